@@ -431,6 +431,8 @@ function(LinkDependencies)
 	  SET(LZ4Sources 
 		"deps/lz4/lib/lz4.h" 
 		"deps/lz4/lib/lz4.c"
+		"deps/lz4/lib/lz4hc.h" 
+		"deps/lz4/lib/lz4hc.c"
 	  )
 	  ADD_LIBRARY(lz4 ${LZ4Sources})
 	  TARGET_INCLUDE_DIRECTORIES(lz4 INTERFACE "deps/lz4/lib")
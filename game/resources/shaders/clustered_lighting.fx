@@ -0,0 +1,71 @@
+#include "common.fxh"
+#include "pbr.fxh"
+
+// x, y, z: cluster grid size. w: slice scale.
+#define grid_params  user_data[1]
+// x: near. y: depth sign. z: index texture width. w: light texture width.
+#define depth_params user_data[2]
+
+struct VSOutput
+{
+  float4 position : SV_POSITION0;
+  float2 tex      : TEX_COORD;
+};
+
+VSOutput VS(uint id: SV_VertexID)
+{
+  VSOutput vOut;
+  vOut.tex      = float2((id << 1) & 2, id & 2);
+  vOut.position = float4(vOut.tex * float2(2, -2) + float2(-1, 1), 0, 1);
+  return vOut;
+}
+
+Make_Texture2D(tex_position, 0);
+Make_Texture2D(tex_normal, 1);
+Make_Texture2D(tex_metallic_roughness, 2);
+Make_Texture2D(tex_clusters, 3);
+Make_Texture2D(tex_cluster_indices, 4);
+Make_Texture2D(tex_cluster_lights, 5);
+
+float4 PS(VSOutput pIn) : SV_TARGET0
+{
+  float4 position = float4(Sample(tex_position, SamLinearClamp, pIn.tex).xyz, 1.0f);
+  float depth = mul(view_matrix, position).z * depth_params.y;
+
+  if (depth <= 0.0f)
+    return 0.0f;
+
+  // Find the cluster, slices are exponential in depth.
+  uint3 cluster;
+  cluster.xy = (uint2)clamp(pIn.tex * grid_params.xy, 0.0f, grid_params.xy - 1.0f);
+  cluster.z  = (uint)clamp(log(max(depth, depth_params.x) / depth_params.x) * grid_params.w, 0.0f, grid_params.z - 1.0f);
+
+  float2 offset_count = tex_clusters.Load(int3(cluster.x + cluster.y * (uint)grid_params.x, cluster.z, 0)).xy;
+  uint offset = (uint)offset_count.x;
+  uint count  = (uint)offset_count.y;
+
+  if (count == 0)
+    return 0.0f;
+
+  float3 normal = normalize(Sample(tex_normal, SamLinearClamp, pIn.tex).rgb * 2.0f - 1.0f);
+  float2 metallic_roughness = Sample(tex_metallic_roughness, SamLinearClamp, pIn.tex).rg;
+
+  uint index_width = (uint)depth_params.z;
+  float3 col = 0.0f;
+
+  for (uint i = 0; i < count; ++i)
+  {
+    uint index = offset + i;
+    uint light = (uint)tex_cluster_indices.Load(int3(index % index_width, index / index_width, 0)).x;
+    float4 position_radius = tex_cluster_lights.Load(int3(light * 2, 0, 0));
+    float4 colour          = tex_cluster_lights.Load(int3(light * 2 + 1, 0, 0));
+
+    col += PBRPoint(
+      position_radius.xyz, camera_position,
+      position.xyz, normal, metallic_roughness.r,
+      metallic_roughness.g, colour.rgb, position_radius.w
+    );
+  }
+
+  return float4(col, 1.0f);
+}
@@ -18,11 +18,11 @@
 
 struct VSInput
 {
-  float3 position : Positions;
-  float3 normal   : Normals;
-  float2 tex      : TexCoords;
+  VertexPosition  position : Positions;
+  VertexDirection normal   : Normals;
+  float2          tex      : TexCoords;
 #if NORMAL_MAPPING
-  float3 tangent  : Tangents;
+  VertexDirection tangent  : Tangents;
 #endif
 };
 
@@ -32,7 +32,7 @@ struct VSOutput
   float4 hPosition : H_POSITION;
   float4 colour    : COLOUR;
   float2 tex       : TEX_COORD;
-  float2 mr        : METALLIC_ROUGHNESS;
+  float3 mr        : METALLIC_ROUGHNESS; // z is the LOD fade.
   float3 emissive  : EMISSIVENESS;
   float3 normal    : NORMAL;
 #if NORMAL_MAPPING
@@ -47,24 +47,29 @@ struct VSOutput
 VSOutput VS(VSInput vIn, uint instanceID : SV_InstanceID)
 {
   VSOutput vOut;
-  vOut.hPosition = mul(model_matrix[instanceID], float4(vIn.position, 1.0f));
+  const float3 position = decodePosition(vIn.position);
+  const float3 normal   = decodeDirection(vIn.normal);
+#if NORMAL_MAPPING || VIOLET_GRID_ALBEDO
+  const float3 tangent  = decodeDirection(vIn.tangent);
+#endif
+  vOut.hPosition = mul(model_matrix[instanceID], float4(position, 1.0f));
   vOut.position  = mul(view_projection_matrix, vOut.hPosition);
   vOut.colour    = float4(1.0f, 1.0f, 1.0f, 1.0f);
   vOut.tex       = vIn.tex;
-  vOut.mr        = metallic_roughness[instanceID].xy;
+  vOut.mr        = metallic_roughness[instanceID].xyz;
   vOut.emissive  = emissiveness[instanceID].xyz;
 
   const float3x3 model_matrix_3x3 = (float3x3)model_matrix[instanceID];
 #if NORMAL_MAPPING
-  float3 bitangent = cross(vIn.tangent, vIn.normal);
-  float3 N = normalize(mul(model_matrix_3x3, vIn.normal));
+  float3 bitangent = cross(tangent, normal);
+  float3 N = normalize(mul(model_matrix_3x3, normal));
   float3 B = normalize(mul(model_matrix_3x3, bitangent));
-  float3 T = normalize(mul(model_matrix_3x3, vIn.tangent));
+  float3 T = normalize(mul(model_matrix_3x3, tangent));
   vOut.tbn = float3x3(T, B, N);
 #endif
-  vOut.normal    = normalize(mul(model_matrix_3x3, vIn.normal));
+  vOut.normal    = normalize(mul(model_matrix_3x3, normal));
 #if VIOLET_GRID_ALBEDO
-  vOut.tangent   = normalize(mul(model_matrix_3x3, vIn.tangent));
+  vOut.tangent   = normalize(mul(model_matrix_3x3, tangent));
   vOut.bitangent = cross(vOut.tangent, vOut.normal);
 #endif
 
@@ -149,6 +154,7 @@ PSOutput PS(VSOutput pIn)
 #if USE_CHECKER
   if (CHECKER_POSITION) discard;
 #endif
+  if (DiscardLOD(pIn.position.xy, pIn.mr.z)) discard;
 
 #if VIOLET_PARALLAX_MAPPING
   float3 eye = mul(pIn.tbn, normalize(pIn.hPosition.xyz - camera_position));
@@ -182,14 +188,16 @@ PSOutput PS(VSOutput pIn)
 #endif
 
 #if NORMAL_MAPPING
-  float3 N = normalize(tex_normal.Sample(SamLinearWarp, pIn.tex).rgb * 2.0f - 1.0f);
+  // Normal maps are compressed to BC5, which only keeps x and y.
+  const float2 NM = tex_normal.Sample(SamLinearWarp, pIn.tex).rg * 2.0f - 1.0f;
+  float3 N = float3(NM, sqrt(saturate(1.0f - dot(NM, NM))));
   N = mul(N, pIn.tbn);
 #else
   float3 N = normalize(pIn.normal);
 #endif
 
   const float4 dmra = tex_dmra.Sample(SamLinearWarp, pIn.tex);
-  const float3 mra    = dmra.gba * float3(pIn.mr, 1.0f);
+  const float3 mra    = dmra.gba * float3(pIn.mr.xy, 1.0f);
   pOut.position = float4(pIn.hPosition.xyz, 1.0f);
   pOut.normal   = float4(N * 0.5f + 0.5f, 1.0f);
   pOut.mra      = float4(mra, 1.0f);
@@ -0,0 +1,101 @@
+#include "common.fxh"
+
+// Octahedral impostors baked by the mesh compiler. model_matrix maps the unit
+// sphere onto the bounding sphere of the sub mesh, emissiveness holds its rect
+// in the atlases and user_data[0].x the frames per side of the octahedron.
+// The frames have to match VioletImpostorBaker::GetFrameDirection and
+// VioletImpostorBaker::GetFrameAxes.
+
+struct VSInput
+{
+  float3 position : Positions;
+};
+
+struct VSOutput
+{
+  float4 position  : SV_POSITION0;
+  float4 hPosition : H_POSITION;         // On the plane of the frame, through the center.
+  float3 forward   : FORWARD;            // World space offset of a depth of one, towards the frame.
+  float2 tex       : TEX_COORD;
+  float3 mr        : METALLIC_ROUGHNESS; // z is the LOD fade.
+  float3x3 model   : MODEL;
+};
+
+float2 OctEncode(float3 n)
+{
+  n /= abs(n.x) + abs(n.y) + abs(n.z);
+  if (n.z < 0.0f)
+    n.xy = (1.0f - abs(n.yx)) * float2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+  return n.xy;
+}
+
+float3 OctDecode(float2 oct)
+{
+  float3 n = float3(oct, 1.0f - abs(oct.x) - abs(oct.y));
+  const float t = max(-n.z, 0.0f);
+  n.x += n.x >= 0.0f ? -t : t;
+  n.y += n.y >= 0.0f ? -t : t;
+  return normalize(n);
+}
+
+VSOutput VS(VSInput vIn, uint instanceID : SV_InstanceID)
+{
+  const float4x4 model_matrix_4x4 = model_matrix[instanceID];
+  const float3x3 model_matrix_3x3 = (float3x3)model_matrix_4x4;
+  const float    frames           = user_data[0].x;
+  const float4   rect             = emissiveness[instanceID];
+
+  // Bring the direction to the camera into the space the frames were baked in.
+  const float3x3 transposed = transpose(model_matrix_3x3);
+  const float3   center     = mul(model_matrix_4x4, float4(0.0f, 0.0f, 0.0f, 1.0f)).xyz;
+  const float3   scale_sq   = float3(dot(transposed[0], transposed[0]), dot(transposed[1], transposed[1]), dot(transposed[2], transposed[2]));
+  const float3   eye        = normalize(mul(transposed, camera_position - center) / scale_sq);
+
+  // Snap to the closest frame.
+  const float2 frame     = clamp(floor((OctEncode(eye) * 0.5f + 0.5f) * frames), 0.0f, frames - 1.0f);
+  const float3 direction = OctDecode((frame + 0.5f) / frames * 2.0f - 1.0f);
+  const float3 reference = abs(direction.y) < 0.999f ? float3(0.0f, 1.0f, 0.0f) : float3(0.0f, 0.0f, 1.0f);
+  const float3 right     = normalize(cross(reference, direction));
+  const float3 up        = cross(direction, right);
+
+  VSOutput vOut;
+  vOut.hPosition = mul(model_matrix_4x4, float4(right * vIn.position.x + up * vIn.position.y, 1.0f));
+  vOut.position  = mul(view_projection_matrix, vOut.hPosition);
+  vOut.forward   = mul(model_matrix_3x3, direction);
+  vOut.tex       = rect.xy + (frame + float2(vIn.position.x * 0.5f + 0.5f, 0.5f - vIn.position.y * 0.5f)) / frames * rect.zw;
+  vOut.mr        = metallic_roughness[instanceID].xyz;
+  vOut.model     = model_matrix_3x3;
+  return vOut;
+}
+
+Make_Texture2D(tex_albedo,       0);
+Make_Texture2D(tex_normal_depth, 1); // Normal - Depth, in the unit sphere.
+
+struct PSOutput
+{
+  float4 albedo   : SV_Target0;
+  float4 position : SV_Target1;
+  float4 normal   : SV_Target2;
+  float4 mra      : SV_Target3; // Metallic - Roughness - Ambient Occlusion.
+  float4 emissive : SV_Target4;
+};
+
+PSOutput PS(VSOutput pIn)
+{
+  if (DiscardLOD(pIn.position.xy, pIn.mr.z)) discard;
+
+  const float4 albedo = tex_albedo.Sample(SamLinearClamp, pIn.tex);
+  if (albedo.a < 0.5f)
+    discard;
+
+  const float4 normal_depth = tex_normal_depth.Sample(SamLinearClamp, pIn.tex);
+  const float3 N = normalize(mul(pIn.model, normal_depth.xyz * 2.0f - 1.0f));
+
+  PSOutput pOut;
+  pOut.albedo   = float4(albedo.rgb, 1.0f);
+  pOut.position = float4(pIn.hPosition.xyz + pIn.forward * (normal_depth.w * 2.0f - 1.0f), 1.0f);
+  pOut.normal   = float4(N * 0.5f + 0.5f, 1.0f);
+  pOut.mra      = float4(pIn.mr.xy, 1.0f, 1.0f);
+  pOut.emissive = float4(0.0f, 0.0f, 0.0f, 1.0f);
+  return pOut;
+}
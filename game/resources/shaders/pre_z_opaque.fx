@@ -2,7 +2,7 @@
 
 struct VSInput
 {
-  float3 position : Positions;
+  VertexPosition position : Positions;
 };
 
 struct VSOutput
@@ -14,7 +14,7 @@ struct VSOutput
 VSOutput VS(VSInput vIn, uint instanceID : SV_InstanceID)
 {
   VSOutput vOut;
-  vOut.hPosition = mul(model_matrix[instanceID], float4(vIn.position, 1.0f));
+  vOut.hPosition = mul(model_matrix[instanceID], float4(decodePosition(vIn.position), 1.0f));
   vOut.position  = mul(view_projection_matrix, vOut.hPosition);
   return vOut;
 }
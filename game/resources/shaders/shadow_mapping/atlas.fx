@@ -0,0 +1,31 @@
+[COPY|CLEAR]
+#include "../common.fxh"
+
+// Source rect in uv space, the destination rect is set through the viewport.
+#define source_rect user_data[1]
+
+struct VSOutput
+{
+  float2 tex      : TEX_COORD;
+  float4 position : SV_POSITION;
+};
+
+VSOutput VS(uint id : SV_VertexID)
+{
+  VSOutput vOut;
+  vOut.tex      = float2((id << 1) & 2, id & 2);
+  vOut.position = float4(vOut.tex * float2(2, -2) + float2(-1, 1), 0, 1);
+
+  return vOut;
+}
+
+Make_Texture2D(tex_source, 0);
+
+float4 PS(VSOutput pIn) : SV_TARGET0
+{
+#if TYPE == CLEAR
+  return float4(3.402823466e+38f, 3.402823466e+38f, 1.0f, 1.0f);
+#else
+  return tex_source.Sample(SamPointClamp, source_rect.xy + pIn.tex * source_rect.zw);
+#endif
+}
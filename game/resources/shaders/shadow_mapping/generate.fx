@@ -27,7 +27,7 @@
 
 struct VSInput
 {
-  float3 position : Positions;
+  VertexPosition position : Positions;
   float2 tex      : TexCoords;
 };
 
@@ -41,7 +41,7 @@ struct VSOutput
 VSOutput VS(VSInput vIn, uint instanceID : SV_InstanceID)
 {
   VSOutput vOut;
-  vOut.hPosition   = mul(model_matrix[instanceID], float4(vIn.position, 1.0f));
+  vOut.hPosition   = mul(model_matrix[instanceID], float4(decodePosition(vIn.position), 1.0f));
   vOut.position    = mul(light_view_projection_matrix, vOut.hPosition);
   vOut.tex         = vIn.tex;
   return vOut;
@@ -57,12 +57,11 @@ float calcShadow(float2 moments, float compare)
 }
 #endif
 
-#if LIGHT_POINT
-Make_TextureCube(tex_shadow_map, 0);
-#elif !NO_SHADOWS
+#if !NO_SHADOWS
 Make_Texture2D(tex_shadow_map, 0);
 #endif
 Make_Texture2D(tex_overlay, 1);
+#define inv_shadow_atlas_size user_data[1].xy
 Make_Texture2D(tex_position, 2);
 Make_Texture2D(tex_normal, 3);
 Make_Texture2D(tex_metallic_roughness, 4);
@@ -82,6 +81,13 @@ VSOutput VS(uint id : SV_VertexID)
   return vOut;
 }
 
+// Maps [0, 1] coordinates into the slot, staying half a texel inside to avoid bleeding.
+float2 atlasCoords(float2 coords, float4 rect)
+{
+  float2 half_texel = 0.5f * inv_shadow_atlas_size;
+  return rect.xy + clamp(coords, 0.0f, 1.0f) * rect.zw + (1.0f - 2.0f * clamp(coords, 0.0f, 1.0f)) * half_texel;
+}
+
 float4 PS(VSOutput pIn) : SV_TARGET0
 {
   float4 position = float4(Sample(tex_position, SamLinearClamp, pIn.tex).xyz, 1.0f);
@@ -93,14 +99,27 @@ float4 PS(VSOutput pIn) : SV_TARGET0
   float position_depth = trans_position.z * light_far;
   float4 overlay = tex_overlay.Sample(SamLinearClamp, coords);
   float hide_shadows = clamp(when_le(coords.x, 0.0f) + when_ge(coords.x, 1.0f) + when_le(coords.y, 0.0f) + when_ge(coords.y, 1.0f) + when_le(trans_position.z, 0.0f) + when_ge(trans_position.z, 1.0f), 0.0f, 1.0f);
+  coords = atlasCoords(coords, light_atlas_rect);
 
 #elif LIGHT_POINT && !NO_SHADOWS
   float4 overlay = 1.0f;
-  float3 coords = position.xyz - light_position;
-  float position_depth = length(coords);
-  coords = normalize(coords);
+  float3 direction = position.xyz - light_position;
+  float position_depth = length(direction);
   float hide_shadows = position_depth > light_far;
 
+  // Pick the cube face, same order as the faces are rendered in: +x, -x, +y, -y, +z, -z.
+  float3 abs_direction = abs(direction);
+  uint face = 0;
+  if (abs_direction.x >= abs_direction.y && abs_direction.x >= abs_direction.z)
+    face = direction.x >= 0.0f ? 0 : 1;
+  else if (abs_direction.y >= abs_direction.z)
+    face = direction.y >= 0.0f ? 2 : 3;
+  else
+    face = direction.z >= 0.0f ? 4 : 5;
+
+  float4 trans_position = mul(light_face_view_projection_matrix[face], position);
+  float2 coords = atlasCoords(trans_position.xy / trans_position.w * float2(0.5f, -0.5f) + 0.5f, light_face_atlas_rect[face]);
+
 #elif LIGHT_SPOT && !NO_SHADOWS
 
   float4 trans_position = mul(light_view_projection_matrix, position);
@@ -1,14 +1,24 @@
 #include <memory/memory.h>
 #include <utils/console.h>
 #include <utils/file_system.h>
+#include <utils/file_watcher.h>
 #include <compilers/texture_compiler.h>
 #include <compilers/wave_compiler.h>
 #include <compilers/shader_compiler.h>
 #include <compilers/mesh_compiler.h>
+#include <archive/archive_builder.h>
+#include <dependencies/dependency_scanner.h>
+#include <cache/build_cache.h>
+#include <pipeline/build_graph.h>
+#include <pipeline/build_database.h>
+#include <assets/base_asset_manager.h>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <stb_image.h>
 #include <stb_image_write.h>
 #include <algorithm>
+#include <cstdlib>
 
 enum class Type : uint32_t
 {
@@ -216,145 +226,12 @@ void SendMessage()
 
 
 
-class TimeStampManager
-{
-public:
-  TimeStampManager()
-  {
-    read();
-  }
-  void read()
-  {
-    if (!lambda::FileSystem::DoesFileExist("generated/timestamps"))
-    {
-      lambda::foundation::Error("Could not open file: generated/timestamps.\n");
-      return;
-    }
-    lambda::Vector<char> data = lambda::FileSystem::FileToVector("generated/timestamps");
-    uint32_t offset = 0u;
-    while (offset < data.size())
-    {
-      lambda::Vector<char> time_stamp_vec(data.begin() + offset, std::find(data.begin() + offset, data.end(), ' '));
-      lambda::String time_stamp(time_stamp_vec.size(), '\0');
-      memcpy((void*)time_stamp.data(), time_stamp_vec.data(), time_stamp_vec.size());
-      offset += (uint32_t)time_stamp.size() + 1u;
-      lambda::Vector<char> file_name_vec(data.begin() + offset, std::find(data.begin() + offset, data.end(), '\n'));
-      lambda::String file_name(file_name_vec.size(), '\0');
-      memcpy((void*)file_name.data(), file_name_vec.data(), file_name_vec.size());
-      offset += (uint32_t)file_name.size() + 1u;
-
-      // Add the file name and time stamp.
-      file_names_.push_back(file_name);
-      time_stamps_.push_back(std::stoull(time_stamp.c_str()));
-    }
-  }
-  void write()
-  {
-    // Get the size of the data.
-    uint32_t size = 0u;
-    for (uint32_t i = 0u; i < file_names_.size(); ++i)
-    {
-      size += (uint32_t)lambda::toString(time_stamps_[i]).size() + 1u;
-      size += (uint32_t)file_names_[i].size() + 1u;
-    }
-
-    lambda::Vector<char> data(size);
-    uint32_t offset = 0u;
-
-    // Write the data.
-    for (uint32_t i = 0u; i < file_names_.size(); ++i)
-    {
-      lambda::String time_stamp = lambda::toString(time_stamps_[i]);
-      memcpy(data.data() + offset, time_stamp.data(), time_stamp.size());
-      offset += (uint32_t)time_stamp.size();
-      memset(data.data() + offset, ' ', 1u);
-      offset += 1u;
-      memcpy(data.data() + offset, file_names_[i].data(), file_names_[i].size());
-      offset += (uint32_t)file_names_[i].size();
-      memset(data.data() + offset, '\n', 1u);
-      offset += 1u;
-    }
-
-    // Write the file.
-    lambda::FileSystem::WriteFile("generated/timestamps", data);
-  }
-
-  bool hasFileChanged(const lambda::String& file_name) const
-  {
-    for (uint32_t i = 0u; i < file_names_.size(); ++i)
-      if (file_name == file_names_[i])
-        return hasFileChanged(i);
-    return false;
-  }
-  bool hasFileChanged(const uint32_t index) const
-  {
-    return lambda::FileSystem::GetTimeStamp(file_names_[index]) != time_stamps_[index];
-  }
-  void updateTimeStap(const lambda::String& file_name)
-  {
-    for (uint32_t i = 0u; i < file_names_.size(); ++i)
-    {
-      if (file_name == file_names_[i])
-      {
-        updateTimeStap(i);
-        return;
-      }
-    }
-  }
-  void updateTimeStap(const uint32_t index)
-  {
-    const uint64_t time_stamp = lambda::FileSystem::GetTimeStamp(file_names_[index]);
-    if (time_stamp != time_stamps_[index])
-    {
-      time_stamps_[index] = time_stamp;
-      write();
-    }
-  }
-  const lambda::Vector<lambda::String>& getFiles() const
-  {
-    return file_names_;
-  }
-  bool hasFile(lambda::String file_name) const
-  {
-    return (eastl::find(file_names_.begin(), file_names_.end(), file_name) != file_names_.end());
-  }
-  void addFile(lambda::String file_name)
-  {
-    if (hasFile(file_name))
-      return;
-
-    file_names_.push_back(file_name);
-    time_stamps_.push_back(0u);
-    write();
-  }
-  void removeFile(lambda::String file_name)
-  {
-    if (!hasFile(file_name))
-      return;
-
-    for (uint32_t i = 0u; i < file_names_.size(); ++i)
-    {
-      if (file_names_[i] == file_name)
-      {
-        file_names_.erase(file_names_.begin() + i);
-        time_stamps_.erase(time_stamps_.begin() + i);
-        write();
-        return;
-      }
-    }
-  }
-
-private:
-  lambda::Vector<lambda::String> file_names_;
-  lambda::Vector<uint64_t>       time_stamps_;
-};
-
 void removeFile(
 	const lambda::String& file, 
-	lambda::VioletTextureCompiler texture_compiler, 
-	lambda::VioletWaveCompiler wave_compiler,
-	lambda::VioletShaderCompiler shader_compiler,
-	lambda::VioletMeshCompiler mesh_compiler)
+	lambda::VioletTextureCompiler& texture_compiler, 
+	lambda::VioletWaveCompiler& wave_compiler,
+	lambda::VioletShaderCompiler& shader_compiler,
+	lambda::VioletMeshCompiler& mesh_compiler)
 {
   lambda::String extension = lambda::FileSystem::GetExtension(file);
   if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "hdr")
@@ -451,14 +328,18 @@ public:
 	int w = 0, h = 0, c = 0;
 };
 
-void handleDMRA(const lambda::String& file, const lambda::String& extension)
+bool isDMRAChannel(const lambda::String& file, const lambda::String& extension)
 {
 	bool is_ao  = file.find("_ao."  + extension) != lambda::String::npos;
 	bool is_dis = file.find("_dis." + extension) != lambda::String::npos;
 	bool is_met = file.find("_met." + extension) != lambda::String::npos;
 	bool is_rgh = file.find("_rgh." + extension) != lambda::String::npos;
+	return is_ao || is_dis || is_met || is_rgh;
+}
 
-	if (is_ao || is_dis || is_met || is_rgh)
+void handleDMRA(const lambda::String& file, const lambda::String& extension)
+{
+	if (isDMRAChannel(file, extension))
 	{
 		lambda::String file_base = file.substr(0, file.find_last_of("_"));
 		
@@ -491,115 +372,354 @@ void handleDMRA(const lambda::String& file, const lambda::String& extension)
 	}
 }
 
+// Sources the builder writes itself: packed DMRA textures, images embedded in
+// glTF files and impostor atlases. The builder compiles them right after
+// writing them, so the watcher has to leave them alone.
+bool isGeneratedSource(const lambda::String& file)
+{
+  const lambda::String name = lambda::FileSystem::FileName(file);
+  if (name.compare(0u, 2u, "__") == 0)
+    return true;
 
-bool updateFile(
-	const lambda::String& file, 
-	lambda::VioletTextureCompiler texture_compiler, 
-	lambda::VioletWaveCompiler wave_compiler,
-	lambda::VioletShaderCompiler shader_compiler,
-	lambda::VioletMeshCompiler mesh_compiler)
+  // A hand made DMRA texture without channel textures is a normal source.
+  if (name.size() < 5u || name.compare(name.size() - 5u, 5u, "_dmra") != 0)
+    return false;
+  const lambda::String file_base = file.substr(0, file.find_last_of("_"));
+  return doesTextureExist(file_base + "_ao") || doesTextureExist(file_base + "_dis") || doesTextureExist(file_base + "_met") || doesTextureExist(file_base + "_rgh");
+}
+
+// Buffers a glTF file references are part of the mesh, images are compiled on their own.
+lambda::Vector<lambda::String> getMeshInputs(const lambda::String& file)
 {
-  lambda::String extension = lambda::FileSystem::GetExtension(file);
-  if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "hdr")
+  lambda::Vector<lambda::String> inputs = { file };
+  if (lambda::FileSystem::GetExtension(file) != "gltf")
+    return inputs;
+
+  const lambda::String json = lambda::FileSystem::FileToString(file);
+  for (eastl_size_t offset = json.find("\"uri\""); offset != lambda::String::npos; offset = json.find("\"uri\"", offset + 1u))
   {
-		handleDMRA(file, extension);
+    const eastl_size_t begin = json.find('"', json.find(':', offset));
+    const eastl_size_t end   = begin == lambda::String::npos ? lambda::String::npos : json.find('"', begin + 1u);
+    if (end == lambda::String::npos)
+      break;
 
-    lambda::foundation::Info("[TEX] " + file + "\n");
-    lambda::foundation::Info("\tCompiling...\n");
+    const lambda::String uri = json.substr(begin + 1u, end - begin - 1u);
+    if (uri.compare(0u, 5u, "data:") != 0)
+      inputs.push_back(lambda::FileSystem::RemoveName(file) + uri);
+  }
+  return inputs;
+}
 
-    lambda::TextureCompileInfo compile_info{};
-    compile_info.file = file;
-    
-	if (texture_compiler.Compile(compile_info))
-	{
-      lambda::foundation::Info("\tCompiled!\n");
+enum class BuildResult
+{
+  kFailed,
+  kCompiled,
+  kRestored,
+  kTracked, // Nothing is generated from the file.
+};
+
+struct BuildOutput
+{
+  lambda::String                 file;
+  BuildResult                    result;
+  lambda::Vector<lambda::String> outputs;      // Generated files.
+  lambda::Vector<lambda::String> dependencies; // Other files the outputs were built from.
+  lambda::Vector<lambda::String> sources;      // Sources the build wrote, compiled after it.
+};
+
+bool isTexture(const lambda::String& extension)
+{
+  return extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "hdr";
+}
+
+lambda::String getTag(const lambda::String& extension)
+{
+  if (isTexture(extension))
+    return "[TEX]";
+  if (extension == "wav")
+    return "[WAV]";
+  if (extension == "fx" || extension == "fxh")
+    return "[SHA]";
+  if (extension == "gltf" || extension == "glb")
+    return "[MSH]";
+  if (extension == "as")
+    return "[AS-]";
+  if (extension == "wren")
+    return "[WRE]";
+  if (extension == "ttf")
+    return "[FNT]";
+  if (extension == "txt")
+    return "[TXT]";
+  if (extension == "ini")
+    return "[INI]";
+  return "[---]";
+}
+
+// VIOLET_TEXTURE_QUALITY picks the preset of the texture encoder: fast, normal or high.
+lambda::VioletTextureQuality getTextureQuality()
+{
+  static const lambda::VioletTextureQuality quality = []() {
+    const char* setting = getenv("VIOLET_TEXTURE_QUALITY");
+    if (setting && lambda::String(setting) == "fast")
+      return lambda::VioletTextureQuality::kFast;
+    if (setting && lambda::String(setting) == "high")
+      return lambda::VioletTextureQuality::kHigh;
+    return lambda::VioletTextureQuality::kNormal;
+  }();
+  return quality;
+}
+
+// Runs on the build workers, every call only writes the generated files of its own asset.
+BuildResult updateFile(
+	BuildOutput& output, 
+	lambda::VioletTextureCompiler& texture_compiler, 
+	lambda::VioletWaveCompiler& wave_compiler,
+	lambda::VioletShaderCompiler& shader_compiler,
+	lambda::VioletMeshCompiler& mesh_compiler,
+	lambda::VioletBuildCache& build_cache)
+{
+  const lambda::String& file = output.file;
+  lambda::String extension = lambda::FileSystem::GetExtension(file);
+  if (isTexture(extension))
+  {
+    const lambda::VioletTextureQuality quality = getTextureQuality();
+    const uint64_t key = build_cache.GetKey({ file }, "tex|" + lambda::toString(lambda::VioletTextureCompiler::kVersion) + "|" + lambda::toString((int)quality));
+    const bool restored = build_cache.Restore(key);
+    if (!restored)
+    {
+      lambda::TextureCompileInfo compile_info{};
+      compile_info.file    = file;
+      compile_info.quality = quality;
+      if (!texture_compiler.Compile(compile_info))
+        return BuildResult::kFailed;
       texture_compiler.Save();
-      lambda::foundation::Info("\tSaved!\n");
-	  return true;
-	}
-	else
-	{
-	  lambda::foundation::Info("\tCompilation failed!\n");
-	  return false;
-	}
+    }
+
+    output.outputs = texture_compiler.GetGeneratedFiles(texture_compiler.GetHash(file));
+    if (restored)
+      return BuildResult::kRestored;
+    build_cache.Store(key, output.outputs);
+    return BuildResult::kCompiled;
   }
   else if (extension == "wav")
   {
-    lambda::foundation::Info("[WAV] " + file + "\n");
-    lambda::foundation::Info("\tCompiling...\n");
-    
-    lambda::WaveCompileInfo compile_info{};
-    compile_info.file = file;
-    if (wave_compiler.Compile(compile_info))
+    const uint64_t key = build_cache.GetKey({ file }, "wav|" + lambda::toString(lambda::VioletWaveCompiler::kVersion));
+    const bool restored = build_cache.Restore(key);
+    if (!restored)
     {
-      lambda::foundation::Info("\tCompiled!\n");
+      lambda::WaveCompileInfo compile_info{};
+      compile_info.file = file;
+      if (!wave_compiler.Compile(compile_info))
+        return BuildResult::kFailed;
       wave_compiler.Save();
-      lambda::foundation::Info("\tSaved!\n");
-	  return true;
-	}
-    else
-    {
-      lambda::foundation::Info("\tCompilation failed!\n");
-	  return false;
-	}
+    }
+
+    output.outputs = wave_compiler.GetGeneratedFiles(wave_compiler.GetHash(file));
+    if (restored)
+      return BuildResult::kRestored;
+    build_cache.Store(key, output.outputs);
+    return BuildResult::kCompiled;
   }
   else if (extension == "fx")
   {
-    lambda::foundation::Info("[SHA] " + file + "\n");
-    lambda::foundation::Info("\tCompiling...\n");
-    
-    lambda::ShaderCompileInfo compile_info{};
-    compile_info.file = file;
-    if (shader_compiler.Compile(compile_info))
+    // Includes are hashed as well, so editing a header invalidates every shader that uses it.
+    output.dependencies = lambda::VioletShaderCompiler::GetIncludes(file);
+    lambda::Vector<lambda::String> inputs = output.dependencies;
+    inputs.insert(inputs.begin(), file);
+    const uint64_t key = build_cache.GetKey(inputs, "shader|" + lambda::toString(lambda::VioletShaderCompiler::kVersion));
+    const bool restored = build_cache.Restore(key);
+    if (!restored)
     {
-      lambda::foundation::Info("\tCompiled!\n");
+      lambda::ShaderCompileInfo compile_info{};
+      compile_info.file  = file;
+      compile_info.cache = &build_cache;
+      if (!shader_compiler.Compile(compile_info))
+        return BuildResult::kFailed;
       shader_compiler.Save();
-      lambda::foundation::Info("\tSaved!\n");
-	  return true;
-	}
-    else
-    {
-      lambda::foundation::Info("\tCompilation failed!\n");
-	  return false;
     }
+
+    for (const lambda::String& permutation : lambda::VioletShaderCompiler::GetPermutations(lambda::FileSystem::FileToString(file)))
+      for (const lambda::String& generated : shader_compiler.GetGeneratedFiles(shader_compiler.GetHash(file + "|" + permutation)))
+        output.outputs.push_back(generated);
+    if (restored)
+      return BuildResult::kRestored;
+    build_cache.Store(key, output.outputs);
+    return BuildResult::kCompiled;
   }
   else if (extension == "gltf" || extension == "glb")
   {
-    lambda::foundation::Info("[MSH] " + file + "\n");
-    lambda::foundation::Info("\tCompiling...\n");
-    
     lambda::MeshCompileInfo compile_info{};
     compile_info.file = file;
-    if (mesh_compiler.Compile(compile_info))
+
+    const lambda::Vector<lambda::String> inputs = getMeshInputs(file);
+    output.dependencies.assign(inputs.begin() + 1, inputs.end());
+    lambda::String settings = "msh|" + lambda::toString(lambda::VioletMeshCompiler::kVersion) + "|" + lambda::toString(compile_info.optimize) + "|" + lambda::toString(compile_info.quantize) +
+      "|" + lambda::toString(compile_info.lod_max_error) + "|" + lambda::toString(compile_info.impostor_frames) + "|" + lambda::toString(compile_info.impostor_frame_size) +
+      "|" + lambda::toString(compile_info.cluster_max_vertices) + "|" + lambda::toString(compile_info.cluster_max_triangles) + "|" + lambda::toString(compile_info.cluster_min_triangles) +
+      "|" + lambda::toString(compile_info.cluster_cone_weight) + "|" + lambda::toString(compile_info.animation_frame_rate);
+    for (float ratio : compile_info.lod_ratios)
+      settings += "|" + lambda::toString(ratio);
+    const uint64_t key = build_cache.GetKey(inputs, settings);
+
+    bool restored = build_cache.Restore(key);
+    if (restored)
     {
-      lambda::foundation::Info("\tCompiled!\n");
-	  mesh_compiler.Save();
-      lambda::foundation::Info("\tSaved!\n");
-	  return true;
-	}
-    else
+      // Embedded images are written next to the mesh when it is compiled, without them it has to be compiled again.
+      const lambda::VioletMesh mesh = mesh_compiler.GetMesh(mesh_compiler.GetHash(file));
+      for (const lambda::Vector<lambda::String>* textures : { &mesh.data.tex_alb, &mesh.data.tex_nrm, &mesh.data.tex_dmra, &mesh.data.tex_emi })
+        for (const lambda::String& texture : *textures)
+          restored &= lambda::FileSystem::DoesFileExist(texture);
+      for (const lambda::String* atlas : { &mesh.data.impostor_albedo, &mesh.data.impostor_normal_depth })
+        restored &= atlas->empty() || lambda::FileSystem::DoesFileExist(*atlas);
+    }
+
+    if (!restored)
     {
-      lambda::foundation::Info("\tCompilation failed!\n");
-	  return false;
+      if (!mesh_compiler.Compile(compile_info))
+        return BuildResult::kFailed;
+      mesh_compiler.Save();
     }
+
+    output.outputs = mesh_compiler.GetGeneratedFiles(mesh_compiler.GetHash(file));
+
+    const lambda::VioletMesh mesh = mesh_compiler.GetMesh(mesh_compiler.GetHash(file));
+    for (const lambda::Vector<lambda::String>* textures : { &mesh.data.tex_alb, &mesh.data.tex_nrm, &mesh.data.tex_dmra, &mesh.data.tex_emi })
+      for (const lambda::String& texture : *textures)
+        if (isGeneratedSource(texture))
+          output.sources.push_back(texture);
+    for (const lambda::String* atlas : { &mesh.data.impostor_albedo, &mesh.data.impostor_normal_depth })
+      if (!atlas->empty())
+        output.sources.push_back(*atlas);
+
+    if (restored)
+      return BuildResult::kRestored;
+    build_cache.Store(key, output.outputs);
+    return BuildResult::kCompiled;
   }
-  else if (extension == "fxh")
-    Warning("[SHA]" + file + " changed!\n");
-  else if (extension == "as")
-    Warning("[AS-] " + file + " changed!\n");
-  else if (extension == "wren")
-    Warning("[WRE] " + file + " changed!\n");
-  else if (extension == "glb")
-    Warning("[MDL] " + file + " changed!\n");
-  else if (extension == "ttf")
-    Warning("[FNT] " + file + " changed!\n");
-  else if (extension == "txt")
-    Warning("[TXT] " + file + " changed!\n");
-  else if (extension == "ini")
-    Warning("[INI] " + file + " changed!\n");
-  else
-    Debug("[---] " + file + " changed!\n");
-  return true;
+
+  return BuildResult::kTracked;
+}
+
+// Compiles the changed files on a worker pool. Ordering is only enforced where
+// one build reads what another writes: the packed DMRA texture is compiled after
+// it is packed, and shaders are compiled again when one of their includes changes.
+lambda::Vector<BuildOutput> buildFiles(
+  const lambda::Vector<lambda::String>& files,
+  const lambda::VioletBuildDatabase& build_database,
+	lambda::VioletTextureCompiler& texture_compiler, 
+	lambda::VioletWaveCompiler& wave_compiler,
+	lambda::VioletShaderCompiler& shader_compiler,
+	lambda::VioletMeshCompiler& mesh_compiler,
+	lambda::VioletBuildCache& build_cache)
+{
+  lambda::VioletBuildGraph graph;
+  lambda::Vector<BuildOutput> outputs;
+  // Every job only writes its own output.
+  lambda::UnorderedMap<lambda::String, uint32_t> jobs;
+
+  auto addBuild = [&](const lambda::String& file) -> uint32_t {
+    auto it = jobs.find(file);
+    if (it != jobs.end())
+      return it->second;
+
+    const uint32_t output = (uint32_t)outputs.size();
+    outputs.push_back(BuildOutput{ file, BuildResult::kFailed });
+    const uint32_t job = graph.AddJob(file, [&, file, output]() {
+      outputs[output].result = updateFile(outputs[output], texture_compiler, wave_compiler, shader_compiler, mesh_compiler, build_cache);
+      return outputs[output].result != BuildResult::kFailed;
+    });
+    jobs.insert(eastl::make_pair(file, job));
+    return job;
+  };
+
+  for (const lambda::String& file : files)
+  {
+    const lambda::String extension = lambda::FileSystem::GetExtension(file);
+    addBuild(file);
+
+    if (isTexture(extension) && isDMRAChannel(file, extension))
+    {
+      const lambda::String file_base = file.substr(0, file.find_last_of("_"));
+      const lambda::String dmra = file_base + "_dmra.png";
+      if (jobs.find("pack:" + dmra) == jobs.end())
+      {
+        const uint32_t pack = graph.AddJob("pack:" + dmra, [file, extension]() { handleDMRA(file, extension); return true; });
+        jobs.insert(eastl::make_pair("pack:" + dmra, pack));
+        graph.AddDependency(addBuild(dmra), pack);
+      }
+    }
+
+    // Shaders that include the file, meshes that reference the buffer, etc.
+    for (const lambda::String& dependent : build_database.GetDependents(file))
+      addBuild(dependent);
+  }
+
+  if (graph.GetJobCount() == 0u)
+    return outputs;
+
+  graph.Run();
+
+  uint32_t counts[4u] = {};
+  for (const BuildOutput& output : outputs)
+  {
+    const lambda::VioletBuildGraph::Job& job = graph.GetJob(jobs[output.file]);
+    const lambda::String tag = getTag(lambda::FileSystem::GetExtension(output.file));
+    const lambda::String time = lambda::toString((uint32_t)job.time) + "ms";
+    counts[(int)output.result]++;
+
+    if (job.skipped)
+      lambda::foundation::Error(tag + " " + output.file + " skipped, a dependency failed\n");
+    else if (output.result == BuildResult::kFailed)
+      lambda::foundation::Error(tag + " " + output.file + " failed after " + time + "\n");
+    else if (output.result == BuildResult::kCompiled)
+      lambda::foundation::Info(tag + " " + output.file + " compiled in " + time + "\n");
+    else if (output.result == BuildResult::kRestored)
+      lambda::foundation::Info(tag + " " + output.file + " restored from the cache in " + time + "\n");
+    else
+      lambda::foundation::Info(tag + " " + output.file + " changed\n");
+  }
+
+  lambda::foundation::Info(
+    "Built " + lambda::toString(outputs.size()) + " files in " + lambda::toString((uint32_t)graph.GetWallTime()) + "ms on " +
+    lambda::toString(graph.GetThreadCount()) + " threads: " + lambda::toString(counts[(int)BuildResult::kCompiled]) + " compiled, " +
+    lambda::toString(counts[(int)BuildResult::kRestored]) + " restored, " + lambda::toString(counts[(int)BuildResult::kFailed]) + " failed\n"
+  );
+  return outputs;
+}
+
+// Lets the compilers (de)compress the blocks of large assets on a fixed set of
+// threads. Every build job shares them, so a rebuild adds these threads once
+// instead of a set per job.
+void startBlockWorkers(uint32_t worker_count)
+{
+  struct Pool
+  {
+    std::mutex                                  mutex;
+    std::condition_variable                     condition;
+    lambda::Queue<lambda::Function<void(void)>> jobs;
+  };
+  static Pool pool;
+
+  for (uint32_t i = 0u; i < worker_count; ++i)
+  {
+    std::thread([]() {
+      while (true)
+      {
+        std::unique_lock<std::mutex> lock(pool.mutex);
+        pool.condition.wait(lock, []() { return !pool.jobs.empty(); });
+        lambda::Function<void(void)> job = pool.jobs.front();
+        pool.jobs.pop();
+        lock.unlock();
+        job();
+      }
+    }).detach();
+  }
+
+  lambda::VioletBaseAssetManager::SetJobQueue([](lambda::Function<void(void)> job) {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.jobs.push(job);
+    pool.condition.notify_one();
+  }, worker_count);
 }
 
 int main(int argc, char** argv)
@@ -609,16 +729,118 @@ int main(int argc, char** argv)
   if (argc == 1)
     LMB_ASSERT(false, "No project folder was speficied!");
   lambda::FileSystem::SetBaseDir(argv[1]);
-  TimeStampManager time_stamp_manager;
+  // The thread that compresses an asset works along, so one less than the cores.
+  startBlockWorkers(eastl::max(2u, (uint32_t)std::thread::hardware_concurrency()) - 1u);
+  // With --pack everything is compiled once and written to a single archive.
+  const bool pack = argc > 2 && lambda::String(argv[2]) == "--pack";
+  // Replaces the old generated/timestamps text file, which is not read anymore.
+  lambda::VioletBuildDatabase build_database;
+  build_database.Load("generated/build_database");
   lambda::VioletTextureCompiler texture_compiler;
   lambda::VioletWaveCompiler wave_compiler;
   lambda::VioletShaderCompiler shader_compiler;
   lambda::VioletMeshCompiler mesh_compiler;
 
-  while (true)
+  // A missing or outdated graph is filled in again by the startup scan.
+  lambda::VioletDependencyGraph dependency_graph;
+  const bool rebuild_dependencies = !dependency_graph.Load("generated/dependencies");
+  lambda::VioletDependencyScanner dependency_scanner(texture_compiler, mesh_compiler, shader_compiler, wave_compiler);
+  bool dependencies_changed = rebuild_dependencies;
+
+  // VIOLET_BUILD_CACHE points the cache at a folder that is shared between checkouts.
+  lambda::BuildCacheSettings cache_settings;
+  if (const char* cache_folder = getenv("VIOLET_BUILD_CACHE"))
+    cache_settings.folder = cache_folder;
+  lambda::VioletBuildCache build_cache;
+  build_cache.Initialize(cache_settings);
+
+  // --dump <file> prints the generated header of an asset as JSon.
+  if (argc > 3 && lambda::String(argv[2]) == "--dump")
+  {
+    lambda::String file = lambda::FileSystem::MakeRelative(argv[3]);
+    lambda::String extension = lambda::FileSystem::GetExtension(file);
+    if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "hdr")
+      lambda::foundation::Info(texture_compiler.DumpHeader(texture_compiler.GetHash(file)) + "\n");
+    else if (extension == "wav")
+      lambda::foundation::Info(wave_compiler.DumpHeader(wave_compiler.GetHash(file)) + "\n");
+    else if (extension == "fx")
+      lambda::foundation::Info(shader_compiler.DumpHeader(shader_compiler.GetHash(file)) + "\n");
+    else if (extension == "gltf" || extension == "glb")
+      lambda::foundation::Info(mesh_compiler.DumpHeader(mesh_compiler.GetHash(file)) + "\n");
+    else
+      lambda::foundation::Error("Can not dump " + file + "\n");
+    return 0;
+  }
+
+  // --deps <level> [<next level>] prints what loading a level pulls in, and
+  // what would be unloaded when moving on to the next level.
+  if (argc > 3 && lambda::String(argv[2]) == "--deps")
+  {
+    auto print = [&dependency_graph](const lambda::String& name, const lambda::Vector<uint64_t>& assets) {
+      const lambda::VioletDependencyGraph::Footprint footprint = dependency_graph.GetFootprint(assets);
+      lambda::foundation::Info(name + ": " + lambda::toString(assets.size()) + " assets, " + lambda::toString(footprint.total / 1024u) + " KB\n");
+      for (int i = 0; i < (int)lambda::VioletAssetType::kCount; ++i)
+        if (footprint.count[i] > 0u)
+          lambda::foundation::Info("\t" + lambda::VioletDependencyGraph::TypeToString((lambda::VioletAssetType)i) + ": " + lambda::toString(footprint.count[i]) + " assets, " + lambda::toString(footprint.size[i] / 1024u) + " KB\n");
+    };
+
+    const lambda::String level = lambda::FileSystem::MakeRelative(argv[3]);
+    const lambda::Vector<uint64_t> closure = dependency_graph.GetClosure({ lambda::hash(level) });
+    if (closure.empty())
+    {
+      lambda::foundation::Error("No dependencies are known for " + level + ", run the builder on the project first\n");
+      return 1;
+    }
+
+    print(level, closure);
+    for (uint64_t hash : closure)
+    {
+      const lambda::VioletDependencyGraph::Node* node = dependency_graph.GetNode(hash);
+      lambda::foundation::Info("\t\t" + node->file + " (" + lambda::toString(node->size / 1024u) + " KB)\n");
+    }
+
+    if (argc > 4)
+    {
+      const lambda::String next_level = lambda::FileSystem::MakeRelative(argv[4]);
+      const lambda::Vector<uint64_t> next_closure = dependency_graph.GetClosure({ lambda::hash(next_level) });
+      print(next_level, next_closure);
+      print("Unloaded", dependency_graph.GetUnloaded(closure, next_closure));
+      print("Loaded", dependency_graph.GetUnloaded(next_closure, closure));
+    }
+    return 0;
+  }
+
+  // Builds the changed files, and remembers the ones that were built. The
+  // textures a build writes are built in the next round, the watcher skips them.
+  auto build = [&](lambda::Vector<lambda::String> files) {
+    while (!files.empty())
+    {
+      lambda::Vector<lambda::String> sources;
+      for (const BuildOutput& output : buildFiles(files, build_database, texture_compiler, wave_compiler, shader_compiler, mesh_compiler, build_cache))
+      {
+        // Failed files are not stored, so they are tried again on the next run.
+        if (output.result == BuildResult::kFailed)
+          continue;
+
+        build_database.Update(output.file, output.outputs, output.dependencies);
+        dependencies_changed |= dependency_scanner.Scan(dependency_graph, output.file);
+        for (const lambda::String& source : output.sources)
+          if (eastl::find(sources.begin(), sources.end(), source) == sources.end() && build_database.HasChanged(source))
+            sources.push_back(source);
+      }
+      files = eastl::move(sources);
+    }
+  };
+
+  // Started before the first scan, so nothing that changes during the scan is missed.
+  lambda::FileWatcher file_watcher;
+  if (!pack)
+    file_watcher.Watch("");
+
+  // Catch up with everything that changed while the builder was not running.
   {
-    auto function_start = std::chrono::high_resolution_clock::now();
-    lambda::Vector<lambda::String> previous_files = time_stamp_manager.getFiles();
+    lambda::Vector<lambda::String> changed_files;
+    build_database.BeginScan();
 
     for (lambda::String file : lambda::FileSystem::GetAllFilesInFolderRecursive("", ""))
     {
@@ -629,32 +851,87 @@ int main(int argc, char** argv)
       // Make the file relative, so it can be used by the file system.
       file = lambda::FileSystem::MakeRelative(file);
 
-      // If this file does not exist yet. Add it.
-      if (!time_stamp_manager.hasFile(file))
-        time_stamp_manager.addFile(file);
+      // Files that are not seen during the scan have been deleted.
+      build_database.MarkSeen(file);
 
-      // Erase this file from the to delete list.
-      lambda::String* it = nullptr;
-      while ((it = std::find(previous_files.begin(), previous_files.end(), file)) != previous_files.end())
-        previous_files.erase(it);
-
-      // Update the file.
-      if (time_stamp_manager.hasFileChanged(file))
-        if (updateFile(file, texture_compiler, wave_compiler, shader_compiler, mesh_compiler))
-		  time_stamp_manager.updateTimeStap(file);
+      // Generated files that went missing are built again as well.
+      if (build_database.HasChanged(file, true))
+        changed_files.push_back(file);
+      else if (rebuild_dependencies)
+        dependency_scanner.Scan(dependency_graph, file);
     }
 
+    build(changed_files);
+
     // Remove all deleted files.
-    for (const lambda::String& file : previous_files)
+    for (const lambda::String& file : build_database.GetUnseen())
     {
-      time_stamp_manager.removeFile(file);
+      build_database.Remove(file);
       removeFile(file, texture_compiler, wave_compiler, shader_compiler, mesh_compiler);
+      dependency_graph.RemoveFile(file);
+      dependencies_changed = true;
+    }
+
+    if (dependencies_changed)
+      dependency_graph.Save("generated/dependencies");
+    dependencies_changed = false;
+
+    if (build_database.IsDirty())
+      build_database.Save("generated/build_database");
+    build_cache.Flush();
+    build_cache.LogStats();
+  }
+
+  if (pack)
+  {
+    lambda::VioletArchiveBuilder archive_builder;
+    return archive_builder.Build(lambda::ArchiveBuildInfo{}) ? 0 : 1;
+  }
+
+  // From here on only the files the watcher reports are looked at.
+  while (true)
+  {
+    lambda::Vector<lambda::String> changed_files;
+    for (const lambda::FileWatcher::Event& event : file_watcher.Poll())
+    {
+      // Don't track hidden files, this also skips everything the builder generates.
+      const lambda::String& file = event.file;
+      if (lambda::FileSystem::GetExtension(file).empty())
+        continue;
+
+      // The builder compiles the sources it writes itself, seeing them here would build them twice
+      // and rebuild whatever depends on them.
+      if (isGeneratedSource(file))
+        continue;
+
+      if (event.action == lambda::FileWatcher::Action::kRemoved)
+      {
+        if (build_database.HasFile(file))
+        {
+          build_database.Remove(file);
+          removeFile(file, texture_compiler, wave_compiler, shader_compiler, mesh_compiler);
+          dependency_graph.RemoveFile(file);
+          dependencies_changed = true;
+        }
+        continue;
+      }
+
+      if (build_database.HasChanged(file))
+        changed_files.push_back(file);
+    }
+
+    if (!changed_files.empty())
+      build(changed_files);
+
+    if (dependencies_changed)
+    {
+      dependency_graph.Save("generated/dependencies");
+      dependencies_changed = false;
     }
+    if (build_database.IsDirty())
+      build_database.Save("generated/build_database");
+    build_cache.Flush();
 
-    // Sleep if we should.
-    auto function_end = std::chrono::high_resolution_clock::now();
-    auto sleep_point = function_start + std::chrono::seconds(1);
-    if (function_end < sleep_point)
-      std::this_thread::sleep_for(sleep_point - function_end);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
   }
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "utils/name.h"
 #include <utils/console.h>
+#include <memory/memory.h>
+#include <atomic>
 #include <mutex>
 
 namespace lambda
@@ -12,82 +14,129 @@ namespace lambda
 			kGPUOnly = 1u,
 		};
 
+		// Every named asset gets a slot, handles point straight at theirs. Slots
+		// never move, so copying a handle is a single atomic increment. The lock
+		// is only taken when a slot is handed out or given back. The generation
+		// goes up every time a slot is given back, which tells stale handles and
+		// late releases apart from the current owner.
 		template<typename T>
 		class VioletRefHandler
 		{
 		public:
-			static void incRef(const size_t& hash)
+			struct Slot
 			{
-				g_mutex.lock();
+				std::atomic<int32_t>  refs;
+				std::atomic<uint32_t> generation;
+				size_t hash;
+				Name   name;
+			};
+
+			// Returns the slot of the asset with one reference added.
+			static Slot* acquire(const Name& name, uint32_t& generation)
+			{
+				std::lock_guard<std::mutex> lock(g_mutex);
 				LMB_ASSERT(g_valid, "AssetHandle not valid anymore");
 
-				if (hash == 0u)
+				Slot* slot = nullptr;
+				auto it = g_slots.find(name.getHash());
+				if (it != g_slots.end())
+					slot = it->second;
+				else
 				{
-					g_mutex.unlock();
-					return;
+					if (g_free.empty())
+					{
+						Chunk* chunk = foundation::Memory::construct<Chunk>();
+						for (uint32_t i = 0u; i < kChunkSize; ++i)
+						{
+							chunk->slots[i].refs       = 0;
+							chunk->slots[i].generation = 0u;
+							chunk->slots[i].hash       = 0u;
+							g_free.push_back(&chunk->slots[kChunkSize - i - 1u]);
+						}
+						g_chunks.push_back(chunk);
+					}
+
+					slot = g_free.back();
+					g_free.pop_back();
+					slot->hash = name.getHash();
+					slot->name = name;
+					g_slots.insert(eastl::make_pair(slot->hash, slot));
 				}
 
-				g_refs[hash]++;
-				g_mutex.unlock();
+				slot->refs.fetch_add(1, std::memory_order_relaxed);
+				generation = slot->generation.load(std::memory_order_relaxed);
+				return slot;
 			}
-			static bool decRef(const size_t& hash)
+			static void incRef(Slot* slot)
 			{
-				g_mutex.lock();
-				LMB_ASSERT(g_valid, "AssetHandle not valid anymore");
-
-				if (hash == 0u)
-				{
-					g_mutex.unlock();
+				slot->refs.fetch_add(1, std::memory_order_relaxed);
+			}
+			// Returns false when this was the last reference, the name of the
+			// released asset is moved into name.
+			static bool decRef(Slot* slot, uint32_t generation, Name& name)
+			{
+				if (slot->refs.fetch_sub(1, std::memory_order_acq_rel) > 1)
 					return true;
-				}
 
-				const int ref = --g_refs[hash];
+				std::lock_guard<std::mutex> lock(g_mutex);
+				LMB_ASSERT(g_valid, "AssetHandle not valid anymore");
 
-				if (ref <= 0)
-				{
-					g_refs.erase(hash);
-					g_names.erase(hash);
-				}
-				g_mutex.unlock();
+				// A handle could have been made from the name in the mean time, or
+				// that handle could have released the slot already.
+				if (slot->refs.load(std::memory_order_acquire) > 0 ||
+					slot->generation.load(std::memory_order_relaxed) != generation)
+					return true;
 
-				return ref > 0;
+				g_slots.erase(slot->hash);
+				name = eastl::move(slot->name);
+				slot->name = Name();
+				slot->hash = 0u;
+				slot->generation.fetch_add(1u, std::memory_order_relaxed);
+				g_free.push_back(slot);
+				return false;
 			}
-			static const Name& getName(const size_t& hash)
+			// Only meant for debugging, handles know their own name.
+			static Name getName(const size_t& hash)
 			{
-				g_mutex.lock();
-				LMB_ASSERT(g_valid, "AssetHandle not valid anymore");
-				Name& name = g_names[hash];
-				g_mutex.unlock();
-				return name;
+				std::lock_guard<std::mutex> lock(g_mutex);
+				auto it = g_slots.find(hash);
+				return it != g_slots.end() ? it->second->name : Name();
 			}
-			static void tyToSetName(const size_t& hash, const Name& name)
+			static uint32_t getRefCount(const size_t& hash)
 			{
-				g_mutex.lock();
-				LMB_ASSERT(g_valid, "AssetHandle not valid anymore");
-				if (g_names.find(hash) == g_names.end())
-					g_names[hash] = name;
-				g_mutex.unlock();
+				std::lock_guard<std::mutex> lock(g_mutex);
+				auto it = g_slots.find(hash);
+				return it != g_slots.end() ? (uint32_t)it->second->refs.load(std::memory_order_relaxed) : 0u;
 			}
 			static void releaseAll()
 			{
-				g_mutex.lock();
-				g_refs = UnorderedMap<size_t, int>();
-				g_names = UnorderedMap<size_t, Name>();
+				// Chunks stay alive, handles that are destroyed after this still point to them.
+				std::lock_guard<std::mutex> lock(g_mutex);
+				g_slots = UnorderedMap<size_t, Slot*>();
 				g_valid = false;
 			}
 
 		private:
+			static constexpr uint32_t kChunkSize = 256u;
+			struct Chunk
+			{
+				Slot slots[kChunkSize];
+			};
+
 			static std::mutex g_mutex;
-			static UnorderedMap<size_t, int> g_refs;
-			static UnorderedMap<size_t, Name> g_names;
+			static UnorderedMap<size_t, Slot*> g_slots;
+			static Vector<Slot*> g_free;
+			static Vector<Chunk*> g_chunks;
 			static bool g_valid;
 		};
 
 
 		template<typename T>
-		UnorderedMap<size_t, int> VioletRefHandler<T>::g_refs;
+		UnorderedMap<size_t, typename VioletRefHandler<T>::Slot*> VioletRefHandler<T>::g_slots;
 		template<typename T>
-		UnorderedMap<size_t, Name> VioletRefHandler<T>::g_names;
+		Vector<typename VioletRefHandler<T>::Slot*> VioletRefHandler<T>::g_free;
+		template<typename T>
+		Vector<typename VioletRefHandler<T>::Chunk*> VioletRefHandler<T>::g_chunks;
 		template<typename T>
 		bool VioletRefHandler<T>::g_valid = true;
 		template<typename T>
@@ -99,26 +148,39 @@ namespace lambda
 		{
 		public:
 			VioletHandle()
-				: data_(nullptr)
-				, hash_(0ull)
+				: hash_(0ull)
+				, data_(nullptr)
+				, slot_(nullptr)
+				, generation_(0u)
 			{
 			}
 			VioletHandle(T* data, Name name)
-				: data_(data)
-				, hash_(name.getHash())
+				: hash_(name.getHash())
+				, data_(data)
+				, slot_(nullptr)
+				, generation_(0u)
 			{
 				if (hash_)
-				{
-					VioletRefHandler<T>::tyToSetName(hash_, name);
-					VioletRefHandler<T>::incRef(hash_);
-				}
+					slot_ = VioletRefHandler<T>::acquire(name, generation_);
 			}
 			VioletHandle(const VioletHandle& other)
-				: data_(other.data_)
-				, hash_(other.hash_)
+				: hash_(other.hash_)
+				, data_(other.data_)
+				, slot_(other.slot_)
+				, generation_(other.generation_)
 			{
-				if (hash_)
-					VioletRefHandler<T>::incRef(hash_);
+				if (slot_)
+					VioletRefHandler<T>::incRef(slot_);
+			}
+			VioletHandle(VioletHandle&& other)
+				: hash_(other.hash_)
+				, data_(other.data_)
+				, slot_(other.slot_)
+				, generation_(other.generation_)
+			{
+				other.hash_ = 0ull;
+				other.data_ = nullptr;
+				other.slot_ = nullptr;
 			}
 			~VioletHandle()
 			{
@@ -131,16 +193,33 @@ namespace lambda
 
 				release();
 
-				data_ = other.data_;
-				hash_ = other.hash_;
+				hash_       = other.hash_;
+				data_       = other.data_;
+				slot_       = other.slot_;
+				generation_ = other.generation_;
 
-				if (hash_)
-					VioletRefHandler<T>::incRef(hash_);
+				if (slot_)
+					VioletRefHandler<T>::incRef(slot_);
+			}
+			void operator=(VioletHandle<T>&& other)
+			{
+				if (this == &other)
+					return;
+
+				release();
+
+				hash_       = other.hash_;
+				data_       = other.data_;
+				slot_       = other.slot_;
+				generation_ = other.generation_;
+
+				other.hash_ = 0ull;
+				other.data_ = nullptr;
+				other.slot_ = nullptr;
 			}
 			void operator=(const std::nullptr_t& /*null*/)
 			{
 				release();
-				data_ = nullptr;
 			}
 			bool operator==(const VioletHandle<T>& other) const
 			{
@@ -193,25 +272,27 @@ namespace lambda
 			}
 			Name getName()
 			{
-				return hash_ ? VioletRefHandler<T>::getName(hash_) : Name();
+				return slot_ ? slot_->name : Name();
 			}
 
 			const Name& getName() const
 			{
 				static Name k_name;
-				return hash_ ? VioletRefHandler<T>::getName(hash_) : k_name;
+				return slot_ ? slot_->name : k_name;
 			}
 
 			void release()
 			{
-				Name name = VioletRefHandler<T>::getName(hash_);
-				if (hash_ && !VioletRefHandler<T>::decRef(hash_))
+				Name name;
+				if (slot_ && !VioletRefHandler<T>::decRef(slot_, generation_, name))
 				{
 					foundation::Info("Released \"" + name.getName() + "\"\n");
 					T::release(data_, hash_);
-					data_ = nullptr;
-					hash_ = 0ull;
 				}
+
+				hash_ = 0ull;
+				data_ = nullptr;
+				slot_ = nullptr;
 			}
 
 			void metaSet(String name)
@@ -226,6 +307,8 @@ namespace lambda
 		private:
 			size_t hash_;
 			T* data_;
+			typename VioletRefHandler<T>::Slot* slot_;
+			uint32_t generation_;
 		};
 	}
 }
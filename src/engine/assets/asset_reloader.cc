@@ -0,0 +1,107 @@
+#include "asset_reloader.h"
+#include "assets/texture.h"
+#include "assets/mesh.h"
+#include "assets/shader.h"
+#include <utils/console.h>
+#include <memory/memory.h>
+
+namespace lambda
+{
+	namespace asset
+	{
+		///////////////////////////////////////////////////////////////////////////
+		void AssetReloader::start(const String& folder)
+		{
+			watcher_.Watch(folder);
+			if (watcher_.IsPolling())
+				foundation::Info("ASSET RELOADER: No file notifications for " + folder + ", polling it instead\n");
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetReloader::stop()
+		{
+			watcher_.Stop();
+			for (auto& pending : pending_)
+				pending.clear();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		bool AssetReloader::isRunning() const
+		{
+			return watcher_.IsWatching();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetReloader::update()
+		{
+			if (!watcher_.IsWatching())
+				return;
+
+			for (const FileWatcher::Event& event : watcher_.Poll())
+			{
+				// Assets that are in use stay loaded when their files go away.
+				if (event.action == FileWatcher::Action::kRemoved)
+					continue;
+
+				uint64_t hash = 0u;
+				Type type = Type::kCount;
+				if (ShaderManager::getInstance()->isGeneratedFile(event.file, hash))
+					type = Type::kShader;
+				else if (TextureManager::getInstance()->isGeneratedFile(event.file, hash))
+					type = Type::kTexture;
+				else if (MeshManager::getInstance()->isGeneratedFile(event.file, hash))
+					type = Type::kMesh;
+				else
+					continue;
+
+				pending_[(int)type][hash].reset();
+			}
+
+			// Shaders first, meshes last because they stream their textures in.
+			for (int type = 0; type < (int)Type::kCount; ++type)
+			{
+				UnorderedMap<uint64_t, utilities::Timer>& pending = pending_[type];
+				for (auto it = pending.begin(); it != pending.end();)
+				{
+					if ((float)it->second.elapsed().milliseconds() < settings_.settle_time)
+					{
+						++it;
+						continue;
+					}
+
+					const uint64_t hash = it->first;
+					it = pending.erase(it);
+
+					switch ((Type)type)
+					{
+					case Type::kShader:  ShaderManager::getInstance()->reload(hash);  break;
+					case Type::kTexture: TextureManager::getInstance()->reload(hash); break;
+					case Type::kMesh:    MeshManager::getInstance()->reload(hash);    break;
+					default: break;
+					}
+				}
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetReloader::setSettings(const Settings& settings)
+		{
+			settings_ = settings;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const AssetReloader::Settings& AssetReloader::getSettings() const
+		{
+			return settings_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		AssetReloader* AssetReloader::getInstance()
+		{
+			static AssetReloader* s_instance =
+				foundation::Memory::construct<AssetReloader>();
+
+			return s_instance;
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <containers/containers.h>
+#include <utils/file_watcher.h>
+#include <utils/timer.h>
+
+namespace lambda
+{
+	namespace asset
+	{
+		///////////////////////////////////////////////////////////////////////////
+		// Watches the generated folder and reloads the textures, meshes and
+		// shaders the builder writes again. The assets are updated in place, so
+		// every handle to them sees the new version. Only loose files are
+		// watched, assets read from a mounted archive never change.
+		class AssetReloader
+		{
+		public:
+			struct Settings
+			{
+				// The builder writes the header and the data separately, wait for it to finish.
+				float settle_time = 100.0f; // Milliseconds.
+			};
+
+			void start(const String& folder = "generated/");
+			void stop();
+			bool isRunning() const;
+
+			// Needs to be called from the main thread once per frame, while nothing is being rendered.
+			void update();
+
+			void setSettings(const Settings& settings);
+			const Settings& getSettings() const;
+
+		public:
+			static AssetReloader* getInstance();
+
+		private:
+			enum class Type : uint8_t
+			{
+				kShader,
+				kTexture,
+				kMesh,
+				kCount,
+			};
+
+			FileWatcher watcher_;
+			Settings settings_;
+			// Time since the last change of every asset that is waiting to be reloaded.
+			UnorderedMap<uint64_t, utilities::Timer> pending_[(int)Type::kCount];
+		};
+	}
+}
@@ -0,0 +1,337 @@
+#include "asset_streamer.h"
+#include "utils/mt_manager.h"
+#include <utils/timer.h>
+#include <utils/console.h>
+#include <memory/memory.h>
+#include <algorithm>
+#include <thread>
+
+namespace lambda
+{
+	namespace asset
+	{
+		///////////////////////////////////////////////////////////////////////////
+		uint64_t AssetStreamer::request(ReadFunction read, DecodeFunction decode, CompleteFunction complete, StreamPriority priority)
+		{
+			LMB_ASSERT(priority < StreamPriority::kCount, "ASSET STREAMER: Invalid priority %u", (uint32_t)priority);
+
+			Request* request = foundation::Memory::construct<Request>();
+			request->priority  = priority;
+			request->state     = State::kQueued;
+			request->cancelled = false;
+			request->read      = read;
+			request->decode    = decode;
+			request->complete  = complete;
+
+			mutex_.lock();
+			request->id = next_id_++;
+			requests_.insert(eastl::make_pair(request->id, request));
+			enqueue(request);
+			stats_.requested++;
+			dispatch();
+			mutex_.unlock();
+
+			return request->id;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		bool AssetStreamer::cancel(uint64_t id)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto it = requests_.find(id);
+			if (it == requests_.end() || it->second->cancelled)
+				return false;
+
+			Request* request = it->second;
+			request->cancelled = true;
+			stats_.cancelled++;
+
+			// Workers clean up after themselves when they are done with it.
+			if (request->state != State::kReading && request->state != State::kDecoding)
+			{
+				requests_.erase(it);
+				foundation::Memory::destruct(request);
+			}
+
+			return true;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetStreamer::setPriority(uint64_t id, StreamPriority priority)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto it = requests_.find(id);
+			if (it == requests_.end() || it->second->priority == priority)
+				return;
+
+			it->second->priority = priority;
+			enqueue(it->second);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		bool AssetStreamer::isPending(uint64_t id) const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto it = requests_.find(id);
+			return it != requests_.end() && !it->second->cancelled;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetStreamer::wait(uint64_t id)
+		{
+			setPriority(id, StreamPriority::kCritical);
+
+			while (true)
+			{
+				mutex_.lock();
+				auto it = requests_.find(id);
+				if (it == requests_.end() || it->second->cancelled)
+				{
+					mutex_.unlock();
+					return;
+				}
+
+				Request* request = it->second;
+				if (request->state == State::kDecoded)
+				{
+					// Its id stays in the queue, front skips it once it is gone.
+					requests_.erase(it);
+					mutex_.unlock();
+					complete(request);
+					return;
+				}
+
+				dispatch();
+				mutex_.unlock();
+				std::this_thread::sleep_for(std::chrono::microseconds(1));
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetStreamer::update()
+		{
+			utilities::Timer timer;
+			uint32_t completed = 0u;
+
+			while (true)
+			{
+				mutex_.lock();
+				dispatch();
+				Request* request = front(State::kDecoded);
+				if (request == nullptr)
+				{
+					mutex_.unlock();
+					break;
+				}
+
+				// Critical requests always land, the rest has to fit in the budget.
+				const bool over_budget =
+					completed >= settings_.max_completions_per_frame ||
+					(float)timer.elapsed().milliseconds() >= settings_.max_completion_time;
+				if (over_budget && request->priority != StreamPriority::kCritical)
+				{
+					mutex_.unlock();
+					break;
+				}
+
+				pop(request);
+				requests_.erase(request->id);
+				mutex_.unlock();
+
+				complete(request);
+				completed++;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			stats_.pending             = (uint32_t)requests_.size();
+			stats_.completion_time     = (float)timer.elapsed().milliseconds();
+			stats_.max_completion_time = std::max(stats_.max_completion_time, stats_.completion_time);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetStreamer::setSettings(const Settings& settings)
+		{
+			LMB_ASSERT(settings.max_reads_in_flight > 0u && settings.max_decodes_in_flight > 0u, "ASSET STREAMER: Needs at least one job in flight per stage");
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			settings_ = settings;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const AssetStreamer::Settings& AssetStreamer::getSettings() const
+		{
+			return settings_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		AssetStreamer::Stats AssetStreamer::getStats() const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return stats_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		AssetStreamer* AssetStreamer::getInstance()
+		{
+			static AssetStreamer* s_instance =
+				foundation::Memory::construct<AssetStreamer>();
+
+			return s_instance;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		AssetStreamer::~AssetStreamer()
+		{
+			mutex_.lock();
+			for (auto it = requests_.begin(); it != requests_.end();)
+			{
+				Request* request = it->second;
+				request->cancelled = true;
+
+				if (request->state != State::kReading && request->state != State::kDecoding)
+				{
+					foundation::Memory::destruct(request);
+					it = requests_.erase(it);
+				}
+				else
+					++it;
+			}
+			mutex_.unlock();
+
+			while (jobs_in_flight_ > 0u)
+				std::this_thread::sleep_for(std::chrono::microseconds(1));
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetStreamer::dispatch()
+		{
+			// Expects the mutex to be locked.
+			while (decodes_in_flight_ < settings_.max_decodes_in_flight)
+			{
+				Request* request = front(State::kRead);
+				if (request == nullptr)
+					break;
+
+				pop(request);
+				request->state = State::kDecoding;
+				decodes_in_flight_++;
+				jobs_in_flight_++;
+				platform::TaskScheduler::queue(decode, request, platform::TaskScheduler::kMedium);
+			}
+
+			while (reads_in_flight_ < settings_.max_reads_in_flight)
+			{
+				Request* request = front(State::kQueued);
+				if (request == nullptr)
+					break;
+
+				pop(request);
+				request->state = State::kReading;
+				reads_in_flight_++;
+				jobs_in_flight_++;
+				platform::TaskScheduler::queue(read, request, platform::TaskScheduler::kLow);
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetStreamer::complete(Request* request)
+		{
+			if (request->complete)
+				request->complete(request->data);
+
+			mutex_.lock();
+			stats_.completed++;
+			mutex_.unlock();
+
+			foundation::Memory::destruct(request);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetStreamer::enqueue(Request* request)
+		{
+			// Expects the mutex to be locked. Only the states that wait for a stage have a queue.
+			if (request->state == State::kQueued || request->state == State::kRead || request->state == State::kDecoded)
+				waiting_[(uint8_t)request->state][(uint8_t)request->priority].push(request->id);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		AssetStreamer::Request* AssetStreamer::front(State state)
+		{
+			// Highest priority first, first come first served within a priority.
+			for (uint8_t priority = 0u; priority < (uint8_t)StreamPriority::kCount; ++priority)
+			{
+				Queue<uint64_t>& queue = waiting_[(uint8_t)state][priority];
+				while (!queue.empty())
+				{
+					auto it = requests_.find(queue.front());
+					if (it != requests_.end() && !it->second->cancelled && it->second->state == state && (uint8_t)it->second->priority == priority)
+						return it->second;
+					queue.pop();
+				}
+			}
+			return nullptr;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetStreamer::pop(Request* request)
+		{
+			// Expects request to be what front returned.
+			waiting_[(uint8_t)request->state][(uint8_t)request->priority].pop();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetStreamer::read(void* user_data)
+		{
+			AssetStreamer* streamer = getInstance();
+			Request* request = (Request*)user_data;
+
+			if (!request->cancelled)
+				request->data = request->read();
+
+			streamer->mutex_.lock();
+			streamer->reads_in_flight_--;
+			if (request->cancelled)
+			{
+				streamer->requests_.erase(request->id);
+				foundation::Memory::destruct(request);
+			}
+			else
+			{
+				request->state = State::kRead;
+				streamer->enqueue(request);
+			}
+			streamer->dispatch();
+			streamer->mutex_.unlock();
+			streamer->jobs_in_flight_--;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void AssetStreamer::decode(void* user_data)
+		{
+			AssetStreamer* streamer = getInstance();
+			Request* request = (Request*)user_data;
+
+			if (!request->cancelled && request->decode)
+				request->data = request->decode(request->data);
+
+			streamer->mutex_.lock();
+			streamer->decodes_in_flight_--;
+			if (request->cancelled)
+			{
+				streamer->requests_.erase(request->id);
+				foundation::Memory::destruct(request);
+			}
+			else
+			{
+				request->state = State::kDecoded;
+				streamer->enqueue(request);
+			}
+			streamer->dispatch();
+			streamer->mutex_.unlock();
+			streamer->jobs_in_flight_--;
+		}
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <containers/containers.h>
+#include <atomic>
+#include <mutex>
+
+namespace lambda
+{
+	namespace asset
+	{
+		///////////////////////////////////////////////////////////////////////////
+		enum class StreamPriority : uint8_t
+		{
+			kCritical, // Needed this frame, ignores the completion budget.
+			kVisible,
+			kPrefetch,
+			kCount,
+		};
+
+		///////////////////////////////////////////////////////////////////////////
+		// Loads asset data in the background. Every request goes through a read
+		// stage and a decode stage, both run on the task scheduler and are picked
+		// by priority. Finished requests are handed back on the main thread in
+		// update(), limited by a per frame budget so landing a lot of data at
+		// once does not cause a hitch.
+		class AssetStreamer
+		{
+		public:
+			typedef Function<Vector<char>(void)> ReadFunction;
+			typedef Function<Vector<char>(const Vector<char>&)> DecodeFunction;
+			typedef Function<void(Vector<char>&)> CompleteFunction;
+
+			struct Settings
+			{
+				uint32_t max_reads_in_flight       = 2u;
+				uint32_t max_decodes_in_flight     = 2u;
+				uint32_t max_completions_per_frame = 8u;
+				float    max_completion_time       = 2.0f; // Milliseconds.
+			};
+
+			struct Stats
+			{
+				uint32_t requested = 0u;
+				uint32_t completed = 0u;
+				uint32_t cancelled = 0u;
+				uint32_t pending   = 0u;
+				// Time update() spent handing back data, last frame and worst frame.
+				float    completion_time     = 0.0f;
+				float    max_completion_time = 0.0f;
+			};
+
+			static constexpr uint64_t kInvalid = 0u;
+
+			uint64_t request(ReadFunction read, DecodeFunction decode, CompleteFunction complete, StreamPriority priority);
+			// Returns false when the request already landed. Work that is in flight
+			// still finishes, but its result is thrown away.
+			bool cancel(uint64_t id);
+			void setPriority(uint64_t id, StreamPriority priority);
+			bool isPending(uint64_t id) const;
+			// Blocks until the request landed.
+			void wait(uint64_t id);
+
+			// Needs to be called from the main thread once per frame.
+			void update();
+
+			void setSettings(const Settings& settings);
+			const Settings& getSettings() const;
+			Stats getStats() const;
+
+		public:
+			static AssetStreamer* getInstance();
+			~AssetStreamer();
+
+		private:
+			enum class State : uint8_t
+			{
+				kQueued,
+				kReading,
+				kRead,
+				kDecoding,
+				kDecoded,
+				kCount,
+			};
+
+			struct Request
+			{
+				uint64_t         id;
+				StreamPriority   priority;
+				State            state;
+				std::atomic<bool> cancelled; // Read by the workers without the lock.
+				ReadFunction     read;
+				DecodeFunction   decode;
+				CompleteFunction complete;
+				Vector<char>     data;
+			};
+
+			void dispatch();
+			void complete(Request* request);
+			void enqueue(Request* request);
+			Request* front(State state);
+			void pop(Request* request);
+			static void read(void* user_data);
+			static void decode(void* user_data);
+
+		private:
+			mutable std::mutex         mutex_;
+			Settings                   settings_;
+			Stats                      stats_;
+			uint64_t                   next_id_ = 1u;
+			UnorderedMap<uint64_t, Request*> requests_;
+			// Ids of the requests waiting for the next stage, per state and priority.
+			// Requests that were cancelled, moved on or changed priority are only
+			// dropped once they reach the front.
+			Queue<uint64_t>            waiting_[(uint8_t)State::kCount][(uint8_t)StreamPriority::kCount];
+			uint32_t                   reads_in_flight_   = 0u;
+			uint32_t                   decodes_in_flight_ = 0u;
+			std::atomic<uint32_t>      jobs_in_flight_ = { 0u };
+		};
+	}
+}
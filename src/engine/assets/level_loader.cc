@@ -0,0 +1,144 @@
+#include "level_loader.h"
+#include "interfaces/irenderer.h"
+#include <utils/console.h>
+#include <utils/timer.h>
+#include <memory/memory.h>
+
+namespace lambda
+{
+	namespace asset
+	{
+		///////////////////////////////////////////////////////////////////////////
+		bool LevelLoader::initialize(const String& file)
+		{
+			initialized_ = graph_.Load(file);
+			if (!initialized_)
+				foundation::Info("LEVEL LOADER: No dependencies found in " + file + ", assets are loaded on first use\n");
+			return initialized_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		bool LevelLoader::isInitialized() const
+		{
+			return initialized_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void LevelLoader::setRenderer(platform::IRenderer* renderer)
+		{
+			renderer_ = renderer;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void LevelLoader::load(const String& level)
+		{
+			if (renderer_ && !level_.empty())
+				renderer_->endLevel(level_);
+
+			if (!initialized_)
+			{
+				level_ = level;
+				if (renderer_)
+					renderer_->beginLevel(level_, shaders_);
+				return;
+			}
+
+			utilities::Timer timer;
+			const Vector<uint64_t> closure = graph_.GetClosure({ hash(level) });
+			const Vector<uint64_t> unloaded = graph_.GetUnloaded(closure_, closure);
+
+			// The new handles are taken before the old ones are released, so
+			// shared assets never drop to zero references in between.
+			Vector<VioletTextureHandle> textures;
+			Vector<VioletMeshHandle>    meshes;
+			Vector<VioletShaderHandle>  shaders;
+			Vector<VioletWaveHandle>    waves;
+
+			// The closure is sorted by type and hash, the order of the archive.
+			for (uint64_t asset : closure)
+			{
+				switch (graph_.GetNode(asset)->type)
+				{
+				case VioletAssetType::kTexture:
+					textures.push_back(TextureManager::getInstance()->stream(asset, StreamPriority::kPrefetch));
+					break;
+				case VioletAssetType::kMesh:
+					meshes.push_back(MeshManager::getInstance()->get(asset));
+					break;
+				case VioletAssetType::kShader:
+					shaders.push_back(ShaderManager::getInstance()->get(asset));
+					break;
+				case VioletAssetType::kWave:
+					waves.push_back(WaveManager::getInstance()->get(asset));
+					break;
+				default:
+					break;
+				}
+			}
+
+			textures_.swap(textures);
+			meshes_.swap(meshes);
+			shaders_.swap(shaders);
+			waves_.swap(waves);
+			// Releasing the previous level unloads everything only it used.
+			textures.clear();
+			meshes.clear();
+			shaders.clear();
+			waves.clear();
+
+			const VioletDependencyGraph::Footprint unloaded_footprint = graph_.GetFootprint(unloaded);
+			level_     = level;
+			closure_   = closure;
+			footprint_ = graph_.GetFootprint(closure_);
+			if (renderer_)
+				renderer_->beginLevel(level_, shaders_);
+
+			foundation::Info(
+				"LEVEL LOADER: " + level + " needs " + toString(closure_.size()) + " assets (" +
+				toString(footprint_.total / (1024u * 1024u)) + " MB), released " + toString(unloaded.size()) + " assets (" +
+				toString(unloaded_footprint.total / (1024u * 1024u)) + " MB) in " + toString(timer.elapsed().milliseconds()) + "ms\n"
+			);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void LevelLoader::unload()
+		{
+			if (renderer_ && !level_.empty())
+				renderer_->endLevel(level_);
+			textures_.clear();
+			meshes_.clear();
+			shaders_.clear();
+			waves_.clear();
+			level_.clear();
+			closure_.clear();
+			footprint_ = VioletDependencyGraph::Footprint();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const String& LevelLoader::getLevel() const
+		{
+			return level_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const VioletDependencyGraph::Footprint& LevelLoader::getFootprint() const
+		{
+			return footprint_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const VioletDependencyGraph& LevelLoader::getGraph() const
+		{
+			return graph_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		LevelLoader* LevelLoader::getInstance()
+		{
+			static LevelLoader* s_instance =
+				foundation::Memory::construct<LevelLoader>();
+
+			return s_instance;
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "assets/texture.h"
+#include "assets/mesh.h"
+#include "assets/shader.h"
+#include "assets/wave.h"
+#include <assets/dependency_graph.h>
+
+namespace lambda
+{
+	namespace platform
+	{
+		class IRenderer;
+	}
+
+	namespace asset
+	{
+		///////////////////////////////////////////////////////////////////////////
+		// Preloads everything a level needs, using the dependency graph the
+		// builder writes. A level is named by its main script. The loader holds
+		// a handle to every asset of the current level, so switching levels
+		// only unloads the assets the next level does not reference.
+		class LevelLoader
+		{
+		public:
+			bool initialize(const String& file = "generated/dependencies");
+			bool isInitialized() const;
+			// Told when a level starts and ends, so it can record and prewarm its pipelines.
+			void setRenderer(platform::IRenderer* renderer);
+
+			// Needs to be called from the main thread, textures keep streaming in afterwards.
+			void load(const String& level);
+			void unload();
+			const String& getLevel() const;
+			const VioletDependencyGraph::Footprint& getFootprint() const;
+			const VioletDependencyGraph& getGraph() const;
+
+		public:
+			static LevelLoader* getInstance();
+
+		private:
+			VioletDependencyGraph graph_;
+			bool initialized_ = false;
+			platform::IRenderer* renderer_ = nullptr;
+			String level_;
+			Vector<uint64_t> closure_;
+			VioletDependencyGraph::Footprint footprint_;
+
+			Vector<VioletTextureHandle> textures_;
+			Vector<VioletMeshHandle>    meshes_;
+			Vector<VioletShaderHandle>  shaders_;
+			Vector<VioletWaveHandle>    waves_;
+		};
+	}
+}
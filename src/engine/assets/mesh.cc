@@ -4,11 +4,132 @@
 #include "interfaces/irenderer.h"
 #include <utils/file_system.h>
 #include <glm/gtx/norm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <atomic>
 
 namespace lambda
 {
   namespace asset
   {
+    // Lives in front of the data, which it keeps 16 byte aligned.
+    struct alignas(16) Mesh::Buffer::Storage
+    {
+      std::atomic<uint32_t> references;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    Mesh::Buffer::Buffer(const void* data, uint32_t count, uint16_t size)
+      : count(count)
+      , size(size)
+    {
+      const size_t bytes = (size_t)count * size;
+      if (bytes == 0u)
+        return;
+
+      storage_ = (Storage*)foundation::Memory::allocate(sizeof(Storage) + bytes, alignof(Storage));
+      new (storage_) Storage();
+      storage_->references = 1u;
+
+      void* storage_data = storage_ + 1;
+      if (data)
+        memcpy(storage_data, data, bytes);
+      else
+        memset(storage_data, 0, bytes);
+      this->data = storage_data;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    Mesh::Buffer::Buffer(const Buffer& other)
+      : data(other.data)
+      , count(other.count)
+      , size(other.size)
+      , storage_(other.storage_)
+    {
+      if (storage_)
+        storage_->references++;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    Mesh::Buffer::Buffer(Buffer&& other)
+      : data(other.data)
+      , count(other.count)
+      , size(other.size)
+      , storage_(other.storage_)
+    {
+      other.data     = nullptr;
+      other.count    = 0u;
+      other.size     = 0u;
+      other.storage_ = nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    Mesh::Buffer& Mesh::Buffer::operator=(const Buffer& other)
+    {
+      if (this != &other)
+      {
+        if (other.storage_)
+          other.storage_->references++;
+        release();
+        data     = other.data;
+        count    = other.count;
+        size     = other.size;
+        storage_ = other.storage_;
+      }
+      return *this;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    Mesh::Buffer& Mesh::Buffer::operator=(Buffer&& other)
+    {
+      if (this != &other)
+      {
+        release();
+        data     = other.data;
+        count    = other.count;
+        size     = other.size;
+        storage_ = other.storage_;
+        other.data     = nullptr;
+        other.count    = 0u;
+        other.size     = 0u;
+        other.storage_ = nullptr;
+      }
+      return *this;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    Mesh::Buffer::~Buffer()
+    {
+      release();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void* Mesh::Buffer::getMutableData()
+    {
+      if (isShared())
+        *this = Buffer(data, count, size);
+      return (void*)data;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    bool Mesh::Buffer::isShared() const
+    {
+      return storage_ && storage_->references > 1u;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void Mesh::Buffer::release()
+    {
+      if (storage_ && --storage_->references == 0u)
+      {
+        storage_->~Storage();
+        foundation::Memory::deallocate(storage_);
+      }
+      storage_ = nullptr;
+      data     = nullptr;
+      count    = 0u;
+      size     = 0u;
+    }
+
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     Mesh::Mesh()
     {
@@ -31,6 +152,13 @@ namespace lambda
 
       textures_      = mesh.textures_;
       texture_count_ = mesh.texture_count_;
+
+      impostor_albedo_       = mesh.impostor_albedo_;
+      impostor_normal_depth_ = mesh.impostor_normal_depth_;
+      impostor_frames_       = mesh.impostor_frames_;
+
+      joints_ = mesh.joints_;
+      clips_  = mesh.clips_;
     }
     
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -80,6 +208,32 @@ namespace lambda
 		return buffer_.at(hash);
 	}
 
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Mesh::ColliderData Mesh::makeColliderData(const uint64_t& sub_mesh, const glm::vec3& scale) const
+	{
+		// Packed positions are decoded straight into the array.
+		struct PackedPosition { uint16_t v[4]; };
+		const SubMesh& sm = sub_meshes_.at(sub_mesh);
+		const bool packed = (sm.quantized & kMeshQuantizedPositions) != 0u;
+		const MeshView<glm::vec3> positions = packed ? MeshView<glm::vec3>() : get<glm::vec3>(MeshElements::kPositions, sub_mesh);
+		const MeshView<PackedPosition> packed_positions = packed ? get<PackedPosition>(MeshElements::kPositions, sub_mesh) : MeshView<PackedPosition>();
+		const bool indices_16 = get(MeshElements::kIndices).size == sizeof(uint16_t);
+		const MeshView<uint16_t> indices16 = indices_16 ? get<uint16_t>(MeshElements::kIndices, sub_mesh) : MeshView<uint16_t>();
+		const MeshView<uint32_t> indices32 = indices_16 ? MeshView<uint32_t>() : get<uint32_t>(MeshElements::kIndices, sub_mesh);
+
+		ColliderData data;
+		data.vertex_count = packed ? packed_positions.size() : positions.size();
+		data.index_count  = indices_16 ? indices16.size() : indices32.size();
+		data.vertices     = (glm::vec3*)foundation::Memory::allocate(data.vertex_count * sizeof(glm::vec3));
+		data.indices      = (int*)foundation::Memory::allocate(data.index_count * sizeof(int));
+
+		for (size_t i = 0u; i < data.vertex_count; ++i)
+			data.vertices[i] = (packed ? VioletMeshManager::DequantizePosition(packed_positions[i].v, sm.position_min, sm.position_max) : positions[i]) * scale;
+		for (size_t i = 0u; i < data.index_count; ++i)
+			data.indices[i] = indices_16 ? (int)indices16[i] : (int)indices32[i];
+		return data;
+	}
+
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     void Mesh::set(const uint32_t& hash, const Buffer& buffer)
     {
@@ -87,6 +241,13 @@ namespace lambda
       changed_[hash] = true;
     }
     
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void Mesh::set(const uint32_t& hash, Buffer&& buffer)
+    {
+	  buffer_[hash] = eastl::move(buffer);
+      changed_[hash] = true;
+    }
+    
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     void Mesh::clear(bool has_changed)
     {
@@ -97,8 +258,9 @@ namespace lambda
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     void Mesh::recalculateTangents()
     {
-      Vector<glm::vec3> normals = get<glm::vec3>(MeshElements::kNormals);
-	  Vector<uint32_t>  indices = get<uint32_t>(MeshElements::kIndices);
+      dequantize();
+      const MeshView<glm::vec3> normals = get<glm::vec3>(MeshElements::kNormals);
+	  const MeshView<uint32_t>  indices = get<uint32_t>(MeshElements::kIndices);
       Vector<glm::vec3> tangents(get(MeshElements::kPositions).count);
 
 	  for (glm::vec3& tan : tangents)
@@ -125,6 +287,84 @@ namespace lambda
       set(MeshElements::kTangents, Buffer(tangents));
     }
     
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	void Mesh::dequantize()
+	{
+		struct Stream
+		{
+			uint32_t hash;
+			uint32_t flag;
+			uint16_t size;
+		};
+		static const Stream kStreams[] = {
+			{ MeshElements::kPositions, kMeshQuantizedPositions, sizeof(glm::vec3) },
+			{ MeshElements::kNormals,   kMeshQuantizedNormals,   sizeof(glm::vec3) },
+			{ MeshElements::kTangents,  kMeshQuantizedTangents,  sizeof(glm::vec3) },
+			{ MeshElements::kTexCoords, kMeshQuantizedTexCoords, sizeof(glm::vec2) },
+		};
+
+		uint32_t quantized = 0u;
+		for (const SubMesh& sub_mesh : sub_meshes_)
+			quantized |= sub_mesh.quantized;
+
+		for (const Stream& stream : kStreams)
+		{
+			if (!(quantized & stream.flag) || !has(stream.hash))
+				continue;
+
+			// Every packed element becomes one float element, so the segments keep their index.
+			const Buffer& packed = get(stream.hash);
+			Buffer decoded(nullptr, packed.count, stream.size);
+			unsigned char* to = (unsigned char*)decoded.getMutableData();
+			bool any = false;
+
+			for (SubMesh& sub_mesh : sub_meshes_)
+			{
+				const auto it = sub_mesh.offsets.find(stream.hash);
+				if (!(sub_mesh.quantized & stream.flag) || it == sub_mesh.offsets.end() || it->second.stride == 0u)
+					continue;
+
+				SubMesh::Offset& offset = it->second;
+				const unsigned char* from = (const unsigned char*)packed.data + offset.offset;
+				const size_t first = offset.offset / offset.stride;
+				for (size_t i = 0u; i < offset.count; ++i)
+				{
+					const unsigned char* element = from + i * offset.stride;
+					unsigned char* out = to + (first + i) * stream.size;
+					uint32_t v;
+					memcpy(&v, element, sizeof(uint32_t));
+					if (stream.flag == kMeshQuantizedPositions)
+					{
+						uint16_t p[4];
+						memcpy(p, element, sizeof(p));
+						const glm::vec3 position = VioletMeshManager::DequantizePosition(p, sub_mesh.position_min, sub_mesh.position_max);
+						memcpy(out, &position, sizeof(position));
+					}
+					else if (stream.flag == kMeshQuantizedTexCoords)
+					{
+						const glm::vec2 tex = glm::unpackHalf2x16(v);
+						memcpy(out, &tex, sizeof(tex));
+					}
+					else
+					{
+						// The renderer wants the tangents without the sign in w.
+						const glm::vec3 direction = glm::vec3(VioletMeshManager::DequantizeDirection(v));
+						memcpy(out, &direction, sizeof(direction));
+					}
+				}
+				offset.offset = first * stream.size;
+				offset.stride = stream.size;
+				any = true;
+			}
+
+			if (any)
+				set(stream.hash, eastl::move(decoded));
+		}
+
+		for (SubMesh& sub_mesh : sub_meshes_)
+			sub_mesh.quantized = 0u;
+	}
+
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     bool Mesh::changed(const uint32_t& hash) const
     {
@@ -137,6 +377,13 @@ namespace lambda
       changed_.at(hash) = true;
     }
     
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void* Mesh::getMutableData(const uint32_t& hash)
+    {
+      markAsChanged(hash);
+      return buffer_.at(hash).getMutableData();
+    }
+    
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     void Mesh::updated()
     {
@@ -181,6 +428,51 @@ namespace lambda
       return texture_count_;
     }
     
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void Mesh::setImpostor(VioletTextureHandle albedo, VioletTextureHandle normal_depth, uint32_t frames)
+    {
+      impostor_albedo_       = albedo;
+      impostor_normal_depth_ = normal_depth;
+      impostor_frames_       = frames;
+    }
+    
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    VioletTextureHandle Mesh::getImpostorAlbedo() const
+    {
+      return impostor_albedo_;
+    }
+    
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    VioletTextureHandle Mesh::getImpostorNormalDepth() const
+    {
+      return impostor_normal_depth_;
+    }
+    
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    uint32_t Mesh::getImpostorFrames() const
+    {
+      return impostor_frames_;
+    }
+    
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void Mesh::setAnimation(const Vector<VioletMeshJoint>& joints, const Vector<VioletAnimationClip>& clips)
+    {
+      joints_ = joints;
+      clips_  = clips;
+    }
+    
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    const Vector<VioletMeshJoint>& Mesh::getJoints() const
+    {
+      return joints_;
+    }
+    
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    const Vector<VioletAnimationClip>& Mesh::getClips() const
+    {
+      return clips_;
+    }
+    
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     Mesh Mesh::createScreenQuad()
     {
@@ -943,28 +1235,45 @@ namespace lambda
 		}
 
 		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-		VioletMeshHandle MeshManager::create(Name name, VioletMesh mesh)
+		VioletMeshHandle MeshManager::create(Name name, const VioletMesh& mesh)
+		{
+			return create(name, convert(mesh));
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		Mesh MeshManager::convert(const VioletMesh& mesh)
 		{
-			Vector<glm::vec3> pos(mesh.data.pos.data.size() / sizeof(glm::vec3));
-			Vector<glm::vec3> nor(mesh.data.nor.data.size() / sizeof(glm::vec3));
-			Vector<glm::vec2> tex(mesh.data.tex.data.size() / sizeof(glm::vec2));
-			Vector<glm::vec4> col(mesh.data.col.data.size() / sizeof(glm::vec4));
-			Vector<glm::vec4> ltn(mesh.data.tan.data.size() / sizeof(glm::vec4));
-			Vector<glm::vec4> joi(mesh.data.joi.data.size() / sizeof(glm::vec4));
-			Vector<glm::vec4> wei(mesh.data.wei.data.size() / sizeof(glm::vec4));
-			Vector<uint32_t>  idx(mesh.data.idx.data.size() / sizeof(uint32_t));
-			Vector<glm::vec3> tan(ltn.size());
-
-			memcpy((void*)pos.data(), mesh.data.pos.data.data(), mesh.data.pos.data.size());
-			memcpy((void*)nor.data(), mesh.data.nor.data.data(), mesh.data.nor.data.size());
-			memcpy((void*)tex.data(), mesh.data.tex.data.data(), mesh.data.tex.data.size());
-			memcpy((void*)col.data(), mesh.data.col.data.data(), mesh.data.col.data.size());
-			memcpy((void*)ltn.data(), mesh.data.tan.data.data(), mesh.data.tan.data.size());
-			memcpy((void*)joi.data(), mesh.data.joi.data.data(), mesh.data.joi.data.size());
-			memcpy((void*)wei.data(), mesh.data.wei.data.data(), mesh.data.wei.data.size());
-			memcpy((void*)idx.data(), mesh.data.idx.data.data(), mesh.data.idx.data.size());
-			for (uint64_t i = 0u; i < tan.size(); ++i)
-				memcpy((glm::vec3*)tan.data() + i, (glm::vec4*)ltn.data() + i, sizeof(float) * 3u);
+			// Packed streams stay packed in the vertex buffers, the VIOLET_QUANTIZED
+			// variants of the vertex shaders decode them. Only the D3D11 renderer
+			// has those variants, the other renderers and meshes that only have
+			// some of their streams packed get floats.
+#if defined VIOLET_RENDERER_D3D11
+			const bool packed = mesh.data.quantized == kMeshQuantizedAll;
+#else
+			const bool packed = false;
+#endif
+			if (mesh.data.quantized != 0u && !packed)
+			{
+				VioletMesh decoded = mesh;
+				VioletMeshManager::Dequantize(decoded);
+				return convert(decoded);
+			}
+
+			// The streams are copied once, straight out of the loaded mesh.
+			const auto makeBuffer = [](const VioletDataInfo& info, uint16_t size) {
+				return asset::Mesh::Buffer(info.data.data(), (uint32_t)(info.data.size() / size), size);
+			};
+
+			// The renderer wants the tangents without the sign in w, packed tangents keep it in their last bits.
+			asset::Mesh::Buffer tan = packed ?
+				makeBuffer(mesh.data.tan, sizeof(uint32_t)) :
+				asset::Mesh::Buffer(nullptr, (uint32_t)(mesh.data.tan.data.size() / sizeof(glm::vec4)), sizeof(glm::vec3));
+			if (!packed)
+			{
+				glm::vec3* tangents = (glm::vec3*)tan.getMutableData();
+				for (uint32_t i = 0u; i < tan.count; ++i)
+					memcpy(tangents + i, mesh.data.tan.data.data() + i * sizeof(glm::vec4), sizeof(float) * 3u);
+			}
 
 			Vector<asset::SubMesh> sub_meshes;
 			for (const VioletSubMesh& m : mesh.meshes)
@@ -1000,7 +1309,12 @@ namespace lambda
 					mesh.data.col.segments.at(m.col).count,
 					mesh.data.col.segments.at(m.col).stride
 				};
-				if (m.tan >= 0) sm.offsets[asset::MeshElements::kTangents] = asset::SubMesh::Offset{
+				if (m.tan >= 0 && packed) sm.offsets[asset::MeshElements::kTangents] = asset::SubMesh::Offset{
+					mesh.data.tan.segments.at(m.tan).offset,
+					mesh.data.tan.segments.at(m.tan).count,
+					mesh.data.tan.segments.at(m.tan).stride
+				};
+				else if (m.tan >= 0) sm.offsets[asset::MeshElements::kTangents] = asset::SubMesh::Offset{
 					mesh.data.tan.segments.at(m.tan).offset / mesh.data.tan.segments.at(m.tan).stride * sizeof(glm::vec3),
 					//mesh.data.tan.segments.at(m.tan].offset,
 					mesh.data.tan.segments.at(m.tan).count,
@@ -1026,30 +1340,74 @@ namespace lambda
 					mesh.data.idx.segments.at(m.idx).count,
 					mesh.data.idx.segments.at(m.idx).stride
 				};
+				for (const VioletMeshLOD& lod : mesh.data.lods)
+				{
+					if (m.idx < 0 || lod.base != m.idx)
+						continue;
+
+					const VioletDataSegment& segment = mesh.data.idx.segments.at(lod.idx);
+					asset::SubMesh::LOD level;
+					level.indices = asset::SubMesh::Offset{ segment.offset, segment.count, segment.stride };
+					level.error   = lod.error;
+					sm.lods.push_back(level);
+				}
+				for (const VioletMeshImpostor& impostor : mesh.data.impostors)
+				{
+					if (m.idx < 0 || impostor.idx != m.idx)
+						continue;
+
+					sm.impostor.rect   = impostor.rect;
+					sm.impostor.center = impostor.center;
+					sm.impostor.radius = impostor.radius;
+					sm.impostor.error  = impostor.error;
+				}
+				for (const VioletMeshCluster& cluster : mesh.data.clusters)
+				{
+					if (m.idx < 0 || cluster.idx != m.idx)
+						continue;
+
+					asset::SubMesh::Cluster c;
+					c.index_offset = cluster.index_offset;
+					c.index_count  = cluster.index_count;
+					c.center       = cluster.center;
+					c.radius       = cluster.radius;
+					c.cone_axis    = cluster.cone_axis;
+					c.cone_cutoff  = cluster.cone_cutoff;
+					sm.clusters.push_back(c);
+				}
 				sm.min = m.aabb_min;
 				sm.max = m.aabb_max;
+				if (packed)
+				{
+					sm.quantized = mesh.data.quantized;
+					if (m.pos >= 0)
+					{
+						sm.position_min = mesh.data.pos_bounds.at(m.pos * 2u);
+						sm.position_max = mesh.data.pos_bounds.at(m.pos * 2u + 1u);
+					}
+				}
 				sub_meshes.push_back(sm);
 			}
 
 			Vector<asset::VioletTextureHandle> textures;
 			for (const String& texture : mesh.data.tex_alb)
-				textures.push_back(asset::TextureManager::getInstance()->get(texture));
+				textures.push_back(asset::TextureManager::getInstance()->stream(texture));
 			for (const String& texture : mesh.data.tex_nrm)
-				textures.push_back(asset::TextureManager::getInstance()->get(texture));
+				textures.push_back(asset::TextureManager::getInstance()->stream(texture));
 			for (const String& texture : mesh.data.tex_dmra)
-				textures.push_back(asset::TextureManager::getInstance()->get(texture));
+				textures.push_back(asset::TextureManager::getInstance()->stream(texture));
 			for (const String& texture : mesh.data.tex_emi)
-				textures.push_back(asset::TextureManager::getInstance()->get(texture));
+				textures.push_back(asset::TextureManager::getInstance()->stream(texture));
 
 			asset::Mesh m;
-			m.set(asset::MeshElements::kPositions, eastl::move(pos));
-			m.set(asset::MeshElements::kNormals, eastl::move(nor));
-			m.set(asset::MeshElements::kTexCoords, eastl::move(tex));
-			m.set(asset::MeshElements::kColours, eastl::move(col));
+			m.set(asset::MeshElements::kPositions, makeBuffer(mesh.data.pos, packed ? sizeof(uint16_t) * 4u : sizeof(glm::vec3)));
+			m.set(asset::MeshElements::kNormals, makeBuffer(mesh.data.nor, packed ? sizeof(uint32_t) : sizeof(glm::vec3)));
+			m.set(asset::MeshElements::kTexCoords, makeBuffer(mesh.data.tex, packed ? sizeof(uint32_t) : sizeof(glm::vec2)));
+			m.set(asset::MeshElements::kColours, makeBuffer(mesh.data.col, sizeof(glm::vec4)));
 			m.set(asset::MeshElements::kTangents, eastl::move(tan));
-			m.set(asset::MeshElements::kJoints, eastl::move(joi));
-			m.set(asset::MeshElements::kWeights, eastl::move(wei));
-			m.set(asset::MeshElements::kIndices, eastl::move(idx));
+			m.set(asset::MeshElements::kJoints, makeBuffer(mesh.data.joi, sizeof(glm::vec4)));
+			m.set(asset::MeshElements::kWeights, makeBuffer(mesh.data.wei, sizeof(glm::vec4)));
+			m.set(asset::MeshElements::kIndices, makeBuffer(mesh.data.idx, sizeof(uint32_t)));
 			m.setSubMeshes(eastl::move(sub_meshes));
 			m.setAttachedTextures(eastl::move(textures));
 			m.setAttachedTextureCount(glm::uvec4(
@@ -1058,8 +1416,18 @@ namespace lambda
 				mesh.data.tex_dmra.size(),
 				mesh.data.tex_emi.size()
 			));
+			if (!mesh.data.impostors.empty())
+			{
+				m.setImpostor(
+					asset::TextureManager::getInstance()->stream(mesh.data.impostor_albedo),
+					asset::TextureManager::getInstance()->stream(mesh.data.impostor_normal_depth),
+					mesh.data.impostor_frames
+				);
+			}
+			if (!mesh.data.joints.empty())
+				m.setAnimation(mesh.data.joints, mesh.data.clips);
 
-			return create(name, m);
+			return m;
 		}
 
 		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1097,7 +1465,27 @@ namespace lambda
 				mesh_cache_.erase(it);
 
 			foundation::Memory::destruct<Mesh>(mesh);
-			renderer_->destroyMesh(hash);
+			if (renderer_)
+				renderer_->destroyMesh(hash);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		void MeshManager::reload(uint64_t hash)
+		{
+			auto it = mesh_cache_.find(hash);
+			if (it == mesh_cache_.end() || !manager_.HasHeader(hash))
+				return;
+
+			// The renderer builds its buffers again the next time the mesh is drawn.
+			*it->second = convert(manager_.GetMesh(hash, true));
+			if (renderer_)
+				renderer_->destroyMesh(hash);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		bool MeshManager::isGeneratedFile(const String& file, uint64_t& hash) const
+		{
+			return manager_.ParseGeneratedFile(file, hash);
 		}
 
 		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -78,6 +78,45 @@ namespace lambda
 			size_t index_offset = 0;
 			size_t vertex_offset = 0;
 
+			// Levels of detail generated by the mesh compiler, from the most to the least detailed.
+			// They only have their own indices, the vertices are the ones of the sub mesh.
+			struct LOD
+			{
+				Offset indices;
+				float  error = 0.0f; // Largest distance to the full detail surface, in local units.
+			};
+			Vector<LOD> lods;
+
+			// Octahedral impostor baked by the mesh compiler, drawn after the last LOD.
+			struct Impostor
+			{
+				glm::vec4 rect;           // Part of the impostor atlases, offset and size in uv.
+				glm::vec3 center;         // Of the bounding sphere the views are fitted to, in local units.
+				float     radius = 0.0f;  // Zero when there is no impostor.
+				float     error  = 0.0f;  // Largest distance to the full detail surface, in local units.
+			} impostor;
+
+			// Small groups of triangles of the full detail indices, built by the
+			// mesh compiler so the parts of the sub mesh that can not be seen
+			// are skipped. Sorted by index offset, empty for small sub meshes.
+			struct Cluster
+			{
+				uint32_t  index_offset = 0u;  // Into the indices of the sub mesh.
+				uint32_t  index_count  = 0u;
+				glm::vec3 center;             // Of the bounding sphere, in local units.
+				float     radius       = 0.0f;
+				glm::vec3 cone_axis;          // Average facing of the triangles.
+				float     cone_cutoff  = 1.0f; // One when the cone can not cull.
+			};
+			Vector<Cluster> clusters;
+
+			// Streams that the vertex buffers keep packed, see kMeshQuantized*. The
+			// VIOLET_QUANTIZED variants of the vertex shaders decode them. Packed
+			// positions are relative to the position bounds.
+			uint32_t  quantized = 0u;
+			glm::vec3 position_min = glm::vec3(0.0f);
+			glm::vec3 position_max = glm::vec3(0.0f);
+
 			struct {
 				// Required information.
 				int       parent = 0;
@@ -108,56 +147,94 @@ namespace lambda
 			}
 		};
 
+		// Reads the elements of a mesh buffer in place, they do not have to be
+		// tightly packed. Does not own the data, so it is only valid for as
+		// long as the buffer it was taken from is not replaced.
+		template<typename T>
+		class MeshView
+		{
+		public:
+			class Iterator
+			{
+			public:
+				Iterator(const unsigned char* data, size_t stride) : data_(data), stride_(stride) {};
+				const T& operator*() const { return *(const T*)data_; }
+				const T* operator->() const { return (const T*)data_; }
+				Iterator& operator++() { data_ += stride_; return *this; }
+				bool operator==(const Iterator& other) const { return data_ == other.data_; }
+				bool operator!=(const Iterator& other) const { return data_ != other.data_; }
+
+			private:
+				const unsigned char* data_;
+				size_t stride_;
+			};
+
+			MeshView() {};
+			MeshView(const void* data, size_t count, size_t stride)
+				: data_((const unsigned char*)data)
+				, count_(count)
+				, stride_(stride)
+			{}
+
+			const T& operator[](size_t i) const { return *(const T*)(data_ + i * stride_); }
+			const T& at(size_t i) const
+			{
+				LMB_ASSERT(i < count_, "MESH VIEW: %llu is out of range", (unsigned long long)i);
+				return (*this)[i];
+			}
+			size_t size() const { return count_; }
+			size_t stride() const { return stride_; }
+			bool empty() const { return count_ == 0u; }
+			Iterator begin() const { return Iterator(data_, stride_); }
+			Iterator end() const { return Iterator(data_ + count_ * stride_, stride_); }
+
+			// Copies the elements, for code that has to change them.
+			Vector<T> toVector() const
+			{
+				Vector<T> vector(count_);
+				for (size_t i = 0u; i < count_; ++i)
+					vector[i] = (*this)[i];
+				return vector;
+			}
+
+		private:
+			const unsigned char* data_ = nullptr;
+			size_t count_  = 0u;
+			size_t stride_ = 0u;
+		};
+
 		class Mesh
 		{
 		public:
+			// A single vertex or index stream. Copies share the data and only
+			// getMutableData copies it, when other buffers still use it.
 			struct Buffer
 			{
 				Buffer() {};
-				Buffer(void* data, uint32_t count, uint16_t size)
-					: data(data)
-					, count(count)
-					, size(size)
-				{}
+				// Copies the data, the caller keeps ownership of it. Without data the buffer is zeroed.
+				Buffer(const void* data, uint32_t count, uint16_t size);
 				template<typename T>
 				Buffer(const Vector<T>& vector)
-				{
-					if (data)
-						foundation::Memory::deallocate(data);
+					: Buffer(vector.data(), (uint32_t)vector.size(), (uint16_t)sizeof(T))
+				{}
+				Buffer(const Buffer& other);
+				Buffer(Buffer&& other);
+				Buffer& operator=(const Buffer& other);
+				Buffer& operator=(Buffer&& other);
+				~Buffer();
 
-					count = (uint32_t)vector.size();
-					size = sizeof(T);
-					data = foundation::Memory::allocate(count * size);
-					memcpy(data, vector.data(), count * size);
-				}
-				Buffer(const Buffer& other)
-				{
-					if (data)
-						foundation::Memory::deallocate(data);
-					count = other.count;
-					size  = other.size;
-					data  = foundation::Memory::allocate(count * size);
-					memcpy(data, other.data, count * size);
-				}
-				void operator=(const Buffer& other)
-				{
-					if (data)
-						foundation::Memory::deallocate(data);
-					count = other.count;
-					size  = other.size;
-					data  = foundation::Memory::allocate(count * size);
-					memcpy(data, other.data, count * size);
-				}
-				~Buffer()
-				{
-					foundation::Memory::deallocate(data);
-					data  = nullptr;
-					count = 0u;
-					size  = 0u;
-				}
-				void*    data  = nullptr;
-				uint32_t count = 0u;
-				uint16_t size  = 0u;
+				void* getMutableData();
+				bool isShared() const;
+
+				const void* data  = nullptr;
+				uint32_t    count = 0u;
+				uint16_t    size  = 0u;
+
+			private:
+				struct Storage;
+				void release();
+
+				Storage* storage_ = nullptr;
 			};
 
 			Mesh();
@@ -173,11 +250,27 @@ namespace lambda
 			//Buffer get(const uint32_t& hash);
 			const Buffer& get(const uint32_t& hash) const;
 			template<typename T>
-			Vector<T> get(const uint32_t& hash);
+			MeshView<T> get(const uint32_t& hash) const;
+			// Only the elements of the sub mesh, with its stride.
 			template<typename T>
-			Vector<T> get(const uint32_t& hash, const uint64_t& sub_mesh);
+			MeshView<T> get(const uint32_t& hash, const uint64_t& sub_mesh) const;
+			// The positions of a sub mesh scaled and its indices as ints, the layout the
+			// physics engines keep. The mesh is read in place, so the two arrays are
+			// the only allocations. They are made with foundation::Memory and belong
+			// to the caller.
+			struct ColliderData
+			{
+				glm::vec3* vertices     = nullptr;
+				size_t     vertex_count = 0u;
+				int*       indices      = nullptr;
+				size_t     index_count  = 0u;
+			};
+			ColliderData makeColliderData(const uint64_t& sub_mesh, const glm::vec3& scale) const;
 			// Set
 			void set(const uint32_t& hash, const Buffer& buffer);
+			void set(const uint32_t& hash, Buffer&& buffer);
+			// Copies the buffer first when other meshes share it and marks it as changed.
+			void* getMutableData(const uint32_t& hash);
 			// Sub Meshes
 			void setSubMeshes(const Vector<SubMesh>& sub_meshes);
 			const Vector<SubMesh>& getSubMeshes() const;
@@ -185,6 +278,8 @@ namespace lambda
 			// Clearing / recalculating
 			void clear(bool has_changed = true);
 			void recalculateTangents();
+			// Turns the packed streams back into floats, for code that reads the vertices.
+			void dequantize();
 			// Changed
 			bool changed(const uint32_t& hash) const;
 			void markAsChanged(const uint32_t& hash);
@@ -197,6 +292,15 @@ namespace lambda
 			const Vector<VioletTextureHandle>& getAttachedTextures() const;
 			void setAttachedTextureCount(const glm::uvec4& texture_count);
 			const glm::uvec4& getAttachedTextureCount() const;
+			// Impostor atlases, shared by every sub mesh.
+			void setImpostor(VioletTextureHandle albedo, VioletTextureHandle normal_depth, uint32_t frames);
+			VioletTextureHandle getImpostorAlbedo() const;
+			VioletTextureHandle getImpostorNormalDepth() const;
+			uint32_t getImpostorFrames() const;
+			// Skeleton and clips of skinned meshes, see VioletMeshData.
+			void setAnimation(const Vector<VioletMeshJoint>& joints, const Vector<VioletAnimationClip>& clips);
+			const Vector<VioletMeshJoint>& getJoints() const;
+			const Vector<VioletAnimationClip>& getClips() const;
 			// Creators
 			static Mesh createPoint();
 			static Mesh createQuad(const glm::vec2& min = glm::vec2(-1.0f), const glm::vec2& max = glm::vec2(1.0f));
@@ -219,30 +323,37 @@ namespace lambda
 			Vector<VioletTextureHandle> textures_;
 			glm::uvec4 texture_count_;
 
+			VioletTextureHandle impostor_albedo_;
+			VioletTextureHandle impostor_normal_depth_;
+			uint32_t impostor_frames_ = 0u;
+
+			Vector<VioletMeshJoint> joints_;
+			Vector<VioletAnimationClip> clips_;
+
 			Vector<SubMesh> sub_meshes_;
 			Topology topology_ = Topology::kTriangles;
 		};
 
 		template<typename T>
-		inline Vector<T> Mesh::get(const uint32_t& hash)
+		inline MeshView<T> Mesh::get(const uint32_t& hash) const
 		{
-			Buffer buffer = get(hash);
-			Vector<T> vector(buffer.count);
-			memcpy(vector.data(), buffer.data, buffer.count * buffer.size);
-			return vector;
+			const Buffer& buffer = get(hash);
+			LMB_ASSERT(buffer.count == 0u || sizeof(T) <= buffer.size, "MESH: Elements of %lu are smaller than the view", hash);
+			return MeshView<T>(buffer.data, buffer.count, buffer.size);
 		}
 		template<typename T>
-		inline Vector<T> Mesh::get(const uint32_t& hash, const uint64_t& sub_mesh)
+		inline MeshView<T> Mesh::get(const uint32_t& hash, const uint64_t& sub_mesh) const
 		{
-			Buffer buffer  = get(hash);
-			SubMesh sm     = sub_meshes_.at(sub_mesh);
-			auto sm_offset = sm.offsets[hash];
-			size_t count   = sm_offset.count;
-			size_t offset  = sm_offset.offset;
-			size_t stride  = sm_offset.stride;
-			Vector<T> vector(count);
-			memcpy(vector.data(), (char*)buffer.data + offset, count * stride);
-			return vector;
+			const SubMesh& sm = sub_meshes_.at(sub_mesh);
+			const auto it = sm.offsets.find(hash);
+			if (it == sm.offsets.end() || it->second.count == 0u || !has(hash))
+				return MeshView<T>();
+
+			const Buffer& buffer = get(hash);
+			const SubMesh::Offset& offset = it->second;
+			LMB_ASSERT(sizeof(T) <= offset.stride, "MESH: Elements of %lu are smaller than the view", hash);
+			LMB_ASSERT(offset.offset + (offset.count - 1u) * offset.stride + sizeof(T) <= (size_t)buffer.count * buffer.size, "MESH: Sub mesh %llu is outside of the buffer", sub_mesh);
+			return MeshView<T>((const unsigned char*)buffer.data + offset.offset, offset.count, offset.stride);
 		}
 
 		using VioletMeshHandle = VioletHandle<Mesh>;
@@ -253,11 +364,14 @@ namespace lambda
 		public:
 			VioletMeshHandle create(Name name);
 			VioletMeshHandle create(Name name, Mesh mesh);
-			VioletMeshHandle create(Name name, VioletMesh mesh);
+			VioletMeshHandle create(Name name, const VioletMesh& mesh);
 			VioletMeshHandle get(Name name);
 			VioletMeshHandle get(uint64_t hash);
 			VioletMeshHandle getFromCache(Name name);
 			void destroy(Mesh* mesh, const size_t& hash);
+			// Loads the mesh again into the cached mesh, handles keep pointing at the same mesh.
+			void reload(uint64_t hash);
+			bool isGeneratedFile(const String& file, uint64_t& hash) const;
 
 		public:
 			static MeshManager* getInstance();
@@ -269,7 +383,10 @@ namespace lambda
 			const VioletMeshManager& getManager() const;
 
 		private:
-			platform::IRenderer* renderer_;
+			Mesh convert(const VioletMesh& mesh);
+
+		private:
+			platform::IRenderer* renderer_ = nullptr;
 			VioletMeshManager manager_;
 			UnorderedMap<uint64_t, Mesh*> mesh_cache_;
 		};
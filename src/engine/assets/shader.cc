@@ -148,6 +148,15 @@ namespace lambda
 			return get(hash);
 		}
 
+		///////////////////////////////////////////////////////////////////////////
+		bool ShaderManager::has(Name name)
+		{
+			String str = FileSystem::MakeRelative(name.getName());
+			if (str.find('|') == String::npos)
+				str += "|DEFAULT";
+			return manager_.HasHeader(manager_.GetHash(str));
+		}
+
 		///////////////////////////////////////////////////////////////////////////
 		VioletShaderHandle ShaderManager::get(uint64_t hash)
 		{
@@ -169,6 +178,23 @@ namespace lambda
 			renderer_->destroyShader(hash);
 		}
 
+		///////////////////////////////////////////////////////////////////////////
+		void ShaderManager::reload(uint64_t hash)
+		{
+			auto it = shader_cache_.find(hash);
+			if (it == shader_cache_.end() || !manager_.HasHeader(hash))
+				return;
+
+			it->second->shader_ = manager_.GetShader(hash);
+			renderer_->destroyShader(hash);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		bool ShaderManager::isGeneratedFile(const String& file, uint64_t& hash) const
+		{
+			return manager_.ParseGeneratedFile(file, hash);
+		}
+
 		///////////////////////////////////////////////////////////////////////////
 		Array<Array<Vector<char>, VIOLET_LANG_COUNT>, (int)ShaderStages::kCount>
 			ShaderManager::getData(VioletShaderHandle Shader)
@@ -50,7 +50,12 @@ namespace lambda
 			VioletShaderHandle create(Name name, VioletShader Shader);
 			VioletShaderHandle get(Name name);
 			VioletShaderHandle get(uint64_t hash);
+			// Whether the packager compiled the program, like get(Name) the name can include the permutation.
+			bool has(Name name);
 			void destroy(Shader* shader, const size_t& hash);
+			// Loads the shader again into the cached shader, the renderer compiles it again on next use.
+			void reload(uint64_t hash);
+			bool isGeneratedFile(const String& file, uint64_t& hash) const;
 			Array<Array<Vector<char>, VIOLET_LANG_COUNT>, (int)ShaderStages::kCount>
 			getData(VioletShaderHandle Shader);
 
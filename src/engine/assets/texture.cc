@@ -443,10 +443,140 @@ namespace lambda
 			return create(texture.file, texture);
 		}
 
+		///////////////////////////////////////////////////////////////////////////
+		VioletTextureHandle TextureManager::stream(Name name, StreamPriority priority)
+		{
+			uint64_t hash = manager_.GetHash(FileSystem::MakeRelative(name.getName()));
+			LMB_ASSERT(manager_.HasHeader(hash), "Could not find texture: %s", name.getName().c_str());
+			return stream(hash, priority);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		VioletTextureHandle TextureManager::stream(uint64_t hash, StreamPriority priority)
+		{
+			LMB_ASSERT(manager_.HasHeader(hash), "Could not find texture: %llu", hash);
+			VioletTexture header = manager_.GetTexture(hash);
+
+			auto it = texture_cache_.find(hash);
+			if (it != texture_cache_.end())
+				return VioletTextureHandle(it->second, header.file);
+
+			// 1x1 grey until the data is there. Not marked as DDS, otherwise the
+			// renderer would load the data itself.
+			VioletTexture placeholder = header;
+			placeholder.width     = 1u;
+			placeholder.height    = 1u;
+			placeholder.mip_count = 1u;
+			placeholder.format    = TextureFormat::kR8G8B8A8;
+			placeholder.flags    &= ~(kTextureFlagFromDDS | kTextureFlagContainsAlpha);
+			placeholder.data      = { (char)128, (char)128, (char)128, (char)255 };
+			VioletTextureHandle handle = create(header.file, placeholder);
+
+			// Only the mip tail to start with, residency takes it from there.
+			streamMips(hash, header, getTailMip(header), priority);
+
+			return handle;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t TextureManager::getTailMip(const VioletTexture& header)
+		{
+			uint32_t mip = 0u;
+			if (header.flags & kTextureFlagMipTailFirst)
+			{
+				while (mip + 1u < header.mip_count && eastl::max(header.width >> mip, header.height >> mip) > kMipTailSize)
+					mip++;
+			}
+			return mip;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void TextureManager::streamMips(uint64_t hash, const VioletTexture& header, uint32_t mip, StreamPriority priority)
+		{
+			const uint64_t size = VioletTextureManager::GetMipChainSize(header, mip);
+			const bool tail_first = (header.flags & kTextureFlagMipTailFirst) != 0u;
+
+			streaming_[hash] = AssetStreamer::getInstance()->request(
+				[this, hash, size, tail_first]() { return tail_first ? manager_.ReadData(hash, size) : manager_.ReadData(hash); },
+				[this, hash, header, mip, tail_first](const Vector<char>& data) {
+					Vector<char> decoded = manager_.DecodeData(hash, data);
+					if (!tail_first)
+						return decoded;
+					return VioletTextureManager::FromMipTailFirst(header, decoded, mip);
+				},
+				[this, hash, header, mip](Vector<char>& data) { land(hash, header, data, mip); },
+				priority
+			);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		bool TextureManager::isStreaming(VioletTextureHandle texture) const
+		{
+			return streaming_.find(texture.getHash()) != streaming_.end();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void TextureManager::requestMip(VioletTextureHandle texture, uint32_t mip)
+		{
+			residency_.request(texture.getHash(), mip);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void TextureManager::requestScreenSize(VioletTextureHandle texture, float pixels)
+		{
+			residency_.requestScreenSize(texture.getHash(), pixels);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t TextureManager::getResidentMip(VioletTextureHandle texture) const
+		{
+			return residency_.getResidentMip(texture.getHash());
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t TextureManager::getRequestedMip(VioletTextureHandle texture) const
+		{
+			return residency_.getRequestedMip(texture.getHash());
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void TextureManager::updateResidency()
+		{
+			for (const TextureResidency::Change& change : residency_.update())
+			{
+				if (texture_cache_.find(change.hash) == texture_cache_.end())
+					continue;
+
+				// Dropping mips reads the smaller chain again, it is cheap and
+				// saves keeping a copy of every resident texture around.
+				streamMips(change.hash, manager_.GetTexture(change.hash), change.mip, StreamPriority::kVisible);
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		TextureResidency& TextureManager::getResidency()
+		{
+			return residency_;
+		}
+
 		///////////////////////////////////////////////////////////////////////////
 		Vector<char> TextureManager::getData(VioletTextureHandle texture)
 		{
+			streamed_data_mutex_.lock();
+			auto it = streamed_data_.find(texture.getHash());
+			if (it != streamed_data_.end())
+			{
+				Vector<char> data = eastl::move(it->second);
+				streamed_data_.erase(it);
+				streamed_data_mutex_.unlock();
+				return eastl::move(data);
+			}
+			streamed_data_mutex_.unlock();
+
 			LMB_ASSERT(manager_.HasHeader(texture.getHash()), "Could not find texture: %s", texture.getName().getName().c_str());
+			VioletTexture header = manager_.GetTexture(texture.getHash());
+			if (header.flags & kTextureFlagMipTailFirst)
+				return VioletTextureManager::FromMipTailFirst(header, manager_.GetData(texture.getHash()), 0u);
 			return eastl::move(manager_.GetData(texture.getHash()));
 		}
 
@@ -460,10 +590,52 @@ namespace lambda
 			if (it != texture_cache_.end())
 				texture_cache_.erase(it);
 
+			auto streaming = streaming_.find(hash);
+			if (streaming != streaming_.end())
+			{
+				AssetStreamer::getInstance()->cancel(streaming->second);
+				streaming_.erase(streaming);
+			}
+
+			streamed_data_mutex_.lock();
+			streamed_data_.erase(hash);
+			streamed_data_mutex_.unlock();
+			residency_.remove(hash);
+
 			foundation::Memory::destruct<Texture>(texture);
 			renderer_->destroyTexture(hash);
 		}
 
+		///////////////////////////////////////////////////////////////////////////
+		void TextureManager::reload(uint64_t hash)
+		{
+			if (texture_cache_.find(hash) == texture_cache_.end() || !manager_.HasHeader(hash))
+				return;
+
+			auto streaming = streaming_.find(hash);
+			if (streaming != streaming_.end())
+			{
+				AssetStreamer::getInstance()->cancel(streaming->second);
+				streaming_.erase(streaming);
+			}
+
+			streamed_data_mutex_.lock();
+			streamed_data_.erase(hash);
+			streamed_data_mutex_.unlock();
+
+			// The size or the mip count could have changed, residency starts over from the tail.
+			// The old texture stays visible until the new data lands.
+			residency_.remove(hash);
+			const VioletTexture header = manager_.GetTexture(hash);
+			streamMips(hash, header, getTailMip(header), StreamPriority::kVisible);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		bool TextureManager::isGeneratedFile(const String& file, uint64_t& hash) const
+		{
+			return manager_.ParseGeneratedFile(file, hash);
+		}
+
 		///////////////////////////////////////////////////////////////////////////
 		TextureManager* TextureManager::getInstance()
 		{
@@ -486,6 +658,48 @@ namespace lambda
 				destroy(texture_cache_.begin()->second, texture_cache_.begin()->first);
 		}
 
+		///////////////////////////////////////////////////////////////////////////
+		void TextureManager::land(uint64_t hash, VioletTexture header, Vector<char>& data, uint32_t mip)
+		{
+			streaming_.erase(hash);
+
+			auto it = texture_cache_.find(hash);
+			if (it == texture_cache_.end())
+				return;
+
+			if (header.flags & kTextureFlagMipTailFirst)
+			{
+				if (residency_.contains(hash))
+					residency_.landed(hash, mip);
+				else
+				{
+					Vector<uint64_t> mip_sizes(header.mip_count);
+					for (uint32_t i = 0u; i < header.mip_count; ++i)
+						mip_sizes[i] = VioletTextureManager::GetMipSize(header, i);
+					residency_.add(hash, eastl::max(header.width, header.height), mip_sizes, mip);
+				}
+
+				// The data was put back in the usual order, starting at the landed mip.
+				header.width     = (uint16_t)eastl::max(1u, (uint32_t)header.width  >> mip);
+				header.height    = (uint16_t)eastl::max(1u, (uint32_t)header.height >> mip);
+				header.mip_count = (uint16_t)(header.mip_count - mip);
+				header.flags    &= ~kTextureFlagMipTailFirst;
+			}
+
+			header.flags |= kTextureFlagRecreate;
+			if (header.flags & kTextureFlagFromDDS)
+			{
+				streamed_data_mutex_.lock();
+				streamed_data_[hash] = eastl::move(data);
+				streamed_data_mutex_.unlock();
+			}
+			else
+				header.data = eastl::move(data);
+
+			it->second->getLayer(0u) = TextureLayer(header);
+			it->second->makeDirty();
+		}
+
 		///////////////////////////////////////////////////////////////////////////
 		VioletTextureManager& TextureManager::getManager()
 		{
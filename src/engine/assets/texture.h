@@ -1,5 +1,7 @@
 #pragma once
 #include "assets/asset_handle.h"
+#include "assets/asset_streamer.h"
+#include "assets/texture_residency.h"
 #include "utils/bitset.h"
 #include <glm/glm.hpp>
 #include <containers/containers.h>
@@ -79,6 +81,9 @@ namespace lambda
 		class TextureManager
 		{
 		public:
+			// Mips this size and smaller are the mip tail, which is always resident.
+			static constexpr uint32_t kMipTailSize = 64u;
+
 			VioletTextureHandle create(Name name);
 			VioletTextureHandle create(Name name, Texture texture);
 			VioletTextureHandle create(Name name, VioletTexture texture);
@@ -103,8 +108,27 @@ namespace lambda
 			VioletTextureHandle getFromCache(Name name);
 			VioletTextureHandle get(Name name);
 			VioletTextureHandle get(uint64_t hash);
+			// Returns a placeholder right away and streams the data in. The layer
+			// gets swapped for the real texture once the data has landed.
+			VioletTextureHandle stream(Name name, StreamPriority priority = StreamPriority::kVisible);
+			VioletTextureHandle stream(uint64_t hash, StreamPriority priority = StreamPriority::kVisible);
+			bool isStreaming(VioletTextureHandle texture) const;
+
+			// Textures with a mip tail only load the tail when streamed, the rest
+			// of the mips come in when asked for and go when the budget runs out.
+			void requestMip(VioletTextureHandle texture, uint32_t mip);
+			void requestScreenSize(VioletTextureHandle texture, float pixels);
+			// Returns TextureResidency::kNoRequest for textures that are not mip streamed.
+			uint32_t getResidentMip(VioletTextureHandle texture) const;
+			uint32_t getRequestedMip(VioletTextureHandle texture) const;
+			// Needs to be called from the main thread once per frame, after the streamer update.
+			void updateResidency();
+			TextureResidency& getResidency();
 			Vector<char> getData(VioletTextureHandle texture);
 			void destroy(Texture* texture, const size_t& hash);
+			// Streams the texture in again, handles keep pointing at the same texture.
+			void reload(uint64_t hash);
+			bool isGeneratedFile(const String& file, uint64_t& hash) const;
 
 		public:
 			static TextureManager* getInstance();
@@ -115,10 +139,20 @@ namespace lambda
 			VioletTextureManager& getManager();
 			const VioletTextureManager& getManager() const;
 
+		private:
+			void streamMips(uint64_t hash, const VioletTexture& header, uint32_t mip, StreamPriority priority);
+			static uint32_t getTailMip(const VioletTexture& header);
+			void land(uint64_t hash, VioletTexture header, Vector<char>& data, uint32_t mip);
+
 		private:
 			VioletTextureManager manager_;
 			platform::IRenderer* renderer_;
 			UnorderedMap<uint64_t, Texture*> texture_cache_;
+			UnorderedMap<uint64_t, uint64_t> streaming_;
+			// Landed DDS data, handed to the renderer when it creates the texture.
+			UnorderedMap<uint64_t, Vector<char>> streamed_data_;
+			std::mutex streamed_data_mutex_;
+			TextureResidency residency_;
 		};
 	}
 }
@@ -0,0 +1,268 @@
+#include "texture_residency.h"
+#include <utils/console.h>
+#include <algorithm>
+#include <cmath>
+
+namespace lambda
+{
+	namespace asset
+	{
+		///////////////////////////////////////////////////////////////////////////
+		void TextureResidency::add(uint64_t hash, uint32_t size, const Vector<uint64_t>& mip_sizes, uint32_t tail_mip)
+		{
+			LMB_ASSERT(tail_mip < mip_sizes.size(), "TEXTURE RESIDENCY: Tail mip %u is out of range", tail_mip);
+			remove(hash);
+
+			Entry entry;
+			entry.chain_sizes.resize(mip_sizes.size() + 1u, 0u);
+			for (uint32_t mip = (uint32_t)mip_sizes.size(); mip > 0u; --mip)
+				entry.chain_sizes[mip - 1u] = entry.chain_sizes[mip] + mip_sizes[mip - 1u];
+
+			entry.size            = size;
+			entry.tail_mip        = tail_mip;
+			entry.resident_mip    = tail_mip;
+			entry.target_mip      = tail_mip;
+			entry.requested_mip   = tail_mip;
+			entry.requested_frame = frame_;
+			entry.last_used       = frame_;
+
+			committed_size_ += entry.chain_sizes[tail_mip];
+			entries_.insert(eastl::make_pair(hash, entry));
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void TextureResidency::remove(uint64_t hash)
+		{
+			auto it = entries_.find(hash);
+			if (it == entries_.end())
+				return;
+
+			committed_size_ -= it->second.chain_sizes[std::min(it->second.resident_mip, it->second.target_mip)];
+			entries_.erase(it);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		bool TextureResidency::contains(uint64_t hash) const
+		{
+			return entries_.find(hash) != entries_.end();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void TextureResidency::request(uint64_t hash, uint32_t mip)
+		{
+			auto it = entries_.find(hash);
+			if (it == entries_.end())
+				return;
+
+			Entry& entry = it->second;
+			entry.frame_mip = std::min(entry.frame_mip, std::min(mip, entry.tail_mip));
+			entry.last_used = frame_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void TextureResidency::requestScreenSize(uint64_t hash, float pixels)
+		{
+			auto it = entries_.find(hash);
+			if (it == entries_.end())
+				return;
+
+			const float texels_per_pixel = (float)it->second.size / std::max(pixels, 1.0f);
+			request(hash, (uint32_t)std::max(0.0f, std::floor(std::log2(texels_per_pixel))));
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		Vector<TextureResidency::Change> TextureResidency::update()
+		{
+			Vector<Change> changes;
+			Vector<eastl::pair<uint64_t, Entry*>> loads;
+			// Memory that evictions which did not land yet give back.
+			uint64_t freeing = 0u;
+
+			for (auto& it : entries_)
+			{
+				Entry& entry = it.second;
+				updateRequest(entry);
+				if (entry.target_mip > entry.resident_mip)
+					freeing += entry.chain_sizes[entry.resident_mip] - entry.chain_sizes[entry.target_mip];
+
+				// One change at a time per texture.
+				if (entry.target_mip == entry.resident_mip && entry.requested_mip < entry.resident_mip)
+					loads.push_back(eastl::make_pair(it.first, &entry));
+			}
+
+			// Whatever was looked at most recently first, then the biggest jump in detail.
+			eastl::sort(loads.begin(), loads.end(), [](const eastl::pair<uint64_t, Entry*>& lhs, const eastl::pair<uint64_t, Entry*>& rhs) {
+				if (lhs.second->last_used != rhs.second->last_used)
+					return lhs.second->last_used > rhs.second->last_used;
+				const uint32_t lhs_gain = lhs.second->resident_mip - lhs.second->requested_mip;
+				const uint32_t rhs_gain = rhs.second->resident_mip - rhs.second->requested_mip;
+				if (lhs_gain != rhs_gain)
+					return lhs_gain > rhs_gain;
+				return lhs.first < rhs.first;
+			});
+
+			for (const auto& load : loads)
+			{
+				if (changes.size() >= settings_.max_changes_per_update)
+					break;
+
+				Entry& entry = *load.second;
+				uint32_t mip = entry.requested_mip;
+				while (mip < entry.resident_mip)
+				{
+					const uint64_t size = committed_size_ + entry.chain_sizes[mip] - entry.chain_sizes[entry.resident_mip];
+					if (size <= settings_.budget)
+						break;
+
+					// The memory is only free once the evictions land, so the load
+					// waits for them. Later loads can not count on the same memory.
+					if (size <= settings_.budget + freeing)
+					{
+						freeing -= size - settings_.budget;
+						mip = entry.resident_mip;
+						break;
+					}
+
+					// Drop mips nobody asked for, least recently used first.
+					uint64_t victim_hash = 0u;
+					Entry* victim = changes.size() + 1u < settings_.max_changes_per_update ? findVictim(load.first, victim_hash) : nullptr;
+					if (victim != nullptr)
+					{
+						freeing += victim->chain_sizes[victim->resident_mip] - victim->chain_sizes[victim->requested_mip];
+						setTarget(victim_hash, *victim, victim->requested_mip, changes);
+					}
+					else
+						mip++; // Settle for less detail.
+				}
+
+				if (mip < entry.resident_mip)
+					setTarget(load.first, entry, mip, changes);
+			}
+
+			// The budget can shrink, get back under it when it did.
+			while (committed_size_ > settings_.budget + freeing && changes.size() < settings_.max_changes_per_update)
+			{
+				uint64_t victim_hash = 0u;
+				Entry* victim = findVictim(0u, victim_hash);
+				if (victim == nullptr)
+					break;
+				freeing += victim->chain_sizes[victim->resident_mip] - victim->chain_sizes[victim->requested_mip];
+				setTarget(victim_hash, *victim, victim->requested_mip, changes);
+			}
+
+			frame_++;
+			return changes;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void TextureResidency::landed(uint64_t hash, uint32_t mip)
+		{
+			auto it = entries_.find(hash);
+			if (it == entries_.end())
+				return;
+
+			Entry& entry = it->second;
+			// Loads reserved their memory up front, evictions free it when they land.
+			if (mip > entry.resident_mip)
+				committed_size_ -= entry.chain_sizes[entry.resident_mip] - entry.chain_sizes[mip];
+			entry.resident_mip = mip;
+			entry.target_mip   = mip;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t TextureResidency::getResidentMip(uint64_t hash) const
+		{
+			auto it = entries_.find(hash);
+			return it != entries_.end() ? it->second.resident_mip : kNoRequest;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t TextureResidency::getRequestedMip(uint64_t hash) const
+		{
+			auto it = entries_.find(hash);
+			return it != entries_.end() ? it->second.requested_mip : kNoRequest;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint64_t TextureResidency::getResidentSize() const
+		{
+			uint64_t size = 0u;
+			for (const auto& it : entries_)
+				size += it.second.chain_sizes[it.second.resident_mip];
+			return size;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint64_t TextureResidency::getCommittedSize() const
+		{
+			return committed_size_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint64_t TextureResidency::getFrame() const
+		{
+			return frame_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void TextureResidency::setSettings(const Settings& settings)
+		{
+			settings_ = settings;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const TextureResidency::Settings& TextureResidency::getSettings() const
+		{
+			return settings_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void TextureResidency::updateRequest(Entry& entry)
+		{
+			const uint32_t mip = entry.frame_mip == kNoRequest ? entry.tail_mip : entry.frame_mip;
+			entry.frame_mip = kNoRequest;
+
+			// More detail is granted right away, less detail only once the hold ran out.
+			if (mip <= entry.requested_mip)
+			{
+				entry.requested_mip   = mip;
+				entry.requested_frame = frame_;
+			}
+			else if (frame_ - entry.requested_frame > settings_.hold_frames)
+			{
+				entry.requested_mip   = mip;
+				entry.requested_frame = frame_;
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void TextureResidency::setTarget(uint64_t hash, Entry& entry, uint32_t mip, Vector<Change>& changes)
+		{
+			if (mip < entry.resident_mip)
+				committed_size_ += entry.chain_sizes[mip] - entry.chain_sizes[entry.resident_mip];
+
+			entry.target_mip = mip;
+			changes.push_back({ hash, mip });
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		TextureResidency::Entry* TextureResidency::findVictim(uint64_t except, uint64_t& hash)
+		{
+			// Only textures holding more than they were asked for, and that are not changing already.
+			Entry* victim = nullptr;
+			for (auto& it : entries_)
+			{
+				Entry& entry = it.second;
+				if (it.first == except || entry.target_mip != entry.resident_mip || entry.resident_mip >= entry.requested_mip)
+					continue;
+
+				if (victim == nullptr || entry.last_used < victim->last_used)
+				{
+					victim = &entry;
+					hash   = it.first;
+				}
+			}
+			return victim;
+		}
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <containers/containers.h>
+
+namespace lambda
+{
+	namespace asset
+	{
+		///////////////////////////////////////////////////////////////////////////
+		// Decides which mips of the streamed textures are resident. Mips are
+		// counted from the full resolution, so a lower mip is more detail. Every
+		// texture keeps its mip tail, everything above it has to fit in the
+		// budget. Textures only exist as hashes with mip sizes in here, so the
+		// policy can be run without a renderer or any data.
+		class TextureResidency
+		{
+		public:
+			struct Settings
+			{
+				uint64_t budget = 256ull * 1024ull * 1024ull; // Bytes.
+				// A texture keeps a more detailed mip for this many frames after it
+				// was last asked for, so it does not go back and forth.
+				uint32_t hold_frames = 30u;
+				uint32_t max_changes_per_update = 8u;
+			};
+
+			struct Change
+			{
+				uint64_t hash;
+				uint32_t mip; // Most detailed mip that should be resident.
+			};
+
+			static constexpr uint32_t kNoRequest = UINT32_MAX;
+
+			// mip_sizes holds the size of every mip on its own. The tail starts out resident.
+			void add(uint64_t hash, uint32_t size, const Vector<uint64_t>& mip_sizes, uint32_t tail_mip);
+			void remove(uint64_t hash);
+			bool contains(uint64_t hash) const;
+
+			// The most detailed request within a frame wins.
+			void request(uint64_t hash, uint32_t mip);
+			// Asks for the mip that has about one texel per pixel for a texture
+			// covering pixels pixels on screen.
+			void requestScreenSize(uint64_t hash, float pixels);
+
+			// Call once per frame. The changes have to be applied by the caller,
+			// which calls landed() once the mip is resident.
+			Vector<Change> update();
+			void landed(uint64_t hash, uint32_t mip);
+
+			uint32_t getResidentMip(uint64_t hash) const;
+			uint32_t getRequestedMip(uint64_t hash) const;
+			uint64_t getResidentSize() const;
+			// Resident size plus what changes that did not land yet will add.
+			uint64_t getCommittedSize() const;
+			uint64_t getFrame() const;
+
+			void setSettings(const Settings& settings);
+			const Settings& getSettings() const;
+
+		private:
+			struct Entry
+			{
+				Vector<uint64_t> chain_sizes; // Size of the mip and all smaller ones.
+				uint32_t size           = 0u;
+				uint32_t tail_mip       = 0u;
+				uint32_t resident_mip   = 0u;
+				uint32_t target_mip     = 0u; // Differs from resident_mip while a change is in flight.
+				uint32_t requested_mip  = 0u;
+				uint32_t frame_mip      = kNoRequest;
+				uint64_t requested_frame = 0u;
+				uint64_t last_used      = 0u;
+			};
+
+			void updateRequest(Entry& entry);
+			void setTarget(uint64_t hash, Entry& entry, uint32_t mip, Vector<Change>& changes);
+			Entry* findVictim(uint64_t except, uint64_t& hash);
+
+		private:
+			UnorderedMap<uint64_t, Entry> entries_;
+			uint64_t committed_size_ = 0u;
+			uint64_t frame_ = 0u;
+			Settings settings_;
+		};
+	}
+}
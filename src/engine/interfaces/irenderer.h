@@ -13,6 +13,7 @@
 #define cbPerLightIdx 4
 #define cbDynamicResolutionIdx 5
 #define cbGuiIdx 6
+#define cbQuantizationIdx 7
 
 namespace lambda
 {
@@ -82,6 +83,9 @@ namespace lambda
 			virtual void startFrame() = 0;
 			virtual void endFrame(bool display = true) = 0;
 			virtual void draw(uint32_t instance_count = 1ul) = 0;
+			// Only draws index_count indices of the bound sub mesh and level,
+			// starting at first_index. Used to skip the culled clusters.
+			virtual void drawRange(uint32_t first_index, uint32_t index_count, uint32_t instance_count = 1ul) = 0;
 
 			virtual void setRasterizerState(
 				const RasterizerState& rasterizer_state
@@ -113,7 +117,8 @@ namespace lambda
 			virtual void setViewports(const Vector<glm::vec4>& rects) = 0;
 
 			virtual void setMesh(asset::VioletMeshHandle mesh) = 0;
-			virtual void setSubMesh(const uint32_t& sub_mesh_idx) = 0;
+			// lod 0 draws the sub mesh itself, lod n draws SubMesh::lods[n - 1].
+			virtual void setSubMesh(const uint32_t& sub_mesh_idx, const uint32_t& lod = 0u) = 0;
 			virtual void setShader(asset::VioletShaderHandle shader) = 0;
 			virtual void setTexture(
 				asset::VioletTextureHandle texture,
@@ -139,8 +144,15 @@ namespace lambda
 
 			virtual void setRenderScale(const float& render_scale) = 0;
 			virtual float getRenderScale() = 0;
+			// Part of the dynamically scaled targets that gets rendered to, it is upscaled when copied to the screen.
+			virtual void setDynamicResolutionScale(const float& scale) = 0;
+			virtual float getDynamicResolutionScale() = 0;
 			virtual void setVSync(bool vsync) = 0;
 			virtual bool getVSync() const = 0;
+			// Called by the level loader when a level starts and when it ends, with
+			// the shaders of the level. Lets the renderer prepare per level state.
+			virtual void beginLevel(const String& level, const Vector<asset::VioletShaderHandle>& shaders) = 0;
+			virtual void endLevel(const String& level) = 0;
 
 			virtual void destroyTexture(const size_t& hash) = 0;
 			virtual void destroyShader(const size_t& hash) = 0;
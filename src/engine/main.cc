@@ -45,6 +45,11 @@
 #include "assets/mesh.h"
 #include "assets/shader.h"
 #include "assets/wave.h"
+#include "assets/asset_streamer.h"
+#include "assets/asset_reloader.h"
+#include "assets/level_loader.h"
+#include <assets/base_asset_manager.h>
+#include <package/pack_archive.h>
 
 #include "systems/entity_system.h"
 #include "systems/transform_system.h"
@@ -282,37 +287,6 @@ public:
 	  }
 
 	  getGUI().executeJavaScript("if (gameState == Game) { setAllTimers([" + execute_string + "] ) }");
-	  
-	  float dynamic_resolution_scale = 1.0f;
-
-	  static const float drs[] = {
-		  0.2f,
-		  0.4f,
-		  0.6f,
-		  0.8f,
-		  1.0f
-	  };
-
-	  bool scale_up   = false;
-	  bool scale_down = false;
-
-	  if (frame_counter.getFrames() < 60)
-	  {
-		  if (dynamic_resolution_scale < drs[(int)(((float)frame_counter.getFrames()) / 60.0f * 5.0f)])
-			  scale_up = true;
-		  else
-			  scale_down = true;
-	  }
-	  else if (dynamic_resolution_scale < 1.0f)
-		  scale_up = true;
-
-	  if (scale_down)
-		  dynamic_resolution_scale = max(dynamic_resolution_scale - 0.01f, drs[(int)(((float)frame_counter.getFrames()) / 60.0f * 5.0f)]);
-	  if (scale_up)
-		  dynamic_resolution_scale = min(dynamic_resolution_scale + 0.01f, 1.0f);
-
-		// TODO (Hilze): Get rid of this ASAP!
-		dynamic_resolution_scale = 1.0f;
   }
 
   virtual void fixedUpdate() override
@@ -340,6 +314,21 @@ int main(int argc, char** argv)
 	LMB_ASSERT(argc != 1, "No project folder was speficied!");
 
 	lambda::FileSystem::SetBaseDir(argv[1]);
+
+	// Assets that are not in the archive are loaded from the loose generated files.
+	VioletPackArchive archive;
+	if (archive.Open("generated/assets.pack"))
+		VioletBaseAssetManager::MountArchive(&archive);
+	else
+		asset::AssetReloader::getInstance()->start(); // Picks up what the builder compiles while running.
+	asset::LevelLoader::getInstance()->initialize();
+
+	// Lets large assets decompress their blocks on the worker threads. Every
+	// worker runs its own priority and the ones above it, so the kLow and the
+	// kMedium worker pick these jobs up.
+	VioletBaseAssetManager::SetJobQueue([](Function<void(void)> job) {
+		platform::TaskScheduler::queue([job](void*) { job(); }, nullptr, platform::TaskScheduler::kMedium);
+	}, platform::TaskScheduler::kMedium + 1u);
 	
 	{
 #if defined VIOLET_RENDERER_D3D11
@@ -382,17 +371,25 @@ int main(int argc, char** argv)
 
 				//scripting::ScriptBinding(&world);
 				scripting->initialize({});
+				// Everything the main script references is in memory before it runs.
+				asset::LevelLoader::getInstance()->setRenderer(renderer);
+				asset::LevelLoader::getInstance()->load(script);
 				scripting->loadScripts({ script });
 
 				world.run();
+				asset::LevelLoader::getInstance()->unload();
+				asset::LevelLoader::getInstance()->setRenderer(nullptr);
 			}
 
 			//scripting::ScriptRelease();
 
+			foundation::Memory::destruct(asset::AssetReloader::getInstance());
+			foundation::Memory::destruct(asset::LevelLoader::getInstance());
 			foundation::Memory::destruct(asset::ShaderManager::getInstance());
 			foundation::Memory::destruct(asset::TextureManager::getInstance());
 			foundation::Memory::destruct(asset::WaveManager::getInstance());
 			foundation::Memory::destruct(asset::MeshManager::getInstance());
+			foundation::Memory::destruct(asset::AssetStreamer::getInstance());
 			foundation::Memory::destruct(foundation::GetFrameHeap());
 
 			window->close();
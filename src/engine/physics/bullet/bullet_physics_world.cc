@@ -410,46 +410,23 @@ namespace lambda
 		{
 			// Get the indices.
 			glm::vec3 scale = components::TransformSystem::getWorldScale(entity_, *scene_);
-			asset::SubMesh sub_mesh = mesh->getSubMeshes().at(sub_mesh_id);
-			auto index_offset = sub_mesh.offsets[asset::MeshElements::kIndices];
-			auto vertex_offset = sub_mesh.offsets[asset::MeshElements::kPositions];
+			const asset::SubMesh& sub_mesh = mesh->getSubMeshes().at(sub_mesh_id);
+			// Read straight out of the mesh, only the scaled vertices and the converted indices are copied.
+			const asset::Mesh::ColliderData data = mesh->makeColliderData(sub_mesh_id, scale);
+			const size_t index_count = data.index_count;
 
 			if (indices_)
 				foundation::Memory::deallocate(indices_);
-			indices_ = (int*)foundation::Memory::allocate(index_offset.count * sizeof(int));
+			indices_ = data.indices;
 
 			if (vertices_)
 				foundation::Memory::deallocate(vertices_);
-			vertices_ = (glm::vec3*)foundation::Memory::allocate(vertex_offset.count * sizeof(glm::vec3));
-
-			auto mii = mesh->get(asset::MeshElements::kIndices);
-			auto mpi = mesh->get(asset::MeshElements::kPositions);
-
-			memcpy(vertices_, (char*)mpi.data + vertex_offset.offset, vertex_offset.count * mpi.size);
-			for (uint32_t i = 0; i < vertex_offset.count; ++i)
-				vertices_[i] *= scale;
-
-			if (sizeof(uint16_t) == mii.size)
-			{
-				Vector<uint16_t> idx(index_offset.count);
-				memcpy(idx.data(), (char*)mii.data + index_offset.offset, index_offset.count * mii.size);
-
-				for (size_t i = 0u; i < index_offset.count; ++i)
-					indices_[i] = (int)idx.at(i);
-			}
-			else
-			{
-				Vector<uint32_t> idx(index_offset.count);
-				memcpy(idx.data(), (char*)mii.data + index_offset.offset, index_offset.count * mii.size);
-
-				for (size_t i = 0u; i < index_offset.count; ++i)
-					indices_[i] = (int)idx.at(i);
-			}
+			vertices_ = data.vertices;
 
 			bool is_aabb = true;
 			glm::vec3 min = sub_mesh.min * scale;
 			glm::vec3 max = sub_mesh.max * scale;
-			for (uint32_t i = 0; i < index_offset.count; ++i)
+			for (uint32_t i = 0; i < index_count; ++i)
 			{
 				const glm::vec3& vertex = vertices_[indices_[i]];
 				if (!allCornersClose(vertex, min, max))
@@ -466,12 +443,12 @@ namespace lambda
 				return;
 			}
 
-			for (uint32_t i = 0; i < vertex_offset.count; ++i)
+			for (uint32_t i = 0; i < data.vertex_count; ++i)
 				vertices_[i] *= VIOLET_PHYSICS_SCALE;
 
 			auto* triangle_mesh = foundation::Memory::construct<btTriangleMesh>(false, false);
 
-			for (uint32_t i = 0; i < index_offset.count; i += 3)
+			for (uint32_t i = 0; i < index_count; i += 3)
 			{
 				auto v1 = vertices_[indices_[i + 0]];
 				auto v2 = vertices_[indices_[i + 1]];
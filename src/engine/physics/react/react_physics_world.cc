@@ -369,41 +369,18 @@ namespace lambda
 
 			// Get the indices.
 			glm::vec3 scale = components::TransformSystem::getWorldScale(entity_, *scene_);
-			asset::SubMesh sub_mesh = mesh->getSubMeshes().at(sub_mesh_id);
-			auto index_offset = sub_mesh.offsets[asset::MeshElements::kIndices];
-			auto vertex_offset = sub_mesh.offsets[asset::MeshElements::kPositions];
-			indices_ = (int*)foundation::Memory::allocate(index_offset.count * sizeof(int));
-			vertices_ = (glm::vec3*)foundation::Memory::allocate(vertex_offset.count * sizeof(glm::vec3));
-
-			auto mii = mesh->get(asset::MeshElements::kIndices);
-			auto mpi = mesh->get(asset::MeshElements::kPositions);
-
-			memcpy(vertices_, (char*)mpi.data + vertex_offset.offset, vertex_offset.count * mpi.size);
-			for (uint32_t i = 0; i < vertex_offset.count; ++i)
-				vertices_[i] *= scale;
-
-			if (sizeof(uint16_t) == mii.size)
-			{
-				Vector<uint16_t> idx(index_offset.count);
-				memcpy(idx.data(), (char*)mii.data + index_offset.offset, index_offset.count * mii.size);
-
-				for (size_t i = 0u; i < index_offset.count; ++i)
-					indices_[i] = (int)idx.at(i);
-			}
-			else
-			{
-				Vector<uint32_t> idx(index_offset.count);
-				memcpy(idx.data(), (char*)mii.data + index_offset.offset, index_offset.count * mii.size);
-
-				for (size_t i = 0u; i < index_offset.count; ++i)
-					indices_[i] = (int)idx.at(i);
-			}
+			const asset::SubMesh& sub_mesh = mesh->getSubMeshes().at(sub_mesh_id);
+			// Read straight out of the mesh, only the scaled vertices and the converted indices are copied.
+			const asset::Mesh::ColliderData data = mesh->makeColliderData(sub_mesh_id, scale);
+			const size_t index_count = data.index_count;
+			indices_ = data.indices;
+			vertices_ = data.vertices;
 
 			glm::vec3 min = sub_mesh.min * scale;
 			glm::vec3 max = sub_mesh.max * scale;
 
 			bool is_aabb = true;
-			for (uint32_t i = 0; i < index_offset.count; ++i)
+			for (uint32_t i = 0; i < index_count; ++i)
 			{
 				const glm::vec3& vertex = vertices_[indices_[i]];
 				if (!allCornersClose(vertex, min, max))
@@ -419,14 +396,14 @@ namespace lambda
 				return;
 			}
 
-			for (uint32_t i = 0; i < vertex_offset.count; ++i)
+			for (uint32_t i = 0; i < data.vertex_count; ++i)
 				vertices_[i] *= VIOLET_PHYSICS_SCALE;
 
 			reactphysics3d::TriangleVertexArray* triangle_array = foundation::Memory::construct<reactphysics3d::TriangleVertexArray>(
-				reactphysics3d::uint(vertex_offset.count),
+				reactphysics3d::uint(data.vertex_count),
 				(float*)vertices_,
 				reactphysics3d::uint(3 * sizeof(float)),
-				reactphysics3d::uint(index_offset.count / 3),
+				reactphysics3d::uint(index_count / 3),
 				indices_,
 				reactphysics3d::uint(3 * sizeof(int)),
 				reactphysics3d::TriangleVertexArray::VertexDataType::VERTEX_FLOAT_TYPE,
@@ -0,0 +1,147 @@
+#include "cluster_culling.h"
+#include "frustum.h"
+#include "utils/mt_manager.h"
+#include <algorithm>
+#include <cmath>
+
+namespace lambda
+{
+	namespace utilities
+	{
+		namespace ClusterCulling
+		{
+			namespace
+			{
+				constexpr uint32_t kJobCount   = 4u;
+				constexpr uint32_t kMinJobSize = 64u; // Renderables.
+
+				struct Job
+				{
+					Vector<Range> ranges;
+					Stats         stats;
+					uint32_t      begin = 0u;
+					uint32_t      end   = 0u;
+				};
+
+				void add(Stats& stats, const Stats& other)
+				{
+					stats.renderables       += other.renderables;
+					stats.removed           += other.removed;
+					stats.clusters          += other.clusters;
+					stats.frustum_culled    += other.frustum_culled;
+					stats.cone_culled       += other.cone_culled;
+					stats.ranges            += other.ranges;
+					stats.triangles         += other.triangles;
+					stats.visible_triangles += other.visible_triangles;
+				}
+
+				// See forEachLOD in scene.cc.
+				bool drawsOnlyFullDetail(const Renderable& renderable)
+				{
+					return (renderable.lod == 0u && (renderable.fade_lod == 0u || renderable.lod_fade >= 1.0f)) ||
+						(renderable.fade_lod == 0u && renderable.lod_fade <= 0.0f);
+				}
+			}
+
+			///////////////////////////////////////////////////////////////////////////
+			bool isBackFacing(const asset::SubMesh::Cluster& cluster, const glm::vec3& position)
+			{
+				if (cluster.cone_cutoff >= 1.0f)
+					return false;
+
+				const glm::vec3 to_center = cluster.center - position;
+				return glm::dot(to_center, cluster.cone_axis) >= cluster.cone_cutoff * glm::length(to_center) + cluster.radius;
+			}
+
+			///////////////////////////////////////////////////////////////////////////
+			Stats cull(const View& view, const Vector<Vector<Renderable>*>& lists, Vector<Range>& ranges)
+			{
+				Stats stats;
+				Vector<Renderable*> renderables;
+				for (Vector<Renderable>* list : lists)
+				{
+					for (Renderable& renderable : *list)
+					{
+						renderable.clustered = false;
+						if (renderable.mesh && (renderable.lod == 0u || renderable.fade_lod == 0u) && !renderable.mesh->getSubMeshes().at(renderable.sub_mesh).clusters.empty())
+							renderables.push_back(&renderable);
+					}
+				}
+
+				if (renderables.empty())
+					return stats;
+
+				Job jobs[kJobCount];
+				platform::TaskScheduler::parallelFor((uint32_t)renderables.size(), kJobCount, kMinJobSize, [&](uint32_t job_index, uint32_t begin, uint32_t end) {
+					Job& job = jobs[job_index];
+					job.begin = begin;
+					job.end   = end;
+
+					for (uint32_t i = begin; i < end; ++i)
+					{
+						Renderable& renderable = *renderables[i];
+						const asset::SubMesh& sub_mesh = renderable.mesh->getSubMeshes().at(renderable.sub_mesh);
+						const glm::mat4x4& model = renderable.model_matrix;
+						const glm::vec3 position = glm::vec3(glm::inverse(model) * glm::vec4(view.position, 1.0f));
+						const float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+						// Mirroring flips the winding, then the rasterizer culls the other side.
+						const bool cones = view.cones && glm::determinant(glm::mat3(model)) > 0.0f && !isTwoSided(renderable);
+
+						renderable.clustered   = true;
+						renderable.first_range = (uint32_t)job.ranges.size();
+						renderable.range_count = 0u;
+						job.stats.renderables++;
+
+						for (const asset::SubMesh::Cluster& cluster : sub_mesh.clusters)
+						{
+							job.stats.clusters++;
+							job.stats.triangles += cluster.index_count / 3u;
+
+							if (!view.frustum->ContainsSphere(glm::vec3(model * glm::vec4(cluster.center, 1.0f)), cluster.radius * scale))
+							{
+								job.stats.frustum_culled++;
+								continue;
+							}
+							if (cones && isBackFacing(cluster, position))
+							{
+								job.stats.cone_culled++;
+								continue;
+							}
+
+							job.stats.visible_triangles += cluster.index_count / 3u;
+							if (renderable.range_count > 0u && job.ranges.back().first_index + job.ranges.back().index_count == cluster.index_offset)
+								job.ranges.back().index_count += cluster.index_count;
+							else
+							{
+								job.ranges.push_back({ cluster.index_offset, cluster.index_count });
+								renderable.range_count++;
+							}
+						}
+					}
+				});
+
+				for (const Job& job : jobs)
+				{
+					const uint32_t base = (uint32_t)ranges.size();
+					for (uint32_t i = job.begin; i < job.end; ++i)
+						renderables[i]->first_range += base;
+					ranges.insert(ranges.end(), job.ranges.begin(), job.ranges.end());
+					add(stats, job.stats);
+				}
+				stats.ranges = (uint32_t)ranges.size();
+
+				// Nothing is left to draw of these.
+				for (Vector<Renderable>* list : lists)
+				{
+					const size_t size = list->size();
+					list->erase(std::remove_if(list->begin(), list->end(), [](const Renderable& renderable) {
+						return renderable.clustered && renderable.range_count == 0u && drawsOnlyFullDetail(renderable);
+					}), list->end());
+					stats.removed += (uint32_t)(size - list->size());
+				}
+
+				return stats;
+			}
+		}
+	}
+}
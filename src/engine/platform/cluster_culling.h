@@ -0,0 +1,55 @@
+#pragma once
+#include "utils/renderable.h"
+#include <containers/containers.h>
+#include <glm/glm.hpp>
+
+namespace lambda
+{
+	namespace utilities
+	{
+		class Frustum;
+
+		///////////////////////////////////////////////////////////////////////////
+		// Culls the clusters the mesh compiler split large sub meshes into, after
+		// the renderables themselves were culled. What is left of a renderable
+		// is a list of ranges of its indices, neighbouring clusters share a range.
+		namespace ClusterCulling
+		{
+			struct Range
+			{
+				uint32_t first_index;
+				uint32_t index_count;
+			};
+
+			struct View
+			{
+				const Frustum* frustum;
+				glm::vec3      position; // World space.
+				bool           cones;    // Back faces are culled, not the case for shadows.
+			};
+
+			struct Stats
+			{
+				uint32_t renderables       = 0u; // With clusters at full detail.
+				uint32_t removed           = 0u; // Renderables that had no visible clusters left.
+				uint32_t clusters          = 0u;
+				uint32_t frustum_culled    = 0u;
+				uint32_t cone_culled       = 0u;
+				uint32_t ranges            = 0u;
+				uint64_t triangles         = 0u; // Of the renderables with clusters.
+				uint64_t visible_triangles = 0u;
+			};
+
+			// Culls the clusters of the renderables that draw their full detail
+			// level. Renderables that only draw that level and have no visible
+			// clusters are removed from their list, the others point at their
+			// part of ranges.
+			Stats cull(const View& view, const Vector<Vector<Renderable>*>& lists, Vector<Range>& ranges);
+
+			// Whether every triangle of the cluster faces away from position, in
+			// the space of the sub mesh. Transforms keep the side of a plane a
+			// point is on, so this also holds for scaled renderables.
+			bool isBackFacing(const asset::SubMesh::Cluster& cluster, const glm::vec3& position);
+		}
+	}
+}
@@ -0,0 +1,126 @@
+#include "dynamic_resolution.h"
+#include <utils/console.h>
+#include <algorithm>
+#include <cmath>
+
+namespace lambda
+{
+	namespace platform
+	{
+		///////////////////////////////////////////////////////////////////////////
+		void DynamicResolution::setSettings(const Settings& settings)
+		{
+			LMB_ASSERT(settings.min_scale > 0.0f && settings.min_scale <= settings.max_scale, "DYNAMIC RESOLUTION: Invalid scale range %f - %f", settings.min_scale, settings.max_scale);
+			LMB_ASSERT(settings.target_frame_time > 0.0f, "DYNAMIC RESOLUTION: Invalid target frame time %f", settings.target_frame_time);
+
+			// The render targets are allocated at full resolution, they can not be scaled up.
+			settings_ = settings;
+			settings_.max_scale = std::min(settings_.max_scale, 1.0f);
+			settings_.min_scale = std::min(settings_.min_scale, settings_.max_scale);
+			scale_    = std::max(settings_.min_scale, std::min(settings_.max_scale, scale_));
+			frames_since_change_ = 0u;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const DynamicResolution::Settings& DynamicResolution::getSettings() const
+		{
+			return settings_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void DynamicResolution::reset()
+		{
+			scale_               = settings_.max_scale;
+			smoothed_frame_time_ = 0.0f;
+			smoothed_gpu_time_   = 0.0f;
+			has_samples_         = false;
+			frames_since_change_ = 0u;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		float DynamicResolution::update(float frame_time, float gpu_time)
+		{
+			if (!settings_.enabled)
+			{
+				scale_ = 1.0f;
+				return scale_;
+			}
+
+			if (!has_samples_)
+			{
+				smoothed_frame_time_ = frame_time;
+				smoothed_gpu_time_   = gpu_time;
+				has_samples_         = true;
+			}
+			else
+			{
+				smoothed_frame_time_ += (frame_time - smoothed_frame_time_) * settings_.smoothing;
+				smoothed_gpu_time_   += (gpu_time - smoothed_gpu_time_) * settings_.smoothing;
+			}
+
+			if (++frames_since_change_ < settings_.cooldown_frames)
+				return scale_;
+
+			const float time   = smoothed_gpu_time_ > 0.0f ? smoothed_gpu_time_ : smoothed_frame_time_;
+			const float budget = settings_.target_frame_time;
+			if (time <= 0.0f)
+				return scale_;
+
+			// Within the band nothing changes, this is what keeps the scale from oscillating.
+			const bool over  = time > budget * (1.0f + settings_.scale_down_threshold);
+			const bool under = time < budget * (1.0f - settings_.scale_up_threshold);
+			if (!over && !under)
+				return scale_;
+
+			// Cost scales with the amount of pixels, which is the square of the scale.
+			float scale = scale_ * std::sqrt(budget / time);
+			scale = std::max(scale_ - settings_.max_step_down, std::min(scale_ + settings_.max_step_up, scale));
+			scale = quantize(scale);
+			if (scale == scale_)
+				scale += over ? -settings_.granularity : settings_.granularity;
+			scale = std::max(settings_.min_scale, std::min(settings_.max_scale, scale));
+
+			if (scale != scale_)
+			{
+				// Assume the timings follow the change, so the next decision does not
+				// have to wait for the filter to catch up.
+				const float ratio = (scale * scale) / (scale_ * scale_);
+				smoothed_frame_time_ *= ratio;
+				smoothed_gpu_time_   *= ratio;
+				scale_ = scale;
+				frames_since_change_ = 0u;
+			}
+
+			return scale_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		float DynamicResolution::getScale() const
+		{
+			return scale_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		float DynamicResolution::getSmoothedFrameTime() const
+		{
+			return smoothed_frame_time_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		float DynamicResolution::getSmoothedGpuTime() const
+		{
+			return smoothed_gpu_time_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		float DynamicResolution::quantize(float scale) const
+		{
+			if (settings_.granularity <= 0.0f)
+				return scale;
+
+			// Round towards the current scale so a change never overshoots the request.
+			const float steps = scale / settings_.granularity;
+			return (scale > scale_ ? std::floor(steps + 0.001f) : std::ceil(steps - 0.001f)) * settings_.granularity;
+		}
+	}
+}
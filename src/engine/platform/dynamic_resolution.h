@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+
+namespace lambda
+{
+	namespace platform
+	{
+		///////////////////////////////////////////////////////////////////////////
+		// Picks the scale the scene is rendered at so the frame stays within its
+		// time budget. Only works on the timings it is given, so the same trace
+		// always results in the same scales.
+		class DynamicResolution
+		{
+		public:
+			struct Settings
+			{
+				bool     enabled              = false;
+				float    target_frame_time    = 16.6f; // Milliseconds, budget for the timed work.
+				float    min_scale            = 0.5f;
+				float    max_scale            = 1.0f; // Clamped to 1, the targets are not bigger than the screen.
+				// How far the smoothed time has to be over / under the target before the scale changes.
+				float    scale_down_threshold = 0.05f;
+				float    scale_up_threshold   = 0.15f;
+				float    max_step_down        = 0.1f;
+				float    max_step_up          = 0.05f;
+				// Scales snap to multiples of this to keep the amount of different viewports small.
+				float    granularity          = 0.025f;
+				float    smoothing            = 0.1f;
+				// Frames to wait after a change so the new timings can settle.
+				uint32_t cooldown_frames      = 15u;
+			};
+
+			void setSettings(const Settings& settings);
+			const Settings& getSettings() const;
+			void reset();
+
+			// gpu_time is the sum of the timed passes. Zero when the renderer has no
+			// timers, the controller falls back to the frame time then.
+			float update(float frame_time, float gpu_time);
+
+			float getScale() const;
+			float getSmoothedFrameTime() const;
+			float getSmoothedGpuTime() const;
+
+		private:
+			float quantize(float scale) const;
+
+		private:
+			Settings settings_;
+			float    scale_ = 1.0f;
+			float    smoothed_frame_time_ = 0.0f;
+			float    smoothed_gpu_time_ = 0.0f;
+			bool     has_samples_ = false;
+			uint32_t frames_since_change_ = 0u;
+		};
+	}
+}
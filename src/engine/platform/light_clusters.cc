@@ -0,0 +1,446 @@
+#include "light_clusters.h"
+#include "assets/texture.h"
+#include "utils/mt_manager.h"
+#include <memory/memory.h>
+#include <utils/console.h>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHT_CLUSTERS_SSE 1
+#include <emmintrin.h>
+#else
+#define LIGHT_CLUSTERS_SSE 0
+#endif
+
+namespace lambda
+{
+	namespace platform
+	{
+		static constexpr uint32_t kIndexTextureWidth = 1024u;
+		static constexpr uint32_t kMaxIndices        = kIndexTextureWidth * 64u;
+
+		///////////////////////////////////////////////////////////////////////////
+		static asset::VioletTextureHandle createTexture(const String& name, uint32_t width, uint32_t height, TextureFormat format)
+		{
+			asset::VioletTextureHandle texture = asset::TextureManager::getInstance()->create(
+				Name(name),
+				width,
+				height,
+				1u,
+				format,
+				kTextureFlagDynamicData
+			);
+			texture->setKeepInMemory(true);
+			return texture;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static bool sphereIntersectsAabb(const glm::vec3& center, float radius, const glm::vec3& min, const glm::vec3& max)
+		{
+			const glm::vec3 d = glm::max(min - center, glm::vec3(0.0f)) + glm::max(center - max, glm::vec3(0.0f));
+			return glm::dot(d, d) <= radius * radius;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static bool sameLights(const Vector<LightClusters::Light>& a, const Vector<LightClusters::Light>& b)
+		{
+			if (a.size() != b.size())
+				return false;
+			for (size_t i = 0u; i < a.size(); ++i)
+				if (a[i].position != b[i].position || a[i].radius != b[i].radius || a[i].colour != b[i].colour)
+					return false;
+			return true;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void LightClusters::initialize(uint32_t size_x, uint32_t size_y, uint32_t size_z, uint32_t max_lights, uint32_t max_lights_per_cluster)
+		{
+			LMB_ASSERT(max_lights <= 65535u, "LIGHT CLUSTERS: At most 65535 lights are supported, %u requested", max_lights);
+
+			size_x_   = size_x;
+			size_y_   = size_y;
+			size_z_   = size_z;
+			stride_x_ = (size_x + 3u) & ~3u;
+			max_lights_ = max_lights;
+			max_lights_per_cluster_ = max_lights_per_cluster;
+			near_ = far_ = 0.0f;
+
+			const uint32_t cluster_count = size_x_ * size_y_ * size_z_;
+			bounds_.resize(size_y_ * size_z_ * 6u * stride_x_);
+			row_bounds_.resize(size_y_ * size_z_ * 2u);
+			cluster_lights_.resize(cluster_count * max_lights_per_cluster_);
+			cluster_counts_.resize(cluster_count);
+			clusters_.resize(cluster_count);
+			previous_clusters_.resize(cluster_count);
+			indices_.reserve(kMaxIndices);
+			previous_indices_.reserve(kMaxIndices);
+			view_lights_.reserve(max_lights_);
+			lights_.reserve(max_lights_);
+			previous_lights_.reserve(max_lights_);
+			lights_dirty_   = true;
+			clusters_dirty_ = true;
+
+			// The textures are made by the first upload, so the clusters can be built without a renderer.
+			cluster_target_ = RenderTarget();
+			index_target_   = RenderTarget();
+			light_target_   = RenderTarget();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void LightClusters::deinitialize()
+		{
+			bounds_.clear();
+			row_bounds_.clear();
+			view_lights_.clear();
+			lights_.clear();
+			cluster_lights_.clear();
+			cluster_counts_.clear();
+			clusters_.clear();
+			indices_.clear();
+			previous_lights_.clear();
+			previous_clusters_.clear();
+			previous_indices_.clear();
+			cluster_target_ = RenderTarget();
+			index_target_   = RenderTarget();
+			light_target_   = RenderTarget();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void LightClusters::setProjection(const glm::mat4x4& projection, float near, float far)
+		{
+			if (projection == projection_ && near == near_ && far == far_)
+				return;
+
+			projection_  = projection;
+			near_        = std::max(near, 0.0001f);
+			far_         = std::max(far, near_ + 0.0001f);
+			slice_scale_ = (float)size_z_ / std::log(far_ / near_);
+
+			// Every tile corner is a line through two unprojected points. This works
+			// for both perspective and orthographic projections and either handedness.
+			const glm::mat4x4 inverse_projection = glm::inverse(projection_);
+			auto unproject = [&inverse_projection](float x, float y, float z) {
+				glm::vec4 p = inverse_projection * glm::vec4(x, y, z, 1.0f);
+				return glm::vec3(p) / p.w;
+			};
+
+			depth_sign_ = unproject(0.0f, 0.0f, 0.5f).z < 0.0f ? -1.0f : 1.0f;
+
+			for (uint32_t z = 0u; z < size_z_; ++z)
+			{
+				const float depth_near = near_ * std::pow(far_ / near_, (float)z / (float)size_z_);
+				const float depth_far  = near_ * std::pow(far_ / near_, (float)(z + 1u) / (float)size_z_);
+
+				for (uint32_t y = 0u; y < size_y_; ++y)
+				{
+					float* bounds = bounds_.data() + (z * size_y_ + y) * 6u * stride_x_;
+					glm::vec3 row_min(FLT_MAX);
+					glm::vec3 row_max(-FLT_MAX);
+
+					for (uint32_t x = 0u; x < stride_x_; ++x)
+					{
+						// Padding columns never intersect anything.
+						if (x >= size_x_)
+						{
+							for (uint32_t c = 0u; c < 3u; ++c)
+							{
+								bounds[c * stride_x_ + x]        = FLT_MAX;
+								bounds[(c + 3u) * stride_x_ + x] = -FLT_MAX;
+							}
+							continue;
+						}
+
+						// Tile y = 0 is the top of the screen.
+						const float ndc_x[2] = { -1.0f + 2.0f * (float)x / (float)size_x_, -1.0f + 2.0f * (float)(x + 1u) / (float)size_x_ };
+						const float ndc_y[2] = {  1.0f - 2.0f * (float)(y + 1u) / (float)size_y_, 1.0f - 2.0f * (float)y / (float)size_y_ };
+
+						glm::vec3 min(FLT_MAX);
+						glm::vec3 max(-FLT_MAX);
+						for (uint32_t i = 0u; i < 4u; ++i)
+						{
+							glm::vec3 a = unproject(ndc_x[i & 1u], ndc_y[i >> 1u], 0.25f);
+							glm::vec3 b = unproject(ndc_x[i & 1u], ndc_y[i >> 1u], 0.75f);
+							a.z *= depth_sign_;
+							b.z *= depth_sign_;
+
+							for (float depth : { depth_near, depth_far })
+							{
+								const float t = (depth - a.z) / (b.z - a.z);
+								const glm::vec3 p = a + (b - a) * t;
+								min = glm::min(min, p);
+								max = glm::max(max, p);
+							}
+						}
+
+						for (uint32_t c = 0u; c < 3u; ++c)
+						{
+							bounds[c * stride_x_ + x]        = min[c];
+							bounds[(c + 3u) * stride_x_ + x] = max[c];
+						}
+						row_min = glm::min(row_min, min);
+						row_max = glm::max(row_max, max);
+					}
+
+					row_bounds_[(z * size_y_ + y) * 2u + 0u] = row_min;
+					row_bounds_[(z * size_y_ + y) * 2u + 1u] = row_max;
+				}
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void LightClusters::build(const glm::mat4x4& view, const Vector<Light>& lights, uint32_t job_count)
+		{
+			LMB_ASSERT(near_ > 0.0f, "LIGHT CLUSTERS: Build was called before setProjection");
+
+			// Keep the last result around, upload compares against it.
+			lights_.swap(previous_lights_);
+			clusters_.swap(previous_clusters_);
+			indices_.swap(previous_indices_);
+			lights_.clear();
+			view_lights_.clear();
+
+			// Move the lights into view space and find the slices they touch.
+			for (const Light& light : lights)
+			{
+				if (lights_.size() >= max_lights_)
+				{
+					foundation::Warning("LIGHT CLUSTERS: More than " + toString(max_lights_) + " lights, the rest is ignored\n");
+					break;
+				}
+
+				glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+				center.z *= depth_sign_;
+				if (center.z + light.radius < near_ || center.z - light.radius > far_)
+					continue;
+
+				ViewLight view_light;
+				view_light.center    = center;
+				view_light.radius    = light.radius;
+				view_light.slice_min = getSlice(center.z - light.radius);
+				view_light.slice_max = getSlice(center.z + light.radius);
+				view_lights_.push_back(view_light);
+				lights_.push_back(light);
+			}
+
+			// Every job owns a range of slices, so no two jobs write the same cluster.
+			TaskScheduler::parallelFor(size_z_, job_count, 1u, [this](uint32_t job, uint32_t begin, uint32_t end) {
+				assignSlices(begin, end);
+			});
+
+			// Compact the per cluster lists.
+			indices_.clear();
+			bool overflow = false;
+			for (uint32_t i = 0u; i < (uint32_t)clusters_.size(); ++i)
+			{
+				uint32_t count = cluster_counts_[i];
+				if (indices_.size() + count > kMaxIndices)
+				{
+					count = kMaxIndices - (uint32_t)indices_.size();
+					overflow = true;
+				}
+
+				clusters_[i].offset = (uint32_t)indices_.size();
+				clusters_[i].count  = count;
+				const uint16_t* cluster_lights = cluster_lights_.data() + i * max_lights_per_cluster_;
+				indices_.insert(indices_.end(), cluster_lights, cluster_lights + count);
+			}
+
+			if (overflow)
+				foundation::Warning("LIGHT CLUSTERS: Ran out of light indices, some lights were dropped\n");
+
+			// Stays dirty until the next upload, build can run more than once in between.
+			lights_dirty_   = lights_dirty_ || !sameLights(lights_, previous_lights_);
+			clusters_dirty_ = clusters_dirty_ || indices_ != previous_indices_ ||
+				memcmp(clusters_.data(), previous_clusters_.data(), clusters_.size() * sizeof(Cluster)) != 0;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void LightClusters::assignSlices(uint32_t slice_begin, uint32_t slice_end)
+		{
+			const uint32_t slice_size = size_x_ * size_y_;
+			memset(cluster_counts_.data() + slice_begin * slice_size, 0, (slice_end - slice_begin) * slice_size * sizeof(uint32_t));
+
+			for (uint32_t l = 0u; l < (uint32_t)view_lights_.size(); ++l)
+			{
+				const ViewLight& light = view_lights_[l];
+				const uint32_t z_begin = std::max(light.slice_min, slice_begin);
+				const uint32_t z_end   = std::min(light.slice_max + 1u, slice_end);
+
+				for (uint32_t z = z_begin; z < z_end; ++z)
+				{
+					for (uint32_t y = 0u; y < size_y_; ++y)
+					{
+						const uint32_t row = z * size_y_ + y;
+						if (!sphereIntersectsAabb(light.center, light.radius, row_bounds_[row * 2u], row_bounds_[row * 2u + 1u]))
+							continue;
+
+						const float* bounds = getRowBounds(y, z);
+						uint32_t* counts = cluster_counts_.data() + getClusterIndex(0u, y, z);
+						uint16_t* lists  = cluster_lights_.data() + getClusterIndex(0u, y, z) * max_lights_per_cluster_;
+
+#if LIGHT_CLUSTERS_SSE
+						const __m128 zero = _mm_setzero_ps();
+						const __m128 cx = _mm_set1_ps(light.center.x);
+						const __m128 cy = _mm_set1_ps(light.center.y);
+						const __m128 cz = _mm_set1_ps(light.center.z);
+						const __m128 r2 = _mm_set1_ps(light.radius * light.radius);
+
+						for (uint32_t x = 0u; x < stride_x_; x += 4u)
+						{
+							const __m128 dx = _mm_add_ps(
+								_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(bounds + 0u * stride_x_ + x), cx), zero),
+								_mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(bounds + 3u * stride_x_ + x)), zero)
+							);
+							const __m128 dy = _mm_add_ps(
+								_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(bounds + 1u * stride_x_ + x), cy), zero),
+								_mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(bounds + 4u * stride_x_ + x)), zero)
+							);
+							const __m128 dz = _mm_add_ps(
+								_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(bounds + 2u * stride_x_ + x), cz), zero),
+								_mm_max_ps(_mm_sub_ps(cz, _mm_loadu_ps(bounds + 5u * stride_x_ + x)), zero)
+							);
+							const __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+							const int mask = _mm_movemask_ps(_mm_cmple_ps(d2, r2));
+
+							for (uint32_t b = 0u; b < 4u && mask; ++b)
+							{
+								const uint32_t i = x + b;
+								if ((mask & (1 << b)) && counts[i] < max_lights_per_cluster_)
+									lists[i * max_lights_per_cluster_ + counts[i]++] = (uint16_t)l;
+							}
+						}
+#else
+						for (uint32_t x = 0u; x < size_x_; ++x)
+						{
+							const glm::vec3 min(bounds[0u * stride_x_ + x], bounds[1u * stride_x_ + x], bounds[2u * stride_x_ + x]);
+							const glm::vec3 max(bounds[3u * stride_x_ + x], bounds[4u * stride_x_ + x], bounds[5u * stride_x_ + x]);
+							if (sphereIntersectsAabb(light.center, light.radius, min, max) && counts[x] < max_lights_per_cluster_)
+								lists[x * max_lights_per_cluster_ + counts[x]++] = (uint16_t)l;
+						}
+#endif
+					}
+				}
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void LightClusters::upload()
+		{
+			if (!cluster_target_.getTexture())
+			{
+				cluster_target_ = RenderTarget(Name("__light_clusters__"),        createTexture("__light_clusters__", size_x_ * size_y_, size_z_, TextureFormat::kR32G32));
+				index_target_   = RenderTarget(Name("__light_cluster_indices__"), createTexture("__light_cluster_indices__", kIndexTextureWidth, kMaxIndices / kIndexTextureWidth, TextureFormat::kR32));
+				light_target_   = RenderTarget(Name("__light_cluster_lights__"),  createTexture("__light_cluster_lights__", max_lights_ * 2u, 1u, TextureFormat::kR32G32B32A32));
+				lights_dirty_   = true;
+				clusters_dirty_ = true;
+			}
+
+			if (lights_dirty_)
+			{
+				Vector<char> light_data(max_lights_ * 2u * sizeof(glm::vec4));
+				glm::vec4* light_texels = (glm::vec4*)light_data.data();
+				for (uint32_t i = 0u; i < (uint32_t)lights_.size(); ++i)
+				{
+					light_texels[i * 2u + 0u] = glm::vec4(lights_[i].position, lights_[i].radius);
+					light_texels[i * 2u + 1u] = glm::vec4(lights_[i].colour, 1.0f);
+				}
+				light_target_.getTexture()->getLayer(0u).setData(light_data);
+				lights_dirty_ = false;
+			}
+
+			if (!clusters_dirty_)
+				return;
+
+			Vector<char> cluster_data(clusters_.size() * sizeof(glm::vec2));
+			glm::vec2* cluster_texels = (glm::vec2*)cluster_data.data();
+			for (uint32_t i = 0u; i < (uint32_t)clusters_.size(); ++i)
+				cluster_texels[i] = glm::vec2((float)clusters_[i].offset, (float)clusters_[i].count);
+
+			Vector<char> index_data(kMaxIndices * sizeof(float));
+			float* index_texels = (float*)index_data.data();
+			for (uint32_t i = 0u; i < (uint32_t)indices_.size(); ++i)
+				index_texels[i] = (float)indices_[i];
+
+			cluster_target_.getTexture()->getLayer(0u).setData(cluster_data);
+			index_target_.getTexture()->getLayer(0u).setData(index_data);
+			clusters_dirty_ = false;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t LightClusters::getClusterIndex(uint32_t x, uint32_t y, uint32_t z) const
+		{
+			return x + (y + z * size_y_) * size_x_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t LightClusters::getSlice(float depth) const
+		{
+			if (depth <= near_)
+				return 0u;
+			const float slice = std::log(depth / near_) * slice_scale_;
+			return std::min((uint32_t)slice, size_z_ - 1u);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const Vector<LightClusters::Cluster>& LightClusters::getClusters() const
+		{
+			return clusters_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const Vector<uint16_t>& LightClusters::getIndices() const
+		{
+			return indices_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t LightClusters::getLightCount() const
+		{
+			return (uint32_t)lights_.size();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		glm::uvec3 LightClusters::getSize() const
+		{
+			return glm::uvec3(size_x_, size_y_, size_z_);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		glm::vec4 LightClusters::getGridParams() const
+		{
+			return glm::vec4((float)size_x_, (float)size_y_, (float)size_z_, slice_scale_);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		glm::vec4 LightClusters::getDepthParams() const
+		{
+			return glm::vec4(near_, depth_sign_, (float)kIndexTextureWidth, (float)(max_lights_ * 2u));
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const RenderTarget& LightClusters::getClusterTarget() const
+		{
+			return cluster_target_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const RenderTarget& LightClusters::getIndexTarget() const
+		{
+			return index_target_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const RenderTarget& LightClusters::getLightTarget() const
+		{
+			return light_target_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const float* LightClusters::getRowBounds(uint32_t y, uint32_t z) const
+		{
+			return bounds_.data() + (z * size_y_ + y) * 6u * stride_x_;
+		}
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "render_target.h"
+#include <containers/containers.h>
+#include <glm/glm.hpp>
+
+namespace lambda
+{
+	namespace platform
+	{
+		///////////////////////////////////////////////////////////////////////////
+		// Splits the camera frustum into a grid of clusters, exponential in depth,
+		// and assigns lights to the clusters they touch. The result is a compact
+		// list of light indices per cluster so all of these lights can be shaded
+		// in one full screen pass.
+		class LightClusters
+		{
+		public:
+			struct Light
+			{
+				glm::vec3 position; // World space.
+				float     radius;
+				glm::vec3 colour;
+				float     padding;
+			};
+
+			struct Cluster
+			{
+				uint32_t offset;
+				uint32_t count;
+			};
+
+			void initialize(uint32_t size_x = 16u, uint32_t size_y = 9u, uint32_t size_z = 24u, uint32_t max_lights = 1024u, uint32_t max_lights_per_cluster = 256u);
+			void deinitialize();
+
+			// Rebuilds the cluster bounds, only does work when the projection changed.
+			void setProjection(const glm::mat4x4& projection, float near, float far);
+			// Assigns the lights to the clusters. Slices are spread over job_count jobs.
+			void build(const glm::mat4x4& view, const Vector<Light>& lights, uint32_t job_count = 4u);
+			// Writes the clusters, indices and lights into the textures used by the
+			// shading pass, creating them on the first call. Textures whose content
+			// did not change since the last upload are skipped.
+			void upload();
+
+			uint32_t getClusterIndex(uint32_t x, uint32_t y, uint32_t z) const;
+			uint32_t getSlice(float depth) const;
+			const Vector<Cluster>& getClusters() const;
+			const Vector<uint16_t>& getIndices() const;
+			uint32_t getLightCount() const;
+			glm::uvec3 getSize() const;
+
+			// x, y, z: grid size. w: slice scale.
+			glm::vec4 getGridParams() const;
+			// x: near, y: depth sign, z: index texture width, w: light texture width.
+			glm::vec4 getDepthParams() const;
+
+			const RenderTarget& getClusterTarget() const;
+			const RenderTarget& getIndexTarget() const;
+			const RenderTarget& getLightTarget() const;
+
+		private:
+			struct ViewLight
+			{
+				glm::vec3 center; // View space, depth along +z.
+				float     radius;
+				uint32_t  slice_min;
+				uint32_t  slice_max;
+			};
+
+			void assignSlices(uint32_t slice_begin, uint32_t slice_end);
+			const float* getRowBounds(uint32_t y, uint32_t z) const;
+
+		private:
+			uint32_t size_x_ = 0u;
+			uint32_t size_y_ = 0u;
+			uint32_t size_z_ = 0u;
+			uint32_t stride_x_ = 0u; // size_x_ rounded up to a multiple of four.
+			uint32_t max_lights_ = 0u;
+			uint32_t max_lights_per_cluster_ = 0u;
+
+			glm::mat4x4 projection_;
+			float near_ = 0.0f;
+			float far_ = 0.0f;
+			float depth_sign_ = -1.0f;
+			float slice_scale_ = 0.0f;
+
+			// Per row of clusters: min x, min y, min z, max x, max y, max z for every column.
+			Vector<float>     bounds_;
+			// Per row of clusters: the bounds of the entire row.
+			Vector<glm::vec3> row_bounds_;
+
+			Vector<ViewLight> view_lights_;
+			Vector<Light>     lights_;
+			Vector<uint16_t>  cluster_lights_;
+			Vector<uint32_t>  cluster_counts_;
+			Vector<Cluster>   clusters_;
+			Vector<uint16_t>  indices_;
+
+			// What the last build produced, to tell whether the textures are stale.
+			Vector<Light>     previous_lights_;
+			Vector<Cluster>   previous_clusters_;
+			Vector<uint16_t>  previous_indices_;
+			bool lights_dirty_   = true;
+			bool clusters_dirty_ = true;
+
+			RenderTarget cluster_target_;
+			RenderTarget index_target_;
+			RenderTarget light_target_;
+		};
+	}
+}
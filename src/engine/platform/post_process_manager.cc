@@ -12,6 +12,9 @@ namespace lambda
       final_target_ = other.final_target_;
       targets_      = other.targets_;
       passes_       = other.passes_;
+      persistent_   = other.persistent_;
+      aliases_      = other.aliases_;
+      dirty_        = true;
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -20,12 +23,15 @@ namespace lambda
       target.getTexture()->getLayer(0u).setFlags(target.getTexture()->getLayer(0u).getFlags() | kTextureFlagIsRenderTarget);
       targets_.insert(eastl::make_pair(target.getName(), target));
       targets_[target.getName()].resize(last_size_);
+      dirty_ = true;
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     void PostProcessManager::removeTarget(const RenderTarget& target)
     {
       targets_.erase(target.getName());
+      aliases_.erase(target.getName());
+      dirty_ = true;
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -33,7 +39,17 @@ namespace lambda
     {
 			last_size_ = size;
 			for (auto& target : targets_)
-        target.second.resize(size);
+        resizeTarget(target.second, aliases_.find(target.first) != aliases_.end());
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void PostProcessManager::resizeTarget(RenderTarget& target, bool aliased)
+    {
+      // Aliased targets render into the texture of another target, their own texture only has to exist.
+      if (!aliased)
+        target.resize(last_size_);
+      else if ((target.getTexture()->getLayer(0u).getFlags() & kTextureFlagResize) != 0)
+        target.getTexture()->resize(1u, 1u);
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -54,11 +70,14 @@ namespace lambda
     void PostProcessManager::addPass(const ShaderPass& pass)
     {
       passes_.push_back(pass);
+      dirty_ = true;
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     void PostProcessManager::setFinalTarget(const Name& final_target)
     {
+      if (final_target_ != final_target)
+        dirty_ = true;
       final_target_ = final_target;
     }
 
@@ -68,9 +87,22 @@ namespace lambda
       return final_target_;
     }
 
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void PostProcessManager::setPersistent(const Name& name, bool persistent)
+    {
+      auto it = eastl::find(persistent_.begin(), persistent_.end(), name);
+      if (persistent && it == persistent_.end())
+        persistent_.push_back(name);
+      else if (!persistent && it != persistent_.end())
+        persistent_.erase(it);
+      dirty_ = true;
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     Vector<ShaderPass>& PostProcessManager::getPasses()
     {
+      // Passes can be enabled or disabled through this.
+      dirty_ = true;
       return passes_;
     }
 
@@ -86,6 +118,114 @@ namespace lambda
       return targets_;
     }
 
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    const Vector<ShaderPass>& PostProcessManager::getCompiledPasses()
+    {
+      if (dirty_)
+        compile();
+      return compiled_passes_;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    const RenderGraph& PostProcessManager::getGraph()
+    {
+      if (dirty_)
+        compile();
+      return graph_;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void PostProcessManager::compile()
+    {
+      graph_.clear();
+
+      auto getResource = [this](const RenderTarget& target) {
+        uint32_t resource = graph_.findResource(target.getName());
+        if (resource != RenderGraph::kInvalid)
+          return resource;
+
+        // Only targets that are owned and sized by the manager can be aliased.
+        auto it = targets_.find(target.getName());
+        const bool owned =
+          it != targets_.end() &&
+          !it->second.isBackBuffer() &&
+          !it->second.fromTexture() &&
+          target.getMipMap() == 0 &&
+          target.getLayer() == 0 &&
+          (it->second.getTexture()->getLayer(0u).getFlags() & kTextureFlagResize) != 0 &&
+          eastl::find(persistent_.begin(), persistent_.end(), target.getName()) == persistent_.end();
+
+        return graph_.addResource(
+          target.getName(),
+          owned ? it->second.getRenderScale() : 0.0f,
+          owned ? it->second.getTexture()->getLayer(0u).getFormat() : TextureFormat::kUnknown,
+          !owned
+        );
+      };
+
+      Vector<uint32_t> pass_indices;
+      for (uint32_t i = 0u; i < passes_.size(); ++i)
+      {
+        if (!passes_[i].getEnabled())
+          continue;
+
+        Vector<uint32_t> reads;
+        Vector<uint32_t> writes;
+        for (const RenderTarget& input : passes_[i].getInputs())
+          reads.push_back(getResource(input));
+        for (const RenderTarget& output : passes_[i].getOutputs())
+          writes.push_back(getResource(output));
+
+        graph_.addPass(passes_[i].getName(), reads, writes);
+        pass_indices.push_back(i);
+      }
+
+      const uint32_t final_target = graph_.findResource(final_target_);
+      if (final_target != RenderGraph::kInvalid)
+        graph_.addOutput(final_target);
+
+      graph_.compile();
+
+      // Only touch the textures of targets that started or stopped being aliased.
+      UnorderedMap<Name, Name> aliases;
+      for (uint32_t i = 0u; i < graph_.getResources().size(); ++i)
+      {
+        const RenderGraph::Resource& resource = graph_.getResources()[i];
+        if (resource.physical != i)
+          aliases.insert(eastl::make_pair(resource.name, graph_.getResources()[resource.physical].name));
+      }
+
+      for (auto& target : targets_)
+      {
+        const bool was_aliased = aliases_.find(target.first) != aliases_.end();
+        const bool is_aliased  = aliases.find(target.first) != aliases.end();
+        if (was_aliased != is_aliased)
+          resizeTarget(target.second, is_aliased);
+      }
+      aliases_ = aliases;
+
+      auto resolve = [this](Vector<RenderTarget> targets) {
+        for (RenderTarget& target : targets)
+        {
+          auto it = aliases_.find(target.getName());
+          if (it != aliases_.end())
+            target.metaSetTexture(targets_[it->second].getTexture());
+        }
+        return targets;
+      };
+
+      compiled_passes_.clear();
+      for (const RenderGraph::CompiledPass& compiled_pass : graph_.getCompiledPasses())
+      {
+        ShaderPass pass = passes_[pass_indices[compiled_pass.pass]];
+        pass.metaSetInputs(resolve(pass.getInputs()));
+        pass.metaSetOutputs(resolve(pass.getOutputs()));
+        compiled_passes_.push_back(pass);
+      }
+
+      dirty_ = false;
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     ShaderPass::ShaderPass() :
       enabled_(false)
@@ -1,5 +1,6 @@
 #pragma once
 #include "shader_pass.h"
+#include "render_graph.h"
 
 namespace lambda
 {
@@ -24,16 +25,34 @@ namespace lambda
       
       void setFinalTarget(const Name& final_target);
       Name getFinalTarget() const;
+
+      // Persistent targets keep their content between frames and are never aliased.
+      void setPersistent(const Name& name, bool persistent);
       
       Vector<ShaderPass>& getPasses();
       const Vector<ShaderPass>& getPasses() const;
       const UnorderedMap<Name, RenderTarget>& getAllTargets() const;
 
+      // The enabled passes without the culled ones, with the aliased targets resolved.
+      const Vector<ShaderPass>& getCompiledPasses();
+      const RenderGraph& getGraph();
+
+    private:
+      void compile();
+      void resizeTarget(RenderTarget& target, bool aliased);
+
     private:
       glm::uvec2 last_size_ = glm::uvec2(1u);
       Name final_target_;
       UnorderedMap<Name, RenderTarget> targets_;
       Vector<ShaderPass> passes_;
+
+      bool dirty_ = true;
+      Vector<Name> persistent_;
+      RenderGraph graph_;
+      Vector<ShaderPass> compiled_passes_;
+      // Targets that use the texture of another target.
+      UnorderedMap<Name, Name> aliases_;
     };
   }
 }
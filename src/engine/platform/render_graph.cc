@@ -0,0 +1,295 @@
+#include "render_graph.h"
+#include <utils/console.h>
+
+namespace lambda
+{
+	namespace platform
+	{
+		///////////////////////////////////////////////////////////////////////////
+		void RenderGraph::clear()
+		{
+			resources_.clear();
+			passes_.clear();
+			outputs_.clear();
+			culled_.clear();
+			compiled_passes_.clear();
+			final_barriers_.clear();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t RenderGraph::addResource(const Name& name, float render_scale, TextureFormat format, bool imported)
+		{
+			LMB_ASSERT(findResource(name) == kInvalid, "RENDER GRAPH: Resource %s was already added", name.getName().c_str());
+
+			Resource resource;
+			resource.name         = name;
+			resource.render_scale = render_scale;
+			resource.format       = format;
+			resource.imported     = imported;
+			resource.transient    = false;
+			resource.first_use    = kInvalid;
+			resource.last_use     = kInvalid;
+			resource.physical     = (uint32_t)resources_.size();
+			resources_.push_back(resource);
+			return resource.physical;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t RenderGraph::addPass(const Name& name, const Vector<uint32_t>& reads, const Vector<uint32_t>& writes)
+		{
+			for (uint32_t resource : reads)
+				LMB_ASSERT(resource < resources_.size(), "RENDER GRAPH: Pass %s reads an unknown resource", name.getName().c_str());
+			for (uint32_t resource : writes)
+				LMB_ASSERT(resource < resources_.size(), "RENDER GRAPH: Pass %s writes an unknown resource", name.getName().c_str());
+
+			passes_.push_back({ name, reads, writes });
+			return (uint32_t)passes_.size() - 1u;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void RenderGraph::addOutput(uint32_t resource)
+		{
+			LMB_ASSERT(resource < resources_.size(), "RENDER GRAPH: Unknown output %u", resource);
+			if (eastl::find(outputs_.begin(), outputs_.end(), resource) == outputs_.end())
+				outputs_.push_back(resource);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void RenderGraph::compile()
+		{
+			// A resource is transient when its content does not have to survive
+			// the frame, which is the case when the first pass touching it writes
+			// all of it.
+			Vector<bool> touched(resources_.size(), false);
+			for (Resource& resource : resources_)
+				resource.transient = false;
+
+			for (const Pass& pass : passes_)
+			{
+				for (uint32_t resource : pass.reads)
+					touched[resource] = true;
+				for (uint32_t resource : pass.writes)
+				{
+					if (!touched[resource])
+						resources_[resource].transient = !resources_[resource].imported;
+					touched[resource] = true;
+				}
+			}
+
+			for (uint32_t output : outputs_)
+				resources_[output].transient = false;
+
+			cull();
+			computeLifetimes();
+			alias();
+			computeBarriers();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t RenderGraph::findResource(const Name& name) const
+		{
+			for (uint32_t i = 0u; i < resources_.size(); ++i)
+				if (resources_[i].name == name)
+					return i;
+			return kInvalid;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const Vector<RenderGraph::Resource>& RenderGraph::getResources() const
+		{
+			return resources_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const Vector<RenderGraph::Pass>& RenderGraph::getPasses() const
+		{
+			return passes_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const Vector<RenderGraph::CompiledPass>& RenderGraph::getCompiledPasses() const
+		{
+			return compiled_passes_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const Vector<RenderGraph::Barrier>& RenderGraph::getFinalBarriers() const
+		{
+			return final_barriers_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		bool RenderGraph::isCulled(uint32_t pass) const
+		{
+			return pass >= culled_.size() || culled_[pass];
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t RenderGraph::getPhysicalCount() const
+		{
+			uint32_t count = 0u;
+			for (uint32_t i = 0u; i < resources_.size(); ++i)
+				if (resources_[i].first_use != kInvalid && resources_[i].physical == i)
+					count++;
+			return count;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void RenderGraph::cull()
+		{
+			// Walk back from the end of the frame. Persistent resources are always
+			// needed, transient resources only when a pass that is kept reads them.
+			Vector<bool> needed(resources_.size(), false);
+			for (uint32_t i = 0u; i < resources_.size(); ++i)
+				needed[i] = !resources_[i].transient;
+			for (uint32_t output : outputs_)
+				needed[output] = true;
+
+			culled_.resize(passes_.size());
+			for (int32_t i = (int32_t)passes_.size() - 1; i >= 0; --i)
+			{
+				const Pass& pass = passes_[i];
+
+				bool keep = false;
+				for (uint32_t resource : pass.writes)
+					keep |= needed[resource];
+				culled_[i] = !keep;
+
+				if (!keep)
+					continue;
+
+				// Passes write the entire target, so earlier writes to a transient
+				// resource are dead unless something in between reads them.
+				for (uint32_t resource : pass.writes)
+					if (resources_[resource].transient)
+						needed[resource] = false;
+				for (uint32_t resource : pass.reads)
+					needed[resource] = true;
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void RenderGraph::computeLifetimes()
+		{
+			compiled_passes_.clear();
+			for (Resource& resource : resources_)
+			{
+				resource.first_use = kInvalid;
+				resource.last_use  = kInvalid;
+			}
+
+			for (uint32_t i = 0u; i < passes_.size(); ++i)
+			{
+				if (culled_[i])
+					continue;
+
+				const uint32_t index = (uint32_t)compiled_passes_.size();
+				compiled_passes_.push_back({ i, {} });
+
+				auto use = [&](uint32_t r) {
+					Resource& resource = resources_[r];
+					if (resource.first_use == kInvalid)
+						resource.first_use = index;
+					resource.last_use = index;
+				};
+				for (uint32_t resource : passes_[i].reads)
+					use(resource);
+				for (uint32_t resource : passes_[i].writes)
+					use(resource);
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void RenderGraph::alias()
+		{
+			Vector<uint32_t> transients;
+			for (uint32_t i = 0u; i < resources_.size(); ++i)
+			{
+				resources_[i].physical = i;
+				if (resources_[i].transient && resources_[i].first_use != kInvalid)
+					transients.push_back(i);
+			}
+
+			eastl::stable_sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b) {
+				return resources_[a].first_use < resources_[b].first_use;
+			});
+
+			// Greedy interval assignment. Only resources that would be created
+			// identically can share memory.
+			struct Slot
+			{
+				uint32_t physical;
+				uint32_t last_use;
+			};
+			Vector<Slot> slots;
+
+			for (uint32_t r : transients)
+			{
+				Resource& resource = resources_[r];
+
+				Slot* found = nullptr;
+				for (Slot& slot : slots)
+				{
+					const Resource& physical = resources_[slot.physical];
+					if (slot.last_use < resource.first_use &&
+						physical.format == resource.format &&
+						physical.render_scale == resource.render_scale)
+					{
+						found = &slot;
+						break;
+					}
+				}
+
+				if (found)
+				{
+					resource.physical = found->physical;
+					found->last_use   = resource.last_use;
+				}
+				else
+				{
+					slots.push_back({ r, resource.last_use });
+				}
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void RenderGraph::computeBarriers()
+		{
+			// Persistent resources are expected to be readable in between frames.
+			Vector<ResourceState> states(resources_.size(), ResourceState::kShaderRead);
+			for (uint32_t i = 0u; i < resources_.size(); ++i)
+				if (resources_[i].transient)
+					states[i] = ResourceState::kUndefined;
+
+			for (uint32_t i = 0u; i < compiled_passes_.size(); ++i)
+			{
+				CompiledPass& compiled_pass = compiled_passes_[i];
+				const Pass& pass = passes_[compiled_pass.pass];
+
+				auto transition = [&](uint32_t physical, ResourceState state) {
+					if (states[physical] != state)
+					{
+						compiled_pass.barriers.push_back({ physical, states[physical], state });
+						states[physical] = state;
+					}
+				};
+
+				for (uint32_t resource : pass.reads)
+					transition(resources_[resource].physical, ResourceState::kShaderRead);
+
+				for (uint32_t resource : pass.writes)
+				{
+					// A new resource starts living in this memory, the old content can be discarded.
+					if (resources_[resource].transient && resources_[resource].first_use == i)
+						states[resources_[resource].physical] = ResourceState::kUndefined;
+					transition(resources_[resource].physical, ResourceState::kRenderTarget);
+				}
+			}
+
+			final_barriers_.clear();
+			for (uint32_t i = 0u; i < resources_.size(); ++i)
+				if (!resources_[i].transient && states[i] != ResourceState::kShaderRead)
+					final_barriers_.push_back({ i, states[i], ResourceState::kShaderRead });
+		}
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <containers/containers.h>
+#include <assets/enums.h>
+#include <utils/name.h>
+
+namespace lambda
+{
+	namespace platform
+	{
+		///////////////////////////////////////////////////////////////////////////
+		// Frame graph of full screen passes. Passes declare which resources they
+		// read and write. Compiling the graph culls passes that do not contribute
+		// to an output, computes the lifetime of every resource, lets transient
+		// resources that never overlap share the same memory and works out which
+		// state transitions are required in between passes.
+		// Does not touch the device, the result is a plan that gets applied by the
+		// post process manager.
+		class RenderGraph
+		{
+		public:
+			static constexpr uint32_t kInvalid = ~0u;
+
+			enum class ResourceState : uint8_t
+			{
+				kUndefined,
+				kRenderTarget,
+				kShaderRead,
+			};
+
+			struct Resource
+			{
+				Name          name;
+				float         render_scale;
+				TextureFormat format;
+				// Imported resources keep their content across frames and are never aliased.
+				bool          imported;
+
+				// Filled in by compile().
+				bool          transient;
+				uint32_t      first_use;
+				uint32_t      last_use;
+				uint32_t      physical; // Index of the resource whose memory this resource uses.
+			};
+
+			struct Pass
+			{
+				Name             name;
+				Vector<uint32_t> reads;
+				Vector<uint32_t> writes;
+			};
+
+			struct Barrier
+			{
+				uint32_t      resource; // Physical resource.
+				ResourceState before;
+				ResourceState after;
+			};
+
+			struct CompiledPass
+			{
+				uint32_t        pass;
+				Vector<Barrier> barriers; // Need to be executed before the pass.
+			};
+
+			void clear();
+			uint32_t addResource(const Name& name, float render_scale, TextureFormat format, bool imported);
+			uint32_t addPass(const Name& name, const Vector<uint32_t>& reads, const Vector<uint32_t>& writes);
+			// Passes that (indirectly) write to an output are never culled.
+			void addOutput(uint32_t resource);
+			void compile();
+
+			uint32_t findResource(const Name& name) const;
+			const Vector<Resource>& getResources() const;
+			const Vector<Pass>& getPasses() const;
+			const Vector<CompiledPass>& getCompiledPasses() const;
+			// Return the persistent resources to a readable state after the last pass.
+			const Vector<Barrier>& getFinalBarriers() const;
+			bool isCulled(uint32_t pass) const;
+			// Amount of resources that own memory after aliasing.
+			uint32_t getPhysicalCount() const;
+
+		private:
+			void cull();
+			void computeLifetimes();
+			void alias();
+			void computeBarriers();
+
+		private:
+			Vector<Resource>     resources_;
+			Vector<Pass>         passes_;
+			Vector<uint32_t>     outputs_;
+			Vector<bool>         culled_;
+			Vector<CompiledPass> compiled_passes_;
+			Vector<Barrier>      final_barriers_;
+		};
+	}
+}
@@ -8,9 +8,17 @@
 #include "platform/depth_stencil_state.h"
 #include "platform/blend_state.h"
 #include "platform/rasterizer_state.h"
+#include "platform/shadow_atlas.h"
+#include "platform/light_clusters.h"
+#include "platform/dynamic_resolution.h"
+#include "platform/cluster_culling.h"
+#include "assets/asset_streamer.h"
+#include "assets/asset_reloader.h"
+#include "assets/texture.h"
 #include <gui/gui.h>
 #include <memory/frame_heap.h>
 #include <algorithm>
+#include <chrono>
 #include <utils/decompose_matrix.h>
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
@@ -42,11 +50,17 @@ namespace lambda
 			components::RigidBodySystem::initialize(scene);
 			components::WaveSourceSystem::initialize(scene);
 			components::LightSystem::initialize(scene);
+			scene.shadow_atlas = foundation::Memory::construct<platform::ShadowAtlas>();
+			scene.shadow_atlas->initialize();
+			scene.light_clusters = foundation::Memory::construct<platform::LightClusters>();
+			scene.light_clusters->initialize();
+			scene.dynamic_resolution = foundation::Memory::construct<platform::DynamicResolution>();
 			scene.debug_renderer.Initialize(scene);
 		}
 		void sceneUpdate(const float& delta_time, scene::Scene& scene)
 		{
 			components::LODSystem::update(delta_time, scene);
+			components::AnimationSystem::update(delta_time, scene);
 			components::MonoBehaviourSystem::update(delta_time, scene);
 			components::WaveSourceSystem::update(delta_time, scene);
 		}
@@ -91,6 +105,15 @@ namespace lambda
 			Vector<platform::RenderTarget> output;
 		};
 
+		// A sub mesh that is drawn as its impostor.
+		struct ImpostorInstance
+		{
+			asset::VioletMeshHandle mesh;
+			glm::mat4x4             model_matrix; // Maps the unit sphere onto the bounding sphere of the sub mesh.
+			glm::vec4               mr;           // Metallic, roughness, LOD fade.
+			glm::vec4               rect;         // Of the sub mesh in the impostor atlases.
+		};
+
 		struct CameraBatch
 		{
 			~CameraBatch() {};
@@ -105,6 +128,10 @@ namespace lambda
 #else
 			Vector<utilities::Renderable> opaque;
 			Vector<utilities::Renderable> alpha;
+			Vector<ImpostorInstance>      impostors; // Sorted by mesh, so every atlas is bound once.
+			Vector<utilities::ClusterCulling::Range> cluster_ranges;
+			asset::VioletShaderHandle     impostor_shader;
+			asset::VioletMeshHandle       impostor_quad;
 #endif
 			Vector<SceneShaderPass>  shader_passes;
 
@@ -119,8 +146,12 @@ namespace lambda
 #if USE_RENDERABLES
 				renderables   = other.renderables;
 #else
-				opaque        = other.opaque;
-				alpha         = other.alpha;
+				opaque          = other.opaque;
+				alpha           = other.alpha;
+				impostors       = other.impostors;
+				impostor_shader = other.impostor_shader;
+				impostor_quad   = other.impostor_quad;
+				cluster_ranges  = other.cluster_ranges;
 #endif
 			}
 		};
@@ -135,41 +166,58 @@ namespace lambda
 			
 				glm::mat4x4 view_projection;
 				glm::vec3   direction;
+				glm::vec4   atlas_rect;
+				glm::vec4   viewport;
 
 #if USE_RENDERABLES
+				Vector<SceneRenderable>  static_renderables;
 				Vector<SceneRenderable>  renderables;
 #else
+				Vector<utilities::Renderable> static_opaque;
+				Vector<utilities::Renderable> static_alpha;
 				Vector<utilities::Renderable> opaque;
 				Vector<utilities::Renderable> alpha;
 #endif
 
+				SceneShaderPass           clear;
+				SceneShaderPass           cache;
+				SceneShaderPass           composite;
 				SceneShaderPass           generate;
 				Vector<SceneShaderPass>   modify;
+				SceneShaderPass           resolve;
 
 				void operator=(const Face& other)
 				{
-					view_projection = other.view_projection;
-					direction       = other.direction;
+					view_projection    = other.view_projection;
+					direction          = other.direction;
+					atlas_rect         = other.atlas_rect;
+					viewport           = other.viewport;
 #if USE_RENDERABLES
-					renderables     = other.renderables;
+					static_renderables = other.static_renderables;
+					renderables        = other.renderables;
 #else
-					opaque          = other.opaque;
-					alpha           = other.alpha;
+					static_opaque      = other.static_opaque;
+					static_alpha       = other.static_alpha;
+					opaque             = other.opaque;
+					alpha              = other.alpha;
 #endif
-					generate        = other.generate;
-					modify          = other.modify;
+					clear              = other.clear;
+					cache              = other.cache;
+					composite          = other.composite;
+					generate           = other.generate;
+					modify             = other.modify;
+					resolve            = other.resolve;
 				}
 			};
 
 			Vector<Face> faces;
-			Vector<platform::RenderTarget> clear_queue_depth;
-			Vector<platform::RenderTarget> clear_queue_texture;
 			asset::VioletMeshHandle full_screen_mesh;
 
 			glm::vec3   position;
 			glm::vec3   colour;
 			float       near;
 			float       far;
+			Vector<glm::vec4> publish_user_data; // Bound from user data slot 1 onwards.
 			bool        is_rh;
 
 			SceneShaderPass publish;
@@ -182,10 +230,9 @@ namespace lambda
 				colour              = other.colour;
 				near                = other.near;
 				far                 = other.far;
+				publish_user_data   = other.publish_user_data;
 				publish             = other.publish;
 				is_rh               = other.is_rh;
-				clear_queue_depth   = other.clear_queue_depth;
-				clear_queue_texture = other.clear_queue_texture;
 			}
 		};
 
@@ -259,7 +306,7 @@ namespace lambda
 			}
 		}
 
-		void renderMeshes(platform::IRenderer* renderer, const Vector<SceneRenderable>& renderables, platform::RasterizerState::CullMode cull_mode)
+		void renderMeshes(platform::IRenderer* renderer, const Vector<SceneRenderable>& renderables, platform::RasterizerState::CullMode cull_mode, const platform::BlendState& blend_state = platform::BlendState::Alpha())
 		{
 			struct CBData
 			{
@@ -271,7 +318,7 @@ namespace lambda
 			platform::IRenderBuffer* cb = renderer->allocRenderBuffer(sizeof(data), platform::IRenderBuffer::kFlagConstant | platform::IRenderBuffer::kFlagTransient | platform::IRenderBuffer::kFlagDynamic, &data);
 			renderer->setConstantBuffer(cb, cbPerMeshIdx);
 
-			renderer->setBlendState(platform::BlendState::Alpha());
+			renderer->setBlendState(blend_state);
 			for (const SceneRenderable& renderable : renderables)
 			{
 				renderer->setMesh(renderable.mesh);
@@ -282,7 +329,7 @@ namespace lambda
 				renderer->setTexture(renderable.dmra,     2);
 				renderer->setTexture(renderable.emissive, 3);
 
-				auto sub_mesh = renderable.mesh->getSubMeshes().at(renderable.sub_mesh);
+				const asset::SubMesh& sub_mesh = renderable.mesh->getSubMeshes().at(renderable.sub_mesh);
 				// TODO (Hilze): Implement.
 				if (sub_mesh.io.double_sided == true || (sub_mesh.io.tex_alb >= 0 && renderable.mesh->getAttachedTextures().at(sub_mesh.io.tex_alb)->getLayer(0u).containsAlpha()))
 					renderer->setRasterizerState(platform::RasterizerState::SolidNone());
@@ -314,7 +361,32 @@ namespace lambda
 			}
 		}
 #else
-		void renderMeshes(platform::IRenderer* renderer, const Vector<utilities::Renderable>& renderables, platform::RasterizerState::CullMode cull_mode)
+		///////////////////////////////////////////////////////////////////////////
+		// Calls draw(lod, fade) for every level the renderable is visible with.
+		// The fade ends up in metallic_roughness.z, see DiscardLOD in common.fxh.
+		template<typename T>
+		static void forEachLOD(const utilities::Renderable& renderable, const T& draw)
+		{
+			if (renderable.lod_fade >= 1.0f || renderable.lod == renderable.fade_lod)
+				draw(renderable.lod, 0.0f);
+			else if (renderable.lod_fade <= 0.0f)
+				draw(renderable.fade_lod, 0.0f);
+			else
+			{
+				draw(renderable.fade_lod, -renderable.lod_fade);
+				draw(renderable.lod, renderable.lod_fade);
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		// Levels after the last LOD are impostors, they are drawn by renderImpostors.
+		static bool isImpostorLOD(const asset::SubMesh& sub_mesh, uint8_t lod)
+		{
+			return lod > sub_mesh.lods.size();
+		}
+
+		// cluster_ranges is needed when clusters of the renderables were culled.
+		void renderMeshes(platform::IRenderer* renderer, const Vector<utilities::Renderable>& renderables, platform::RasterizerState::CullMode cull_mode, const platform::BlendState& blend_state = platform::BlendState::Alpha(), const Vector<utilities::ClusterCulling::Range>* cluster_ranges = nullptr)
 		{
 			struct CBData
 			{
@@ -326,28 +398,23 @@ namespace lambda
 			platform::IRenderBuffer* cb = renderer->allocRenderBuffer(sizeof(data), platform::IRenderBuffer::kFlagConstant | platform::IRenderBuffer::kFlagTransient | platform::IRenderBuffer::kFlagDynamic, &data);
 			renderer->setConstantBuffer(cb, cbPerMeshIdx);
 
-			renderer->setBlendState(platform::BlendState::Alpha());
-			for (utilities::Renderable renderable : renderables)
+			renderer->setBlendState(blend_state);
+			for (const utilities::Renderable& renderable : renderables)
 			{
-				glm::vec4 mr(renderable.metallicness, renderable.roughness, 0.0f, 0.0f);
 				glm::vec4 em(renderable.emissiveness.x, renderable.emissiveness.y, renderable.emissiveness.z, 0.0f);
 				memcpy(data.mm, &renderable.model_matrix, sizeof(glm::mat4x4));
-				memcpy(data.mr, &mr, sizeof(glm::vec4));
 				memcpy(data.em, &em, sizeof(glm::vec4));
-				memcpy(cb->lock(), &data, sizeof(data));
-				cb->unlock();
 
 				renderer->setMesh(renderable.mesh);
-				renderer->setSubMesh(renderable.sub_mesh);
 
 				renderer->setTexture(renderable.albedo_texture,   0);
 				renderer->setTexture(renderable.normal_texture,   1);
 				renderer->setTexture(renderable.dmra_texture,     2);
 				renderer->setTexture(renderable.emissive_texture, 3);
 
-				auto sub_mesh = renderable.mesh->getSubMeshes().at(renderable.sub_mesh);
+				const asset::SubMesh& sub_mesh = renderable.mesh->getSubMeshes().at(renderable.sub_mesh);
 				// TODO (Hilze): Implement.
-				if (sub_mesh.io.double_sided == true || (sub_mesh.io.tex_alb >= 0 && renderable.mesh->getAttachedTextures().at(sub_mesh.io.tex_alb)->getLayer(0u).containsAlpha()))
+				if (utilities::isTwoSided(renderable))
 					renderer->setRasterizerState(platform::RasterizerState::SolidNone());
 				else
 				{
@@ -359,11 +426,146 @@ namespace lambda
 						renderer->setRasterizerState(platform::RasterizerState::SolidNone());
 				}
 
-				renderer->draw(1);
+				forEachLOD(renderable, [&](uint8_t lod, float fade) {
+					if (isImpostorLOD(sub_mesh, lod))
+						return;
+					const bool clustered = lod == 0u && renderable.clustered;
+					if (clustered && renderable.range_count == 0u)
+						return;
+
+					glm::vec4 mr(renderable.metallicness, renderable.roughness, fade, 0.0f);
+					memcpy(data.mr, &mr, sizeof(glm::vec4));
+					memcpy(cb->lock(), &data, sizeof(data));
+					cb->unlock();
+
+					renderer->setSubMesh(renderable.sub_mesh, lod);
+					if (clustered)
+					{
+						LMB_ASSERT(cluster_ranges, "SCENE: Clustered renderable drawn without its ranges");
+						for (uint32_t i = 0u; i < renderable.range_count; ++i)
+						{
+							const utilities::ClusterCulling::Range& range = cluster_ranges->at(renderable.first_range + i);
+							renderer->drawRange(range.first_index, range.index_count);
+						}
+					}
+					else
+						renderer->draw(1);
+				});
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static void collectImpostors(const Vector<utilities::Renderable>& renderables, Vector<ImpostorInstance>& impostors)
+		{
+			for (const utilities::Renderable& renderable : renderables)
+			{
+				const asset::SubMesh& sub_mesh = renderable.mesh->getSubMeshes().at(renderable.sub_mesh);
+				forEachLOD(renderable, [&](uint8_t lod, float fade) {
+					if (!isImpostorLOD(sub_mesh, lod) || sub_mesh.impostor.radius <= 0.0f)
+						return;
+
+					ImpostorInstance instance;
+					instance.mesh         = renderable.mesh;
+					instance.model_matrix = glm::scale(glm::translate(renderable.model_matrix, sub_mesh.impostor.center), glm::vec3(sub_mesh.impostor.radius));
+					instance.mr           = glm::vec4(renderable.metallicness, renderable.roughness, fade, 0.0f);
+					instance.rect         = sub_mesh.impostor.rect;
+					impostors.push_back(instance);
+				});
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		// Draws the impostors with the render targets of the shader pass, a
+		// single quad instanced over every impostor that shares an atlas.
+		static void renderImpostors(platform::IRenderer* renderer, const CameraBatch& camera_batch, const SceneShaderPass& shader_pass)
+		{
+			if (camera_batch.impostors.empty())
+				return;
+
+			struct CBData
+			{
+				glm::mat4x4 mm[64];
+				glm::vec4 mr[64];
+				glm::vec4 em[64];
+			} data;
+
+			renderer->bindShaderPass(platform::ShaderPass(Name(""), camera_batch.impostor_shader, shader_pass.input, shader_pass.output));
+
+			platform::IRenderBuffer* cb = renderer->allocRenderBuffer(sizeof(data), platform::IRenderBuffer::kFlagConstant | platform::IRenderBuffer::kFlagTransient | platform::IRenderBuffer::kFlagDynamic, &data);
+			renderer->setConstantBuffer(cb, cbPerMeshIdx);
+
+			renderer->setBlendState(platform::BlendState::Alpha());
+			renderer->setRasterizerState(platform::RasterizerState::SolidNone());
+			renderer->setMesh(camera_batch.impostor_quad);
+			renderer->setSubMesh(0u);
+
+			const Vector<ImpostorInstance>& impostors = camera_batch.impostors;
+			size_t begin = 0u;
+			while (begin < impostors.size())
+			{
+				const asset::VioletMeshHandle& mesh = impostors[begin].mesh;
+				size_t end = begin + 1u;
+				while (end < impostors.size() && impostors[end].mesh.getHash() == mesh.getHash())
+					end++;
+
+				renderer->setTexture(mesh->getImpostorAlbedo(),       0);
+				renderer->setTexture(mesh->getImpostorNormalDepth(), 1);
+				renderer->setUserData(glm::vec4((float)mesh->getImpostorFrames(), 0.0f, 0.0f, 0.0f), 0);
+
+				// The rect goes where the emissiveness of a mesh would be.
+				for (size_t offset = begin; offset < end; offset += 64u)
+				{
+					const uint32_t count = (uint32_t)std::min(end - offset, (size_t)64u);
+					for (uint32_t i = 0u; i < count; ++i)
+					{
+						data.mm[i] = impostors[offset + i].model_matrix;
+						data.mr[i] = impostors[offset + i].mr;
+						data.em[i] = impostors[offset + i].rect;
+					}
+					memcpy(cb->lock(), &data, sizeof(data));
+					cb->unlock();
+
+					renderer->draw(count);
+				}
+
+				begin = end;
+			}
+		}
+#endif
+
+#if !USE_RENDERABLES
+		static asset::VioletShaderHandle g_impostorShader;
+		static asset::VioletMeshHandle   g_impostorQuad;
+
+		static const char* kImpostorShader = "resources/shaders/impostor.fx";
+
+		///////////////////////////////////////////////////////////////////////////
+		static asset::VioletShaderHandle getImpostorShader()
+		{
+			if (!g_impostorShader)
+			{
+				g_impostorShader = asset::ShaderManager::getInstance()->get(Name(kImpostorShader));
+				g_impostorShader->setKeepInMemory(true);
 			}
+			return g_impostorShader;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static asset::VioletMeshHandle getImpostorQuad()
+		{
+			if (!g_impostorQuad)
+				g_impostorQuad = asset::MeshManager::getInstance()->create(Name("__impostor_quad__"), asset::Mesh::createQuad());
+			return g_impostorQuad;
 		}
 #endif
 
+		///////////////////////////////////////////////////////////////////////////
+		// Every camera and shadow face keeps its own LOD state.
+		static uint64_t getLODViewKey(entity::Entity entity, uint32_t face)
+		{
+			return ((uint64_t)entity << 3ull) | face;
+		}
+
 		CameraBatch constructCamera(Scene& scene, entity::Entity entity)
 		{
 			LMB_ASSERT(entity, "CAMERA: Camera was not valid");
@@ -393,11 +595,45 @@ namespace lambda
 			Vector<utilities::Renderable> alpha;
 			components::MeshRenderSystem::createSortedRenderList(&statics,  opaque, alpha, scene);
 			components::MeshRenderSystem::createSortedRenderList(&dynamics, opaque, alpha, scene);
+			components::MeshRenderSystem::requestTextureMips(opaque, camera_batch.projection, camera_batch.position, (float)scene.window->getSize().y);
+			components::MeshRenderSystem::requestTextureMips(alpha,  camera_batch.projection, camera_batch.position, (float)scene.window->getSize().y);
 			convertRenderableList(opaque, camera_batch.renderables);
 			convertRenderableList(alpha, camera_batch.renderables);
 #else
 			components::MeshRenderSystem::createSortedRenderList(&statics,  camera_batch.opaque, camera_batch.alpha, scene);
 			components::MeshRenderSystem::createSortedRenderList(&dynamics, camera_batch.opaque, camera_batch.alpha, scene);
+
+			components::LODSystem::View lod_view;
+			lod_view.key        = getLODViewKey(entity, 0u);
+			lod_view.projection = camera_batch.projection;
+			lod_view.position   = camera_batch.position;
+			lod_view.resolution = (float)scene.window->getSize().y;
+			lod_view.cross_fade = true;
+			lod_view.impostors  = true;
+			components::LODSystem::selectLODs(lod_view, { &camera_batch.opaque, &camera_batch.alpha }, scene);
+
+			if (scene.mesh_render.cull_clusters)
+			{
+				utilities::ClusterCulling::View cluster_view;
+				cluster_view.frustum  = &frustum;
+				cluster_view.position = camera_batch.position;
+				cluster_view.cones    = true;
+				scene.mesh_render.cluster_stats = utilities::ClusterCulling::cull(cluster_view, { &camera_batch.opaque, &camera_batch.alpha }, camera_batch.cluster_ranges);
+			}
+
+			collectImpostors(camera_batch.opaque, camera_batch.impostors);
+			collectImpostors(camera_batch.alpha,  camera_batch.impostors);
+			if (!camera_batch.impostors.empty())
+			{
+				std::sort(camera_batch.impostors.begin(), camera_batch.impostors.end(), [](const ImpostorInstance& lhs, const ImpostorInstance& rhs) {
+					return lhs.mesh.getHash() < rhs.mesh.getHash();
+				});
+				camera_batch.impostor_shader = getImpostorShader();
+				camera_batch.impostor_quad   = getImpostorQuad();
+			}
+
+			components::MeshRenderSystem::requestTextureMips(camera_batch.opaque, camera_batch.projection, camera_batch.position, (float)scene.window->getSize().y);
+			components::MeshRenderSystem::requestTextureMips(camera_batch.alpha,  camera_batch.projection, camera_batch.position, (float)scene.window->getSize().y);
 #endif
 			for (const auto& shader_pass : camera.shader_passes)
 			{
@@ -455,8 +691,9 @@ namespace lambda
 #if USE_RENDERABLES
 				renderMeshes(renderer, camera_batch.renderables, platform::RasterizerState::CullMode::kFront);
 #else
-				renderMeshes(renderer, camera_batch.opaque, platform::RasterizerState::CullMode::kFront);
-				renderMeshes(renderer, camera_batch.alpha, platform::RasterizerState::CullMode::kFront);
+				renderMeshes(renderer, camera_batch.opaque, platform::RasterizerState::CullMode::kFront, platform::BlendState::Alpha(), &camera_batch.cluster_ranges);
+				renderMeshes(renderer, camera_batch.alpha, platform::RasterizerState::CullMode::kFront, platform::BlendState::Alpha(), &camera_batch.cluster_ranges);
+				renderImpostors(renderer, camera_batch, camera_batch.shader_passes[i]);
 #endif
 			}
 
@@ -467,64 +704,268 @@ namespace lambda
 			renderer->setDepthStencilState(platform::DepthStencilState::Default());
 		}
 
-		static Map<size_t, asset::VioletShaderHandle>  g_lightShaders;
-		static Map<size_t, asset::VioletTextureHandle> g_lightTextures;
+		static Map<size_t, asset::VioletShaderHandle> g_lightShaders;
 
-		static Map<entity::Entity, void*> g_generatedOnce;
+		static const char* kShadowAtlasShader = "resources/shaders/shadow_mapping/atlas.fx";
 
-		LightBatch constructDirectional(entity::Entity entity, Scene& scene)
+		///////////////////////////////////////////////////////////////////////////
+		static asset::VioletShaderHandle getLightShader(const Name& shader_name)
 		{
-			LightBatch light_batch;
-			LightBatch::Face light_batch_face;
-			light_batch.full_screen_mesh = scene.light.full_screen_mesh;
-			light_batch.is_rh = true;
+			if (g_lightShaders.find(shader_name.getHash()) == g_lightShaders.end())
+				g_lightShaders[shader_name.getHash()] = asset::ShaderManager::getInstance()->get(shader_name);
+			return g_lightShaders[shader_name.getHash()];
+		}
 
-			auto& data = scene.light.get(entity);
+		///////////////////////////////////////////////////////////////////////////
+		static platform::BlendState shadowBlendState()
+		{
+			// Casters keep the closest depth, so the atlas does not need a depth buffer.
+			return platform::BlendState(
+				false,                                /*alpha_to_coverage*/
+				true,                                 /*blend_enabled*/
+				platform::BlendState::BlendMode::kOne /*src_blend*/,
+				platform::BlendState::BlendMode::kOne /*dest_blend*/,
+				platform::BlendState::BlendOp::kMin   /*blend_op*/,
+				platform::BlendState::BlendMode::kOne /*src_blend_alpha*/,
+				platform::BlendState::BlendMode::kOne /*dest_blend_alpha*/,
+				platform::BlendState::BlendOp::kMin   /*blend_op_alpha*/,
+				(unsigned char)platform::BlendState::WriteMode::kColourWriteEnableRGBA /*write_mask*/
+			);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static void requestShadowUpdate(const components::LightSystem::Data& data, uint32_t face, float priority, Scene& scene)
+		{
+			// Dynamic lights ask for an update every frame, a lower frequency only lowers their priority.
+			const bool dynamic = data.shadow_type == components::ShadowType::kDynamic;
+			if (dynamic)
+				priority /= (float)std::max(data.dynamic_frequency, (uint8_t)1u);
+
+			scene.shadow_atlas->requestUpdate(data.entity, face, dynamic, priority);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static void createShadowRenderList(utilities::Culler& culler, const glm::mat4x4& view, const glm::mat4x4& projection, const glm::vec3& position, const platform::ShadowAtlas::Face& slot, uint64_t lod_key, bool add_statics, bool add_dynamics, LightBatch::Face& face, Scene& scene)
+		{
+			utilities::Frustum frustum;
+			frustum.construct(projection, view);
+			culler.setCullFrequency(1u);
+
+			components::MeshRenderSystem::createRenderList(culler, frustum, scene);
+			auto statics  = culler.getStatics();
+			auto dynamics = culler.getDynamics();
+#if USE_RENDERABLES
+			if (add_statics)
+			{
+				Vector<utilities::Renderable> opaque;
+				Vector<utilities::Renderable> alpha;
+				components::MeshRenderSystem::createSortedRenderList(&statics, opaque, alpha, scene);
+				convertRenderableList(opaque, face.static_renderables);
+				convertRenderableList(alpha, face.static_renderables);
+			}
+			if (add_dynamics)
+			{
+				Vector<utilities::Renderable> opaque;
+				Vector<utilities::Renderable> alpha;
+				components::MeshRenderSystem::createSortedRenderList(&dynamics, opaque, alpha, scene);
+				convertRenderableList(opaque, face.renderables);
+				convertRenderableList(alpha, face.renderables);
+			}
+#else
+			if (add_statics)
+				components::MeshRenderSystem::createSortedRenderList(&statics, face.static_opaque, face.static_alpha, scene);
+			if (add_dynamics)
+				components::MeshRenderSystem::createSortedRenderList(&dynamics, face.opaque, face.alpha, scene);
+
+			// Shadow maps are not redrawn every frame and the statics are cached, so the levels swap at once.
+			components::LODSystem::View lod_view;
+			lod_view.key        = lod_key;
+			lod_view.projection = projection;
+			lod_view.position   = position;
+			lod_view.resolution = (float)slot.rect.w;
+			lod_view.cross_fade = false;
+			// The impostor shader only writes the G-buffer.
+			lod_view.impostors  = false;
+			components::LODSystem::selectLODs(lod_view, { &face.static_opaque, &face.static_alpha, &face.opaque, &face.alpha }, scene);
+#endif
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		// Statics are rendered into the static atlas only when the cache is stale.
+		// Every update copies the cached statics into a scratch target, adds the
+		// dynamic casters, blurs and resolves the result into the atlas slot.
+		static void constructShadowPasses(const platform::ShadowAtlas::Face& slot, const String& shadow_type, const String& shader_type, LightBatch::Face& face, Scene& scene)
+		{
+			platform::ShadowAtlas& atlas = *scene.shadow_atlas;
+			const asset::VioletShaderHandle generate = getLightShader(Name(scene.light.shader_generate + shader_type));
+			const asset::VioletShaderHandle copy     = getLightShader(Name(String(kShadowAtlasShader) + "|COPY"));
+
+			if (slot.scheduled == platform::ShadowAtlas::UpdateType::kStatic)
+			{
+				face.clear.shader = getLightShader(Name(String(kShadowAtlasShader) + "|CLEAR"));
+				face.clear.input  = {};
+				face.clear.output = { atlas.getStaticAtlas() };
+
+				face.cache.shader = generate;
+				face.cache.input  = {};
+				face.cache.output = { atlas.getStaticAtlas() };
+			}
+
+			platform::RenderTarget rt_input  = atlas.getScratch(slot.rect.z, 0u);
+			platform::RenderTarget rt_output = atlas.getScratch(slot.rect.z, 1u);
+
+			face.composite.shader = copy;
+			face.composite.input  = { atlas.getStaticAtlas() };
+			face.composite.output = { rt_input };
+
+			face.generate.shader = generate;
+			face.generate.input  = {};
+			face.generate.output = { rt_input };
+
+			// Draw all modify shaders.
+			for (uint32_t i = 0; i < scene.light.shader_modify_count; ++i)
+			{
+				SceneShaderPass modify;
+				modify.input  = { rt_input };
+				modify.output = { rt_output };
+				modify.shader = getLightShader(Name(scene.light.shader_modify + shadow_type + "HORIZONTAL"));
+				face.modify.push_back(modify);
+
+				platform::RenderTarget rt_temp = rt_input;
+				rt_input  = rt_output;
+				rt_output = rt_temp;
+
+				modify.input  = { rt_input };
+				modify.output = { rt_output };
+				modify.shader = getLightShader(Name(scene.light.shader_modify + shadow_type + "VERTICAL"));
+				face.modify.push_back(modify);
+
+				rt_temp   = rt_input;
+				rt_input  = rt_output;
+				rt_output = rt_temp;
+			}
 
-			if (data.shadow_type == components::ShadowType::kGenerateOnce)
-				data.shadow_type = (g_generatedOnce[entity] == data.depth_target[0].getTexture().get()) ? components::ShadowType::kGenerated : components::ShadowType::kGenerateOnce;
+			face.resolve.shader = copy;
+			face.resolve.input  = { rt_input };
+			face.resolve.output = { atlas.getAtlas() };
+		}
 
+		///////////////////////////////////////////////////////////////////////////
+		static void updateDirectional(components::LightSystem::Data& data, Scene& scene)
+		{
 			const glm::vec3 forward = ((glm::mat3x3)data.world_matrix) * glm::vec3(0.0f, 0.0f, -1.0f);
+			const uint32_t slot_size = scene.shadow_atlas->getSlotSize(1.0f, data.shadow_map_size_px);
 
-			const bool update = (data.shadow_type == components::ShadowType::kDynamic) ? (++data.dynamic_index >= data.dynamic_frequency) : (data.shadow_type != components::ShadowType::kGenerated);
+			// Set everything up.
+			float light_depth = data.depth.back();
+			float smh_size = data.size * 0.5f;
+			glm::vec3 translation;
+			utilities::decomposeMatrix(data.world_matrix, nullptr, nullptr, &translation);
 
-			if (data.dynamic_index >= data.dynamic_frequency)
-				data.dynamic_index = 0u;
+			// Remove shimmering
+			{
+				float texels_per_unit = (float)slot_size / data.size;
+				glm::vec3 scalar(texels_per_unit);
 
-			Vector<platform::RenderTarget> shadow_maps(data.render_target.begin(), data.render_target.end());
-			if (shadow_maps.empty())
-				shadow_maps.push_back(scene.light.default_shadow_map);
-			
-			// Setup camera.
-			//if (update)
+				glm::mat4x4 look_at = glm::lookAtRH(glm::vec3(0.0f), forward, glm::vec3(0.0f, 1.0f, 0.0f));
+				look_at *= glm::vec4(scalar, 1.0f);
+				glm::mat4x4 look_at_inv = glm::inverse(look_at);
+
+				translation   = glm::vec3(look_at * glm::vec4(translation, 1.0f));
+				translation.x = std::floorf(translation.x);
+				translation.y = std::floorf(translation.y);
+				translation   = glm::vec3(look_at_inv * glm::vec4(translation, 1.0f));
+			}
+
+			// Update matrices.
+			data.view.back()          = glm::lookAtRH(translation, translation + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+			data.view_position.back() = translation;
+			data.projection.back() = glm::orthoRH(-smh_size, smh_size, -smh_size, smh_size, -light_depth * 0.5f, light_depth * 0.5f);
+
+			if (data.shadow_type == components::ShadowType::kNone)
+				return;
+
+			if (scene.shadow_atlas->requestFace(data.entity, 0u, slot_size, data.projection.back() * data.view.back()))
+				requestShadowUpdate(data, 0u, 1.0f, scene);
+		}
+
+		static const glm::vec3 g_forwards[6u] = {
+			glm::vec3(1.0f, 0.0f, 0.0f),
+			glm::vec3(-1.0f, 0.0f, 0.0f),
+			glm::vec3(0.0f,  1.0f, 0.0f),
+			glm::vec3(0.0f, -1.0f, 0.0f),
+			glm::vec3(0.0f, 0.0f,  1.0f),
+			glm::vec3(0.0f, 0.0f, -1.0f),
+		};
+
+		static const glm::vec3 g_ups[6u] = {
+			glm::vec3(0.0f, 1.0f,  0.0f),
+			glm::vec3(0.0f, 1.0f,  0.0f),
+			glm::vec3(0.0f, 0.0f,  1.0f),
+			glm::vec3(0.0f, 0.0f, -1.0f),
+			glm::vec3(0.0f, 1.0f,  0.0f),
+			glm::vec3(0.0f, 1.0f,  0.0f),
+		};
+
+		///////////////////////////////////////////////////////////////////////////
+		static void updatePoint(components::LightSystem::Data& data, const CameraBatch& camera, Scene& scene)
+		{
+			glm::vec3 position;
+			utilities::decomposeMatrix(data.world_matrix, nullptr, nullptr, &position);
+
+			// Size the faces by how much of the screen the light covers.
+			const float radius    = data.depth.back();
+			const float distance  = std::max(glm::length(position - camera.position), radius);
+			const float coverage  = radius / distance * camera.projection[1][1];
+			const uint32_t slot_size = scene.shadow_atlas->getSlotSize(coverage, data.shadow_map_size_px);
+
+			for (uint32_t i = 0; i < 6; ++i)
 			{
 				// Set everything up.
-				float light_depth = data.depth.back();
-				float smh_size = data.size * 0.5f;
-				glm::vec3 translation;
-				utilities::decomposeMatrix(data.world_matrix, nullptr, nullptr, &translation);
+				glm::vec3 translation = position;
 
 				// Remove shimmering
 				{
-					float texels_per_unit = (float)shadow_maps.begin()->getTexture()->getLayer(0u).getWidth() / data.size;
+					float texels_per_unit = (float)slot_size / data.size;
 					glm::vec3 scalar(texels_per_unit);
 
-					glm::mat4x4 look_at = glm::lookAtRH(glm::vec3(0.0f), forward, glm::vec3(0.0f, 1.0f, 0.0f));
+					glm::mat4x4 look_at = glm::lookAtRH(glm::vec3(0.0f), g_forwards[i], glm::vec3(0.0f, 1.0f, 0.0f));
 					look_at *= glm::vec4(scalar, 1.0f);
 					glm::mat4x4 look_at_inv = glm::inverse(look_at);
 
-					translation   = glm::vec3(look_at * glm::vec4(translation, 1.0f));
+					translation = glm::vec3(look_at * glm::vec4(translation, 1.0f));
 					translation.x = std::floorf(translation.x);
 					translation.y = std::floorf(translation.y);
-					translation   = glm::vec3(look_at_inv * glm::vec4(translation, 1.0f));
+					translation = glm::vec3(look_at_inv * glm::vec4(translation, 1.0f));
 				}
 
-				// Update matrices.
-				data.view.back()          = glm::lookAtRH(translation, translation + forward, glm::vec3(0.0f, 1.0f, 0.0f));
-				data.view_position.back() = translation;
-				data.projection.back() = glm::orthoRH(-smh_size, smh_size, -smh_size, smh_size, -light_depth * 0.5f, light_depth * 0.5f);
+				data.view[i] = glm::lookAtLH(glm::vec3(0.0f), g_forwards[i], g_ups[i]), glm::vec3(-1.0f, 1.0f, 1.0f);
+				if (i == 2 || i == 3)   data.view[i] = glm::rotate(data.view[i], 1.5708f * 2.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+				data.view[i] = glm::translate(data.view[i], -translation);
+				data.view_position[i] = translation;
+				data.projection[i] = glm::perspectiveLH(1.5708f, 1.0f, 0.001f, data.depth[i]); // 1.5708f radians == 90 degrees.
 			}
 
+			if (data.shadow_type == components::ShadowType::kNone)
+				return;
+
+			for (uint32_t i = 0; i < 6; ++i)
+				if (scene.shadow_atlas->requestFace(data.entity, i, slot_size, data.projection[i] * data.view[i]))
+					requestShadowUpdate(data, i, coverage, scene);
+		}
+
+		LightBatch constructDirectional(entity::Entity entity, Scene& scene)
+		{
+			LightBatch light_batch;
+			LightBatch::Face light_batch_face;
+			light_batch.full_screen_mesh = scene.light.full_screen_mesh;
+			light_batch.is_rh = true;
+			light_batch.publish_user_data = { glm::vec4(1.0f / (float)scene.shadow_atlas->getSize()) };
+
+			auto& data = scene.light.get(entity);
+
+			const glm::vec3 forward = ((glm::mat3x3)data.world_matrix) * glm::vec3(0.0f, 0.0f, -1.0f);
+
 			// Shader variables.
 			light_batch_face.view_projection = data.projection.back() * data.view.back();
 			light_batch_face.direction = -forward;
@@ -534,125 +975,41 @@ namespace lambda
 			light_batch.near = 0.0f;
 			light_batch.far = data.depth.back();
 
+			const platform::ShadowAtlas::Face* slot = (data.shadow_type == components::ShadowType::kNone) ? nullptr : scene.shadow_atlas->getFace(entity, 0u);
+			// A slot that is neither rendered nor scheduled this frame still holds what its previous owner left in it.
+			if (slot != nullptr && !slot->content_valid)
+				slot = nullptr;
 
-			String shadow_type = data.shadow_type == components::ShadowType::kNone ? "|NO_" : ("|" + scene.light.shader_shadow_type + "_");
+			String shadow_type = slot == nullptr ? "|NO_" : ("|" + scene.light.shader_shadow_type + "_");
 			String shader_type = shadow_type + "DIRECTIONAL";
 
-			// Generate shadow maps.
-			if (update && data.shadow_type != components::ShadowType::kNone)
+			if (slot)
 			{
-				if (data.shadow_type == components::ShadowType::kGenerateOnce)
-				{
-					g_generatedOnce[entity] = data.depth_target[0].getTexture().get();
-					data.shadow_type = components::ShadowType::kGenerated;
-				}
-
-				const platform::RenderTarget depth_map = data.depth_target.at(0u);
-				Vector<platform::RenderTarget> output = shadow_maps;
-				output.push_back(depth_map);
-
-				for (const auto& shadow_map : shadow_maps)
-					light_batch.clear_queue_texture.push_back(shadow_map);
-				light_batch.clear_queue_depth.push_back(depth_map);
+				light_batch_face.atlas_rect = slot->uv_rect;
+				light_batch_face.viewport   = glm::vec4(slot->rect);
 
-				Name shader_name(scene.light.shader_generate + shader_type);
-				if (g_lightShaders.find(shader_name.getHash()) == g_lightShaders.end())
-					g_lightShaders[shader_name.getHash()] = asset::ShaderManager::getInstance()->get(shader_name);
-				light_batch_face.generate.shader = g_lightShaders[shader_name.getHash()];
-
-				light_batch_face.generate.input  = {};
-				light_batch_face.generate.output = output;
-				
-				for (const auto& o : output)
-					g_lightTextures[o.getTexture().getHash()] = o.getTexture();
-
-				// Handle frustum culling.
-				if (data.shadow_type == components::ShadowType::kDynamic)
-					data.culler.back().setCullFrequency(data.dynamic_frequency);
-				else
-					data.culler.back().setCullFrequency(1u);
-
-				utilities::Frustum frustum;
-				frustum.construct(data.projection.back(), data.view.back());
-
-				components::MeshRenderSystem::createRenderList(data.culler.back(), frustum, scene);
-				auto statics = data.culler.back().getStatics();
-				auto dynamics = data.culler.back().getDynamics();
-#if USE_RENDERABLES
-				Vector<utilities::Renderable> opaque;
-				Vector<utilities::Renderable> alpha;
-				components::MeshRenderSystem::createSortedRenderList(&statics, opaque, alpha, scene);
-				components::MeshRenderSystem::createSortedRenderList(&dynamics, opaque, alpha, scene);
-				convertRenderableList(opaque, light_batch_face.renderables);
-				convertRenderableList(alpha, light_batch_face.renderables);
-#else
-				components::MeshRenderSystem::createSortedRenderList(&statics, light_batch_face.opaque, light_batch_face.alpha, scene);
-				components::MeshRenderSystem::createSortedRenderList(&dynamics, light_batch_face.opaque, light_batch_face.alpha, scene);
-#endif
+				// Generate shadow maps.
+				if (slot->scheduled != platform::ShadowAtlas::UpdateType::kNone)
+				{
+					const bool add_statics  = slot->scheduled == platform::ShadowAtlas::UpdateType::kStatic;
+					const bool add_dynamics = data.shadow_type == components::ShadowType::kDynamic;
+					createShadowRenderList(data.culler.back(), data.view.back(), data.projection.back(), light_batch.position, *slot, getLODViewKey(entity, 0u), add_statics, add_dynamics, light_batch_face, scene);
+					constructShadowPasses(*slot, shadow_type, shader_type, light_batch_face, scene);
 
-				String config = "__temp_target_" + toString(shadow_maps.at(0u).getTexture()->getLayer(0).getWidth()) + "_" + toString(shadow_maps.at(0u).getTexture()->getLayer(0).getHeight()) + "__";
-				asset::VioletTextureHandle temp = asset::TextureManager::getInstance()->create(Name(config),
-					shadow_maps.at(0u).getTexture()->getLayer(0).getWidth(),
-					shadow_maps.at(0u).getTexture()->getLayer(0).getHeight(),
-					1,
-					shadow_maps.at(0u).getTexture()->getLayer(0).getFormat(),
-					shadow_maps.at(0u).getTexture()->getLayer(0).getFlags()
-				);
-				temp->setKeepInMemory(true);
-
-				platform::RenderTarget rt_input = shadow_maps.at(0u);
-				platform::RenderTarget rt_output(config, temp);
-				g_lightTextures[rt_input.getTexture().getHash()] = rt_input.getTexture();
-				g_lightTextures[rt_output.getTexture().getHash()] = rt_output.getTexture();
-
-				// Draw all modify shaders.
-				for (uint32_t i = 0; i < scene.light.shader_modify_count; ++i)
-				 {
-					SceneShaderPass modify;
-					modify.input  = { rt_input };
-					modify.output = { rt_output };
-					
-					Name shader_name(scene.light.shader_modify + shadow_type + "HORIZONTAL");
-					if (g_lightShaders.find(shader_name.getHash()) == g_lightShaders.end())
-						g_lightShaders[shader_name.getHash()] = asset::ShaderManager::getInstance()->get(shader_name);
-					modify.shader = g_lightShaders[shader_name.getHash()];
-
-					light_batch_face.modify.push_back(modify);
-					platform::RenderTarget rt_temp = rt_input;
-					rt_input = rt_output;
-					rt_output = rt_temp;
-					modify.input = { rt_input };
-					modify.output = { rt_output };
-					
-					shader_name = Name(scene.light.shader_modify + shadow_type + "VERTICAL");
-					if (g_lightShaders.find(shader_name.getHash()) == g_lightShaders.end())
-						g_lightShaders[shader_name.getHash()] = asset::ShaderManager::getInstance()->get(shader_name);
-					modify.shader = g_lightShaders[shader_name.getHash()];
-
-					light_batch_face.modify.push_back(modify);
-					rt_temp = rt_input;
-					rt_input = rt_output;
-					rt_output = rt_temp;
+					if (data.shadow_type == components::ShadowType::kGenerateOnce)
+						data.shadow_type = components::ShadowType::kGenerated;
 				}
 			}
 
 			// Render light using the shadow map.
-			Vector<platform::RenderTarget> input = {
-				shadow_maps.at(0u),
+			light_batch.publish.shader = getLightShader(Name(scene.light.shader_publish + shader_type));
+			light_batch.publish.input  = {
+				slot ? scene.shadow_atlas->getAtlas() : scene.light.default_shadow_map,
 				platform::RenderTarget(Name("texture"), data.texture),
 				scene.post_process_manager->getTarget(Name("position")),
 				scene.post_process_manager->getTarget(Name("normal")),
 				scene.post_process_manager->getTarget(Name("metallic_roughness"))
 			};
-			if (shadow_maps.size() > 1u)
-				input.insert(input.end(), shadow_maps.begin() + 1u, shadow_maps.end());
-
-			Name shader_name(scene.light.shader_publish + shader_type);
-			if (g_lightShaders.find(shader_name.getHash()) == g_lightShaders.end())
-				g_lightShaders[shader_name.getHash()] = asset::ShaderManager::getInstance()->get(shader_name);
-			light_batch.publish.shader = g_lightShaders[shader_name.getHash()];
-
-			light_batch.publish.input  = input;
 			light_batch.publish.output = { scene.post_process_manager->getTarget(Name("light_map")) };
 
 			light_batch.faces.push_back(light_batch_face);
@@ -665,246 +1022,63 @@ namespace lambda
 			LightBatch::Face light_batch_faces[6];
 			light_batch.full_screen_mesh = scene.light.full_screen_mesh;
 			light_batch.is_rh = false;
+			light_batch.publish_user_data = { glm::vec4(1.0f / (float)scene.shadow_atlas->getSize()) };
 
 			auto& data = scene.light.get(entity);
 
-			if (data.shadow_type == components::ShadowType::kGenerateOnce)
-				data.shadow_type = (g_generatedOnce[entity] == data.depth_target[0].getTexture().get()) ? components::ShadowType::kGenerated : components::ShadowType::kGenerateOnce;
-
-			static const glm::vec3 g_forwards[6u] = {
-				glm::vec3(1.0f, 0.0f, 0.0f),
-				glm::vec3(-1.0f, 0.0f, 0.0f),
-				glm::vec3(0.0f,  1.0f, 0.0f),
-				glm::vec3(0.0f, -1.0f, 0.0f),
-				glm::vec3(0.0f, 0.0f,  1.0f),
-				glm::vec3(0.0f, 0.0f, -1.0f),
-			};
-
-			static const glm::vec3 g_ups[6u] = {
-				glm::vec3(0.0f, 1.0f,  0.0f),
-				glm::vec3(0.0f, 1.0f,  0.0f),
-				glm::vec3(0.0f, 0.0f,  1.0f),
-				glm::vec3(0.0f, 0.0f, -1.0f),
-				glm::vec3(0.0f, 1.0f,  0.0f),
-				glm::vec3(0.0f, 1.0f,  0.0f),
-			};
-
-			platform::RenderTarget shadow_map = (data.render_target.empty()) ? scene.light.default_shadow_map : data.render_target.at(0u);
-			const bool update = (data.shadow_type == components::ShadowType::kDynamic) ? (++data.dynamic_index >= data.dynamic_frequency) : (data.shadow_type != components::ShadowType::kGenerated);
-
-			if (data.dynamic_index >= data.dynamic_frequency)
-				data.dynamic_index = 0u;
-
-			// Setup camera.
-			//if (update)
-			{
-				for (uint32_t i = 0; i < 6; ++i)
-				{
-					// Set everything up.
-					glm::vec3 translation;
-					utilities::decomposeMatrix(data.world_matrix, nullptr, nullptr, &translation);
-
-					auto view_size = data.view.size();
-					auto view_position_size = data.view_position.size();
-					auto projection_size = data.projection.size();
-
-					// Remove shimmering
-					{
-						float texels_per_unit = (float)shadow_map.getTexture()->getLayer(0u).getWidth() / data.size;
-						glm::vec3 scalar(texels_per_unit);
-
-						glm::mat4x4 look_at = glm::lookAtRH(glm::vec3(0.0f), g_forwards[i], glm::vec3(0.0f, 1.0f, 0.0f));
-						look_at *= glm::vec4(scalar, 1.0f);
-						glm::mat4x4 look_at_inv = glm::inverse(look_at);
-
-						translation = glm::vec3(look_at * glm::vec4(translation, 1.0f));
-						translation.x = std::floorf(translation.x);
-						translation.y = std::floorf(translation.y);
-						translation = glm::vec3(look_at_inv * glm::vec4(translation, 1.0f));
-					}
-
-					data.view[i] = glm::lookAtLH(glm::vec3(0.0f), g_forwards[i], g_ups[i]), glm::vec3(-1.0f, 1.0f, 1.0f);
-					if (i == 2 || i == 3)   data.view[i] = glm::rotate(data.view[i], 1.5708f * 2.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-					data.view[i] = glm::translate(data.view[i], -translation);
-					data.view_position[i] = translation;
-					data.projection[i] = glm::perspectiveLH(1.5708f, 1.0f, 0.001f, data.depth[i]); // 1.5708f radians == 90 degrees.
-				}
-			}
-
-
 			// Shader variables.
 			light_batch.position = data.view_position.back();
 			light_batch.colour = data.colour * data.intensity;
 			light_batch.near = 0.0f;
 			light_batch.far = data.depth.back();
 
-			String shadow_type = data.shadow_type == components::ShadowType::kNone ? "|NO_" : ("|" + scene.light.shader_shadow_type + "_");
+			// Faces are only rendered when all of them got a slot.
+			const platform::ShadowAtlas::Face* slots[6] = {};
+			bool has_slots = data.shadow_type != components::ShadowType::kNone;
+			for (uint32_t i = 0; i < 6 && has_slots; ++i)
+			{
+				slots[i] = scene.shadow_atlas->getFace(entity, i);
+				has_slots = slots[i] != nullptr;
+			}
+
+			// Shadows are only used once every face is rendered or scheduled this
+			// frame, until then some slots hold what their previous owner left.
+			bool has_shadows = has_slots;
+			for (uint32_t i = 0; i < 6 && has_shadows; ++i)
+				has_shadows = slots[i]->content_valid;
+
+			String shadow_type = !has_slots ? "|NO_" : ("|" + scene.light.shader_shadow_type + "_");
 			String shader_type = shadow_type + "POINT";
 
+			bool updated = false;
 			for (uint32_t i = 0; i < 6; ++i)
 			{
 				light_batch_faces[i].view_projection = data.projection[i] * data.view[i];
 				light_batch_faces[i].direction = -g_forwards[i];
-			}
-
-			// Generate shadow maps.
-			if (update && data.shadow_type != components::ShadowType::kNone)
-			{
-				bool statics_only = (data.shadow_type == components::ShadowType::kGenerateOnce);
 
-				if (data.shadow_type == components::ShadowType::kGenerateOnce)
-				{
-					g_generatedOnce[entity] = data.depth_target[0].getTexture().get();
-					data.shadow_type = components::ShadowType::kGenerated;
-				}
-
-				// Clear the shadow map.
-				platform::RenderTarget depth_map = data.depth_target.at(0u);
-				light_batch.clear_queue_texture.push_back(shadow_map);
-				light_batch.clear_queue_depth.push_back(depth_map);
+				if (!has_slots)
+					continue;
 
-				g_lightTextures[depth_map.getTexture().getHash()]  = depth_map.getTexture();
-				g_lightTextures[shadow_map.getTexture().getHash()] = shadow_map.getTexture();
+				light_batch_faces[i].atlas_rect = slots[i]->uv_rect;
+				light_batch_faces[i].viewport   = glm::vec4(slots[i]->rect);
 
-				for (uint32_t i = 0; i < 6; ++i)
+				// Generate shadow maps.
+				if (slots[i]->scheduled != platform::ShadowAtlas::UpdateType::kNone)
 				{
-					// Render to the shadow map.
-					shadow_map.setLayer(i);
-					depth_map.setLayer(i);
-
-					Name shader_name(scene.light.shader_generate + shader_type);
-					if (g_lightShaders.find(shader_name.getHash()) == g_lightShaders.end())
-						g_lightShaders[shader_name.getHash()] = asset::ShaderManager::getInstance()->get(shader_name);
-					light_batch_faces[i].generate.shader = g_lightShaders[shader_name.getHash()];
-
-					light_batch_faces[i].generate.input = {};
-					light_batch_faces[i].generate.output = { shadow_map, depth_map };
-
-					// Handle frustum culling.
-					if (data.shadow_type == components::ShadowType::kDynamic)
-						data.culler[i].setCullFrequency(std::max(1u, 10u / data.dynamic_frequency));
-					else
-						data.culler[i].setCullFrequency(1u);
-					utilities::Frustum frustum;
-					frustum.construct(data.projection[i], data.view[i]);
-
-					// Render to the shadow map.
-					if (statics_only)
-					{
-						components::MeshRenderSystem::createRenderList(data.culler.back(), frustum, scene);
-						auto statics = data.culler.back().getStatics();
-#if USE_RENDERABLES
-						Vector<utilities::Renderable> opaque;
-						Vector<utilities::Renderable> alpha;
-						components::MeshRenderSystem::createSortedRenderList(&statics, opaque, alpha, scene);
-						convertRenderableList(opaque, light_batch_faces[i].renderables);
-						convertRenderableList(alpha, light_batch_faces[i].renderables);
-#else
-						components::MeshRenderSystem::createSortedRenderList(&statics, light_batch_faces[i].opaque, light_batch_faces[i].alpha, scene);
-#endif
-					}
-					else
-					{
-						components::MeshRenderSystem::createRenderList(data.culler.back(), frustum, scene);
-						auto statics = data.culler.back().getStatics();
-						auto dynamics = data.culler.back().getDynamics();
-#if USE_RENDERABLES
-						Vector<utilities::Renderable> opaque;
-						Vector<utilities::Renderable> alpha;
-						components::MeshRenderSystem::createSortedRenderList(&statics, opaque, alpha, scene);
-						components::MeshRenderSystem::createSortedRenderList(&dynamics, opaque, alpha, scene);
-						convertRenderableList(opaque, light_batch_faces[i].renderables);
-						convertRenderableList(alpha, light_batch_faces[i].renderables);
-#else
-						components::MeshRenderSystem::createSortedRenderList(&statics, light_batch_faces[i].opaque, light_batch_faces[i].alpha, scene);
-						components::MeshRenderSystem::createSortedRenderList(&dynamics, light_batch_faces[i].opaque, light_batch_faces[i].alpha, scene);
-#endif
-					}
-
-					String config1 = "__temp_target_cube1_" + toString(shadow_map.getTexture()->getLayer(0).getWidth()) + "_" + toString(shadow_map.getTexture()->getLayer(0).getHeight()) + "__";
-					asset::VioletTextureHandle temp1 = asset::TextureManager::getInstance()->create(Name(config1),
-						shadow_map.getTexture()->getLayer(0).getWidth(),
-						shadow_map.getTexture()->getLayer(0).getHeight(),
-						1,
-						shadow_map.getTexture()->getLayer(0).getFormat(),
-						shadow_map.getTexture()->getLayer(0).getFlags()
-					);
-					temp1->setKeepInMemory(true);
-
-					String config2 = "__temp_target_cube2_" + toString(shadow_map.getTexture()->getLayer(0).getWidth()) + "_" + toString(shadow_map.getTexture()->getLayer(0).getHeight()) + "__";
-					asset::VioletTextureHandle temp2 = asset::TextureManager::getInstance()->create(Name(config2),
-						shadow_map.getTexture()->getLayer(0).getWidth(),
-						shadow_map.getTexture()->getLayer(0).getHeight(),
-						1,
-						shadow_map.getTexture()->getLayer(0).getFormat(),
-						shadow_map.getTexture()->getLayer(0).getFlags()
-					);
-					temp2->setKeepInMemory(true);
-
-					platform::RenderTarget rt_input = shadow_map;
-					platform::RenderTarget rt_temp1(config1, temp1);
-					platform::RenderTarget rt_temp2(config2, temp2);
-					platform::RenderTarget rt_output = rt_temp1;
-					rt_input.setLayer(i);
-					g_lightTextures[rt_input.getTexture().getHash()] = rt_input.getTexture();
-					g_lightTextures[rt_temp1.getTexture().getHash()] = rt_temp1.getTexture();
-					g_lightTextures[rt_temp2.getTexture().getHash()] = rt_temp2.getTexture();
-
-					// Draw all modify shaders.
-					for (uint32_t j = 0; j < scene.light.shader_modify_count; ++j)
-					{
-						SceneShaderPass modify;
-						modify.input = { rt_input };
-						modify.output = { rt_output };
-
-						Name shader_name(scene.light.shader_modify + shadow_type + "HORIZONTAL" + (rt_input.getTexture() == shadow_map.getTexture() ? "_CUBE" : ""));
-						if (g_lightShaders.find(shader_name.getHash()) == g_lightShaders.end())
-							g_lightShaders[shader_name.getHash()] = asset::ShaderManager::getInstance()->get(shader_name);
-						modify.shader = g_lightShaders[shader_name.getHash()];
-
-						light_batch_faces[i].modify.push_back(modify);
-						
-						rt_input  = rt_output;
-						rt_output = rt_output.getTexture() == rt_temp1.getTexture() ? rt_temp2 : rt_temp1;
-
-						modify.input = { rt_input };
-						modify.output = { rt_output };
-
-						shader_name = Name(scene.light.shader_modify + shadow_type + "VERTICAL");
-						if (g_lightShaders.find(shader_name.getHash()) == g_lightShaders.end())
-							g_lightShaders[shader_name.getHash()] = asset::ShaderManager::getInstance()->get(shader_name);
-						modify.shader = g_lightShaders[shader_name.getHash()];
-
-						light_batch_faces[i].modify.push_back(modify);
-						auto rt_temp = rt_input;
-						rt_input = rt_output;
-						rt_output = rt_temp;
-					}
-
-					if (scene.light.shader_modify_count > 0)
-					{
-						SceneShaderPass modify;
-						modify.input = { rt_output };
-						modify.output = { shadow_map };
-						shader_name = Name(scene.light.shader_modify + "|CUBE");
-						if (g_lightShaders.find(shader_name.getHash()) == g_lightShaders.end())
-							g_lightShaders[shader_name.getHash()] = asset::ShaderManager::getInstance()->get(shader_name);
-						modify.shader = g_lightShaders[shader_name.getHash()];
-						light_batch_faces[i].modify.push_back(modify);
-					}
+					const bool add_statics  = slots[i]->scheduled == platform::ShadowAtlas::UpdateType::kStatic;
+					const bool add_dynamics = data.shadow_type == components::ShadowType::kDynamic;
+					createShadowRenderList(data.culler[i], data.view[i], data.projection[i], light_batch.position, *slots[i], getLODViewKey(entity, i), add_statics, add_dynamics, light_batch_faces[i], scene);
+					constructShadowPasses(*slots[i], shadow_type, shader_type, light_batch_faces[i], scene);
+					updated = true;
 				}
-
-				shadow_map.setLayer(-1);
-				depth_map.setLayer(-1);
 			}
 
-			Name shader_name(scene.light.shader_publish + shader_type);
-			if (g_lightShaders.find(shader_name.getHash()) == g_lightShaders.end())
-				g_lightShaders[shader_name.getHash()] = asset::ShaderManager::getInstance()->get(shader_name);
-			light_batch.publish.shader = g_lightShaders[shader_name.getHash()];
+			if (updated && data.shadow_type == components::ShadowType::kGenerateOnce)
+				data.shadow_type = components::ShadowType::kGenerated;
 
+			light_batch.publish.shader = getLightShader(Name(scene.light.shader_publish + (has_shadows ? shader_type : String("|NO_POINT"))));
 			light_batch.publish.input  = {
-				shadow_map,
+				has_shadows ? scene.shadow_atlas->getAtlas() : scene.light.default_shadow_map,
 				platform::RenderTarget(Name("texture"), data.texture),
 				scene.post_process_manager->getTarget(Name("position")),
 				scene.post_process_manager->getTarget(Name("normal")),
@@ -918,6 +1092,34 @@ namespace lambda
 			return light_batch;
 		}
 
+		LightBatch constructClusters(const CameraBatch& camera, const Vector<platform::LightClusters::Light>& lights, Scene& scene)
+		{
+			platform::LightClusters& clusters = *scene.light_clusters;
+			clusters.setProjection(camera.projection, camera.near, camera.far);
+			clusters.build(camera.view, lights);
+			clusters.upload();
+
+			LightBatch light_batch;
+			light_batch.full_screen_mesh = scene.light.full_screen_mesh;
+			light_batch.is_rh = true;
+			light_batch.near = camera.near;
+			light_batch.far = camera.far;
+			light_batch.publish_user_data = { clusters.getGridParams(), clusters.getDepthParams() };
+
+			light_batch.publish.shader = getLightShader(Name("resources/shaders/clustered_lighting.fx"));
+			light_batch.publish.input  = {
+				scene.post_process_manager->getTarget(Name("position")),
+				scene.post_process_manager->getTarget(Name("normal")),
+				scene.post_process_manager->getTarget(Name("metallic_roughness")),
+				clusters.getClusterTarget(),
+				clusters.getIndexTarget(),
+				clusters.getLightTarget()
+			};
+			light_batch.publish.output = { scene.post_process_manager->getTarget(Name("light_map")) };
+
+			return light_batch;
+		}
+
 		Vector<LightBatch> constructLight(const CameraBatch& camera, Scene& scene)
 		{
 			Vector<LightBatch> light_batches;
@@ -925,6 +1127,8 @@ namespace lambda
 			utilities::Frustum frustum;
 			frustum.construct(camera.projection, camera.view);
 
+			Vector<components::LightSystem::Data*> lights;
+			Vector<platform::LightClusters::Light> clustered_lights;
 			for (auto& data : scene.light.data)
 			{
 				bool enabled = data.enabled;
@@ -944,26 +1148,67 @@ namespace lambda
 					}
 				}
 
-				if (enabled)
+				if (!enabled)
+					continue;
+
+				// Unshadowed point lights are shaded together in one clustered pass.
+				if (data.type == components::LightType::kPoint && data.shadow_type == components::ShadowType::kNone)
 				{
-					switch (data.type)
-					{
-					case components::LightType::kDirectional:
-						light_batches.push_back(constructDirectional(data.entity, scene));
-						break;
-					case components::LightType::kSpot:
-						//constructSpot(data.entity, scene, light_batches);
-						break;
-					case components::LightType::kPoint:
-						light_batches.push_back(constructPoint(data.entity, scene));
-						break;
-					case components::LightType::kCascade:
-						//constructCascade(data.entity, scene, light_batches);
-						break;
-					}
+					glm::vec3 position;
+					utilities::decomposeMatrix(data.world_matrix, nullptr, nullptr, &position);
+
+					platform::LightClusters::Light light;
+					light.position = position;
+					light.radius   = data.depth.back();
+					light.colour   = data.colour * data.intensity;
+					light.padding  = 0.0f;
+					clustered_lights.push_back(light);
+					continue;
 				}
+
+				lights.push_back(&data);
 			}
 
+			// Decide which shadow map faces get rendered this frame.
+			scene.shadow_atlas->beginFrame();
+			for (auto* data : lights)
+			{
+				switch (data->type)
+				{
+				case components::LightType::kDirectional:
+					updateDirectional(*data, scene);
+					break;
+				case components::LightType::kPoint:
+					updatePoint(*data, camera, scene);
+					break;
+				default:
+					break;
+				}
+			}
+			scene.shadow_atlas->schedule();
+
+			for (auto* data : lights)
+			{
+				switch (data->type)
+				{
+				case components::LightType::kDirectional:
+					light_batches.push_back(constructDirectional(data->entity, scene));
+					break;
+				case components::LightType::kSpot:
+					//constructSpot(data->entity, scene, light_batches);
+					break;
+				case components::LightType::kPoint:
+					light_batches.push_back(constructPoint(data->entity, scene));
+					break;
+				case components::LightType::kCascade:
+					//constructCascade(data->entity, scene, light_batches);
+					break;
+				}
+			}
+
+			if (!clustered_lights.empty())
+				light_batches.push_back(constructClusters(camera, clustered_lights, scene));
+
 			for (auto& it : g_lightShaders)
 				it.second->setKeepInMemory(true);
 
@@ -972,7 +1217,9 @@ namespace lambda
 
 		void renderLight(platform::IRenderer* renderer, platform::PostProcessManager& post_process_manager, const LightBatch* light_batches, uint32_t light_batch_count)
 		{
-			renderer->beginTimer("Lighting");
+			// Shadows render at the resolution of their atlas slot, not at the dynamic
+			// resolution, so they are timed on their own.
+			renderer->beginTimer("Shadow Atlas");
 
 			struct CBData
 			{
@@ -984,66 +1231,93 @@ namespace lambda
 				glm::vec3 light_colour;
 				float     light_cut_off;
 				float     light_outer_cut_off;
-
+				float     light_padding[3];
+				glm::vec4 light_atlas_rect;
+				glm::mat4x4 light_face_view_projection_matrix[6];
+				glm::vec4 light_face_atlas_rect[6];
 			} data;
 
 			platform::IRenderBuffer* cb = renderer->allocRenderBuffer(sizeof(data), platform::IRenderBuffer::kFlagConstant | platform::IRenderBuffer::kFlagTransient | platform::IRenderBuffer::kFlagDynamic, &data);
 			renderer->setConstantBuffer(cb, cbPerLightIdx);
 
+			const platform::BlendState shadow_blend_state = shadowBlendState();
 
-			// Prepare the light buffer.
-			renderer->pushMarker("Clear Light Buffer");
-			renderer->clearRenderTarget(
-				post_process_manager.getTarget(Name("light_map")).getTexture(),
-				glm::vec4(0.0f)
-			);
-			renderer->popMarker();
+			// Fills the constant buffer of the light, face is the one the single face values come from.
+			const auto setLightData = [&](const LightBatch& light_batch, uint8_t face) {
+				memset(&data, 0, sizeof(data));
+				data.light_position = light_batch.position;
+				data.light_near     = light_batch.near;
+				data.light_far      = light_batch.far;
+				data.light_colour   = light_batch.colour;
+				for (uint32_t f = 0u; f < light_batch.faces.size() && f < 6u; ++f)
+				{
+					data.light_face_view_projection_matrix[f] = light_batch.faces[f].view_projection;
+					data.light_face_atlas_rect[f]             = light_batch.faces[f].atlas_rect;
+				}
+				if (face < light_batch.faces.size())
+				{
+					data.light_view_projection_matrix = light_batch.faces[face].view_projection;
+					data.light_direction              = light_batch.faces[face].direction;
+					data.light_atlas_rect             = light_batch.faces[face].atlas_rect;
+				}
+				memcpy(cb->lock(), &data, sizeof(data));
+				cb->unlock();
+			};
 
 			for (uint32_t i = 0; i < light_batch_count; ++i)
 			{
 				renderer->pushMarker("Light");
 
-				platform::IRenderBuffer* last_cb = nullptr;
-
 				const auto& light_batch = light_batches[i];
-
-				renderer->pushMarker("Clear");
-				for (const auto& to_clear : light_batch.clear_queue_depth)
-					renderer->clearRenderTarget(to_clear.getTexture(), glm::vec4(1.0f));
-
-				for (const auto& to_clear : light_batch.clear_queue_texture)
-					renderer->clearRenderTarget(to_clear.getTexture(), glm::vec4(FLT_MAX));
-				renderer->popMarker();
-
 				for (uint8_t f = 0u; f < light_batch.faces.size(); ++f)
 				{
 					const auto& face = light_batch.faces[f];
-					data = {
-						face.view_projection,
-						light_batch.position,
-						light_batch.near,
-						face.direction,
-						light_batch.far,
-						light_batch.colour,
-						0.0f,
-						0.0f
-					};
-					memcpy(cb->lock(), &data, sizeof(data));
-					cb->unlock();
-
-					renderer->setUserData(glm::vec4(f, 0.0f, 0.0f, 0.0f), 0);
-
-					// Generate shadow maps.
 					if (face.generate.shader)
 					{
+						setLightData(light_batch, f);
+						renderer->setUserData(glm::vec4(f, 0.0f, 0.0f, 0.0f), 0);
+
+						// Generate shadow maps.
 						renderer->pushMarker("Generate");
-						renderer->bindShaderPass(platform::ShaderPass(Name(""), face.generate.shader, face.generate.input, face.generate.output));
 
+						// Refresh the cached static casters.
+						if (face.cache.shader)
+						{
+							renderer->setMesh(light_batch.full_screen_mesh);
+							renderer->setSubMesh(0u);
+							renderer->setRasterizerState(platform::RasterizerState::SolidBack());
+							renderer->setBlendState(platform::BlendState::Default());
+							renderer->bindShaderPass(platform::ShaderPass(Name(""), face.clear.shader, face.clear.input, face.clear.output));
+							renderer->setViewports({ face.viewport });
+							renderer->setScissorRects({ face.viewport });
+							renderer->draw();
+
+							renderer->bindShaderPass(platform::ShaderPass(Name(""), face.cache.shader, face.cache.input, face.cache.output));
+							renderer->setViewports({ face.viewport });
+							renderer->setScissorRects({ face.viewport });
 #if USE_RENDERABLES
-						renderMeshes(renderer, face.renderables, platform::RasterizerState::CullMode::kNone);
+							renderMeshes(renderer, face.static_renderables, platform::RasterizerState::CullMode::kNone, shadow_blend_state);
 #else
-						renderMeshes(renderer, face.alpha, platform::RasterizerState::CullMode::kNone);
-						renderMeshes(renderer, face.opaque, platform::RasterizerState::CullMode::kNone);
+							renderMeshes(renderer, face.static_alpha, platform::RasterizerState::CullMode::kNone, shadow_blend_state);
+							renderMeshes(renderer, face.static_opaque, platform::RasterizerState::CullMode::kNone, shadow_blend_state);
+#endif
+						}
+
+						// Start from the cached statics and add the dynamic casters.
+						renderer->setMesh(light_batch.full_screen_mesh);
+						renderer->setSubMesh(0u);
+						renderer->setRasterizerState(platform::RasterizerState::SolidBack());
+						renderer->setBlendState(platform::BlendState::Default());
+						renderer->bindShaderPass(platform::ShaderPass(Name(""), face.composite.shader, face.composite.input, face.composite.output));
+						renderer->setUserData(face.atlas_rect, 1);
+						renderer->draw();
+
+						renderer->bindShaderPass(platform::ShaderPass(Name(""), face.generate.shader, face.generate.input, face.generate.output));
+#if USE_RENDERABLES
+						renderMeshes(renderer, face.renderables, platform::RasterizerState::CullMode::kNone, shadow_blend_state);
+#else
+						renderMeshes(renderer, face.alpha, platform::RasterizerState::CullMode::kNone, shadow_blend_state);
+						renderMeshes(renderer, face.opaque, platform::RasterizerState::CullMode::kNone, shadow_blend_state);
 #endif
 						renderer->popMarker();
 
@@ -1061,9 +1335,41 @@ namespace lambda
 							renderer->draw();
 						}
 						renderer->popMarker();
+
+						renderer->pushMarker("Resolve");
+						renderer->setBlendState(platform::BlendState::Default());
+						renderer->bindShaderPass(platform::ShaderPass(Name(""), face.resolve.shader, face.resolve.input, face.resolve.output));
+						renderer->setViewports({ face.viewport });
+						renderer->setScissorRects({ face.viewport });
+						renderer->setUserData(glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), 1);
+						renderer->draw();
+						renderer->popMarker();
 					}
 				}
 
+				renderer->popMarker();
+			}
+
+			renderer->endTimer("Shadow Atlas");
+			renderer->beginTimer("Lighting");
+
+			// Prepare the light buffer.
+			renderer->pushMarker("Clear Light Buffer");
+			renderer->clearRenderTarget(
+				post_process_manager.getTarget(Name("light_map")).getTexture(),
+				glm::vec4(0.0f)
+			);
+			renderer->popMarker();
+
+			for (uint32_t i = 0; i < light_batch_count; ++i)
+			{
+				renderer->pushMarker("Light");
+
+				const auto& light_batch = light_batches[i];
+				const uint8_t last_face = light_batch.faces.empty() ? 0u : (uint8_t)(light_batch.faces.size() - 1u);
+				setLightData(light_batch, last_face);
+				renderer->setUserData(glm::vec4(last_face, 0.0f, 0.0f, 0.0f), 0);
+
 				renderer->pushMarker("Publish");
 				// Render lights to the light map.
 				// Set up the post processing passes.
@@ -1073,6 +1379,8 @@ namespace lambda
 
 				// Render light using the shadow map.
 				renderer->bindShaderPass(platform::ShaderPass(Name(""), light_batch.publish.shader, light_batch.publish.input, light_batch.publish.output));
+				for (uint32_t u = 0u; u < light_batch.publish_user_data.size(); ++u)
+					renderer->setUserData(light_batch.publish_user_data[u], (uint8_t)(u + 1u));
 
 				renderer->setBlendState(platform::BlendState(
 					false,                                /*alpha_to_coverage*/
@@ -1109,20 +1417,14 @@ namespace lambda
 
 				scene.renderer->beginTimer("Post Processing");
 				scene.renderer->pushMarker("Post Processing");
-				for (auto& pass : scene.post_process_manager->getPasses())
+				// Disabled and culled passes are not part of the compiled passes.
+				for (const auto& pass : scene.post_process_manager->getCompiledPasses())
 				{
-					if (pass.getEnabled())
-					{
-						scene.renderer->pushMarker(pass.getName().getName());
-						scene.renderer->bindShaderPass(pass);
+					scene.renderer->pushMarker(pass.getName().getName());
+					scene.renderer->bindShaderPass(pass);
 
-						scene.renderer->draw();
-						scene.renderer->popMarker();
-					}
-					else
-					{
-						scene.renderer->setMarker(pass.getName().getName() + " - Disabled");
-					}
+					scene.renderer->draw();
+					scene.renderer->popMarker();
 				}
 				scene.renderer->popMarker();
 				scene.renderer->endTimer("Post Processing");
@@ -1199,10 +1501,34 @@ namespace lambda
 			virtual ~RenderAction_CopyToScreen() override {};
 		};
 
+		///////////////////////////////////////////////////////////////////////////
+		void updateDynamicResolution(scene::Scene& scene)
+		{
+			// Only the passes that render at the dynamic resolution, the shadow atlas
+			// is timed as "Shadow Atlas" and does not get cheaper at a lower scale.
+			static const char* kScaledTimers[] = { "Main Camera", "Lighting", "Post Processing" };
+			static std::chrono::steady_clock::time_point k_last_flush = std::chrono::steady_clock::now();
+
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			const float frame_time = std::chrono::duration<float, std::milli>(now - k_last_flush).count();
+			k_last_flush = now;
+
+			if (!scene.dynamic_resolution)
+				return;
+
+			// Timers are from the previous frame, the renderer reads them back at the start of a frame.
+			float gpu_time = 0.0f;
+			for (const char* timer : kScaledTimers)
+				gpu_time += (float)scene.renderer->getTimerMicroSeconds(timer) / 1000.0f;
+
+			scene.renderer->setDynamicResolutionScale(scene.dynamic_resolution->update(frame_time, gpu_time));
+		}
+
 		///////////////////////////////////////////////////////////////////////////
 		void flush(scene::Scene& scene, const CameraBatch& camera_batch, const Vector<LightBatch>& light_batches)
 		{
 			scene.renderer->setOverrideScene(&scene);
+			updateDynamicResolution(scene);
 			scene.renderer->startFrame();
 
 			renderCamera(scene.renderer, camera_batch);
@@ -1264,9 +1590,15 @@ namespace lambda
 			while (!k_queue_flush_data.done)
 				std::this_thread::sleep_for(std::chrono::microseconds(1));
 
+			// Streamed in data modifies the assets, which is only safe while nothing is being flushed.
+			asset::AssetStreamer::getInstance()->update();
+			asset::TextureManager::getInstance()->updateResidency();
+			asset::AssetReloader::getInstance()->update();
+
 			construct(scene, k_queue_flush_data.camera_batch, k_queue_flush_data.light_batches);
 			k_queue_flush_data.scene.renderer                 = scene.renderer;
 			k_queue_flush_data.scene.post_process_manager     = scene.post_process_manager;
+			k_queue_flush_data.scene.dynamic_resolution       = scene.dynamic_resolution;
 			k_queue_flush_data.scene.window                   = scene.window;
 			k_queue_flush_data.scene.gui                      = scene.gui;
 			k_queue_flush_data.scene.render_actions           = scene.render_actions;
@@ -1280,6 +1612,9 @@ namespace lambda
 			platform::TaskScheduler::queue(queueFlush, &k_queue_flush_data, platform::TaskScheduler::kCritical);
 #else
 			// Create new.
+			asset::AssetStreamer::getInstance()->update();
+			asset::TextureManager::getInstance()->updateResidency();
+			asset::AssetReloader::getInstance()->update();
 
 			CameraBatch camera_batch;
 			Vector<LightBatch> light_batches;
@@ -1295,6 +1630,7 @@ namespace lambda
 		{
 			components::NameSystem::collectGarbage(scene);
 			components::LODSystem::collectGarbage(scene);
+			components::AnimationSystem::collectGarbage(scene);
 			components::CameraSystem::collectGarbage(scene);
 			components::MeshRenderSystem::collectGarbage(scene);
 			components::TransformSystem::collectGarbage(scene);
@@ -1329,12 +1665,33 @@ namespace lambda
 			components::RigidBodySystem::deinitialize(scene);
 			components::NameSystem::deinitialize(scene);
 			components::LODSystem::deinitialize(scene);
+			components::AnimationSystem::deinitialize(scene);
 			components::CameraSystem::deinitialize(scene);
 			components::MeshRenderSystem::deinitialize(scene);
 			components::TransformSystem::deinitialize(scene);
 			components::MonoBehaviourSystem::deinitialize(scene);
 			components::WaveSourceSystem::deinitialize(scene);
 			components::LightSystem::deinitialize(scene);
+
+			if (scene.shadow_atlas)
+			{
+				scene.shadow_atlas->deinitialize();
+				foundation::Memory::destruct(scene.shadow_atlas);
+				scene.shadow_atlas = nullptr;
+			}
+
+			if (scene.light_clusters)
+			{
+				scene.light_clusters->deinitialize();
+				foundation::Memory::destruct(scene.light_clusters);
+				scene.light_clusters = nullptr;
+			}
+
+			if (scene.dynamic_resolution)
+			{
+				foundation::Memory::destruct(scene.dynamic_resolution);
+				scene.dynamic_resolution = nullptr;
+			}
 		}
 
 		std::string k_src;
@@ -1396,6 +1753,9 @@ namespace lambda
 
 			new_scene.debug_renderer       = scene.debug_renderer;
 			new_scene.post_process_manager = scene.post_process_manager;
+			new_scene.shadow_atlas         = scene.shadow_atlas;
+			new_scene.light_clusters       = scene.light_clusters;
+			new_scene.dynamic_resolution   = scene.dynamic_resolution;
 			new_scene.scripting            = scene.scripting;
 			new_scene.renderer             = scene.renderer;
 			new_scene.window               = scene.window;
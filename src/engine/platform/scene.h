@@ -2,6 +2,7 @@
 #include <systems/entity_system.h>
 #include <systems/name_system.h>
 #include <systems/lod_system.h>
+#include <systems/animation_system.h>
 #include <systems/rigid_body_system.h>
 #include <systems/collider_system.h>
 #include <systems/mono_behaviour_system.h>
@@ -22,6 +23,13 @@ namespace lambda
 		class GUI;
 	}
 
+	namespace platform
+	{
+		class ShadowAtlas;
+		class LightClusters;
+		class DynamicResolution;
+	}
+
 	namespace scene
 	{
 		struct Scene;
@@ -38,6 +46,7 @@ namespace lambda
 			components::EntitySystem::SystemData        entity;
 			components::NameSystem::SystemData          name;
 			components::LODSystem::SystemData           lod;
+			components::AnimationSystem::SystemData     animation;
 			components::CameraSystem::SystemData        camera;
 			components::RigidBodySystem::SystemData     rigid_body;
 			components::ColliderSystem::SystemData      collider;
@@ -48,6 +57,9 @@ namespace lambda
 			components::MeshRenderSystem::SystemData    mesh_render;
 			platform::DebugRenderer         debug_renderer;
 			platform::PostProcessManager*   post_process_manager;
+			platform::ShadowAtlas*          shadow_atlas = nullptr;
+			platform::LightClusters*        light_clusters = nullptr;
+			platform::DynamicResolution*    dynamic_resolution = nullptr;
 			scripting::IScriptContext* scripting = nullptr;
 			platform::IRenderer*       renderer  = nullptr;
 			platform::IWindow*         window    = nullptr;
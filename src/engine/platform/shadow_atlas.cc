@@ -0,0 +1,372 @@
+#include "shadow_atlas.h"
+#include "assets/texture.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace lambda
+{
+	namespace platform
+	{
+		///////////////////////////////////////////////////////////////////////////
+		static uint32_t nextPowerOfTwo(uint32_t value)
+		{
+			uint32_t result = 1u;
+			while (result < value)
+				result <<= 1u;
+			return result;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static asset::VioletTextureHandle createTarget(const String& name, uint32_t size)
+		{
+			asset::VioletTextureHandle texture = asset::TextureManager::getInstance()->create(
+				Name(name),
+				size,
+				size,
+				1u,
+				TextureFormat::kR32G32,
+				kTextureFlagIsRenderTarget
+			);
+			texture->setKeepInMemory(true);
+			return texture;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void ShadowAtlas::initialize(uint32_t size, uint32_t min_slot_size, uint32_t max_slot_size)
+		{
+			LMB_ASSERT(nextPowerOfTwo(size) == size, "SHADOW ATLAS: Size %u is not a power of two", size);
+			LMB_ASSERT(min_slot_size <= max_slot_size && max_slot_size <= size, "SHADOW ATLAS: Invalid slot sizes %u - %u", min_slot_size, max_slot_size);
+
+			size_          = size;
+			min_slot_size_ = nextPowerOfTwo(min_slot_size);
+			max_slot_size_ = nextPowerOfTwo(max_slot_size);
+			frame_         = 0ull;
+
+			atlas_        = RenderTarget(Name("__shadow_atlas__"),        createTarget("__shadow_atlas__", size_));
+			static_atlas_ = RenderTarget(Name("__shadow_atlas_static__"), createTarget("__shadow_atlas_static__", size_));
+
+			free_blocks_.clear();
+			free_blocks_.resize(getLevel(min_slot_size_) + 1u);
+			free_blocks_[0u].push_back(glm::uvec2(0u, 0u));
+
+			records_.clear();
+			requests_.clear();
+			frees_ = 0ull;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void ShadowAtlas::deinitialize()
+		{
+			records_.clear();
+			requests_.clear();
+			free_blocks_.clear();
+			scratch_.clear();
+			atlas_        = RenderTarget();
+			static_atlas_ = RenderTarget();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void ShadowAtlas::beginFrame()
+		{
+			frame_++;
+			requests_.clear();
+
+			// Lights that have not been seen for a while give their slots back.
+			Vector<entity::Entity> unused;
+			for (auto& it : records_)
+			{
+				if (it.second.last_used + release_after_ < frame_)
+					unused.push_back(it.first);
+
+				for (Face& face : it.second.faces)
+					face.scheduled = UpdateType::kNone;
+			}
+
+			for (entity::Entity entity : unused)
+				release(entity);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		ShadowAtlas::Face* ShadowAtlas::requestFace(entity::Entity entity, uint32_t face, uint32_t size, const glm::mat4x4& view_projection)
+		{
+			Record& record = records_[entity];
+			record.last_used = frame_;
+			if (record.faces.size() <= face)
+				record.faces.resize(face + 1u);
+
+			Face& f = record.faces[face];
+			size = std::max(min_slot_size_, std::min(max_slot_size_, nextPowerOfTwo(size)));
+
+			// A new slot has none of the old content.
+			const auto place = [&](const glm::uvec4& rect) {
+				f.rect          = rect;
+				f.uv_rect       = glm::vec4(f.rect) / (float)size_;
+				f.static_valid  = false;
+				f.content_valid = false;
+			};
+
+			glm::uvec4 rect;
+			if (!f.allocated)
+			{
+				// Settle for a smaller slot when the atlas is full.
+				for (uint32_t s = size; s >= min_slot_size_ && !f.allocated; s >>= 1u)
+					f.allocated = allocate(s, rect);
+
+				if (!f.allocated)
+					return nullptr;
+
+				place(rect);
+				f.requested   = size;
+				f.failed_grow = frees_;
+			}
+			else if (size * 4u <= f.rect.z)
+			{
+				// Only shrink when the slot is at least four times too big. The
+				// freed slot always fits the smaller one.
+				free(f.rect);
+				f.allocated = allocate(size, rect);
+				LMB_ASSERT(f.allocated, "SHADOW ATLAS: Could not shrink a slot to %u", size);
+				place(rect);
+				f.requested = size;
+			}
+			else if (size > f.rect.z && (size != f.requested || frees_ != f.failed_grow))
+			{
+				// Grow as far as the atlas allows. The old slot is kept until a
+				// bigger one is found, and a slot that could not grow waits for
+				// space to be given back before it tries again.
+				bool grown = false;
+				for (uint32_t s = size; s > f.rect.z && !grown; s >>= 1u)
+					grown = allocate(s, rect);
+
+				if (grown)
+				{
+					free(f.rect);
+					place(rect);
+				}
+				f.requested   = size;
+				f.failed_grow = frees_;
+			}
+
+			if (f.view_projection != view_projection)
+			{
+				f.view_projection = view_projection;
+				f.static_valid    = false;
+				f.content_valid   = false;
+			}
+
+			return &f;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void ShadowAtlas::requestUpdate(entity::Entity entity, uint32_t face, bool dynamic, float priority)
+		{
+			requests_.push_back({ entity, face, dynamic, priority });
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const ShadowAtlas::Face* ShadowAtlas::getFace(entity::Entity entity, uint32_t face) const
+		{
+			auto it = records_.find(entity);
+			if (it == records_.end() || it->second.faces.size() <= face || !it->second.faces[face].allocated)
+				return nullptr;
+			return &it->second.faces[face];
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void ShadowAtlas::schedule()
+		{
+			struct Candidate
+			{
+				Face* face;
+				float score;
+			};
+			Vector<Candidate> candidates;
+			candidates.reserve(requests_.size());
+
+			for (const Request& request : requests_)
+			{
+				auto it = records_.find(request.entity);
+				if (it == records_.end() || it->second.faces.size() <= request.face)
+					continue;
+
+				Face& face = it->second.faces[request.face];
+				if (!face.allocated || (face.content_valid && !request.dynamic))
+					continue;
+
+				// Faces without valid content always go first, the rest is round-robin on age.
+				const float age = (float)(frame_ - face.last_update);
+				const float score = face.content_valid ? age * std::max(request.priority, 0.001f) : FLT_MAX;
+				candidates.push_back({ &face, score });
+			}
+
+			const uint32_t count = std::min((uint32_t)candidates.size(), face_budget_);
+			eastl::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), [](const Candidate& a, const Candidate& b) {
+				return a.score > b.score;
+			});
+
+			for (uint32_t i = 0u; i < count; ++i)
+			{
+				Face& face = *candidates[i].face;
+				face.scheduled     = face.static_valid ? UpdateType::kDynamic : UpdateType::kStatic;
+				face.last_update   = frame_;
+				face.static_valid  = true;
+				face.content_valid = true;
+			}
+
+			requests_.clear();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void ShadowAtlas::invalidate(entity::Entity entity)
+		{
+			auto it = records_.find(entity);
+			if (it == records_.end())
+				return;
+
+			for (Face& face : it->second.faces)
+			{
+				face.static_valid  = false;
+				face.content_valid = false;
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void ShadowAtlas::release(entity::Entity entity)
+		{
+			auto it = records_.find(entity);
+			if (it == records_.end())
+				return;
+
+			for (const Face& face : it->second.faces)
+				if (face.allocated)
+					free(face.rect);
+
+			records_.erase(it);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t ShadowAtlas::getSlotSize(float screen_coverage, uint32_t max_size) const
+		{
+			const float coverage = std::max(0.0f, std::min(1.0f, screen_coverage));
+			const uint32_t size = nextPowerOfTwo((uint32_t)(coverage * (float)max_slot_size_));
+			return std::max(min_slot_size_, std::min(std::min(max_slot_size_, nextPowerOfTwo(max_size)), size));
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void ShadowAtlas::setFaceBudget(uint32_t face_budget)
+		{
+			face_budget_ = face_budget;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t ShadowAtlas::getFaceBudget() const
+		{
+			return face_budget_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t ShadowAtlas::getSize() const
+		{
+			return size_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const RenderTarget& ShadowAtlas::getAtlas() const
+		{
+			return atlas_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		const RenderTarget& ShadowAtlas::getStaticAtlas() const
+		{
+			return static_atlas_;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		RenderTarget ShadowAtlas::getScratch(uint32_t size, uint32_t index)
+		{
+			const uint32_t key = size * 2u + index;
+			auto it = scratch_.find(key);
+			if (it == scratch_.end())
+			{
+				const String name = "__shadow_atlas_scratch_" + toString(size) + "_" + toString(index) + "__";
+				it = scratch_.insert(eastl::make_pair(key, RenderTarget(Name(name), createTarget(name, size)))).first;
+			}
+			return it->second;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		bool ShadowAtlas::allocate(uint32_t size, glm::uvec4& rect)
+		{
+			const uint32_t level = getLevel(size);
+			if (level >= free_blocks_.size())
+				return false;
+
+			// Find the smallest free block that fits.
+			int32_t found = -1;
+			for (int32_t l = (int32_t)level; l >= 0 && found < 0; --l)
+				if (!free_blocks_[l].empty())
+					found = l;
+
+			if (found < 0)
+				return false;
+
+			glm::uvec2 block = free_blocks_[found].back();
+			free_blocks_[found].pop_back();
+
+			// Split it down to the requested size.
+			for (uint32_t l = (uint32_t)found; l < level; ++l)
+			{
+				const uint32_t half = size_ >> (l + 1u);
+				free_blocks_[l + 1u].push_back(block + glm::uvec2(half, 0u));
+				free_blocks_[l + 1u].push_back(block + glm::uvec2(0u, half));
+				free_blocks_[l + 1u].push_back(block + glm::uvec2(half, half));
+			}
+
+			rect = glm::uvec4(block.x, block.y, size, size);
+			return true;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void ShadowAtlas::free(const glm::uvec4& rect)
+		{
+			frees_++;
+			glm::uvec2 block(rect.x, rect.y);
+			uint32_t level = getLevel(rect.z);
+
+			// Merge with the siblings as long as all of them are free.
+			while (level > 0u)
+			{
+				const uint32_t size   = size_ >> level;
+				const glm::uvec2 parent = (block / (size * 2u)) * (size * 2u);
+
+				Vector<glm::uvec2>& blocks = free_blocks_[level];
+				uint32_t siblings = 0u;
+				for (const glm::uvec2& b : blocks)
+					if (b != block && b.x >= parent.x && b.x < parent.x + size * 2u && b.y >= parent.y && b.y < parent.y + size * 2u)
+						siblings++;
+
+				if (siblings != 3u)
+					break;
+
+				blocks.erase(eastl::remove_if(blocks.begin(), blocks.end(), [&](const glm::uvec2& b) {
+					return b.x >= parent.x && b.x < parent.x + size * 2u && b.y >= parent.y && b.y < parent.y + size * 2u;
+				}), blocks.end());
+
+				block = parent;
+				level--;
+			}
+
+			free_blocks_[level].push_back(block);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t ShadowAtlas::getLevel(uint32_t size) const
+		{
+			uint32_t level = 0u;
+			while ((size_ >> level) > size)
+				level++;
+			return level;
+		}
+	}
+}
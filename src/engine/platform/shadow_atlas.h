@@ -0,0 +1,104 @@
+#pragma once
+#include "render_target.h"
+#include "systems/entity.h"
+#include <containers/containers.h>
+#include <glm/glm.hpp>
+
+namespace lambda
+{
+	namespace platform
+	{
+		///////////////////////////////////////////////////////////////////////////
+		// All shadow maps live in one atlas. Slots are power of two squares
+		// handed out by a quad tree buddy allocator. Static casters are cached
+		// per slot in a second atlas and a global budget limits the amount of
+		// faces that get re-rendered every frame.
+		class ShadowAtlas
+		{
+		public:
+			enum class UpdateType : uint8_t
+			{
+				kNone,    // The slot is up to date.
+				kStatic,  // Re-render static casters into the cache, then composite.
+				kDynamic, // Composite the cached statics with the dynamic casters.
+			};
+
+			struct Face
+			{
+				glm::uvec4  rect           = glm::uvec4(0u); // x, y, size, size in texels.
+				glm::vec4   uv_rect        = glm::vec4(0.0f);
+				glm::mat4x4 view_projection;
+				uint64_t    last_update    = 0ull;
+				uint32_t    requested      = 0u;   // Size of the last request, the slot is smaller when the atlas was full.
+				uint64_t    failed_grow    = 0ull; // Frees the atlas had seen when the slot last failed to grow.
+				bool        allocated      = false;
+				bool        static_valid   = false;
+				bool        content_valid  = false;
+				UpdateType  scheduled      = UpdateType::kNone;
+			};
+
+			void initialize(uint32_t size = 4096u, uint32_t min_slot_size = 64u, uint32_t max_slot_size = 1024u);
+			void deinitialize();
+
+			// Called once per frame before any light requests a slot.
+			void beginFrame();
+			// Returns the face or nullptr when the atlas is full.
+			Face* requestFace(entity::Entity entity, uint32_t face, uint32_t size, const glm::mat4x4& view_projection);
+			// Marks the face as wanting a re-render this frame.
+			void requestUpdate(entity::Entity entity, uint32_t face, bool dynamic, float priority);
+			// Returns the face or nullptr when it has no slot.
+			const Face* getFace(entity::Entity entity, uint32_t face) const;
+			// Picks the faces that will be rendered this frame, respecting the budget.
+			void schedule();
+			void invalidate(entity::Entity entity);
+			void release(entity::Entity entity);
+
+			uint32_t getSlotSize(float screen_coverage, uint32_t max_size) const;
+			void setFaceBudget(uint32_t face_budget);
+			uint32_t getFaceBudget() const;
+			uint32_t getSize() const;
+
+			const RenderTarget& getAtlas() const;
+			const RenderTarget& getStaticAtlas() const;
+			// Scratch targets used by the blur passes, one pair per slot size.
+			RenderTarget getScratch(uint32_t size, uint32_t index);
+
+		private:
+			struct Request
+			{
+				entity::Entity entity;
+				uint32_t       face;
+				bool           dynamic;
+				float          priority;
+			};
+
+			struct Record
+			{
+				Vector<Face> faces;
+				uint64_t     last_used = 0ull;
+			};
+
+			bool allocate(uint32_t size, glm::uvec4& rect);
+			void free(const glm::uvec4& rect);
+			uint32_t getLevel(uint32_t size) const;
+
+		private:
+			uint32_t size_          = 0u;
+			uint32_t min_slot_size_ = 0u;
+			uint32_t max_slot_size_ = 0u;
+			uint32_t face_budget_   = 8u;
+			uint32_t release_after_ = 120u;
+			uint64_t frame_         = 0ull;
+			uint64_t frees_         = 0ull; // Slots given back, a slot that could not grow only tries again after one.
+
+			RenderTarget atlas_;
+			RenderTarget static_atlas_;
+			UnorderedMap<uint32_t, RenderTarget> scratch_;
+
+			// Free blocks per level, level 0 is the full atlas.
+			Vector<Vector<glm::uvec2>> free_blocks_;
+			UnorderedMap<entity::Entity, Record> records_;
+			Vector<Request> requests_;
+		};
+	}
+}
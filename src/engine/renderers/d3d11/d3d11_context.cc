@@ -582,6 +582,7 @@ namespace lambda
 		void D3D11Context::deinitialize()
 		{
 			state_manager_.deinitialize();
+			quantized_shaders_.clear();
 			asset_manager_.deleteAllAssets();
 			memset(&state_, 0, sizeof(state_));
 			context_.backbuffer = nullptr;
@@ -717,6 +718,12 @@ namespace lambda
 
     ///////////////////////////////////////////////////////////////////////////
     void D3D11Context::draw(uint32_t instance_count)
+    {
+			drawRange(0u, UINT32_MAX, instance_count);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void D3D11Context::drawRange(uint32_t first_index, uint32_t index_count, uint32_t instance_count)
     {
 			LMB_ASSERT(override_scene_, "D3D11 CONTEXT: Tried to render outside of the flush thread");
 			LMB_ASSERT(instance_count, "D3D11 CONTEXT: Tried to render zero instances");
@@ -727,9 +734,35 @@ namespace lambda
 			LMB_ASSERT(shader, "D3D11 CONTEXT: There was no valid shader bound");
 			LMB_ASSERT(mesh, "D3D11 CONTEXT: There was no valid mesh bound");
 
-			if (isDirty(DirtyStates::kShader))
+			// Quantized sub meshes keep their packed streams, the variant of the shader decodes them.
+			const Vector<asset::SubMesh>& sub_meshes = state_.mesh->getSubMeshes();
+			if (state_.sub_mesh < sub_meshes.size() && sub_meshes[state_.sub_mesh].quantized != 0u)
+			{
+				const asset::SubMesh& sub_mesh = sub_meshes[state_.sub_mesh];
+				shader = getQuantizedShader();
+				if (!shader)
+					return;
+
+				const glm::vec4 position_bounds[2u] = {
+					glm::vec4(sub_mesh.position_min, 0.0f),
+					glm::vec4(sub_mesh.position_max - sub_mesh.position_min, 0.0f),
+				};
+				if (!cbs_.quantization || memcmp(cbs_.position_bounds, position_bounds, sizeof(position_bounds)) != 0)
+				{
+					memcpy(cbs_.position_bounds, position_bounds, sizeof(position_bounds));
+					if (!cbs_.quantization)
+						cbs_.quantization = (D3D11RenderBuffer*)allocRenderBuffer(sizeof(cbs_.position_bounds), platform::IRenderBuffer::kFlagConstant | platform::IRenderBuffer::kFlagDynamic, nullptr);
+					memcpy(cbs_.quantization->lock(), cbs_.position_bounds, sizeof(cbs_.position_bounds));
+					cbs_.quantization->unlock();
+				}
+				setConstantBuffer(cbs_.quantization, cbQuantizationIdx);
+			}
+
+			const bool shader_changed = isDirty(DirtyStates::kShader) || shader != dx_state_.bound_shader;
+			if (shader_changed)
 			{
 				shader->bind();
+				dx_state_.bound_shader = shader;
 			}
 
 			if (isDirty(DirtyStates::kViewports))
@@ -804,16 +837,16 @@ namespace lambda
 				}
 			}
 
-			if (isDirty(DirtyStates::kMesh) || isDirty(DirtyStates::kShader))
+			if (isDirty(DirtyStates::kMesh) || shader_changed)
 			{
 				state_manager_.bindTopology(state_.mesh->getTopology());
 
 				Vector<uint32_t> stages = shader->getStages();
-				mesh->bind(stages, state_.mesh, state_.sub_mesh);
+				mesh->bind(stages, state_.mesh, state_.sub_mesh, state_.lod);
 				state_.mesh->updated();
 			}
 
-			mesh->draw(state_.mesh, state_.sub_mesh, instance_count);
+			mesh->draw(state_.mesh, state_.sub_mesh, state_.lod, instance_count, first_index, index_count);
 
 			cleanAll();
     }
@@ -883,6 +916,7 @@ namespace lambda
 	  asset::VioletShaderHandle  shader   = state_.shader;
 	  asset::VioletMeshHandle    mesh     = state_.mesh;
 	  uint32_t                   sub_mesh = state_.sub_mesh;
+	  uint32_t                   lod      = state_.lod;
 	  glm::vec4                  ud       = cbs_.user_data[0];
 
 	  ID3D11ShaderResourceView* srv = nullptr;
@@ -911,7 +945,7 @@ namespace lambda
 	  setScissorRects(scissor_rects);
 	  setMesh(mesh);
 	  setShader(shader);
-	  setSubMesh(sub_mesh);
+	  setSubMesh(sub_mesh, lod);
 	  for (uint32_t i = 0; i < MAX_TEXTURE_COUNT; ++i)
 		setTexture(textures[i], i);
 	  setRenderTargets(render_targets, state_.depth_target);
@@ -1167,14 +1201,15 @@ namespace lambda
 		}
 
     ///////////////////////////////////////////////////////////////////////////
-		void D3D11Context::setSubMesh(const uint32_t& sub_mesh_idx)
+		void D3D11Context::setSubMesh(const uint32_t& sub_mesh_idx, const uint32_t& lod)
 		{
 			LMB_ASSERT(override_scene_, "D3D11 CONTEXT: Tried to render outside of the flush thread");
 
-			if (sub_mesh_idx == state_.sub_mesh)
+			if (sub_mesh_idx == state_.sub_mesh && lod == state_.lod)
 				return;
 
 			state_.sub_mesh = sub_mesh_idx;
+			state_.lod      = lod;
 			makeDirty(DirtyStates::kMesh);
 		}
 
@@ -1460,6 +1495,19 @@ namespace lambda
       return render_scale_;
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    void D3D11Context::setDynamicResolutionScale(const float& scale)
+    {
+      LMB_ASSERT(scale > 0.0f && scale <= 1.0f, "D3D11 CONTEXT: Tried to set invalid dynamic resolution scale | %f", scale);
+      dynamic_resolution_scale_ = scale;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    float D3D11Context::getDynamicResolutionScale()
+    {
+      return dynamic_resolution_scale_;
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     void D3D11Context::setVSync(bool vsync)
     {
@@ -1472,6 +1520,16 @@ namespace lambda
       return vsync_;
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    void D3D11Context::beginLevel(const String& level, const Vector<asset::VioletShaderHandle>& shaders)
+    {
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void D3D11Context::endLevel(const String& level)
+    {
+    }
+
 	///////////////////////////////////////////////////////////////////////////
 	void D3D11Context::destroyTexture(const size_t& hash)
 	{
@@ -1479,10 +1537,42 @@ namespace lambda
 		asset_manager_.removeTexture(hash);
 	}
 
+	///////////////////////////////////////////////////////////////////////////
+	D3D11Shader* D3D11Context::getQuantizedShader()
+	{
+		auto it = quantized_shaders_.find(state_.shader.getHash());
+		if (it == quantized_shaders_.end())
+		{
+			QuantizedShader variant;
+			const String name = state_.shader->getFilePath() + VIOLET_QUANTIZED_SUFFIX;
+			if (asset::ShaderManager::getInstance()->has(name))
+			{
+				variant.handle = asset::ShaderManager::getInstance()->get(name);
+				variant.shader = asset_manager_.getShader(variant.handle);
+			}
+			else
+				foundation::Error("D3D11 CONTEXT: " + state_.shader->getFilePath() + " can not draw quantized meshes, its inputs are not declared with VertexPosition\n");
+			it = quantized_shaders_.insert(eastl::make_pair(state_.shader.getHash(), variant)).first;
+		}
+		return it->second.shader;
+	}
+
 	///////////////////////////////////////////////////////////////////////////
 	void D3D11Context::destroyShader(const size_t& hash)
 	{
 		LMB_ASSERT(hash, "D3D11 CONTEXT: Tried to destroy invalid shader");
+		// Reloaded shaders keep their handle, make sure the next set does not skip it.
+		if (state_.shader.getHash() == hash)
+			state_.shader = nullptr;
+		dx_state_.bound_shader = nullptr;
+		quantized_shaders_.erase(hash);
+		for (auto it = quantized_shaders_.begin(); it != quantized_shaders_.end();)
+		{
+			if (it->second.handle.getHash() == hash)
+				it = quantized_shaders_.erase(it);
+			else
+				++it;
+		}
 		asset_manager_.removeShader(hash);
 	}
 
@@ -1490,6 +1580,8 @@ namespace lambda
 	void D3D11Context::destroyMesh(const size_t& hash)
 	{
 		LMB_ASSERT(hash, "D3D11 CONTEXT: Tried to destroy invalid mesh");
+		if (state_.mesh.getHash() == hash)
+			state_.mesh = nullptr;
 		asset_manager_.removeMesh(hash);
 	}
     
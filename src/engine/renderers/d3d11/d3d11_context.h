@@ -166,6 +166,7 @@ namespace lambda
 			///// Deferred Calls ////////////////////////////////////////////////////
 			/////////////////////////////////////////////////////////////////////////
 			virtual void draw(uint32_t instance_count = 1ul) override;
+			virtual void drawRange(uint32_t first_index, uint32_t index_count, uint32_t instance_count = 1ul) override;
 
 			virtual void setRasterizerState(
 				const platform::RasterizerState& rasterizer_state
@@ -203,7 +204,7 @@ namespace lambda
 			virtual void setViewports(const Vector<glm::vec4>& rects) override;
 
 			virtual void setMesh(asset::VioletMeshHandle mesh) override;
-			virtual void setSubMesh(const uint32_t& sub_mesh_idx) override;
+			virtual void setSubMesh(const uint32_t& sub_mesh_idx, const uint32_t& lod = 0u) override;
 			virtual void setShader(asset::VioletShaderHandle shader) override;
 			virtual void setTexture(
 				asset::VioletTextureHandle texture,
@@ -236,9 +237,13 @@ namespace lambda
 
 			virtual void setRenderScale(const float& render_scale) override;
 			virtual float getRenderScale() override;
+			virtual void setDynamicResolutionScale(const float& scale) override;
+			virtual float getDynamicResolutionScale() override;
 
 			virtual void setVSync(bool vsync) override;
 			virtual bool getVSync() const override;
+			virtual void beginLevel(const String& level, const Vector<asset::VioletShaderHandle>& shaders) override;
+			virtual void endLevel(const String& level) override;
 
 			virtual void destroyTexture(const size_t& hash) override;
 			virtual void destroyShader(const size_t& hash) override;
@@ -261,6 +266,8 @@ namespace lambda
 		protected:
 			scene::Scene* getScene() const;
 			void resizeImpl();
+			// The VIOLET_QUANTIZED variant of the bound shader, null when it has none.
+			D3D11Shader* getQuantizedShader();
 
 		private:
 			bool queued_update_ = false;
@@ -297,6 +304,7 @@ namespace lambda
 				uint16_t                   dirty_textures;
 				asset::VioletMeshHandle    mesh;
 				uint32_t                   sub_mesh;
+				uint32_t                   lod;
 				asset::VioletShaderHandle  shader;
 				platform::IRenderBuffer*   constant_buffers[MAX_CONSTANT_BUFFER_COUNT];
 				uint16_t                   dirty_constant_buffers[(int)ShaderStages::kCount];
@@ -310,6 +318,7 @@ namespace lambda
 				ID3D11DepthStencilView*   depth_target;
 				ID3D11ShaderResourceView* textures[MAX_TEXTURE_COUNT];
 				D3D11Shader*              shader;
+				D3D11Shader*              bound_shader; // The shader or its quantized variant.
 				D3D11Mesh*                mesh;
 				ID3D11Buffer*             constant_buffers[MAX_CONSTANT_BUFFER_COUNT];
 			} dx_state_;
@@ -339,8 +348,18 @@ namespace lambda
 				D3D11RenderBuffer* drs          = nullptr;
 				D3D11RenderBuffer* cb_user_data = nullptr;
 				glm::vec4 user_data[MAX_USER_DATA_COUNT];
+				D3D11RenderBuffer* quantization = nullptr;
+				glm::vec4 position_bounds[2u]; // Offset and scale of the packed positions.
 			} cbs_;
 
+			// Variants of the shaders that decode the packed streams of quantized meshes, by the hash of the shader.
+			struct QuantizedShader
+			{
+				asset::VioletShaderHandle handle;
+				D3D11Shader*              shader = nullptr;
+			};
+			UnorderedMap<size_t, QuantizedShader> quantized_shaders_;
+
 #if GPU_MARKERS
 			Microsoft::WRL::ComPtr<ID3DUserDefinedAnnotation>
 				user_defined_annotation_;
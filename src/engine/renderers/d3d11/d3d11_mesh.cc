@@ -2,11 +2,21 @@
 #include <d3d11.h>
 #include <utils/console.h>
 #include <renderers/d3d11/d3d11_context.h>
+#include <algorithm>
 
 namespace lambda
 {
   namespace windows
   {
+    ///////////////////////////////////////////////////////////////////////////
+    // Levels past the last one the mesh has use the least detailed level.
+    static asset::SubMesh::Offset& getIndices(asset::SubMesh& sub_mesh, const uint32_t& lod)
+    {
+      if (lod == 0u || sub_mesh.lods.empty())
+        return sub_mesh.offsets[asset::MeshElements::kIndices];
+      return sub_mesh.lods[std::min(lod, (uint32_t)sub_mesh.lods.size()) - 1u].indices;
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     D3D11Mesh::D3D11Mesh(D3D11Context* context) 
       : context_(context)
@@ -25,7 +35,8 @@ namespace lambda
     void D3D11Mesh::bind(
       const Vector<uint32_t>& stages,
       asset::VioletMeshHandle mesh,
-      const uint32_t& sub_mesh_idx)
+      const uint32_t& sub_mesh_idx,
+      const uint32_t& lod)
     {
       Vector<UINT> strides;
       Vector<ID3D11Buffer*> buffers;
@@ -86,37 +97,41 @@ namespace lambda
 					context_->getD3D11Context()->IASetIndexBuffer(
 						buffer_.at(asset::MeshElements::kIndices)->getBuffer(),
 						format,
-						(UINT)sub_mesh.offsets[asset::MeshElements::kIndices].offset
+						(UINT)getIndices(sub_mesh, lod).offset
 					);
 				}
 			}
     }
 
     ///////////////////////////////////////////////////////////////////////////
-    void D3D11Mesh::draw(asset::VioletMeshHandle mesh, const uint32_t& sub_mesh_idx, const uint32_t& instance_count)
+    void D3D11Mesh::draw(asset::VioletMeshHandle mesh, const uint32_t& sub_mesh_idx, const uint32_t& lod, const uint32_t& instance_count, const uint32_t& first_index, const uint32_t& index_count)
     {
       asset::SubMesh& sub_mesh = mesh->getSubMeshes().at(sub_mesh_idx);
      
       if (buffer_.find(asset::MeshElements::kIndices) != buffer_.end() &&
         buffer_.at(asset::MeshElements::kIndices)->getSize() > 0)
       {
-        const asset::SubMesh::Offset& idx = 
-          sub_mesh.offsets[asset::MeshElements::kIndices];
+        const asset::SubMesh::Offset& idx = getIndices(sub_mesh, lod);
+        const size_t first = std::min((size_t)first_index, idx.count);
         context_->getD3D11Context()->DrawIndexedInstanced(
-          (UINT)idx.count, 
+          (UINT)std::min((size_t)index_count, idx.count - first), 
           (UINT)instance_count,
-					(UINT)sub_mesh.index_offset, 
+					(UINT)(sub_mesh.index_offset + first), 
           (INT)sub_mesh.vertex_offset,
 					0					
         );
       }
       else
+      {
+        const size_t count = sub_mesh.offsets[asset::MeshElements::kPositions].count;
+        const size_t first = std::min((size_t)first_index, count);
         context_->getD3D11Context()->DrawInstanced(
-          (UINT)sub_mesh.offsets[asset::MeshElements::kPositions].count,
+          (UINT)std::min((size_t)index_count, count - first),
 					(UINT)instance_count,
-					0,
+					(UINT)first,
           0
         );
+      }
     }
    
     ///////////////////////////////////////////////////////////////////////////
@@ -24,9 +24,11 @@ namespace lambda
       void bind(
         const Vector<uint32_t>& stages,
 				asset::VioletMeshHandle mesh,
-        const uint32_t& sub_mesh_idx
+        const uint32_t& sub_mesh_idx,
+        const uint32_t& lod
       );
-      void draw(asset::VioletMeshHandle mesh, const uint32_t& sub_mesh_idx, const uint32_t& instance_count);
+      // Draws at most index_count indices from first_index on, or vertices when there are no indices.
+      void draw(asset::VioletMeshHandle mesh, const uint32_t& sub_mesh_idx, const uint32_t& lod, const uint32_t& instance_count, const uint32_t& first_index, const uint32_t& index_count);
 
     private:
       void update(
@@ -99,6 +99,21 @@ namespace lambda
       }
     };
 
+    ///////////////////////////////////////////////////////////////////////////
+    struct RenderActionDrawRange : public IRenderAction
+    {
+      RenderActionDrawRange() :
+        first_index(0u), index_count(0u), instance_count(1u) {};
+      ~RenderActionDrawRange() {};
+      virtual void execute(D3D11Context* context) const override
+      {
+        context->drawRange(first_index, index_count, instance_count);
+      }
+      uint32_t first_index;
+      uint32_t index_count;
+      uint32_t instance_count;
+    };
+
     ///////////////////////////////////////////////////////////////////////////
     struct RenderActionDrawInstanced : public IRenderAction
     {
@@ -275,13 +290,14 @@ namespace lambda
     struct RenderActionSetSubMesh : public IRenderAction
     {
       RenderActionSetSubMesh() :
-      sub_mesh_idx(0u) {};
+      sub_mesh_idx(0u), lod(0u) {};
       ~RenderActionSetSubMesh() {};
       virtual void execute(D3D11Context* context) const override
       {
-        context->setSubMesh(sub_mesh_idx);
+        context->setSubMesh(sub_mesh_idx, lod);
       }
       uint32_t sub_mesh_idx;
+      uint32_t lod;
     };
 
     ///////////////////////////////////////////////////////////////////////////
@@ -403,6 +419,17 @@ namespace lambda
       queue_actions_.push_back(action);
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    void D3D11Renderer::drawRange(uint32_t first_index, uint32_t index_count, uint32_t instance_count)
+    {
+      RenderActionDrawRange* action = 
+        foundation::GetFrameHeap()->construct<RenderActionDrawRange>();
+      action->first_index    = first_index;
+      action->index_count    = index_count;
+      action->instance_count = instance_count;
+      queue_actions_.push_back(action);
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     void D3D11Renderer::drawInstanced(const Vector<glm::mat4>& matrices)
     {
@@ -532,11 +559,12 @@ namespace lambda
     }
 
     ///////////////////////////////////////////////////////////////////////////
-    void D3D11Renderer::setSubMesh(const uint32_t& sub_mesh_idx)
+    void D3D11Renderer::setSubMesh(const uint32_t& sub_mesh_idx, const uint32_t& lod)
     {
       RenderActionSetSubMesh* action = 
         foundation::GetFrameHeap()->construct<RenderActionSetSubMesh>();
       action->sub_mesh_idx = sub_mesh_idx;
+      action->lod          = lod;
       queue_actions_.push_back(action);
     }
 
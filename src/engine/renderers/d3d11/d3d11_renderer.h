@@ -47,6 +47,7 @@ namespace lambda
       ///// Deferred Calls ////////////////////////////////////////////////////
       /////////////////////////////////////////////////////////////////////////
       virtual void draw() override;
+      virtual void drawRange(uint32_t first_index, uint32_t index_count, uint32_t instance_count = 1ul) override;
       virtual void drawInstanced(const Vector<glm::mat4>& matrices) override;
 
       virtual void setRasterizerState(
@@ -84,7 +85,7 @@ namespace lambda
       virtual void setViewports(const Vector<glm::vec4>& rects);
 
       virtual void setMesh(asset::VioletMeshHandle mesh) override;
-      virtual void setSubMesh(const uint32_t& sub_mesh_idx) override;
+      virtual void setSubMesh(const uint32_t& sub_mesh_idx, const uint32_t& lod = 0u) override;
       virtual void setShader(asset::VioletShaderHandle shader) override;
       virtual void setTexture(
         asset::VioletTextureHandle texture, 
@@ -40,6 +40,7 @@ namespace lambda
       , ps_(nullptr)
       , gs_(nullptr)
       , il_(nullptr)
+      , quantized_(shader->getFilePath().find(VIOLET_QUANTIZED_SUFFIX) != String::npos)
     {
 			Vector<VioletShaderResource::Input> reflection_inputs;
 
@@ -154,6 +155,9 @@ namespace lambda
       case DXGI_FORMAT_R32G32B32A32_UINT: return 16; break;
       case DXGI_FORMAT_R32G32B32A32_SINT: return 16; break;
       case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16; break;
+      case DXGI_FORMAT_R16G16_FLOAT: return 4; break;
+      case DXGI_FORMAT_R10G10B10A2_UNORM: return 4; break;
+      case DXGI_FORMAT_R16G16B16A16_UNORM: return 8; break;
       }
       return 0;
     }
@@ -231,6 +235,18 @@ namespace lambda
 				case VioletShaderComponentType::kFloat4: element.Format = DXGI_FORMAT_R32G32B32A32_FLOAT; break;
 				}
 
+				// The packed streams, see kMeshQuantized*.
+				if (quantized_ && inl == 0)
+				{
+					switch ((uint32_t)constexprHash(semantic))
+					{
+					case asset::MeshElements::kPositions: element.Format = DXGI_FORMAT_R16G16B16A16_UNORM; break;
+					case asset::MeshElements::kNormals:
+					case asset::MeshElements::kTangents:  element.Format = DXGI_FORMAT_R10G10B10A2_UNORM; break;
+					case asset::MeshElements::kTexCoords: element.Format = DXGI_FORMAT_R16G16_FLOAT; break;
+					}
+				}
+
 				offset += sizeFromFormat(element.Format);
 				input_layout.push_back(element);
 			}
@@ -48,6 +48,8 @@ namespace lambda
 	  Vector<uint32_t> stages_;
 
       D3D11Context* context_;
+      // The VIOLET_QUANTIZED variant, which reads the packed streams of quantized meshes.
+      bool quantized_;
     };
   }
 }
\ No newline at end of file
@@ -75,6 +75,11 @@ namespace lambda
     {
     }
     
+    ///////////////////////////////////////////////////////////////////////////
+    void MetalRenderer::drawRange(uint32_t first_index, uint32_t index_count, uint32_t instance_count)
+    {
+    }
+    
     ///////////////////////////////////////////////////////////////////////////
     void MetalRenderer::drawInstanced(const Vector<glm::mat4>& matrices)
     {
@@ -142,7 +147,7 @@ namespace lambda
     }
 
     ///////////////////////////////////////////////////////////////////////////
-    void MetalRenderer::setSubMesh(const uint32_t& sub_mesh_idx)
+    void MetalRenderer::setSubMesh(const uint32_t& sub_mesh_idx, const uint32_t& lod)
     {
     }
 
@@ -222,5 +227,15 @@ namespace lambda
     {
       return false;
     }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void MetalRenderer::beginLevel(const String& level, const Vector<asset::VioletShaderHandle>& shaders)
+    {
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void MetalRenderer::endLevel(const String& level)
+    {
+    }
   }
 }
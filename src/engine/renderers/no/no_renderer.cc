@@ -50,6 +50,11 @@ namespace lambda
     {
     }
     
+    ///////////////////////////////////////////////////////////////////////////
+    void NoRenderer::drawRange(uint32_t first_index, uint32_t index_count, uint32_t instance_count)
+    {
+    }
+    
     ///////////////////////////////////////////////////////////////////////////
     void NoRenderer::drawInstanced(const Vector<glm::mat4>& matrices)
     {
@@ -117,7 +122,7 @@ namespace lambda
     }
 
     ///////////////////////////////////////////////////////////////////////////
-    void NoRenderer::setSubMesh(const uint32_t& sub_mesh_idx)
+    void NoRenderer::setSubMesh(const uint32_t& sub_mesh_idx, const uint32_t& lod)
     {
     }
 
@@ -192,10 +197,31 @@ namespace lambda
       return 1.0f;
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    void NoRenderer::setDynamicResolutionScale(const float& scale)
+    {
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    float NoRenderer::getDynamicResolutionScale()
+    {
+      return 1.0f;
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     bool NoRenderer::getVSync() const
     {
       return false;
     }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void NoRenderer::beginLevel(const String& level, const Vector<asset::VioletShaderHandle>& shaders)
+    {
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void NoRenderer::endLevel(const String& level)
+    {
+    }
   }
 }
\ No newline at end of file
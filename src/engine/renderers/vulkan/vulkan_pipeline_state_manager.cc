@@ -1,7 +1,11 @@
 #include "vulkan_pipeline_state_manager.h"
 #include "vulkan_device_manager.h"
 #include <utils/console.h>
+#include <utils/file_system.h>
 #include "vulkan_shader.h"
+#include "utils/mt_manager.h"
+#include <thread>
+#include <chrono>
 
 namespace lambda
 {
@@ -146,6 +150,260 @@ namespace lambda
 
 				return hash;
 			}
+
+			size_t PipelineKey::hash() const
+			{
+				size_t hash = 0ull;
+				hashCombine(hash, shader);
+				hashCombine(hash, eastl::hash<platform::RasterizerState>()(rasterizer));
+				hashCombine(hash, eastl::hash<platform::BlendState>()(blend_state));
+				hashCombine(hash, (uint32_t)topology);
+				for (uint32_t i = 0; i < format_count; ++i)
+					hashCombine(hash, (uint32_t)formats[i]);
+				return hash;
+			}
+		}
+
+		static const char kPipelineCacheMagic[] = "psc";
+		static const char kPipelineKeysMagic[]  = "psk";
+		static const uint32_t kPipelineKeysVersion = 1u;
+
+		///////////////////////////////////////////////////////////////////////////
+		static bool isDepthFormat(VkFormat format)
+		{
+			return 
+				format == VK_FORMAT_D16_UNORM ||
+				format == VK_FORMAT_X8_D24_UNORM_PACK32 ||
+				format == VK_FORMAT_D32_SFLOAT ||
+				format == VK_FORMAT_S8_UINT ||
+				format == VK_FORMAT_D16_UNORM_S8_UINT ||
+				format == VK_FORMAT_D24_UNORM_S8_UINT ||
+				format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static void fillRasterizer(const platform::RasterizerState& state, VkPipelineRasterizationStateCreateInfo& rasterizer)
+		{
+			switch (state.getCullMode())
+			{
+			case platform::RasterizerState::CullMode::kBack:
+				rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+				break;
+			case platform::RasterizerState::CullMode::kFront:
+				rasterizer.cullMode = VK_CULL_MODE_FRONT_BIT;
+				break;
+			case platform::RasterizerState::CullMode::kNone:
+				rasterizer.cullMode = VK_CULL_MODE_NONE;
+				break;
+			}
+			switch (state.getFillMode())
+			{
+			case platform::RasterizerState::FillMode::kSolid:
+				rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+				break;
+			case platform::RasterizerState::FillMode::kWireframe:
+				rasterizer.polygonMode = VK_POLYGON_MODE_LINE;
+				break;
+			}
+			rasterizer.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+			rasterizer.depthClampEnable        = VK_FALSE;
+			rasterizer.rasterizerDiscardEnable = VK_FALSE;
+			rasterizer.lineWidth               = 1.0f;
+			rasterizer.frontFace               = VK_FRONT_FACE_CLOCKWISE;
+			rasterizer.depthBiasEnable         = VK_FALSE;
+			rasterizer.depthBiasConstantFactor = 0.0f;
+			rasterizer.depthBiasClamp          = 0.0f;
+			rasterizer.depthBiasSlopeFactor    = 0.0f;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static void fillBlendState(const platform::BlendState& state, VkPipelineColorBlendAttachmentState& attachment, VkPipelineColorBlendStateCreateInfo& colour_blend)
+		{
+			static const auto getBlendOp = [](platform::BlendState::BlendOp op) {
+				switch (op)
+				{
+				default:
+				case platform::BlendState::BlendOp::kAdd:         return VK_BLEND_OP_ADD;
+				case platform::BlendState::BlendOp::kSubtract:    return VK_BLEND_OP_SUBTRACT;
+				case platform::BlendState::BlendOp::kMin:         return VK_BLEND_OP_MIN;
+				case platform::BlendState::BlendOp::kMax:         return VK_BLEND_OP_MAX;
+				case platform::BlendState::BlendOp::kRevSubtract: return VK_BLEND_OP_REVERSE_SUBTRACT;
+				}
+			};
+			static const auto getBlendMode = [](platform::BlendState::BlendMode mode) {
+				switch (mode)
+				{
+				default:
+				case platform::BlendState::BlendMode::kZero:           return VK_BLEND_FACTOR_ZERO;
+				case platform::BlendState::BlendMode::kOne:            return VK_BLEND_FACTOR_ONE;
+				case platform::BlendState::BlendMode::kSrcColour:      return VK_BLEND_FACTOR_SRC_COLOR;
+				case platform::BlendState::BlendMode::kInvSrcColour:   return VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+				case platform::BlendState::BlendMode::kSrcAlpha:       return VK_BLEND_FACTOR_SRC_ALPHA;
+				case platform::BlendState::BlendMode::kInvSrcAlpha:    return VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+				case platform::BlendState::BlendMode::kDestAlpha:      return VK_BLEND_FACTOR_DST_ALPHA;
+				case platform::BlendState::BlendMode::kInvDestAlpha:   return VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA;
+				case platform::BlendState::BlendMode::kDestColour:     return VK_BLEND_FACTOR_DST_COLOR;
+				case platform::BlendState::BlendMode::kInvDestColour:  return VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR;
+				case platform::BlendState::BlendMode::kSrcAlphaSat:    return VK_BLEND_FACTOR_SRC_ALPHA_SATURATE;
+				case platform::BlendState::BlendMode::kBlendFactor:    return VK_BLEND_FACTOR_CONSTANT_COLOR;
+				case platform::BlendState::BlendMode::kInvBlendFactor: return VK_BLEND_FACTOR_ONE_MINUS_CONSTANT_COLOR;
+				case platform::BlendState::BlendMode::kSrc1Colour:     return VK_BLEND_FACTOR_SRC1_COLOR;
+				case platform::BlendState::BlendMode::kInvSrc1Colour:  return VK_BLEND_FACTOR_ONE_MINUS_SRC1_COLOR;
+				case platform::BlendState::BlendMode::kSrc1Alpha:      return VK_BLEND_FACTOR_SRC1_ALPHA;
+				case platform::BlendState::BlendMode::kInvSrc1Alpha:   return VK_BLEND_FACTOR_ONE_MINUS_SRC1_ALPHA;
+				}
+			};
+
+			attachment.colorWriteMask = 0;
+			if (state.getWriteMask() & (unsigned char)platform::BlendState::WriteMode::kColourWriteEnableRed)
+				attachment.colorWriteMask |= VK_COLOR_COMPONENT_R_BIT;
+			if (state.getWriteMask() & (unsigned char)platform::BlendState::WriteMode::kColourWriteEnableGreen)
+				attachment.colorWriteMask |= VK_COLOR_COMPONENT_G_BIT;
+			if (state.getWriteMask() & (unsigned char)platform::BlendState::WriteMode::kColourWriteEnableBlue)
+				attachment.colorWriteMask |= VK_COLOR_COMPONENT_B_BIT;
+			if (state.getWriteMask() & (unsigned char)platform::BlendState::WriteMode::kColourWriteEnableAlpha)
+				attachment.colorWriteMask |= VK_COLOR_COMPONENT_A_BIT;
+
+			attachment.blendEnable         = state.getBlendEnable() ? VK_TRUE : VK_FALSE;
+			attachment.srcColorBlendFactor = getBlendMode(state.getSrcBlend());
+			attachment.dstColorBlendFactor = getBlendMode(state.getDestBlend());
+			attachment.colorBlendOp        = getBlendOp(state.getBlendOp());
+			attachment.srcAlphaBlendFactor = getBlendMode(state.getSrcBlendAlpha());
+			attachment.dstAlphaBlendFactor = getBlendMode(state.getDestBlendAlpha());
+			attachment.alphaBlendOp        = getBlendOp(state.getBlendOpAlpha());
+
+			colour_blend.sType             = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+			colour_blend.logicOpEnable     = VK_FALSE;
+			colour_blend.logicOp           = VK_LOGIC_OP_COPY;
+			colour_blend.attachmentCount   = 1;
+			colour_blend.pAttachments      = &attachment;
+			colour_blend.blendConstants[0] = 0.0f;
+			colour_blend.blendConstants[1] = 0.0f;
+			colour_blend.blendConstants[2] = 0.0f;
+			colour_blend.blendConstants[3] = 0.0f;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static void fillInputAssembly(const asset::Topology& topology, VkPipelineInputAssemblyStateCreateInfo& input_assembly)
+		{
+			input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+			input_assembly.primitiveRestartEnable = VK_FALSE;
+
+			switch (topology)
+			{
+			case asset::Topology::kLines:
+				input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+				break;
+			case asset::Topology::kTriangles:
+				input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+				break;
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static void fillMultisample(VkPipelineMultisampleStateCreateInfo& multisample)
+		{
+			multisample.sType                 = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+			multisample.sampleShadingEnable   = VK_FALSE;
+			multisample.rasterizationSamples  = VK_SAMPLE_COUNT_1_BIT;
+			multisample.minSampleShading      = 1.0f;
+			multisample.pSampleMask           = nullptr;
+			multisample.alphaToCoverageEnable = VK_FALSE;
+			multisample.alphaToOneEnable      = VK_FALSE;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static VkRenderPass createRenderPass(const Vector<VkFormat>& formats, const Vector<VkImageLayout>& layouts, VkDevice device, VkAllocationCallbacks* allocator)
+		{
+			Vector<VkAttachmentDescription> colour_attachments(formats.size());
+			Vector<VkAttachmentReference> colour_attachment_references(formats.size());
+
+			for (uint32_t i = 0; i < formats.size(); ++i)
+			{
+				colour_attachments[i].format         = formats[i];
+				colour_attachments[i].samples        = VK_SAMPLE_COUNT_1_BIT;
+				colour_attachments[i].loadOp         = VK_ATTACHMENT_LOAD_OP_LOAD;
+				colour_attachments[i].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+				colour_attachments[i].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_LOAD;
+				colour_attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+				colour_attachments[i].initialLayout  = layouts[i];
+				colour_attachments[i].finalLayout    = layouts[i];
+
+				colour_attachment_references[i].attachment = i;
+				colour_attachment_references[i].layout     = isDepthFormat(formats[i]) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			}
+
+			VkSubpassDescription subpass{};
+			subpass.colorAttachmentCount = (uint32_t)colour_attachment_references.size();
+			subpass.pColorAttachments    = colour_attachment_references.data();
+
+			VkSubpassDependency subpass_dependency{};
+			subpass_dependency.srcSubpass    = VK_SUBPASS_EXTERNAL;
+			subpass_dependency.dstSubpass    = 0;
+			subpass_dependency.srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			subpass_dependency.srcAccessMask = 0;
+			subpass_dependency.dstStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			subpass_dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+			VkRenderPassCreateInfo render_pass_create_info{};
+			render_pass_create_info.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			render_pass_create_info.attachmentCount = (uint32_t)colour_attachments.size();
+			render_pass_create_info.pAttachments    = colour_attachments.data();
+			render_pass_create_info.subpassCount    = 1;
+			render_pass_create_info.pSubpasses      = &subpass;
+			render_pass_create_info.dependencyCount = 1;
+			render_pass_create_info.pDependencies   = &subpass_dependency;
+
+			VkResult result;
+			VkRenderPass render_pass;
+			result = vkCreateRenderPass(device, &render_pass_create_info, allocator, &render_pass);
+			LMB_ASSERT(result == VK_SUCCESS, "VULKAN: could not create render pass | %s", vkErrorCode(result));
+			return render_pass;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		static VkPipeline createPipeline(const memory::Pipeline& pipeline, VkDevice device, VkAllocationCallbacks* allocator, VkPipelineCache cache)
+		{
+			VkPipelineViewportStateCreateInfo viewport_state{};
+			viewport_state.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+			viewport_state.viewportCount = 0;
+			viewport_state.pViewports    = nullptr;
+			viewport_state.scissorCount  = 0;
+			viewport_state.pScissors     = nullptr;
+
+
+			VkDynamicState dynamic_state_array[] = {
+				VK_DYNAMIC_STATE_VIEWPORT,
+				VK_DYNAMIC_STATE_SCISSOR
+			};
+			VkPipelineDynamicStateCreateInfo dynamic_states{};
+			dynamic_states.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+			dynamic_states.dynamicStateCount = sizeof(dynamic_state_array) / sizeof(dynamic_state_array[0]);
+			dynamic_states.pDynamicStates = dynamic_state_array;
+
+			VkGraphicsPipelineCreateInfo pipeline_create_info{};
+			pipeline_create_info.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			pipeline_create_info.stageCount          = (uint32_t)pipeline.shader_stages.size(); // DONE
+			pipeline_create_info.pStages             = pipeline.shader_stages.data();           // DONE
+			pipeline_create_info.pVertexInputState   = &pipeline.vertex_input;                  // <-- TODO
+			pipeline_create_info.pInputAssemblyState = &pipeline.input_assembly;                // DONE
+			pipeline_create_info.pViewportState      = &viewport_state;                         // DONE
+			pipeline_create_info.pRasterizationState = &pipeline.rasterizer;                    // DONE
+			pipeline_create_info.pMultisampleState   = &pipeline.multisample;                   // DONE
+			pipeline_create_info.pDepthStencilState  = nullptr;                                 // DONE
+			pipeline_create_info.pColorBlendState    = &pipeline.colour_blend;                  // DONE
+			pipeline_create_info.pDynamicState       = &dynamic_states;                         // DONE
+			pipeline_create_info.layout              = pipeline.pipeline_layout;                // <-- TODO
+			pipeline_create_info.renderPass          = pipeline.render_pass;                    // DONE
+			pipeline_create_info.subpass             = 0;                                       // DONE
+			pipeline_create_info.basePipelineHandle  = VK_NULL_HANDLE;                          // DONE
+			pipeline_create_info.basePipelineIndex   = -1;                                      // DONE
+
+			VkResult result;
+			VkPipeline vk_pipeline;
+			result = vkCreateGraphicsPipelines(device, cache, 1, &pipeline_create_info, allocator, &vk_pipeline);
+			LMB_ASSERT(result == VK_SUCCESS, "VULKAN: could not create graphics pipeline | %s", vkErrorCode(result));
+			return vk_pipeline;
 		}
 
 		///////////////////////////////////////////////////////////////////////////
@@ -153,6 +411,7 @@ namespace lambda
 		{
 			device_manager_ = device_manager;
 			invalidateAll();
+			prewarm_pending_ = 0u;
 
 			memset(&vk_state_, 0, sizeof(vk_state_));
 			
@@ -178,20 +437,38 @@ namespace lambda
 			VkResult result;
 			result = vkCreateDescriptorSetLayout(device_manager_->getDevice(), &descriptor_set_layout_create_info, device_manager_->getAllocator(), &descriptor_set_layout_);
 			LMB_ASSERT(result == VK_SUCCESS, "VULKAN: could not create descriptor set layout | %s", vkErrorCode(result));
+
+			loadPipelineCache();
 		}
 
 		///////////////////////////////////////////////////////////////////////////
 		void VulkanPipelineStateManager::deinitialize()
 		{
+			// Background compiles write into the pipeline cache.
+			while (prewarm_pending_ > 0u)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+			savePipelineCache();
+
+			VkDevice device = device_manager_->getDevice();
+			VkAllocationCallbacks* allocator = device_manager_->getAllocator();
+
+			for (const auto& it : prewarm_render_passes_)
+				vkDestroyRenderPass(device, it.second, allocator);
+			prewarm_render_passes_.clear();
+
+			vkDestroyPipelineCache(device, pipeline_cache_, allocator);
+			pipeline_cache_ = VK_NULL_HANDLE;
 		}
 
 		///////////////////////////////////////////////////////////////////////////
-		void VulkanPipelineStateManager::setShader(VulkanShader* shader)
+		void VulkanPipelineStateManager::setShader(VulkanShader* shader, size_t shader_hash)
 		{
 			if (state_.shader == shader)
 				return;
 
-			state_.shader = shader;
+			state_.shader      = shader;
+			state_.shader_hash = shader_hash;
 			makeDirty(kDirtyStateShader);
 		}
 
@@ -246,131 +523,16 @@ namespace lambda
 		void VulkanPipelineStateManager::bindPipeline()
 		{
 			if (isDirty(kDirtyStateRasterizer))
-			{
-				switch (state_.rasterizer.getCullMode())
-				{
-				case platform::RasterizerState::CullMode::kBack:
-					vk_state_.pipeline.rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-					break;
-				case platform::RasterizerState::CullMode::kFront:
-					vk_state_.pipeline.rasterizer.cullMode = VK_CULL_MODE_FRONT_BIT;
-					break;
-				case platform::RasterizerState::CullMode::kNone:
-					vk_state_.pipeline.rasterizer.cullMode = VK_CULL_MODE_NONE;
-					break;
-				}
-				switch (state_.rasterizer.getFillMode())
-				{
-				case platform::RasterizerState::FillMode::kSolid:
-					vk_state_.pipeline.rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-					break;
-				case platform::RasterizerState::FillMode::kWireframe:
-					vk_state_.pipeline.rasterizer.polygonMode = VK_POLYGON_MODE_LINE;
-					break;
-				}
-				vk_state_.pipeline.rasterizer.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-				vk_state_.pipeline.rasterizer.depthClampEnable        = VK_FALSE;
-				vk_state_.pipeline.rasterizer.rasterizerDiscardEnable = VK_FALSE;
-				vk_state_.pipeline.rasterizer.lineWidth               = 1.0f;
-				vk_state_.pipeline.rasterizer.frontFace               = VK_FRONT_FACE_CLOCKWISE;
-				vk_state_.pipeline.rasterizer.depthBiasEnable         = VK_FALSE;
-				vk_state_.pipeline.rasterizer.depthBiasConstantFactor = 0.0f;
-				vk_state_.pipeline.rasterizer.depthBiasClamp          = 0.0f;
-				vk_state_.pipeline.rasterizer.depthBiasSlopeFactor    = 0.0f;
-			}
+				fillRasterizer(state_.rasterizer, vk_state_.pipeline.rasterizer);
 
 			if (isDirty(kDirtyStateBlend))
-			{
-				static const auto getBlendOp = [](platform::BlendState::BlendOp op) {
-					switch (op)
-					{
-					default:
-					case platform::BlendState::BlendOp::kAdd:         return VK_BLEND_OP_ADD;
-					case platform::BlendState::BlendOp::kSubtract:    return VK_BLEND_OP_SUBTRACT;
-					case platform::BlendState::BlendOp::kMin:         return VK_BLEND_OP_MIN;
-					case platform::BlendState::BlendOp::kMax:         return VK_BLEND_OP_MAX;
-					case platform::BlendState::BlendOp::kRevSubtract: return VK_BLEND_OP_REVERSE_SUBTRACT;
-					}
-				};
-				static const auto getBlendMode = [](platform::BlendState::BlendMode mode) {
-					switch (mode)
-					{
-					default:
-					case platform::BlendState::BlendMode::kZero:           return VK_BLEND_FACTOR_ZERO;
-					case platform::BlendState::BlendMode::kOne:            return VK_BLEND_FACTOR_ONE;
-					case platform::BlendState::BlendMode::kSrcColour:      return VK_BLEND_FACTOR_SRC_COLOR;
-					case platform::BlendState::BlendMode::kInvSrcColour:   return VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
-					case platform::BlendState::BlendMode::kSrcAlpha:       return VK_BLEND_FACTOR_SRC_ALPHA;
-					case platform::BlendState::BlendMode::kInvSrcAlpha:    return VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-					case platform::BlendState::BlendMode::kDestAlpha:      return VK_BLEND_FACTOR_DST_ALPHA;
-					case platform::BlendState::BlendMode::kInvDestAlpha:   return VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA;
-					case platform::BlendState::BlendMode::kDestColour:     return VK_BLEND_FACTOR_DST_COLOR;
-					case platform::BlendState::BlendMode::kInvDestColour:  return VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR;
-					case platform::BlendState::BlendMode::kSrcAlphaSat:    return VK_BLEND_FACTOR_SRC_ALPHA_SATURATE;
-					case platform::BlendState::BlendMode::kBlendFactor:    return VK_BLEND_FACTOR_CONSTANT_COLOR;
-					case platform::BlendState::BlendMode::kInvBlendFactor: return VK_BLEND_FACTOR_ONE_MINUS_CONSTANT_COLOR;
-					case platform::BlendState::BlendMode::kSrc1Colour:     return VK_BLEND_FACTOR_SRC1_COLOR;
-					case platform::BlendState::BlendMode::kInvSrc1Colour:  return VK_BLEND_FACTOR_ONE_MINUS_SRC1_COLOR;
-					case platform::BlendState::BlendMode::kSrc1Alpha:      return VK_BLEND_FACTOR_SRC1_ALPHA;
-					case platform::BlendState::BlendMode::kInvSrc1Alpha:   return VK_BLEND_FACTOR_ONE_MINUS_SRC1_ALPHA;
-					}
-				};
-
-				vk_state_.pipeline.colour_blend_attachment.colorWriteMask = 0;
-				if (state_.blend_state.getWriteMask() & (unsigned char)platform::BlendState::WriteMode::kColourWriteEnableRed)
-					vk_state_.pipeline.colour_blend_attachment.colorWriteMask |= VK_COLOR_COMPONENT_R_BIT;
-				if (state_.blend_state.getWriteMask() & (unsigned char)platform::BlendState::WriteMode::kColourWriteEnableGreen)
-					vk_state_.pipeline.colour_blend_attachment.colorWriteMask |= VK_COLOR_COMPONENT_G_BIT;
-				if (state_.blend_state.getWriteMask() & (unsigned char)platform::BlendState::WriteMode::kColourWriteEnableBlue)
-					vk_state_.pipeline.colour_blend_attachment.colorWriteMask |= VK_COLOR_COMPONENT_B_BIT;
-				if (state_.blend_state.getWriteMask() & (unsigned char)platform::BlendState::WriteMode::kColourWriteEnableAlpha)
-					vk_state_.pipeline.colour_blend_attachment.colorWriteMask |= VK_COLOR_COMPONENT_A_BIT;
-
-				vk_state_.pipeline.colour_blend_attachment.blendEnable         = state_.blend_state.getBlendEnable() ? VK_TRUE : VK_FALSE;
-				vk_state_.pipeline.colour_blend_attachment.srcColorBlendFactor = getBlendMode(state_.blend_state.getSrcBlend());
-				vk_state_.pipeline.colour_blend_attachment.dstColorBlendFactor = getBlendMode(state_.blend_state.getDestBlend());
-				vk_state_.pipeline.colour_blend_attachment.colorBlendOp        = getBlendOp(state_.blend_state.getBlendOp());
-				vk_state_.pipeline.colour_blend_attachment.srcAlphaBlendFactor = getBlendMode(state_.blend_state.getSrcBlendAlpha());
-				vk_state_.pipeline.colour_blend_attachment.dstAlphaBlendFactor = getBlendMode(state_.blend_state.getDestBlendAlpha());
-				vk_state_.pipeline.colour_blend_attachment.alphaBlendOp        = getBlendOp(state_.blend_state.getBlendOpAlpha());
-
-				vk_state_.pipeline.colour_blend.sType             = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-				vk_state_.pipeline.colour_blend.logicOpEnable     = VK_FALSE;
-				vk_state_.pipeline.colour_blend.logicOp           = VK_LOGIC_OP_COPY;
-				vk_state_.pipeline.colour_blend.attachmentCount   = 1;
-				vk_state_.pipeline.colour_blend.pAttachments      = &vk_state_.pipeline.colour_blend_attachment;
-				vk_state_.pipeline.colour_blend.blendConstants[0] = 0.0f;
-				vk_state_.pipeline.colour_blend.blendConstants[1] = 0.0f;
-				vk_state_.pipeline.colour_blend.blendConstants[2] = 0.0f;
-				vk_state_.pipeline.colour_blend.blendConstants[3] = 0.0f;
-			}
+				fillBlendState(state_.blend_state, vk_state_.pipeline.colour_blend_attachment, vk_state_.pipeline.colour_blend);
 
 			if (isDirty(kDirtyStateTopology))
-			{
-				vk_state_.pipeline.input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-				vk_state_.pipeline.input_assembly.primitiveRestartEnable = VK_FALSE;
-
-				switch (state_.topology)
-				{
-				case asset::Topology::kLines:
-					vk_state_.pipeline.input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
-					break;
-				case asset::Topology::kTriangles:
-					vk_state_.pipeline.input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-					break;
-				}
-			}
+				fillInputAssembly(state_.topology, vk_state_.pipeline.input_assembly);
 
 			if (isDirty(kDirtyStateMultisample))
-			{
-				vk_state_.pipeline.multisample.sType                 = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-				vk_state_.pipeline.multisample.sampleShadingEnable   = VK_FALSE;
-				vk_state_.pipeline.multisample.rasterizationSamples  = VK_SAMPLE_COUNT_1_BIT;
-				vk_state_.pipeline.multisample.minSampleShading      = 1.0f;
-				vk_state_.pipeline.multisample.pSampleMask           = nullptr;
-				vk_state_.pipeline.multisample.alphaToCoverageEnable = VK_FALSE;
-				vk_state_.pipeline.multisample.alphaToOneEnable      = VK_FALSE;
-			}
+				fillMultisample(vk_state_.pipeline.multisample);
 
 			// TODO (Hilze): Add constant buffer support here.
 			if (isDirty(kDirtyStateShader))
@@ -389,7 +551,21 @@ namespace lambda
 
 				// Update pipeline.
 				vk_state_.pipeline.render_pass = vk_state_.bound_render_pass;
-				vk_state_.bound_pipeline = memory_.getPipeline(vk_state_.pipeline, device_manager_->getDevice(), device_manager_->getAllocator());
+				vk_state_.bound_pipeline = memory_.getPipeline(vk_state_.pipeline, device_manager_->getDevice(), device_manager_->getAllocator(), pipeline_cache_);
+
+				// Remember the pipeline so it can be prewarmed next time.
+				if (state_.shader_hash != 0ull && state_.render_targets.size() <= memory::PipelineKey::kMaxRenderTargets)
+				{
+					memory::PipelineKey key;
+					key.shader       = state_.shader_hash;
+					key.rasterizer   = state_.rasterizer;
+					key.blend_state  = state_.blend_state;
+					key.topology     = state_.topology;
+					key.format_count = (uint32_t)state_.render_targets.size();
+					for (uint32_t i = 0; i < key.format_count; ++i)
+						key.formats[i] = state_.render_targets[i]->format;
+					used_pipelines_.insert({ key.hash(), key });
+				}
 
 				// Update framebuffer.
 				for (uint32_t i = 0; i < state_.render_targets.size(); ++i)
@@ -438,66 +614,219 @@ namespace lambda
 			}
 		}
 
+		///////////////////////////////////////////////////////////////////////////
+		void VulkanPipelineStateManager::clearUsedPipelines()
+		{
+			used_pipelines_.clear();
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void VulkanPipelineStateManager::saveUsedPipelines(const String& level) const
+		{
+			Vector<char> data(sizeof(uint32_t) * 2u + used_pipelines_.size() * sizeof(memory::PipelineKey));
+			uint32_t version = kPipelineKeysVersion;
+			uint32_t count   = (uint32_t)used_pipelines_.size();
+			memcpy(data.data(), &version, sizeof(uint32_t));
+			memcpy(data.data() + sizeof(uint32_t), &count, sizeof(uint32_t));
+
+			char* keys = data.data() + sizeof(uint32_t) * 2u;
+			for (const auto& it : used_pipelines_)
+			{
+				memcpy(keys, &it.second, sizeof(memory::PipelineKey));
+				keys += sizeof(memory::PipelineKey);
+			}
+
+			FileSystem::WriteFile("generated/pipeline_keys_" + toString(hash(level)), data.data(), data.size(), kPipelineKeysMagic, sizeof(kPipelineKeysMagic) - 1u);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		Vector<memory::PipelineKey> VulkanPipelineStateManager::loadUsedPipelines(const String& level) const
+		{
+			const String file = "generated/pipeline_keys_" + toString(hash(level));
+			if (!FileSystem::DoesFileExist(file))
+				return Vector<memory::PipelineKey>();
+
+			Vector<char> data = FileSystem::FileToVector(file, kPipelineKeysMagic, sizeof(kPipelineKeysMagic) - 1u);
+			if (data.size() < sizeof(uint32_t) * 2u)
+				return Vector<memory::PipelineKey>();
+
+			uint32_t version, count;
+			memcpy(&version, data.data(), sizeof(uint32_t));
+			memcpy(&count, data.data() + sizeof(uint32_t), sizeof(uint32_t));
+			if (version != kPipelineKeysVersion || data.size() != sizeof(uint32_t) * 2u + count * sizeof(memory::PipelineKey))
+			{
+				foundation::Warning("VULKAN: Discarded outdated pipeline keys for level: " + level + "\n");
+				return Vector<memory::PipelineKey>();
+			}
+
+			Vector<memory::PipelineKey> keys(count);
+			memcpy(keys.data(), data.data() + sizeof(uint32_t) * 2u, count * sizeof(memory::PipelineKey));
+			return keys;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void VulkanPipelineStateManager::prewarm(const Vector<memory::PipelineKey>& keys, const Function<VulkanShader*(size_t)>& get_shader)
+		{
+			struct PrewarmJob
+			{
+				memory::Pipeline pipeline;
+				VkDevice device;
+				VkAllocationCallbacks* allocator;
+				VkPipelineCache cache;
+				std::atomic<uint32_t>* pending;
+			};
+
+			VkDevice device = device_manager_->getDevice();
+			VkAllocationCallbacks* allocator = device_manager_->getAllocator();
+
+			memory::PipelineLayout pipeline_layout{};
+			pipeline_layout.descriptor_set_layouts.push_back(descriptor_set_layout_);
+			VkPipelineLayout layout = memory_.getPipelineLayout(pipeline_layout, device, allocator);
+
+			for (const memory::PipelineKey& key : keys)
+			{
+				VulkanShader* shader = get_shader(key.shader);
+				if (!shader)
+					continue;
+
+				// Only the attachment formats matter for render pass compatibility.
+				size_t format_hash = 0ull;
+				Vector<VkFormat> formats(key.format_count);
+				Vector<VkImageLayout> layouts(key.format_count);
+				for (uint32_t i = 0; i < key.format_count; ++i)
+				{
+					formats[i] = key.formats[i];
+					layouts[i] = isDepthFormat(formats[i]) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+					hashCombine(format_hash, (uint32_t)formats[i]);
+				}
+
+				auto it = prewarm_render_passes_.find(format_hash);
+				if (it == prewarm_render_passes_.end())
+					it = prewarm_render_passes_.insert({ format_hash, createRenderPass(formats, layouts, device, allocator) }).first;
+
+				PrewarmJob* job = foundation::Memory::construct<PrewarmJob>();
+				job->device    = device;
+				job->allocator = allocator;
+				job->cache     = pipeline_cache_;
+				job->pending   = &prewarm_pending_;
+				job->pipeline.shader_stages   = shader->getShaderStages();
+				job->pipeline.pipeline_layout = layout;
+				job->pipeline.render_pass     = it->second;
+				fillRasterizer(key.rasterizer, job->pipeline.rasterizer);
+				fillBlendState(key.blend_state, job->pipeline.colour_blend_attachment, job->pipeline.colour_blend);
+				fillInputAssembly(key.topology, job->pipeline.input_assembly);
+				fillMultisample(job->pipeline.multisample);
+
+				prewarm_pending_++;
+				platform::TaskScheduler::queue([](void* data) {
+					// The pipeline itself is thrown away, the compiled result stays in the pipeline cache.
+					PrewarmJob* job = (PrewarmJob*)data;
+					VkPipeline pipeline = createPipeline(job->pipeline, job->device, job->allocator, job->cache);
+					vkDestroyPipeline(job->device, pipeline, job->allocator);
+					(*job->pending)--;
+					foundation::Memory::destruct(job);
+				}, job, platform::TaskScheduler::kLow);
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		String VulkanPipelineStateManager::getPipelineCacheFile() const
+		{
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(device_manager_->getPhysicalDevice(), &properties);
+
+			static const char* kHex = "0123456789abcdef";
+			String uuid;
+			for (uint32_t i = 0; i < VK_UUID_SIZE; ++i)
+			{
+				uuid += kHex[properties.pipelineCacheUUID[i] >> 4u];
+				uuid += kHex[properties.pipelineCacheUUID[i] & 0xFu];
+			}
+
+			return "generated/pipeline_cache_" + toString(properties.vendorID) + "_" + toString(properties.deviceID) + "_" + uuid;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void VulkanPipelineStateManager::loadPipelineCache()
+		{
+			const String file = getPipelineCacheFile();
+			Vector<char> data;
+			if (FileSystem::DoesFileExist(file))
+				data = FileSystem::FileToVector(file, kPipelineCacheMagic, sizeof(kPipelineCacheMagic) - 1u);
+
+			// Validate the header ourselves, some drivers do not like foreign data.
+			if (!data.empty())
+			{
+				VkPhysicalDeviceProperties properties;
+				vkGetPhysicalDeviceProperties(device_manager_->getPhysicalDevice(), &properties);
+
+				uint32_t header[4] = {};
+				bool valid = data.size() >= sizeof(header) + VK_UUID_SIZE;
+				if (valid)
+				{
+					memcpy(header, data.data(), sizeof(header));
+					valid = header[0] >= sizeof(header) + VK_UUID_SIZE &&
+						header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+						header[2] == properties.vendorID &&
+						header[3] == properties.deviceID &&
+						memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+				}
+
+				if (!valid)
+				{
+					foundation::Warning("VULKAN: Discarded incompatible pipeline cache: " + file + "\n");
+					data.clear();
+				}
+			}
+
+			VkPipelineCacheCreateInfo pipeline_cache_create_info{};
+			pipeline_cache_create_info.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+			pipeline_cache_create_info.initialDataSize = data.size();
+			pipeline_cache_create_info.pInitialData    = data.empty() ? nullptr : data.data();
+
+			VkResult result;
+			result = vkCreatePipelineCache(device_manager_->getDevice(), &pipeline_cache_create_info, device_manager_->getAllocator(), &pipeline_cache_);
+			LMB_ASSERT(result == VK_SUCCESS, "VULKAN: could not create pipeline cache | %s", vkErrorCode(result));
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void VulkanPipelineStateManager::savePipelineCache()
+		{
+			if (pipeline_cache_ == VK_NULL_HANDLE)
+				return;
+
+			size_t size = 0u;
+			VkResult result;
+			result = vkGetPipelineCacheData(device_manager_->getDevice(), pipeline_cache_, &size, nullptr);
+			if (result != VK_SUCCESS || size == 0u)
+				return;
+
+			Vector<char> data(size);
+			result = vkGetPipelineCacheData(device_manager_->getDevice(), pipeline_cache_, &size, data.data());
+			if (result != VK_SUCCESS)
+			{
+				foundation::Warning("VULKAN: Could not retrieve pipeline cache data | " + String(vkErrorCode(result)) + "\n");
+				return;
+			}
+
+			FileSystem::WriteFile(getPipelineCacheFile(), data.data(), size, kPipelineCacheMagic, sizeof(kPipelineCacheMagic) - 1u);
+		}
+
 		VkRenderPass VulkanPipelineStateManager::Memory::getRenderPass(const memory::RenderPass& pass, VkDevice device, VkAllocationCallbacks* allocator)
 		{
 			auto it = render_passes.find(pass);
 
 			if (it == render_passes.end())
 			{
-				// Render targets.
-				Vector<VkAttachmentDescription> colour_attachments(pass.render_targets.size());
-				Vector<VkAttachmentReference> colour_attachment_references(pass.render_targets.size());
-				
+				Vector<VkFormat> formats(pass.render_targets.size());
+				Vector<VkImageLayout> layouts(pass.render_targets.size());
 				for (uint32_t i = 0; i < pass.render_targets.size(); ++i)
 				{
-					VkImageLayout layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-					if (pass.render_targets[i]->format == VK_FORMAT_D16_UNORM ||
-						pass.render_targets[i]->format == VK_FORMAT_X8_D24_UNORM_PACK32 ||
-						pass.render_targets[i]->format == VK_FORMAT_D32_SFLOAT ||
-						pass.render_targets[i]->format == VK_FORMAT_S8_UINT ||
-						pass.render_targets[i]->format == VK_FORMAT_D16_UNORM_S8_UINT ||
-						pass.render_targets[i]->format == VK_FORMAT_D24_UNORM_S8_UINT ||
-						pass.render_targets[i]->format == VK_FORMAT_D32_SFLOAT_S8_UINT)
-					  layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-					
-					colour_attachments[i].format         = pass.render_targets[i]->format;
-					colour_attachments[i].samples        = VK_SAMPLE_COUNT_1_BIT;
-					colour_attachments[i].loadOp         = VK_ATTACHMENT_LOAD_OP_LOAD;
-					colour_attachments[i].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-					colour_attachments[i].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_LOAD;
-					colour_attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-					colour_attachments[i].initialLayout  = pass.render_targets[i]->layout;
-					colour_attachments[i].finalLayout    = pass.render_targets[i]->layout;
-
-					colour_attachment_references[i].attachment = i;
-					colour_attachment_references[i].layout     = layout;
+					formats[i] = pass.render_targets[i]->format;
+					layouts[i] = pass.render_targets[i]->layout;
 				}
 
-				VkSubpassDescription subpass{};
-				subpass.colorAttachmentCount = (uint32_t)colour_attachment_references.size();
-				subpass.pColorAttachments    = colour_attachment_references.data();
-
-				VkSubpassDependency subpass_dependency{};
-				subpass_dependency.srcSubpass    = VK_SUBPASS_EXTERNAL;
-				subpass_dependency.dstSubpass    = 0;
-				subpass_dependency.srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-				subpass_dependency.srcAccessMask = 0;
-				subpass_dependency.dstStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-				subpass_dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-				VkRenderPassCreateInfo render_pass_create_info{};
-				render_pass_create_info.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-				render_pass_create_info.attachmentCount = (uint32_t)colour_attachments.size();
-				render_pass_create_info.pAttachments    = colour_attachments.data();
-				render_pass_create_info.subpassCount    = 1;
-				render_pass_create_info.pSubpasses      = &subpass;
-				render_pass_create_info.dependencyCount = 1;
-				render_pass_create_info.pDependencies   = &subpass_dependency;
-
-				VkResult result;
-				VkRenderPass render_pass;
-				result = vkCreateRenderPass(device, &render_pass_create_info, allocator, &render_pass);
-				LMB_ASSERT(result == VK_SUCCESS, "VULKAN: could not create render pass | %s", vkErrorCode(result));
+				VkRenderPass render_pass = createRenderPass(formats, layouts, device, allocator);
 				render_passes.insert({ pass, render_pass });
 				return render_pass;
 			}
@@ -555,51 +884,13 @@ namespace lambda
 		}
 
 #pragma optimize ("", off)
-		VkPipeline VulkanPipelineStateManager::Memory::getPipeline(const memory::Pipeline& pipeline, VkDevice device, VkAllocationCallbacks* allocator)
+		VkPipeline VulkanPipelineStateManager::Memory::getPipeline(const memory::Pipeline& pipeline, VkDevice device, VkAllocationCallbacks* allocator, VkPipelineCache cache)
 		{
 			auto it = pipelines.find(pipeline);
 
 			if (it == pipelines.end())
 			{
-				VkPipelineViewportStateCreateInfo viewport_state{};
-				viewport_state.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-				viewport_state.viewportCount = 0;
-				viewport_state.pViewports    = nullptr;
-				viewport_state.scissorCount  = 0;
-				viewport_state.pScissors     = nullptr;
-
-
-				VkDynamicState dynamic_state_array[] = {
-					VK_DYNAMIC_STATE_VIEWPORT,
-					VK_DYNAMIC_STATE_SCISSOR
-				};
-				VkPipelineDynamicStateCreateInfo dynamic_states{};
-				dynamic_states.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-				dynamic_states.dynamicStateCount = sizeof(dynamic_state_array) / sizeof(dynamic_state_array[0]);
-				dynamic_states.pDynamicStates = dynamic_state_array;
-
-				VkGraphicsPipelineCreateInfo pipeline_create_info{};
-				pipeline_create_info.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-				pipeline_create_info.stageCount          = (uint32_t)pipeline.shader_stages.size(); // DONE
-				pipeline_create_info.pStages             = pipeline.shader_stages.data();           // DONE
-				pipeline_create_info.pVertexInputState   = &pipeline.vertex_input;                  // <-- TODO
-				pipeline_create_info.pInputAssemblyState = &pipeline.input_assembly;                // DONE
-				pipeline_create_info.pViewportState      = &viewport_state;                         // DONE
-				pipeline_create_info.pRasterizationState = &pipeline.rasterizer;                    // DONE
-				pipeline_create_info.pMultisampleState   = &pipeline.multisample;                   // DONE
-				pipeline_create_info.pDepthStencilState  = nullptr;                                 // DONE
-				pipeline_create_info.pColorBlendState    = &pipeline.colour_blend;                  // DONE
-				pipeline_create_info.pDynamicState       = &dynamic_states;                         // DONE
-				pipeline_create_info.layout              = pipeline.pipeline_layout;                // <-- TODO
-				pipeline_create_info.renderPass          = pipeline.render_pass;                    // DONE
-				pipeline_create_info.subpass             = 0;                                       // DONE
-				pipeline_create_info.basePipelineHandle  = VK_NULL_HANDLE;                          // DONE
-				pipeline_create_info.basePipelineIndex   = -1;                                      // DONE
-
-				VkResult result;
-				VkPipeline vk_pipeline;
-				result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_create_info, allocator, &vk_pipeline);
-				LMB_ASSERT(result == VK_SUCCESS, "VULKAN: could not create graphics pipeline | %s", vkErrorCode(result));
+				VkPipeline vk_pipeline = createPipeline(pipeline, device, allocator, cache);
 				pipelines.insert({ pipeline, vk_pipeline });
 				return vk_pipeline;
 			}
@@ -5,6 +5,7 @@
 #include <platform/rasterizer_state.h>
 #include <assets/mesh.h>
 #include <glm/glm.hpp>
+#include <atomic>
 
 namespace lambda
 {
@@ -67,6 +68,21 @@ namespace lambda
 				size_t hash() const;
 				bool operator==(const Pipeline& other) const { return hash() == other.hash(); }
 			};
+
+			// Handle free description of a pipeline. Stable across runs so it can be recorded to disk.
+			struct PipelineKey
+			{
+				static constexpr uint32_t kMaxRenderTargets = 8u;
+
+				uint64_t                  shader = 0ull;
+				platform::RasterizerState rasterizer;
+				platform::BlendState      blend_state;
+				asset::Topology           topology = asset::Topology::kTriangles;
+				uint32_t                  format_count = 0u;
+				VkFormat                  formats[kMaxRenderTargets] = {};
+				size_t hash() const;
+				bool operator==(const PipelineKey& other) const { return hash() == other.hash(); }
+			};
 		}
 	}
 }
@@ -112,6 +128,16 @@ namespace eastl
 			return k.hash();
 		}
 	};
+
+	/////////////////////////////////////////////////////////////////////////////
+	template <>
+	struct hash<lambda::linux::memory::PipelineKey>
+	{
+		std::size_t operator()(const lambda::linux::memory::PipelineKey& k) const
+		{
+			return k.hash();
+		}
+	};
 }
 
 namespace lambda
@@ -128,7 +154,7 @@ namespace lambda
 			void initialize(VulkanDeviceManager* device_manager);
 			void deinitialize();
 
-			void setShader(VulkanShader* shader);
+			void setShader(VulkanShader* shader, size_t shader_hash = 0ull);
 			void setRasterizer(platform::RasterizerState rasterizer);
 			void setBlendState(platform::BlendState blend_state);
 			void setRenderTargets(const Vector<VulkanWrapperImage*>& render_targets);
@@ -137,8 +163,24 @@ namespace lambda
 			void endRenderPass();
 			void beginRenderPass();
 
+			// Pipelines used since the last clear. Saved per level so they can be prewarmed during load.
+			void clearUsedPipelines();
+			void saveUsedPipelines(const String& level) const;
+			Vector<memory::PipelineKey> loadUsedPipelines(const String& level) const;
+			void prewarm(const Vector<memory::PipelineKey>& keys, const Function<VulkanShader*(size_t)>& get_shader);
+			bool isPrewarming() const { return prewarm_pending_ > 0u; }
+
+		private:
+			void loadPipelineCache();
+			void savePipelineCache();
+			String getPipelineCacheFile() const;
+
 		private:
 			VulkanDeviceManager* device_manager_;
+			VkPipelineCache pipeline_cache_;
+			UnorderedMap<size_t, memory::PipelineKey> used_pipelines_;
+			UnorderedMap<size_t, VkRenderPass> prewarm_render_passes_;
+			std::atomic<uint32_t> prewarm_pending_;
 
 			enum DirtyStates : uint32_t
 			{
@@ -157,6 +199,7 @@ namespace lambda
 				platform::RasterizerState rasterizer;
 				platform::BlendState blend_state;
 				VulkanShader* shader;
+				size_t shader_hash;
 				Vector<VulkanWrapperImage*> render_targets;
 			} state_;
 
@@ -173,7 +216,7 @@ namespace lambda
 				VkRenderPass     getRenderPass(const memory::RenderPass& pass, VkDevice device, VkAllocationCallbacks* allocator);
 				VkFramebuffer    getFramebuffer(const memory::Framebuffer& buffer, VkDevice device, VkAllocationCallbacks* allocator);
 				VkPipelineLayout getPipelineLayout(const memory::PipelineLayout& layout, VkDevice device, VkAllocationCallbacks* allocator);
-				VkPipeline       getPipeline(const memory::Pipeline& pipeline, VkDevice device, VkAllocationCallbacks* allocator);
+				VkPipeline       getPipeline(const memory::Pipeline& pipeline, VkDevice device, VkAllocationCallbacks* allocator, VkPipelineCache cache);
 			} memory_;
 
 			struct VkState
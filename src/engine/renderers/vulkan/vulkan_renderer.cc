@@ -170,6 +170,7 @@ namespace lambda
     ///////////////////////////////////////////////////////////////////////////
     void VulkanRenderer::deinitialize()
     {
+		pipeline_state_manager_.deinitialize();
 		device_manager_.deinitialize();
     }
 
@@ -447,6 +448,13 @@ namespace lambda
 		//	//command_buffer_.tryEnd();
 		//	//command_buffer_.tryBegin();
 	}
+
+    ///////////////////////////////////////////////////////////////////////////
+    void VulkanRenderer::drawRange(uint32_t first_index, uint32_t index_count, uint32_t instance_count)
+    {
+		// Nothing is recorded by draw yet, so there is no range to limit.
+		draw(instance_count);
+	}
     
     ///////////////////////////////////////////////////////////////////////////
     void VulkanRenderer::setRasterizerState(
@@ -755,11 +763,12 @@ namespace lambda
 	}
 
     ///////////////////////////////////////////////////////////////////////////
-    void VulkanRenderer::setSubMesh(const uint32_t& sub_mesh_idx)
+    void VulkanRenderer::setSubMesh(const uint32_t& sub_mesh_idx, const uint32_t& lod)
     {
-		if (sub_mesh_idx != state_.sub_mesh)
+		if (sub_mesh_idx != state_.sub_mesh || lod != state_.lod)
 		{
 			state_.sub_mesh = sub_mesh_idx;
+			state_.lod      = lod;
 			makeDirty(DirtyState::kMesh);
 		}
 	}
@@ -770,7 +779,7 @@ namespace lambda
       if (!shader)
         return;
 
-	  pipeline_state_manager_.setShader(memory_.getShader(shader));
+	  pipeline_state_manager_.setShader(memory_.getShader(shader), shader ? shader.getHash() : 0ull);
     }
 
     ///////////////////////////////////////////////////////////////////////////
@@ -1051,12 +1060,46 @@ namespace lambda
 		return render_scale_;
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    void VulkanRenderer::setDynamicResolutionScale(const float& scale)
+    {
+		dynamic_resolution_scale_ = scale;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    float VulkanRenderer::getDynamicResolutionScale()
+    {
+		return dynamic_resolution_scale_;
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     bool VulkanRenderer::getVSync() const
     {
       return vsync_;
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    void VulkanRenderer::beginLevel(const String& level, const Vector<asset::VioletShaderHandle>& shaders)
+    {
+      // The keys refer to the shaders by the hash setShader was given.
+      UnorderedMap<size_t, asset::VioletShaderHandle> shader_map;
+      for (const asset::VioletShaderHandle& shader : shaders)
+        shader_map.insert(eastl::make_pair(shader.getHash(), shader));
+
+      pipeline_state_manager_.clearUsedPipelines();
+      pipeline_state_manager_.prewarm(pipeline_state_manager_.loadUsedPipelines(level), [this, &shader_map](size_t hash) -> VulkanShader* {
+        const auto it = shader_map.find(hash);
+        return it == shader_map.end() ? nullptr : memory_.getShader(it->second);
+      });
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void VulkanRenderer::endLevel(const String& level)
+    {
+      pipeline_state_manager_.saveUsedPipelines(level);
+      pipeline_state_manager_.clearUsedPipelines();
+    }
+
 	///////////////////////////////////////////////////////////////////////////
 	VulkanRenderBuffer::VulkanRenderBuffer(uint32_t size, uint32_t flags, VulkanAlloc allocation, VulkanRenderer* renderer)
 		: data_(nullptr)
@@ -197,6 +197,7 @@ namespace lambda
       ///// Deferred Calls ////////////////////////////////////////////////////
       /////////////////////////////////////////////////////////////////////////
       virtual void draw(uint32_t instance_count) override;
+      virtual void drawRange(uint32_t first_index, uint32_t index_count, uint32_t instance_count) override;
 
       virtual void setRasterizerState(
         const platform::RasterizerState& rasterizer_state
@@ -234,7 +235,7 @@ namespace lambda
 	  virtual void setViewports(const Vector<glm::vec4>& rects) override;
 
       virtual void setMesh(asset::VioletMeshHandle mesh) override;
-      virtual void setSubMesh(const uint32_t& sub_mesh_idx) override;
+      virtual void setSubMesh(const uint32_t& sub_mesh_idx, const uint32_t& lod = 0u) override;
       virtual void setShader(asset::VioletShaderHandle shader) override;
       virtual void setTexture(
         asset::VioletTextureHandle texture, 
@@ -263,9 +264,13 @@ namespace lambda
 
       virtual void setRenderScale(const float& render_scale) override;
       virtual float getRenderScale() override;
+      virtual void setDynamicResolutionScale(const float& scale) override;
+      virtual float getDynamicResolutionScale() override;
 
       virtual void setVSync(bool vsync) override;
       virtual bool getVSync() const override;
+      virtual void beginLevel(const String& level, const Vector<asset::VioletShaderHandle>& shaders) override;
+      virtual void endLevel(const String& level) override;
 
 	  VkDevice getDevice() const;
 	  VkCommandBuffer getCommandBuffer() const;
@@ -320,6 +325,7 @@ namespace lambda
 		  asset::VioletShaderHandle shader;
 		  asset::VioletMeshHandle mesh;
 		  uint32_t sub_mesh;
+		  uint32_t lod;
 
 		  asset::VioletTextureHandle render_targets[8];
 		  asset::VioletTextureHandle depth_target;
@@ -4,6 +4,7 @@
 #include <assets/mesh_io.h>
 #include <assets/shader.h>
 #include <assets/shader_io.h>
+#include <assets/level_loader.h>
 #include <systems/entity_system.h>
 #include <systems/name_system.h>
 #include <systems/transform_system.h>
@@ -16,6 +17,7 @@
 #include <systems/collider_system.h>
 #include <systems/mono_behaviour_system.h>
 #include <platform/post_process_manager.h>
+#include <platform/dynamic_resolution.h>
 #include <interfaces/iworld.h>
 #include <gui/gui.h>
 
@@ -1435,6 +1437,7 @@ namespace lambda
 			if (components::NameSystem::hasComponent(e, *g_scene))          components::NameSystem::removeComponent(e, *g_scene);
 			if (components::CameraSystem::hasComponent(e, *g_scene))        components::CameraSystem::removeComponent(e, *g_scene);
 			if (components::LODSystem::hasComponent(e, *g_scene))           components::LODSystem::removeComponent(e, *g_scene);
+			if (components::AnimationSystem::hasComponent(e, *g_scene))     components::AnimationSystem::removeComponent(e, *g_scene);
 			if (components::RigidBodySystem::hasComponent(e, *g_scene))     components::RigidBodySystem::removeComponent(e, *g_scene);
 			if (components::ColliderSystem::hasComponent(e, *g_scene))      components::ColliderSystem::removeComponent(e, *g_scene);
 			if (components::MonoBehaviourSystem::hasComponent(e, *g_scene)) components::MonoBehaviourSystem::removeComponent(e, *g_scene);
@@ -2994,6 +2997,18 @@ namespace lambda
 				if (strcmp(signature, "renderScale") == 0) return [](WrenVM* vm) {
 					wrenSetSlotDouble(vm, 0, (float)g_scene->renderer->getRenderScale());
 				};
+				if (strcmp(signature, "setDynamicResolution(_,_,_,_)") == 0) return [](WrenVM* vm) {
+					platform::DynamicResolution::Settings settings = g_scene->dynamic_resolution->getSettings();
+					settings.enabled           = wrenGetSlotBool(vm, 1);
+					settings.target_frame_time = (float)wrenGetSlotDouble(vm, 2);
+					settings.min_scale         = (float)wrenGetSlotDouble(vm, 3);
+					settings.max_scale         = (float)wrenGetSlotDouble(vm, 4);
+					g_scene->dynamic_resolution->setSettings(settings);
+					g_scene->dynamic_resolution->reset();
+				};
+				if (strcmp(signature, "dynamicResolutionScale") == 0) return [](WrenVM* vm) {
+					wrenSetSlotDouble(vm, 0, (float)g_scene->renderer->getDynamicResolutionScale());
+				};
 				if (strcmp(signature, "setLightShaders(_,_,_,_,_)") == 0) return [](WrenVM* vm) {
 					String generate = wrenGetSlotString(vm, 1);
 					String modify = wrenGetSlotString(vm, 2);
@@ -3107,6 +3122,9 @@ namespace lambda
 					texture->getLayer(i).setFlags(texture->getLayer(i).getFlags() & ~flag);
 			}
         };
+        if (strcmp(signature, "setRenderTargetPersistent(_,_)") == 0) return [](WrenVM* vm) {
+          g_scene->post_process_manager->setPersistent(Name(wrenGetSlotString(vm, 1)), wrenGetSlotBool(vm, 2));
+        };
         if (strcmp(signature, "setFinalRenderTarget(_)") == 0) return [](WrenVM* vm) {
           g_scene->post_process_manager->setFinalTarget(Name(wrenGetSlotString(vm, 1)));
         };
@@ -4074,6 +4092,13 @@ namespace lambda
 				String file = wrenGetSlotString(vm, 1);
 				g_scene->do_deserialize = true;
 			};
+			// Preloads the assets of the level, the ones only the last level used are let go.
+			if (strcmp(signature, "loadLevel(_)") == 0) return [](WrenVM* vm) {
+				asset::LevelLoader::getInstance()->load(wrenGetSlotString(vm, 1));
+			};
+			if (strcmp(signature, "level") == 0) return [](WrenVM* vm) {
+				wrenSetSlotString(vm, 0, asset::LevelLoader::getInstance()->getLevel().c_str());
+			};
 			return nullptr;
 		}
 	}
@@ -0,0 +1,462 @@
+#include <systems/animation_system.h>
+#include <systems/mesh_render_system.h>
+#include <platform/scene.h>
+#include <assets/animation.h>
+#include <utils/mt_manager.h>
+#include <utils/timer.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace lambda
+{
+	namespace components
+	{
+		namespace
+		{
+			constexpr uint32_t kJobCount   = 4u;
+			constexpr uint32_t kMinJobSize = 4u;  // Entities.
+			constexpr uint32_t kJointWork  = 8u;  // Work of posing a joint, relative to skinning a vertex.
+			constexpr float    kCostBlend  = 0.1f;
+
+			// An entity that is evaluated this frame, with the streams it skins.
+			struct Instance
+			{
+				AnimationSystem::Data* data;
+				float            priority;
+				uint32_t         work;
+				uint32_t         sub_mesh;
+				size_t           count = 0u; // Vertices, zero when nothing is skinned.
+				const glm::vec3* positions = nullptr;
+				const glm::vec3* normals   = nullptr;
+				const glm::vec3* tangents  = nullptr;
+				const glm::vec4* joints    = nullptr;
+				const glm::vec4* weights   = nullptr;
+				glm::vec3*       out_positions = nullptr;
+				glm::vec3*       out_normals   = nullptr;
+				glm::vec3*       out_tangents  = nullptr;
+			};
+
+			// Poses of a single job, so the jobs never share memory.
+			struct Scratch
+			{
+				Vector<VioletAnimation::Transform> pose;
+				Vector<glm::mat4>                  model;
+			};
+
+			// Keeps looping clips in their first cycle, so the time does not lose precision.
+			float advance(const Vector<VioletAnimationClip>& clips, int clip, bool loop, float time)
+			{
+				if (clip < 0 || clip >= (int)clips.size() || clips[clip].duration <= 0.0f)
+					return time;
+				const float duration = clips[clip].duration;
+				if (!loop)
+					return std::min(std::max(time, 0.0f), duration);
+				time = std::fmod(time, duration);
+				return time < 0.0f ? time + duration : time;
+			}
+
+			uint32_t getVertexCount(const asset::SubMesh& sub_mesh)
+			{
+				const auto it = sub_mesh.offsets.find(asset::MeshElements::kPositions);
+				return it == sub_mesh.offsets.end() ? 0u : (uint32_t)it->second.count;
+			}
+
+			void detach(AnimationSystem::Data& data, scene::Scene& scene)
+			{
+				if (data.skinned && MeshRenderSystem::hasComponent(data.entity, scene) && MeshRenderSystem::getMesh(data.entity, scene).get() == data.skinned.get())
+					MeshRenderSystem::setMesh(data.entity, data.mesh, scene);
+				data.mesh    = asset::VioletMeshHandle();
+				data.skinned = asset::VioletMeshHandle();
+				data.palette.clear();
+			}
+
+			// Gives the entity a copy of its mesh to skin, when the mesh has a skeleton.
+			void attach(AnimationSystem::Data& data, asset::VioletMeshHandle mesh, scene::Scene& scene)
+			{
+				detach(data, scene);
+				data.mesh      = mesh;
+				data.clip      = -1;
+				data.fade_clip = -1;
+				data.fade      = 1.0f;
+				data.dirty     = true;
+				if (!mesh || mesh->getJoints().empty())
+					return;
+
+				data.skinned = asset::MeshManager::getInstance()->create(Name("__animated_" + toString(data.entity) + "__"), asset::Mesh(*mesh));
+				data.skinned->setAnimation({}, {});
+				// Copies the streams that are skinned now, so the first frame does not have to.
+				for (uint32_t hash : { asset::MeshElements::kPositions, asset::MeshElements::kNormals, asset::MeshElements::kTangents })
+					if (data.skinned->has(hash))
+						data.skinned->getMutableData(hash);
+				data.palette.assign(mesh->getJoints().size(), glm::mat4(1.0f));
+				MeshRenderSystem::setMesh(data.entity, data.skinned, scene);
+			}
+
+			// Finds the streams of the sub mesh, skinning needs them tightly packed.
+			void gatherStreams(Instance& instance)
+			{
+				const asset::Mesh& mesh = *instance.data->mesh;
+				asset::Mesh& skinned = *instance.data->skinned;
+				const asset::SubMesh& sub_mesh = mesh.getSubMeshes().at(instance.sub_mesh);
+				const size_t count = getVertexCount(sub_mesh);
+
+				const auto find = [&](uint32_t hash, size_t stride) -> const asset::SubMesh::Offset* {
+					const auto it = sub_mesh.offsets.find(hash);
+					if (it == sub_mesh.offsets.end() || it->second.count != count || it->second.stride != stride || !mesh.has(hash) || !skinned.has(hash))
+						return nullptr;
+					return &it->second;
+				};
+				const auto input = [&](const asset::SubMesh::Offset* offset, uint32_t hash) {
+					return offset ? (const void*)((const unsigned char*)mesh.get(hash).data + offset->offset) : nullptr;
+				};
+				const auto output = [&](const asset::SubMesh::Offset* offset, uint32_t hash) {
+					return offset ? (glm::vec3*)((unsigned char*)skinned.getMutableData(hash) + offset->offset) : nullptr;
+				};
+
+				const asset::SubMesh::Offset* positions = find(asset::MeshElements::kPositions, sizeof(glm::vec3));
+				const asset::SubMesh::Offset* joints    = find(asset::MeshElements::kJoints, sizeof(glm::vec4));
+				const asset::SubMesh::Offset* weights   = find(asset::MeshElements::kWeights, sizeof(glm::vec4));
+				if (count == 0u || !positions || !joints || !weights)
+					return;
+				const asset::SubMesh::Offset* normals  = find(asset::MeshElements::kNormals, sizeof(glm::vec3));
+				const asset::SubMesh::Offset* tangents = find(asset::MeshElements::kTangents, sizeof(glm::vec3));
+
+				instance.count         = count;
+				instance.positions     = (const glm::vec3*)input(positions, asset::MeshElements::kPositions);
+				instance.normals       = (const glm::vec3*)input(normals, asset::MeshElements::kNormals);
+				instance.tangents      = (const glm::vec3*)input(tangents, asset::MeshElements::kTangents);
+				instance.joints        = (const glm::vec4*)input(joints, asset::MeshElements::kJoints);
+				instance.weights       = (const glm::vec4*)input(weights, asset::MeshElements::kWeights);
+				instance.out_positions = output(positions, asset::MeshElements::kPositions);
+				instance.out_normals   = output(normals, asset::MeshElements::kNormals);
+				instance.out_tangents  = output(tangents, asset::MeshElements::kTangents);
+			}
+
+			void evaluate(Instance& instance, Scratch& scratch)
+			{
+				AnimationSystem::Data& data = *instance.data;
+				const Vector<VioletMeshJoint>& joints = data.mesh->getJoints();
+				const Vector<VioletAnimationClip>& clips = data.mesh->getClips();
+				const uint32_t joint_count = (uint32_t)joints.size();
+
+				VioletAnimation::Transform* pose  = scratch.pose.data();
+				VioletAnimation::Transform* other = pose + joint_count;
+				VioletAnimation::RestPose(joints, pose);
+				if (data.clip >= 0)
+					VioletAnimation::Sample(clips[data.clip], data.time, data.loop, joint_count, pose);
+				if (data.fade < 1.0f)
+				{
+					VioletAnimation::RestPose(joints, other);
+					if (data.fade_clip >= 0)
+						VioletAnimation::Sample(clips[data.fade_clip], data.fade_time, data.fade_loop, joint_count, other);
+					VioletAnimation::Blend(other, pose, data.fade, joint_count, pose);
+				}
+				VioletAnimation::LocalToModel(joints, pose, scratch.model.data());
+				VioletAnimation::Palette(joints, scratch.model.data(), data.palette.data());
+
+				if (instance.count == 0u)
+					return;
+
+				asset::SubMesh& sub_mesh = data.skinned->getSubMeshes().at(instance.sub_mesh);
+				VioletAnimation::Skin(data.palette.data(), joint_count, instance.joints, instance.weights, instance.count,
+					instance.positions, instance.normals, instance.tangents,
+					instance.out_positions, instance.out_normals, instance.out_tangents, sub_mesh.min, sub_mesh.max);
+			}
+		}
+
+		namespace AnimationSystem
+		{
+			AnimationComponent addComponent(const entity::Entity& entity, scene::Scene& scene)
+			{
+				if (!MeshRenderSystem::hasComponent(entity, scene))
+					MeshRenderSystem::addComponent(entity, scene);
+
+				Data& data = scene.animation.add(entity);
+				attach(data, MeshRenderSystem::getMesh(entity, scene), scene);
+
+				return AnimationComponent(entity, scene);
+			}
+			AnimationComponent getComponent(const entity::Entity& entity, scene::Scene& scene)
+			{
+				return AnimationComponent(entity, scene);
+			}
+			bool hasComponent(const entity::Entity& entity, scene::Scene& scene)
+			{
+				return scene.animation.has(entity);
+			}
+			void removeComponent(const entity::Entity& entity, scene::Scene& scene)
+			{
+				scene.animation.remove(entity);
+			}
+			void collectGarbage(scene::Scene& scene)
+			{
+				if (!scene.animation.marked_for_delete.empty())
+				{
+					for (entity::Entity entity : scene.animation.marked_for_delete)
+					{
+						const auto& it = scene.animation.entity_to_data.find(entity);
+						if (it != scene.animation.entity_to_data.end())
+						{
+							uint32_t idx = it->second;
+							// Gives the mesh render component its shared mesh back and frees the copy.
+							detach(scene.animation.data[idx], scene);
+							scene.animation.unused_data_entries.push(idx);
+							scene.animation.data_to_entity.erase(idx);
+							scene.animation.entity_to_data.erase(entity);
+							scene.animation.data[idx].valid = false;
+						}
+					}
+					scene.animation.marked_for_delete.clear();
+				}
+			}
+			void deinitialize(scene::Scene& scene)
+			{
+				Vector<entity::Entity> entities;
+				for (const auto& it : scene.animation.entity_to_data)
+					entities.push_back(it.first);
+
+				for (const auto& entity : entities)
+					scene.animation.remove(entity);
+				collectGarbage(scene);
+			}
+			void update(const float& delta_time, scene::Scene& scene)
+			{
+				utilities::Timer timer;
+				SystemData& system = scene.animation;
+				system.stats = Stats();
+
+				// Every entity moves on, only the pose evaluation is budgeted.
+				Vector<Instance> instances;
+				uint32_t max_joints = 0u;
+				for (Data& data : system.data)
+				{
+					if (!data.valid || !MeshRenderSystem::hasComponent(data.entity, scene))
+						continue;
+
+					// The mesh was changed from outside, so start over with the new one.
+					const asset::VioletMeshHandle mesh = MeshRenderSystem::getMesh(data.entity, scene);
+					if (mesh.get() != data.skinned.get() && mesh.get() != data.mesh.get())
+						attach(data, mesh, scene);
+					if (!data.skinned)
+						continue;
+
+					const Vector<VioletAnimationClip>& clips = data.mesh->getClips();
+					const float step = delta_time * data.speed;
+					data.time = advance(clips, data.clip, data.loop, data.time + step);
+					if (data.fade < 1.0f)
+					{
+						data.fade_time = advance(clips, data.fade_clip, data.fade_loop, data.fade_time + step);
+						data.fade = data.fade_duration > 0.0f ? std::min(data.fade + delta_time / data.fade_duration, 1.0f) : 1.0f;
+					}
+					data.pending += delta_time;
+					system.stats.instances++;
+
+					Instance instance;
+					instance.data     = &data;
+					instance.priority = data.dirty ? FLT_MAX : data.pending;
+					instance.sub_mesh = MeshRenderSystem::getSubMesh(data.entity, scene);
+					const uint32_t joint_count = (uint32_t)data.mesh->getJoints().size();
+					const uint32_t vertices = system.cpu_skinning && instance.sub_mesh < data.mesh->getSubMeshes().size() ? getVertexCount(data.mesh->getSubMeshes()[instance.sub_mesh]) : 0u;
+					instance.work = joint_count * kJointWork + vertices;
+					instances.push_back(instance);
+					max_joints = std::max(max_joints, joint_count);
+				}
+
+				if (instances.empty())
+					return;
+
+				// The entities that waited the longest go first, for as long as the estimate fits the budget.
+				std::sort(instances.begin(), instances.end(), [](const Instance& a, const Instance& b) { return a.priority > b.priority; });
+				uint32_t count = 0u;
+				uint64_t work  = 0u;
+				float estimate = 0.0f;
+				for (; count < (uint32_t)instances.size(); ++count)
+				{
+					const float cost = (float)instances[count].work * system.cost_per_work;
+					if (count > 0u && estimate + cost > system.budget)
+						break;
+					estimate += cost;
+					work += instances[count].work;
+				}
+
+				// Marking the streams as changed is not thread safe, so it happens here.
+				for (uint32_t i = 0u; i < count; ++i)
+					if (system.cpu_skinning && instances[i].sub_mesh < instances[i].data->mesh->getSubMeshes().size())
+						gatherStreams(instances[i]);
+
+				Scratch scratch[kJobCount];
+				for (Scratch& job : scratch)
+				{
+					job.pose.resize(max_joints * 2u);
+					job.model.resize(max_joints);
+				}
+				platform::TaskScheduler::parallelFor(count, kJobCount, kMinJobSize, [&](uint32_t job, uint32_t begin, uint32_t end) {
+					for (uint32_t i = begin; i < end; ++i)
+						evaluate(instances[i], scratch[job]);
+				});
+
+				for (uint32_t i = 0u; i < count; ++i)
+				{
+					instances[i].data->pending = 0.0f;
+					instances[i].data->dirty   = false;
+					system.stats.vertices += (uint32_t)instances[i].count;
+				}
+
+				const float time = (float)timer.elapsed().milliseconds();
+				if (work > 0u)
+					system.cost_per_work += (time / (float)work - system.cost_per_work) * kCostBlend;
+				system.stats.evaluated = count;
+				system.stats.time      = time;
+			}
+
+			void play(const entity::Entity& entity, const String& clip, bool loop, float fade, scene::Scene& scene)
+			{
+				Data& data = scene.animation.get(entity);
+				int index = -1;
+				if (data.mesh)
+				{
+					const Vector<VioletAnimationClip>& clips = data.mesh->getClips();
+					for (int i = 0; i < (int)clips.size() && index < 0; ++i)
+						if (clips[i].name == clip)
+							index = i;
+				}
+				if (index == data.clip)
+				{
+					data.loop = loop;
+					return;
+				}
+
+				data.fade_clip     = data.clip;
+				data.fade_time     = data.time;
+				data.fade_loop     = data.loop;
+				data.clip          = index;
+				data.time          = 0.0f;
+				data.loop          = loop;
+				data.fade_duration = fade;
+				data.fade          = fade > 0.0f ? 0.0f : 1.0f;
+				data.dirty         = true;
+			}
+			String getClip(const entity::Entity& entity, scene::Scene& scene)
+			{
+				const Data& data = scene.animation.get(entity);
+				return data.clip >= 0 ? data.mesh->getClips()[data.clip].name : String();
+			}
+			void setSpeed(const entity::Entity& entity, const float& speed, scene::Scene& scene)
+			{
+				scene.animation.get(entity).speed = speed;
+			}
+			float getSpeed(const entity::Entity& entity, scene::Scene& scene)
+			{
+				return scene.animation.get(entity).speed;
+			}
+			const Vector<glm::mat4>& getPalette(const entity::Entity& entity, scene::Scene& scene)
+			{
+				return scene.animation.get(entity).palette;
+			}
+		}
+
+		// The system data.
+		namespace AnimationSystem
+		{
+			Data& SystemData::add(const entity::Entity& entity)
+			{
+				uint32_t idx = 0ul;
+				if (!unused_data_entries.empty())
+				{
+					idx = unused_data_entries.front();
+					unused_data_entries.pop();
+					data[idx] = Data(entity);
+				}
+				else
+				{
+					idx = (uint32_t)data.size();
+					data.push_back(Data(entity));
+					data_to_entity[idx] = entity;
+				}
+
+				data_to_entity[idx] = entity;
+				entity_to_data[entity] = idx;
+
+				return data[idx];
+			}
+
+			Data& SystemData::get(const entity::Entity& entity)
+			{
+				auto it = entity_to_data.find(entity);
+				LMB_ASSERT(it != entity_to_data.end(), "ANIMATION: %llu does not have a component", entity);
+				LMB_ASSERT(data[it->second].valid, "ANIMATION: %llu's data was not valid", entity);
+				return data[it->second];
+			}
+
+			void SystemData::remove(const entity::Entity& entity)
+			{
+				marked_for_delete.insert(entity);
+			}
+
+			bool SystemData::has(const entity::Entity& entity)
+			{
+				return entity_to_data.find(entity) != entity_to_data.end();
+			}
+		}
+
+		namespace AnimationSystem
+		{
+			Data::Data(const Data& other)
+			{
+				*this = other;
+			}
+			Data& Data::operator=(const Data& other)
+			{
+				mesh          = other.mesh;
+				skinned       = other.skinned;
+				clip          = other.clip;
+				fade_clip     = other.fade_clip;
+				time          = other.time;
+				fade_time     = other.fade_time;
+				fade          = other.fade;
+				fade_duration = other.fade_duration;
+				speed         = other.speed;
+				loop          = other.loop;
+				fade_loop     = other.fade_loop;
+				pending       = other.pending;
+				dirty         = other.dirty;
+				palette       = other.palette;
+				entity        = other.entity;
+				valid         = other.valid;
+
+				return *this;
+			}
+		}
+
+		AnimationComponent::AnimationComponent(const entity::Entity& entity, scene::Scene& scene) :
+			IComponent(entity), scene_(&scene)
+		{
+		}
+		AnimationComponent::AnimationComponent(const AnimationComponent& other) :
+			IComponent(other.entity_), scene_(other.scene_)
+		{
+		}
+		AnimationComponent::AnimationComponent() :
+			IComponent(entity::Entity()), scene_(nullptr)
+		{
+		}
+		void AnimationComponent::play(const String& clip, bool loop, float fade)
+		{
+			AnimationSystem::play(entity_, clip, loop, fade, *scene_);
+		}
+		String AnimationComponent::getClip() const
+		{
+			return AnimationSystem::getClip(entity_, *scene_);
+		}
+		void AnimationComponent::setSpeed(const float& speed)
+		{
+			AnimationSystem::setSpeed(entity_, speed, *scene_);
+		}
+		float AnimationComponent::getSpeed() const
+		{
+			return AnimationSystem::getSpeed(entity_, *scene_);
+		}
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <interfaces/icomponent.h>
+#include <assets/mesh.h>
+
+namespace lambda
+{
+	namespace scene
+	{
+		struct Scene;
+	}
+
+	namespace components
+	{
+		class AnimationComponent : public IComponent
+		{
+		public:
+			AnimationComponent(const entity::Entity& entity, scene::Scene& scene);
+			AnimationComponent(const AnimationComponent& other);
+			AnimationComponent();
+
+			void play(const String& clip, bool loop = true, float fade = 0.2f);
+			String getClip() const;
+			void setSpeed(const float& speed);
+			float getSpeed() const;
+
+		private:
+			scene::Scene* scene_;
+		};
+
+		// Plays the clips the mesh compiler imported on the mesh of the mesh
+		// render component. Every entity draws its own copy of the mesh, which
+		// is skinned on the job system. Poses are evaluated within a budget,
+		// the entities that waited the longest go first, so large crowds step
+		// at a lower rate instead of stalling the frame.
+		namespace AnimationSystem
+		{
+			struct Data
+			{
+				Data() {};
+				Data(const entity::Entity& entity) : entity(entity) {};
+				Data(const Data& other);
+				Data& operator=(const Data& other);
+
+				asset::VioletMeshHandle mesh;    // Shared, in the bind pose.
+				asset::VioletMeshHandle skinned; // Of this entity alone, drawn instead of mesh.
+				int   clip          = -1;   // Into Mesh::getClips, -1 for the rest pose.
+				int   fade_clip     = -1;   // The clip that is faded out of.
+				float time          = 0.0f; // Seconds into clip.
+				float fade_time     = 0.0f; // Seconds into fade_clip.
+				float fade          = 1.0f; // Weight of clip, fade_clip has the rest.
+				float fade_duration = 0.0f;
+				float speed         = 1.0f;
+				bool  loop          = true;
+				bool  fade_loop     = true;
+				float pending       = 0.0f; // Seconds since the pose was evaluated last.
+				bool  dirty         = true; // Has to be evaluated, whatever the budget.
+				Vector<glm::mat4> palette;  // Bind pose to posed skeleton, per joint.
+				entity::Entity entity;
+				bool valid = true;
+			};
+
+			struct Stats
+			{
+				uint32_t instances = 0u;
+				uint32_t evaluated = 0u;    // This frame.
+				uint32_t vertices  = 0u;    // Skinned this frame.
+				float    time      = 0.0f;  // Milliseconds.
+			};
+
+			struct SystemData
+			{
+				Vector<Data>                  data;
+				Map<entity::Entity, uint32_t> entity_to_data;
+				Map<uint32_t, entity::Entity> data_to_entity;
+				Set<entity::Entity>           marked_for_delete;
+				Queue<uint32_t>               unused_data_entries;
+
+				Data& add(const entity::Entity& entity);
+				Data& get(const entity::Entity& entity);
+				void  remove(const entity::Entity& entity);
+				bool  has(const entity::Entity& entity);
+
+				float budget         = 2.0f;    // Milliseconds per frame, at least one entity is evaluated.
+				bool  cpu_skinning   = true;    // Off only keeps the palettes up to date.
+				float cost_per_work  = 0.0001f; // Milliseconds, measured. See update for what work is.
+				Stats stats;
+			};
+
+			AnimationComponent addComponent(const entity::Entity& entity, scene::Scene& scene);
+			AnimationComponent getComponent(const entity::Entity& entity, scene::Scene& scene);
+			bool hasComponent(const entity::Entity& entity, scene::Scene& scene);
+			void removeComponent(const entity::Entity& entity, scene::Scene& scene);
+
+			void collectGarbage(scene::Scene& scene);
+			void deinitialize(scene::Scene& scene);
+			void update(const float& delta_time, scene::Scene& scene);
+
+			// Cross fades from the clip that plays now over fade seconds. An
+			// unknown clip fades to the rest pose.
+			void play(const entity::Entity& entity, const String& clip, bool loop, float fade, scene::Scene& scene);
+			String getClip(const entity::Entity& entity, scene::Scene& scene);
+			void setSpeed(const entity::Entity& entity, const float& speed, scene::Scene& scene);
+			float getSpeed(const entity::Entity& entity, scene::Scene& scene);
+			// Of the last evaluated pose, for renderers that skin on the GPU.
+			const Vector<glm::mat4>& getPalette(const entity::Entity& entity, scene::Scene& scene);
+		}
+	}
+}
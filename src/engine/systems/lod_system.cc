@@ -1,12 +1,47 @@
 #include <systems/lod_system.h>
 #include <platform/scene.h>
+#include <utils/mt_manager.h>
 
 #include <algorithm>
+#include <cmath>
 
 namespace lambda
 {
 	namespace components
 	{
+		namespace
+		{
+			constexpr uint32_t kMaxLevels      = 8u;   // Including the full detail level and the impostor.
+			constexpr uint32_t kJobCount       = 4u;
+			constexpr uint32_t kMinJobSize     = 256u; // Renderables.
+			constexpr uint32_t kMaxBudgetSteps = 8u;   // Every step doubles the threshold.
+
+			// What the selection needs of a renderable, gathered once so the
+			// budget passes only walk this array.
+			struct LODInput
+			{
+				float    pixels;      // Pixels a local unit of error covers.
+				uint32_t state;       // In to the view state.
+				uint32_t level_count;
+				float    error[kMaxLevels];
+				uint32_t triangles[kMaxLevels];
+			};
+
+			// Splits [0, count) over up to kJobCount jobs, see TaskScheduler::parallelFor.
+			void parallelFor(uint32_t count, const Function<void(uint32_t job, uint32_t begin, uint32_t end)>& function)
+			{
+				platform::TaskScheduler::parallelFor(count, kJobCount, kMinJobSize, function);
+			}
+
+			uint32_t getTriangleCount(const asset::SubMesh& sub_mesh)
+			{
+				auto it = sub_mesh.offsets.find(asset::MeshElements::kIndices);
+				if (it == sub_mesh.offsets.end() || it->second.count == 0u)
+					it = sub_mesh.offsets.find(asset::MeshElements::kPositions);
+				return it == sub_mesh.offsets.end() ? 0u : (uint32_t)(it->second.count / 3u);
+			}
+		}
+
 		void LOD::setMesh(asset::VioletMeshHandle mesh)
 		{
 			mesh_ = mesh;
@@ -82,10 +117,13 @@ namespace lambda
 				for (const auto& entity : entities)
 					scene.lod.remove(entity);
 				collectGarbage(scene);
+				scene.lod.views.clear();
 			}
 			void update(const float& delta_time, scene::Scene& scene)
 			{
-				// Do not update the LODs every frame. Just not worth it.
+				scene.lod.fade_step = scene.lod.fade_time > 0.0f ? delta_time / scene.lod.fade_time : 1.0f;
+
+				// Do not update the hand made LODs every frame. Just not worth it.
 				scene.lod.time += delta_time;
 				if (scene.lod.time < scene.lod.update_frequency)
 					return;
@@ -97,20 +135,168 @@ namespace lambda
 
 				for (auto& data : scene.lod.data)
 				{
-					auto* chosen_lod = &data.base_lod;
-					float distance = glm::length(components::TransformSystem::getWorldTranslation(data.entity, scene) - camera_position);
+					if (!data.valid || data.lods.empty())
+						continue;
+
+					// The LODs are sorted from far to near, so the level is the number of LODs the distance is past.
+					const auto getLevel = [&data](float distance) {
+						uint32_t level = 0u;
+						for (const auto& lod : data.lods)
+							if (distance > lod.getDistance())
+								level++;
+						return level;
+					};
+
+					// Keep the current level while the distance is within the hysteresis band of its bounds.
+					const float distance = glm::length(components::TransformSystem::getWorldTranslation(data.entity, scene) - camera_position);
+					if (data.level >= getLevel(distance * (1.0f - scene.lod.hysteresis)) &&
+						data.level <= getLevel(distance * (1.0f + scene.lod.hysteresis)))
+						continue;
+
+					data.level = getLevel(distance);
+					const LOD& chosen_lod = data.level == 0u ? data.base_lod : data.lods[data.lods.size() - data.level];
+					components::MeshRenderSystem::setMesh(data.entity, chosen_lod.getMesh(), scene);
+				}
+			}
+
+			void selectLODs(const View& view, const Vector<Vector<utilities::Renderable>*>& lists, scene::Scene& scene)
+			{
+				Vector<utilities::Renderable*> renderables;
+				for (Vector<utilities::Renderable>* list : lists)
+					for (utilities::Renderable& renderable : *list)
+						if (renderable.mesh)
+							renderables.push_back(&renderable);
+
+				if (renderables.empty())
+					return;
+
+				ViewState& state = scene.lod.views[view.key];
+				const size_t state_count = scene.mesh_render.data.size();
+				if (state.lod.size() < state_count)
+				{
+					state.lod.resize(state_count, 0u);
+					state.fade_lod.resize(state_count, 0u);
+					state.fade.resize(state_count, -1.0f);
+				}
+
+				const uint32_t count = (uint32_t)renderables.size();
+				Vector<LODInput> inputs(count);
+				Vector<uint8_t>  levels(count);
+				uint64_t         triangles[kJobCount];
 
-					for (auto& lod : data.lods)
+				// Gather the errors and triangle counts of the levels.
+				const bool is_perspective = view.projection[2][3] != 0.0f;
+				const float pixels_per_unit = view.projection[1][1] * view.resolution * 0.5f;
+				parallelFor(count, [&](uint32_t job, uint32_t begin, uint32_t end) {
+					for (uint32_t i = begin; i < end; ++i)
 					{
-						if (distance > lod.getDistance())
+						const utilities::Renderable& renderable = *renderables[i];
+						const asset::SubMesh& sub_mesh = renderable.mesh->getSubMeshes().at(renderable.sub_mesh);
+						LODInput& input = inputs[i];
+
+						input.state        = renderable.index;
+						input.level_count  = 1u + (uint32_t)std::min(sub_mesh.lods.size(), (size_t)kMaxLevels - 1u);
+						input.error[0]     = 0.0f;
+						input.triangles[0] = getTriangleCount(sub_mesh);
+						for (uint32_t level = 1u; level < input.level_count; ++level)
 						{
-							chosen_lod = &lod;
-							break;
+							input.error[level]     = std::max(sub_mesh.lods[level - 1u].error, input.error[level - 1u]);
+							input.triangles[level] = (uint32_t)(sub_mesh.lods[level - 1u].indices.count / 3u);
 						}
+
+						// The impostor has to be the level right after the last LOD, the renderer tells them apart by that.
+						if (view.impostors && sub_mesh.impostor.radius > 0.0f && renderable.mesh->getImpostorFrames() > 0u && sub_mesh.lods.size() + 2u <= kMaxLevels)
+						{
+							input.error[input.level_count]     = std::max(sub_mesh.impostor.error, input.error[input.level_count - 1u]);
+							input.triangles[input.level_count] = 2u;
+							input.level_count++;
+						}
+
+						const float scale = std::max(glm::length(glm::vec3(renderable.model_matrix[0])), std::max(glm::length(glm::vec3(renderable.model_matrix[1])), glm::length(glm::vec3(renderable.model_matrix[2]))));
+						const float distance = is_perspective ? std::fmax(glm::length(renderable.center - view.position) - renderable.radius, 0.01f) : 1.0f;
+						input.pixels = scale * pixels_per_unit / distance;
 					}
+				});
+
+				const auto select = [&](float threshold) {
+					memset(triangles, 0, sizeof(triangles));
+
+					parallelFor(count, [&](uint32_t job, uint32_t begin, uint32_t end) {
+						uint64_t job_triangles = 0u;
+						for (uint32_t i = begin; i < end; ++i)
+						{
+							const LODInput& input = inputs[i];
+							const uint32_t current = state.fade[input.state] < 0.0f ? kMaxLevels : state.lod[input.state];
+							const uint32_t level   = selectLevel(input.error, input.level_count, input.pixels, current, threshold, scene.lod.hysteresis);
 
-					components::MeshRenderSystem::setMesh(data.entity, chosen_lod->getMesh(), scene);
+							levels[i] = (uint8_t)level;
+							job_triangles += input.triangles[level];
+						}
+						triangles[job] = job_triangles;
+					});
+
+					uint64_t total = 0u;
+					for (uint64_t job_triangles : triangles)
+						total += job_triangles;
+					return total;
+				};
+
+				// Start at half the scale of last time, so the threshold drops back once the view allows it.
+				const uint64_t budget = scene.lod.triangle_budget;
+				float budget_scale = budget == 0u ? 1.0f : std::max(1.0f, state.budget_scale * 0.5f);
+				uint64_t total = select(scene.lod.error_threshold * budget_scale);
+				for (uint32_t step = 0u; budget != 0u && total > budget && step < kMaxBudgetSteps; ++step)
+				{
+					budget_scale *= 2.0f;
+					total = select(scene.lod.error_threshold * budget_scale);
 				}
+				state.budget_scale = budget_scale;
+
+				// Start a cross-fade when the level changed, from the level that was the most visible.
+				const float fade_step = scene.lod.fade_step;
+				parallelFor(count, [&](uint32_t job, uint32_t begin, uint32_t end) {
+					for (uint32_t i = begin; i < end; ++i)
+					{
+						const uint32_t index = inputs[i].state;
+						uint8_t& lod      = state.lod[index];
+						uint8_t& fade_lod = state.fade_lod[index];
+						float&   fade     = state.fade[index];
+
+						if (!view.cross_fade || fade < 0.0f)
+						{
+							lod      = levels[i];
+							fade_lod = levels[i];
+							fade     = 1.0f;
+						}
+						else if (levels[i] != lod)
+						{
+							fade_lod = fade < 0.5f ? fade_lod : lod;
+							lod      = levels[i];
+							fade     = 0.0f;
+						}
+						else
+							fade = std::min(fade + fade_step, 1.0f);
+
+						utilities::Renderable& renderable = *renderables[i];
+						renderable.lod      = lod;
+						renderable.fade_lod = fade_lod;
+						renderable.lod_fade = fade;
+					}
+				});
+			}
+
+			uint32_t selectLevel(const float* errors, uint32_t level_count, float pixels, uint32_t current, float threshold, float hysteresis)
+			{
+				uint32_t level = level_count - 1u;
+				while (level > 0u && errors[level] * pixels > threshold)
+					level--;
+
+				// Only go coarser once the error is well below the threshold, so nothing keeps switching at the boundary.
+				const float band = threshold * (1.0f - hysteresis);
+				while (level > current && errors[level] * pixels > band)
+					level--;
+
+				return level;
 			}
 
 			void setBaseLOD(const entity::Entity& entity, const LOD& lod, scene::Scene& scene)
@@ -184,6 +370,7 @@ namespace lambda
 			{
 				lods = other.lods;
 				base_lod = other.base_lod;
+				level = other.level;
 				entity = other.entity;
 				valid = other.valid;
 			}
@@ -191,6 +378,7 @@ namespace lambda
 			{
 				lods = other.lods;
 				base_lod = other.base_lod;
+				level = other.level;
 				entity = other.entity;
 				valid = other.valid;
 
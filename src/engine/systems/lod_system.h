@@ -59,10 +59,21 @@ namespace lambda
 
 				Vector<LOD> lods;
 				LOD base_lod;
+				uint32_t level = 0u; // 0 is the base LOD, n the LOD with the n-th smallest distance.
 				entity::Entity entity;
 				bool valid = true;
 			};
 
+			// Levels of the renderables as seen from a single view, indexed by
+			// utilities::Renderable::index.
+			struct ViewState
+			{
+				Vector<uint8_t> lod;
+				Vector<uint8_t> fade_lod;
+				Vector<float>   fade; // Negative when the renderable has not been seen yet.
+				float           budget_scale = 1.0f;
+			};
+
 			struct SystemData
 			{
 				Vector<Data>                  data;
@@ -78,6 +89,25 @@ namespace lambda
 
 				float time;
 				float update_frequency = 1.0f / 30.0f;
+
+				// Selection of the levels that the mesh compiler generated.
+				float    error_threshold = 1.0f;  // Pixels the surface of a level may be off by.
+				float    hysteresis      = 0.2f;  // Part of the threshold a coarser level has to stay below.
+				float    fade_time       = 0.25f; // Seconds.
+				float    fade_step       = 1.0f;  // Fade of a single frame.
+				uint64_t triangle_budget = 0u;    // Per view, zero to disable.
+				UnorderedMap<uint64_t, ViewState> views;
+			};
+
+			// Where a set of renderables is seen from.
+			struct View
+			{
+				uint64_t    key;          // Identifies the view state, every camera and shadow face needs its own.
+				glm::mat4x4 projection;
+				glm::vec3   position;
+				float       resolution;   // Height of the target in pixels.
+				bool        cross_fade;   // Cached views, like static shadows, have to swap at once.
+				bool        impostors;    // Allows the impostor after the last LOD, the level after the last one of SubMesh::lods.
 			};
 
 			LODComponent addComponent(const entity::Entity& entity, scene::Scene& scene);
@@ -89,6 +119,17 @@ namespace lambda
 			void deinitialize(scene::Scene& scene);
 			void update(const float& delta_time, scene::Scene& scene);
 
+			// Picks the coarsest level of every renderable whose simplification
+			// error stays below error_threshold pixels. When the levels of all
+			// lists together go over the triangle budget the threshold is raised.
+			void selectLODs(const View& view, const Vector<Vector<utilities::Renderable>*>& lists, scene::Scene& scene);
+
+			// The level selectLODs picks for a single renderable, from the errors
+			// of its levels in local units, the pixels a local unit covers and
+			// the level it is at now. Needs nothing else, so it can be tested
+			// on its own.
+			uint32_t selectLevel(const float* errors, uint32_t level_count, float pixels, uint32_t current, float threshold, float hysteresis);
+
 			void setBaseLOD(const entity::Entity& entity, const LOD& lod, scene::Scene& scene);
 			void addLOD(const entity::Entity& entity, const LOD& lod, scene::Scene& scene);
 			LOD getBaseLOD(const entity::Entity& entity, scene::Scene& scene);
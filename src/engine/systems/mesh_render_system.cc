@@ -267,7 +267,7 @@ namespace lambda
 			void attachMesh(const entity::Entity& entity, asset::VioletMeshHandle mesh, scene::Scene& scene)
 			{
 				// Get all textures.
-				Vector<asset::VioletTextureHandle> textures = mesh->getAttachedTextures();
+				const Vector<asset::VioletTextureHandle>& textures = mesh->getAttachedTextures();
 				const glm::uvec3 texture_count = mesh->getAttachedTextureCount();
 				size_t alb_offset  = 0u;
 				size_t nor_offset  = texture_count.x;
@@ -444,6 +444,29 @@ namespace lambda
 				}
 			}
 
+			void requestTextureMips(const Vector<utilities::Renderable>& renderables, const glm::mat4x4& projection, const glm::vec3& position, float screen_height)
+			{
+				asset::TextureManager* texture_manager = asset::TextureManager::getInstance();
+				const bool is_perspective = projection[2][3] != 0.0f;
+				const float pixels_per_unit = projection[1][1] * screen_height * 0.5f;
+
+				for (const utilities::Renderable& renderable : renderables)
+				{
+					// Assumes the textures are stretched over the whole renderable once.
+					const float distance = is_perspective ? std::fmax(glm::length(renderable.center - position) - renderable.radius, 0.01f) : 1.0f;
+					const float pixels = renderable.radius * 2.0f * pixels_per_unit / distance;
+
+					if (renderable.albedo_texture)
+						texture_manager->requestScreenSize(renderable.albedo_texture, pixels);
+					if (renderable.normal_texture)
+						texture_manager->requestScreenSize(renderable.normal_texture, pixels);
+					if (renderable.dmra_texture)
+						texture_manager->requestScreenSize(renderable.dmra_texture, pixels);
+					if (renderable.emissive_texture)
+						texture_manager->requestScreenSize(renderable.emissive_texture, pixels);
+				}
+			}
+
 			struct DepthSort
 			{
 				bool larger = false;
@@ -481,7 +504,7 @@ namespace lambda
 				for (const utilities::Renderable* renderable : opaque)
 				{
 					scene.renderer->setMesh(renderable->mesh);
-					scene.renderer->setSubMesh(renderable->sub_mesh);
+					scene.renderer->setSubMesh(renderable->sub_mesh, renderable->lod);
 
 					scene.renderer->setTexture(renderable->albedo_texture, 0);
 					scene.renderer->setTexture(renderable->normal_texture, 1);
@@ -490,7 +513,7 @@ namespace lambda
 					//scene.shader_variable_manager.setVariable(platform::ShaderVariable(Name("metallic_roughness"), glm::vec2(renderable->metallicness, renderable->roughness)));
 					//scene.shader_variable_manager.setVariable(platform::ShaderVariable(Name("model_matrix"), renderable->model_matrix));
 
-					auto sub_mesh = renderable->mesh->getSubMeshes().at(renderable->sub_mesh);
+					const asset::SubMesh& sub_mesh = renderable->mesh->getSubMeshes().at(renderable->sub_mesh);
 					// TODO (Hilze): Implement.
 					if (sub_mesh.io.double_sided == true || (sub_mesh.io.tex_alb >= 0 && renderable->mesh->getAttachedTextures().at(sub_mesh.io.tex_alb)->getLayer(0u).containsAlpha()))
 					{
@@ -512,13 +535,13 @@ namespace lambda
 				{
 					scene.renderer->setMesh(renderable->mesh);
 					//scene.shader_variable_manager.setVariable(platform::ShaderVariable(Name("metallic_roughness"), glm::vec2(renderable->metallicness, renderable->roughness)));
-					scene.renderer->setSubMesh(renderable->sub_mesh);
+					scene.renderer->setSubMesh(renderable->sub_mesh, renderable->lod);
 					scene.renderer->setTexture(renderable->albedo_texture, 0);
 					scene.renderer->setTexture(renderable->normal_texture, 1);
 					scene.renderer->setTexture(renderable->dmra_texture, 2);
 					//scene.shader_variable_manager.setVariable(platform::ShaderVariable(Name("model_matrix"), renderable->model_matrix));
 
-					auto sub_mesh = renderable->mesh->getSubMeshes().at(renderable->sub_mesh);
+					const asset::SubMesh& sub_mesh = renderable->mesh->getSubMeshes().at(renderable->sub_mesh);
 					// TODO (Hilze): Implement.
 					if (sub_mesh.io.double_sided == true || (sub_mesh.io.tex_alb >= 0 && renderable->mesh->getAttachedTextures().at(sub_mesh.io.tex_alb)->getLayer(0u).containsAlpha()))
 						scene.renderer->setRasterizerState(platform::RasterizerState::SolidNone());
@@ -559,6 +582,7 @@ namespace lambda
 				d.dmra_texture      = default_dmra;
 				d.emissive_texture  = default_emissive;
 				d.renderable.entity = entity;
+				d.renderable.index  = idx;
 
 				return d;
 			}
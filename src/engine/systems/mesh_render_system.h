@@ -5,6 +5,7 @@
 #include "assets/mesh_io.h"
 #include "utils/bvh.h"
 #include "utils/renderable.h"
+#include "platform/cluster_culling.h"
 
 namespace lambda
 {
@@ -106,6 +107,9 @@ namespace lambda
 				asset::VioletTextureHandle default_normal;
 				asset::VioletTextureHandle default_dmra;
 				asset::VioletTextureHandle default_emissive;
+
+				bool                             cull_clusters = true;
+				utilities::ClusterCulling::Stats cluster_stats; // Of the last camera.
 			};
 
 			MeshRenderComponent addComponent(const entity::Entity& entity, scene::Scene& scene);
@@ -147,6 +151,8 @@ namespace lambda
 			void createRenderList(utilities::Culler& culler, const utilities::Frustum& frustum, scene::Scene& scene);
 			void createSortedRenderList(utilities::LinkedNode* linked_node, Vector<utilities::Renderable*>& opaque, Vector<utilities::Renderable*>& alpha, scene::Scene& scene);
 			void createSortedRenderList(utilities::LinkedNode* linked_node, Vector<utilities::Renderable>& opaque, Vector<utilities::Renderable>& alpha, scene::Scene& scene);
+			// Asks the texture manager for the mips the visible renderables need, based on their size on screen.
+			void requestTextureMips(const Vector<utilities::Renderable>& renderables, const glm::mat4x4& projection, const glm::vec3& position, float screen_height);
 			void renderAll(utilities::Culler& culler, const utilities::Frustum& frustum, scene::Scene& scene, bool is_rh = true);
 			void renderAll(utilities::LinkedNode* statics, utilities::LinkedNode* dynamics, scene::Scene& scene, bool is_rh = true);
 			void renderAll(const Vector<utilities::Renderable*>& opaque, const Vector<utilities::Renderable*>& alpha, scene::Scene& scene, bool is_rh = true);
@@ -0,0 +1,115 @@
+#include "test.h"
+#include "assets/asset_handle.h"
+#include <atomic>
+#include <thread>
+
+namespace lambda
+{
+	namespace
+	{
+		const uint32_t kThreads = 8u;
+
+		// Stands in for an asset, only counts how often its last handle went away.
+		struct TestAsset
+		{
+			static void release(TestAsset* asset, const size_t& hash)
+			{
+				asset->released++;
+			}
+
+			std::atomic<uint32_t> released;
+		};
+
+		///////////////////////////////////////////////////////////////////////////
+		template<typename Function>
+		void runThreads(const Function& function)
+		{
+			std::thread threads[kThreads];
+			for (uint32_t i = 0u; i < kThreads; ++i)
+				threads[i] = std::thread(function, i);
+			for (std::thread& thread : threads)
+				thread.join();
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Copies made and dropped on many threads at once never lose a reference,
+	// the asset is released exactly once, by the last handle.
+	VIOLET_TEST(assetHandleCopiesKeepTheCount)
+	{
+		TestAsset asset;
+		asset.released = 0u;
+		const Name name("__asset_handle_test__");
+
+		{
+			asset::VioletHandle<TestAsset> handle(&asset, name);
+			runThreads([&handle](uint32_t) {
+				for (uint32_t i = 0u; i < 100000u; ++i)
+				{
+					asset::VioletHandle<TestAsset> copy(handle);
+					asset::VioletHandle<TestAsset> moved(eastl::move(copy));
+				}
+			});
+
+			VIOLET_CHECK(asset::VioletRefHandler<TestAsset>::getRefCount(name.getHash()) == 1u);
+			VIOLET_CHECK(asset.released == 0u);
+		}
+
+		VIOLET_CHECK(asset.released == 1u);
+		VIOLET_CHECK(asset::VioletRefHandler<TestAsset>::getRefCount(name.getHash()) == 0u);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Handles made from the name while others drop theirs all find the same
+	// slot, the asset stays alive while one of them is held.
+	VIOLET_TEST(assetHandleAcquireWhileReleasing)
+	{
+		TestAsset asset;
+		asset.released = 0u;
+		const Name name("__asset_handle_acquire_test__");
+
+		{
+			asset::VioletHandle<TestAsset> keep(&asset, name);
+			runThreads([&asset, &name](uint32_t) {
+				for (uint32_t i = 0u; i < 10000u; ++i)
+					asset::VioletHandle<TestAsset> handle(&asset, name);
+			});
+			VIOLET_CHECK(asset.released == 0u);
+		}
+		VIOLET_CHECK(asset.released == 1u);
+
+		// Without a handle to keep it alive the slot is given back and taken again
+		// all the time, it still ends up free. Every release is logged, so fewer rounds.
+		asset.released = 0u;
+		runThreads([&asset, &name](uint32_t) {
+			for (uint32_t i = 0u; i < 1000u; ++i)
+				asset::VioletHandle<TestAsset> handle(&asset, name);
+		});
+		VIOLET_CHECK(asset.released >= 1u);
+		VIOLET_CHECK(asset::VioletRefHandler<TestAsset>::getRefCount(name.getHash()) == 0u);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Eight threads copying the same handle, the worst case for the count.
+	VIOLET_TEST(assetHandleContentionBenchmark)
+	{
+		TestAsset asset;
+		asset.released = 0u;
+		asset::VioletHandle<TestAsset> handle(&asset, Name("__asset_handle_benchmark__"));
+		const uint32_t iterations = 1000000u;
+
+		for (uint32_t thread_count : { 1u, kThreads })
+		{
+			utilities::Timer timer;
+			runThreads([&handle, thread_count, iterations](uint32_t thread) {
+				if (thread >= thread_count)
+					return;
+				for (uint32_t i = 0u; i < iterations; ++i)
+					asset::VioletHandle<TestAsset> copy(handle);
+			});
+			test::report(thread_count == 1u ? "Handle copy, 1 thread" : "Handle copy, 8 threads", timer, iterations);
+		}
+
+		VIOLET_CHECK(asset.released == 0u);
+	}
+}
@@ -0,0 +1,152 @@
+#include "test.h"
+#include "platform/dynamic_resolution.h"
+#include <algorithm>
+#include <cmath>
+
+namespace lambda
+{
+	namespace
+	{
+		///////////////////////////////////////////////////////////////////////////
+		// Feeds the controller frame_count frames of a GPU whose cost is split in
+		// a part that scales with the pixels and a fixed part. Returns the scale
+		// after every frame.
+		template<typename Cost>
+		Vector<float> runTrace(platform::DynamicResolution& controller, uint32_t frame_count, const Cost& cost)
+		{
+			Vector<float> scales;
+			float scale = controller.getScale();
+			for (uint32_t frame = 0u; frame < frame_count; ++frame)
+			{
+				const float gpu_time = cost(frame, scale);
+				scale = controller.update(gpu_time + 1.0f, gpu_time);
+				scales.push_back(scale);
+			}
+			return scales;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		platform::DynamicResolution makeController()
+		{
+			platform::DynamicResolution::Settings settings;
+			settings.enabled = true;
+			platform::DynamicResolution controller;
+			controller.setSettings(settings);
+			controller.reset();
+			return controller;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t countChanges(const Vector<float>& scales, uint32_t first)
+		{
+			uint32_t changes = 0u;
+			for (uint32_t i = std::max(first, 1u); i < (uint32_t)scales.size(); ++i)
+				changes += scales[i] != scales[i - 1u] ? 1u : 0u;
+			return changes;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		// Same numbers on every platform.
+		float noise(uint32_t frame)
+		{
+			uint32_t state = frame * 747796405u + 2891336453u;
+			state = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+			return (float)((state >> 22u) ^ state) / 4294967295.0f * 2.0f - 1.0f;
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	VIOLET_TEST(dynamicResolutionDisabledKeepsFullScale)
+	{
+		platform::DynamicResolution controller;
+		const Vector<float> scales = runTrace(controller, 100u, [](uint32_t, float) { return 40.0f; });
+		VIOLET_CHECK(scales.back() == 1.0f);
+		VIOLET_CHECK(countChanges(scales, 0u) == 0u);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Work that fits the budget at full resolution never lowers the scale.
+	VIOLET_TEST(dynamicResolutionLightLoadStaysAtFullScale)
+	{
+		platform::DynamicResolution controller = makeController();
+		const Vector<float> scales = runTrace(controller, 600u, [](uint32_t, float scale) { return 2.0f + 8.0f * scale * scale; });
+		VIOLET_CHECK(countChanges(scales, 0u) == 0u);
+		VIOLET_CHECK(scales.back() == 1.0f);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// A load of twice the budget settles inside the band and stays there.
+	// Steps are limited, on the grid and a cooldown apart.
+	VIOLET_TEST(dynamicResolutionHeavyLoadSettles)
+	{
+		platform::DynamicResolution controller = makeController();
+		const platform::DynamicResolution::Settings& settings = controller.getSettings();
+		const auto cost = [](uint32_t, float scale) { return 2.0f + 30.0f * scale * scale; };
+		const Vector<float> scales = runTrace(controller, 600u, cost);
+
+		const float time = cost(0u, scales.back());
+		VIOLET_CHECK(time <= settings.target_frame_time * (1.0f + settings.scale_down_threshold));
+		VIOLET_CHECK(time >= settings.target_frame_time * (1.0f - settings.scale_up_threshold));
+		VIOLET_CHECK(countChanges(scales, 300u) == 0u);
+
+		int last_change = -1; // The first update counts towards the cooldown.
+		for (uint32_t i = 1u; i < (uint32_t)scales.size(); ++i)
+		{
+			if (scales[i] == scales[i - 1u])
+				continue;
+			VIOLET_CHECK(scales[i - 1u] - scales[i] <= settings.max_step_down + 0.0001f);
+			VIOLET_CHECK(scales[i] - scales[i - 1u] <= settings.max_step_up + 0.0001f);
+			VIOLET_CHECK((int)i - last_change >= (int)settings.cooldown_frames);
+			const float steps = scales[i] / settings.granularity;
+			VIOLET_CHECK(std::abs(steps - std::round(steps)) < 0.001f);
+			last_change = (int)i;
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Timings that jitter by 10% around a settled load do not make the scale oscillate.
+	VIOLET_TEST(dynamicResolutionIgnoresNoise)
+	{
+		platform::DynamicResolution controller = makeController();
+		const Vector<float> scales = runTrace(controller, 1200u, [](uint32_t frame, float scale) {
+			return (2.0f + 24.0f * scale * scale) * (1.0f + 0.1f * noise(frame));
+		});
+		VIOLET_CHECK(countChanges(scales, 400u) <= 2u);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// The load drops after a heavy section, the scale climbs back to full.
+	// Loads that can not fit the budget stop at the minimum scale.
+	VIOLET_TEST(dynamicResolutionFollowsTheLoad)
+	{
+		platform::DynamicResolution controller = makeController();
+		const Vector<float> scales = runTrace(controller, 1200u, [](uint32_t frame, float scale) {
+			return frame < 400u ? 2.0f + 30.0f * scale * scale : 2.0f + 8.0f * scale * scale;
+		});
+		VIOLET_CHECK(scales[399u] < 1.0f);
+		VIOLET_CHECK(scales.back() == 1.0f);
+
+		platform::DynamicResolution overloaded = makeController();
+		const Vector<float> minimum = runTrace(overloaded, 600u, [](uint32_t, float scale) { return 2.0f + 200.0f * scale * scale; });
+		VIOLET_CHECK(minimum.back() == overloaded.getSettings().min_scale);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Without GPU timers the frame time drives the scale. The same trace always
+	// gives the same scales.
+	VIOLET_TEST(dynamicResolutionIsDeterministic)
+	{
+		const auto trace = [](uint32_t frame, float scale) { return (2.0f + 30.0f * scale * scale) * (1.0f + 0.2f * noise(frame)); };
+
+		platform::DynamicResolution a = makeController();
+		platform::DynamicResolution b = makeController();
+		VIOLET_CHECK(runTrace(a, 500u, trace) == runTrace(b, 500u, trace));
+
+		platform::DynamicResolution cpu_only = makeController();
+		float scale = 1.0f;
+		for (uint32_t frame = 0u; frame < 300u; ++frame)
+			scale = cpu_only.update(trace(frame, scale), 0.0f);
+		VIOLET_CHECK(scale < 1.0f);
+		VIOLET_CHECK(cpu_only.getSmoothedGpuTime() == 0.0f);
+	}
+}
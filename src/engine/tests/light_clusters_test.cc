@@ -0,0 +1,202 @@
+#include "test.h"
+#include "platform/light_clusters.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace lambda
+{
+	namespace
+	{
+		const uint32_t kSizeX = 16u;
+		const uint32_t kSizeY = 9u;
+		const uint32_t kSizeZ = 24u;
+		const float    kNear  = 0.1f;
+		const float    kFar   = 100.0f;
+
+		struct Bounds
+		{
+			glm::vec3 min;
+			glm::vec3 max;
+		};
+
+		///////////////////////////////////////////////////////////////////////////
+		// Same random numbers on every platform, so a failure can be reproduced.
+		float random(uint32_t& state)
+		{
+			state = state * 1664525u + 1013904223u;
+			return (float)(state >> 8u) / (float)(1u << 24u);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		Vector<platform::LightClusters::Light> makeLights(uint32_t count)
+		{
+			uint32_t state = 1u;
+			Vector<platform::LightClusters::Light> lights(count);
+			for (platform::LightClusters::Light& light : lights)
+			{
+				// In front of a camera looking down -z, never closer than near or further than far.
+				light.radius   = 0.5f + random(state) * 3.5f;
+				light.position = glm::vec3((random(state) - 0.5f) * 120.0f, (random(state) - 0.5f) * 70.0f, -(5.0f + random(state) * 90.0f));
+				light.colour   = glm::vec3(random(state), random(state), random(state));
+				light.padding  = 0.0f;
+			}
+			return lights;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		// The view space box of every cluster, worked out one cluster at a time.
+		Vector<Bounds> makeClusterBounds(const glm::mat4x4& projection)
+		{
+			const glm::mat4x4 inverse_projection = glm::inverse(projection);
+			auto unproject = [&inverse_projection](float x, float y, float z) {
+				const glm::vec4 p = inverse_projection * glm::vec4(x, y, z, 1.0f);
+				return glm::vec3(p) / p.w;
+			};
+
+			Vector<Bounds> clusters(kSizeX * kSizeY * kSizeZ);
+			for (uint32_t z = 0u; z < kSizeZ; ++z)
+			for (uint32_t y = 0u; y < kSizeY; ++y)
+			for (uint32_t x = 0u; x < kSizeX; ++x)
+			{
+				const float depths[2] = {
+					kNear * std::pow(kFar / kNear, (float)z / (float)kSizeZ),
+					kNear * std::pow(kFar / kNear, (float)(z + 1u) / (float)kSizeZ)
+				};
+
+				Bounds& bounds = clusters[x + (y + z * kSizeY) * kSizeX];
+				bounds.min = glm::vec3(FLT_MAX);
+				bounds.max = glm::vec3(-FLT_MAX);
+				for (uint32_t corner = 0u; corner < 4u; ++corner)
+				{
+					// Tile y = 0 is the top of the screen.
+					const float ndc_x = -1.0f + 2.0f * (float)(x + (corner & 1u)) / (float)kSizeX;
+					const float ndc_y =  1.0f - 2.0f * (float)(y + (corner >> 1u)) / (float)kSizeY;
+					glm::vec3 a = unproject(ndc_x, ndc_y, 0.25f);
+					glm::vec3 b = unproject(ndc_x, ndc_y, 0.75f);
+					a.z = -a.z;
+					b.z = -b.z;
+
+					for (float depth : depths)
+					{
+						const glm::vec3 p = a + (b - a) * ((depth - a.z) / (b.z - a.z));
+						bounds.min = glm::min(bounds.min, p);
+						bounds.max = glm::max(bounds.max, p);
+					}
+				}
+			}
+			return clusters;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		float distanceSquared(const glm::vec3& center, const Bounds& bounds)
+		{
+			const glm::vec3 d = glm::max(bounds.min - center, glm::vec3(0.0f)) + glm::max(center - bounds.max, glm::vec3(0.0f));
+			return glm::dot(d, d);
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Every cluster holds exactly the lights whose sphere touches its box. Lights
+	// that graze a box are allowed either way, the SIMD test rounds differently.
+	VIOLET_TEST(lightClustersMatchBruteForce)
+	{
+		const glm::mat4x4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, kNear, kFar);
+		const glm::mat4x4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		const Vector<platform::LightClusters::Light> lights = makeLights(1000u);
+
+		platform::LightClusters clusters;
+		clusters.initialize(kSizeX, kSizeY, kSizeZ, 1024u, 256u);
+		clusters.setProjection(projection, kNear, kFar);
+		clusters.build(view, lights);
+		VIOLET_CHECK(clusters.getLightCount() == (uint32_t)lights.size());
+
+		const Vector<Bounds> reference = makeClusterBounds(projection);
+		const Vector<platform::LightClusters::Cluster>& result = clusters.getClusters();
+		const Vector<uint16_t>& indices = clusters.getIndices();
+		VIOLET_CHECK(result.size() == reference.size());
+
+		uint32_t mismatches = 0u;
+		uint32_t total = 0u;
+		for (uint32_t i = 0u; i < (uint32_t)reference.size() && i < (uint32_t)result.size(); ++i)
+		{
+			uint32_t must = 0u;
+			uint32_t may  = 0u;
+			for (const platform::LightClusters::Light& light : lights)
+			{
+				glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+				center.z = -center.z;
+				const float d2 = distanceSquared(center, reference[i]);
+				const float r2 = light.radius * light.radius;
+				must += d2 <= r2 * 0.999f ? 1u : 0u;
+				may  += d2 <= r2 * 1.001f ? 1u : 0u;
+			}
+
+			const uint32_t count = result[i].count;
+			if (count < std::min(must, 256u) || count > std::min(may, 256u))
+				mismatches++;
+			total += count;
+
+			// Every listed light has to be able to reach the cluster.
+			for (uint32_t j = 0u; j < count && result[i].offset + j < (uint32_t)indices.size(); ++j)
+			{
+				const platform::LightClusters::Light& light = lights[indices[result[i].offset + j]];
+				glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+				center.z = -center.z;
+				if (distanceSquared(center, reference[i]) > light.radius * light.radius * 1.001f)
+					mismatches++;
+			}
+		}
+
+		VIOLET_CHECK(mismatches == 0u);
+		VIOLET_CHECK(total == (uint32_t)indices.size());
+		VIOLET_CHECK(total > 0u);
+		clusters.deinitialize();
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Lights behind the camera or past the far plane never reach the index list.
+	VIOLET_TEST(lightClustersSkipLightsOutsideTheRange)
+	{
+		const glm::mat4x4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, kNear, kFar);
+		Vector<platform::LightClusters::Light> lights(2u);
+		lights[0].position = glm::vec3(0.0f, 0.0f, 5.0f);
+		lights[0].radius   = 1.0f;
+		lights[1].position = glm::vec3(0.0f, 0.0f, -200.0f);
+		lights[1].radius   = 1.0f;
+
+		platform::LightClusters clusters;
+		clusters.initialize(kSizeX, kSizeY, kSizeZ, 1024u, 256u);
+		clusters.setProjection(projection, kNear, kFar);
+		clusters.build(glm::mat4x4(1.0f), lights);
+		VIOLET_CHECK(clusters.getLightCount() == 0u);
+		VIOLET_CHECK(clusters.getIndices().empty());
+		clusters.deinitialize();
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	VIOLET_TEST(lightClustersBuildBenchmark)
+	{
+		const glm::mat4x4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, kNear, kFar);
+		const Vector<platform::LightClusters::Light> lights = makeLights(1000u);
+		const uint32_t iterations = 100u;
+
+		platform::LightClusters clusters;
+		clusters.initialize(kSizeX, kSizeY, kSizeZ, 1024u, 256u);
+		clusters.setProjection(projection, kNear, kFar);
+
+		for (uint32_t job_count : { 1u, 4u })
+		{
+			clusters.build(glm::mat4x4(1.0f), lights, job_count);
+
+			utilities::Timer timer;
+			for (uint32_t i = 0u; i < iterations; ++i)
+				clusters.build(glm::mat4x4(1.0f), lights, job_count);
+			test::report(job_count == 1u ? "1k lights, 16x9x24, 1 job" : "1k lights, 16x9x24, 4 jobs", timer, iterations);
+		}
+
+		VIOLET_CHECK(clusters.getLightCount() == (uint32_t)lights.size());
+		clusters.deinitialize();
+	}
+}
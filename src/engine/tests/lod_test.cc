@@ -0,0 +1,194 @@
+#include "test.h"
+#include "systems/lod_system.h"
+#include "platform/scene.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+
+namespace lambda
+{
+	namespace
+	{
+		using namespace components;
+
+		// Full detail, two LODs and the impostor of the mesh below, in local units.
+		const float    kErrors[4]       = { 0.0f, 0.01f, 0.05f, 0.2f };
+		const uint32_t kTriangles[4]    = { 1000u, 500u, 100u, 2u };
+		const float    kResolution      = 1000.0f;
+		// Distances to the center of a renderable with a radius of one, at which
+		// a 90 degree view on a target of kResolution pixels picks the level.
+		const float    kLevelDistance[4] = { 2.0f, 10.0f, 50.0f, 200.0f };
+
+		///////////////////////////////////////////////////////////////////////////
+		asset::VioletMeshHandle makeMesh()
+		{
+			asset::SubMesh sub_mesh;
+			sub_mesh.offset(asset::MeshElements::kIndices) = asset::SubMesh::Offset(0u, kTriangles[0] * 3u, sizeof(uint32_t));
+			for (uint32_t level = 1u; level < 3u; ++level)
+			{
+				asset::SubMesh::LOD lod;
+				lod.indices = asset::SubMesh::Offset(0u, kTriangles[level] * 3u, sizeof(uint32_t));
+				lod.error   = kErrors[level];
+				sub_mesh.lods.push_back(lod);
+			}
+			sub_mesh.impostor.rect   = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+			sub_mesh.impostor.center = glm::vec3(0.0f);
+			sub_mesh.impostor.radius = 1.0f;
+			sub_mesh.impostor.error  = kErrors[3];
+
+			asset::Mesh mesh;
+			mesh.setSubMeshes({ sub_mesh });
+			mesh.setImpostor(asset::VioletTextureHandle(), asset::VioletTextureHandle(), 8u);
+			return asset::MeshManager::getInstance()->create(Name("__lod_test__"), mesh);
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		Vector<utilities::Renderable> makeRenderables(asset::VioletMeshHandle mesh, uint32_t count, float distance, scene::Scene& scene)
+		{
+			Vector<utilities::Renderable> renderables(count);
+			for (uint32_t i = 0u; i < count; ++i)
+			{
+				renderables[i].mesh         = mesh;
+				renderables[i].model_matrix = glm::mat4x4(1.0f);
+				renderables[i].center       = glm::vec3(0.0f, 0.0f, -distance);
+				renderables[i].radius       = 1.0f;
+				renderables[i].index        = i;
+			}
+			if (scene.mesh_render.data.size() < count)
+				scene.mesh_render.data.resize(count);
+			return renderables;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		LODSystem::View makeView(uint64_t key, bool cross_fade, bool impostors)
+		{
+			LODSystem::View view;
+			view.key        = key;
+			view.projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 1000.0f);
+			view.position   = glm::vec3(0.0f);
+			view.resolution = kResolution;
+			view.cross_fade = cross_fade;
+			view.impostors  = impostors;
+			return view;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void select(const LODSystem::View& view, Vector<utilities::Renderable>& renderables, scene::Scene& scene)
+		{
+			LODSystem::selectLODs(view, { &renderables }, scene);
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// The coarsest level below the threshold wins, ties included. Going finer
+	// happens at once, going coarser only below the hysteresis band.
+	VIOLET_TEST(lodSelectLevelUsesHysteresis)
+	{
+		const uint32_t kNotSeen = 8u;
+		VIOLET_CHECK(LODSystem::selectLevel(kErrors, 4u, 100.0f, kNotSeen, 1.0f, 0.2f) == 1u);
+		VIOLET_CHECK(LODSystem::selectLevel(kErrors, 4u, 20.0f, kNotSeen, 1.0f, 0.2f) == 2u);
+		VIOLET_CHECK(LODSystem::selectLevel(kErrors, 4u, 1000.0f, kNotSeen, 1.0f, 0.2f) == 0u);
+		VIOLET_CHECK(LODSystem::selectLevel(kErrors, 4u, 1.0f, kNotSeen, 1.0f, 0.2f) == 3u);
+		VIOLET_CHECK(LODSystem::selectLevel(kErrors, 3u, 1.0f, kNotSeen, 1.0f, 0.2f) == 2u);
+
+		// Just past the boundary of level two the error is within the band.
+		VIOLET_CHECK(LODSystem::selectLevel(kErrors, 4u, 19.0f, 1u, 1.0f, 0.2f) == 1u);
+		VIOLET_CHECK(LODSystem::selectLevel(kErrors, 4u, 15.0f, 1u, 1.0f, 0.2f) == 2u);
+		VIOLET_CHECK(LODSystem::selectLevel(kErrors, 4u, 21.0f, 2u, 1.0f, 0.2f) == 1u);
+
+		// Wobbling around a boundary switches once, not every frame.
+		uint32_t level    = LODSystem::selectLevel(kErrors, 4u, 10.0f, kNotSeen, 1.0f, 0.2f);
+		uint32_t switches = 0u;
+		for (uint32_t frame = 0u; frame < 100u; ++frame)
+		{
+			const uint32_t next = LODSystem::selectLevel(kErrors, 4u, frame % 2u ? 19.0f : 21.0f, level, 1.0f, 0.2f);
+			switches += next != level ? 1u : 0u;
+			level = next;
+		}
+		VIOLET_CHECK(switches == 1u);
+		VIOLET_CHECK(level == 1u);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Far renderables end up on the impostor, the level after the last LOD,
+	// unless the view does not allow impostors.
+	VIOLET_TEST(lodSelectsImpostorsFarAway)
+	{
+		scene::Scene scene;
+		asset::VioletMeshHandle mesh = makeMesh();
+
+		for (uint32_t level = 0u; level < 4u; ++level)
+		{
+			Vector<utilities::Renderable> renderables = makeRenderables(mesh, 1u, kLevelDistance[level], scene);
+			select(makeView(level, false, true), renderables, scene);
+			VIOLET_CHECK(renderables[0].lod == level);
+			VIOLET_CHECK(renderables[0].fade_lod == level);
+			VIOLET_CHECK(renderables[0].lod_fade == 1.0f);
+
+			select(makeView(level + 4u, false, false), renderables, scene);
+			VIOLET_CHECK(renderables[0].lod == std::min(level, 2u));
+		}
+
+		// The impostor error stays above the last LOD, even if it was baked lower.
+		mesh->getSubMeshes()[0].impostor.error = 0.0f;
+		Vector<utilities::Renderable> renderables = makeRenderables(mesh, 1u, kLevelDistance[1], scene);
+		select(makeView(8u, false, true), renderables, scene);
+		VIOLET_CHECK(renderables[0].lod == 1u);
+		mesh->getSubMeshes()[0].impostor.error = kErrors[3];
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// A level change cross-fades from the level that was visible, views that
+	// do not cross-fade swap at once.
+	VIOLET_TEST(lodCrossFadesLevelChanges)
+	{
+		scene::Scene scene;
+		scene.lod.fade_step = 0.25f;
+		asset::VioletMeshHandle mesh = makeMesh();
+		Vector<utilities::Renderable> renderables = makeRenderables(mesh, 1u, kLevelDistance[1], scene);
+		const LODSystem::View view = makeView(0u, true, true);
+
+		select(view, renderables, scene);
+		VIOLET_CHECK(renderables[0].lod == 1u && renderables[0].lod_fade == 1.0f);
+
+		renderables[0].center.z = -kLevelDistance[3];
+		select(view, renderables, scene);
+		VIOLET_CHECK(renderables[0].lod == 3u);
+		VIOLET_CHECK(renderables[0].fade_lod == 1u);
+		VIOLET_CHECK(renderables[0].lod_fade == 0.0f);
+
+		for (uint32_t frame = 1u; frame <= 4u; ++frame)
+		{
+			select(view, renderables, scene);
+			VIOLET_CHECK(renderables[0].lod == 3u);
+			VIOLET_CHECK(renderables[0].lod_fade == 0.25f * frame);
+		}
+
+		// A view without cross-fading swaps at once.
+		select(makeView(1u, false, true), renderables, scene);
+		renderables[0].center.z = -kLevelDistance[0];
+		select(makeView(1u, false, true), renderables, scene);
+		VIOLET_CHECK(renderables[0].lod == 0u && renderables[0].fade_lod == 0u && renderables[0].lod_fade == 1.0f);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Over the triangle budget the threshold doubles until the levels fit.
+	VIOLET_TEST(lodKeepsTheTriangleBudget)
+	{
+		scene::Scene scene;
+		asset::VioletMeshHandle mesh = makeMesh();
+		Vector<utilities::Renderable> renderables = makeRenderables(mesh, 16u, kLevelDistance[1], scene);
+
+		select(makeView(0u, false, true), renderables, scene);
+		for (const utilities::Renderable& renderable : renderables)
+			VIOLET_CHECK(renderable.lod == 1u);
+
+		scene.lod.triangle_budget = 16u * kTriangles[2] + 400u;
+		select(makeView(1u, false, true), renderables, scene);
+		uint64_t triangles = 0u;
+		for (const utilities::Renderable& renderable : renderables)
+			triangles += kTriangles[renderable.lod];
+		VIOLET_CHECK(triangles <= scene.lod.triangle_budget);
+		VIOLET_CHECK(renderables[0].lod == 2u);
+		VIOLET_CHECK(scene.lod.views[1u].budget_scale == 4.0f);
+	}
+}
@@ -0,0 +1,70 @@
+#include "test.h"
+#include "utils/mt_manager.h"
+#include <utils/console.h>
+
+namespace lambda
+{
+	namespace test
+	{
+		static Test* k_tests  = nullptr;
+		static bool  k_failed = false;
+
+		///////////////////////////////////////////////////////////////////////////
+		Test::Test(const char* name, void(*function)())
+			: name(name)
+			, function(function)
+			, next(k_tests)
+		{
+			k_tests = this;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		Test* getTests()
+		{
+			return k_tests;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void fail(const char* file, int line, const char* expression)
+		{
+			foundation::Error(String("\t") + file + "(" + toString(line) + "): " + expression + "\n");
+			k_failed = true;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		void report(const char* name, const utilities::Timer& timer, uint32_t iterations)
+		{
+			const double us = timer.elapsed().microseconds() / (double)iterations;
+			foundation::Info(String("\t") + name + ": " + toString((float)us) + "us\n");
+		}
+	}
+}
+
+// Runs every test, or only the ones whose name contains the first argument.
+int main(int argc, char** argv)
+{
+	using namespace lambda;
+
+	uint32_t run    = 0u;
+	uint32_t failed = 0u;
+	for (test::Test* test = test::getTests(); test != nullptr; test = test->next)
+	{
+		if (argc > 1 && String(test->name).find(argv[1]) == String::npos)
+			continue;
+
+		foundation::Info(String(test->name) + "\n");
+		test::k_failed = false;
+		test->function();
+		run++;
+		if (test::k_failed)
+			failed++;
+	}
+
+	platform::TaskScheduler::terminate();
+
+	if (failed > 0u)
+		foundation::Error(toString(failed) + " of " + toString(run) + " tests failed\n");
+	else
+		foundation::Info(toString(run) + " tests passed\n");
+	return failed > 0u ? 1 : 0;
+}
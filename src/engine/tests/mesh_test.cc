@@ -0,0 +1,124 @@
+#include "test.h"
+#include "assets/mesh.h"
+#include <memory/memory.h>
+
+namespace lambda
+{
+	namespace
+	{
+		// Everything an import or a copy may allocate besides the streams: the
+		// sub meshes, the maps of the mesh and a block of handle slots. Less than
+		// the smallest stream, so copying any stream twice is noticed.
+		const size_t kOverhead = 64u * 1024u;
+
+		///////////////////////////////////////////////////////////////////////////
+		template<typename T>
+		void fill(VioletDataInfo& info, const Vector<T>& elements)
+		{
+			info.data.resize(elements.size() * sizeof(T));
+			memcpy(info.data.data(), elements.data(), info.data.size());
+			info.segments.push_back(VioletDataSegment{ 0u, elements.size(), sizeof(T) });
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		// One sub mesh of vertex_count vertices, with as many triangles.
+		VioletMesh makeMesh(uint32_t vertex_count)
+		{
+			Vector<glm::vec3> positions(vertex_count);
+			Vector<glm::vec3> normals(vertex_count, glm::vec3(0.0f, 1.0f, 0.0f));
+			Vector<glm::vec4> tangents(vertex_count, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+			Vector<glm::vec2> tex_coords(vertex_count);
+			Vector<uint32_t>  indices(vertex_count * 3u);
+			for (uint32_t i = 0u; i < vertex_count; ++i)
+			{
+				positions[i]  = glm::vec3((float)(i % 100u), (float)(i / 100u), 0.0f);
+				tex_coords[i] = glm::vec2(positions[i]) * 0.01f;
+			}
+			for (uint32_t i = 0u; i < (uint32_t)indices.size(); ++i)
+				indices[i] = (i * 7u) % vertex_count;
+
+			VioletMesh mesh;
+			mesh.file = "__mesh_test__";
+			fill(mesh.data.pos, positions);
+			fill(mesh.data.nor, normals);
+			fill(mesh.data.tan, tangents);
+			fill(mesh.data.tex, tex_coords);
+			fill(mesh.data.idx, indices);
+
+			VioletSubMesh sub_mesh;
+			sub_mesh.pos = sub_mesh.nor = sub_mesh.tan = sub_mesh.tex = sub_mesh.idx = 0;
+			sub_mesh.aabb_max = glm::vec3(99.0f, (float)(vertex_count / 100u), 0.0f);
+			mesh.meshes.push_back(sub_mesh);
+			return mesh;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		size_t allocated()
+		{
+			return foundation::Memory::default_allocator()->total_allocated();
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Importing copies every stream out of the loaded mesh once. Copies of the
+	// mesh and views into it share that memory.
+	VIOLET_TEST(meshImportCopiesStreamsOnce)
+	{
+		const VioletMesh source = makeMesh(20000u);
+		// The tangents lose their w on import.
+		const size_t stream_bytes = source.data.pos.data.size() + source.data.nor.data.size() + source.data.tan.data.size() / 4u * 3u +
+			source.data.tex.data.size() + source.data.idx.data.size();
+		asset::MeshManager* manager = asset::MeshManager::getInstance();
+		const Name name(source.file);
+
+		const size_t before = allocated();
+		asset::VioletMeshHandle mesh = manager->create(name, source);
+		const size_t imported = allocated() - before;
+		VIOLET_CHECK(imported >= stream_bytes);
+		VIOLET_CHECK(imported < stream_bytes + kOverhead);
+
+		const size_t before_copy = allocated();
+		const asset::Mesh copy = *mesh.get();
+		VIOLET_CHECK(allocated() - before_copy < kOverhead);
+		VIOLET_CHECK(copy.get(asset::MeshElements::kPositions).data == mesh->get(asset::MeshElements::kPositions).data);
+		VIOLET_CHECK(copy.get(asset::MeshElements::kIndices).data == mesh->get(asset::MeshElements::kIndices).data);
+		VIOLET_CHECK(mesh->get(asset::MeshElements::kPositions).isShared());
+
+		const size_t before_view = allocated();
+		const asset::MeshView<glm::vec3> positions = mesh->get<glm::vec3>(asset::MeshElements::kPositions, 0u);
+		const asset::MeshView<uint32_t> indices = mesh->get<uint32_t>(asset::MeshElements::kIndices, 0u);
+		VIOLET_CHECK(allocated() == before_view);
+		VIOLET_CHECK(positions.size() == 20000u && indices.size() == 60000u);
+		VIOLET_CHECK(&positions[0] == (const glm::vec3*)mesh->get(asset::MeshElements::kPositions).data);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Collider creation only allocates the scaled vertices and the int indices
+	// the physics engine keeps, the mesh itself is read in place.
+	VIOLET_TEST(meshColliderOnlyAllocatesItsArrays)
+	{
+		const VioletMesh source = makeMesh(20000u);
+		asset::VioletMeshHandle mesh = asset::MeshManager::getInstance()->create(Name(source.file), source);
+		const glm::vec3 scale(2.0f, 3.0f, 4.0f);
+
+		const size_t before = allocated();
+		const asset::Mesh::ColliderData data = mesh->makeColliderData(0u, scale);
+		const size_t used = allocated() - before;
+		const size_t arrays = data.vertex_count * sizeof(glm::vec3) + data.index_count * sizeof(int);
+		VIOLET_CHECK(data.vertex_count == 20000u && data.index_count == 60000u);
+		VIOLET_CHECK(used >= arrays);
+		VIOLET_CHECK(used < arrays + 256u); // Two allocation headers.
+
+		const asset::MeshView<glm::vec3> positions = mesh->get<glm::vec3>(asset::MeshElements::kPositions, 0u);
+		const asset::MeshView<uint32_t> indices = mesh->get<uint32_t>(asset::MeshElements::kIndices, 0u);
+		bool same = true;
+		for (size_t i = 0u; i < data.vertex_count; ++i)
+			same &= data.vertices[i] == positions[i] * scale;
+		for (size_t i = 0u; i < data.index_count; ++i)
+			same &= data.indices[i] == (int)indices[i];
+		VIOLET_CHECK(same);
+
+		foundation::Memory::deallocate(data.vertices);
+		foundation::Memory::deallocate(data.indices);
+	}
+}
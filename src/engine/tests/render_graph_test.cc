@@ -0,0 +1,211 @@
+#include "test.h"
+#include "platform/render_graph.h"
+
+namespace lambda
+{
+	namespace
+	{
+		using RenderGraph = platform::RenderGraph;
+
+		///////////////////////////////////////////////////////////////////////////
+		// Replays the barriers of the compiled graph. Every pass has to find the
+		// resources it reads readable and the ones it writes writable.
+		bool barriersAreValid(const RenderGraph& graph)
+		{
+			const Vector<RenderGraph::Resource>& resources = graph.getResources();
+			Vector<RenderGraph::ResourceState> states(resources.size(), RenderGraph::ResourceState::kShaderRead);
+			for (uint32_t i = 0u; i < resources.size(); ++i)
+				if (resources[i].transient)
+					states[i] = RenderGraph::ResourceState::kUndefined;
+
+			bool valid = true;
+			for (const RenderGraph::CompiledPass& compiled_pass : graph.getCompiledPasses())
+			{
+				// A transient resource that starts living in shared memory discards the old content.
+				for (const RenderGraph::Barrier& barrier : compiled_pass.barriers)
+				{
+					valid &= barrier.before == states[barrier.resource] || barrier.before == RenderGraph::ResourceState::kUndefined;
+					states[barrier.resource] = barrier.after;
+				}
+
+				const RenderGraph::Pass& pass = graph.getPasses()[compiled_pass.pass];
+				for (uint32_t resource : pass.reads)
+					valid &= states[resources[resource].physical] == RenderGraph::ResourceState::kShaderRead;
+				for (uint32_t resource : pass.writes)
+					valid &= states[resources[resource].physical] == RenderGraph::ResourceState::kRenderTarget;
+			}
+
+			for (const RenderGraph::Barrier& barrier : graph.getFinalBarriers())
+				states[barrier.resource] = barrier.after;
+			for (uint32_t i = 0u; i < resources.size(); ++i)
+				if (!resources[i].transient)
+					valid &= states[i] == RenderGraph::ResourceState::kShaderRead;
+			return valid;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		// Resources that share memory are never alive at the same time and would
+		// have been created the same way. Persistent resources never share.
+		bool aliasingIsValid(const RenderGraph& graph)
+		{
+			const Vector<RenderGraph::Resource>& resources = graph.getResources();
+			bool valid = true;
+			for (uint32_t a = 0u; a < resources.size(); ++a)
+			{
+				if (!resources[a].transient)
+					valid &= resources[a].physical == a;
+				if (resources[a].first_use == RenderGraph::kInvalid)
+					continue;
+
+				for (uint32_t b = a + 1u; b < resources.size(); ++b)
+				{
+					if (resources[b].first_use == RenderGraph::kInvalid || resources[a].physical != resources[b].physical)
+						continue;
+					valid &= resources[a].transient && resources[b].transient;
+					valid &= resources[a].last_use < resources[b].first_use || resources[b].last_use < resources[a].first_use;
+					valid &= resources[a].format == resources[b].format && resources[a].render_scale == resources[b].render_scale;
+				}
+			}
+			return valid;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint32_t random(uint32_t& state, uint32_t count)
+		{
+			state = state * 1664525u + 1013904223u;
+			return (state >> 8u) % count;
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// A post process chain: every other target can share memory, only the
+	// back buffer is kept. The barriers follow the reads and writes.
+	VIOLET_TEST(renderGraphAliasesAPostChain)
+	{
+		RenderGraph graph;
+		const uint32_t back_buffer = graph.addResource(Name("back_buffer"), 1.0f, TextureFormat::kR8G8B8A8, true);
+		const uint32_t scene = graph.addResource(Name("scene"), 1.0f, TextureFormat::kR16G16B16A16, false);
+		const uint32_t blur_x = graph.addResource(Name("blur_x"), 1.0f, TextureFormat::kR16G16B16A16, false);
+		const uint32_t blur_y = graph.addResource(Name("blur_y"), 1.0f, TextureFormat::kR16G16B16A16, false);
+		graph.addPass(Name("scene"), {}, { scene });
+		graph.addPass(Name("blur_x"), { scene }, { blur_x });
+		graph.addPass(Name("blur_y"), { blur_x }, { blur_y });
+		graph.addPass(Name("tone_map"), { blur_y }, { back_buffer });
+		graph.addOutput(back_buffer);
+		graph.compile();
+
+		const Vector<RenderGraph::Resource>& resources = graph.getResources();
+		VIOLET_CHECK(graph.getCompiledPasses().size() == 4u);
+		VIOLET_CHECK(!resources[back_buffer].transient);
+		VIOLET_CHECK(resources[scene].transient && resources[blur_x].transient && resources[blur_y].transient);
+		VIOLET_CHECK(resources[blur_y].physical == scene);
+		VIOLET_CHECK(resources[blur_x].physical == blur_x);
+		VIOLET_CHECK(graph.getPhysicalCount() == 3u);
+
+		// Blur y starts out in the memory of the scene target, whose content is not needed anymore.
+		const Vector<RenderGraph::Barrier>& barriers = graph.getCompiledPasses()[2].barriers;
+		bool discards = false;
+		for (const RenderGraph::Barrier& barrier : barriers)
+			discards |= barrier.resource == scene && barrier.before == RenderGraph::ResourceState::kUndefined && barrier.after == RenderGraph::ResourceState::kRenderTarget;
+		VIOLET_CHECK(discards);
+		VIOLET_CHECK(graph.getFinalBarriers().size() == 1u && graph.getFinalBarriers()[0].resource == back_buffer);
+		VIOLET_CHECK(barriersAreValid(graph));
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Passes that do not lead to an output are culled, so are writes that are
+	// overwritten before anything reads them.
+	VIOLET_TEST(renderGraphCullsDeadPasses)
+	{
+		RenderGraph graph;
+		const uint32_t output = graph.addResource(Name("output"), 1.0f, TextureFormat::kR8G8B8A8, true);
+		const uint32_t used = graph.addResource(Name("used"), 1.0f, TextureFormat::kR8G8B8A8, false);
+		const uint32_t unused = graph.addResource(Name("unused"), 0.5f, TextureFormat::kR8G8B8A8, false);
+		const uint32_t overwritten = graph.addPass(Name("overwritten"), {}, { used });
+		const uint32_t write = graph.addPass(Name("write"), {}, { used });
+		const uint32_t dead = graph.addPass(Name("dead"), { used }, { unused });
+		const uint32_t final_pass = graph.addPass(Name("final"), { used }, { output });
+		graph.addOutput(output);
+		graph.compile();
+
+		VIOLET_CHECK(graph.isCulled(overwritten));
+		VIOLET_CHECK(!graph.isCulled(write));
+		VIOLET_CHECK(graph.isCulled(dead));
+		VIOLET_CHECK(!graph.isCulled(final_pass));
+		VIOLET_CHECK(graph.getCompiledPasses().size() == 2u);
+		VIOLET_CHECK(graph.getResources()[unused].first_use == RenderGraph::kInvalid);
+		VIOLET_CHECK(barriersAreValid(graph));
+
+		// Once it is an output the pass has to stay.
+		graph.addOutput(unused);
+		graph.compile();
+		VIOLET_CHECK(!graph.isCulled(dead));
+		VIOLET_CHECK(!graph.getResources()[unused].transient);
+		VIOLET_CHECK(barriersAreValid(graph));
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Targets with a different format or scale never share memory.
+	VIOLET_TEST(renderGraphOnlyAliasesMatchingTargets)
+	{
+		RenderGraph graph;
+		const uint32_t output = graph.addResource(Name("output"), 1.0f, TextureFormat::kR8G8B8A8, true);
+		const uint32_t a = graph.addResource(Name("a"), 1.0f, TextureFormat::kR16G16B16A16, false);
+		const uint32_t b = graph.addResource(Name("b"), 1.0f, TextureFormat::kR8G8B8A8, false);
+		const uint32_t c = graph.addResource(Name("c"), 0.5f, TextureFormat::kR16G16B16A16, false);
+		const uint32_t d = graph.addResource(Name("d"), 1.0f, TextureFormat::kR16G16B16A16, false);
+		graph.addPass(Name("a"), {}, { a });
+		graph.addPass(Name("b"), { a }, { b });
+		graph.addPass(Name("c"), { b }, { c });
+		graph.addPass(Name("d"), { c }, { d });
+		graph.addPass(Name("output"), { d }, { output });
+		graph.addOutput(output);
+		graph.compile();
+
+		const Vector<RenderGraph::Resource>& resources = graph.getResources();
+		VIOLET_CHECK(resources[b].physical == b);
+		VIOLET_CHECK(resources[c].physical == c);
+		VIOLET_CHECK(resources[d].physical == a);
+		VIOLET_CHECK(aliasingIsValid(graph));
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Seeded random graphs, every compiled result has to respect lifetimes and
+	// leave every pass with its resources in the right state.
+	VIOLET_TEST(renderGraphRandomGraphsCompile)
+	{
+		const TextureFormat formats[2] = { TextureFormat::kR8G8B8A8, TextureFormat::kR16G16B16A16 };
+		const float scales[2] = { 1.0f, 0.5f };
+		uint32_t state = 7u;
+
+		for (uint32_t graph_index = 0u; graph_index < 200u; ++graph_index)
+		{
+			RenderGraph graph;
+			const uint32_t resource_count = 4u + random(state, 12u);
+			for (uint32_t i = 0u; i < resource_count; ++i)
+			{
+				const bool imported = random(state, 5u) == 0u;
+				graph.addResource(Name("resource_" + toString(i)), scales[random(state, 2u)], formats[random(state, 2u)], imported);
+			}
+
+			const uint32_t pass_count = 2u + random(state, 20u);
+			for (uint32_t i = 0u; i < pass_count; ++i)
+			{
+				const uint32_t write = random(state, resource_count);
+				Vector<uint32_t> reads;
+				for (uint32_t r = random(state, 3u); r > 0u; --r)
+				{
+					const uint32_t read = random(state, resource_count);
+					if (read != write && eastl::find(reads.begin(), reads.end(), read) == reads.end())
+						reads.push_back(read);
+				}
+				graph.addPass(Name("pass_" + toString(i)), reads, { write });
+			}
+			graph.addOutput(random(state, resource_count));
+			graph.compile();
+
+			VIOLET_CHECK(aliasingIsValid(graph));
+			VIOLET_CHECK(barriersAreValid(graph));
+		}
+	}
+}
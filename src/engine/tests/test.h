@@ -0,0 +1,35 @@
+#pragma once
+#include <containers/containers.h>
+#include <utils/timer.h>
+
+namespace lambda
+{
+	namespace test
+	{
+		///////////////////////////////////////////////////////////////////////////
+		// A test registers itself before main runs. The list is linked through the
+		// tests themselves, so nothing is allocated during static initialization.
+		struct Test
+		{
+			Test(const char* name, void(*function)());
+
+			const char* name;
+			void(*function)();
+			Test* next;
+		};
+
+		Test* getTests();
+		// Marks the running test as failed, it keeps running.
+		void fail(const char* file, int line, const char* expression);
+		// Prints how long one iteration of a benchmark took.
+		void report(const char* name, const utilities::Timer& timer, uint32_t iterations);
+	}
+}
+
+#define VIOLET_TEST(name) \
+	static void name(); \
+	static ::lambda::test::Test name##_test(#name, name); \
+	static void name()
+
+#define VIOLET_CHECK(expression) \
+	do { if (!(expression)) ::lambda::test::fail(__FILE__, __LINE__, #expression); } while (false)
@@ -0,0 +1,194 @@
+#include "test.h"
+#include "assets/texture_residency.h"
+#include <algorithm>
+
+namespace lambda
+{
+	namespace
+	{
+		const uint32_t kTailMip = 7u;
+
+		///////////////////////////////////////////////////////////////////////////
+		// A 1024x1024 texture at one byte per texel.
+		Vector<uint64_t> makeMipSizes()
+		{
+			Vector<uint64_t> mip_sizes;
+			for (uint32_t mip = 0u; mip < 11u; ++mip)
+				mip_sizes.push_back((uint64_t)(1024u >> mip) * (uint64_t)(1024u >> mip));
+			return mip_sizes;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		uint64_t chainSize(uint32_t first_mip)
+		{
+			uint64_t size = 0u;
+			const Vector<uint64_t> mip_sizes = makeMipSizes();
+			for (uint32_t mip = first_mip; mip < (uint32_t)mip_sizes.size(); ++mip)
+				size += mip_sizes[mip];
+			return size;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		asset::TextureResidency makeResidency(uint32_t texture_count, uint64_t budget)
+		{
+			asset::TextureResidency residency;
+			asset::TextureResidency::Settings settings;
+			settings.budget = budget;
+			residency.setSettings(settings);
+			for (uint64_t hash = 1u; hash <= texture_count; ++hash)
+				residency.add(hash, 1024u, makeMipSizes(), kTailMip);
+			return residency;
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		// Runs a frame in which every change lands right away.
+		Vector<asset::TextureResidency::Change> runFrame(asset::TextureResidency& residency)
+		{
+			const Vector<asset::TextureResidency::Change> changes = residency.update();
+			for (const asset::TextureResidency::Change& change : changes)
+				residency.landed(change.hash, change.mip);
+			return changes;
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// A request turns into a load, the memory is reserved before it lands.
+	VIOLET_TEST(textureResidencyLoadsRequestedMips)
+	{
+		asset::TextureResidency residency = makeResidency(1u, chainSize(0u));
+		VIOLET_CHECK(residency.getResidentMip(1u) == kTailMip);
+		VIOLET_CHECK(residency.getResidentSize() == chainSize(kTailMip));
+
+		residency.requestScreenSize(1u, 256.0f);
+		Vector<asset::TextureResidency::Change> changes = residency.update();
+		VIOLET_CHECK(changes.size() == 1u && changes[0].hash == 1u && changes[0].mip == 2u);
+		VIOLET_CHECK(residency.getCommittedSize() == chainSize(2u));
+		VIOLET_CHECK(residency.getResidentMip(1u) == kTailMip);
+
+		residency.landed(1u, 2u);
+		VIOLET_CHECK(residency.getResidentSize() == chainSize(2u));
+
+		residency.request(1u, 0u);
+		changes = runFrame(residency);
+		VIOLET_CHECK(changes.size() == 1u && changes[0].mip == 0u);
+		VIOLET_CHECK(residency.getResidentSize() == chainSize(0u));
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Four textures want full detail, two fit. The resident size never goes
+	// over the budget and the other two keep their tails.
+	VIOLET_TEST(textureResidencyStaysWithinTheBudget)
+	{
+		const uint64_t budget = chainSize(0u) * 2u + chainSize(kTailMip) * 2u;
+		asset::TextureResidency residency = makeResidency(4u, budget);
+
+		uint64_t worst = 0u;
+		for (uint32_t frame = 0u; frame < 200u; ++frame)
+		{
+			for (uint64_t hash = 1u; hash <= 4u; ++hash)
+				residency.request(hash, 0u);
+			runFrame(residency);
+			worst = std::max(worst, residency.getResidentSize());
+		}
+
+		uint32_t full_detail = 0u;
+		for (uint64_t hash = 1u; hash <= 4u; ++hash)
+			full_detail += residency.getResidentMip(hash) == 0u ? 1u : 0u;
+		VIOLET_CHECK(worst <= budget);
+		VIOLET_CHECK(full_detail == 2u);
+		VIOLET_CHECK(residency.getCommittedSize() == residency.getResidentSize());
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// A texture nobody looks at keeps its mips for hold_frames, then it is the
+	// one evicted to make room. The load waits until the eviction landed.
+	VIOLET_TEST(textureResidencyEvictsTheLeastRecentlyUsed)
+	{
+		asset::TextureResidency residency = makeResidency(3u, chainSize(0u) * 2u + chainSize(kTailMip));
+		for (uint32_t frame = 0u; frame < 5u; ++frame)
+		{
+			residency.request(1u, 0u);
+			residency.request(2u, 0u);
+			runFrame(residency);
+		}
+		VIOLET_CHECK(residency.getResidentMip(1u) == 0u && residency.getResidentMip(2u) == 0u);
+
+		const uint32_t hold_frames = residency.getSettings().hold_frames;
+		uint32_t evicted_frame = 0u;
+		uint32_t loaded_frame  = 0u;
+		for (uint32_t frame = 0u; frame < hold_frames * 2u; ++frame)
+		{
+			residency.request(2u, 0u);
+			residency.request(3u, 0u);
+			for (const asset::TextureResidency::Change& change : runFrame(residency))
+			{
+				VIOLET_CHECK(change.hash != 2u);
+				if (change.hash == 1u)
+					evicted_frame = frame;
+				if (change.hash == 3u)
+					loaded_frame = frame;
+			}
+			VIOLET_CHECK(residency.getResidentSize() <= residency.getSettings().budget);
+		}
+
+		VIOLET_CHECK(evicted_frame >= hold_frames);
+		VIOLET_CHECK(loaded_frame > evicted_frame);
+		VIOLET_CHECK(residency.getResidentMip(1u) == kTailMip);
+		VIOLET_CHECK(residency.getResidentMip(3u) == 0u);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Asking for less detail only lowers the request once the hold ran out.
+	VIOLET_TEST(textureResidencyHoldsDetail)
+	{
+		asset::TextureResidency residency = makeResidency(1u, chainSize(0u));
+		residency.request(1u, 0u);
+		runFrame(residency);
+
+		const uint32_t hold_frames = residency.getSettings().hold_frames;
+		for (uint32_t frame = 0u; frame < hold_frames; ++frame)
+		{
+			residency.request(1u, 4u);
+			VIOLET_CHECK(runFrame(residency).empty());
+			VIOLET_CHECK(residency.getRequestedMip(1u) == 0u);
+		}
+
+		residency.request(1u, 4u);
+		runFrame(residency);
+		VIOLET_CHECK(residency.getRequestedMip(1u) == 4u);
+		// Nothing else wants the memory, so the mips stay.
+		VIOLET_CHECK(residency.getResidentMip(1u) == 0u);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Shrinking the budget evicts what is not asked for, a frame only makes
+	// max_changes_per_update changes.
+	VIOLET_TEST(textureResidencyShrinksAndLimitsChanges)
+	{
+		asset::TextureResidency residency = makeResidency(20u, chainSize(0u) * 20u);
+		for (uint64_t hash = 1u; hash <= 20u; ++hash)
+			residency.request(hash, 0u);
+		VIOLET_CHECK(runFrame(residency).size() == residency.getSettings().max_changes_per_update);
+
+		asset::TextureResidency shrinking = makeResidency(4u, chainSize(0u) * 4u);
+		for (uint32_t frame = 0u; frame < 3u; ++frame)
+		{
+			for (uint64_t hash = 1u; hash <= 4u; ++hash)
+				shrinking.request(hash, 0u);
+			runFrame(shrinking);
+		}
+
+		asset::TextureResidency::Settings settings = shrinking.getSettings();
+		settings.budget = chainSize(0u) * 2u + chainSize(kTailMip) * 2u;
+		shrinking.setSettings(settings);
+		for (uint32_t frame = 0u; frame < settings.hold_frames + 10u; ++frame)
+		{
+			shrinking.request(1u, 0u);
+			shrinking.request(2u, 0u);
+			runFrame(shrinking);
+		}
+		VIOLET_CHECK(shrinking.getResidentMip(1u) == 0u && shrinking.getResidentMip(2u) == 0u);
+		VIOLET_CHECK(shrinking.getResidentMip(3u) == kTailMip && shrinking.getResidentMip(4u) == kTailMip);
+		VIOLET_CHECK(shrinking.getResidentSize() <= settings.budget);
+	}
+}
@@ -62,10 +62,25 @@ namespace lambda
       convert(input, output);
       return eastl::move(output);
     }
+    
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename TI, typename TR>
+    Vector<TR> convert(const asset::MeshView<TI>& input)
+    {
+      Vector<TR> output(input.size());
+      for (size_t i = 0u; i < input.size(); ++i)
+        output[i] = (TR)input[i];
+      return eastl::move(output);
+    }
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     void MeshDecimator::decimate(asset::Mesh* input, asset::Mesh* output, float reduction, float target_error)
     {
+      // The decimator reads the vertices as floats. The copy shares the buffers until they are decoded.
+      asset::Mesh decoded(*input);
+      decoded.dequantize();
+      input = &decoded;
+
       // Output data.
       Vector<glm::vec3> new_pos;
       Vector<glm::vec3> new_nor;
@@ -86,22 +101,15 @@ namespace lambda
         size_t index_count  = sub_mesh.offsets[asset::MeshElements::kIndices].count / 3u;
         if(vertex_count != 0u&& index_count != 0u)
         {
-          Vector<glm::vec3> vertices = input->get<glm::vec3>(asset::MeshElements::kPositions, sid);
-          char* i_data = (char*)input->get(asset::MeshElements::kIndices).data + sub_mesh.offsets[asset::MeshElements::kIndices].offset;
-        
           // Convert the indices.
           Vector<int> indices;
           if (sizeof(uint16_t) == input->get(asset::MeshElements::kIndices).size)
           {
-            Vector<uint16_t> ti(index_count * 3u);
-            memcpy(ti.data(), i_data, index_count * 3u * sizeof(uint16_t));
-            indices = convert<uint16_t, int>(ti);
+            indices = convert<uint16_t, int>(input->get<uint16_t>(asset::MeshElements::kIndices, sid));
           }
           else
           {
-            Vector<uint32_t> ti(index_count * 3u);
-            memcpy(ti.data(), i_data, index_count * 3u * sizeof(uint32_t));
-            indices = convert<uint32_t, int>(ti);
+            indices = convert<uint32_t, int>(input->get<uint32_t>(asset::MeshElements::kIndices, sid));
           }
 
           // Init decimator.
@@ -111,6 +119,8 @@ namespace lambda
           size_t new_vertex_count;
           if (vertex_count > 50u&& index_count > 50u)
           {
+            // The decimator moves the vertices, so it needs a copy of its own.
+            Vector<glm::vec3> vertices = input->get<glm::vec3>(asset::MeshElements::kPositions, sid).toVector();
             LambdaMeshDecimator decimator;
             decimator.Initialize(vertex_count, index_count, (MeshDecimation::Vec3<MeshDecimation::Float>*)vertices.data(), (MeshDecimation::Vec3<int>*)indices.data());
 
@@ -137,13 +147,13 @@ namespace lambda
         
           // Get all required things. So many different things.
           // Input data.
-          Vector<glm::vec3> old_pos = input->get<glm::vec3>(asset::MeshElements::kPositions, sid);
-          Vector<glm::vec3> old_nor = input->get<glm::vec3>(asset::MeshElements::kNormals,   sid);
-          Vector<glm::vec2> old_tex = input->get<glm::vec2>(asset::MeshElements::kTexCoords, sid);
-          Vector<glm::vec4> old_col = input->get<glm::vec4>(asset::MeshElements::kColours,   sid);
-          Vector<glm::vec3> old_tan = input->get<glm::vec3>(asset::MeshElements::kTangents,  sid);
-          Vector<glm::vec4> old_joi = input->get<glm::vec4>(asset::MeshElements::kJoints,    sid);
-          Vector<glm::vec4> old_wei = input->get<glm::vec4>(asset::MeshElements::kWeights,   sid);
+          const asset::MeshView<glm::vec3> old_pos = input->get<glm::vec3>(asset::MeshElements::kPositions, sid);
+          const asset::MeshView<glm::vec3> old_nor = input->get<glm::vec3>(asset::MeshElements::kNormals,   sid);
+          const asset::MeshView<glm::vec2> old_tex = input->get<glm::vec2>(asset::MeshElements::kTexCoords, sid);
+          const asset::MeshView<glm::vec4> old_col = input->get<glm::vec4>(asset::MeshElements::kColours,   sid);
+          const asset::MeshView<glm::vec3> old_tan = input->get<glm::vec3>(asset::MeshElements::kTangents,  sid);
+          const asset::MeshView<glm::vec4> old_joi = input->get<glm::vec4>(asset::MeshElements::kJoints,    sid);
+          const asset::MeshView<glm::vec4> old_wei = input->get<glm::vec4>(asset::MeshElements::kWeights,   sid);
 
           size_t size_pos = new_pos.size();
           size_t size_nor = new_nor.size();
@@ -185,7 +195,9 @@ namespace lambda
             }
           }
 
-          // Set output.
+          // Set output. The compiled levels and clusters index the old triangles.
+          sub_mesh.lods.clear();
+          sub_mesh.clusters.clear();
           sub_mesh.offsets[asset::MeshElements::kIndices].count = new_indices.size();
 
           if (sizeof(uint16_t) == input->get(asset::MeshElements::kIndices).size)
@@ -239,10 +251,16 @@ namespace lambda
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     void MeshDecimator::decimateOld(asset::Mesh* input, asset::Mesh* output, float reduction, float target_error)
     {
+      asset::Mesh decoded(*input);
+      decoded.dequantize();
+      input = &decoded;
+
       // Get the correct counts and vertices.
       size_t vertex_count = input->get(asset::MeshElements::kPositions).count;
       size_t index_count  = input->get(asset::MeshElements::kIndices).count / 3u;
-      MeshDecimation::Vec3<MeshDecimation::Float>* vertices = (MeshDecimation::Vec3<MeshDecimation::Float>*)input->get(asset::MeshElements::kPositions).data;
+      // The decimator moves the vertices, so it needs a copy of its own.
+      Vector<glm::vec3> positions = input->get<glm::vec3>(asset::MeshElements::kPositions).toVector();
+      MeshDecimation::Vec3<MeshDecimation::Float>* vertices = (MeshDecimation::Vec3<MeshDecimation::Float>*)positions.data();
       
       // Convert the indices.
       Vector<int> indices;
@@ -275,20 +293,20 @@ namespace lambda
 
       // Get all required things. So many different things.
       // Input data.
-      Vector<glm::vec3> old_pos = input->get<glm::vec3>(asset::MeshElements::kPositions);
-      Vector<glm::vec3> old_nor = input->get<glm::vec3>(asset::MeshElements::kNormals);
-      Vector<glm::vec2> old_tex = input->get<glm::vec2>(asset::MeshElements::kTexCoords);
-      Vector<glm::vec4> old_col = input->get<glm::vec4>(asset::MeshElements::kColours);
-      Vector<glm::vec4> old_tan = input->get<glm::vec4>(asset::MeshElements::kTangents);
-      Vector<glm::vec4> old_joi = input->get<glm::vec4>(asset::MeshElements::kJoints);
-      Vector<glm::vec4> old_wei = input->get<glm::vec4>(asset::MeshElements::kWeights);
+      const asset::MeshView<glm::vec3> old_pos = input->get<glm::vec3>(asset::MeshElements::kPositions);
+      const asset::MeshView<glm::vec3> old_nor = input->get<glm::vec3>(asset::MeshElements::kNormals);
+      const asset::MeshView<glm::vec2> old_tex = input->get<glm::vec2>(asset::MeshElements::kTexCoords);
+      const asset::MeshView<glm::vec4> old_col = input->get<glm::vec4>(asset::MeshElements::kColours);
+      const asset::MeshView<glm::vec3> old_tan = input->get<glm::vec3>(asset::MeshElements::kTangents);
+      const asset::MeshView<glm::vec4> old_joi = input->get<glm::vec4>(asset::MeshElements::kJoints);
+      const asset::MeshView<glm::vec4> old_wei = input->get<glm::vec4>(asset::MeshElements::kWeights);
 
       // Output data.
       Vector<glm::vec3> new_pos(std::min(old_pos.size(), new_vertex_count));
       Vector<glm::vec3> new_nor(std::min(old_nor.size(), new_vertex_count));
       Vector<glm::vec2> new_tex(std::min(old_tex.size(), new_vertex_count));
       Vector<glm::vec4> new_col(std::min(old_col.size(), new_vertex_count));
-      Vector<glm::vec4> new_tan(std::min(old_tan.size(), new_vertex_count));
+      Vector<glm::vec3> new_tan(std::min(old_tan.size(), new_vertex_count));
       Vector<glm::vec4> new_joi(std::min(old_joi.size(), new_vertex_count));
       Vector<glm::vec4> new_wei(std::min(old_wei.size(), new_vertex_count));
 
@@ -297,7 +315,7 @@ namespace lambda
       glm::vec3* nor_it = new_nor.data();
       glm::vec2* tex_it = new_tex.data();
       glm::vec4* col_it = new_col.data();
-      glm::vec4* tan_it = new_tan.data();
+      glm::vec3* tan_it = new_tan.data();
       glm::vec4* joi_it = new_joi.data();
       glm::vec4* wei_it = new_wei.data();
 
@@ -1,5 +1,8 @@
 #include "mt_manager.h"
 #include <memory/memory.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 #ifdef MULTI_THREADED_MANAGER
 namespace lambda
@@ -76,13 +79,53 @@ namespace lambda
 				}
 			}
 
+			void parallelFor(uint32_t count, uint32_t max_jobs, uint32_t min_job_size, const Function<void(uint32_t job, uint32_t begin, uint32_t end)>& function)
+			{
+				struct Job
+				{
+					const Function<void(uint32_t, uint32_t, uint32_t)>* function;
+					uint32_t               job;
+					uint32_t               begin;
+					uint32_t               end;
+					std::atomic<uint32_t>* remaining;
+				};
+
+				const uint32_t job_count = std::max(1u, std::min(max_jobs, count / std::max(1u, min_job_size)));
+				std::atomic<uint32_t> remaining(job_count - 1u);
+				Vector<Job> jobs(job_count);
+				for (uint32_t i = 0u; i < job_count; ++i)
+				{
+					jobs[i].function  = &function;
+					jobs[i].job       = i;
+					jobs[i].begin     = (uint32_t)(((uint64_t)count * i) / job_count);
+					jobs[i].end       = (uint32_t)(((uint64_t)count * (i + 1u)) / job_count);
+					jobs[i].remaining = &remaining;
+				}
+
+				for (uint32_t i = 1u; i < job_count; ++i)
+				{
+					queue([](void* user_data) {
+						Job* job = (Job*)user_data;
+						(*job->function)(job->job, job->begin, job->end);
+						(*job->remaining)--;
+					}, &jobs[i], Priority::kHigh);
+				}
+
+				function(0u, jobs[0].begin, jobs[0].end);
+
+				while (remaining > 0u)
+					std::this_thread::yield();
+			}
+
 			void terminate()
 			{
 				k_alive = false;
 
 				for (uint8_t i = 0u; i < Priority::kCount; ++i)
 				{
-					k_worker_threads[i].join();
+					// The workers only start with the first queued job.
+					if (k_worker_threads[i].joinable())
+						k_worker_threads[i].join();
 					k_functions[i] = {};
 					k_num_functions[i] = 0;
 				}
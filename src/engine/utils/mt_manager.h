@@ -18,6 +18,9 @@ namespace lambda
 		kCount,
 	  };
 	  extern void queue(Function<void(void*)> function, void* arguments, Priority priority);
+	  // Splits [0, count) over up to max_jobs jobs of at least min_job_size
+	  // items and waits for all of them. The calling thread runs the first one.
+	  void parallelFor(uint32_t count, uint32_t max_jobs, uint32_t min_job_size, const Function<void(uint32_t job, uint32_t begin, uint32_t end)>& function);
 	  void terminate();
 	}
   }
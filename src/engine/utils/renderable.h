@@ -25,6 +25,25 @@ namespace lambda
       glm::vec3 max;
       glm::vec3 center;
       float     radius;
+      uint32_t  index = 0u; // In to the MeshRenderSystem data.
+      // Level of detail picked for the view the renderable is drawn in. While
+      // lod_fade is below one it is dithered in and fade_lod is dithered out.
+      uint8_t   lod      = 0u;
+      uint8_t   fade_lod = 0u;
+      float     lod_fade = 1.0f;
+      // Index ranges of the full detail level that survived cluster culling,
+      // in the list of the view. Only used when clustered is set.
+      bool      clustered   = false;
+      uint32_t  first_range = 0u;
+      uint32_t  range_count = 0u;
     };
+
+    // Back faces of double sided materials and of alpha tested albedo are
+    // drawn as well, so they can not be culled.
+    inline bool isTwoSided(const Renderable& renderable)
+    {
+      const asset::SubMesh& sub_mesh = renderable.mesh->getSubMeshes().at(renderable.sub_mesh);
+      return sub_mesh.io.double_sided == true || (sub_mesh.io.tex_alb >= 0 && renderable.mesh->getAttachedTextures().at(sub_mesh.io.tex_alb)->getLayer(0u).containsAlpha());
+    }
   }
 }
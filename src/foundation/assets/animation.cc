@@ -0,0 +1,291 @@
+#include "animation.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VIOLET_ANIMATION_SSE 1
+#include <emmintrin.h>
+#else
+#define VIOLET_ANIMATION_SSE 0
+#endif
+
+namespace lambda
+{
+  namespace
+  {
+    constexpr float kSqrt2 = 1.41421356f;
+
+    // The evaluation is written once against these, they map to SSE
+    // registers when the target has them and to plain vectors otherwise.
+#if VIOLET_ANIMATION_SSE
+    typedef __m128 Lane;
+    inline Lane load(const glm::vec4& v) { return _mm_loadu_ps(&v.x); }
+    inline void store(glm::vec4& v, Lane l) { _mm_storeu_ps(&v.x, l); }
+    inline Lane splat(float f) { return _mm_set1_ps(f); }
+    inline Lane add(Lane a, Lane b) { return _mm_add_ps(a, b); }
+    inline Lane sub(Lane a, Lane b) { return _mm_sub_ps(a, b); }
+    inline Lane mul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+    inline Lane dot(Lane a, Lane b)
+    {
+      Lane m = _mm_mul_ps(a, b);
+      m = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+      return _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+    // Flips b when it is on the other side of a, q and -q are the same rotation.
+    inline Lane alignSign(Lane a, Lane b)
+    {
+      return _mm_xor_ps(b, _mm_and_ps(_mm_cmplt_ps(dot(a, b), _mm_setzero_ps()), _mm_set1_ps(-0.0f)));
+    }
+    inline Lane normalize(Lane a) { return _mm_div_ps(a, _mm_sqrt_ps(dot(a, a))); }
+#else
+    typedef glm::vec4 Lane;
+    inline Lane load(const glm::vec4& v) { return v; }
+    inline void store(glm::vec4& v, Lane l) { v = l; }
+    inline Lane splat(float f) { return glm::vec4(f); }
+    inline Lane add(Lane a, Lane b) { return a + b; }
+    inline Lane sub(Lane a, Lane b) { return a - b; }
+    inline Lane mul(Lane a, Lane b) { return a * b; }
+    inline Lane dot(Lane a, Lane b) { return glm::vec4(glm::dot(a, b)); }
+    inline Lane alignSign(Lane a, Lane b) { return glm::dot(a, b) < 0.0f ? -b : b; }
+    inline Lane normalize(Lane a) { return a / glm::sqrt(dot(a, a)); }
+#endif
+    inline Lane lerp(Lane a, Lane b, Lane t) { return add(a, mul(sub(b, a), t)); }
+    inline Lane nlerp(Lane a, Lane b, Lane t) { return normalize(lerp(a, alignSign(a, b), t)); }
+
+    // result = a * b, result may be either of the inputs.
+    inline void mulMatrix(const glm::mat4& a, const glm::mat4& b, glm::mat4& result)
+    {
+      const Lane a0 = load(a[0]), a1 = load(a[1]), a2 = load(a[2]), a3 = load(a[3]);
+      for (int c = 0; c < 4; ++c)
+      {
+        const glm::vec4 column = b[c];
+        store(result[c], add(add(mul(a0, splat(column.x)), mul(a1, splat(column.y))), add(mul(a2, splat(column.z)), mul(a3, splat(column.w)))));
+      }
+    }
+
+    void toMatrix(const VioletAnimation::Transform& transform, glm::mat4& matrix)
+    {
+      const glm::vec4& q = transform.rotation;
+      const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+      const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+      const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+      matrix[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * transform.scale.x;
+      matrix[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * transform.scale.y;
+      matrix[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * transform.scale.z;
+      matrix[3] = glm::vec4(transform.translation.x, transform.translation.y, transform.translation.z, 1.0f);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletAnimation::RestPose(const Vector<VioletMeshJoint>& joints, Transform* pose)
+  {
+    for (uint32_t j = 0u; j < (uint32_t)joints.size(); ++j)
+    {
+      const VioletMeshJoint& joint = joints[j];
+      pose[j].rotation    = glm::vec4(joint.rotation.x, joint.rotation.y, joint.rotation.z, joint.rotation.w);
+      pose[j].translation = glm::vec4(joint.translation, 0.0f);
+      pose[j].scale       = glm::vec4(joint.scale, 0.0f);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletAnimation::Sample(const VioletAnimationClip& clip, float time, bool loop, uint32_t joint_count, Transform* pose)
+  {
+    if (clip.frame_count == 0u)
+      return;
+
+    float frame = 0.0f;
+    if (clip.duration > 0.0f)
+    {
+      time  = loop ? time - std::floor(time / clip.duration) * clip.duration : std::min(std::max(time, 0.0f), clip.duration);
+      frame = time * clip.frame_rate;
+    }
+    const uint32_t last   = clip.frame_count - 1u;
+    const uint32_t frame0 = std::min((uint32_t)frame, last);
+    const uint32_t frame1 = std::min(frame0 + 1u, last);
+    const Lane     t      = splat(std::min(frame - (float)frame0, 1.0f));
+
+    const uint16_t* keys = clip.keys.data();
+    const auto key = [keys](const VioletAnimationTrack& track, uint32_t index) {
+      return keys + (size_t)(track.offset + std::min(index, track.count - 1u)) * 3u;
+    };
+    // Constant tracks skip the second key and the interpolation.
+    const auto sampleVector = [&](const VioletAnimationTrack& track, glm::vec4& result) {
+      if (track.count == 0u)
+        return;
+      const glm::vec4 a(DecodeVector(key(track, frame0), track), 0.0f);
+      if (track.count == 1u)
+        result = a;
+      else
+        store(result, lerp(load(a), load(glm::vec4(DecodeVector(key(track, frame1), track), 0.0f)), t));
+    };
+    const auto sampleRotation = [&](const VioletAnimationTrack& track, glm::vec4& result) {
+      if (track.count == 0u)
+        return;
+      const glm::vec4 a = DecodeRotation(key(track, frame0));
+      if (track.count == 1u)
+        result = a;
+      else
+        store(result, nlerp(load(a), load(DecodeRotation(key(track, frame1))), t));
+    };
+
+    const uint32_t count = std::min(joint_count, (uint32_t)(clip.tracks.size() / kTracksPerJoint));
+    for (uint32_t j = 0u; j < count; ++j)
+    {
+      const VioletAnimationTrack* tracks = clip.tracks.data() + j * kTracksPerJoint;
+      sampleVector(tracks[0], pose[j].translation);
+      sampleRotation(tracks[1], pose[j].rotation);
+      sampleVector(tracks[2], pose[j].scale);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletAnimation::Blend(const Transform* from, const Transform* to, float weight, uint32_t joint_count, Transform* result)
+  {
+    const Lane w = splat(weight);
+    for (uint32_t j = 0u; j < joint_count; ++j)
+    {
+      store(result[j].rotation,    nlerp(load(from[j].rotation), load(to[j].rotation), w));
+      store(result[j].translation, lerp(load(from[j].translation), load(to[j].translation), w));
+      store(result[j].scale,       lerp(load(from[j].scale), load(to[j].scale), w));
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletAnimation::LocalToModel(const Vector<VioletMeshJoint>& joints, const Transform* local, glm::mat4* model)
+  {
+    for (uint32_t j = 0u; j < (uint32_t)joints.size(); ++j)
+    {
+      toMatrix(local[j], model[j]);
+      const int parent = joints[j].parent;
+      if (parent >= 0 && parent < (int)j)
+        mulMatrix(model[parent], model[j], model[j]);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletAnimation::Palette(const Vector<VioletMeshJoint>& joints, const glm::mat4* model, glm::mat4* palette)
+  {
+    for (uint32_t j = 0u; j < (uint32_t)joints.size(); ++j)
+      mulMatrix(model[j], joints[j].inverse_bind, palette[j]);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletAnimation::Skin(const glm::mat4* palette, uint32_t palette_size, const glm::vec4* joints, const glm::vec4* weights, size_t count,
+    const glm::vec3* positions, const glm::vec3* normals, const glm::vec3* tangents,
+    glm::vec3* out_positions, glm::vec3* out_normals, glm::vec3* out_tangents, glm::vec3& min, glm::vec3& max)
+  {
+    min = glm::vec3(FLT_MAX);
+    max = glm::vec3(-FLT_MAX);
+    if (palette_size == 0u)
+      return;
+
+    const uint32_t last = palette_size - 1u;
+    const auto transformDirection = [](Lane c0, Lane c1, Lane c2, const glm::vec3& v) {
+      glm::vec4 result;
+      store(result, normalize(add(add(mul(c0, splat(v.x)), mul(c1, splat(v.y))), mul(c2, splat(v.z)))));
+      return glm::vec3(result);
+    };
+
+    for (size_t i = 0u; i < count; ++i)
+    {
+      // Blend the matrices first, so every vertex is transformed once.
+      const glm::vec4& joint  = joints[i];
+      const glm::vec4& weight = weights[i];
+      Lane c0 = splat(0.0f), c1 = c0, c2 = c0, c3 = c0;
+      float total = 0.0f;
+      for (int k = 0; k < 4; ++k)
+      {
+        if (weight[k] <= 0.0f)
+          continue;
+        const glm::mat4& m = palette[std::min((uint32_t)joint[k], last)];
+        const Lane w = splat(weight[k]);
+        c0 = add(c0, mul(load(m[0]), w));
+        c1 = add(c1, mul(load(m[1]), w));
+        c2 = add(c2, mul(load(m[2]), w));
+        c3 = add(c3, mul(load(m[3]), w));
+        total += weight[k];
+      }
+
+      if (total <= 0.0f)
+      {
+        out_positions[i] = positions[i];
+        if (normals)
+          out_normals[i] = normals[i];
+        if (tangents)
+          out_tangents[i] = tangents[i];
+      }
+      else
+      {
+        const glm::vec3& p = positions[i];
+        glm::vec4 position;
+        store(position, add(add(mul(c0, splat(p.x)), mul(c1, splat(p.y))), add(mul(c2, splat(p.z)), c3)));
+        out_positions[i] = glm::vec3(position);
+        if (normals)
+          out_normals[i] = transformDirection(c0, c1, c2, normals[i]);
+        if (tangents)
+          out_tangents[i] = transformDirection(c0, c1, c2, tangents[i]);
+      }
+
+      min = glm::min(min, out_positions[i]);
+      max = glm::max(max, out_positions[i]);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletAnimation::EncodeRotation(glm::vec4 rotation, uint16_t* key)
+  {
+    rotation = glm::normalize(rotation);
+    int largest = 0;
+    for (int i = 1; i < 4; ++i)
+      if (std::abs(rotation[i]) > std::abs(rotation[largest]))
+        largest = i;
+    // The largest component is rebuilt as a positive number.
+    if (rotation[largest] < 0.0f)
+      rotation = -rotation;
+
+    uint16_t values[3];
+    for (int i = 0, k = 0; i < 4; ++i)
+      if (i != largest)
+        values[k++] = (uint16_t)std::round(std::min(std::max(rotation[i] * kSqrt2 * 0.5f + 0.5f, 0.0f), 1.0f) * 32767.0f);
+
+    key[0] = (uint16_t)(values[0] | ((largest & 1) << 15));
+    key[1] = (uint16_t)(values[1] | ((largest >> 1) << 15));
+    key[2] = values[2];
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  glm::vec4 VioletAnimation::DecodeRotation(const uint16_t* key)
+  {
+    const int largest = (key[0] >> 15) | ((key[1] >> 15) << 1);
+    glm::vec4 rotation;
+    float sum = 0.0f;
+    for (int i = 0, k = 0; i < 4; ++i)
+    {
+      if (i == largest)
+        continue;
+      const float value = ((float)(key[k++] & 0x7fffu) / 32767.0f * 2.0f - 1.0f) / kSqrt2;
+      rotation[i] = value;
+      sum += value * value;
+    }
+    rotation[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+    return rotation;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletAnimation::EncodeVector(const glm::vec3& vector, const VioletAnimationTrack& track, uint16_t* key)
+  {
+    for (int i = 0; i < 3; ++i)
+    {
+      const float n = track.extent[i] > 0.0f ? (vector[i] - track.min[i]) / track.extent[i] : 0.0f;
+      key[i] = (uint16_t)std::round(std::min(std::max(n, 0.0f), 1.0f) * 65535.0f);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  glm::vec3 VioletAnimation::DecodeVector(const uint16_t* key, const VioletAnimationTrack& track)
+  {
+    return track.min + glm::vec3(key[0], key[1], key[2]) * (1.0f / 65535.0f) * track.extent;
+  }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "mesh_manager.h"
+
+namespace lambda
+{
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Poses the skeletons of VioletMeshData. A pose is a flat array with an
+  // entry per joint in the order of VioletMeshData::joints, so a single pass
+  // over it always finds the parent of a joint done. Used by the runtime and
+  // by the mesh compiler, which encodes the keys and times the evaluation.
+  class VioletAnimation
+  {
+  public:
+    // Tracks of a joint in VioletAnimationClip::tracks.
+    static constexpr uint32_t kTracksPerJoint = 3u;
+
+    // Transform of a joint relative to its parent. Every part fills a SIMD
+    // register, w of the translation and the scale is not used.
+    struct Transform
+    {
+      glm::vec4 rotation;    // Quaternion, xyzw.
+      glm::vec4 translation;
+      glm::vec4 scale;
+    };
+
+    static void RestPose(const Vector<VioletMeshJoint>& joints, Transform* pose);
+    // Pose of the clip at time seconds, which wraps around when looping and
+    // is clamped otherwise. Joints the clip has no tracks for are left alone.
+    static void Sample(const VioletAnimationClip& clip, float time, bool loop, uint32_t joint_count, Transform* pose);
+    // Moves from towards to by weight, rotations are normalized lerped along
+    // the shortest arc. result may be either of the inputs.
+    static void Blend(const Transform* from, const Transform* to, float weight, uint32_t joint_count, Transform* result);
+    // Transforms of the joints relative to the parent of the skeleton.
+    static void LocalToModel(const Vector<VioletMeshJoint>& joints, const Transform* local, glm::mat4* model);
+    // Matrices that move a vertex from the bind pose into the posed skeleton.
+    static void Palette(const Vector<VioletMeshJoint>& joints, const glm::mat4* model, glm::mat4* palette);
+    // Skins count vertices with four influences each, joints and weights as
+    // stored in the Joints and Weights streams. Normals and tangents are
+    // optional. Returns the bounds of the skinned positions.
+    static void Skin(const glm::mat4* palette, uint32_t palette_size, const glm::vec4* joints, const glm::vec4* weights, size_t count,
+      const glm::vec3* positions, const glm::vec3* normals, const glm::vec3* tangents,
+      glm::vec3* out_positions, glm::vec3* out_normals, glm::vec3* out_tangents, glm::vec3& min, glm::vec3& max);
+
+    // Key encoding, see VioletAnimationTrack.
+    static void EncodeRotation(glm::vec4 rotation, uint16_t* key);
+    static glm::vec4 DecodeRotation(const uint16_t* key);
+    static void EncodeVector(const glm::vec3& vector, const VioletAnimationTrack& track, uint16_t* key);
+    static glm::vec3 DecodeVector(const uint16_t* key, const VioletAnimationTrack& track);
+  };
+}
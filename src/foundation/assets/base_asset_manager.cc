@@ -1,10 +1,81 @@
 #include "base_asset_manager.h"
 #include "utils/file_system.h"
 #include "utils/console.h"
+#include <memory/memory.h>
 #include <lz4.h>
+#include <lz4hc.h>
+#include <atomic>
+#include <thread>
+#include <string>
 
 namespace lambda
 {
+  const VioletPackArchive* VioletBaseAssetManager::s_archive_ = nullptr;
+  Function<void(Function<void(void)>)> VioletBaseAssetManager::s_job_queue_;
+  uint32_t VioletBaseAssetManager::s_job_workers_ = 0u;
+
+  // Data files start with this header, followed by the compressed size of
+  // every block and then the blocks. Older files are a single LZ4 block with
+  // the original size at the end.
+  struct VioletBlockHeader
+  {
+    char     magic_number[4u]; // "LBLK"
+    uint8_t  version;
+    uint8_t  compression;
+    uint16_t padding;
+    uint32_t block_size;
+    uint32_t block_count;
+    uint64_t original_size;
+  };
+  static constexpr uint8_t  kBlockVersion = 1u;
+  // Set in the block size when the block did not compress and is stored as is.
+  static constexpr uint32_t kBlockUncompressed = 1u << 31u;
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  static bool readBlockHeader(const char* data, size_t size, VioletBlockHeader& header)
+  {
+    if (size < sizeof(VioletBlockHeader))
+      return false;
+
+    memcpy(&header, data, sizeof(VioletBlockHeader));
+    if (memcmp(header.magic_number, "LBLK", 4u) != 0 || header.version != kBlockVersion)
+      return false;
+
+    // Legacy LZ4 data could start with the magic number by accident, the sizes have to add up as well.
+    uint64_t total = sizeof(VioletBlockHeader) + sizeof(uint32_t) * (uint64_t)header.block_count;
+    if (total > size)
+      return false;
+    for (uint32_t i = 0u; i < header.block_count; ++i)
+    {
+      uint32_t block_size;
+      memcpy(&block_size, data + sizeof(VioletBlockHeader) + sizeof(uint32_t) * i, sizeof(uint32_t));
+      total += block_size & ~kBlockUncompressed;
+    }
+    return total == size;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Rewrites the header so the first block_count blocks are valid data on their
+  // own. The blocks themselves are left to the caller, they go at blocks_offset.
+  static Vector<char> beginPrefix(VioletBlockHeader header, const char* table, uint32_t block_count, size_t& blocks_offset, uint64_t& blocks_size)
+  {
+    blocks_size = 0u;
+    for (uint32_t i = 0u; i < block_count; ++i)
+    {
+      uint32_t block_size;
+      memcpy(&block_size, table + sizeof(uint32_t) * i, sizeof(uint32_t));
+      blocks_size += block_size & ~kBlockUncompressed;
+    }
+
+    blocks_offset = sizeof(VioletBlockHeader) + sizeof(uint32_t) * block_count;
+    Vector<char> prefix(blocks_offset + (size_t)blocks_size);
+    header.original_size = eastl::min<uint64_t>(header.original_size, (uint64_t)block_count * header.block_size);
+    header.block_count   = block_count;
+    memcpy(prefix.data(), &header, sizeof(VioletBlockHeader));
+    memcpy(prefix.data() + sizeof(VioletBlockHeader), table, sizeof(uint32_t) * block_count);
+    return eastl::move(prefix);
+  }
+
   /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   void VioletBaseAssetManager::SetMagicNumber(String magic_number)
   {
@@ -17,6 +88,50 @@ namespace lambda
     file_path_generated_ = file_path;
   }
 
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  String VioletBaseAssetManager::GetGeneratedFilePath() const
+  {
+    return file_path_generated_;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletBaseAssetManager::ParseGeneratedFile(const String& file, uint64_t& hash) const
+  {
+    const String path = FileSystem::FixFilePath(file);
+    if (path.size() <= file_path_generated_.size() || path.compare(0, file_path_generated_.size(), file_path_generated_) != 0)
+      return false;
+
+    // <magic number>_data_<hash> or <magic number>_header_<hash>.
+    const String name = path.substr(file_path_generated_.size());
+    for (const String& kind : { String("_data_"), String("_header_") })
+    {
+      const String prefix = magic_number_ + kind;
+      if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0)
+        continue;
+
+      const String number = name.substr(prefix.size());
+      if (number.find_first_not_of("0123456789") != String::npos)
+        return false;
+
+      hash = std::stoull(number.c_str());
+      return true;
+    }
+    return false;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<String> VioletBaseAssetManager::GetGeneratedFiles(uint64_t hash) const
+  {
+    Vector<String> files;
+    for (const String& kind : { String("_header_"), String("_data_") })
+    {
+      const String file = file_path_generated_ + magic_number_ + kind + toString(hash);
+      if (FileSystem::DoesFileExist(file))
+        files.push_back(file);
+    }
+    return files;
+  }
+
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	Vector<char> VioletBaseAssetManager::GetData(uint64_t hash) const
 	{
@@ -29,9 +144,212 @@ namespace lambda
 		return eastl::move(LoadHeader(hash));
 	}
 
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	const char* VioletBaseAssetManager::GetHeader(uint64_t hash, Vector<char>& storage, size_t& size) const
+	{
+		const VioletPackArchive::Entry* entry = FindEntry(hash, VioletPackArchive::Kind::kHeader);
+		if (entry)
+		{
+			size = (size_t)entry->size;
+			return s_archive_->GetView(*entry);
+		}
+
+		storage = LoadHeader(hash);
+		size    = storage.size();
+		return storage.data();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Vector<char> VioletBaseAssetManager::ReadData(uint64_t hash) const
+	{
+		const VioletPackArchive::Entry* entry = FindEntry(hash, VioletPackArchive::Kind::kData);
+		if (entry)
+			return Vector<char>(s_archive_->GetView(*entry), s_archive_->GetView(*entry) + entry->size);
+
+		return eastl::move(FileSystem::FileToVector(file_path_generated_ + magic_number_ + "_data_" + toString(hash), magic_number_.data(), magic_number_.size()));
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Vector<char> VioletBaseAssetManager::ReadData(uint64_t hash, uint64_t size) const
+	{
+		const VioletPackArchive::Entry* entry = FindEntry(hash, VioletPackArchive::Kind::kData);
+		if (entry == nullptr)
+			return eastl::move(ReadLooseData(hash, size));
+
+		const char* data = s_archive_->GetView(*entry);
+		const size_t data_size = (size_t)entry->size;
+		if ((entry->flags & VioletPackArchive::kEntryFlagCompressed) == 0u)
+			return Vector<char>(data, data + (size_t)eastl::min<uint64_t>(size, data_size));
+
+		// Old data is a single block, that has to be read as a whole.
+		VioletBlockHeader header;
+		if (!readBlockHeader(data, data_size, header))
+			return Vector<char>(data, data + data_size);
+
+		const uint32_t block_count = (uint32_t)eastl::min<uint64_t>(header.block_count, (size + header.block_size - 1u) / header.block_size);
+		size_t blocks_offset;
+		uint64_t blocks_size;
+		Vector<char> prefix = beginPrefix(header, data + sizeof(VioletBlockHeader), block_count, blocks_offset, blocks_size);
+		memcpy(prefix.data() + blocks_offset, data + sizeof(VioletBlockHeader) + sizeof(uint32_t) * (size_t)header.block_count, (size_t)blocks_size);
+		return eastl::move(prefix);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Vector<char> VioletBaseAssetManager::ReadLooseData(uint64_t hash, uint64_t size) const
+	{
+		// Reads the header and the block table first, then only the blocks that are needed.
+		FILE* file = FileSystem::fopen(file_path_generated_ + magic_number_ + "_data_" + toString(hash));
+		if (!file)
+			return Vector<char>();
+
+		fseek(file, 0, SEEK_END);
+		const long file_size = ftell(file);
+		const size_t skip = magic_number_.size();
+		Vector<char> head(skip + sizeof(VioletBlockHeader));
+		fseek(file, 0, SEEK_SET);
+
+		bool blocked = file_size >= (long)head.size() && fread(head.data(), 1u, head.size(), file) == head.size();
+		if (blocked && memcmp(head.data(), magic_number_.data(), skip) != 0)
+		{
+			FileSystem::fclose(file);
+			foundation::Error("AssetManager: Header mismatch!");
+			return Vector<char>();
+		}
+
+		VioletBlockHeader header;
+		if (blocked)
+		{
+			memcpy(&header, head.data() + skip, sizeof(VioletBlockHeader));
+			const uint64_t table_size = sizeof(uint32_t) * (uint64_t)header.block_count;
+			blocked = memcmp(header.magic_number, "LBLK", 4u) == 0 && header.version == kBlockVersion && head.size() + table_size <= (uint64_t)file_size;
+			if (blocked)
+			{
+				head.resize(head.size() + (size_t)table_size);
+				blocked = fread(head.data() + skip + sizeof(VioletBlockHeader), 1u, (size_t)table_size, file) == (size_t)table_size &&
+					readBlockHeader(head.data() + skip, (size_t)file_size - skip, header);
+			}
+		}
+
+		// Old data is a single block, that has to be read as a whole.
+		if (!blocked)
+		{
+			FileSystem::fclose(file);
+			return eastl::move(ReadData(hash));
+		}
+
+		const uint32_t block_count = (uint32_t)eastl::min<uint64_t>(header.block_count, (size + header.block_size - 1u) / header.block_size);
+		size_t blocks_offset;
+		uint64_t blocks_size;
+		Vector<char> prefix = beginPrefix(header, head.data() + skip + sizeof(VioletBlockHeader), block_count, blocks_offset, blocks_size);
+		// The blocks follow the table right away, the file is still there.
+		const bool read = fread(prefix.data() + blocks_offset, 1u, (size_t)blocks_size, file) == (size_t)blocks_size;
+		FileSystem::fclose(file);
+
+		LMB_ASSERT(read, "AssetManager: Could not read the data of %llu", (unsigned long long)hash);
+		return eastl::move(prefix);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Vector<char> VioletBaseAssetManager::DecodeData(uint64_t hash, const Vector<char>& data) const
+	{
+		// Archives store data that does not compress well as is.
+		const VioletPackArchive::Entry* entry = FindEntry(hash, VioletPackArchive::Kind::kData);
+		if (entry && (entry->flags & VioletPackArchive::kEntryFlagCompressed) == 0u)
+			return data;
+
+		return eastl::move(DecompressData(data));
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Vector<char> VioletBaseAssetManager::DecompressData(const Vector<char>& data)
+	{
+		return eastl::move(DecompressData(data.data(), data.size()));
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Vector<char> VioletBaseAssetManager::DecompressData(const char* data, size_t data_size)
+	{
+		VioletBlockHeader header;
+		if (readBlockHeader(data, data_size, header))
+		{
+			// Every block knows where it goes, so they are decompressed straight into the result.
+			Vector<uint64_t> offsets(header.block_count);
+			uint64_t offset = sizeof(VioletBlockHeader) + sizeof(uint32_t) * header.block_count;
+			for (uint32_t i = 0u; i < header.block_count; ++i)
+			{
+				offsets[i] = offset;
+				uint32_t block_size;
+				memcpy(&block_size, data + sizeof(VioletBlockHeader) + sizeof(uint32_t) * i, sizeof(uint32_t));
+				offset += block_size & ~kBlockUncompressed;
+			}
+
+			Vector<char> decompressed_data((size_t)header.original_size);
+			std::atomic<bool> failed(false);
+			ParallelFor(header.block_count, [&](uint32_t i) {
+				uint32_t block_size;
+				memcpy(&block_size, data + sizeof(VioletBlockHeader) + sizeof(uint32_t) * i, sizeof(uint32_t));
+				char* dst = decompressed_data.data() + (size_t)i * header.block_size;
+				const int dst_size = (int)eastl::min<uint64_t>(header.block_size, header.original_size - (uint64_t)i * header.block_size);
+
+				if (block_size & kBlockUncompressed)
+					memcpy(dst, data + offsets[i], (size_t)dst_size);
+				else if (LZ4_decompress_safe(data + offsets[i], dst, (int)block_size, dst_size) != dst_size)
+					failed = true;
+			});
+
+			LMB_ASSERT(!failed, "AssetManager: Could not decompress the data.");
+			return eastl::move(decompressed_data);
+		}
+
+		uint32_t original_size = 0u;
+		memcpy(&original_size, data + data_size - sizeof(uint32_t), sizeof(uint32_t));
+
+		int size = LZ4_compressBound((int)original_size);
+		// Decompress the data.
+		Vector<char> decompressed_data(size, '\0');
+		int res = LZ4_decompress_safe(data, decompressed_data.data(), (int)(data_size - sizeof(uint32_t)), (int)decompressed_data.size());
+
+		if (res < 0)
+			LMB_ASSERT(false, "AssetManager: Could not decompress the data.");
+		else
+			decompressed_data.resize((uint64_t)res);
+
+		return eastl::move(decompressed_data);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	uint64_t VioletBaseAssetManager::GetDecompressedSize(const char* data, size_t size)
+	{
+		VioletBlockHeader header;
+		if (readBlockHeader(data, size, header))
+			return header.original_size;
+
+		uint32_t original_size = 0u;
+		if (size >= sizeof(uint32_t))
+			memcpy(&original_size, data + size - sizeof(uint32_t), sizeof(uint32_t));
+		return original_size;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	void VioletBaseAssetManager::SetCompression(VioletCompression compression, uint32_t block_size)
+	{
+		LMB_ASSERT(block_size > 0u && block_size < kBlockUncompressed, "AssetManager: Invalid block size %u", block_size);
+		compression_ = compression;
+		block_size_  = block_size;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	void VioletBaseAssetManager::SetJobQueue(Function<void(Function<void(void)>)> job_queue, uint32_t worker_count)
+	{
+		s_job_queue_   = job_queue;
+		s_job_workers_ = worker_count;
+	}
+
   /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   bool VioletBaseAssetManager::HasHeader(uint64_t hash) const
   {
+    if (FindEntry(hash, VioletPackArchive::Kind::kData))
+      return true;
     return FileSystem::DoesFileExist(file_path_generated_ + magic_number_ + "_data_" + toString(hash));
   }
 
@@ -48,11 +366,43 @@ namespace lambda
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	void VioletBaseAssetManager::SaveData(const Vector<char>& data, uint64_t hash)
 	{
-		Vector<char> compressed_data((uint64_t)LZ4_compressBound((int)data.size()), '\0');
-		compressed_data.resize(LZ4_compress_default(data.data(), compressed_data.data(), (int)data.size(), (int)compressed_data.size()) + sizeof(uint32_t));
-		//int compression = (int)((1.0f - (float)compressed_data.size() / (float)data.size()) * 100.0f);
-		uint32_t size = (uint32_t)data.size();
-		memcpy(compressed_data.end() - sizeof(uint32_t), &size, sizeof(uint32_t));
+		VioletBlockHeader header;
+		memcpy(header.magic_number, "LBLK", 4u);
+		header.version       = kBlockVersion;
+		header.compression   = (uint8_t)compression_;
+		header.padding       = 0u;
+		header.block_size    = block_size_;
+		header.block_count   = (uint32_t)((data.size() + block_size_ - 1u) / block_size_);
+		header.original_size = data.size();
+
+		Vector<Vector<char>> blocks(header.block_count);
+		ParallelFor(header.block_count, [&](uint32_t i) {
+			const char* src = data.data() + (size_t)i * block_size_;
+			const int src_size = (int)eastl::min<size_t>(block_size_, data.size() - (size_t)i * block_size_);
+
+			Vector<char>& block = blocks[i];
+			block.resize((size_t)LZ4_compressBound(src_size));
+			int size = 0;
+			if (compression_ == VioletCompression::kLZ4HC)
+				size = LZ4_compress_HC(src, block.data(), src_size, (int)block.size(), LZ4HC_CLEVEL_DEFAULT);
+			else if (compression_ == VioletCompression::kLZ4)
+				size = LZ4_compress_default(src, block.data(), src_size, (int)block.size());
+
+			if (size <= 0 || size >= src_size)
+				block.assign(src, src + src_size);
+			else
+				block.resize((size_t)size);
+		});
+
+		Vector<char> compressed_data(sizeof(VioletBlockHeader) + sizeof(uint32_t) * header.block_count);
+		memcpy(compressed_data.data(), &header, sizeof(VioletBlockHeader));
+		for (uint32_t i = 0u; i < header.block_count; ++i)
+		{
+			const size_t src_size = eastl::min<size_t>(block_size_, data.size() - (size_t)i * block_size_);
+			const uint32_t size = (uint32_t)blocks[i].size() | (blocks[i].size() == src_size ? kBlockUncompressed : 0u);
+			memcpy(compressed_data.data() + sizeof(VioletBlockHeader) + sizeof(uint32_t) * i, &size, sizeof(uint32_t));
+			compressed_data.insert(compressed_data.end(), blocks[i].begin(), blocks[i].end());
+		}
 
 		FileSystem::WriteFile(file_path_generated_ + magic_number_ + "_data_" + toString(hash), compressed_data.data(), compressed_data.size(), magic_number_.data(), magic_number_.size());
 	}
@@ -66,27 +416,26 @@ namespace lambda
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	Vector<char> VioletBaseAssetManager::LoadData(uint64_t hash) const
 	{
-		Vector<char> data = FileSystem::FileToVector(file_path_generated_ + magic_number_ + "_data_" + toString(hash), magic_number_.data(), magic_number_.size());
+		// Decompress straight from the mapped archive, without reading the blob into memory first.
+		const VioletPackArchive::Entry* entry = FindEntry(hash, VioletPackArchive::Kind::kData);
+		if (entry)
+		{
+			const char* view = s_archive_->GetView(*entry);
+			if (entry->flags & VioletPackArchive::kEntryFlagCompressed)
+				return eastl::move(DecompressData(view, (size_t)entry->size));
+			return Vector<char>(view, view + entry->size);
+		}
 
-		uint32_t original_size = 0u;
-		memcpy(&original_size, data.end() - sizeof(uint32_t), sizeof(uint32_t));
-
-		int size = LZ4_compressBound((int)original_size);
-		// Decompress the data.
-		Vector<char> decompressed_data(size, '\0');
-		int res = LZ4_decompress_safe(data.data(), decompressed_data.data(), (int)data.size() - sizeof(uint32_t), (int)decompressed_data.size());
-
-		if (res < 0)
-			LMB_ASSERT(false, "AssetManager: Could not decompress the data.");
-		else
-			decompressed_data.resize((uint64_t)res);
-
-		return eastl::move(decompressed_data);
+		return eastl::move(DecompressData(ReadData(hash)));
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	Vector<char> VioletBaseAssetManager::LoadHeader(uint64_t hash) const
 	{
+		const VioletPackArchive::Entry* entry = FindEntry(hash, VioletPackArchive::Kind::kHeader);
+		if (entry)
+			return Vector<char>(s_archive_->GetView(*entry), s_archive_->GetView(*entry) + entry->size);
+
 		return eastl::move(FileSystem::FileToVector(file_path_generated_ + magic_number_ + "_header_" + toString(hash), magic_number_.data(), magic_number_.size()));
 	}
 
@@ -101,4 +450,61 @@ namespace lambda
 	{
 		FileSystem::RemoveFile(file_path_generated_ + magic_number_ + "_header_" + toString(hash));
 	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	void VioletBaseAssetManager::MountArchive(const VioletPackArchive* archive)
+	{
+		s_archive_ = (archive && archive->IsOpen()) ? archive : nullptr;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	const VioletPackArchive::Entry* VioletBaseAssetManager::FindEntry(uint64_t hash, VioletPackArchive::Kind kind) const
+	{
+		return s_archive_ ? s_archive_->Find(hash, magic_number_, kind) : nullptr;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	void VioletBaseAssetManager::ParallelFor(uint32_t count, Function<void(uint32_t)> function)
+	{
+		if (count <= 1u || !s_job_queue_)
+		{
+			for (uint32_t i = 0u; i < count; ++i)
+				function(i);
+			return;
+		}
+
+		// The calling thread works along, so this never waits on jobs that did
+		// not get picked up. Jobs that start late find nothing left to do, which
+		// is why the state is shared with them.
+		struct State
+		{
+			std::atomic<uint32_t> next;
+			std::atomic<uint32_t> done;
+			uint32_t count;
+			Function<void(uint32_t)> function;
+		};
+		foundation::SharedPointer<State> state = foundation::Memory::constructShared<State>();
+		state->next     = 0u;
+		state->done     = 0u;
+		state->count    = count;
+		state->function = function;
+
+		auto work = [state]() {
+			uint32_t i;
+			while ((i = state->next++) < state->count)
+			{
+				state->function(i);
+				state->done++;
+			}
+		};
+
+		// One job per worker, the calling thread takes the rest. count is at least two here.
+		const uint32_t job_count = eastl::min(count - 1u, s_job_workers_);
+		for (uint32_t i = 0u; i < job_count; ++i)
+			s_job_queue_(work);
+
+		work();
+		while (state->done < count)
+			std::this_thread::yield();
+	}
 }
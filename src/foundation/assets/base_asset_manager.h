@@ -1,17 +1,54 @@
 #pragma once
 #include <containers/containers.h>
 #include "package/package.h"
+#include "package/pack_archive.h"
 
 namespace lambda
 {
+  enum class VioletCompression : uint8_t
+  {
+    kNone,
+    kLZ4,
+    kLZ4HC,
+  };
+
   class VioletBaseAssetManager
   {
+  public:
+    static constexpr uint32_t kDefaultBlockSize = 256u * 1024u;
+
   public: // Not virtuals
     void SetMagicNumber(String magic_number);
     void SetGeneratedFilePath(String file_path);
+	String GetGeneratedFilePath() const;
+	// Tells if a file in the generated folder belongs to this manager and which asset it holds.
+	bool ParseGeneratedFile(const String& file, uint64_t& hash) const;
+	// The loose header and data files of an asset, only the ones that exist.
+	Vector<String> GetGeneratedFiles(uint64_t hash) const;
 	Vector<char> GetData(uint64_t hash) const;
 	Vector<char> GetHeader(uint64_t hash) const;
+	// Points straight into the mounted archive, loose headers are loaded into storage.
+	const char* GetHeader(uint64_t hash, Vector<char>& storage, size_t& size) const;
 	bool HasHeader(uint64_t hash) const;
+	// Split version of GetData so reading and decompressing can happen on different threads.
+	Vector<char> ReadData(uint64_t hash) const;
+	// Only reads the blocks that cover the first size bytes, the result still goes through DecodeData.
+	Vector<char> ReadData(uint64_t hash, uint64_t size) const;
+	Vector<char> DecodeData(uint64_t hash, const Vector<char>& data) const;
+	static Vector<char> DecompressData(const Vector<char>& data);
+	static Vector<char> DecompressData(const char* data, size_t size);
+	static uint64_t GetDecompressedSize(const char* data, size_t size);
+
+	// Data is split into blocks that are compressed independently. Set by the builder per asset type.
+	void SetCompression(VioletCompression compression, uint32_t block_size = kDefaultBlockSize);
+	// Blocks are (de)compressed on the jobs this queues, next to the calling thread.
+	// worker_count is the amount of threads that run the queued jobs, no more
+	// jobs than that are queued at once. Without a job queue everything runs on
+	// the calling thread.
+	static void SetJobQueue(Function<void(Function<void(void)>)> job_queue, uint32_t worker_count);
+
+	// Assets found in the archive are read from it instead of from the generated folder.
+	static void MountArchive(const VioletPackArchive* archive);
 
     void Save() const;
     void Load();
@@ -24,8 +61,18 @@ namespace lambda
 	void RemoveData(uint64_t hash);
 	void RemoveHeader(uint64_t hash);
 
+  private:
+	const VioletPackArchive::Entry* FindEntry(uint64_t hash, VioletPackArchive::Kind kind) const;
+	Vector<char> ReadLooseData(uint64_t hash, uint64_t size) const;
+	static void ParallelFor(uint32_t count, Function<void(uint32_t)> function);
+
   private:
     String file_path_generated_;
     String magic_number_;
+	VioletCompression compression_ = VioletCompression::kLZ4;
+	uint32_t block_size_ = kDefaultBlockSize;
+	static const VioletPackArchive* s_archive_;
+	static Function<void(Function<void(void)>)> s_job_queue_;
+	static uint32_t s_job_workers_;
   };
 }
\ No newline at end of file
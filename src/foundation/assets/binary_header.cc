@@ -0,0 +1,92 @@
+#include "binary_header.h"
+#include <utils/console.h>
+
+namespace lambda
+{
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletHeaderWriter::Write(const char* data, size_t size)
+  {
+    data_.resize(data_.size() + size);
+    memcpy(data_.data() + data_.size() - size, data, size);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletHeaderWriter::WriteString(const String& string)
+  {
+    Write((uint32_t)string.size());
+    Write(string.data(), string.size());
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<char> VioletHeaderWriter::GetData() const
+  {
+    return data_;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  VioletHeaderReader::VioletHeaderReader(const char* data, size_t size, uint8_t version)
+    : data_(data)
+    , size_(size)
+    , offset_(sizeof(VioletBinaryHeaderPrefix))
+    , valid_(false)
+  {
+    if (!IsBinaryHeader(data, size))
+      return;
+
+    VioletBinaryHeaderPrefix prefix;
+    memcpy(&prefix, data, sizeof(prefix));
+    if (prefix.version != version)
+    {
+      foundation::Error("Header: Version " + toString(prefix.version) + " is not supported, expected " + toString(version) + ". Rebuild the asset.\n");
+      return;
+    }
+
+    valid_ = true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletHeaderReader::IsValid() const
+  {
+    return valid_;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletHeaderReader::Read(char* data, size_t size)
+  {
+    if (valid_ && offset_ + size > size_)
+    {
+      foundation::Error("Header: Tried to read past the end of the header.\n");
+      valid_ = false;
+    }
+
+    if (!valid_)
+    {
+      memset(data, 0, size);
+      return;
+    }
+
+    memcpy(data, data_ + offset_, size);
+    offset_ += size;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  String VioletHeaderReader::ReadString()
+  {
+    const uint32_t size = Read<uint32_t>();
+    if (!valid_ || offset_ + size > size_)
+    {
+      valid_ = false;
+      return "";
+    }
+
+    String string(data_ + offset_, data_ + offset_ + size);
+    offset_ += size;
+    return string;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletHeaderReader::IsBinaryHeader(const char* data, size_t size)
+  {
+    return size >= sizeof(VioletBinaryHeaderPrefix) && data[0] == 'L' && data[1] == 'B' && data[2] == 'H';
+  }
+}
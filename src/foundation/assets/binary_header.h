@@ -0,0 +1,104 @@
+#pragma once
+#include <containers/containers.h>
+
+namespace lambda
+{
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Asset headers are stored as a prefix, the fixed layout block of the asset
+  // type and then any variable length data (strings, lists). The reader works
+  // on a pointer, so headers can be decoded straight from a mapped archive.
+  struct VioletBinaryHeaderPrefix
+  {
+    char     magic_number[3u]; // Always "LBH", JSon headers start with '{'.
+    uint8_t  version;
+    uint32_t block_size;
+  };
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  class VioletHeaderWriter
+  {
+  public:
+    template<typename T>
+    VioletHeaderWriter(uint8_t version, const T& block);
+
+    template<typename T>
+    void Write(const T& t);
+    void Write(const char* data, size_t size);
+    void WriteString(const String& string);
+    Vector<char> GetData() const;
+
+  private:
+    Vector<char> data_;
+  };
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  class VioletHeaderReader
+  {
+  public:
+    VioletHeaderReader(const char* data, size_t size, uint8_t version);
+    bool IsValid() const;
+
+    // Copies the fixed block, T has to match the block that was written.
+    template<typename T>
+    bool ReadBlock(T& block);
+    template<typename T>
+    T Read();
+    void Read(char* data, size_t size);
+    String ReadString();
+
+    static bool IsBinaryHeader(const char* data, size_t size);
+
+  private:
+    const char* data_;
+    size_t      size_;
+    size_t      offset_;
+    bool        valid_;
+  };
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  template<typename T>
+  inline VioletHeaderWriter::VioletHeaderWriter(uint8_t version, const T& block)
+  {
+    VioletBinaryHeaderPrefix prefix;
+    memcpy(prefix.magic_number, "LBH", 3u);
+    prefix.version    = version;
+    prefix.block_size = (uint32_t)sizeof(T);
+    Write(prefix);
+    Write(block);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  template<typename T>
+  inline void VioletHeaderWriter::Write(const T& t)
+  {
+    Write((const char*)&t, sizeof(T));
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  template<typename T>
+  inline bool VioletHeaderReader::ReadBlock(T& block)
+  {
+    if (!valid_)
+      return false;
+
+    VioletBinaryHeaderPrefix prefix;
+    memcpy(&prefix, data_, sizeof(prefix));
+    if (prefix.block_size != sizeof(T))
+    {
+      valid_ = false;
+      return false;
+    }
+
+    Read((char*)&block, sizeof(T));
+    return valid_;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  template<typename T>
+  inline T VioletHeaderReader::Read()
+  {
+    T t{};
+    Read((char*)&t, sizeof(T));
+    return t;
+  }
+}
@@ -0,0 +1,242 @@
+#include "dependency_graph.h"
+#include "binary_header.h"
+#include <utils/file_system.h>
+#include <utils/console.h>
+
+namespace lambda
+{
+  namespace
+  {
+    struct VioletDependencyGraphBlock
+    {
+      uint32_t node_count;
+    };
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletDependencyGraph::AddNode(uint64_t hash, VioletAssetType type, const String& file, uint64_t size, Vector<uint64_t> dependencies)
+  {
+    eastl::sort(dependencies.begin(), dependencies.end());
+    dependencies.erase(eastl::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+    dependencies.erase(eastl::remove(dependencies.begin(), dependencies.end(), hash), dependencies.end());
+
+    Node& node = nodes_[hash];
+    node.hash         = hash;
+    node.type         = type;
+    node.size         = size;
+    node.file         = file;
+    node.dependencies = eastl::move(dependencies);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletDependencyGraph::RemoveFile(const String& file)
+  {
+    for (auto it = nodes_.begin(); it != nodes_.end();)
+    {
+      if (it->second.file == file)
+        it = nodes_.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  const VioletDependencyGraph::Node* VioletDependencyGraph::GetNode(uint64_t hash) const
+  {
+    auto it = nodes_.find(hash);
+    return it != nodes_.end() ? &it->second : nullptr;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint32_t VioletDependencyGraph::GetNodeCount() const
+  {
+    return (uint32_t)nodes_.size();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<uint64_t> VioletDependencyGraph::GetClosure(const Vector<uint64_t>& roots) const
+  {
+    Set<uint64_t> visited;
+    Vector<uint64_t> stack;
+    Vector<uint64_t> closure;
+
+    for (uint64_t root : roots)
+      stack.push_back(root);
+
+    while (!stack.empty())
+    {
+      const uint64_t hash = stack.back();
+      stack.pop_back();
+      if (!visited.insert(hash).second)
+        continue;
+
+      const Node* node = GetNode(hash);
+      if (!node)
+        continue;
+
+      closure.push_back(hash);
+      for (uint64_t dependency : node->dependencies)
+        stack.push_back(dependency);
+    }
+
+    // Grouped by type, and in hash order within a type, which is also the order of the archive.
+    eastl::sort(closure.begin(), closure.end(), [this](uint64_t lhs, uint64_t rhs) { return Less(lhs, rhs); });
+    return closure;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  VioletDependencyGraph::Footprint VioletDependencyGraph::GetFootprint(const Vector<uint64_t>& assets) const
+  {
+    Footprint footprint;
+    for (uint64_t hash : assets)
+    {
+      const Node* node = GetNode(hash);
+      if (!node)
+        continue;
+
+      footprint.count[(int)node->type]++;
+      footprint.size[(int)node->type] += node->size;
+      footprint.total += node->size;
+    }
+    return footprint;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<uint64_t> VioletDependencyGraph::GetUnloaded(const Vector<uint64_t>& from, const Vector<uint64_t>& to) const
+  {
+    Vector<uint64_t> unloaded;
+    size_t j = 0u;
+    for (uint64_t hash : from)
+    {
+      while (j < to.size() && Less(to[j], hash))
+        j++;
+      if (j == to.size() || to[j] != hash)
+        unloaded.push_back(hash);
+    }
+    return unloaded;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<char> VioletDependencyGraph::Serialize() const
+  {
+    // Sorted, so the same graph always gives the same file.
+    Vector<const Node*> nodes;
+    nodes.reserve(nodes_.size());
+    for (const auto& it : nodes_)
+      nodes.push_back(&it.second);
+    eastl::sort(nodes.begin(), nodes.end(), [](const Node* lhs, const Node* rhs) { return lhs->hash < rhs->hash; });
+
+    VioletDependencyGraphBlock block;
+    block.node_count = (uint32_t)nodes.size();
+
+    VioletHeaderWriter writer(kVersion, block);
+    for (const Node* node : nodes)
+    {
+      writer.Write(node->hash);
+      writer.Write(node->type);
+      writer.Write(node->size);
+      writer.WriteString(node->file);
+      writer.Write((uint32_t)node->dependencies.size());
+      writer.Write((const char*)node->dependencies.data(), node->dependencies.size() * sizeof(uint64_t));
+    }
+    return writer.GetData();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletDependencyGraph::Deserialize(const char* data, size_t size)
+  {
+    nodes_.clear();
+
+    VioletHeaderReader reader(data, size, kVersion);
+    VioletDependencyGraphBlock block;
+    if (!reader.ReadBlock(block))
+      return false;
+
+    for (uint32_t i = 0u; i < block.node_count && reader.IsValid(); ++i)
+    {
+      Node node;
+      node.hash = reader.Read<uint64_t>();
+      node.type = reader.Read<VioletAssetType>();
+      node.size = reader.Read<uint64_t>();
+      node.file = reader.ReadString();
+      const uint32_t dependency_count = reader.Read<uint32_t>();
+      if (!reader.IsValid() || dependency_count > size / sizeof(uint64_t))
+        break;
+      node.dependencies.resize(dependency_count);
+      reader.Read((char*)node.dependencies.data(), dependency_count * sizeof(uint64_t));
+      nodes_[node.hash] = eastl::move(node);
+    }
+
+    if (!reader.IsValid())
+    {
+      nodes_.clear();
+      return false;
+    }
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletDependencyGraph::Save(const String& file) const
+  {
+    FileSystem::WriteFile(file, Serialize());
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletDependencyGraph::Load(const String& file)
+  {
+    nodes_.clear();
+    if (!FileSystem::DoesFileExist(file))
+      return false;
+
+    const Vector<char> data = FileSystem::FileToVector(file);
+    if (!Deserialize(data.data(), data.size()))
+    {
+      foundation::Error("DependencyGraph: " + file + " is not valid, it will be generated again\n");
+      return false;
+    }
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  VioletAssetType VioletDependencyGraph::TypeFromExtension(const String& extension)
+  {
+    if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "hdr")
+      return VioletAssetType::kTexture;
+    if (extension == "gltf" || extension == "glb")
+      return VioletAssetType::kMesh;
+    if (extension == "fx")
+      return VioletAssetType::kShader;
+    if (extension == "wav")
+      return VioletAssetType::kWave;
+    if (extension == "wren" || extension == "as")
+      return VioletAssetType::kScript;
+    return VioletAssetType::kUnknown;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  String VioletDependencyGraph::TypeToString(VioletAssetType type)
+  {
+    switch (type)
+    {
+    case VioletAssetType::kTexture: return "textures";
+    case VioletAssetType::kMesh:    return "meshes";
+    case VioletAssetType::kShader:  return "shaders";
+    case VioletAssetType::kWave:    return "waves";
+    case VioletAssetType::kScript:  return "scripts";
+    default:                        return "unknown";
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletDependencyGraph::Less(uint64_t lhs, uint64_t rhs) const
+  {
+    const Node* l = GetNode(lhs);
+    const Node* r = GetNode(rhs);
+    const VioletAssetType lt = l ? l->type : VioletAssetType::kUnknown;
+    const VioletAssetType rt = r ? r->type : VioletAssetType::kUnknown;
+    if (lt != rt)
+      return lt < rt;
+    return lhs < rhs;
+  }
+}
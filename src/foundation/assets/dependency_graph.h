@@ -0,0 +1,70 @@
+#pragma once
+#include <containers/containers.h>
+
+namespace lambda
+{
+  enum class VioletAssetType : uint8_t
+  {
+    kUnknown,
+    kTexture,
+    kMesh,
+    kShader,
+    kWave,
+    kScript,
+    kCount,
+  };
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Which assets need which other assets, written by the builder. Nodes are
+  // keyed by the same hash the asset managers use, so a level's closure can
+  // be handed straight to them. Scripts are nodes as well, a level is the
+  // closure of its main script.
+  class VioletDependencyGraph
+  {
+  public:
+    static constexpr uint8_t kVersion = 1u;
+
+    struct Node
+    {
+      uint64_t         hash;
+      VioletAssetType  type;
+      uint64_t         size; // Uncompressed size of the generated data.
+      String           file; // Source file, shader permutations share theirs.
+      Vector<uint64_t> dependencies;
+    };
+
+    struct Footprint
+    {
+      uint32_t count[(int)VioletAssetType::kCount] = {};
+      uint64_t size[(int)VioletAssetType::kCount] = {};
+      uint64_t total = 0u;
+    };
+
+    void AddNode(uint64_t hash, VioletAssetType type, const String& file, uint64_t size, Vector<uint64_t> dependencies);
+    // Removes every node that was generated from the file.
+    void RemoveFile(const String& file);
+    const Node* GetNode(uint64_t hash) const;
+    uint32_t GetNodeCount() const;
+
+    // The roots and everything they need, sorted by type and then by hash.
+    // Dependencies on assets that are not in the graph are skipped.
+    Vector<uint64_t> GetClosure(const Vector<uint64_t>& roots) const;
+    Footprint GetFootprint(const Vector<uint64_t>& assets) const;
+    // Assets in from that are not in to. Both have to be sorted like GetClosure sorts them.
+    Vector<uint64_t> GetUnloaded(const Vector<uint64_t>& from, const Vector<uint64_t>& to) const;
+
+    Vector<char> Serialize() const;
+    bool Deserialize(const char* data, size_t size);
+    bool Save(const String& file) const;
+    bool Load(const String& file);
+
+    static VioletAssetType TypeFromExtension(const String& extension);
+    static String TypeToString(VioletAssetType type);
+
+  private:
+    bool Less(uint64_t lhs, uint64_t rhs) const;
+
+  private:
+    UnorderedMap<uint64_t, Node> nodes_;
+  };
+}
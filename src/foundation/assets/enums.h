@@ -100,7 +100,8 @@ namespace lambda
       bpr = (w + 3u) / 4u * 8u;
       if (bpr < 8u)
         bpr = 8u;
-      bpl = w * h / 2u;
+      // Partial blocks at the edges still take up a whole block.
+      bpl = bpr * ((h + 3u) / 4u);
       if (bpl < 8u)
         bpl = 8u;
       break;
@@ -113,7 +114,7 @@ namespace lambda
       bpr = (w + 3u) / 4u * 16u;
       if (bpr < 16u)
         bpr = 16u;
-      bpl = w * h;
+      bpl = bpr * ((h + 3u) / 4u);
       if (bpl < 16u)
         bpl = 16u;
       break;
@@ -1,13 +1,23 @@
 #include "mesh_manager.h"
+#include "binary_header.h"
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
 #include <utils/console.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <cfloat>
 
 namespace lambda
 {
 	static constexpr char kMagicHeader[] = { 'L', 'M', 'B' };
 	static constexpr char kInvalidHeader[] = { 'I', 'N', 'V' };
+	static constexpr uint8_t kMeshHeaderVersion = 1u;
+
+	struct VioletMeshHeaderBlock
+	{
+		uint64_t hash;
+	};
 
 	struct VioletDataHeader
 	{
@@ -31,6 +41,42 @@ namespace lambda
 		size_t dmra_count;
 		size_t emi_count;
 	};
+	// Optional, meshes written before quantization existed end after the models.
+	struct VioletQuantizationHeader
+	{
+		uint32_t quantized;
+		uint32_t bounds_count;
+	};
+	// Optional, follows the quantization header, which is always written when there are LODs.
+	struct VioletLODHeader
+	{
+		uint32_t lod_count;
+	};
+	// Optional, follows the LOD header, which is always written when there are impostors.
+	struct VioletImpostorHeader
+	{
+		uint32_t frames;
+		uint32_t impostor_count;
+	};
+	// Optional, follows the impostor header, which is always written when there are clusters.
+	struct VioletClusterHeader
+	{
+		uint32_t cluster_count;
+	};
+	// Optional, follows the cluster header, which is always written when there is a skeleton.
+	struct VioletSkinHeader
+	{
+		uint32_t joint_count;
+		uint32_t clip_count;
+	};
+	struct VioletClipHeader
+	{
+		float    duration;
+		float    frame_rate;
+		uint32_t frame_count;
+		uint32_t track_count;
+		uint32_t key_count;
+	};
 
 	void write(Vector<char>& data, const char* t, size_t len)
 	{
@@ -126,6 +172,72 @@ namespace lambda
 		writeHeader(data, mesh.data.tex_alb, mesh.data.tex_nrm, mesh.data.tex_dmra, mesh.data.tex_emi);
 		writeHeader(data, mesh.meshes);
 
+		const bool has_skin      = !mesh.data.joints.empty();
+		const bool has_clusters  = !mesh.data.clusters.empty() || has_skin;
+		const bool has_impostors = !mesh.data.impostors.empty() || has_clusters;
+		const bool has_lods      = !mesh.data.lods.empty() || has_impostors;
+		if (mesh.data.quantized != 0u || has_lods)
+		{
+			VioletQuantizationHeader header;
+			header.quantized    = mesh.data.quantized;
+			header.bounds_count = (uint32_t)mesh.data.pos_bounds.size();
+			write(data, header);
+			write(data, (const char*)mesh.data.pos_bounds.data(), mesh.data.pos_bounds.size() * sizeof(glm::vec3));
+		}
+
+		if (has_lods)
+		{
+			VioletLODHeader header;
+			header.lod_count = (uint32_t)mesh.data.lods.size();
+			write(data, header);
+			write(data, (const char*)mesh.data.lods.data(), mesh.data.lods.size() * sizeof(VioletMeshLOD));
+		}
+
+		if (has_impostors)
+		{
+			VioletImpostorHeader header;
+			header.frames         = mesh.data.impostor_frames;
+			header.impostor_count = (uint32_t)mesh.data.impostors.size();
+			write(data, header);
+			for (const String* texture : { &mesh.data.impostor_albedo, &mesh.data.impostor_normal_depth })
+			{
+				write(data, (size_t)texture->size());
+				write(data, texture->c_str(), texture->size());
+			}
+			write(data, (const char*)mesh.data.impostors.data(), mesh.data.impostors.size() * sizeof(VioletMeshImpostor));
+		}
+
+		if (has_clusters)
+		{
+			VioletClusterHeader header;
+			header.cluster_count = (uint32_t)mesh.data.clusters.size();
+			write(data, header);
+			write(data, (const char*)mesh.data.clusters.data(), mesh.data.clusters.size() * sizeof(VioletMeshCluster));
+		}
+
+		if (has_skin)
+		{
+			VioletSkinHeader header;
+			header.joint_count = (uint32_t)mesh.data.joints.size();
+			header.clip_count  = (uint32_t)mesh.data.clips.size();
+			write(data, header);
+			write(data, (const char*)mesh.data.joints.data(), mesh.data.joints.size() * sizeof(VioletMeshJoint));
+			for (const VioletAnimationClip& clip : mesh.data.clips)
+			{
+				VioletClipHeader clip_header;
+				clip_header.duration    = clip.duration;
+				clip_header.frame_rate  = clip.frame_rate;
+				clip_header.frame_count = clip.frame_count;
+				clip_header.track_count = (uint32_t)clip.tracks.size();
+				clip_header.key_count   = (uint32_t)clip.keys.size();
+				write(data, clip_header);
+				write(data, (size_t)clip.name.size());
+				write(data, clip.name.c_str(), clip.name.size());
+				write(data, (const char*)clip.tracks.data(), clip.tracks.size() * sizeof(VioletAnimationTrack));
+				write(data, (const char*)clip.keys.data(), clip.keys.size() * sizeof(uint16_t));
+			}
+		}
+
 		finalizeWriting(data);
 		return eastl::move(data);
 	}
@@ -251,8 +363,134 @@ namespace lambda
 		readHeader(data, offset, mesh.data.idx);
 		readHeader(data, offset, mesh.data.tex_alb, mesh.data.tex_nrm, mesh.data.tex_dmra, mesh.data.tex_emi);
 		readHeader(data, offset, mesh.meshes);
+
+		if (offset + sizeof(VioletQuantizationHeader) <= data.size())
+		{
+			VioletQuantizationHeader header;
+			read(data, offset, header);
+			mesh.data.quantized = header.quantized;
+			mesh.data.pos_bounds.resize(header.bounds_count);
+			read(data, offset, (char*)mesh.data.pos_bounds.data(), header.bounds_count * sizeof(glm::vec3));
+		}
+
+		if (offset + sizeof(VioletLODHeader) <= data.size())
+		{
+			VioletLODHeader header;
+			read(data, offset, header);
+			mesh.data.lods.resize(header.lod_count);
+			read(data, offset, (char*)mesh.data.lods.data(), header.lod_count * sizeof(VioletMeshLOD));
+		}
+
+		if (offset + sizeof(VioletImpostorHeader) <= data.size())
+		{
+			VioletImpostorHeader header;
+			read(data, offset, header);
+			mesh.data.impostor_frames = header.frames;
+			for (String* texture : { &mesh.data.impostor_albedo, &mesh.data.impostor_normal_depth })
+			{
+				size_t size;
+				read(data, offset, size);
+				texture->resize(size);
+				read(data, offset, (char*)texture->data(), size);
+			}
+			mesh.data.impostors.resize(header.impostor_count);
+			read(data, offset, (char*)mesh.data.impostors.data(), header.impostor_count * sizeof(VioletMeshImpostor));
+		}
+
+		if (offset + sizeof(VioletClusterHeader) <= data.size())
+		{
+			VioletClusterHeader header;
+			read(data, offset, header);
+			mesh.data.clusters.resize(header.cluster_count);
+			read(data, offset, (char*)mesh.data.clusters.data(), header.cluster_count * sizeof(VioletMeshCluster));
+		}
+
+		if (offset + sizeof(VioletSkinHeader) <= data.size())
+		{
+			VioletSkinHeader header;
+			read(data, offset, header);
+			mesh.data.joints.resize(header.joint_count);
+			read(data, offset, (char*)mesh.data.joints.data(), header.joint_count * sizeof(VioletMeshJoint));
+			mesh.data.clips.resize(header.clip_count);
+			for (VioletAnimationClip& clip : mesh.data.clips)
+			{
+				VioletClipHeader clip_header;
+				read(data, offset, clip_header);
+				clip.duration    = clip_header.duration;
+				clip.frame_rate  = clip_header.frame_rate;
+				clip.frame_count = clip_header.frame_count;
+				size_t size;
+				read(data, offset, size);
+				clip.name.resize(size);
+				read(data, offset, (char*)clip.name.data(), size);
+				clip.tracks.resize(clip_header.track_count);
+				read(data, offset, (char*)clip.tracks.data(), clip_header.track_count * sizeof(VioletAnimationTrack));
+				clip.keys.resize(clip_header.key_count);
+				read(data, offset, (char*)clip.keys.data(), clip_header.key_count * sizeof(uint16_t));
+			}
+		}
+	}
+
+	// Octahedral mapping of a unit vector to [-1, 1]^2.
+	glm::vec2 octEncode(glm::vec3 n)
+	{
+		n /= (glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z));
+		glm::vec2 oct(n.x, n.y);
+		if (n.z < 0.0f)
+		{
+			oct = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return oct;
+	}
+	glm::vec3 octDecode(glm::vec2 oct)
+	{
+		glm::vec3 n(oct.x, oct.y, 1.0f - glm::abs(oct.x) - glm::abs(oct.y));
+		const float t = glm::max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		return glm::normalize(n);
+	}
+	// 10:10:10:2 unorm, like DXGI_FORMAT_R10G10B10A2_UNORM. The octahedral
+	// coordinate goes in x and y, z stays zero.
+	uint32_t packDirection(const glm::vec2& oct, uint32_t w)
+	{
+		const glm::vec2 v = glm::round(glm::clamp(oct * 0.5f + 0.5f, 0.0f, 1.0f) * 1023.0f);
+		return (uint32_t)v.x | ((uint32_t)v.y << 10u) | (w << 30u);
+	}
+
+	// Rewrites every segment of the stream with a new element size, offsets follow.
+	template<typename From, typename To, typename Convert>
+	bool convertStream(VioletDataInfo& info, size_t from_stride, Convert convert)
+	{
+		for (const VioletDataSegment& segment : info.segments)
+			if (segment.stride != from_stride)
+				return false;
+
+		Vector<unsigned char> data;
+		for (uint32_t s = 0u; s < info.segments.size(); ++s)
+		{
+			VioletDataSegment& segment = info.segments[s];
+			const size_t offset = data.size();
+			data.resize(offset + segment.count * sizeof(To));
+			for (size_t i = 0u; i < segment.count; ++i)
+			{
+				From from;
+				memcpy(&from, info.data.data() + segment.offset + i * from_stride, sizeof(From));
+				const To to = convert(s, from);
+				memcpy(data.data() + offset + i * sizeof(To), &to, sizeof(To));
+			}
+			segment.offset = offset;
+			segment.stride = sizeof(To);
+		}
+		info.data = eastl::move(data);
+		return true;
 	}
 
+	struct QuantizedPosition  { uint16_t v[4]; };
+	struct QuantizedDirection { uint32_t v; };
+	struct QuantizedTexCoord  { uint32_t v; };
+	struct Tangent           { glm::vec4 v; };
+
 
 
 
@@ -286,7 +524,7 @@ namespace lambda
   /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   void VioletMeshManager::AddMesh(VioletMesh mesh)
   {
-    SaveHeader(MeshHeaderToJSon(mesh), mesh.hash);
+    SaveHeader(MeshHeaderToBinary(mesh), mesh.hash);
 	Vector<char> data = write(mesh);
 	SaveData(data, mesh.hash);
   }
@@ -294,7 +532,13 @@ namespace lambda
   /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   VioletMesh VioletMeshManager::GetMesh(uint64_t hash, bool get_data)
   {
-    VioletMesh mesh = JSonToMeshHeader(GetHeader(hash));
+    Vector<char> storage;
+    size_t size = 0u;
+    const char* header = GetHeader(hash, storage, size);
+
+    VioletMesh mesh = VioletHeaderReader::IsBinaryHeader(header, size) ?
+      BinaryToMeshHeader(header, size) :
+      JSonToMeshHeader(Vector<char>(header, header + size));
     if (get_data)
       read(mesh, GetData(hash));
     return mesh;
@@ -307,6 +551,146 @@ namespace lambda
 		RemoveHeader(hash);
   }
 
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  String VioletMeshManager::DumpHeader(uint64_t hash)
+  {
+    Vector<char> json = MeshHeaderToJSon(GetMesh(hash));
+    return String(json.begin(), json.end());
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletMeshManager::Quantize(VioletMesh& mesh, uint32_t streams)
+  {
+    VioletMeshData& data = mesh.data;
+    streams &= ~data.quantized;
+
+    if (streams & kMeshQuantizedPositions)
+    {
+      Vector<glm::vec3> bounds;
+      for (const VioletDataSegment& segment : data.pos.segments)
+      {
+        glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+        for (size_t i = 0u; i < segment.count && segment.stride == sizeof(glm::vec3); ++i)
+        {
+          glm::vec3 p;
+          memcpy(&p, data.pos.data.data() + segment.offset + i * segment.stride, sizeof(glm::vec3));
+          min = glm::min(min, p);
+          max = glm::max(max, p);
+        }
+        bounds.push_back(segment.count > 0u ? min : glm::vec3(0.0f));
+        bounds.push_back(segment.count > 0u ? max : glm::vec3(0.0f));
+      }
+
+      const bool converted = convertStream<glm::vec3, QuantizedPosition>(data.pos, sizeof(glm::vec3), [&bounds](uint32_t s, const glm::vec3& p) {
+        const glm::vec3 extent = glm::max(bounds[s * 2u + 1u] - bounds[s * 2u], glm::vec3(FLT_MIN));
+        const glm::vec3 n = glm::round(glm::clamp((p - bounds[s * 2u]) / extent, 0.0f, 1.0f) * 65535.0f);
+        return QuantizedPosition{ { (uint16_t)n.x, (uint16_t)n.y, (uint16_t)n.z, 0u } };
+      });
+      if (converted)
+      {
+        data.pos_bounds = eastl::move(bounds);
+        data.quantized |= kMeshQuantizedPositions;
+      }
+    }
+
+    if ((streams & kMeshQuantizedNormals) && convertStream<glm::vec3, QuantizedDirection>(data.nor, sizeof(glm::vec3), [](uint32_t, const glm::vec3& n) {
+      return QuantizedDirection{ packDirection(octEncode(glm::length(n) > 0.0f ? n : glm::vec3(0.0f, 0.0f, 1.0f)), 0u) };
+    }))
+      data.quantized |= kMeshQuantizedNormals;
+
+    if ((streams & kMeshQuantizedTangents) && convertStream<Tangent, QuantizedDirection>(data.tan, sizeof(glm::vec4), [](uint32_t, const Tangent& t) {
+      const glm::vec3 v(t.v);
+      return QuantizedDirection{ packDirection(octEncode(glm::length(v) > 0.0f ? v : glm::vec3(1.0f, 0.0f, 0.0f)), t.v.w < 0.0f ? 0u : 3u) };
+    }))
+      data.quantized |= kMeshQuantizedTangents;
+
+    if ((streams & kMeshQuantizedTexCoords) && convertStream<glm::vec2, QuantizedTexCoord>(data.tex, sizeof(glm::vec2), [](uint32_t, const glm::vec2& uv) {
+      return QuantizedTexCoord{ glm::packHalf2x16(uv) };
+    }))
+      data.quantized |= kMeshQuantizedTexCoords;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletMeshManager::Dequantize(VioletMesh& mesh)
+  {
+    VioletMeshData& data = mesh.data;
+
+    if (data.quantized & kMeshQuantizedPositions)
+    {
+      const Vector<glm::vec3>& bounds = data.pos_bounds;
+      LMB_ASSERT(bounds.size() == data.pos.segments.size() * 2u, "[MESH] Position bounds do not match the segments");
+      convertStream<QuantizedPosition, glm::vec3>(data.pos, sizeof(QuantizedPosition), [&bounds](uint32_t s, const QuantizedPosition& p) {
+        return DequantizePosition(p.v, bounds[s * 2u], bounds[s * 2u + 1u]);
+      });
+    }
+
+    if (data.quantized & kMeshQuantizedNormals)
+    {
+      convertStream<QuantizedDirection, glm::vec3>(data.nor, sizeof(QuantizedDirection), [](uint32_t, const QuantizedDirection& n) {
+        return glm::vec3(DequantizeDirection(n.v));
+      });
+    }
+
+    if (data.quantized & kMeshQuantizedTangents)
+    {
+      convertStream<QuantizedDirection, Tangent>(data.tan, sizeof(QuantizedDirection), [](uint32_t, const QuantizedDirection& t) {
+        return Tangent{ DequantizeDirection(t.v) };
+      });
+    }
+
+    if (data.quantized & kMeshQuantizedTexCoords)
+    {
+      convertStream<QuantizedTexCoord, glm::vec2>(data.tex, sizeof(QuantizedTexCoord), [](uint32_t, const QuantizedTexCoord& uv) {
+        return glm::unpackHalf2x16(uv.v);
+      });
+    }
+
+    data.quantized = 0u;
+    data.pos_bounds.clear();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  glm::vec3 VioletMeshManager::DequantizePosition(const uint16_t position[4], const glm::vec3& min, const glm::vec3& max)
+  {
+    return min + glm::vec3(position[0], position[1], position[2]) / 65535.0f * (max - min);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  glm::vec4 VioletMeshManager::DequantizeDirection(uint32_t direction)
+  {
+    const glm::vec2 oct = glm::vec2((float)(direction & 1023u), (float)((direction >> 10u) & 1023u)) / 1023.0f * 2.0f - 1.0f;
+    return glm::vec4(octDecode(oct), (direction >> 30u) != 0u ? 1.0f : -1.0f);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  VioletMesh VioletMeshManager::BinaryToMeshHeader(const char* data, size_t size)
+  {
+    VioletHeaderReader reader(data, size, kMeshHeaderVersion);
+    VioletMeshHeaderBlock block;
+    if (!reader.ReadBlock(block))
+    {
+      foundation::Error("[MESH] Invalid header\n");
+      return VioletMesh();
+    }
+
+    VioletMesh mesh;
+    mesh.hash = block.hash;
+    mesh.file = reader.ReadString();
+
+    return mesh;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<char> VioletMeshManager::MeshHeaderToBinary(const VioletMesh& mesh)
+  {
+    VioletMeshHeaderBlock block{};
+    block.hash = mesh.hash;
+
+    VioletHeaderWriter writer(kMeshHeaderVersion, block);
+    writer.WriteString(mesh.file);
+    return writer.GetData();
+  }
+
   extern String rapidjsonErrortoString(rapidjson::ParseErrorCode error);
 
   /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -3,6 +3,7 @@
 #include <containers/containers.h>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
 #include <glm/gtc/quaternion.hpp>
 
 namespace lambda
@@ -50,6 +51,89 @@ namespace lambda
 		glm::vec3 emissiveness = glm::vec3(0.0f);
 		glm::vec4 colour = glm::vec4(1.0f);
 	};
+	// Streams that are stored in a smaller format. These are formats the GPU
+	// reads, so the vertex buffers keep them and the vertex shaders decode them.
+	static constexpr uint32_t kMeshQuantizedPositions = 1u << 0u; // 4x16 bit unorm relative to the segment bounds, w is unused.
+	static constexpr uint32_t kMeshQuantizedNormals   = 1u << 1u; // 10:10:10:2 unorm, octahedral in x and y.
+	static constexpr uint32_t kMeshQuantizedTangents  = 1u << 2u; // 10:10:10:2 unorm, octahedral in x and y, the sign of w in the 2 bits.
+	static constexpr uint32_t kMeshQuantizedTexCoords = 1u << 3u; // Half floats.
+	static constexpr uint32_t kMeshQuantizedAll       = kMeshQuantizedPositions | kMeshQuantizedNormals | kMeshQuantizedTangents | kMeshQuantizedTexCoords;
+
+	// Lower detail version of an index segment, generated by the mesh compiler.
+	// It uses the same vertices as the full detail segment.
+	struct VioletMeshLOD
+	{
+		int   base  = -1;   // Index segment of the full detail mesh.
+		int   idx   = -1;   // Index segment of this level.
+		float error = 0.0f; // Largest distance to the full detail surface, in the units of the positions.
+	};
+
+	// Octahedral impostor of an index segment, baked by the mesh compiler. Its
+	// rect in the impostor atlases holds frames * frames views of the segment,
+	// frame (x, y) looks at the segment from the direction that decodes from
+	// the octahedral coordinate ((x, y) + 0.5) / frames * 2 - 1.
+	struct VioletMeshImpostor
+	{
+		int       idx    = -1;               // Index segment it was baked from.
+		glm::vec4 rect   = glm::vec4(0.0f);  // Offset and size in the atlases, in uv.
+		glm::vec3 center = glm::vec3(0.0f);  // Of the bounding sphere, in the units of the positions.
+		float     radius = 0.0f;
+		float     error  = 0.0f;             // Largest distance to the surface, like VioletMeshLOD::error.
+	};
+
+	// Small group of triangles of an index segment, built by the mesh compiler
+	// so parts of a sub mesh can be culled on their own. The triangles of a
+	// cluster follow each other in the segment.
+	struct VioletMeshCluster
+	{
+		int       idx          = -1;               // Index segment the cluster is part of.
+		uint32_t  index_offset = 0u;               // First index in the segment.
+		uint32_t  index_count  = 0u;
+		glm::vec3 center       = glm::vec3(0.0f);  // Of the bounding sphere, in the units of the positions.
+		float     radius       = 0.0f;
+		glm::vec3 cone_axis    = glm::vec3(0.0f);  // Average facing of the triangles.
+		float     cone_cutoff  = 1.0f;             // Sine of the largest angle between a triangle and the axis, one when the cone can not cull.
+	};
+
+	// Joint of the skeleton that skins the mesh, the Joints stream indexes
+	// VioletMeshData::joints. Parents come before their children. A mesh has a
+	// single skeleton, the transforms are relative to the parent of its root.
+	struct VioletMeshJoint
+	{
+		int       parent       = -1;
+		glm::mat4 inverse_bind = glm::mat4(1.0f);                   // From the mesh to the joint, in the bind pose.
+		glm::vec3 translation  = glm::vec3(0.0f);                   // Rest pose, relative to the parent.
+		glm::quat rotation     = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::vec3 scale        = glm::vec3(1.0f);
+	};
+
+	// Keys of a single joint property. A track holds one key when it does not
+	// change, otherwise a key for every frame of its clip. Every key is three
+	// words: the translations and scales are 16 bit unorm relative to the
+	// range of the track, the rotations are the three smallest components of
+	// the quaternion in 15 bits each, with the index of the largest one in
+	// the top bits of the first two words.
+	struct VioletAnimationTrack
+	{
+		uint32_t  offset = 0u;              // First key in VioletAnimationClip::keys.
+		uint32_t  count  = 0u;              // One or the frame count of the clip.
+		glm::vec3 min    = glm::vec3(0.0f); // Not used by rotations.
+		glm::vec3 extent = glm::vec3(0.0f);
+	};
+
+	// Animation of the skeleton, resampled at a fixed frame rate, so sampling
+	// never has to search for a key.
+	struct VioletAnimationClip
+	{
+		String   name;
+		float    duration    = 0.0f; // Seconds.
+		float    frame_rate  = 30.0f;
+		uint32_t frame_count = 0u;
+		// Translation, rotation and scale of every joint, in that order.
+		Vector<VioletAnimationTrack> tracks;
+		Vector<uint16_t> keys;
+	};
+
 	struct VioletMeshData
 	{
 		VioletDataInfo pos;
@@ -64,6 +148,22 @@ namespace lambda
 		Vector<String> tex_nrm;
 		Vector<String> tex_dmra;
 		Vector<String> tex_emi;
+		uint32_t quantized = 0u;
+		// Min and max of every position segment, only used when the positions are quantized.
+		Vector<glm::vec3> pos_bounds;
+		// Sorted by base segment, then from the most to the least detailed level.
+		Vector<VioletMeshLOD> lods;
+		// Atlases shared by all impostors. The albedo keeps the coverage in alpha, the
+		// other one the object space normal and the depth relative to the bounding sphere.
+		String impostor_albedo;
+		String impostor_normal_depth;
+		uint32_t impostor_frames = 0u;
+		Vector<VioletMeshImpostor> impostors;
+		// Sorted by index segment, then by index offset.
+		Vector<VioletMeshCluster> clusters;
+		// Empty when the mesh is not skinned.
+		Vector<VioletMeshJoint> joints;
+		Vector<VioletAnimationClip> clips;
 	};
 	struct VioletMesh
 	{
@@ -83,8 +183,22 @@ namespace lambda
 		void AddMesh(VioletMesh mesh);
 		VioletMesh GetMesh(uint64_t hash, bool get_data = false);
 		void RemoveMesh(uint64_t hash);
+		// Readable version of the header, only meant for debugging.
+		String DumpHeader(uint64_t hash);
+
+		// Only quantizes the streams that are still stored as floats.
+		static void Quantize(VioletMesh& mesh, uint32_t streams);
+		// Turns the streams back into floats, for code that reads the vertices on the CPU.
+		static void Dequantize(VioletMesh& mesh);
+		// A single packed element, see kMeshQuantized*.
+		static glm::vec3 DequantizePosition(const uint16_t position[4], const glm::vec3& min, const glm::vec3& max);
+		// The sign of a tangent ends up in w.
+		static glm::vec4 DequantizeDirection(uint32_t direction);
 
 	private:
+		VioletMesh BinaryToMeshHeader(const char* data, size_t size);
+		Vector<char> MeshHeaderToBinary(const VioletMesh& mesh);
+		// Headers generated before the binary format are still JSon.
 		VioletMesh JSonToMeshHeader(Vector<char> json);
 		Vector<char> MeshHeaderToJSon(VioletMesh mesh);
 	};
@@ -1,4 +1,5 @@
 #include "shader_manager.h"
+#include "binary_header.h"
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
@@ -7,6 +8,14 @@
 
 namespace lambda
 {
+	static constexpr uint8_t kShaderHeaderVersion = 1u;
+
+	struct VioletShaderHeaderBlock
+	{
+		uint64_t hash;
+		uint32_t blob_sizes[(size_t)ShaderStages::kCount][VIOLET_LANG_COUNT];
+	};
+
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	VioletShaderManager::VioletShaderManager()
 	{
@@ -24,7 +33,7 @@ namespace lambda
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	void VioletShaderManager::AddShader(VioletShader shader_program)
 	{
-		SaveHeader(ShaderHeaderToJSon(shader_program), shader_program.hash);
+		SaveHeader(ShaderHeaderToBinary(shader_program), shader_program.hash);
 
 		uint32_t size = 0;
 		for (uint32_t l = 0; l < VIOLET_LANG_COUNT; ++l)
@@ -49,7 +58,13 @@ namespace lambda
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	VioletShader VioletShaderManager::GetShader(uint64_t hash, bool get_data)
 	{
-		VioletShader shader = JSonToShaderHeader(GetHeader(hash));
+		Vector<char> storage;
+		size_t size = 0u;
+		const char* header = GetHeader(hash, storage, size);
+
+		VioletShader shader = VioletHeaderReader::IsBinaryHeader(header, size) ?
+			BinaryToShaderHeader(header, size) :
+			JSonToShaderHeader(Vector<char>(header, header + size));
 		if (get_data)
 			getBlobs(shader);
 		return shader;
@@ -80,6 +95,142 @@ namespace lambda
 		}
 	}
 
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	String VioletShaderManager::DumpHeader(uint64_t hash)
+	{
+		VioletShader shader = GetShader(hash, true);
+		Vector<char> json = ShaderHeaderToJSon(shader);
+		return String(json.begin(), json.end());
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	VioletShader VioletShaderManager::BinaryToShaderHeader(const char* data, size_t size)
+	{
+		VioletHeaderReader reader(data, size, kShaderHeaderVersion);
+		VioletShaderHeaderBlock block;
+		VioletShader program;
+		if (!reader.ReadBlock(block))
+		{
+			foundation::Error("[SHA] Invalid header\n");
+			return program;
+		}
+
+		program.hash      = block.hash;
+		program.file_path = reader.ReadString();
+
+		uint32_t offset = 0;
+		for (int lang_int = 0; lang_int < VIOLET_LANG_COUNT; ++lang_int)
+		{
+			for (int stage_int = 0; stage_int < (int)ShaderStages::kCount; ++stage_int)
+			{
+				program.blob_sizes[stage_int][lang_int].first  = offset;
+				program.blob_sizes[stage_int][lang_int].second = block.blob_sizes[stage_int][lang_int];
+				offset += block.blob_sizes[stage_int][lang_int];
+			}
+		}
+
+		for (int stage_int = 0; stage_int < (int)ShaderStages::kCount; ++stage_int)
+		{
+			if (!ReadResources(reader, program.resources[stage_int]))
+			{
+				foundation::Error("[SHA] Invalid header\n");
+				return VioletShader();
+			}
+		}
+
+		return program;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Vector<char> VioletShaderManager::ShaderHeaderToBinary(const VioletShader& shader_program)
+	{
+		VioletShaderHeaderBlock block{};
+		block.hash = shader_program.hash;
+		for (int lang_int = 0; lang_int < VIOLET_LANG_COUNT; ++lang_int)
+			for (int stage_int = 0; stage_int < (int)ShaderStages::kCount; ++stage_int)
+				block.blob_sizes[stage_int][lang_int] = (uint32_t)shader_program.blobs[stage_int][lang_int].size();
+
+		VioletHeaderWriter writer(kShaderHeaderVersion, block);
+		writer.WriteString(shader_program.file_path);
+
+		for (int stage_int = 0; stage_int < (int)ShaderStages::kCount; ++stage_int)
+			WriteResources(writer, shader_program.resources[stage_int]);
+
+		return writer.GetData();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	void VioletShaderManager::WriteResources(VioletHeaderWriter& writer, const Vector<VioletShaderResource>& resources)
+	{
+		writer.Write((uint32_t)resources.size());
+
+		for (const VioletShaderResource& resource : resources)
+		{
+			writer.WriteString(resource.name);
+			writer.Write((uint8_t)resource.type);
+			writer.Write((uint8_t)resource.stage);
+			writer.Write((uint32_t)resource.slot);
+			writer.Write((uint32_t)resource.size);
+			writer.Write((uint32_t)resource.items.size());
+			writer.Write((uint32_t)resource.inputs.size());
+
+			for (const VioletShaderResource::Item& item : resource.items)
+			{
+				writer.WriteString(item.name);
+				writer.Write((uint32_t)item.offset);
+				writer.Write((uint32_t)item.size);
+			}
+
+			for (const VioletShaderResource::Input& input : resource.inputs)
+			{
+				writer.WriteString(input.name);
+				writer.Write((uint32_t)input.reg);
+				writer.Write((uint32_t)input.semantic_index);
+				writer.Write((uint8_t)input.type);
+			}
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	bool VioletShaderManager::ReadResources(VioletHeaderReader& reader, Vector<VioletShaderResource>& resources)
+	{
+		const uint32_t resource_count = reader.Read<uint32_t>();
+		if (!reader.IsValid())
+			return false;
+		resources.resize(resource_count);
+
+		for (VioletShaderResource& resource : resources)
+		{
+			resource.name  = reader.ReadString();
+			resource.type  = (VioletShaderResourceType)reader.Read<uint8_t>();
+			resource.stage = (ShaderStages)reader.Read<uint8_t>();
+			resource.slot  = reader.Read<uint32_t>();
+			resource.size  = reader.Read<uint32_t>();
+			resource.items.resize(reader.Read<uint32_t>());
+			resource.inputs.resize(reader.Read<uint32_t>());
+
+			for (VioletShaderResource::Item& item : resource.items)
+			{
+				item.name   = reader.ReadString();
+				item.offset = reader.Read<uint32_t>();
+				item.size   = reader.Read<uint32_t>();
+			}
+
+			for (VioletShaderResource::Input& input : resource.inputs)
+			{
+				input.name           = reader.ReadString();
+				input.reg            = reader.Read<uint32_t>();
+				input.semantic_index = reader.Read<uint32_t>();
+				input.type           = (VioletShaderComponentType)reader.Read<uint8_t>();
+			}
+
+			if (!reader.IsValid())
+				return false;
+		}
+
+		return true;
+	}
+
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	String shaderStageToString(ShaderStages stage)
 	{
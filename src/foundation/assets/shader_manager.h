@@ -5,12 +5,20 @@
 
 namespace lambda
 {
+	class VioletHeaderWriter;
+	class VioletHeaderReader;
+
 #define VIOLET_HLSL 0
 #define VIOLET_DXIL 1
 #define VIOLET_SPIRV 2
 #define VIOLET_METAL 3
 #define VIOLET_LANG_COUNT 4
 
+// Appended to the program of a permutation that reads the packed vertex
+// streams of quantized meshes. Only shaders that declare their inputs with
+// VertexPosition (see common.fxh) have one.
+#define VIOLET_QUANTIZED_SUFFIX "|QUANTIZED"
+
 	enum class VioletShaderResourceType : uint8_t
 	{
 		kTexture,
@@ -84,8 +92,18 @@ namespace lambda
 		VioletShader GetShader(uint64_t hash, bool get_data = false);
 		void RemoveShader(uint64_t hash);
 		void getBlobs(VioletShader& shader_program);
+		// Readable version of the header, only meant for debugging.
+		String DumpHeader(uint64_t hash);
+
+	protected:
+		// Reflection data of a single stage, shared with the blob cache of the compiler.
+		static void WriteResources(VioletHeaderWriter& writer, const Vector<VioletShaderResource>& resources);
+		static bool ReadResources(VioletHeaderReader& reader, Vector<VioletShaderResource>& resources);
 
 	private:
+		VioletShader BinaryToShaderHeader(const char* data, size_t size);
+		Vector<char> ShaderHeaderToBinary(const VioletShader& shader_program);
+		// Headers generated before the binary format are still JSon.
 		Vector<char> ShaderHeaderToJSon(VioletShader shader_program);
 		VioletShader JSonToShaderHeader(Vector<char> json);
 	};
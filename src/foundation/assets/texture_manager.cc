@@ -1,11 +1,26 @@
 #include "texture_manager.h"
+#include "binary_header.h"
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
 #include <utils/console.h>
+#include <algorithm>
 
 namespace lambda
 {
+  static constexpr uint8_t kTextureHeaderVersion = 1u;
+
+  struct VioletTextureHeaderBlock
+  {
+    uint64_t hash;
+    uint32_t flags;
+    uint16_t width;
+    uint16_t height;
+    uint16_t mip_count;
+    uint8_t  format;
+    uint8_t  padding;
+  };
+
   /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   VioletTextureManager::VioletTextureManager()
   {
@@ -23,14 +38,20 @@ namespace lambda
   /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   void VioletTextureManager::AddTexture(VioletTexture texture)
   {
-    SaveHeader(TextureHeaderToJSon(texture), texture.hash);
+    SaveHeader(TextureHeaderToBinary(texture), texture.hash);
     SaveData(texture.data, texture.hash);
   }
   
   /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   VioletTexture VioletTextureManager::GetTexture(uint64_t hash, bool get_data)
   {
-    VioletTexture texture = JSonToTextureHeader(GetHeader(hash));
+    Vector<char> storage;
+    size_t size = 0u;
+    const char* header = GetHeader(hash, storage, size);
+
+    VioletTexture texture = VioletHeaderReader::IsBinaryHeader(header, size) ?
+      BinaryToTextureHeader(header, size) :
+      JSonToTextureHeader(Vector<char>(header, header + size));
     if (get_data)
       texture.data = GetData(hash);
     return texture;
@@ -43,6 +64,113 @@ namespace lambda
 		RemoveHeader(hash);
   }
 
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  String VioletTextureManager::DumpHeader(uint64_t hash)
+  {
+    Vector<char> json = TextureHeaderToJSon(GetTexture(hash));
+    return String(json.begin(), json.end());
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint64_t VioletTextureManager::GetMipSize(const VioletTexture& texture, uint32_t mip)
+  {
+    uint32_t bpp, bpr, bpl;
+    calculateImageMemory(
+      texture.format,
+      (uint16_t)std::max(1u, (uint32_t)texture.width  >> mip),
+      (uint16_t)std::max(1u, (uint32_t)texture.height >> mip),
+      bpp,
+      bpr,
+      bpl
+    );
+    return bpl;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint64_t VioletTextureManager::GetMipChainSize(const VioletTexture& texture, uint32_t first_mip)
+  {
+    uint64_t size = 0u;
+    for (uint32_t mip = first_mip; mip < texture.mip_count; ++mip)
+      size += GetMipSize(texture, mip);
+    return size;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<char> VioletTextureManager::ToMipTailFirst(const VioletTexture& texture, const Vector<char>& data)
+  {
+    LMB_ASSERT(data.size() >= GetMipChainSize(texture, 0u), "TextureManager: Not enough data for %u mips", (uint32_t)texture.mip_count);
+
+    Vector<char> result(data.size());
+    uint64_t src = 0u;
+    uint64_t dst = GetMipChainSize(texture, 0u);
+    for (uint32_t mip = 0u; mip < texture.mip_count; ++mip)
+    {
+      const uint64_t size = GetMipSize(texture, mip);
+      dst -= size;
+      memcpy(result.data() + dst, data.data() + src, (size_t)size);
+      src += size;
+    }
+    return result;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<char> VioletTextureManager::FromMipTailFirst(const VioletTexture& texture, const Vector<char>& data, uint32_t first_mip)
+  {
+    const uint64_t chain_size = GetMipChainSize(texture, first_mip);
+    LMB_ASSERT(data.size() >= chain_size, "TextureManager: Not enough data for mip %u", first_mip);
+
+    Vector<char> result((size_t)chain_size);
+    uint64_t src = 0u;
+    uint64_t dst = chain_size;
+    for (uint32_t mip = texture.mip_count; mip > first_mip; --mip)
+    {
+      const uint64_t size = GetMipSize(texture, mip - 1u);
+      dst -= size;
+      memcpy(result.data() + dst, data.data() + src, (size_t)size);
+      src += size;
+    }
+    return result;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  VioletTexture VioletTextureManager::BinaryToTextureHeader(const char* data, size_t size)
+  {
+    VioletHeaderReader reader(data, size, kTextureHeaderVersion);
+    VioletTextureHeaderBlock block;
+    if (!reader.ReadBlock(block))
+    {
+      foundation::Error("[TEX] Invalid header\n");
+      return VioletTexture();
+    }
+
+    VioletTexture texture;
+    texture.hash      = block.hash;
+    texture.flags     = block.flags;
+    texture.width     = block.width;
+    texture.height    = block.height;
+    texture.mip_count = block.mip_count;
+    texture.format    = (TextureFormat)block.format;
+    texture.file      = reader.ReadString();
+
+    return texture;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<char> VioletTextureManager::TextureHeaderToBinary(const VioletTexture& texture)
+  {
+    VioletTextureHeaderBlock block{};
+    block.hash      = texture.hash;
+    block.flags     = texture.flags;
+    block.width     = texture.width;
+    block.height    = texture.height;
+    block.mip_count = texture.mip_count;
+    block.format    = (uint8_t)texture.format;
+
+    VioletHeaderWriter writer(kTextureHeaderVersion, block);
+    writer.WriteString(texture.file);
+    return writer.GetData();
+  }
+
   String rapidjsonErrortoString(rapidjson::ParseErrorCode error)
   {
     switch (error)
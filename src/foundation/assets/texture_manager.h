@@ -25,6 +25,8 @@ namespace lambda
   static constexpr uint32_t kTextureFlagFromDDS        = 1u << 6u;
   static constexpr uint32_t kTextureFlagContainsAlpha  = 1u << 7u;
   static constexpr uint32_t kTextureFlagResize         = 1u << 8u;
+  // The data holds the smallest mip first, so the low detail mips can be read on their own.
+  static constexpr uint32_t kTextureFlagMipTailFirst   = 1u << 9u;
 
   class VioletTextureManager : public VioletBaseAssetManager
   {
@@ -36,8 +38,21 @@ namespace lambda
     void AddTexture(VioletTexture texture);
     VioletTexture GetTexture(uint64_t hash, bool get_data = false);
     void RemoveTexture(uint64_t hash);
+    // Readable version of the header, only meant for debugging.
+    String DumpHeader(uint64_t hash);
+
+    // Mip 0 is the full resolution mip.
+    static uint64_t GetMipSize(const VioletTexture& texture, uint32_t mip);
+    // Size of first_mip and all of the smaller mips.
+    static uint64_t GetMipChainSize(const VioletTexture& texture, uint32_t first_mip);
+    static Vector<char> ToMipTailFirst(const VioletTexture& texture, const Vector<char>& data);
+    // Turns a prefix of tail first data, holding first_mip and down, back into the largest mip first order.
+    static Vector<char> FromMipTailFirst(const VioletTexture& texture, const Vector<char>& data, uint32_t first_mip);
 
   private:
+    VioletTexture BinaryToTextureHeader(const char* data, size_t size);
+    Vector<char> TextureHeaderToBinary(const VioletTexture& texture);
+    // Headers generated before the binary format are still JSon.
     VioletTexture JSonToTextureHeader(Vector<char> json);
     Vector<char> TextureHeaderToJSon(VioletTexture texture);
   };
@@ -1,4 +1,5 @@
 #include "wave_manager.h"
+#include "binary_header.h"
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
@@ -6,6 +7,15 @@
 
 namespace lambda
 {
+	static constexpr uint8_t kWaveHeaderVersion = 1u;
+
+	struct VioletWaveHeaderBlock
+	{
+		uint64_t hash;
+		float    length;
+		uint32_t padding;
+	};
+
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	VioletWaveManager::VioletWaveManager()
 	{
@@ -23,14 +33,20 @@ namespace lambda
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	void VioletWaveManager::AddWave(VioletWave wave)
 	{
-		SaveHeader(WaveHeaderToJSon(wave), wave.hash);
+		SaveHeader(WaveHeaderToBinary(wave), wave.hash);
 		SaveData(wave.data, wave.hash);
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	VioletWave VioletWaveManager::GetWave(uint64_t hash, bool get_data)
 	{
-		VioletWave wave = JSonToWaveHeader(GetHeader(hash));
+		Vector<char> storage;
+		size_t size = 0u;
+		const char* header = GetHeader(hash, storage, size);
+
+		VioletWave wave = VioletHeaderReader::IsBinaryHeader(header, size) ?
+			BinaryToWaveHeader(header, size) :
+			JSonToWaveHeader(Vector<char>(header, header + size));
 		if (get_data)
 			wave.data = GetData(hash);
 		return wave;
@@ -43,6 +59,44 @@ namespace lambda
 		RemoveHeader(hash);
 	}
 
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	String VioletWaveManager::DumpHeader(uint64_t hash)
+	{
+		Vector<char> json = WaveHeaderToJSon(GetWave(hash));
+		return String(json.begin(), json.end());
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	VioletWave VioletWaveManager::BinaryToWaveHeader(const char* data, size_t size)
+	{
+		VioletHeaderReader reader(data, size, kWaveHeaderVersion);
+		VioletWaveHeaderBlock block;
+		if (!reader.ReadBlock(block))
+		{
+			foundation::Error("[WAV] Invalid header\n");
+			return VioletWave();
+		}
+
+		VioletWave wave;
+		wave.hash   = block.hash;
+		wave.length = block.length;
+		wave.file   = reader.ReadString();
+
+		return wave;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Vector<char> VioletWaveManager::WaveHeaderToBinary(const VioletWave& wave)
+	{
+		VioletWaveHeaderBlock block{};
+		block.hash   = wave.hash;
+		block.length = wave.length;
+
+		VioletHeaderWriter writer(kWaveHeaderVersion, block);
+		writer.WriteString(wave.file);
+		return writer.GetData();
+	}
+
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	VioletWave VioletWaveManager::JSonToWaveHeader(Vector<char> data)
 	{
@@ -23,8 +23,13 @@ namespace lambda
 		void AddWave(VioletWave wave);
 		VioletWave GetWave(uint64_t hash, bool get_data = false);
 		void RemoveWave(uint64_t hash);
+		// Readable version of the header, only meant for debugging.
+		String DumpHeader(uint64_t hash);
 
 	private:
+		VioletWave BinaryToWaveHeader(const char* data, size_t size);
+		Vector<char> WaveHeaderToBinary(const VioletWave& wave);
+		// Headers generated before the binary format are still JSon.
 		VioletWave JSonToWaveHeader(Vector<char> json);
 		Vector<char> WaveHeaderToJSon(VioletWave wave);
 	};
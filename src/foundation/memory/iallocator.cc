@@ -9,7 +9,8 @@ namespace lambda
     IAllocator::IAllocator(size_t max_size) :
       max_size_(max_size),
       open_allocations_(0),
-      allocated_(0)
+      allocated_(0),
+      total_allocated_(0)
     {
     }
 
@@ -25,6 +26,12 @@ namespace lambda
       return allocated_;
     }
 
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    size_t IAllocator::total_allocated() const
+    {
+      return total_allocated_;
+    }
+
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     IAllocator::~IAllocator()
     {
@@ -48,6 +55,7 @@ namespace lambda
 		void* ptr = AllocateImpl(size, align);
 
 		allocated_ += size;
+		total_allocated_ += size;
 		++open_allocations_;
 
 #if VIOLET_DEBUG_MEMORY
@@ -24,6 +24,8 @@ namespace lambda
       IAllocator(const IAllocator&& other) = delete;
       size_t open_allocations() const;
       virtual size_t allocated() const;
+      // Every byte allocated so far, frees do not count. Tells how much a piece of code allocates.
+      size_t total_allocated() const;
       virtual ~IAllocator();
 
     protected:
@@ -50,6 +52,7 @@ namespace lambda
     protected:
       std::atomic<size_t> open_allocations_;
       std::atomic<size_t> allocated_;
+      std::atomic<size_t> total_allocated_;
     };
   }
 }
\ No newline at end of file
@@ -0,0 +1,306 @@
+#include "pack_archive.h"
+#include <utils/file_system.h>
+#include <utils/console.h>
+
+#ifdef VIOLET_WIN32
+#include <Windows.h>
+#undef min
+#undef max
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace lambda
+{
+  static_assert(sizeof(VioletPackArchive::Entry) == 40u, "Entries are written to and read from disk as is");
+
+  namespace
+  {
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void makeMagicNumber(const String& magic_number, char* out)
+    {
+      LMB_ASSERT(magic_number.size() <= VioletPackArchive::kMagicSize, "PackArchive: Magic number %s is too long", magic_number.c_str());
+      memset(out, 0, VioletPackArchive::kMagicSize);
+      memcpy(out, magic_number.data(), magic_number.size());
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    int compare(const VioletPackArchive::Entry& entry, uint64_t hash, const char* magic_number, VioletPackArchive::Kind kind)
+    {
+      if (entry.hash != hash)
+        return entry.hash < hash ? -1 : 1;
+      int res = memcmp(entry.magic_number, magic_number, VioletPackArchive::kMagicSize);
+      if (res != 0)
+        return res;
+      if (entry.kind != kind)
+        return entry.kind < kind ? -1 : 1;
+      return 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    uint64_t align(uint64_t offset)
+    {
+      return (offset + VioletPackArchive::kAlignment - 1u) & ~(VioletPackArchive::kAlignment - 1u);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletPackArchive::Write(const String& file, Vector<WriteEntry> entries)
+  {
+    Vector<Entry> toc(entries.size());
+    for (uint32_t i = 0u; i < entries.size(); ++i)
+    {
+      Entry& entry = toc[i];
+      entry.hash          = entries[i].hash;
+      makeMagicNumber(entries[i].magic_number, entry.magic_number);
+      entry.kind          = entries[i].kind;
+      entry.flags         = entries[i].flags;
+      entry.original_size = entries[i].original_size;
+      entry.offset        = i; // Index into entries until the offsets are known.
+      entry.size          = entries[i].data.size();
+    }
+
+    eastl::sort(toc.begin(), toc.end(), [](const Entry& lhs, const Entry& rhs) {
+      return compare(lhs, rhs.hash, rhs.magic_number, rhs.kind) < 0;
+    });
+
+    for (uint32_t i = 1u; i < toc.size(); ++i)
+    {
+      if (compare(toc[i - 1u], toc[i].hash, toc[i].magic_number, toc[i].kind) == 0)
+      {
+        foundation::Error("PackArchive: Duplicate entry " + toString(toc[i].hash) + "\n");
+        return false;
+      }
+    }
+
+    // Blobs are written in table order, so a level that loads assets in hash
+    // order walks the file front to back.
+    Vector<uint32_t> order(toc.size());
+    uint64_t offset = align(sizeof(ArchiveHeader) + sizeof(Entry) * toc.size());
+    for (uint32_t i = 0u; i < toc.size(); ++i)
+    {
+      order[i] = (uint32_t)toc[i].offset;
+      toc[i].offset = offset;
+      offset = align(offset + toc[i].size);
+    }
+
+    FILE* fp = FileSystem::fopen(file, "wb");
+    if (!fp)
+      return false;
+
+    ArchiveHeader header;
+    memcpy(header.magic_number, "LPAK", 4u);
+    header.version     = kVersion;
+    header.entry_count = (uint32_t)toc.size();
+    header.padding     = 0u;
+
+    Vector<char> padding(kAlignment, '\0');
+    uint64_t written = 0u;
+    auto write = [&](const void* data, uint64_t size) {
+      fwrite(data, (size_t)size, 1u, fp);
+      written += size;
+    };
+    auto pad = [&](uint64_t to) {
+      if (to > written)
+        write(padding.data(), to - written);
+    };
+
+    write(&header, sizeof(header));
+    if (!toc.empty())
+      write(toc.data(), sizeof(Entry) * toc.size());
+
+    for (uint32_t i = 0u; i < toc.size(); ++i)
+    {
+      pad(toc[i].offset);
+      const Vector<char>& data = entries[order[i]].data;
+      if (!data.empty())
+        write(data.data(), data.size());
+    }
+    pad(align(written));
+
+    FileSystem::fclose(fp);
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  VioletPackArchive::VioletPackArchive()
+    : data_(nullptr)
+    , size_(0u)
+    , entries_(nullptr)
+    , entry_count_(0u)
+    , file_(nullptr)
+    , mapping_(nullptr)
+  {
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  VioletPackArchive::~VioletPackArchive()
+  {
+    Close();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletPackArchive::Open(const String& file)
+  {
+    Close();
+    String path = FileSystem::FullFilePath(file);
+
+#ifdef VIOLET_WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+      return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+    {
+      CloseHandle(handle);
+      return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0u, 0u, NULL);
+    if (mapping == NULL)
+    {
+      CloseHandle(handle);
+      return false;
+    }
+
+    data_    = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0u, 0u, 0u);
+    size_    = (uint64_t)size.QuadPart;
+    file_    = handle;
+    mapping_ = mapping;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+      close(fd);
+      return false;
+    }
+
+    void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file alive.
+    close(fd);
+    if (data == MAP_FAILED)
+      return false;
+
+    data_ = (const char*)data;
+    size_ = (uint64_t)info.st_size;
+#endif
+
+    if (!data_)
+    {
+      Close();
+      return false;
+    }
+
+    ArchiveHeader header;
+    if (size_ < sizeof(header))
+    {
+      foundation::Error("PackArchive: " + file + " is too small.\n");
+      Close();
+      return false;
+    }
+    memcpy(&header, data_, sizeof(header));
+
+    if (memcmp(header.magic_number, "LPAK", 4u) != 0 || header.version != kVersion)
+    {
+      foundation::Error("PackArchive: " + file + " is not a valid archive or has a different version.\n");
+      Close();
+      return false;
+    }
+
+    if (sizeof(ArchiveHeader) + sizeof(Entry) * (uint64_t)header.entry_count > size_)
+    {
+      foundation::Error("PackArchive: " + file + " is truncated.\n");
+      Close();
+      return false;
+    }
+
+    entries_     = (const Entry*)(data_ + sizeof(ArchiveHeader));
+    entry_count_ = header.entry_count;
+
+    for (uint32_t i = 0u; i < entry_count_; ++i)
+    {
+      if (entries_[i].offset + entries_[i].size > size_)
+      {
+        foundation::Error("PackArchive: " + file + " has an entry outside of the file.\n");
+        Close();
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletPackArchive::Close()
+  {
+#ifdef VIOLET_WIN32
+    if (data_)
+      UnmapViewOfFile(data_);
+    if (mapping_)
+      CloseHandle((HANDLE)mapping_);
+    if (file_)
+      CloseHandle((HANDLE)file_);
+#else
+    if (data_)
+      munmap((void*)data_, (size_t)size_);
+#endif
+
+    data_        = nullptr;
+    size_        = 0u;
+    entries_     = nullptr;
+    entry_count_ = 0u;
+    file_        = nullptr;
+    mapping_     = nullptr;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletPackArchive::IsOpen() const
+  {
+    return data_ != nullptr;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  const VioletPackArchive::Entry* VioletPackArchive::Find(uint64_t hash, const String& magic_number, Kind kind) const
+  {
+    if (magic_number.size() > kMagicSize)
+      return nullptr;
+
+    char magic[kMagicSize];
+    makeMagicNumber(magic_number, magic);
+
+    uint32_t first = 0u;
+    uint32_t last  = entry_count_;
+    while (first < last)
+    {
+      const uint32_t middle = first + (last - first) / 2u;
+      const int res = compare(entries_[middle], hash, magic, kind);
+      if (res == 0)
+        return &entries_[middle];
+      if (res < 0)
+        first = middle + 1u;
+      else
+        last = middle;
+    }
+    return nullptr;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  const char* VioletPackArchive::GetView(const Entry& entry) const
+  {
+    return data_ + entry.offset;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint32_t VioletPackArchive::GetEntryCount() const
+  {
+    return entry_count_;
+  }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <containers/containers.h>
+
+namespace lambda
+{
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Single file holding the generated headers and data of all assets. The
+  // table of contents is sorted so lookups are a binary search, and every
+  // blob starts at a 4K boundary. At runtime the file is memory mapped and
+  // blobs are read straight from the mapping.
+  class VioletPackArchive
+  {
+  public:
+    static constexpr uint32_t kVersion    = 1u;
+    static constexpr uint64_t kAlignment  = 4096u;
+    static constexpr uint32_t kMagicSize  = 7u;
+
+    static constexpr uint32_t kEntryFlagCompressed = 1u << 0u;
+
+    enum class Kind : uint8_t
+    {
+      kHeader,
+      kData,
+    };
+
+    struct Entry
+    {
+      uint64_t hash;
+      char     magic_number[kMagicSize]; // Magic number of the asset manager, zero padded.
+      Kind     kind;
+      uint32_t flags;
+      uint32_t original_size;
+      uint64_t offset;
+      uint64_t size;
+    };
+
+    struct WriteEntry
+    {
+      uint64_t     hash;
+      String       magic_number;
+      Kind         kind;
+      uint32_t     flags;
+      uint32_t     original_size;
+      Vector<char> data;
+    };
+
+    static bool Write(const String& file, Vector<WriteEntry> entries);
+
+  public:
+    VioletPackArchive();
+    ~VioletPackArchive();
+    bool Open(const String& file);
+    void Close();
+    bool IsOpen() const;
+
+    const Entry* Find(uint64_t hash, const String& magic_number, Kind kind) const;
+    // Points into the mapped file, valid for as long as the archive is open.
+    const char* GetView(const Entry& entry) const;
+    uint32_t GetEntryCount() const;
+
+  private:
+    struct ArchiveHeader
+    {
+      char     magic_number[4u];
+      uint32_t version;
+      uint32_t entry_count;
+      uint32_t padding;
+    };
+
+    const char*  data_;
+    uint64_t     size_;
+    const Entry* entries_;
+    uint32_t     entry_count_;
+    void*        file_;
+    void*        mapping_;
+  };
+}
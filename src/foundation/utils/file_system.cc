@@ -7,6 +7,9 @@
 
 #if VIOLET_WIN32
 #include <experimental/filesystem>
+#include <Windows.h>
+#undef min
+#undef max
 #endif
 
 namespace lambda
@@ -374,6 +377,25 @@ namespace lambda
       std::experimental::filesystem::path(FullFilePath(file).c_str())
     );
   }
+
+  //////////////////////////////////////////////////////////////////////////////
+  bool FileSystem::MakeDirectory(const String& folder)
+  {
+    std::error_code error;
+    std::experimental::filesystem::create_directories(
+      std::experimental::filesystem::path(FullFilePath(folder).c_str()), error
+    );
+    return !error;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  bool FileSystem::RenameFile(const String& from, const String& to)
+  {
+    // Replaces the target in one step, and only returns once the move is on disk.
+    const std::experimental::filesystem::path from_path(FullFilePath(from).c_str());
+    const std::experimental::filesystem::path to_path(FullFilePath(to).c_str());
+    return MoveFileExW(from_path.c_str(), to_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+  }
 #else
   //////////////////////////////////////////////////////////////////////////////
   uint64_t FileSystem::GetTimeStamp(const String& /*file*/)
@@ -418,5 +440,18 @@ namespace lambda
   void FileSystem::RemoveFile(const String& /*file*/)
   {
   }
+
+  //////////////////////////////////////////////////////////////////////////////
+  bool FileSystem::MakeDirectory(const String& /*folder*/)
+  {
+    return false;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  bool FileSystem::RenameFile(const String& from, const String& to)
+  {
+    // Replaces the target atomically on POSIX.
+    return std::rename(FullFilePath(from).c_str(), FullFilePath(to).c_str()) == 0;
+  }
 #endif
 }
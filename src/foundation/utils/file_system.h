@@ -33,6 +33,10 @@ namespace lambda
     static String GetExtension(const String& file);
     static bool DoesFileExist(const String& file);
     static void RemoveFile(const String& file);
+    // Creates the folder and all of its parents.
+    static bool MakeDirectory(const String& folder);
+    // Replaces to if it exists.
+    static bool RenameFile(const String& from, const String& to);
 
   private:
     static const char* s_base_dir_;
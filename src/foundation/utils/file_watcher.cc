@@ -0,0 +1,479 @@
+#include "file_watcher.h"
+#include "file_system.h"
+#include "console.h"
+#include <memory/memory.h>
+#include <chrono>
+#include <cstring>
+
+#if VIOLET_WIN32
+#include <Windows.h>
+#undef min
+#undef max
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace lambda
+{
+  namespace
+  {
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    uint64_t now()
+    {
+      return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    String join(const String& folder, const String& file)
+    {
+      if (folder.empty())
+        return file;
+      return folder.back() == '/' ? folder + file : folder + "/" + file;
+    }
+
+#if VIOLET_WIN32
+    constexpr DWORD kBufferSize  = 64u * 1024u;
+    constexpr DWORD kNotifyFlags = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+
+    struct NativeWatch
+    {
+      HANDLE     directory;
+      OVERLAPPED overlapped;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    bool issueRead(NativeWatch* watch, Vector<char>& buffer)
+    {
+      memset(&watch->overlapped, 0, sizeof(watch->overlapped));
+      watch->overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+      return ReadDirectoryChangesW(watch->directory, buffer.data(), (DWORD)buffer.size(), TRUE, kNotifyFlags, NULL, &watch->overlapped, NULL) != 0;
+    }
+#elif defined(__linux__)
+    constexpr uint32_t kNotifyFlags = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF;
+#endif
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  FileWatcher::FileWatcher()
+    : watching_(false)
+    , polling_(false)
+    , poll_interval_(1000u)
+    , last_poll_(0u)
+    , handle_(nullptr)
+  {
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  FileWatcher::~FileWatcher()
+  {
+    Stop();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool FileWatcher::Watch(const String& folder, bool force_polling)
+  {
+    Stop();
+    folder_   = FileSystem::FixFilePath(folder);
+    watching_ = true;
+    polling_  = false;
+
+    if (force_polling || !StartNative())
+      StartPolling();
+
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::StartPolling()
+  {
+    // The first poll only records the time stamps.
+    polling_   = true;
+    last_poll_ = now();
+    time_stamps_.clear();
+    for (const String& file : FileSystem::GetAllFilesInFolderRecursive(folder_, ""))
+    {
+      const String relative = FileSystem::MakeRelative(file);
+      time_stamps_[relative] = FileSystem::GetTimeStamp(relative);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::Stop()
+  {
+    if (!watching_)
+      return;
+
+    if (!polling_)
+      StopNative();
+
+    watching_ = false;
+    polling_  = false;
+    changes_.clear();
+    order_.clear();
+    time_stamps_.clear();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool FileWatcher::IsWatching() const
+  {
+    return watching_;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool FileWatcher::IsPolling() const
+  {
+    return polling_;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::SetPollInterval(uint32_t milliseconds)
+  {
+    poll_interval_ = milliseconds;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<FileWatcher::Event> FileWatcher::Poll()
+  {
+    if (!watching_)
+      return Vector<Event>();
+
+    if (polling_)
+      PollTimeStamps();
+    else
+      PollNative();
+
+    Vector<Event> events;
+    events.reserve(order_.size());
+    for (const String& file : order_)
+      events.push_back(Event{ file, changes_[file] });
+    changes_.clear();
+    order_.clear();
+    return events;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::Add(const String& file, Action action)
+  {
+    auto it = changes_.find(file);
+    if (it == changes_.end())
+    {
+      changes_.insert(eastl::make_pair(file, action));
+      order_.push_back(file);
+      return;
+    }
+
+    // Added and then modified is still added, removed and added again is a modification.
+    if (it->second == Action::kAdded && action == Action::kModified)
+      return;
+    if (it->second == Action::kRemoved && action == Action::kAdded)
+      action = Action::kModified;
+    it->second = action;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::PollTimeStamps()
+  {
+    const uint64_t time = now();
+    if (time - last_poll_ < poll_interval_)
+      return;
+    last_poll_ = time;
+
+    UnorderedMap<String, uint64_t> time_stamps;
+    for (const String& file : FileSystem::GetAllFilesInFolderRecursive(folder_, ""))
+    {
+      const String relative = FileSystem::MakeRelative(file);
+      const uint64_t time_stamp = FileSystem::GetTimeStamp(relative);
+      time_stamps.insert(eastl::make_pair(relative, time_stamp));
+
+      auto it = time_stamps_.find(relative);
+      if (it == time_stamps_.end())
+        Add(relative, Action::kAdded);
+      else if (it->second != time_stamp)
+        Add(relative, Action::kModified);
+    }
+
+    for (const auto& it : time_stamps_)
+      if (time_stamps.find(it.first) == time_stamps.end())
+        Add(it.first, Action::kRemoved);
+
+    time_stamps_ = eastl::move(time_stamps);
+  }
+
+#if VIOLET_WIN32
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool FileWatcher::StartNative()
+  {
+    const String path = FileSystem::FullFilePath(folder_);
+    HANDLE directory = CreateFileA(path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (directory == INVALID_HANDLE_VALUE)
+      return false;
+
+    NativeWatch* watch = foundation::Memory::construct<NativeWatch>();
+    watch->directory = directory;
+    buffer_.resize(kBufferSize);
+    if (!issueRead(watch, buffer_))
+    {
+      CloseHandle(watch->overlapped.hEvent);
+      CloseHandle(directory);
+      foundation::Memory::destruct(watch);
+      return false;
+    }
+
+    handle_ = watch;
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::StopNative()
+  {
+    NativeWatch* watch = (NativeWatch*)handle_;
+    if (!watch)
+      return;
+
+    CancelIo(watch->directory);
+    DWORD bytes = 0u;
+    GetOverlappedResult(watch->directory, &watch->overlapped, &bytes, TRUE);
+    CloseHandle(watch->overlapped.hEvent);
+    CloseHandle(watch->directory);
+    foundation::Memory::destruct(watch);
+    handle_ = nullptr;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::PollNative()
+  {
+    NativeWatch* watch = (NativeWatch*)handle_;
+    DWORD bytes = 0u;
+    while (GetOverlappedResult(watch->directory, &watch->overlapped, &bytes, FALSE))
+    {
+      CloseHandle(watch->overlapped.hEvent);
+
+      // Too many changes for the buffer, everything could have changed.
+      if (bytes == 0u)
+      {
+        foundation::Error("FileWatcher: Lost events for " + folder_ + ", reporting all files\n");
+        AddFolder(folder_, Action::kModified);
+      }
+
+      for (size_t offset = 0u; bytes > 0u;)
+      {
+        const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)(buffer_.data() + offset);
+        const int wide_size = (int)(info->FileNameLength / sizeof(WCHAR));
+        const int size = WideCharToMultiByte(CP_UTF8, 0, info->FileName, wide_size, NULL, 0, NULL, NULL);
+        String name((size_t)size, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, info->FileName, wide_size, (char*)name.data(), size, NULL, NULL);
+        const String file = join(folder_, FileSystem::FixFilePath(name));
+
+        switch (info->Action)
+        {
+        case FILE_ACTION_ADDED:
+        case FILE_ACTION_RENAMED_NEW_NAME:
+          Add(file, Action::kAdded);
+          break;
+        case FILE_ACTION_REMOVED:
+        case FILE_ACTION_RENAMED_OLD_NAME:
+          Add(file, Action::kRemoved);
+          break;
+        default:
+          Add(file, Action::kModified);
+          break;
+        }
+
+        if (info->NextEntryOffset == 0u)
+          break;
+        offset += info->NextEntryOffset;
+      }
+
+      if (!issueRead(watch, buffer_))
+      {
+        foundation::Error("FileWatcher: Could not keep watching " + folder_ + ", falling back to polling\n");
+        CloseHandle(watch->overlapped.hEvent);
+        CloseHandle(watch->directory);
+        foundation::Memory::destruct(watch);
+        handle_ = nullptr;
+        StartPolling();
+        return;
+      }
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::AddFolder(const String& folder, Action action)
+  {
+    for (const String& file : FileSystem::GetAllFilesInFolderRecursive(folder, ""))
+      Add(FileSystem::MakeRelative(file), action);
+  }
+#elif defined(__linux__)
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool FileWatcher::StartNative()
+  {
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+      return false;
+
+    handle_ = (void*)(intptr_t)(fd + 1);
+    buffer_.resize(64u * 1024u);
+
+    // Every folder needs its own watch. Only happens once, new folders are added as they show up.
+    Vector<String> folders = { folder_ };
+    while (!folders.empty())
+    {
+      const String folder = folders.back();
+      folders.pop_back();
+
+      const String path = FileSystem::FullFilePath(folder);
+      const int wd = inotify_add_watch(fd, path.c_str(), kNotifyFlags);
+      if (wd < 0)
+      {
+        if (folder == folder_)
+        {
+          StopNative();
+          return false;
+        }
+        continue;
+      }
+      folders_[wd] = folder;
+
+      if (DIR* dir = opendir(path.c_str()))
+      {
+        while (dirent* entry = readdir(dir))
+          if (entry->d_type == DT_DIR && strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+            folders.push_back(join(folder, entry->d_name));
+        closedir(dir);
+      }
+    }
+
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::StopNative()
+  {
+    if (handle_)
+      close((int)(intptr_t)handle_ - 1);
+    handle_ = nullptr;
+    folders_.clear();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::PollNative()
+  {
+    const int fd = (int)(intptr_t)handle_ - 1;
+    while (true)
+    {
+      const ssize_t bytes = read(fd, buffer_.data(), buffer_.size());
+      if (bytes <= 0)
+        break;
+
+      for (ssize_t offset = 0; offset < bytes;)
+      {
+        const inotify_event* event = (const inotify_event*)(buffer_.data() + offset);
+        offset += sizeof(inotify_event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW)
+        {
+          foundation::Error("FileWatcher: Lost events for " + folder_ + ", reporting all files\n");
+          AddFolder(folder_, Action::kModified);
+          continue;
+        }
+
+        auto it = folders_.find(event->wd);
+        if (it == folders_.end())
+          continue;
+
+        if (event->mask & (IN_DELETE_SELF | IN_IGNORED))
+        {
+          folders_.erase(it);
+          continue;
+        }
+
+        const String file = join(it->second, event->name);
+        if (event->mask & IN_ISDIR)
+        {
+          // Files can land in a new folder before it is watched, so report what is in it.
+          if (event->mask & (IN_CREATE | IN_MOVED_TO))
+          {
+            const int wd = inotify_add_watch(fd, FileSystem::FullFilePath(file).c_str(), kNotifyFlags);
+            if (wd >= 0)
+              folders_[wd] = file;
+            AddFolder(file, Action::kAdded);
+          }
+          continue;
+        }
+
+        if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+          Add(file, Action::kRemoved);
+        else if (event->mask & (IN_CREATE | IN_MOVED_TO))
+          Add(file, Action::kAdded);
+        else if (event->mask & IN_CLOSE_WRITE)
+          Add(file, Action::kModified);
+      }
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::AddFolder(const String& folder, Action action)
+  {
+    const int fd = (int)(intptr_t)handle_ - 1;
+    Vector<String> folders = { folder };
+    while (!folders.empty())
+    {
+      const String current = folders.back();
+      folders.pop_back();
+
+      DIR* dir = opendir(FileSystem::FullFilePath(current).c_str());
+      if (!dir)
+        continue;
+
+      while (dirent* entry = readdir(dir))
+      {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+          continue;
+
+        const String file = join(current, entry->d_name);
+        if (entry->d_type == DT_DIR)
+        {
+          // Sub folders of a new folder are not watched yet either.
+          if (action == Action::kAdded)
+          {
+            const int wd = inotify_add_watch(fd, FileSystem::FullFilePath(file).c_str(), kNotifyFlags);
+            if (wd >= 0)
+              folders_[wd] = file;
+          }
+          folders.push_back(file);
+        }
+        else
+          Add(file, action);
+      }
+      closedir(dir);
+    }
+  }
+#else
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool FileWatcher::StartNative()
+  {
+    return false;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::StopNative()
+  {
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::PollNative()
+  {
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void FileWatcher::AddFolder(const String& folder, Action action)
+  {
+    for (const String& file : FileSystem::GetAllFilesInFolderRecursive(folder, ""))
+      Add(FileSystem::MakeRelative(file), action);
+  }
+#endif
+}
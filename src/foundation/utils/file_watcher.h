@@ -0,0 +1,64 @@
+#pragma once
+#include <containers/containers.h>
+
+namespace lambda
+{
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Reports files that changed in a folder and all of its sub folders. Uses
+  // ReadDirectoryChangesW on Windows and inotify on Linux, so nothing gets
+  // scanned. When neither is available it falls back to comparing time stamps
+  // of all files once per poll interval.
+  class FileWatcher
+  {
+  public:
+    enum class Action : uint8_t
+    {
+      kAdded,
+      kModified,
+      kRemoved,
+    };
+
+    struct Event
+    {
+      String file; // Relative to the base dir, like the rest of the file system.
+      Action action;
+    };
+
+    FileWatcher();
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    void operator=(const FileWatcher&) = delete;
+
+    bool Watch(const String& folder, bool force_polling = false);
+    void Stop();
+    bool IsWatching() const;
+    bool IsPolling() const;
+    void SetPollInterval(uint32_t milliseconds);
+
+    // Never blocks. Every file shows up once, with the last thing that happened to it.
+    Vector<Event> Poll();
+
+  private:
+    void Add(const String& file, Action action);
+    void AddFolder(const String& folder, Action action);
+    void PollNative();
+    void PollTimeStamps();
+    void StartPolling();
+    bool StartNative();
+    void StopNative();
+
+  private:
+    String folder_;
+    bool watching_;
+    bool polling_;
+    uint32_t poll_interval_;
+    uint64_t last_poll_;
+    UnorderedMap<String, Action> changes_;
+    Vector<String> order_;
+    UnorderedMap<String, uint64_t> time_stamps_;
+    // Platform specific state.
+    void* handle_;
+    Vector<char> buffer_;
+    UnorderedMap<int, String> folders_;
+  };
+}
@@ -0,0 +1,68 @@
+#include "archive_builder.h"
+#include <assets/base_asset_manager.h>
+#include <utils/file_system.h>
+#include <utils/console.h>
+#include <algorithm>
+#include <string>
+
+namespace lambda
+{
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletArchiveBuilder::Build(const ArchiveBuildInfo& build_info)
+  {
+    Vector<VioletPackArchive::WriteEntry> entries;
+    uint64_t loose_size = 0u;
+
+    for (String file : FileSystem::GetAllFilesInFolder(build_info.generated_folder))
+    {
+      file = FileSystem::MakeRelative(file);
+
+      // Generated files are named <magic>_<header|data>_<hash>.
+      String name = file.substr(file.find_last_of('/') + 1u);
+      const eastl_size_t first = name.find('_');
+      const eastl_size_t last  = name.find_last_of('_');
+      if (first == String::npos || first == last)
+        continue;
+
+      const String magic_number = name.substr(0u, first);
+      const String kind         = name.substr(first + 1u, last - first - 1u);
+      if (eastl::find(build_info.magic_numbers.begin(), build_info.magic_numbers.end(), magic_number) == build_info.magic_numbers.end())
+        continue;
+      if (kind != "header" && kind != "data")
+        continue;
+
+      VioletPackArchive::WriteEntry entry;
+      entry.hash         = std::stoull(name.substr(last + 1u).c_str());
+      entry.magic_number = magic_number;
+      entry.kind         = kind == "header" ? VioletPackArchive::Kind::kHeader : VioletPackArchive::Kind::kData;
+      entry.flags        = 0u;
+      entry.data         = FileSystem::FileToVector(file, magic_number.data(), magic_number.size());
+      loose_size += entry.data.size();
+
+      if (entry.kind == VioletPackArchive::Kind::kData && entry.data.size() >= sizeof(uint32_t))
+      {
+        entry.original_size = (uint32_t)VioletBaseAssetManager::GetDecompressedSize(entry.data.data(), entry.data.size());
+
+        const float compression = 1.0f - (float)entry.data.size() / (float)std::max(1u, entry.original_size);
+        if (compression >= build_info.min_compression)
+          entry.flags |= VioletPackArchive::kEntryFlagCompressed;
+        else
+          entry.data = VioletBaseAssetManager::DecompressData(entry.data);
+      }
+      else
+        entry.original_size = (uint32_t)entry.data.size();
+
+      entries.push_back(eastl::move(entry));
+    }
+
+    const uint32_t entry_count = (uint32_t)entries.size();
+    if (!VioletPackArchive::Write(build_info.output_file, eastl::move(entries)))
+    {
+      foundation::Error("[PAK] Could not write " + build_info.output_file + "\n");
+      return false;
+    }
+
+    foundation::Info("[PAK] " + build_info.output_file + ": " + toString(entry_count) + " entries, " + toString(loose_size / 1024u) + "KB of loose files\n");
+    return true;
+  }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <package/pack_archive.h>
+
+namespace lambda
+{
+  struct ArchiveBuildInfo
+  {
+    String         generated_folder = "generated/";
+    String         output_file      = "generated/assets.pack";
+    Vector<String> magic_numbers    = { "tex", "msh", "wav", "shader", "pass" };
+    // Data that LZ4 shrinks less than this is stored uncompressed, so it can be used without decompressing.
+    float          min_compression  = 0.1f;
+  };
+
+  class VioletArchiveBuilder
+  {
+  public:
+    bool Build(const ArchiveBuildInfo& build_info);
+  };
+}
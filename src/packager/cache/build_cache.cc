@@ -0,0 +1,350 @@
+#include "build_cache.h"
+#include <assets/binary_header.h>
+#include <utils/file_system.h>
+#include <utils/console.h>
+
+namespace lambda
+{
+  namespace
+  {
+    struct IndexBlock
+    {
+      uint32_t entry_count;
+      uint32_t padding;
+      uint64_t use_count;
+    };
+
+    struct EntryBlock
+    {
+      uint64_t key;
+      uint32_t file_count;
+      uint32_t padding;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    String toMegaBytes(uint64_t size)
+    {
+      return toString(size / (1024u * 1024u)) + "MB";
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletBuildCache::Initialize(const BuildCacheSettings& settings)
+  {
+    settings_ = settings;
+    if (!settings_.folder.empty() && settings_.folder.back() != '/')
+      settings_.folder += "/";
+
+    FileSystem::MakeDirectory(settings_.folder);
+    enabled_ = FileSystem::DoesFileExist(settings_.folder);
+    if (!enabled_)
+    {
+      foundation::Error("BuildCache: Could not create " + settings_.folder + ", everything will be compiled\n");
+      return false;
+    }
+
+    LoadIndex();
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletBuildCache::IsEnabled() const
+  {
+    return enabled_;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint64_t VioletBuildCache::GetKey(const Vector<String>& inputs, const String& settings) const
+  {
+    uint64_t key = HashData((const char*)&kVersion, sizeof(kVersion));
+    key = HashData(settings.data(), settings.size(), key);
+
+    for (const String& input : inputs)
+    {
+      // The path is part of the key, the names of the generated files are derived from it.
+      key = HashData(input.data(), input.size() + 1u, key);
+      if (FileSystem::DoesFileExist(input))
+      {
+        const Vector<char> data = FileSystem::FileToVector(input);
+        key = HashData(data.data(), data.size(), key);
+      }
+    }
+
+    return key;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletBuildCache::Restore(uint64_t key)
+  {
+    // Everything is validated before anything is written, a bad entry never leaves half an asset behind.
+    Vector<Pair<String, Vector<char>>> files;
+    if (!ReadEntry(key, files))
+      return false;
+
+    // Every file is swapped in whole, so a crash or a reader never sees half of one.
+    for (const auto& file : files)
+    {
+      const String temp = file.first + ".tmp";
+      FileSystem::WriteFile(temp, file.second);
+      if (!FileSystem::RenameFile(temp, file.first))
+      {
+        FileSystem::RemoveFile(temp);
+        foundation::Error("BuildCache: Could not replace " + file.first + "\n");
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildCache::Store(uint64_t key, const Vector<String>& files)
+  {
+    if (!enabled_ || files.empty())
+      return;
+
+    Vector<Pair<String, Vector<char>>> entry_files;
+    for (const String& file : files)
+      entry_files.push_back(eastl::make_pair(file, FileSystem::FileToVector(file)));
+    WriteEntry(key, entry_files);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletBuildCache::RestoreBlob(uint64_t key, Vector<char>& data)
+  {
+    // Blobs are stored as a single file without a name.
+    Vector<Pair<String, Vector<char>>> files;
+    if (!ReadEntry(key, files) || files.size() != 1u || !files[0].first.empty())
+      return false;
+
+    data = eastl::move(files[0].second);
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildCache::StoreBlob(uint64_t key, const Vector<char>& data)
+  {
+    if (!enabled_)
+      return;
+
+    WriteEntry(key, { eastl::make_pair(String(), data) });
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildCache::Flush()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_ || !dirty_)
+      return;
+
+    IndexBlock block;
+    block.entry_count = (uint32_t)entries_.size();
+    block.padding     = 0u;
+    block.use_count   = use_count_;
+
+    VioletHeaderWriter writer(kVersion, block);
+    for (const auto& it : entries_)
+      writer.Write(it.second);
+
+    FileSystem::WriteFile(settings_.folder + "index", writer.GetData());
+    dirty_ = false;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  VioletBuildCache::Stats VioletBuildCache::GetStats() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildCache::LogStats() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_)
+      return;
+
+    const uint32_t lookups = stats_.hits + stats_.misses;
+    foundation::Info(
+      "BuildCache: " + toString(stats_.hits) + "/" + toString(lookups) + " hits (" +
+      toString(lookups > 0u ? stats_.hits * 100u / lookups : 0u) + "%), restored " + toMegaBytes(stats_.restored_size) +
+      ", stored " + toString(stats_.stores) + " (" + toMegaBytes(stats_.stored_size) +
+      "), evicted " + toString(stats_.evictions) + " (" + toMegaBytes(stats_.evicted_size) +
+      "), " + toMegaBytes(total_size_) + " of " + toMegaBytes(settings_.max_size) + " in use\n"
+    );
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint64_t VioletBuildCache::HashData(const char* data, size_t size, uint64_t seed)
+  {
+    // 64 bit FNV-1a.
+    uint64_t hash = seed;
+    for (size_t i = 0u; i < size; ++i)
+    {
+      hash ^= (uint8_t)data[i];
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  String VioletBuildCache::GetEntryFile(uint64_t key) const
+  {
+    return settings_.folder + toString(key);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletBuildCache::ReadEntry(uint64_t key, Vector<Pair<String, Vector<char>>>& files)
+  {
+    if (!enabled_)
+      return false;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (entries_.find(key) == entries_.end() || !FileSystem::DoesFileExist(GetEntryFile(key)))
+      {
+        stats_.misses++;
+        return false;
+      }
+    }
+
+    const Vector<char> data = FileSystem::FileToVector(GetEntryFile(key));
+    VioletHeaderReader reader(data.data(), data.size(), kVersion);
+    EntryBlock block{};
+    files.clear();
+    if (reader.ReadBlock(block) && block.key == key)
+    {
+      for (uint32_t i = 0u; i < block.file_count && reader.IsValid(); ++i)
+      {
+        Pair<String, Vector<char>> file;
+        file.first = reader.ReadString();
+        const uint64_t size = reader.Read<uint64_t>();
+        if (!reader.IsValid() || size > data.size())
+          break;
+        file.second.resize((size_t)size);
+        reader.Read(file.second.data(), file.second.size());
+        files.push_back(eastl::move(file));
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (!reader.IsValid() || files.size() != block.file_count)
+    {
+      foundation::Error("BuildCache: Entry " + toString(key) + " is corrupt, it will be rebuilt\n");
+      if (it != entries_.end())
+      {
+        total_size_ -= it->second.size;
+        entries_.erase(it);
+      }
+      FileSystem::RemoveFile(GetEntryFile(key));
+      files.clear();
+      dirty_ = true;
+      stats_.misses++;
+      return false;
+    }
+
+    for (const auto& file : files)
+      stats_.restored_size += file.second.size();
+    if (it != entries_.end())
+      it->second.last_used = ++use_count_;
+    dirty_ = true;
+    stats_.hits++;
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildCache::WriteEntry(uint64_t key, const Vector<Pair<String, Vector<char>>>& files)
+  {
+    EntryBlock block{};
+    block.key        = key;
+    block.file_count = (uint32_t)files.size();
+    block.padding    = 0u;
+
+    VioletHeaderWriter writer(kVersion, block);
+    for (const auto& file : files)
+    {
+      writer.WriteString(file.first);
+      writer.Write((uint64_t)file.second.size());
+      writer.Write(file.second.data(), file.second.size());
+    }
+
+    const Vector<char> data = writer.GetData();
+    FileSystem::WriteFile(GetEntryFile(key), data);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end())
+      total_size_ -= it->second.size;
+
+    Entry& entry = entries_[key];
+    entry.key       = key;
+    entry.size      = data.size();
+    entry.last_used = ++use_count_;
+    total_size_ += entry.size;
+    dirty_ = true;
+
+    stats_.stores++;
+    stats_.stored_size += data.size();
+
+    Evict();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildCache::Evict()
+  {
+    // Expects the mutex to be locked.
+    if (total_size_ <= settings_.max_size)
+      return;
+
+    Vector<Entry> entries;
+    entries.reserve(entries_.size());
+    for (const auto& it : entries_)
+      entries.push_back(it.second);
+    eastl::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.last_used < rhs.last_used; });
+
+    // The entry that was just stored is the most recent one, it is only evicted if it is larger than the cache.
+    for (const Entry& entry : entries)
+    {
+      if (total_size_ <= settings_.max_size)
+        break;
+
+      FileSystem::RemoveFile(GetEntryFile(entry.key));
+      entries_.erase(entry.key);
+      total_size_ -= entry.size;
+      stats_.evictions++;
+      stats_.evicted_size += entry.size;
+    }
+    dirty_ = true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildCache::LoadIndex()
+  {
+    entries_.clear();
+    total_size_ = 0u;
+    use_count_  = 0u;
+
+    const String file = settings_.folder + "index";
+    if (!FileSystem::DoesFileExist(file))
+      return;
+
+    const Vector<char> data = FileSystem::FileToVector(file);
+    VioletHeaderReader reader(data.data(), data.size(), kVersion);
+    IndexBlock block;
+    if (!reader.ReadBlock(block))
+    {
+      foundation::Error("BuildCache: " + file + " is not valid, starting with an empty cache\n");
+      return;
+    }
+
+    for (uint32_t i = 0u; i < block.entry_count && reader.IsValid(); ++i)
+    {
+      const Entry entry = reader.Read<Entry>();
+      if (!reader.IsValid())
+        break;
+      entries_[entry.key] = entry;
+      total_size_ += entry.size;
+    }
+    use_count_ = block.use_count;
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <containers/containers.h>
+#include <mutex>
+
+namespace lambda
+{
+  struct BuildCacheSettings
+  {
+    String   folder   = "generated/cache/";
+    // Least recently used entries are evicted once the cache grows past this.
+    uint64_t max_size = 4ull * 1024ull * 1024ull * 1024ull;
+  };
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Content addressed store of compiled assets. The key of an asset hashes
+  // everything its generated files depend on: the paths and bytes of the
+  // inputs, the compile settings and the compiler version. Time stamps are
+  // not part of it, so touched files, fresh clones and branch switches are
+  // restored from the cache instead of compiled again. The folder can be
+  // shared between checkouts. Restore and Store can be called from several
+  // threads at once.
+  class VioletBuildCache
+  {
+  public:
+    static constexpr uint8_t  kVersion  = 1u;
+    static constexpr uint64_t kHashSeed = 14695981039346656037ull;
+
+    struct Stats
+    {
+      uint32_t hits          = 0u;
+      uint32_t misses        = 0u;
+      uint32_t stores        = 0u;
+      uint32_t evictions     = 0u;
+      uint64_t restored_size = 0u;
+      uint64_t stored_size   = 0u;
+      uint64_t evicted_size  = 0u;
+    };
+
+    bool Initialize(const BuildCacheSettings& settings);
+    bool IsEnabled() const;
+
+    // The first input is the source file, the rest are the files it pulls in.
+    uint64_t GetKey(const Vector<String>& inputs, const String& settings) const;
+    // Writes the generated files of the key back to where they were stored from.
+    bool Restore(uint64_t key);
+    void Store(uint64_t key, const Vector<String>& files);
+    // Entries that hold data instead of files, for results that are smaller
+    // than an asset, like a single compiled shader stage.
+    bool RestoreBlob(uint64_t key, Vector<char>& data);
+    void StoreBlob(uint64_t key, const Vector<char>& data);
+    // Writes the index, call it once a batch of files has been built.
+    void Flush();
+
+    Stats GetStats() const;
+    void LogStats() const;
+
+    static uint64_t HashData(const char* data, size_t size, uint64_t seed = kHashSeed);
+
+  private:
+    struct Entry
+    {
+      uint64_t key;
+      uint64_t size;
+      uint64_t last_used;
+    };
+
+    String GetEntryFile(uint64_t key) const;
+    bool ReadEntry(uint64_t key, Vector<Pair<String, Vector<char>>>& files);
+    void WriteEntry(uint64_t key, const Vector<Pair<String, Vector<char>>>& files);
+    void Evict();
+    void LoadIndex();
+
+  private:
+    BuildCacheSettings settings_;
+    bool enabled_ = false;
+    bool dirty_ = false;
+    uint64_t use_count_ = 0u;
+    uint64_t total_size_ = 0u;
+    UnorderedMap<uint64_t, Entry> entries_;
+    Stats stats_;
+    mutable std::mutex mutex_;
+  };
+}
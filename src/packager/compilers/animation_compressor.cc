@@ -0,0 +1,199 @@
+#include "animation_compressor.h"
+#include <assets/animation.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+
+namespace lambda
+{
+	namespace
+	{
+		// Tracks that move less than this keep a single key.
+		static constexpr float kConstantVector   = 1e-5f;
+		static constexpr float kConstantRotation = 1e-6f; // Of 1 - |dot|.
+
+		typedef VioletAnimationCompressor::Curve Curve;
+
+		// Value of the curve at time, the first and the last key hold outside of it.
+		glm::vec4 evaluate(const Curve& curve, float time)
+		{
+			const bool cubic    = curve.interpolation == Curve::Interpolation::kCubicSpline;
+			const bool rotation = curve.path == Curve::Path::kRotation;
+			const auto value = [&](size_t key) { return curve.values[cubic ? key * 3u + 1u : key]; };
+
+			const size_t count = curve.times.size();
+			if (time <= curve.times.front())
+				return value(0u);
+			if (time >= curve.times.back())
+				return value(count - 1u);
+
+			const size_t key = (size_t)(std::upper_bound(curve.times.begin(), curve.times.end(), time) - curve.times.begin()) - 1u;
+			const float  dt  = curve.times[key + 1u] - curve.times[key];
+			const float  t   = dt > 0.0f ? (time - curve.times[key]) / dt : 0.0f;
+
+			switch (curve.interpolation)
+			{
+			case Curve::Interpolation::kStep:
+				return value(key);
+			case Curve::Interpolation::kCubicSpline:
+			{
+				// Hermite, the tangents are scaled by the length of the interval.
+				const float t2 = t * t, t3 = t2 * t;
+				const glm::vec4 result =
+					(2.0f * t3 - 3.0f * t2 + 1.0f) * value(key) + (t3 - 2.0f * t2 + t) * dt * curve.values[key * 3u + 2u] +
+					(-2.0f * t3 + 3.0f * t2) * value(key + 1u) + (t3 - t2) * dt * curve.values[(key + 1u) * 3u];
+				return rotation ? glm::normalize(result) : result;
+			}
+			default:
+			{
+				if (!rotation)
+					return glm::mix(value(key), value(key + 1u), t);
+				const glm::vec4 a = value(key), b = value(key + 1u);
+				const glm::quat q = glm::slerp(glm::quat(a.w, a.x, a.y, a.z), glm::quat(b.w, b.x, b.y, b.z), t);
+				return glm::vec4(q.x, q.y, q.z, q.w);
+			}
+			}
+		}
+
+		glm::vec4 restValue(const VioletMeshJoint& joint, uint32_t path)
+		{
+			switch (path)
+			{
+			case 0u:  return glm::vec4(joint.translation, 0.0f);
+			case 1u:  return glm::vec4(joint.rotation.x, joint.rotation.y, joint.rotation.z, joint.rotation.w);
+			default:  return glm::vec4(joint.scale, 0.0f);
+			}
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	VioletAnimationClip VioletAnimationCompressor::Compress(const String& name, const Vector<VioletMeshJoint>& joints, const Vector<Curve>& curves, float frame_rate, Stats& stats)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		VioletAnimationClip clip;
+		clip.name       = name;
+		clip.frame_rate = frame_rate;
+		for (const Curve& curve : curves)
+			if (!curve.times.empty())
+				clip.duration = std::max(clip.duration, curve.times.back());
+		clip.frame_count = clip.duration > 0.0f ? (uint32_t)std::ceil(clip.duration * frame_rate - 1e-3f) + 1u : 1u;
+
+		// The curve of every track, the last one wins when a file has several.
+		Vector<const Curve*> sources(joints.size() * VioletAnimation::kTracksPerJoint, nullptr);
+		for (const Curve& curve : curves)
+		{
+			if (curve.joint < (uint32_t)joints.size())
+				sources[curve.joint * VioletAnimation::kTracksPerJoint + (uint32_t)curve.path] = &curve;
+			stats.bytes_before += (curve.times.size() + curve.values.size() * (curve.path == Curve::Path::kRotation ? 4u : 3u)) * sizeof(float);
+		}
+
+		Vector<glm::vec4> samples(clip.frame_count);
+		clip.tracks.resize(sources.size());
+		for (uint32_t index = 0u; index < (uint32_t)sources.size(); ++index)
+		{
+			const uint32_t path     = index % VioletAnimation::kTracksPerJoint;
+			const bool     rotation = path == 1u;
+			const Curve*   source   = sources[index];
+			const glm::vec4 rest = restValue(joints[index / VioletAnimation::kTracksPerJoint], path);
+			for (uint32_t frame = 0u; frame < clip.frame_count; ++frame)
+				samples[frame] = source ? evaluate(*source, std::min((float)frame / frame_rate, clip.duration)) : rest;
+
+			bool constant = true;
+			for (uint32_t frame = 1u; frame < clip.frame_count && constant; ++frame)
+			{
+				if (rotation)
+					constant = 1.0f - std::abs(glm::dot(glm::normalize(samples[frame]), glm::normalize(samples[0]))) <= kConstantRotation;
+				else
+				{
+					const glm::vec3 difference = glm::abs(glm::vec3(samples[frame] - samples[0]));
+					constant = std::max(difference.x, std::max(difference.y, difference.z)) <= kConstantVector;
+				}
+			}
+
+			VioletAnimationTrack& track = clip.tracks[index];
+			track.offset = (uint32_t)(clip.keys.size() / 3u);
+			track.count  = constant ? 1u : clip.frame_count;
+			if (!rotation)
+			{
+				glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+				for (uint32_t frame = 0u; frame < track.count; ++frame)
+				{
+					min = glm::min(min, glm::vec3(samples[frame]));
+					max = glm::max(max, glm::vec3(samples[frame]));
+				}
+				track.min    = min;
+				track.extent = max - min;
+			}
+
+			clip.keys.resize(clip.keys.size() + track.count * 3u);
+			for (uint32_t frame = 0u; frame < track.count; ++frame)
+			{
+				uint16_t* key = clip.keys.data() + (size_t)(track.offset + frame) * 3u;
+				if (rotation)
+				{
+					VioletAnimation::EncodeRotation(samples[frame], key);
+					const float dot = std::abs(glm::dot(VioletAnimation::DecodeRotation(key), glm::normalize(samples[frame])));
+					stats.rotation_error = std::max(stats.rotation_error, glm::degrees(2.0f * std::acos(std::min(dot, 1.0f))));
+				}
+				else
+				{
+					VioletAnimation::EncodeVector(glm::vec3(samples[frame]), track, key);
+					if (path == 0u)
+						stats.translation_error = std::max(stats.translation_error, glm::length(VioletAnimation::DecodeVector(key, track) - glm::vec3(samples[frame])));
+				}
+			}
+
+			stats.tracks++;
+			if (constant)
+				stats.constant_tracks++;
+		}
+
+		stats.bytes_after += clip.keys.size() * sizeof(uint16_t) + clip.tracks.size() * sizeof(VioletAnimationTrack);
+		stats.clips++;
+		stats.time += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return clip;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	VioletAnimationCompressor::Benchmark VioletAnimationCompressor::Measure(const VioletMeshData& data, uint32_t characters, uint32_t frames)
+	{
+		Benchmark benchmark;
+		if (data.joints.empty() || data.clips.empty() || characters == 0u || frames == 0u)
+			return benchmark;
+
+		// Every character has its own poses and palette, like it does at runtime.
+		const uint32_t joint_count = (uint32_t)data.joints.size();
+		const uint32_t clip_count  = (uint32_t)data.clips.size();
+		Vector<VioletAnimation::Transform> poses((size_t)characters * joint_count * 2u);
+		Vector<glm::mat4> model(joint_count);
+		Vector<glm::mat4> palettes((size_t)characters * joint_count);
+		for (uint32_t character = 0u; character < characters * 2u; ++character)
+			VioletAnimation::RestPose(data.joints, poses.data() + (size_t)character * joint_count);
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0u; frame < frames; ++frame)
+		{
+			for (uint32_t character = 0u; character < characters; ++character)
+			{
+				VioletAnimation::Transform* from = poses.data() + (size_t)character * joint_count * 2u;
+				VioletAnimation::Transform* to   = from + joint_count;
+				// So the characters are not in step.
+				const float time = (float)frame / 60.0f + (float)character * 0.37f;
+				VioletAnimation::Sample(data.clips[character % clip_count], time, true, joint_count, from);
+				VioletAnimation::Sample(data.clips[(character + 1u) % clip_count], time, true, joint_count, to);
+				VioletAnimation::Blend(from, to, 0.5f, joint_count, from);
+				VioletAnimation::LocalToModel(data.joints, from, model.data());
+				VioletAnimation::Palette(data.joints, model.data(), palettes.data() + (size_t)character * joint_count);
+			}
+		}
+
+		benchmark.characters = characters;
+		benchmark.frames     = frames;
+		benchmark.frame_time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / frames;
+		return benchmark;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <assets/mesh_manager.h>
+
+namespace lambda
+{
+	// Turns the animation curves of a glTF file into the compressed clips of
+	// VioletMeshData, see VioletAnimationTrack, and times how long the runtime
+	// takes to pose a crowd with them.
+	class VioletAnimationCompressor
+	{
+	public:
+		// Frames Measure poses every character for.
+		static constexpr uint32_t kBenchmarkFrames = 30u;
+
+		// Keys of a single property of a joint, as they were authored.
+		struct Curve
+		{
+			enum class Path { kTranslation, kRotation, kScale };
+			enum class Interpolation { kLinear, kStep, kCubicSpline };
+
+			uint32_t          joint         = 0u; // Into VioletMeshData::joints.
+			Path              path          = Path::kTranslation;
+			Interpolation     interpolation = Interpolation::kLinear;
+			Vector<float>     times;
+			Vector<glm::vec4> values; // Rotations are xyzw. Cubic splines have an in tangent, a value and an out tangent per key.
+		};
+
+		// Adds up over every clip that is compressed with it.
+		struct Stats
+		{
+			uint32_t clips             = 0u;
+			uint32_t tracks            = 0u;
+			uint32_t constant_tracks   = 0u;
+			size_t   bytes_before      = 0u; // Of the authored keys.
+			size_t   bytes_after       = 0u;
+			float    translation_error = 0.0f; // Largest, in the units of the positions.
+			float    rotation_error    = 0.0f; // Largest, in degrees.
+			double   time              = 0.0;  // Milliseconds.
+		};
+
+		struct Benchmark
+		{
+			uint32_t characters = 0u;
+			uint32_t frames     = 0u;
+			double   frame_time = 0.0; // Milliseconds to pose every character once, on one thread.
+		};
+
+		// Resamples the curves at frame_rate and encodes them. Tracks that do
+		// not move keep a single key, joints without curves keep their rest pose.
+		static VioletAnimationClip Compress(const String& name, const Vector<VioletMeshJoint>& joints, const Vector<Curve>& curves, float frame_rate, Stats& stats);
+
+		// Poses characters characters for frames frames, each blending two of
+		// the clips of data the way a cross fade does.
+		static Benchmark Measure(const VioletMeshData& data, uint32_t characters, uint32_t frames);
+	};
+}
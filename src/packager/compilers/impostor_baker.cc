@@ -0,0 +1,402 @@
+#include "impostor_baker.h"
+#include <pipeline/build_graph.h>
+#include <utils/file_system.h>
+#include <utils/console.h>
+#include <glm/glm.hpp>
+#include <stb_image.h>
+#include <stb_image_write.h>
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+
+namespace lambda
+{
+	namespace
+	{
+		static constexpr int kTriangleList = 4; // GLTF primitive mode.
+
+		struct Image
+		{
+			int                   width  = 0;
+			int                   height = 0;
+			Vector<unsigned char> texels; // RGBA8.
+
+			// Nearest texel, wrapped.
+			glm::vec4 sample(const glm::vec2& uv) const
+			{
+				int x = (int)std::floor(uv.x * (float)width)  % width;
+				int y = (int)std::floor(uv.y * (float)height) % height;
+				x += x < 0 ? width  : 0;
+				y += y < 0 ? height : 0;
+				const unsigned char* texel = texels.data() + ((size_t)y * width + x) * 4u;
+				return glm::vec4(texel[0], texel[1], texel[2], texel[3]) / 255.0f;
+			}
+		};
+
+		struct Vertex
+		{
+			glm::vec3 position; // On the bounding sphere scaled to a unit sphere.
+			glm::vec3 normal;
+			glm::vec2 tex;
+		};
+
+		struct Source
+		{
+			int              idx;
+			Vector<Vertex>   vertices;
+			Vector<uint32_t> indices;
+			const Image*     albedo = nullptr;
+			glm::vec4        colour;
+			uint32_t         cell_x;
+			uint32_t         cell_y;
+		};
+
+		struct Atlas
+		{
+			uint32_t              size;
+			Vector<unsigned char> albedo;
+			Vector<unsigned char> normal_depth;
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		glm::vec3 octDecode(const glm::vec2& oct)
+		{
+			glm::vec3 n(oct.x, oct.y, 1.0f - std::abs(oct.x) - std::abs(oct.y));
+			const float t = std::max(-n.z, 0.0f);
+			n.x += n.x >= 0.0f ? -t : t;
+			n.y += n.y >= 0.0f ? -t : t;
+			return glm::normalize(n);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		float edge(const glm::vec2& a, const glm::vec2& b, const glm::vec2& p)
+		{
+			return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		unsigned char toUnorm8(float v)
+		{
+			return (unsigned char)std::round(glm::clamp(v, 0.0f, 1.0f) * 255.0f);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Renders a single view of the source with an orthographic projection
+		// that fits the unit sphere, keeping the surface closest to the viewer.
+		void rasterizeFrame(const Source& source, uint32_t frame_x, uint32_t frame_y, uint32_t frames, uint32_t frame_size, Atlas& atlas)
+		{
+			const glm::vec3 direction = VioletImpostorBaker::GetFrameDirection(frame_x, frame_y, frames);
+			glm::vec3 right, up;
+			VioletImpostorBaker::GetFrameAxes(direction, right, up);
+
+			const size_t texel_count = (size_t)frame_size * frame_size;
+			Vector<float>     depth(texel_count, -FLT_MAX);
+			Vector<glm::vec4> albedo(texel_count, glm::vec4(0.0f));
+			Vector<glm::vec4> normal_depth(texel_count, glm::vec4(0.5f, 0.5f, 1.0f, 0.0f));
+
+			for (size_t i = 0u; i + 2u < source.indices.size(); i += 3u)
+			{
+				const Vertex* v[3] = { &source.vertices[source.indices[i]], &source.vertices[source.indices[i + 1u]], &source.vertices[source.indices[i + 2u]] };
+				glm::vec2 s[3];
+				float     z[3];
+				for (uint32_t j = 0u; j < 3u; ++j)
+				{
+					s[j] = glm::vec2(glm::dot(v[j]->position, right) * 0.5f + 0.5f, 0.5f - glm::dot(v[j]->position, up) * 0.5f) * (float)frame_size;
+					z[j] = glm::dot(v[j]->position, direction);
+				}
+
+				const float area = edge(s[0], s[1], s[2]);
+				if (std::abs(area) < 1e-8f)
+					continue;
+
+				const int min_x = std::max((int)std::floor(std::min(s[0].x, std::min(s[1].x, s[2].x))), 0);
+				const int min_y = std::max((int)std::floor(std::min(s[0].y, std::min(s[1].y, s[2].y))), 0);
+				const int max_x = std::min((int)std::ceil(std::max(s[0].x, std::max(s[1].x, s[2].x))), (int)frame_size - 1);
+				const int max_y = std::min((int)std::ceil(std::max(s[0].y, std::max(s[1].y, s[2].y))), (int)frame_size - 1);
+
+				for (int y = min_y; y <= max_y; ++y)
+				{
+					for (int x = min_x; x <= max_x; ++x)
+					{
+						// Dividing by the signed area makes the weights positive inside for either winding.
+						const glm::vec2 p((float)x + 0.5f, (float)y + 0.5f);
+						const glm::vec3 w(edge(s[1], s[2], p) / area, edge(s[2], s[0], p) / area, edge(s[0], s[1], p) / area);
+						if (w.x < 0.0f || w.y < 0.0f || w.z < 0.0f)
+							continue;
+
+						const size_t texel = (size_t)y * frame_size + x;
+						const float d = w.x * z[0] + w.y * z[1] + w.z * z[2];
+						if (d <= depth[texel])
+							continue;
+
+						glm::vec3 normal = w.x * v[0]->normal + w.y * v[1]->normal + w.z * v[2]->normal;
+						const float length = glm::length(normal);
+						normal = length > 0.0f ? normal / length : direction;
+						// Open meshes show their back faces, light them like the front.
+						if (glm::dot(normal, direction) < 0.0f)
+							normal = -normal;
+
+						glm::vec4 colour = source.colour;
+						if (source.albedo)
+							colour *= source.albedo->sample(w.x * v[0]->tex + w.y * v[1]->tex + w.z * v[2]->tex);
+
+						depth[texel]        = d;
+						albedo[texel]       = colour;
+						normal_depth[texel] = glm::vec4(normal * 0.5f + 0.5f, d * 0.5f + 0.5f);
+					}
+				}
+			}
+
+			// Empty texels take the average of their covered neighbours, but stay transparent.
+			Vector<bool> covered(texel_count);
+			for (size_t i = 0u; i < texel_count; ++i)
+				covered[i] = depth[i] != -FLT_MAX;
+
+			for (uint32_t pass = 0u; pass < VioletImpostorBaker::kDilatePasses; ++pass)
+			{
+				Vector<bool> next = covered;
+				for (uint32_t y = 0u; y < frame_size; ++y)
+				{
+					for (uint32_t x = 0u; x < frame_size; ++x)
+					{
+						const size_t texel = (size_t)y * frame_size + x;
+						if (covered[texel])
+							continue;
+
+						glm::vec4 colour(0.0f), nd(0.0f);
+						uint32_t count = 0u;
+						const int offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+						for (const auto& offset : offsets)
+						{
+							const int nx = (int)x + offset[0];
+							const int ny = (int)y + offset[1];
+							if (nx < 0 || ny < 0 || nx >= (int)frame_size || ny >= (int)frame_size || !covered[(size_t)ny * frame_size + nx])
+								continue;
+							colour += albedo[(size_t)ny * frame_size + nx];
+							nd     += normal_depth[(size_t)ny * frame_size + nx];
+							count++;
+						}
+
+						if (count == 0u)
+							continue;
+
+						albedo[texel]       = glm::vec4(glm::vec3(colour) / (float)count, 0.0f);
+						normal_depth[texel] = nd / (float)count;
+						next[texel]         = true;
+					}
+				}
+				covered = eastl::move(next);
+			}
+
+			const size_t origin_x = ((size_t)source.cell_x * frames + frame_x) * frame_size;
+			const size_t origin_y = ((size_t)source.cell_y * frames + frame_y) * frame_size;
+			for (uint32_t y = 0u; y < frame_size; ++y)
+			{
+				for (uint32_t x = 0u; x < frame_size; ++x)
+				{
+					const size_t texel = (size_t)y * frame_size + x;
+					unsigned char* alb = atlas.albedo.data()       + ((origin_y + y) * atlas.size + origin_x + x) * 4u;
+					unsigned char* nd  = atlas.normal_depth.data() + ((origin_y + y) * atlas.size + origin_x + x) * 4u;
+					for (uint32_t c = 0u; c < 4u; ++c)
+					{
+						alb[c] = toUnorm8(albedo[texel][c]);
+						nd[c]  = toUnorm8(normal_depth[texel][c]);
+					}
+				}
+			}
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	glm::vec3 VioletImpostorBaker::GetFrameDirection(uint32_t x, uint32_t y, uint32_t frames)
+	{
+		return octDecode(glm::vec2(((float)x + 0.5f) / (float)frames, ((float)y + 0.5f) / (float)frames) * 2.0f - 1.0f);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	void VioletImpostorBaker::GetFrameAxes(const glm::vec3& direction, glm::vec3& right, glm::vec3& up)
+	{
+		const glm::vec3 reference = std::abs(direction.y) < 0.999f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+		right = glm::normalize(glm::cross(reference, direction));
+		up    = glm::cross(direction, right);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	VioletImpostorBaker::Stats VioletImpostorBaker::Bake(VioletMesh& mesh, uint32_t frames, uint32_t frame_size)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		Stats stats;
+
+		const String path          = FileSystem::FullFilePath(mesh.file);
+		const String albedo_file   = FileSystem::RemoveName(path) + "__" + FileSystem::FileName(path) + "_impostor.png";
+		const String nd_file       = FileSystem::RemoveName(path) + "__" + FileSystem::FileName(path) + "_impostor_nd.png";
+		mesh.data.impostors.clear();
+		mesh.data.impostor_albedo.clear();
+		mesh.data.impostor_normal_depth.clear();
+		mesh.data.impostor_frames = 0u;
+
+		// Atlases of an earlier build should not stay around when nothing is baked.
+		for (const String& file : { albedo_file, nd_file })
+			if (FileSystem::DoesFileExist(file))
+				FileSystem::RemoveFile(file);
+
+		if (frames == 0u || frame_size == 0u)
+			return stats;
+
+		if (mesh.data.quantized & kMeshQuantizedPositions)
+		{
+			foundation::Error("[MESH] " + mesh.file + " has quantized positions, impostors have to be baked before quantizing\n");
+			return stats;
+		}
+
+		// Skinned meshes do not keep the shape they are baked in.
+		Vector<const VioletSubMesh*> sub_meshes(mesh.data.idx.segments.size(), nullptr);
+		for (const VioletSubMesh& sub_mesh : mesh.meshes)
+		{
+			const bool usable = sub_mesh.idx >= 0 && sub_mesh.topology == kTriangleList && sub_mesh.joi < 0 &&
+				sub_mesh.pos >= 0 && mesh.data.pos.segments[sub_mesh.pos].stride == sizeof(glm::vec3);
+			if (usable && sub_meshes[sub_mesh.idx] == nullptr)
+				sub_meshes[sub_mesh.idx] = &sub_mesh;
+		}
+
+		const uint32_t source_count = (uint32_t)std::count_if(sub_meshes.begin(), sub_meshes.end(), [](const VioletSubMesh* sub_mesh) { return sub_mesh != nullptr; });
+		if (source_count == 0u || source_count > kMaxImpostors)
+			return stats;
+
+		// Every texture is loaded once, however many segments use it.
+		UnorderedMap<int, Image> albedo_textures;
+		for (const VioletSubMesh* sub_mesh : sub_meshes)
+		{
+			if (sub_mesh == nullptr || sub_mesh->tex_alb < 0 || sub_mesh->tex_alb >= (int)mesh.data.tex_alb.size() || albedo_textures.find(sub_mesh->tex_alb) != albedo_textures.end())
+				continue;
+
+			Image image;
+			int channels = 0;
+			unsigned char* texels = stbi_load(FileSystem::FullFilePath(mesh.data.tex_alb[sub_mesh->tex_alb]).c_str(), &image.width, &image.height, &channels, 4);
+			if (texels == nullptr)
+			{
+				foundation::Warning("[MESH] " + mesh.file + " could not load " + mesh.data.tex_alb[sub_mesh->tex_alb] + " for its impostor\n");
+				continue;
+			}
+			image.texels.assign(texels, texels + (size_t)image.width * image.height * 4u);
+			stbi_image_free(texels);
+			albedo_textures[sub_mesh->tex_alb] = eastl::move(image);
+		}
+
+		const uint32_t cells = (uint32_t)std::ceil(std::sqrt((float)source_count));
+		Vector<Source> sources;
+		for (int idx = 0; idx < (int)sub_meshes.size(); ++idx)
+		{
+			const VioletSubMesh* sub_mesh = sub_meshes[idx];
+			if (sub_mesh == nullptr)
+				continue;
+
+			const VioletDataSegment& pos_segment   = mesh.data.pos.segments[sub_mesh->pos];
+			const VioletDataSegment& index_segment = mesh.data.idx.segments[idx];
+			const glm::vec3* positions = (const glm::vec3*)(mesh.data.pos.data.data() + pos_segment.offset);
+			const uint32_t*  indices   = (const uint32_t*)(mesh.data.idx.data.data() + index_segment.offset);
+			const bool has_normals = sub_mesh->nor >= 0 && mesh.data.nor.segments[sub_mesh->nor].stride == sizeof(glm::vec3) && !(mesh.data.quantized & kMeshQuantizedNormals);
+			const bool has_tex     = sub_mesh->tex >= 0 && mesh.data.tex.segments[sub_mesh->tex].stride == sizeof(glm::vec2) && !(mesh.data.quantized & kMeshQuantizedTexCoords);
+
+			bool valid = index_segment.stride == sizeof(uint32_t);
+			for (size_t i = 0u; i < index_segment.count && valid; ++i)
+				valid = indices[i] < pos_segment.count;
+			if (!valid || index_segment.count < 3u)
+				continue;
+
+			glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+			for (size_t i = 0u; i < index_segment.count; ++i)
+			{
+				min = glm::min(min, positions[indices[i]]);
+				max = glm::max(max, positions[indices[i]]);
+			}
+			const glm::vec3 center = (min + max) * 0.5f;
+			float radius = 0.0f;
+			for (size_t i = 0u; i < index_segment.count; ++i)
+				radius = std::max(radius, glm::length(positions[indices[i]] - center));
+			if (radius <= 0.0f)
+				continue;
+
+			Source source;
+			source.idx    = idx;
+			source.colour = sub_mesh->colour;
+			source.cell_x = (uint32_t)sources.size() % cells;
+			source.cell_y = (uint32_t)sources.size() / cells;
+			auto albedo = albedo_textures.find(sub_mesh->tex_alb);
+			source.albedo = (has_tex && albedo != albedo_textures.end()) ? &albedo->second : nullptr;
+			source.indices.assign(indices, indices + index_segment.count);
+			source.vertices.resize(pos_segment.count);
+			for (size_t i = 0u; i < pos_segment.count; ++i)
+			{
+				Vertex& vertex = source.vertices[i];
+				vertex.position = (positions[i] - center) / radius;
+				vertex.normal   = has_normals ? ((const glm::vec3*)(mesh.data.nor.data.data() + mesh.data.nor.segments[sub_mesh->nor].offset))[i] : glm::vec3(0.0f);
+				vertex.tex      = has_tex ? ((const glm::vec2*)(mesh.data.tex.data.data() + mesh.data.tex.segments[sub_mesh->tex].offset))[i] : glm::vec2(0.0f);
+			}
+
+			// Without normals every triangle adds its face normal to its corners.
+			if (!has_normals)
+			{
+				for (size_t i = 0u; i + 2u < source.indices.size(); i += 3u)
+				{
+					Vertex& a = source.vertices[source.indices[i]];
+					Vertex& b = source.vertices[source.indices[i + 1u]];
+					Vertex& c = source.vertices[source.indices[i + 2u]];
+					const glm::vec3 normal = glm::cross(b.position - a.position, c.position - a.position);
+					a.normal += normal;
+					b.normal += normal;
+					c.normal += normal;
+				}
+			}
+
+			// Seen from in between two frames the surface moves by about the radius times half the angle between them.
+			const float cell_uv = 1.0f / (float)cells;
+			VioletMeshImpostor impostor;
+			impostor.idx    = idx;
+			impostor.rect   = glm::vec4((float)source.cell_x * cell_uv, (float)source.cell_y * cell_uv, cell_uv, cell_uv);
+			impostor.center = center;
+			impostor.radius = radius;
+			impostor.error  = radius * std::sin(3.14159265359f * 0.5f / (float)frames);
+			mesh.data.impostors.push_back(impostor);
+			sources.push_back(eastl::move(source));
+		}
+
+		if (sources.empty())
+			return stats;
+
+		Atlas atlas;
+		atlas.size = cells * frames * frame_size;
+		atlas.albedo.resize((size_t)atlas.size * atlas.size * 4u, 0u);
+		atlas.normal_depth.resize((size_t)atlas.size * atlas.size * 4u, 0u);
+
+		// Every frame owns its own part of the atlases.
+		VioletBuildGraph graph;
+		for (const Source& source : sources)
+			for (uint32_t y = 0u; y < frames; ++y)
+				for (uint32_t x = 0u; x < frames; ++x)
+					graph.AddJob(mesh.file, [&source, &atlas, x, y, frames, frame_size]() {
+						rasterizeFrame(source, x, y, frames, frame_size, atlas);
+						return true;
+					});
+		graph.Run();
+
+		const int stride = (int)atlas.size * 4;
+		if (!stbi_write_png(albedo_file.c_str(), (int)atlas.size, (int)atlas.size, 4, atlas.albedo.data(), stride) ||
+			  !stbi_write_png(nd_file.c_str(), (int)atlas.size, (int)atlas.size, 4, atlas.normal_depth.data(), stride))
+		{
+			foundation::Error("[MESH] " + mesh.file + " could not write its impostor atlases\n");
+			mesh.data.impostors.clear();
+			return stats;
+		}
+
+		mesh.data.impostor_albedo       = FileSystem::MakeRelative(albedo_file);
+		mesh.data.impostor_normal_depth = FileSystem::MakeRelative(nd_file);
+		mesh.data.impostor_frames       = frames;
+
+		stats.impostors = (uint32_t)sources.size();
+		stats.size      = atlas.size;
+		stats.time      = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return stats;
+	}
+}
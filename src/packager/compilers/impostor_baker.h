@@ -0,0 +1,34 @@
+#pragma once
+#include <assets/mesh_manager.h>
+
+namespace lambda
+{
+	// Bakes octahedral impostors of the triangle lists of a mesh with a small
+	// CPU rasterizer, so building does not need a GPU. Every index segment gets
+	// a rect of frames * frames views in a pair of atlases, see VioletMeshImpostor.
+	class VioletImpostorBaker
+	{
+	public:
+		// Meshes with more segments are skipped, their atlases would get too big.
+		static constexpr uint32_t kMaxImpostors = 16u;
+		// Passes that grow the covered texels into the empty ones, so filtering
+		// does not pull in the background.
+		static constexpr uint32_t kDilatePasses = 4u;
+
+		struct Stats
+		{
+			uint32_t impostors = 0u;
+			uint32_t size      = 0u;  // Width and height of the atlases.
+			double   time      = 0.0; // Milliseconds.
+		};
+
+		// Writes the atlases as PNG files next to the mesh, they are built like
+		// any other texture. Needs the positions as floats.
+		static Stats Bake(VioletMesh& mesh, uint32_t frames, uint32_t frame_size);
+
+		// The direction frame (x, y) looks at the segment from, pointing away
+		// from it, and the axes of the image. The impostor shader has to match.
+		static glm::vec3 GetFrameDirection(uint32_t x, uint32_t y, uint32_t frames);
+		static void GetFrameAxes(const glm::vec3& direction, glm::vec3& right, glm::vec3& up);
+	};
+}
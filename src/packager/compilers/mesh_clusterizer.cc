@@ -0,0 +1,410 @@
+#include "mesh_clusterizer.h"
+#include <pipeline/build_graph.h>
+#include <utils/console.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+
+namespace lambda
+{
+	namespace
+	{
+		static constexpr int kTriangleList = 4; // GLTF primitive mode.
+		static constexpr uint32_t kNone = ~0u;
+		// Cost of every triangle that is left around a candidate, so the clusters
+		// fill the corners they pass instead of leaving small islands behind.
+		static constexpr float kLiveWeight = 0.1f;
+
+		typedef VioletMeshSimplifier::PositionView PositionView;
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Evenly spread directions on the unit sphere, along a Fibonacci spiral.
+		glm::vec3 getTestDirection(uint32_t i, uint32_t count)
+		{
+			const float y   = 1.0f - 2.0f * ((float)i + 0.5f) / (float)count;
+			const float r   = std::sqrt(std::max(0.0f, 1.0f - y * y));
+			const float phi = (float)i * 2.39996323f; // Golden angle.
+			return glm::vec3(std::cos(phi) * r, y, std::sin(phi) * r);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		glm::vec3 getNormal(const PositionView& positions, const uint32_t* triangle)
+		{
+			const glm::vec3 p0 = positions[triangle[0]];
+			return glm::cross(positions[triangle[1]] - p0, positions[triangle[2]] - p0);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		void computeBounds(const PositionView& positions, const uint32_t* indices, size_t index_count, VioletMeshCluster& cluster)
+		{
+			glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+			glm::vec3 normal_sum(0.0f);
+			for (size_t i = 0u; i + 2u < index_count; i += 3u)
+			{
+				for (size_t j = i; j < i + 3u; ++j)
+				{
+					min = glm::min(min, positions[indices[j]]);
+					max = glm::max(max, positions[indices[j]]);
+				}
+				const glm::vec3 normal = getNormal(positions, indices + i);
+				const float length = glm::length(normal);
+				if (length > 0.0f)
+					normal_sum += normal / length;
+			}
+
+			cluster.center = (min + max) * 0.5f;
+			cluster.radius = 0.0f;
+			for (size_t i = 0u; i < index_count; ++i)
+				cluster.radius = std::max(cluster.radius, glm::length(positions[indices[i]] - cluster.center));
+
+			// The cone has to hold the facing of every triangle, degenerate ones face nowhere.
+			const float axis_length = glm::length(normal_sum);
+			cluster.cone_axis   = axis_length > 0.0f ? normal_sum / axis_length : glm::vec3(0.0f, 0.0f, 1.0f);
+			cluster.cone_cutoff = 1.0f;
+			if (axis_length <= 0.0f)
+				return;
+
+			float min_dot = 1.0f;
+			for (size_t i = 0u; i + 2u < index_count; i += 3u)
+			{
+				const glm::vec3 normal = getNormal(positions, indices + i);
+				const float length = glm::length(normal);
+				if (length > 0.0f)
+					min_dot = std::min(min_dot, glm::dot(normal / length, cluster.cone_axis));
+			}
+			if (min_dot >= VioletMeshClusterizer::kMinConeDot)
+				cluster.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Vector<VioletMeshCluster> VioletMeshClusterizer::BuildClusters(const PositionView& positions, const uint32_t* indices, size_t index_count, uint32_t max_vertices, uint32_t max_triangles, float cone_weight, Vector<uint32_t>& result)
+	{
+		const uint32_t triangle_count = (uint32_t)(index_count / 3u);
+		const uint32_t vertex_count   = (uint32_t)positions.count;
+		Vector<VioletMeshCluster> clusters;
+		result.clear();
+		result.reserve(triangle_count * 3u);
+		if (triangle_count == 0u || max_vertices < 3u || max_triangles == 0u)
+			return clusters;
+
+		// Triangles around every vertex.
+		Vector<uint32_t> adjacency_offsets(vertex_count + 1u, 0u);
+		for (uint32_t i = 0u; i < triangle_count * 3u; ++i)
+			adjacency_offsets[indices[i] + 1u]++;
+		for (uint32_t v = 0u; v < vertex_count; ++v)
+			adjacency_offsets[v + 1u] += adjacency_offsets[v];
+		Vector<uint32_t> adjacency(triangle_count * 3u);
+		Vector<uint32_t> adjacency_fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+		for (uint32_t t = 0u; t < triangle_count; ++t)
+			for (uint32_t k = 0u; k < 3u; ++k)
+				adjacency[adjacency_fill[indices[t * 3u + k]]++] = t;
+
+		Vector<glm::vec3> centroids(triangle_count);
+		Vector<glm::vec3> normals(triangle_count);
+		for (uint32_t t = 0u; t < triangle_count; ++t)
+		{
+			const uint32_t* triangle = indices + t * 3u;
+			centroids[t] = (positions[triangle[0]] + positions[triangle[1]] + positions[triangle[2]]) / 3.0f;
+			const glm::vec3 normal = getNormal(positions, triangle);
+			const float length = glm::length(normal);
+			normals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+		}
+
+		// Triangles left around every vertex.
+		Vector<uint32_t> live(vertex_count);
+		for (uint32_t v = 0u; v < vertex_count; ++v)
+			live[v] = adjacency_offsets[v + 1u] - adjacency_offsets[v];
+
+		// Last cluster a vertex was added to and the last cluster a triangle became a candidate of.
+		Vector<uint32_t> vertex_cluster(vertex_count, kNone);
+		Vector<uint32_t> triangle_cluster(triangle_count, kNone);
+		Vector<uint8_t>  emitted(triangle_count, 0u);
+		Vector<uint32_t> cluster_triangles;
+		Vector<uint32_t> candidates;
+		uint32_t vertices = 0u;
+		glm::vec3 centroid_sum;
+		glm::vec3 normal_sum;
+
+		const auto add = [&](uint32_t cluster, uint32_t t) {
+			emitted[t] = 1u;
+			cluster_triangles.push_back(t);
+			centroid_sum += centroids[t];
+			normal_sum   += normals[t];
+
+			for (uint32_t k = 0u; k < 3u; ++k)
+			{
+				const uint32_t v = indices[t * 3u + k];
+				live[v]--;
+				if (vertex_cluster[v] == cluster)
+					continue;
+				vertex_cluster[v] = cluster;
+				vertices++;
+
+				for (uint32_t a = adjacency_offsets[v]; a < adjacency_offsets[v + 1u]; ++a)
+				{
+					const uint32_t neighbour = adjacency[a];
+					if (!emitted[neighbour] && triangle_cluster[neighbour] != cluster)
+					{
+						triangle_cluster[neighbour] = cluster;
+						candidates.push_back(neighbour);
+					}
+				}
+			}
+		};
+
+		// Every cluster starts next to the previous one, at the triangle with
+		// the fewest triangles left around it, so no small islands are left
+		// behind. Only when there is none the order of the list is followed.
+		uint32_t next = 0u;
+		while (true)
+		{
+			uint32_t seed = kNone;
+			uint32_t seed_live = ~0u;
+			for (uint32_t t : candidates)
+			{
+				if (emitted[t])
+					continue;
+				const uint32_t* triangle = indices + t * 3u;
+				const uint32_t triangle_live = live[triangle[0]] + live[triangle[1]] + live[triangle[2]];
+				if (triangle_live < seed_live)
+				{
+					seed      = t;
+					seed_live = triangle_live;
+				}
+			}
+			if (seed == kNone)
+			{
+				while (next < triangle_count && emitted[next])
+					next++;
+				if (next == triangle_count)
+					break;
+				seed = next;
+			}
+
+			const uint32_t cluster = (uint32_t)clusters.size();
+			cluster_triangles.clear();
+			candidates.clear();
+			vertices     = 0u;
+			centroid_sum = glm::vec3(0.0f);
+			normal_sum   = glm::vec3(0.0f);
+			add(cluster, seed);
+
+			while (cluster_triangles.size() < max_triangles)
+			{
+				const glm::vec3 center = centroid_sum / (float)cluster_triangles.size();
+				const float axis_length = glm::length(normal_sum);
+				const glm::vec3 axis = axis_length > 0.0f ? normal_sum / axis_length : glm::vec3(0.0f);
+				float spread = FLT_EPSILON;
+				for (uint32_t t : cluster_triangles)
+					spread = std::max(spread, glm::length(centroids[t] - center));
+
+				// Fewest new vertices first, then the closest triangle that bends the cone
+				// the least and has the fewest triangles left around it.
+				uint32_t best          = kNone;
+				uint32_t best_vertices = 4u;
+				float    best_cost     = FLT_MAX;
+				for (uint32_t t : candidates)
+				{
+					if (emitted[t])
+						continue;
+
+					uint32_t new_vertices = 0u;
+					for (uint32_t k = 0u; k < 3u; ++k)
+						new_vertices += vertex_cluster[indices[t * 3u + k]] != cluster ? 1u : 0u;
+					if (vertices + new_vertices > max_vertices || new_vertices > best_vertices)
+						continue;
+
+					const uint32_t* triangle = indices + t * 3u;
+					const float cost = (1.0f - cone_weight) * glm::length(centroids[t] - center) / spread + cone_weight * (1.0f - glm::dot(normals[t], axis)) + kLiveWeight * (float)(live[triangle[0]] + live[triangle[1]] + live[triangle[2]]);
+					if (new_vertices < best_vertices || cost < best_cost)
+					{
+						best          = t;
+						best_vertices = new_vertices;
+						best_cost     = cost;
+					}
+				}
+
+				if (best == kNone)
+					break;
+				add(cluster, best);
+			}
+
+			VioletMeshCluster result_cluster;
+			result_cluster.index_offset = (uint32_t)result.size();
+			result_cluster.index_count  = (uint32_t)cluster_triangles.size() * 3u;
+			for (uint32_t t : cluster_triangles)
+				result.insert(result.end(), indices + t * 3u, indices + t * 3u + 3u);
+			computeBounds(positions, result.data() + result_cluster.index_offset, result_cluster.index_count, result_cluster);
+			clusters.push_back(result_cluster);
+		}
+
+		return clusters;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	bool VioletMeshClusterizer::IsBackFacing(const VioletMeshCluster& cluster, const glm::vec3& position)
+	{
+		if (cluster.cone_cutoff >= 1.0f)
+			return false;
+
+		const glm::vec3 to_center = cluster.center - position;
+		return glm::dot(to_center, cluster.cone_axis) >= cluster.cone_cutoff * glm::length(to_center) + cluster.radius;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	VioletMeshClusterizer::Stats VioletMeshClusterizer::Build(VioletMesh& mesh, uint32_t max_vertices, uint32_t max_triangles, uint32_t min_triangles, float cone_weight)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		Stats stats;
+		mesh.data.clusters.clear();
+
+		if (mesh.data.quantized & kMeshQuantizedPositions)
+		{
+			foundation::Error("[MESH] " + mesh.file + " has quantized positions, clusters have to be built before quantizing\n");
+			return stats;
+		}
+
+		// The vertex segment of every index segment, or -2 if they do not match.
+		// Skinned lists are left alone, their bounds and cones only hold in the bind pose.
+		Vector<int> vertices(mesh.data.idx.segments.size(), -1);
+		for (const VioletSubMesh& sub_mesh : mesh.meshes)
+		{
+			if (sub_mesh.idx < 0)
+				continue;
+
+			int& pos = vertices[sub_mesh.idx];
+			const bool usable = sub_mesh.topology == kTriangleList && sub_mesh.joi < 0 && sub_mesh.pos >= 0 && mesh.data.pos.segments[sub_mesh.pos].stride == sizeof(glm::vec3);
+			pos = (!usable || (pos != -1 && pos != sub_mesh.pos)) ? -2 : sub_mesh.pos;
+		}
+
+		struct List
+		{
+			int                       idx;
+			PositionView              positions;
+			glm::vec3                 center;
+			float                     size;
+			Vector<uint32_t>          indices;
+			Vector<VioletMeshCluster> clusters;
+			uint64_t                  cone_culled = 0u;
+			uint64_t                  back_facing = 0u;
+		};
+		Vector<List> lists;
+		for (int idx = 0; idx < (int)vertices.size(); ++idx)
+		{
+			const VioletDataSegment& index_segment = mesh.data.idx.segments[idx];
+			if (vertices[idx] < 0 || index_segment.count / 3u < min_triangles || index_segment.stride != sizeof(uint32_t))
+				continue;
+
+			const VioletDataSegment& vertex_segment = mesh.data.pos.segments[vertices[idx]];
+			const uint32_t* indices = (const uint32_t*)(mesh.data.idx.data.data() + index_segment.offset);
+
+			List list;
+			list.idx              = idx;
+			list.positions.data   = mesh.data.pos.data.data() + vertex_segment.offset;
+			list.positions.stride = vertex_segment.stride;
+			list.positions.count  = vertex_segment.count;
+
+			bool valid = true;
+			glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+			for (size_t i = 0u; i < index_segment.count && valid; ++i)
+			{
+				valid = indices[i] < vertex_segment.count;
+				if (valid)
+				{
+					min = glm::min(min, list.positions[indices[i]]);
+					max = glm::max(max, list.positions[indices[i]]);
+				}
+			}
+			if (!valid)
+			{
+				foundation::Error("[MESH] " + mesh.file + " has indices outside of its vertices, skipped its clusters\n");
+				continue;
+			}
+
+			list.center = (min + max) * 0.5f;
+			list.size   = glm::length(max - min);
+			lists.push_back(eastl::move(list));
+		}
+
+		VioletBuildGraph graph;
+		for (List& list : lists)
+		{
+			const VioletDataSegment& index_segment = mesh.data.idx.segments[list.idx];
+			const uint32_t* indices = (const uint32_t*)(mesh.data.idx.data.data() + index_segment.offset);
+			graph.AddJob(mesh.file, [&list, indices, index_segment, max_vertices, max_triangles, cone_weight]() {
+				list.clusters = BuildClusters(list.positions, indices, index_segment.count, max_vertices, max_triangles, cone_weight, list.indices);
+
+				// How much the cones cull compared to culling every single triangle, from just outside the list.
+				for (uint32_t view = 0u; view < kTestViews; ++view)
+				{
+					const glm::vec3 position = list.center + getTestDirection(view, kTestViews) * list.size;
+					for (const VioletMeshCluster& cluster : list.clusters)
+						if (IsBackFacing(cluster, position))
+							list.cone_culled += cluster.index_count / 3u;
+					for (size_t i = 0u; i + 2u < list.indices.size(); i += 3u)
+						if (glm::dot(getNormal(list.positions, list.indices.data() + i), list.positions[list.indices[i]] - position) > 0.0f)
+							list.back_facing++;
+				}
+				return true;
+			});
+		}
+		graph.Run();
+
+		uint64_t cluster_vertices  = 0u;
+		uint64_t cluster_triangles = 0u;
+		uint64_t tested_triangles  = 0u;
+		uint64_t cone_culled       = 0u;
+		uint64_t back_facing       = 0u;
+		double   radius            = 0.0;
+		Vector<uint32_t> seen;
+		for (List& list : lists)
+		{
+			// Same amount of indices, only the order of the triangles changed.
+			const VioletDataSegment& index_segment = mesh.data.idx.segments[list.idx];
+			memcpy(mesh.data.idx.data.data() + index_segment.offset, list.indices.data(), list.indices.size() * sizeof(uint32_t));
+
+			seen.assign(list.positions.count, kNone);
+			for (uint32_t i = 0u; i < (uint32_t)list.clusters.size(); ++i)
+			{
+				VioletMeshCluster& cluster = list.clusters[i];
+				cluster.idx = list.idx;
+				mesh.data.clusters.push_back(cluster);
+
+				for (uint32_t j = cluster.index_offset; j < cluster.index_offset + cluster.index_count; ++j)
+				{
+					if (seen[list.indices[j]] != i)
+					{
+						seen[list.indices[j]] = i;
+						cluster_vertices++;
+					}
+				}
+				cluster_triangles += cluster.index_count / 3u;
+				radius += list.size > 0.0f ? cluster.radius / list.size : 0.0f;
+			}
+
+			stats.lists++;
+			stats.clusters   += (uint32_t)list.clusters.size();
+			tested_triangles += (uint64_t)(list.indices.size() / 3u) * kTestViews;
+			cone_culled      += list.cone_culled;
+			back_facing      += list.back_facing;
+		}
+
+		if (stats.clusters > 0u)
+		{
+			stats.vertices  = (float)((double)cluster_vertices / stats.clusters);
+			stats.triangles = (float)((double)cluster_triangles / stats.clusters);
+			stats.radius    = (float)(radius / stats.clusters);
+		}
+		if (tested_triangles > 0u)
+		{
+			stats.cone_culled = (float)((double)cone_culled / tested_triangles);
+			stats.back_facing = (float)((double)back_facing / tested_triangles);
+		}
+
+		stats.time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return stats;
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "mesh_simplifier.h"
+
+namespace lambda
+{
+	// Splits the full detail triangle lists of a mesh into small clusters with
+	// a bounding sphere and a normal cone each, see VioletMeshCluster. The
+	// triangles of a list are reordered so every cluster is a single range of
+	// its indices, LOD levels are left alone.
+	class VioletMeshClusterizer
+	{
+	public:
+		// Triangles whose facing is within this of the axis are needed for a cone that can cull.
+		static constexpr float kMinConeDot = 0.1f;
+		// Views per list the culling estimate of Stats is taken from.
+		static constexpr uint32_t kTestViews = 64u;
+
+		struct Stats
+		{
+			uint32_t lists        = 0u;
+			uint32_t clusters     = 0u;
+			float    vertices     = 0.0f; // Average per cluster.
+			float    triangles    = 0.0f; // Average per cluster.
+			float    radius       = 0.0f; // Average cluster radius, relative to the size of its list.
+			float    cone_culled  = 0.0f; // Part of the triangles the cones reject, seen from all around.
+			float    back_facing  = 0.0f; // Part of the triangles that face away from those same views.
+			double   time         = 0.0;  // Milliseconds.
+		};
+
+		// Clusters every triangle list with at least min_triangles triangles.
+		// cone_weight trades compact clusters (0) for tight cones (1).
+		static Stats Build(VioletMesh& mesh, uint32_t max_vertices, uint32_t max_triangles, uint32_t min_triangles, float cone_weight);
+
+		// Clusters a single list. Writes its reordered indices to result, the
+		// index offsets of the clusters are into result and idx is left at -1.
+		static Vector<VioletMeshCluster> BuildClusters(const VioletMeshSimplifier::PositionView& positions, const uint32_t* indices, size_t index_count, uint32_t max_vertices, uint32_t max_triangles, float cone_weight, Vector<uint32_t>& result);
+
+		// Whether every triangle of the cluster faces away from position. The
+		// runtime culls with the same test.
+		static bool IsBackFacing(const VioletMeshCluster& cluster, const glm::vec3& position);
+	};
+}
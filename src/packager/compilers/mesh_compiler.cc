@@ -1,9 +1,15 @@
 #include "mesh_compiler.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "mesh_clusterizer.h"
+#include "impostor_baker.h"
+#include "animation_compressor.h"
 #include <utils/file_system.h>
 #include <utils/utilities.h>
 #include <utils/console.h>
 #include <memory/memory.h>
 #include <algorithm>
+#include <numeric>
 #include <utils/decompose_matrix.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -187,10 +193,12 @@ namespace lambda
 	void addNode(const tinygltf::Model& model, const int& n, const int& current_mesh, Vector<VioletSubMesh>& meshes, const AccessorMemoryConverter& converter);
 	void getData(const tinygltf::Model& model, const Vector<int>& accessors, VioletDataInfo& info);
 	void getDataIdx(const tinygltf::Model& model, const Vector<int>& accessors, VioletDataInfo& info);
+	Vector<float> getFloats(const tinygltf::Model& model, int a);
+	void getSkin(const tinygltf::Model& model, const AccessorMemory& memory, VioletMeshData& data, float frame_rate, VioletAnimationCompressor::Stats& stats);
 	void getTexture(const String& base_path, const String& file_name, const tinygltf::Model& model, const Vector<int>& textures, Vector<String>& handles);
 	void removeAllTextures(const String& base_path, const String& file_name);
 
-	VioletMesh loadMeshGLTF(String path)
+	VioletMesh loadMeshGLTF(String path, float frame_rate, VioletAnimationCompressor::Stats& animation_stats)
 	{
 		VioletMesh converted_mesh;
 		AccessorMemory memory;
@@ -238,6 +246,7 @@ namespace lambda
 		getTexture(base_path, file_name, model, memory.tex_nor, converted_mesh.data.tex_nrm);
 		getTexture(base_path, file_name, model, memory.tex_dmra, converted_mesh.data.tex_dmra);
 		getTexture(base_path, file_name, model, memory.tex_emi, converted_mesh.data.tex_emi);
+		getSkin(model, memory, converted_mesh.data, frame_rate, animation_stats);
 
 		auto convert = [](const Vector<int>& v, UnorderedMap<int, int>& m) { m.insert(eastl::make_pair(-1, -1)); for (int i = 0; i < (int)v.size(); ++i) { m.insert(eastl::make_pair(v.at(i), i)); } };
 		convert(memory.pos, converter.pos);
@@ -350,6 +359,180 @@ namespace lambda
 		}
 	}
 
+	// Reads an accessor as floats, normalized integers end up in [0, 1] or [-1, 1].
+	Vector<float> getFloats(const tinygltf::Model& model, int a)
+	{
+		const tinygltf::Accessor& accessor = model.accessors.at(a);
+		const size_t components = getElementType(accessor.type, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE);
+		Vector<float> result(accessor.count * components, 0.0f);
+		if (accessor.bufferView < 0)
+			return result;
+
+		const tinygltf::BufferView& buffer_view = model.bufferViews.at(accessor.bufferView);
+		const tinygltf::Buffer&     buffer = model.buffers.at(buffer_view.buffer);
+		const size_t element = getElementType(accessor.type, accessor.componentType);
+		const size_t size    = element / components;
+		const size_t stride  = buffer_view.byteStride > 0 ? buffer_view.byteStride : element;
+		const unsigned char* data = buffer.data.data() + buffer_view.byteOffset + accessor.byteOffset;
+
+		for (size_t i = 0; i < accessor.count; ++i)
+		{
+			for (size_t c = 0; c < components; ++c)
+			{
+				const unsigned char* value = data + i * stride + c * size;
+				float& out = result[i * components + c];
+				switch (accessor.componentType)
+				{
+				case TINYGLTF_COMPONENT_TYPE_FLOAT:          memcpy(&out, value, sizeof(float)); break;
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  out = (float)*value; if (accessor.normalized) out /= 255.0f; break;
+				case TINYGLTF_COMPONENT_TYPE_BYTE:           out = (float)*(const int8_t*)value; if (accessor.normalized) out = std::max(out / 127.0f, -1.0f); break;
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, value, sizeof(v)); out = (float)v; if (accessor.normalized) out /= 65535.0f; break; }
+				case TINYGLTF_COMPONENT_TYPE_SHORT:          { int16_t v; memcpy(&v, value, sizeof(v)); out = (float)v; if (accessor.normalized) out = std::max(out / 32767.0f, -1.0f); break; }
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:   { uint32_t v; memcpy(&v, value, sizeof(v)); out = (float)v; break; }
+				default: break;
+				}
+			}
+		}
+		return result;
+	}
+
+	// Reads the skeleton of the first skin and the animations of its joints.
+	// The Joints and Weights streams are turned into floats, so the runtime
+	// reads them the same way whatever the file stored.
+	void getSkin(const tinygltf::Model& model, const AccessorMemory& memory, VioletMeshData& data, float frame_rate, VioletAnimationCompressor::Stats& stats)
+	{
+		if (model.skins.empty())
+			return;
+		if (model.skins.size() > 1u)
+			foundation::Warning("MeshIO: Only the first of " + toString((uint32_t)model.skins.size()) + " skins is used\n");
+
+		const tinygltf::Skin& skin = model.skins[0];
+		const uint32_t count = (uint32_t)skin.joints.size();
+		Vector<int> node_parents(model.nodes.size(), -1);
+		for (int n = 0; n < (int)model.nodes.size(); ++n)
+			for (const int& child : model.nodes[n].children)
+				node_parents[child] = n;
+
+		UnorderedMap<int, uint32_t> node_to_joint;
+		for (uint32_t j = 0u; j < count; ++j)
+			node_to_joint.insert(eastl::make_pair(skin.joints[j], j));
+
+		// Parents have to come before their children, so sort by depth.
+		Vector<int> parents(count, -1);
+		Vector<uint32_t> depths(count, 0u);
+		for (uint32_t j = 0u; j < count; ++j)
+		{
+			for (int n = node_parents[skin.joints[j]]; n >= 0; n = node_parents[n])
+			{
+				const auto it = node_to_joint.find(n);
+				if (it == node_to_joint.end())
+					continue;
+				if (parents[j] < 0)
+					parents[j] = (int)it->second;
+				depths[j]++;
+			}
+		}
+		Vector<uint32_t> order(count);
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&depths](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+		Vector<uint32_t> remap(count);
+		for (uint32_t j = 0u; j < count; ++j)
+			remap[order[j]] = j;
+
+		const Vector<float> inverse_binds = skin.inverseBindMatrices >= 0 ? getFloats(model, skin.inverseBindMatrices) : Vector<float>();
+		data.joints.resize(count);
+		for (uint32_t j = 0u; j < count; ++j)
+		{
+			const uint32_t old = order[j];
+			const tinygltf::Node& node = model.nodes.at(skin.joints[old]);
+			VioletMeshJoint& joint = data.joints[j];
+			joint.parent = parents[old] >= 0 ? (int)remap[parents[old]] : -1;
+			if (inverse_binds.size() >= (old + 1u) * 16u)
+				joint.inverse_bind = glm::make_mat4(inverse_binds.data() + old * 16u);
+
+			if (node.matrix.size())
+				lambda::utilities::decomposeMatrix(glm::mat4(glm::make_mat4(node.matrix.data())), &joint.scale, &joint.rotation, &joint.translation);
+			else
+			{
+				joint.translation = (node.translation.size() > 0 ? glm::vec3((float)node.translation.at(0), (float)node.translation.at(1), (float)node.translation.at(2)) : glm::vec3(0.0f));
+				joint.scale       = (node.scale.size()       > 0 ? glm::vec3((float)node.scale.at(0), (float)node.scale.at(1), (float)node.scale.at(2)) : glm::vec3(1.0f));
+				joint.rotation    = (node.rotation.size()    > 0 ? glm::quat((float)node.rotation.at(3), (float)node.rotation.at(0), (float)node.rotation.at(1), (float)node.rotation.at(2)) : glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+			}
+		}
+
+		// Joints in the new order and weights that add up to one.
+		data.joi = VioletDataInfo();
+		data.wei = VioletDataInfo();
+		for (const int& a : memory.joi)
+		{
+			Vector<float> joints = getFloats(model, a);
+			for (float& joint : joints)
+				joint = (uint32_t)joint < count ? (float)remap[(uint32_t)joint] : 0.0f;
+			data.joi.segments.push_back({ data.joi.data.size(), joints.size() / 4u, sizeof(glm::vec4) });
+			data.joi.data.insert(data.joi.data.end(), (const unsigned char*)joints.data(), (const unsigned char*)(joints.data() + joints.size()));
+		}
+		for (const int& a : memory.wei)
+		{
+			Vector<float> weights = getFloats(model, a);
+			for (size_t i = 0; i + 4u <= weights.size(); i += 4u)
+			{
+				const float total = weights[i] + weights[i + 1u] + weights[i + 2u] + weights[i + 3u];
+				if (total > 0.0f)
+					for (size_t k = 0; k < 4u; ++k)
+						weights[i + k] /= total;
+			}
+			data.wei.segments.push_back({ data.wei.data.size(), weights.size() / 4u, sizeof(glm::vec4) });
+			data.wei.data.insert(data.wei.data.end(), (const unsigned char*)weights.data(), (const unsigned char*)(weights.data() + weights.size()));
+		}
+
+		for (uint32_t a = 0u; a < (uint32_t)model.animations.size(); ++a)
+		{
+			const tinygltf::Animation& animation = model.animations[a];
+			Vector<VioletAnimationCompressor::Curve> curves;
+			for (const tinygltf::AnimationChannel& channel : animation.channels)
+			{
+				const auto it = node_to_joint.find(channel.target_node);
+				if (it == node_to_joint.end() || channel.sampler < 0 || channel.sampler >= (int)animation.samplers.size())
+					continue;
+
+				VioletAnimationCompressor::Curve curve;
+				curve.joint = remap[it->second];
+				if (channel.target_path == "translation")
+					curve.path = VioletAnimationCompressor::Curve::Path::kTranslation;
+				else if (channel.target_path == "rotation")
+					curve.path = VioletAnimationCompressor::Curve::Path::kRotation;
+				else if (channel.target_path == "scale")
+					curve.path = VioletAnimationCompressor::Curve::Path::kScale;
+				else
+					continue; // Morph target weights.
+
+				const tinygltf::AnimationSampler& sampler = animation.samplers[channel.sampler];
+				if (sampler.interpolation == "STEP")
+					curve.interpolation = VioletAnimationCompressor::Curve::Interpolation::kStep;
+				else if (sampler.interpolation == "CUBICSPLINE")
+					curve.interpolation = VioletAnimationCompressor::Curve::Interpolation::kCubicSpline;
+
+				const Vector<float> times  = getFloats(model, sampler.input);
+				const Vector<float> values = getFloats(model, sampler.output);
+				const size_t components = curve.path == VioletAnimationCompressor::Curve::Path::kRotation ? 4u : 3u;
+				curve.times = times;
+				for (size_t i = 0; i + components <= values.size(); i += components)
+					curve.values.push_back(glm::vec4(values[i], values[i + 1u], values[i + 2u], components == 4u ? values[i + 3u] : 0.0f));
+
+				const size_t keys = curve.interpolation == VioletAnimationCompressor::Curve::Interpolation::kCubicSpline ? curve.times.size() * 3u : curve.times.size();
+				if (curve.times.empty() || curve.values.size() != keys)
+				{
+					foundation::Warning("MeshIO: Animation " + toString(a) + " has a channel with mismatching keys\n");
+					continue;
+				}
+				curves.push_back(eastl::move(curve));
+			}
+
+			if (!curves.empty())
+				data.clips.push_back(VioletAnimationCompressor::Compress(animation.name.empty() ? "clip_" + toString(a) : lmbString(animation.name), data.joints, curves, frame_rate, stats));
+		}
+	}
+
 	void removeAllTextures(const String& base_path, const String& file_name)
 	{
 		int texture_index = 0;
@@ -596,14 +779,73 @@ namespace lambda
 	VioletMeshCompiler::VioletMeshCompiler() :
 		VioletMeshManager()
 	{
+		// Meshes are built once and loaded often, so spend the time on a better ratio.
+		SetCompression(VioletCompression::kLZ4HC);
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	bool VioletMeshCompiler::Compile(MeshCompileInfo mesh_info)
 	{
-		VioletMesh mesh = loadMeshGLTF(mesh_info.file);
+		VioletAnimationCompressor::Stats animation_stats;
+		VioletMesh mesh = loadMeshGLTF(mesh_info.file, mesh_info.animation_frame_rate, animation_stats);
 		mesh.hash = GetHash(mesh_info.file);
 		mesh.file = mesh_info.file;
+
+		// The simplifier and the impostor baker work on the float positions, so quantizing comes last.
+		VioletMeshOptimizer::Stats stats;
+		if (mesh_info.optimize)
+			stats = VioletMeshOptimizer::Optimize(mesh, 0u);
+
+		if (!mesh_info.lod_ratios.empty())
+		{
+			const VioletMeshSimplifier::Stats lod_stats = VioletMeshSimplifier::GenerateLODs(mesh, mesh_info.lod_ratios, mesh_info.lod_max_error);
+			for (uint32_t level = 0u; level < (uint32_t)lod_stats.levels.size(); ++level)
+			{
+				const VioletMeshSimplifier::Level& lod = lod_stats.levels[level];
+				foundation::Info("\tLOD" + toString(level + 1u) + ": " + toString(lod.triangles) + " triangles (" +
+					toString(lod_stats.triangles > 0u ? lod.triangles * 100u / lod_stats.triangles : 0u) + "%), error " + toString(lod.error * 100.0f) + "%\n");
+			}
+			foundation::Info("\tLODs took " + toString((uint32_t)lod_stats.time) + "ms\n");
+		}
+
+		// Only reorders the triangles within a list, so the LODs and impostors do not care.
+		if (mesh_info.cluster_max_triangles > 0u)
+		{
+			const VioletMeshClusterizer::Stats cluster_stats = VioletMeshClusterizer::Build(mesh, mesh_info.cluster_max_vertices, mesh_info.cluster_max_triangles, mesh_info.cluster_min_triangles, mesh_info.cluster_cone_weight);
+			if (cluster_stats.clusters > 0u)
+				foundation::Info("\tClusters: " + toString(cluster_stats.clusters) + " in " + toString(cluster_stats.lists) + " lists, " + toString(cluster_stats.vertices) + " vertices and " +
+					toString(cluster_stats.triangles) + " triangles on average, cones cull " + toString(cluster_stats.cone_culled * 100.0f) + "% of " +
+					toString(cluster_stats.back_facing * 100.0f) + "% back facing, took " + toString((uint32_t)cluster_stats.time) + "ms\n");
+		}
+
+		const VioletImpostorBaker::Stats impostor_stats = VioletImpostorBaker::Bake(mesh, mesh_info.impostor_frames, mesh_info.impostor_frame_size);
+		if (impostor_stats.impostors > 0u)
+			foundation::Info("\tImpostors: " + toString(impostor_stats.impostors) + " in a " + toString(impostor_stats.size) + "x" + toString(impostor_stats.size) +
+				" atlas, took " + toString((uint32_t)impostor_stats.time) + "ms\n");
+
+		if (!mesh.data.joints.empty())
+		{
+			foundation::Info("\tAnimation: " + toString((uint32_t)mesh.data.joints.size()) + " joints, " + toString(animation_stats.clips) + " clips, " +
+				toString(animation_stats.constant_tracks) + " of " + toString(animation_stats.tracks) + " tracks constant, " + toString((uint32_t)(animation_stats.bytes_before / 1024u)) + "KB -> " +
+				toString((uint32_t)(animation_stats.bytes_after / 1024u)) + "KB, error " + toString(animation_stats.translation_error) + " units and " + toString(animation_stats.rotation_error) +
+				" degrees, took " + toString((uint32_t)animation_stats.time) + "ms\n");
+
+			const VioletAnimationCompressor::Benchmark benchmark = VioletAnimationCompressor::Measure(mesh.data, mesh_info.animation_benchmark_characters, VioletAnimationCompressor::kBenchmarkFrames);
+			if (benchmark.characters > 0u)
+				foundation::Info("\tPosing " + toString(benchmark.characters) + " characters took " + toString((float)benchmark.frame_time) + "ms per frame on one thread (" +
+					toString((float)(benchmark.frame_time * 1000.0 / benchmark.characters)) + "us each)\n");
+		}
+
+		if (mesh_info.quantize != 0u)
+			Quantize(mesh, mesh_info.quantize);
+
+		if (mesh_info.optimize)
+		{
+			stats.bytes_after = VioletMeshOptimizer::GetStreamSize(mesh.data);
+			foundation::Info("\t" + toString(stats.triangles) + " triangles, ACMR " + toString(stats.acmr_before) + " -> " + toString(stats.acmr_after) +
+				", " + toString(stats.bytes_before / 1024u) + "KB -> " + toString(stats.bytes_after / 1024u) + "KB\n");
+		}
+
 		AddMesh(mesh);
 
 		return true;
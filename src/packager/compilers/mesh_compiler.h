@@ -6,11 +6,36 @@ namespace lambda
   struct MeshCompileInfo
   {
     String file;
+    bool optimize = true;
+    // Streams to quantize, see kMeshQuantized*.
+    uint32_t quantize = kMeshQuantizedAll;
+    // Triangles every LOD keeps of the full detail mesh, empty for no LODs.
+    Vector<float> lod_ratios = { 0.5f, 0.25f, 0.125f };
+    // LODs stop reducing at this error, relative to the size of the sub mesh.
+    float lod_max_error = 0.02f;
+    // Views per side of the octahedral impostor, zero for no impostor.
+    uint32_t impostor_frames = 8u;
+    // Width and height of a single view in texels.
+    uint32_t impostor_frame_size = 64u;
+    // Size of the culling clusters of the triangle lists, zero triangles for no clusters.
+    uint32_t cluster_max_vertices = 64u;
+    uint32_t cluster_max_triangles = 124u;
+    // Smaller triangle lists are culled as a whole.
+    uint32_t cluster_min_triangles = 1024u;
+    // Trades compact clusters (0) for tight normal cones (1).
+    float cluster_cone_weight = 0.25f;
+    // Animation clips are resampled at this rate before they are compressed.
+    float animation_frame_rate = 30.0f;
+    // Characters posing is timed with when the mesh is skinned, zero to skip it.
+    uint32_t animation_benchmark_characters = 512u;
   };
 
   class VioletMeshCompiler : public VioletMeshManager
   {
   public:
+    // Bump together with any change to the optimizer, the simplifier, the clusterizer, the impostor baker, the animation compressor or the quantization.
+    static constexpr uint32_t kVersion = 6u;
+
     VioletMeshCompiler();
     bool Compile(MeshCompileInfo mesh_info);
   };
@@ -0,0 +1,308 @@
+#include "mesh_optimizer.h"
+#include <utils/console.h>
+#include <cmath>
+
+namespace lambda
+{
+	namespace
+	{
+		static constexpr int kTriangleList = 4; // GLTF primitive mode.
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		float vertexScore(int cache_position, uint32_t remaining_triangles)
+		{
+			if (remaining_triangles == 0u)
+				return -1.0f;
+
+			float score = 0.0f;
+			if (cache_position >= 0)
+			{
+				// The last triangle is still in the cache, using it does not favor any of its vertices.
+				if (cache_position < 3)
+					score = 0.75f;
+				else
+					score = std::pow(1.0f - (float)(cache_position - 3) / (float)(VioletMeshOptimizer::kCacheSize - 3u), 1.5f);
+			}
+
+			// Finish off vertices with only a few triangles left.
+			return score + 2.0f / std::sqrt((float)remaining_triangles);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		void remapSegment(VioletDataInfo& info, int segment, const Vector<uint32_t>& remap)
+		{
+			if (segment < 0)
+				return;
+
+			const VioletDataSegment& s = info.segments[segment];
+			LMB_ASSERT(s.count == remap.size(), "[MESH] Vertex streams of a sub mesh have different sizes");
+
+			Vector<unsigned char> data(s.count * s.stride);
+			for (size_t i = 0u; i < s.count; ++i)
+				memcpy(data.data() + remap[i] * s.stride, info.data.data() + s.offset + i * s.stride, s.stride);
+			memcpy(info.data.data() + s.offset, data.data(), data.size());
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	size_t VioletMeshOptimizer::GetStreamSize(const VioletMeshData& data)
+	{
+		return data.pos.data.size() + data.nor.data.size() + data.tan.data.size() + data.col.data.size() +
+			data.tex.data.size() + data.joi.data.size() + data.wei.data.size() + data.idx.data.size();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	void VioletMeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t index_count, size_t vertex_count)
+	{
+		const size_t triangle_count = index_count / 3u;
+		if (triangle_count == 0u)
+			return;
+
+		// Triangles per vertex.
+		Vector<uint32_t> remaining(vertex_count, 0u);
+		for (size_t i = 0u; i < triangle_count * 3u; ++i)
+			remaining[indices[i]]++;
+
+		Vector<uint32_t> adjacency_offset(vertex_count + 1u, 0u);
+		for (size_t v = 0u; v < vertex_count; ++v)
+			adjacency_offset[v + 1u] = adjacency_offset[v] + remaining[v];
+
+		Vector<uint32_t> adjacency(triangle_count * 3u);
+		{
+			Vector<uint32_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+			for (size_t i = 0u; i < triangle_count * 3u; ++i)
+				adjacency[fill[indices[i]]++] = (uint32_t)(i / 3u);
+		}
+
+		Vector<int>   cache_position(vertex_count, -1);
+		Vector<float> vertex_scores(vertex_count);
+		for (size_t v = 0u; v < vertex_count; ++v)
+			vertex_scores[v] = vertexScore(-1, remaining[v]);
+
+		Vector<float> triangle_scores(triangle_count);
+		Vector<bool>  emitted(triangle_count, false);
+		for (size_t t = 0u; t < triangle_count; ++t)
+			triangle_scores[t] = vertex_scores[indices[t * 3u]] + vertex_scores[indices[t * 3u + 1u]] + vertex_scores[indices[t * 3u + 2u]];
+
+		Vector<uint32_t> output(triangle_count * 3u);
+		Vector<uint32_t> cache;
+		Vector<uint32_t> next_cache;
+		cache.reserve(kCacheSize + 3u);
+		next_cache.reserve(kCacheSize + 3u);
+
+		size_t best = 0u;
+		for (size_t t = 1u; t < triangle_count; ++t)
+			if (triangle_scores[t] > triangle_scores[best])
+				best = t;
+		size_t scan = 0u;
+
+		for (size_t emitted_count = 0u; emitted_count < triangle_count; ++emitted_count)
+		{
+			emitted[best] = true;
+			const uint32_t* triangle = indices + best * 3u;
+			memcpy(output.data() + emitted_count * 3u, triangle, sizeof(uint32_t) * 3u);
+
+			// Most recently used vertices go to the front, everything past the cache size falls out.
+			next_cache.clear();
+			for (uint32_t i = 0u; i < 3u; ++i)
+			{
+				next_cache.push_back(triangle[i]);
+				remaining[triangle[i]]--;
+			}
+			for (uint32_t v : cache)
+				if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+					next_cache.push_back(v);
+
+			for (uint32_t i = 0u; i < next_cache.size(); ++i)
+			{
+				const uint32_t v = next_cache[i];
+				cache_position[v] = i < kCacheSize ? (int)i : -1;
+				vertex_scores[v] = vertexScore(cache_position[v], remaining[v]);
+			}
+			if (next_cache.size() > kCacheSize)
+				next_cache.resize(kCacheSize);
+			cache.swap(next_cache);
+
+			// Only triangles touching the cache changed score, the best next triangle is most likely one of them.
+			float best_score = -1.0f;
+			for (uint32_t v : cache)
+			{
+				for (uint32_t a = adjacency_offset[v]; a < adjacency_offset[v + 1u]; ++a)
+				{
+					const uint32_t t = adjacency[a];
+					if (emitted[t])
+						continue;
+
+					const uint32_t* other = indices + t * 3u;
+					triangle_scores[t] = vertex_scores[other[0]] + vertex_scores[other[1]] + vertex_scores[other[2]];
+					if (triangle_scores[t] > best_score)
+					{
+						best_score = triangle_scores[t];
+						best = t;
+					}
+				}
+			}
+
+			// Nothing left around the cache, continue with the next unused triangle.
+			if (best_score < 0.0f)
+			{
+				while (scan < triangle_count && emitted[scan])
+					scan++;
+				best = scan;
+			}
+		}
+
+		memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	void VioletMeshOptimizer::OptimizeVertexFetch(uint32_t* indices, size_t index_count, size_t vertex_count, Vector<uint32_t>& remap)
+	{
+		static constexpr uint32_t kUnused = ~0u;
+		remap.assign(vertex_count, kUnused);
+
+		uint32_t next = 0u;
+		for (size_t i = 0u; i < index_count; ++i)
+		{
+			uint32_t& v = remap[indices[i]];
+			if (v == kUnused)
+				v = next++;
+			indices[i] = v;
+		}
+
+		// Unreferenced vertices are kept at the end so every stream keeps its size.
+		for (uint32_t& v : remap)
+			if (v == kUnused)
+				v = next++;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	float VioletMeshOptimizer::ComputeACMR(const uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size)
+	{
+		if (index_count < 3u)
+			return 0.0f;
+
+		// Every vertex stores when it entered the FIFO, it is a hit while fewer than cache_size vertices came after it.
+		Vector<size_t> inserted(vertex_count, 0u);
+		size_t misses = 0u;
+		for (size_t i = 0u; i < index_count; ++i)
+		{
+			const uint32_t v = indices[i];
+			if (inserted[v] == 0u || misses + 1u - inserted[v] > cache_size)
+				inserted[v] = ++misses;
+		}
+
+		return (float)misses / (float)(index_count / 3u);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	VioletMeshOptimizer::Stats VioletMeshOptimizer::Optimize(VioletMesh& mesh, uint32_t quantize)
+	{
+		static constexpr int kShared = -2;
+
+		Stats stats;
+		stats.bytes_before = GetStreamSize(mesh.data);
+
+		// Index segment that uses a vertex segment, or kShared if there are more.
+		struct Users
+		{
+			Vector<int> pos, nor, tan, col, tex, joi, wei;
+		} users;
+		users.pos.assign(mesh.data.pos.segments.size(), -1);
+		users.nor.assign(mesh.data.nor.segments.size(), -1);
+		users.tan.assign(mesh.data.tan.segments.size(), -1);
+		users.col.assign(mesh.data.col.segments.size(), -1);
+		users.tex.assign(mesh.data.tex.segments.size(), -1);
+		users.joi.assign(mesh.data.joi.segments.size(), -1);
+		users.wei.assign(mesh.data.wei.segments.size(), -1);
+
+		auto use = [](Vector<int>& segment_users, int segment, int idx) {
+			if (segment < 0)
+				return;
+			int& user = segment_users[segment];
+			user = (user == -1 || user == idx) ? idx : kShared;
+		};
+		// The owning sub mesh of every index segment, or kShared if it can not be reordered.
+		Vector<int> owners(mesh.data.idx.segments.size(), -1);
+		for (int i = 0; i < (int)mesh.meshes.size(); ++i)
+		{
+			const VioletSubMesh& sub_mesh = mesh.meshes[i];
+			if (sub_mesh.idx < 0)
+				continue;
+
+			int& owner = owners[sub_mesh.idx];
+			const bool same_vertices = owner >= 0 && mesh.meshes[owner].pos == sub_mesh.pos;
+			owner = (sub_mesh.topology != kTriangleList || sub_mesh.pos < 0 || (owner != -1 && !same_vertices)) ? kShared : (owner == -1 ? i : owner);
+
+			use(users.pos, sub_mesh.pos, sub_mesh.idx);
+			use(users.nor, sub_mesh.nor, sub_mesh.idx);
+			use(users.tan, sub_mesh.tan, sub_mesh.idx);
+			use(users.col, sub_mesh.col, sub_mesh.idx);
+			use(users.tex, sub_mesh.tex, sub_mesh.idx);
+			use(users.joi, sub_mesh.joi, sub_mesh.idx);
+			use(users.wei, sub_mesh.wei, sub_mesh.idx);
+		}
+
+		size_t misses_before = 0u;
+		size_t misses_after  = 0u;
+		Vector<uint32_t> remap;
+		for (int idx = 0; idx < (int)owners.size(); ++idx)
+		{
+			if (owners[idx] < 0)
+				continue;
+
+			const VioletSubMesh& sub_mesh = mesh.meshes[owners[idx]];
+			const VioletDataSegment& segment = mesh.data.idx.segments[idx];
+			uint32_t* indices = (uint32_t*)(mesh.data.idx.data.data() + segment.offset);
+			const size_t index_count  = segment.count - segment.count % 3u;
+			const size_t vertex_count = mesh.data.pos.segments[sub_mesh.pos].count;
+
+			bool valid = true;
+			for (size_t i = 0u; i < index_count && valid; ++i)
+				valid = indices[i] < vertex_count;
+			if (!valid)
+			{
+				foundation::Error("[MESH] " + mesh.file + " has indices outside of its vertices, skipped optimizing it\n");
+				continue;
+			}
+
+			const size_t triangles = index_count / 3u;
+			stats.triangles += triangles;
+			misses_before += (size_t)(ComputeACMR(indices, index_count, vertex_count) * triangles + 0.5f);
+
+			OptimizeVertexCache(indices, index_count, vertex_count);
+			misses_after += (size_t)(ComputeACMR(indices, index_count, vertex_count) * triangles + 0.5f);
+
+			// Vertices can only move if no other index segment points at them.
+			const bool owns_vertices =
+				users.pos[sub_mesh.pos] == idx &&
+				(sub_mesh.nor < 0 || users.nor[sub_mesh.nor] == idx) &&
+				(sub_mesh.tan < 0 || users.tan[sub_mesh.tan] == idx) &&
+				(sub_mesh.col < 0 || users.col[sub_mesh.col] == idx) &&
+				(sub_mesh.tex < 0 || users.tex[sub_mesh.tex] == idx) &&
+				(sub_mesh.joi < 0 || users.joi[sub_mesh.joi] == idx) &&
+				(sub_mesh.wei < 0 || users.wei[sub_mesh.wei] == idx);
+			if (!owns_vertices)
+				continue;
+
+			OptimizeVertexFetch(indices, index_count, vertex_count, remap);
+			remapSegment(mesh.data.pos, sub_mesh.pos, remap);
+			remapSegment(mesh.data.nor, sub_mesh.nor, remap);
+			remapSegment(mesh.data.tan, sub_mesh.tan, remap);
+			remapSegment(mesh.data.col, sub_mesh.col, remap);
+			remapSegment(mesh.data.tex, sub_mesh.tex, remap);
+			remapSegment(mesh.data.joi, sub_mesh.joi, remap);
+			remapSegment(mesh.data.wei, sub_mesh.wei, remap);
+		}
+
+		if (stats.triangles > 0u)
+		{
+			stats.acmr_before = (float)misses_before / (float)stats.triangles;
+			stats.acmr_after  = (float)misses_after  / (float)stats.triangles;
+		}
+
+		VioletMeshManager::Quantize(mesh, quantize);
+		stats.bytes_after = GetStreamSize(mesh.data);
+		return stats;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <assets/mesh_manager.h>
+
+namespace lambda
+{
+  // Reorders and shrinks the mesh data so the GPU does less work per triangle.
+  class VioletMeshOptimizer
+  {
+  public:
+    // Size of the simulated post transform cache.
+    static constexpr uint32_t kCacheSize = 16u;
+
+    struct Stats
+    {
+      size_t triangles    = 0u;
+      float  acmr_before  = 0.0f; // Average cache miss ratio, transformed vertices per triangle.
+      float  acmr_after   = 0.0f;
+      size_t bytes_before = 0u;
+      size_t bytes_after  = 0u;
+    };
+
+    // Optimizes the index order of all triangle lists, reorders the vertices
+    // of sub meshes that do not share their vertex data and quantizes the
+    // requested streams (see kMeshQuantized*).
+    static Stats Optimize(VioletMesh& mesh, uint32_t quantize);
+
+    // Forsyth's linear speed vertex cache optimization.
+    static void OptimizeVertexCache(uint32_t* indices, size_t index_count, size_t vertex_count);
+    // Renumbers the vertices in order of first use. remap[old] = new.
+    static void OptimizeVertexFetch(uint32_t* indices, size_t index_count, size_t vertex_count, Vector<uint32_t>& remap);
+    // Simulates a FIFO cache of cache_size entries.
+    static float ComputeACMR(const uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size = kCacheSize);
+    // Bytes of all vertex and index streams.
+    static size_t GetStreamSize(const VioletMeshData& data);
+  };
+}
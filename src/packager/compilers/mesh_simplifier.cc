@@ -0,0 +1,446 @@
+#include "mesh_simplifier.h"
+#include "mesh_optimizer.h"
+#include <pipeline/build_graph.h>
+#include <utils/console.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+
+namespace lambda
+{
+	namespace
+	{
+		static constexpr int kTriangleList = 4; // GLTF primitive mode.
+		static constexpr uint32_t kNone = ~0u;
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Sum of the squared distances to the planes of the triangles around a
+		// vertex, weighted by their area. Divided by the weight it is the mean
+		// squared distance of a point to the original surface.
+		struct Quadric
+		{
+			double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+			double b0  = 0.0, b1  = 0.0, b2  = 0.0;
+			double c   = 0.0;
+			double w   = 0.0;
+
+			void addPlane(const glm::dvec3& n, double d, double weight)
+			{
+				a00 += weight * n.x * n.x; a01 += weight * n.x * n.y; a02 += weight * n.x * n.z;
+				a11 += weight * n.y * n.y; a12 += weight * n.y * n.z; a22 += weight * n.z * n.z;
+				b0  += weight * n.x * d;   b1  += weight * n.y * d;   b2  += weight * n.z * d;
+				c   += weight * d * d;
+				w   += weight;
+			}
+			void add(const Quadric& other)
+			{
+				a00 += other.a00; a01 += other.a01; a02 += other.a02;
+				a11 += other.a11; a12 += other.a12; a22 += other.a22;
+				b0  += other.b0;  b1  += other.b1;  b2  += other.b2;
+				c   += other.c;
+				w   += other.w;
+			}
+			double eval(const glm::vec3& p) const
+			{
+				const double x = p.x, y = p.y, z = p.z;
+				const double e =
+					a00 * x * x + a11 * y * y + a22 * z * z +
+					2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+					2.0 * (b0 * x + b1 * y + b2 * z) + c;
+				return std::max(e, 0.0);
+			}
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Squared error of moving from onto to, both quadrics end up in to.
+		double collapseError(const Quadric& from, const Quadric& to, const glm::vec3& p)
+		{
+			const double w = from.w + to.w;
+			return w > 0.0 ? (from.eval(p) + to.eval(p)) / w : 0.0;
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		bool lessPosition(const glm::vec3& a, const glm::vec3& b)
+		{
+			if (a.x != b.x) return a.x < b.x;
+			if (a.y != b.y) return a.y < b.y;
+			return a.z < b.z;
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Vertices that can not move without tearing the surface: the ones on
+		// an open or non manifold edge, and the ones that share their position
+		// with another vertex (uv seams, hard edges), as the copies would be
+		// collapsed apart from each other.
+		Vector<bool> findLockedVertices(const VioletMeshSimplifier::PositionView& positions, const Vector<uint32_t>& indices)
+		{
+			const size_t vertex_count = positions.count;
+			Vector<bool> locked(vertex_count, false);
+
+			Vector<uint32_t> order(vertex_count);
+			for (size_t i = 0u; i < vertex_count; ++i)
+				order[i] = (uint32_t)i;
+			std::sort(order.begin(), order.end(), [&positions](uint32_t a, uint32_t b) {
+				return lessPosition(positions[a], positions[b]);
+			});
+
+			Vector<uint32_t> welded(vertex_count);
+			for (size_t i = 0u; i < vertex_count; ++i)
+			{
+				const bool same = i > 0u && positions[order[i]] == positions[order[i - 1u]];
+				welded[order[i]] = same ? welded[order[i - 1u]] : order[i];
+				if (same)
+					locked[order[i]] = locked[welded[order[i]]] = true;
+			}
+
+			// Directed edges of the welded surface, every edge of a closed manifold has exactly one opposite.
+			Vector<uint64_t> edges;
+			edges.reserve(indices.size());
+			for (size_t i = 0u; i < indices.size(); i += 3u)
+			{
+				for (uint32_t e = 0u; e < 3u; ++e)
+				{
+					const uint64_t a = welded[indices[i + e]];
+					const uint64_t b = welded[indices[i + (e + 1u) % 3u]];
+					edges.push_back((a << 32u) | b);
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+
+			for (size_t i = 0u; i < edges.size(); ++i)
+			{
+				const uint32_t a = (uint32_t)(edges[i] >> 32u);
+				const uint32_t b = (uint32_t)(edges[i] & 0xffffffffu);
+				const uint64_t opposite = ((uint64_t)b << 32u) | a;
+
+				const bool duplicate = (i > 0u && edges[i - 1u] == edges[i]) || (i + 1u < edges.size() && edges[i + 1u] == edges[i]);
+				const auto it = std::lower_bound(edges.begin(), edges.end(), opposite);
+				if (duplicate || it == edges.end() || *it != opposite)
+					locked[a] = locked[b] = true;
+			}
+
+			// Welded vertices stand for all vertices at their position.
+			for (size_t i = 0u; i < vertex_count; ++i)
+				if (locked[welded[i]])
+					locked[i] = true;
+
+			return locked;
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		void buildAdjacency(const Vector<uint32_t>& indices, size_t vertex_count, Vector<uint32_t>& offsets, Vector<uint32_t>& triangles)
+		{
+			offsets.assign(vertex_count + 1u, 0u);
+			for (uint32_t v : indices)
+				offsets[v + 1u]++;
+			for (size_t v = 0u; v < vertex_count; ++v)
+				offsets[v + 1u] += offsets[v];
+
+			triangles.resize(indices.size());
+			Vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0u; i < indices.size(); ++i)
+				triangles[fill[indices[i]]++] = (uint32_t)(i / 3u);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Moving from onto to may not turn any of the remaining triangles around from over.
+		bool flipsTriangles(const VioletMeshSimplifier::PositionView& positions, const Vector<uint32_t>& indices, const uint32_t* adjacency, uint32_t adjacency_count, uint32_t from, uint32_t to)
+		{
+			const glm::vec3 target = positions[to];
+			for (uint32_t a = 0u; a < adjacency_count; ++a)
+			{
+				const uint32_t* triangle = indices.data() + adjacency[a] * 3u;
+				if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+					continue;
+
+				glm::vec3 before[3];
+				glm::vec3 after[3];
+				for (uint32_t i = 0u; i < 3u; ++i)
+				{
+					before[i] = positions[triangle[i]];
+					after[i]  = triangle[i] == from ? target : before[i];
+				}
+
+				const glm::vec3 n_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+				const glm::vec3 n_after  = glm::cross(after[1] - after[0], after[2] - after[0]);
+				if (glm::dot(n_before, n_after) <= 0.0f)
+					return true;
+			}
+			return false;
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	glm::vec3 VioletMeshSimplifier::PositionView::operator[](size_t i) const
+	{
+		glm::vec3 p;
+		memcpy(&p, data + i * stride, sizeof(glm::vec3));
+		return p;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	float VioletMeshSimplifier::Simplify(const PositionView& positions, const uint32_t* indices, size_t index_count, size_t target_index_count, float target_error, Vector<uint32_t>& result)
+	{
+		const size_t vertex_count = positions.count;
+		result.clear();
+		result.reserve(index_count);
+		for (size_t i = 0u; i + 2u < index_count; i += 3u)
+			if (indices[i] != indices[i + 1u] && indices[i] != indices[i + 2u] && indices[i + 1u] != indices[i + 2u])
+				result.insert(result.end(), indices + i, indices + i + 3u);
+
+		const Vector<bool> locked = findLockedVertices(positions, result);
+
+		Vector<Quadric> quadrics(vertex_count);
+		for (size_t i = 0u; i < result.size(); i += 3u)
+		{
+			const glm::dvec3 p0(positions[result[i]]);
+			const glm::dvec3 p1(positions[result[i + 1u]]);
+			const glm::dvec3 p2(positions[result[i + 2u]]);
+			glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+			const double length = glm::length(n);
+			if (length <= 0.0)
+				continue;
+
+			n /= length;
+			for (uint32_t v = 0u; v < 3u; ++v)
+				quadrics[result[i + v]].addPlane(n, -glm::dot(n, p0), length * 0.5);
+		}
+
+		struct Collapse
+		{
+			uint32_t from;
+			uint32_t to;
+			double   error;
+		};
+
+		const double max_error = (double)target_error * (double)target_error;
+		double error = 0.0;
+		Vector<uint32_t> adjacency_offsets;
+		Vector<uint32_t> adjacency;
+		Vector<Collapse> collapses;
+		Vector<uint32_t> remap(vertex_count);
+		Vector<bool>     touched(vertex_count);
+
+		while (result.size() > target_index_count)
+		{
+			buildAdjacency(result, vertex_count, adjacency_offsets, adjacency);
+
+			// The cheapest edge of every vertex that is free to move.
+			collapses.assign(vertex_count, Collapse{ kNone, kNone, DBL_MAX });
+			for (size_t i = 0u; i < result.size(); i += 3u)
+			{
+				for (uint32_t e = 0u; e < 3u; ++e)
+				{
+					const uint32_t a = result[i + e];
+					const uint32_t b = result[i + (e + 1u) % 3u];
+					if (!locked[a])
+					{
+						const double cost = collapseError(quadrics[a], quadrics[b], positions[b]);
+						if (cost < collapses[a].error)
+							collapses[a] = Collapse{ a, b, cost };
+					}
+					if (!locked[b])
+					{
+						const double cost = collapseError(quadrics[b], quadrics[a], positions[a]);
+						if (cost < collapses[b].error)
+							collapses[b] = Collapse{ b, a, cost };
+					}
+				}
+			}
+			collapses.erase(std::remove_if(collapses.begin(), collapses.end(), [max_error](const Collapse& collapse) {
+				return collapse.from == kNone || collapse.error > max_error;
+			}), collapses.end());
+			if (collapses.empty())
+				break;
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+			// Collapses in a pass can not share triangles, so their checks stay valid.
+			for (size_t v = 0u; v < vertex_count; ++v)
+			{
+				remap[v] = (uint32_t)v;
+				touched[v] = false;
+			}
+
+			const size_t triangles_to_remove = (result.size() - target_index_count + 2u) / 3u;
+			size_t removed = 0u;
+			size_t collapsed = 0u;
+			for (const Collapse& collapse : collapses)
+			{
+				if (removed >= triangles_to_remove)
+					break;
+				if (touched[collapse.from] || touched[collapse.to])
+					continue;
+
+				const uint32_t* around = adjacency.data() + adjacency_offsets[collapse.from];
+				const uint32_t around_count = adjacency_offsets[collapse.from + 1u] - adjacency_offsets[collapse.from];
+				if (flipsTriangles(positions, result, around, around_count, collapse.from, collapse.to))
+					continue;
+
+				for (uint32_t a = 0u; a < around_count; ++a)
+				{
+					const uint32_t* triangle = result.data() + around[a] * 3u;
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+						removed++;
+					touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+				}
+
+				remap[collapse.from] = collapse.to;
+				quadrics[collapse.to].add(quadrics[collapse.from]);
+				error = std::max(error, collapse.error);
+				collapsed++;
+			}
+			if (collapsed == 0u)
+				break;
+
+			size_t write = 0u;
+			for (size_t i = 0u; i < result.size(); i += 3u)
+			{
+				const uint32_t a = remap[result[i]];
+				const uint32_t b = remap[result[i + 1u]];
+				const uint32_t c = remap[result[i + 2u]];
+				if (a == b || a == c || b == c)
+					continue;
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+			result.resize(write);
+		}
+
+		return (float)std::sqrt(error);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	VioletMeshSimplifier::Stats VioletMeshSimplifier::GenerateLODs(VioletMesh& mesh, const Vector<float>& ratios, float max_error)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		Stats stats;
+		stats.levels.resize(ratios.size());
+		if (ratios.empty())
+			return stats;
+
+		if (mesh.data.quantized & kMeshQuantizedPositions)
+		{
+			foundation::Error("[MESH] " + mesh.file + " has quantized positions, LODs have to be generated before quantizing\n");
+			return stats;
+		}
+
+		// The vertex segment of every index segment, or -2 if they do not match.
+		Vector<int> vertices(mesh.data.idx.segments.size(), -1);
+		for (const VioletSubMesh& sub_mesh : mesh.meshes)
+		{
+			if (sub_mesh.idx < 0)
+				continue;
+
+			int& pos = vertices[sub_mesh.idx];
+			const bool usable = sub_mesh.topology == kTriangleList && sub_mesh.pos >= 0 && mesh.data.pos.segments[sub_mesh.pos].stride == sizeof(glm::vec3);
+			pos = (!usable || (pos != -1 && pos != sub_mesh.pos)) ? -2 : sub_mesh.pos;
+		}
+
+		struct Segment
+		{
+			int                      idx;
+			PositionView             positions;
+			float                    size;
+			Vector<Vector<uint32_t>> levels;
+			Vector<float>            errors;
+		};
+		Vector<Segment> segments;
+		for (int idx = 0; idx < (int)vertices.size(); ++idx)
+		{
+			if (vertices[idx] < 0)
+				continue;
+
+			const VioletDataSegment& vertex_segment = mesh.data.pos.segments[vertices[idx]];
+			const VioletDataSegment& index_segment  = mesh.data.idx.segments[idx];
+			const uint32_t* indices = (const uint32_t*)(mesh.data.idx.data.data() + index_segment.offset);
+
+			Segment segment;
+			segment.idx              = idx;
+			segment.positions.data   = mesh.data.pos.data.data() + vertex_segment.offset;
+			segment.positions.stride = vertex_segment.stride;
+			segment.positions.count  = vertex_segment.count;
+
+			bool valid = index_segment.stride == sizeof(uint32_t);
+			for (size_t i = 0u; i < index_segment.count && valid; ++i)
+				valid = indices[i] < vertex_segment.count;
+			if (!valid)
+			{
+				foundation::Error("[MESH] " + mesh.file + " has indices outside of its vertices, skipped its LODs\n");
+				continue;
+			}
+
+			glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+			for (size_t i = 0u; i < index_segment.count; ++i)
+			{
+				min = glm::min(min, segment.positions[indices[i]]);
+				max = glm::max(max, segment.positions[indices[i]]);
+			}
+			segment.size = index_segment.count > 0u ? glm::length(max - min) : 0.0f;
+
+			segment.levels.resize(ratios.size());
+			segment.errors.resize(ratios.size(), 0.0f);
+			stats.triangles += index_segment.count / 3u;
+			segments.push_back(eastl::move(segment));
+		}
+
+		// Every level starts from the full detail mesh, so its error is measured against the original.
+		VioletBuildGraph graph;
+		for (Segment& segment : segments)
+		{
+			const VioletDataSegment& index_segment = mesh.data.idx.segments[segment.idx];
+			const uint32_t* indices = (const uint32_t*)(mesh.data.idx.data.data() + index_segment.offset);
+			const size_t triangle_count = index_segment.count / 3u;
+
+			for (uint32_t level = 0u; level < (uint32_t)ratios.size(); ++level)
+			{
+				const size_t target = (size_t)((float)triangle_count * ratios[level]) * 3u;
+				graph.AddJob(mesh.file, [&segment, indices, index_segment, target, level, max_error]() {
+					segment.errors[level] = Simplify(segment.positions, indices, index_segment.count, target, max_error * segment.size, segment.levels[level]);
+					VioletMeshOptimizer::OptimizeVertexCache(segment.levels[level].data(), segment.levels[level].size(), segment.positions.count);
+					return true;
+				});
+			}
+		}
+		graph.Run();
+
+		for (Segment& segment : segments)
+		{
+			size_t previous = mesh.data.idx.segments[segment.idx].count;
+			for (uint32_t level = 0u; level < (uint32_t)ratios.size(); ++level)
+			{
+				const Vector<uint32_t>& indices = segment.levels[level];
+				const size_t count = indices.size();
+				// The runtime keeps drawing the previous level in place of a dropped one.
+				if (count == 0u || (float)count > (float)previous * (1.0f - kMinLevelReduction))
+				{
+					stats.levels[level].triangles += previous / 3u;
+					continue;
+				}
+				previous = count;
+
+				VioletDataSegment lod_segment;
+				lod_segment.offset = mesh.data.idx.data.size();
+				lod_segment.count  = count;
+				lod_segment.stride = sizeof(uint32_t);
+				mesh.data.idx.data.insert(mesh.data.idx.data.end(), (const unsigned char*)indices.data(), (const unsigned char*)(indices.data() + count));
+				mesh.data.idx.segments.push_back(lod_segment);
+
+				VioletMeshLOD lod;
+				lod.base  = segment.idx;
+				lod.idx   = (int)mesh.data.idx.segments.size() - 1;
+				lod.error = segment.errors[level];
+				mesh.data.lods.push_back(lod);
+
+				stats.levels[level].triangles += count / 3u;
+				if (segment.size > 0.0f)
+					stats.levels[level].error = std::max(stats.levels[level].error, lod.error / segment.size);
+			}
+		}
+
+		stats.time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return stats;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <assets/mesh_manager.h>
+
+namespace lambda
+{
+	// Builds lower detail versions of the triangle lists of a mesh. Vertices are
+	// only collapsed onto one of their neighbours, so a level is just another
+	// index segment that uses the vertex streams of the full detail mesh.
+	class VioletMeshSimplifier
+	{
+	public:
+		// Levels that remove less than this part of the previous level are dropped.
+		static constexpr float kMinLevelReduction = 0.1f;
+
+		// Reads the positions straight out of a vertex stream.
+		struct PositionView
+		{
+			const unsigned char* data   = nullptr;
+			size_t               stride = 0u;
+			size_t               count  = 0u;
+
+			glm::vec3 operator[](size_t i) const;
+		};
+
+		struct Level
+		{
+			size_t triangles = 0u;
+			float  error     = 0.0f; // Largest error of all segments, relative to the size of the segment.
+		};
+
+		struct Stats
+		{
+			size_t        triangles = 0u; // Of the full detail meshes.
+			Vector<Level> levels;
+			double        time = 0.0;     // Milliseconds.
+		};
+
+		// Adds a level per ratio (triangles to keep) to every triangle list. A
+		// level stops reducing once the error reaches max_error, relative to
+		// the size of the segment, levels that barely reduce are dropped. The
+		// levels are stored in VioletMeshData::lods.
+		static Stats GenerateLODs(VioletMesh& mesh, const Vector<float>& ratios, float max_error);
+
+		// Collapses edges until there are at most target_index_count indices
+		// left, or until every collapse would move the surface further than
+		// target_error. Returns the error of the result, in the units of the
+		// positions.
+		static float Simplify(const PositionView& positions, const uint32_t* indices, size_t index_count, size_t target_index_count, float target_error, Vector<uint32_t>& result);
+	};
+}
@@ -3,13 +3,17 @@
 #include <utils/console.h>
 #include <utils/utilities.h>
 #include <memory/memory.h>
+#include <assets/binary_header.h>
+#include <cache/build_cache.h>
+#include <pipeline/build_graph.h>
 
 #if VIOLET_SHADER_CONDUCTOR
 #include <ShaderConductor/ShaderConductor.hpp>
 #include <d3d12.h>
 
-static lambda::String kFilePath;
-static lambda::String kFailedMsg = "";
+// Per thread, the builder compiles several shaders at once.
+static thread_local lambda::String kFilePath;
+static thread_local lambda::String kFailedMsg = "";
 
 ///////////////////////////////////////////////////////////////////////////////
 ShaderConductor::Blob* includeCallback(const char* include)
@@ -287,6 +291,95 @@ bool compileHLSL(lambda::String file, lambda::String source, lambda::String perm
 
 namespace lambda
 {
+	namespace
+	{
+		struct ShaderStageInfo
+		{
+			ShaderStages stage;
+			const char*  profile;
+			const char*  entry;
+		};
+
+		const ShaderStageInfo kShaderStages[] = {
+			{ ShaderStages::kVertex,   "vs_5_0", "VS" },
+			{ ShaderStages::kPixel,    "ps_5_0", "PS" },
+			{ ShaderStages::kGeometry, "gs_5_0", "GS" },
+			{ ShaderStages::kCompute,  "cs_5_0", "CS" },
+			{ ShaderStages::kHull,     "hs_5_0", "HS" },
+			{ ShaderStages::kDomain,   "ds_5_0", "DS" },
+		};
+
+		struct ShaderBlobBlock
+		{
+			uint32_t blob_size;
+			uint32_t padding;
+		};
+
+		///////////////////////////////////////////////////////////////////////////
+		bool isIdentifier(char c)
+		{
+			return isalnum((unsigned char)c) || c == '_';
+		}
+
+		///////////////////////////////////////////////////////////////////////////
+		// Looks for "entry(". Names in comments and inactive branches count as
+		// well, those stages are still handed to the compiler, which skips them.
+		bool hasEntryPoint(const String& source, const char* entry)
+		{
+			const eastl_size_t length = (eastl_size_t)strlen(entry);
+			for (eastl_size_t offset = source.find(entry); offset != String::npos; offset = source.find(entry, offset + 1u))
+			{
+				if (offset > 0u && isIdentifier(source[offset - 1u]))
+					continue;
+
+				eastl_size_t end = offset + length;
+				while (end < source.size() && isspace((unsigned char)source[end]))
+					end++;
+				if (end < source.size() && source[end] == '(')
+					return true;
+			}
+			return false;
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// The source of a target with its includes, only used to build the cache
+	// key and to find the entry points. The compilers get the original source.
+	String preprocess(const String& file, const String& source, bool spirv)
+	{
+#if VIOLET_WIN32
+		kFilePath = lambda::FileSystem::RemoveName(file) + "/";
+
+		D3D_SHADER_MACRO macros[] = {
+			{ "VIOLET_SPIRV", spirv ? "1" : "0" },
+			{ nullptr, nullptr },
+		};
+
+		IncludeHandler include_handler;
+		ID3DBlob* blob  = nullptr;
+		ID3DBlob* error = nullptr;
+		HRESULT result = D3DPreprocess(source.data(), source.size(), file.c_str(), macros, &include_handler, &blob, &error);
+		if (error)
+			error->Release();
+
+		if (SUCCEEDED(result) && blob)
+		{
+			String preprocessed((const char*)blob->GetBufferPointer(), (const char*)blob->GetBufferPointer() + blob->GetBufferSize());
+			blob->Release();
+			return preprocessed;
+		}
+
+		// The error is reported when the stages are compiled.
+		if (blob)
+			blob->Release();
+#endif
+		// Without a preprocessor the includes are appended, inactive branches stay in.
+		String preprocessed = "#define VIOLET_SPIRV " + String(spirv ? "1" : "0") + "\n" + source;
+		for (const String& include : VioletShaderCompiler::GetIncludes(file))
+			preprocessed += FileSystem::FileToString(include);
+		return preprocessed;
+	}
+
 	///////////////////////////////////////////////////////////////////////////
 	VioletShaderCompiler::VioletShaderCompiler()
 		: VioletShaderManager()
@@ -298,48 +391,35 @@ namespace lambda
 		const String& file,
 		const String& source,
 		const String& permutation,
-		const String& stage,
-		Array<Vector<char>, VIOLET_LANG_COUNT>& output,
+		const ShaderStageInfo& stage,
+		int lang,
+		Vector<char>& output,
 		Vector<VioletShaderResource>& resources)
 	{
 		kFilePath = lambda::FileSystem::RemoveName(file) + "/";
 		if (source.empty())
 			return false;
 
-		String entry;
-		switch (stage[0])
-		{
-		case 'c': case 'C': entry = "CS"; break;
-		case 'd': case 'D': entry = "DS"; break;
-		case 'g': case 'G': entry = "GS"; break;
-		case 'h': case 'H': entry = "HS"; break;
-		case 'p': case 'P': entry = "PS"; break;
-		case 'v': case 'V': entry = "VS"; break;
-		}
+		const String entry = stage.entry;
 
 #if VIOLET_SHADER_CONDUCTOR
 		ShaderConductor::ShaderStage sc_stage;
-		switch (entry[0])
+		switch (stage.stage)
 		{
-		case 'C': sc_stage = ShaderConductor::ShaderStage::ComputeShader; break;
-		case 'D': sc_stage = ShaderConductor::ShaderStage::DomainShader; break;
-		case 'G': sc_stage = ShaderConductor::ShaderStage::GeometryShader; break;
-		case 'H': sc_stage = ShaderConductor::ShaderStage::HullShader; break;
-		case 'P': sc_stage = ShaderConductor::ShaderStage::PixelShader; break;
-		case 'V': sc_stage = ShaderConductor::ShaderStage::VertexShader; break;
+		case ShaderStages::kCompute:  sc_stage = ShaderConductor::ShaderStage::ComputeShader; break;
+		case ShaderStages::kDomain:   sc_stage = ShaderConductor::ShaderStage::DomainShader; break;
+		case ShaderStages::kGeometry: sc_stage = ShaderConductor::ShaderStage::GeometryShader; break;
+		case ShaderStages::kHull:     sc_stage = ShaderConductor::ShaderStage::HullShader; break;
+		case ShaderStages::kPixel:    sc_stage = ShaderConductor::ShaderStage::PixelShader; break;
+		default:                      sc_stage = ShaderConductor::ShaderStage::VertexShader; break;
 		}
 
-		ShaderConductor::MacroDefine defines[VIOLET_LANG_COUNT][1] = {
-			{ { "VIOLET_SPIRV", "0" } },
-			{ { "VIOLET_SPIRV", "0" } },
-			{ { "VIOLET_SPIRV", "0" } },
-			{ { "VIOLET_SPIRV", "0" } },
+		ShaderConductor::MacroDefine defines[1] = {
+			{ "VIOLET_SPIRV", lang == VIOLET_SPIRV ? "1" : "0" },
 		};
 
-		defines[VIOLET_SPIRV][0].value = "1";
-
 		ShaderConductor::Compiler::SourceDesc source_desc;
-		source_desc.defines = nullptr;
+		source_desc.defines = defines;
 		source_desc.entryPoint = entry.c_str();
 		source_desc.fileName = file.c_str();
 		source_desc.loadIncludeCallback = includeCallback;
@@ -356,87 +436,81 @@ namespace lambda
 		options.shaderModel.major_ver = 6;
 		options.shaderModel.minor_ver = 0;
 
-		ShaderConductor::Compiler::TargetDesc target_descs[VIOLET_LANG_COUNT];
-		target_descs[VIOLET_DXIL].language  = ShaderConductor::ShadingLanguage::Dxil;
-		target_descs[VIOLET_DXIL].version   = nullptr;
-		target_descs[VIOLET_SPIRV].language = ShaderConductor::ShadingLanguage::SpirV;
-		target_descs[VIOLET_SPIRV].version  = nullptr;
-		target_descs[VIOLET_METAL].language = ShaderConductor::ShadingLanguage::Msl_macOS;
-		target_descs[VIOLET_METAL].version  = nullptr;
-		target_descs[VIOLET_HLSL].language  = ShaderConductor::ShadingLanguage::Hlsl;
-		target_descs[VIOLET_HLSL].version   = "50";
-
-		ShaderConductor::Compiler::ResultDesc results[VIOLET_LANG_COUNT];
-
-		for (int i = 0; i < VIOLET_LANG_COUNT; ++i)
+		ShaderConductor::Compiler::TargetDesc target_desc;
+		switch (lang)
 		{
-			source_desc.defines = defines[i];
+		case VIOLET_DXIL:
+			target_desc.language = ShaderConductor::ShadingLanguage::Dxil;
+			target_desc.version  = nullptr;
+			break;
+		case VIOLET_SPIRV:
+			target_desc.language = ShaderConductor::ShadingLanguage::SpirV;
+			target_desc.version  = nullptr;
+			break;
+		case VIOLET_METAL:
+			target_desc.language = ShaderConductor::ShadingLanguage::Msl_macOS;
+			target_desc.version  = nullptr;
+			break;
+		default:
+			target_desc.language = ShaderConductor::ShadingLanguage::Hlsl;
+			target_desc.version  = "50";
+			break;
+		}
 
-			ShaderConductor::Compiler::Compile(source_desc, options, &target_descs[i], 1, &results[i]);
+		ShaderConductor::Compiler::ResultDesc result;
+		ShaderConductor::Compiler::Compile(source_desc, options, &target_desc, 1, &result);
 
-			if (!kFailedMsg.empty())
-			{
-				foundation::Error(kFailedMsg + "\n");
-				kFailedMsg = "";
-				return false;
-			}
-			/*catch (const std::exception& e)
-			{
-				foundation::Error(String("Could not find file: ") + e.what() + "\n");
-				return false;
-			}*/
+		if (!kFailedMsg.empty())
+		{
+			foundation::Error(kFailedMsg + "\n");
+			kFailedMsg = "";
+			return false;
+		}
 
-			if (results[i].hasError)
-			{
-				String error = String(
-					(char*)results[i].errorWarningMsg->Data(),
-					results[i].errorWarningMsg->Size()
-				);
+		if (result.hasError)
+		{
+			String error = String(
+				(char*)result.errorWarningMsg->Data(),
+				result.errorWarningMsg->Size()
+			);
 
-				if (error == "error: missing entry point definition\n")
-					return true;
+			if (error == "error: missing entry point definition\n")
+				return true;
 
-				String err = "Permutation: " + permutation + " ShaderConductor: Failed to compile shader \"" + file +
-					"\" with message:\n" + error;
+			String err = "Permutation: " + permutation + " ShaderConductor: Failed to compile shader \"" + file +
+				"\" with message:\n" + error;
 
-				foundation::Error(err.c_str());
-				return false;
-			}
+			foundation::Error(err.c_str());
+			return false;
 		}
 
-		for (int i = 0; i < VIOLET_LANG_COUNT; ++i)
+		if (lang != VIOLET_HLSL)
+		{
+			output.resize(result.target->Size());
+			memcpy(output.data(), result.target->Data(), output.size());
+		}
+		else
 		{
-			if (i != VIOLET_HLSL)
-			{
-				output[i].resize(results[i].target->Size());
-				memcpy(output[i].data(), results[i].target->Data(), output[i].size());
-			}
-			else
-			{
 #if VIOLET_WIN32
-				if (!compileHLSL(file, source, permutation, entry, stage, output[i], resources))
-					return false;
+			if (!compileHLSL(file, source, permutation, entry, stage.profile, output, resources))
+				return false;
 #else
-				output[i].resize(source.size());
-				memcpy(output[i].data(), source.c_str(), source.size());
+			output.resize(source.size());
+			memcpy(output.data(), source.c_str(), source.size());
 #endif
-			}
 		}
 #else
-		for (int i = 0; i < VIOLET_LANG_COUNT; ++i)
-		{
 #if VIOLET_WIN32
-			if (i == VIOLET_HLSL)
-			{
-				if (!compileHLSL(file, source, permutation, entry, stage, output[i], resources))
-					return false;
-			}
-			else
+		if (lang == VIOLET_HLSL)
+		{
+			if (!compileHLSL(file, source, permutation, entry, stage.profile, output, resources))
+				return false;
+		}
+		else
 #endif
-			{
-				output[i].resize(source.size());
-				memcpy(output[i].data(), source.c_str(), output[i].size());
-			}
+		{
+			output.resize(source.size());
+			memcpy(output.data(), source.c_str(), output.size());
 		}
 #endif
 		return true;
@@ -445,51 +519,239 @@ namespace lambda
 	///////////////////////////////////////////////////////////////////////////
 	bool VioletShaderCompiler::Compile(ShaderCompileInfo compile_info)
 	{
-		Vector<String> permutations;
-
 		String source = FileSystem::FileToString(compile_info.file);
 		if (source.empty())
 			return false;
 
+		const Vector<String> permutations = GetPermutations(source);
 		if (source[0] == '[') // We found settings!
-		{
-			String settings = source.substr(1, source.find_first_of(']') - 1);
-			source.erase(source.begin(), source.begin() + settings.size() + 2);
-			permutations = split(settings, '|');
-		}
-
-		if (eastl::find(permutations.begin(), permutations.end(), "DEFAULT") == permutations.end())
-			permutations.insert(permutations.begin(), "DEFAULT");
+			source.erase(source.begin(), source.begin() + source.find_first_of(']') + 1);
 
 		String perms;
 
 		for (uint32_t i = 0; i < permutations.size(); ++i)
 			perms += "#define " + permutations[i] + " " + toString(i + 1) + "\n";
 
-		for (const String& permutation : permutations)
+		// Every permutation is a program, shaders that can read quantized meshes
+		// get a second one with VIOLET_QUANTIZED set.
+		struct Program
 		{
-			String perm_source = perms;
-			perm_source += "#define TYPE " + permutation + "\n";
-			perm_source += source;
-
-			VioletShader shader_program;
-			shader_program.file_path = compile_info.file + "|" + permutation;
-			shader_program.hash = GetHash(shader_program.file_path);
-			if (!CompileX(compile_info.file, perm_source, permutation, "vs_5_0", shader_program.blobs[(int)ShaderStages::kVertex], shader_program.resources[(int)ShaderStages::kVertex]))
-				return false;
-			if (!CompileX(compile_info.file, perm_source, permutation, "ps_5_0", shader_program.blobs[(int)ShaderStages::kPixel], shader_program.resources[(int)ShaderStages::kPixel]))
-				return false;
-			if (!CompileX(compile_info.file, perm_source, permutation, "gs_5_0", shader_program.blobs[(int)ShaderStages::kGeometry], shader_program.resources[(int)ShaderStages::kGeometry]))
-				return false;
-			if (!CompileX(compile_info.file, perm_source, permutation, "cs_5_0", shader_program.blobs[(int)ShaderStages::kCompute], shader_program.resources[(int)ShaderStages::kCompute]))
-				return false;
-			if (!CompileX(compile_info.file, perm_source, permutation, "hs_5_0", shader_program.blobs[(int)ShaderStages::kHull], shader_program.resources[(int)ShaderStages::kHull]))
-				return false;
-			if (!CompileX(compile_info.file, perm_source, permutation, "ds_5_0", shader_program.blobs[(int)ShaderStages::kDomain], shader_program.resources[(int)ShaderStages::kDomain]))
+			uint32_t permutation;
+			bool     quantized;
+			String   source;
+		};
+		const bool quantized = source.find("VertexPosition") != String::npos;
+
+		// Every stage of every target of every program is compiled on its
+		// own. Targets that end up with the same preprocessed source, like a
+		// vertex shader that does not look at the permutation, share one compile.
+		struct Blob
+		{
+			uint64_t                     key;
+			uint32_t                     program;
+			uint32_t                     stage;
+			int                          lang;
+			bool                         restored = false;
+			Vector<char>                 output;
+			Vector<VioletShaderResource> resources;
+		};
+		struct Target
+		{
+			uint32_t program;
+			uint32_t stage;
+			int      lang;
+			uint32_t blob;
+		};
+
+		Vector<Program> programs;
+		for (uint32_t p = 0u; p < permutations.size(); ++p)
+		{
+			const String perm_source = perms + "#define TYPE " + permutations[p] + "\n" + source;
+			programs.push_back(Program{ p, false, perm_source });
+			if (quantized)
+				programs.push_back(Program{ p, true, "#define VIOLET_QUANTIZED 1\n" + perm_source });
+		}
+
+		Vector<Blob> blobs;
+		Vector<Target> targets;
+		UnorderedMap<uint64_t, uint32_t> blob_lookup;
+		uint32_t skipped = 0u;
+
+		for (uint32_t p = 0u; p < programs.size(); ++p)
+		{
+			// Only SPIR-V is compiled with VIOLET_SPIRV set.
+			const String preprocessed[2u] = {
+				preprocess(compile_info.file, programs[p].source, false),
+				preprocess(compile_info.file, programs[p].source, true),
+			};
+			const uint64_t source_hashes[2u] = {
+				VioletBuildCache::HashData(preprocessed[0u].data(), preprocessed[0u].size()),
+				VioletBuildCache::HashData(preprocessed[1u].data(), preprocessed[1u].size()),
+			};
+
+			for (uint32_t s = 0u; s < sizeof(kShaderStages) / sizeof(kShaderStages[0u]); ++s)
+			{
+				for (int l = 0; l < VIOLET_LANG_COUNT; ++l)
+				{
+					const uint32_t define_set = l == VIOLET_SPIRV ? 1u : 0u;
+					if (!hasEntryPoint(preprocessed[define_set], kShaderStages[s].entry))
+					{
+						skipped++;
+						continue;
+					}
+
+					uint64_t key = VioletBuildCache::HashData((const char*)&kVersion, sizeof(kVersion));
+					key = VioletBuildCache::HashData(compile_info.file.data(), compile_info.file.size() + 1u, key);
+					key = VioletBuildCache::HashData(kShaderStages[s].profile, strlen(kShaderStages[s].profile), key);
+					key = VioletBuildCache::HashData((const char*)&l, sizeof(l), key);
+					key = VioletBuildCache::HashData((const char*)&source_hashes[define_set], sizeof(uint64_t), key);
+
+					auto it = blob_lookup.find(key);
+					if (it == blob_lookup.end())
+					{
+						Blob blob;
+						blob.key         = key;
+						blob.program     = p;
+						blob.stage       = s;
+						blob.lang        = l;
+						blobs.push_back(blob);
+						it = blob_lookup.insert(eastl::make_pair(key, (uint32_t)blobs.size() - 1u)).first;
+					}
+
+					targets.push_back(Target{ p, s, l, it->second });
+				}
+			}
+		}
+
+		VioletBuildGraph graph;
+		for (uint32_t i = 0u; i < blobs.size(); ++i)
+		{
+			graph.AddJob(compile_info.file, [&, i]() {
+				Blob& blob = blobs[i];
+				Vector<char> data;
+				if (compile_info.cache && compile_info.cache->RestoreBlob(blob.key, data) && DecodeBlob(data, blob.output, blob.resources))
+				{
+					blob.restored = true;
+					return true;
+				}
+
+				const Program& program = programs[blob.program];
+				if (!CompileX(compile_info.file, program.source, permutations[program.permutation], kShaderStages[blob.stage], blob.lang, blob.output, blob.resources))
+					return false;
+
+				if (compile_info.cache)
+					compile_info.cache->StoreBlob(blob.key, EncodeBlob(blob.output, blob.resources));
+				return true;
+			});
+		}
+		graph.Run();
+
+		for (uint32_t i = 0u; i < graph.GetJobCount(); ++i)
+			if (!graph.GetJob(i).succeeded)
 				return false;
 
-			AddShader(shader_program);
+		Vector<VioletShader> shader_programs(programs.size());
+		for (uint32_t p = 0u; p < programs.size(); ++p)
+		{
+			shader_programs[p].file_path = compile_info.file + "|" + permutations[programs[p].permutation];
+			if (programs[p].quantized)
+				shader_programs[p].file_path += VIOLET_QUANTIZED_SUFFIX;
+			shader_programs[p].hash = GetHash(shader_programs[p].file_path);
 		}
+
+		uint32_t restored = 0u;
+		for (const Blob& blob : blobs)
+			restored += blob.restored ? 1u : 0u;
+
+		for (const Target& target : targets)
+		{
+			const Blob& blob = blobs[target.blob];
+			VioletShader& shader_program = shader_programs[target.program];
+			const int stage = (int)kShaderStages[target.stage].stage;
+			shader_program.blobs[stage][target.lang] = blob.output;
+			// Only the HLSL target is reflected.
+			if (!blob.resources.empty())
+				shader_program.resources[stage] = blob.resources;
+		}
+
+		for (const VioletShader& shader_program : shader_programs)
+			AddShader(shader_program);
+
+		foundation::Info("\t" + toString(permutations.size()) + " permutations, " + toString(programs.size()) + " programs, " + toString(targets.size()) + " stages: " +
+			toString((uint32_t)blobs.size() - restored) + " compiled, " + toString(restored) + " restored, " +
+			toString((uint32_t)(targets.size() - blobs.size())) + " shared, " + toString(skipped) + " without an entry point, " +
+			toString((uint32_t)graph.GetWallTime()) + "ms on " + toString(graph.GetThreadCount()) + " threads\n");
+
 		return true;
 	}
+
+	///////////////////////////////////////////////////////////////////////////
+	Vector<char> VioletShaderCompiler::EncodeBlob(const Vector<char>& blob, const Vector<VioletShaderResource>& resources)
+	{
+		ShaderBlobBlock block;
+		block.blob_size = (uint32_t)blob.size();
+		block.padding   = 0u;
+
+		VioletHeaderWriter writer((uint8_t)kVersion, block);
+		writer.Write(blob.data(), blob.size());
+		WriteResources(writer, resources);
+		return writer.GetData();
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	bool VioletShaderCompiler::DecodeBlob(const Vector<char>& data, Vector<char>& blob, Vector<VioletShaderResource>& resources)
+	{
+		VioletHeaderReader reader(data.data(), data.size(), (uint8_t)kVersion);
+		ShaderBlobBlock block;
+		if (!reader.ReadBlock(block) || block.blob_size > data.size())
+			return false;
+
+		blob.resize(block.blob_size);
+		reader.Read(blob.data(), blob.size());
+		return ReadResources(reader, resources) && reader.IsValid();
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	Vector<String> VioletShaderCompiler::GetPermutations(const String& source)
+	{
+		Vector<String> permutations;
+		if (!source.empty() && source[0] == '[')
+			permutations = split(source.substr(1, source.find_first_of(']') - 1), '|');
+
+		if (eastl::find(permutations.begin(), permutations.end(), "DEFAULT") == permutations.end())
+			permutations.insert(permutations.begin(), "DEFAULT");
+		return permutations;
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	Vector<String> VioletShaderCompiler::GetIncludes(const String& file)
+	{
+		// Includes are relative to the file that includes them, like the include handlers resolve them.
+		Vector<String> includes;
+		Vector<String> stack = { FileSystem::FixFilePath(file) };
+		while (!stack.empty())
+		{
+			const String current = stack.back();
+			stack.pop_back();
+			if (!FileSystem::DoesFileExist(current))
+				continue;
+
+			const String source = FileSystem::FileToString(current);
+			for (eastl_size_t offset = source.find("#include"); offset != String::npos; offset = source.find("#include", offset + 1u))
+			{
+				const eastl_size_t begin = source.find('"', offset);
+				const eastl_size_t end   = begin == String::npos ? String::npos : source.find('"', begin + 1u);
+				if (end == String::npos || source.find('\n', offset) < end)
+					continue;
+
+				const String include = FileSystem::FixFilePath(FileSystem::RemoveName(current) + source.substr(begin + 1u, end - begin - 1u));
+				if (eastl::find(includes.begin(), includes.end(), include) == includes.end())
+				{
+					includes.push_back(include);
+					stack.push_back(include);
+				}
+			}
+		}
+		return includes;
+	}
 }
\ No newline at end of file
@@ -3,15 +3,31 @@
 
 namespace lambda
 {
+	class VioletBuildCache;
+
 	struct ShaderCompileInfo
 	{
 		String file;
+		// Compiled stages are looked up here first, every stage of every target is its own entry.
+		VioletBuildCache* cache = nullptr;
 	};
 
 	class VioletShaderCompiler : public VioletShaderManager
 	{
 	public:
+		// Cached shaders built by an older version are compiled again.
+		static constexpr uint32_t kVersion = 2u;
+
 		VioletShaderCompiler();
 		bool Compile(ShaderCompileInfo compile_info);
+
+		// The permutations named in the "[A|B]" settings line, DEFAULT is always there.
+		static Vector<String> GetPermutations(const String& source);
+		// Every file the shader includes, directly or through another include.
+		static Vector<String> GetIncludes(const String& file);
+
+	private:
+		static Vector<char> EncodeBlob(const Vector<char>& blob, const Vector<VioletShaderResource>& resources);
+		static bool DecodeBlob(const Vector<char>& data, Vector<char>& blob, Vector<VioletShaderResource>& resources);
 	};
 }
\ No newline at end of file
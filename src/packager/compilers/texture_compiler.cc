@@ -26,65 +26,24 @@ namespace lambda
   VioletTextureCompiler::VioletTextureCompiler() :
     VioletTextureManager()
   {
+    // Block compressed textures still shrink noticeably with LZ4HC.
+    SetCompression(VioletCompression::kLZ4HC);
   }
 
-	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	int calcImageSize(int w, int h, int mips)
-	{
-		int data_size = 0;
-		for (int i = 0; i < mips; ++i)
-		{
-			data_size += w * h * 4;
-			w = std::max(1, w / 2);
-			h = std::max(1, h / 2);
-		}
-		return data_size;
-	}
-
-	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	void genMips(int w, int h, int mips, unsigned char* data)
-	{
-		int offset = 0;
-
-		for (int i = 0; i < mips - 1; ++i)
-		{
-			int new_width = std::max(1, w / 2);
-			int new_height = std::max(1, h / 2);
-			int new_offset = offset + w * h * 4;
-
-			stbir_resize_uint8(
-				data + offset,
-				w,
-				h,
-				0,
-				data + new_offset,
-				new_width,
-				new_height,
-				0,
-				STBI_rgb_alpha
-			);
-
-			w = new_width;
-			h = new_height;
-			offset = new_offset;
-		}
-	}
-
   /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	bool VioletTextureCompiler::Compile(TextureCompileInfo texture_info)
   {
-		String extension = FileSystem::GetExtension(texture_info.file);
-		Vector<char> raw_data;
-		int w, h, num_mips;
-		bool contains_alpha = false;
-		TextureFormat format;
 		Vector<char> raw_texture = FileSystem::FileToVector(texture_info.file);
+		const bool hdr = stbi_is_hdr_from_memory((unsigned char*)raw_texture.data(), (int)raw_texture.size()) != 0;
+		bool contains_alpha = false;
+		int w, h, bpp;
 
-		if (stbi_is_hdr_from_memory((unsigned char*)raw_texture.data(), (int)raw_texture.size()))
-		{
-			format = TextureFormat::kR32G32B32A32;
+		VioletTexture texture;
+		texture.hash = GetHash(texture_info.file);
+		texture.file = texture_info.file;
 
-			int bpp;
+		if (hdr)
+		{
 			float* data = stbi_loadf_from_memory((unsigned char*)raw_texture.data(), (int)raw_texture.size(), &w, &h, &bpp, STBI_rgb_alpha);
 
 			if (data == nullptr)
@@ -103,17 +62,12 @@ namespace lambda
 				}
 			}
 
-			num_mips = 1;
-
-			raw_data.resize(w * h * 4 * sizeof(float)* num_mips);
-			memcpy(raw_data.data(), data, w * h * 4 * sizeof(float));
+			texture.format = TextureFormat::kR32G32B32A32;
+			texture.data.assign((char*)data, (char*)data + w * h * 4 * sizeof(float));
 			stbi_image_free(data);
 		}
 		else
 		{
-			format = TextureFormat::kR8G8B8A8;
-
-			int bpp;
 			uint8_t* data = stbi_load_from_memory((unsigned char*)raw_texture.data(), (int)raw_texture.size(), &w, &h, &bpp, STBI_rgb_alpha);
 
 			if (data == nullptr)
@@ -132,26 +86,42 @@ namespace lambda
 				}
 			}
 
-			num_mips = (int)floorf(std::log2f(std::fminf((float)w, (float)h)) + 1.0f);
-
-			int data_size = calcImageSize(w, h, num_mips);
-			raw_data.resize(data_size);
-			memcpy(raw_data.data(), data, w * h * 4);
+			texture.format = TextureFormat::kR8G8B8A8;
+			texture.data.assign((char*)data, (char*)data + w * h * 4);
 			stbi_image_free(data);
-			genMips(w, h, num_mips, (unsigned char*)raw_data.data());
 		}
 
-		VioletTexture texture;
-		texture.hash      = GetHash(texture_info.file);
-		texture.file      = texture_info.file;
-		texture.format    = format;
-		texture.width     = (uint32_t)w;
-		texture.height    = (uint32_t)h;
-		texture.mip_count = num_mips;
+		texture.width     = (uint16_t)w;
+		texture.height    = (uint16_t)h;
+		texture.mip_count = (uint16_t)VioletTextureEncoder::GetMipCount((uint32_t)w, (uint32_t)h);
 		texture.flags     = kTextureFlagFromDDS | (contains_alpha ? kTextureFlagContainsAlpha : 0);
-		texture.data      = raw_data;
+
+		const VioletTextureUsage usage = texture_info.usage == VioletTextureUsage::kAuto ?
+			VioletTextureEncoder::GetUsage(texture_info.file, hdr) :
+			texture_info.usage;
+		VioletTextureEncoder::GenerateMips(texture, usage);
+
+		const TextureFormat format = VioletTextureEncoder::ChooseFormat(usage, texture_info.quality, contains_alpha, (uint32_t)w, (uint32_t)h);
+		VioletTextureEncoder::Stats stats;
+		if (!VioletTextureEncoder::Encode(texture, format, usage, texture_info.quality, stats))
+			return false;
+
+		String info = "\t" + VioletTextureEncoder::FormatToString(format) + " " + toString(w) + "x" + toString(h) + ", " + toString(texture.mip_count) + " mips, " +
+			toString(stats.bytes_before / 1024u) + "KB -> " + toString(stats.bytes_after / 1024u) + "KB";
+		if (stats.psnr > 0.0f)
+			info += ", PSNR " + toString(stats.psnr) + "dB";
+		if (stats.encode_time > 0.0)
+			info += ", " + toString((float)((double)stats.pixels / 1000.0 / stats.encode_time)) + "MP/s";
+		foundation::Info(info + "\n");
+
+		// Lets the engine load the low detail mips first and stream in the rest when they are needed.
+		if (texture.mip_count > 1u)
+		{
+			texture.flags |= kTextureFlagMipTailFirst;
+			texture.data   = ToMipTailFirst(texture, texture.data);
+		}
 		AddTexture(texture);
 
 		return true;
   }
-}
\ No newline at end of file
+}
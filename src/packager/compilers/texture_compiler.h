@@ -1,16 +1,22 @@
 #pragma once
 #include <assets/texture_manager.h>
+#include "texture_encoder.h"
 
 namespace lambda
 {
   struct TextureCompileInfo
   {
     String file;
+    VioletTextureUsage   usage   = VioletTextureUsage::kAuto;
+    VioletTextureQuality quality = VioletTextureQuality::kNormal;
   };
 
   class VioletTextureCompiler : public VioletTextureManager
   {
   public:
+    // Part of the build cache key.
+    static constexpr uint32_t kVersion = 2u;
+
     VioletTextureCompiler();
     bool Compile(TextureCompileInfo texture_info);
   };
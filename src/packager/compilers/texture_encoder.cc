@@ -0,0 +1,567 @@
+#include "texture_encoder.h"
+#include <pipeline/build_graph.h>
+#include <utils/console.h>
+#include <stb_image_resize.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#if VIOLET_DIRECTX_TEX
+#include <DirectXTex.h>
+#endif
+
+namespace lambda
+{
+  namespace
+  {
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    uint32_t getBlockSize(TextureFormat format)
+    {
+      return (format == TextureFormat::kBC1 || format == TextureFormat::kBC4) ? 8u : 16u;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    uint32_t getPixelSize(TextureFormat format)
+    {
+      return format == TextureFormat::kR32G32B32A32 ? 16u : 4u;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void downsampleNormals(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst, uint32_t new_width, uint32_t new_height)
+    {
+      for (uint32_t y = 0u; y < new_height; ++y)
+      {
+        for (uint32_t x = 0u; x < new_width; ++x)
+        {
+          glm::vec3 sum(0.0f);
+          float alpha = 0.0f;
+          for (uint32_t i = 0u; i < 4u; ++i)
+          {
+            const uint32_t sx = std::min(x * 2u + (i & 1u), width - 1u);
+            const uint32_t sy = std::min(y * 2u + (i >> 1u), height - 1u);
+            const uint8_t* pixel = src + (sy * width + sx) * 4u;
+            sum   += glm::vec3(pixel[0u], pixel[1u], pixel[2u]) / 127.5f - 1.0f;
+            alpha += pixel[3u];
+          }
+
+          // Averaged normals get shorter where they disagree, the shaders expect unit length.
+          const float length = glm::length(sum);
+          const glm::vec3 normal = length > 0.0f ? sum / length : glm::vec3(0.0f, 0.0f, 1.0f);
+          uint8_t* out = dst + (y * new_width + x) * 4u;
+          out[0u] = (uint8_t)std::min(255.0f, (normal.x * 0.5f + 0.5f) * 255.0f + 0.5f);
+          out[1u] = (uint8_t)std::min(255.0f, (normal.y * 0.5f + 0.5f) * 255.0f + 0.5f);
+          out[2u] = (uint8_t)std::min(255.0f, (normal.z * 0.5f + 0.5f) * 255.0f + 0.5f);
+          out[3u] = (uint8_t)(alpha / 4.0f + 0.5f);
+        }
+      }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Edge pixels are repeated for blocks that stick out of the mip.
+    void gatherBlock(const uint8_t* src, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y, uint8_t* block)
+    {
+      for (uint32_t y = 0u; y < 4u; ++y)
+      {
+        const uint32_t sy = std::min(block_y * 4u + y, height - 1u);
+        for (uint32_t x = 0u; x < 4u; ++x)
+        {
+          const uint32_t sx = std::min(block_x * 4u + x, width - 1u);
+          memcpy(block + (y * 4u + x) * 4u, src + (sy * width + sx) * 4u, 4u);
+        }
+      }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void encodeBlock(TextureFormat format, const uint8_t* rgba, uint8_t* out, int mode)
+    {
+      switch (format)
+      {
+      case TextureFormat::kBC1:
+        stb_compress_dxt_block(out, rgba, 0, mode);
+        break;
+      case TextureFormat::kBC3:
+        stb_compress_dxt_block(out, rgba, 1, mode);
+        break;
+      case TextureFormat::kBC4:
+      {
+        uint8_t r[16u];
+        for (uint32_t i = 0u; i < 16u; ++i)
+          r[i] = rgba[i * 4u];
+        stb_compress_bc4_block(out, r);
+        break;
+      }
+      case TextureFormat::kBC5:
+      {
+        uint8_t rg[32u];
+        for (uint32_t i = 0u; i < 16u; ++i)
+        {
+          rg[i * 2u + 0u] = rgba[i * 4u + 0u];
+          rg[i * 2u + 1u] = rgba[i * 4u + 1u];
+        }
+        stb_compress_bc5_block(out, rg);
+        break;
+      }
+      default:
+        break;
+      }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void expand565(uint16_t color, uint8_t* rgb)
+    {
+      const uint32_t r = (color >> 11u) & 31u;
+      const uint32_t g = (color >> 5u) & 63u;
+      const uint32_t b = color & 31u;
+      rgb[0u] = (uint8_t)((r << 3u) | (r >> 2u));
+      rgb[1u] = (uint8_t)((g << 2u) | (g >> 4u));
+      rgb[2u] = (uint8_t)((b << 3u) | (b >> 2u));
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void decodeColorBlock(const uint8_t* block, uint8_t* rgba, bool four_colors)
+    {
+      const uint16_t c0 = (uint16_t)(block[0u] | (block[1u] << 8u));
+      const uint16_t c1 = (uint16_t)(block[2u] | (block[3u] << 8u));
+
+      uint8_t colors[4u][4u];
+      expand565(c0, colors[0u]);
+      expand565(c1, colors[1u]);
+      for (uint32_t i = 0u; i < 4u; ++i)
+        colors[i][3u] = 255u;
+
+      for (uint32_t c = 0u; c < 3u; ++c)
+      {
+        if (four_colors || c0 > c1)
+        {
+          colors[2u][c] = (uint8_t)((2u * colors[0u][c] + colors[1u][c]) / 3u);
+          colors[3u][c] = (uint8_t)((colors[0u][c] + 2u * colors[1u][c]) / 3u);
+        }
+        else
+        {
+          colors[2u][c] = (uint8_t)((colors[0u][c] + colors[1u][c]) / 2u);
+          colors[3u][c] = 0u;
+          colors[3u][3u] = 0u;
+        }
+      }
+
+      const uint32_t indices = block[4u] | (block[5u] << 8u) | (block[6u] << 16u) | ((uint32_t)block[7u] << 24u);
+      for (uint32_t i = 0u; i < 16u; ++i)
+        memcpy(rgba + i * 4u, colors[(indices >> (i * 2u)) & 3u], 4u);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // The BC4 block layout, also used for the alpha of BC3 and both channels of BC5.
+    void decodeChannelBlock(const uint8_t* block, uint8_t* out, uint32_t stride)
+    {
+      uint32_t values[8u];
+      values[0u] = block[0u];
+      values[1u] = block[1u];
+      if (values[0u] > values[1u])
+      {
+        for (uint32_t i = 1u; i < 7u; ++i)
+          values[i + 1u] = ((7u - i) * values[0u] + i * values[1u]) / 7u;
+      }
+      else
+      {
+        for (uint32_t i = 1u; i < 5u; ++i)
+          values[i + 1u] = ((5u - i) * values[0u] + i * values[1u]) / 5u;
+        values[6u] = 0u;
+        values[7u] = 255u;
+      }
+
+      uint64_t indices = 0u;
+      for (uint32_t i = 0u; i < 6u; ++i)
+        indices |= (uint64_t)block[2u + i] << (i * 8u);
+      for (uint32_t i = 0u; i < 16u; ++i)
+        out[i * stride] = (uint8_t)values[(indices >> (i * 3u)) & 7u];
+    }
+
+#if VIOLET_DIRECTX_TEX
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    DXGI_FORMAT toDXGIFormat(TextureFormat format)
+    {
+      switch (format)
+      {
+      case TextureFormat::kBC1:          return DXGI_FORMAT_BC1_UNORM;
+      case TextureFormat::kBC3:          return DXGI_FORMAT_BC3_UNORM;
+      case TextureFormat::kBC4:          return DXGI_FORMAT_BC4_UNORM;
+      case TextureFormat::kBC5:          return DXGI_FORMAT_BC5_UNORM;
+      case TextureFormat::kBC6:          return DXGI_FORMAT_BC6H_UF16;
+      case TextureFormat::kBC7:          return DXGI_FORMAT_BC7_UNORM;
+      case TextureFormat::kR32G32B32A32: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+      default:                           return DXGI_FORMAT_R8G8B8A8_UNORM;
+      }
+    }
+#endif
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    bool encodeRows(
+      TextureFormat format,
+      VioletTextureUsage usage,
+      VioletTextureQuality quality,
+      const char* src,
+      uint32_t width,
+      uint32_t height,
+      uint32_t pixel_size,
+      uint32_t first_row,
+      uint32_t row_count,
+      char* dst)
+    {
+#if VIOLET_DIRECTX_TEX
+      DirectX::Image image;
+      image.width      = width;
+      image.height     = std::min(height - first_row * 4u, row_count * 4u);
+      image.format     = pixel_size == 16u ? DXGI_FORMAT_R32G32B32A32_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+      image.rowPitch   = width * pixel_size;
+      image.slicePitch = image.rowPitch * image.height;
+      image.pixels     = (uint8_t*)src + first_row * 4u * image.rowPitch;
+
+      DirectX::TEX_COMPRESS_FLAGS flags = DirectX::TEX_COMPRESS_DEFAULT;
+      // Perceptual weighting is only right for colors.
+      if (usage != VioletTextureUsage::kColor)
+        flags = (DirectX::TEX_COMPRESS_FLAGS)(flags | DirectX::TEX_COMPRESS_UNIFORM);
+      if (quality == VioletTextureQuality::kFast)
+        flags = (DirectX::TEX_COMPRESS_FLAGS)(flags | DirectX::TEX_COMPRESS_BC7_QUICK);
+      else if (quality == VioletTextureQuality::kHigh)
+        flags = (DirectX::TEX_COMPRESS_FLAGS)(flags | DirectX::TEX_COMPRESS_BC7_USE_3SUBSETS);
+
+      DirectX::ScratchImage compressed;
+      if (FAILED(DirectX::Compress(image, toDXGIFormat(format), flags, DirectX::TEX_THRESHOLD_DEFAULT, compressed)))
+        return false;
+
+      memcpy(dst, compressed.GetPixels(), compressed.GetPixelsSize());
+      return true;
+#else
+      if (pixel_size != 4u || format == TextureFormat::kBC6 || format == TextureFormat::kBC7)
+        return false;
+
+      const int mode = quality == VioletTextureQuality::kHigh ? STB_DXT_HIGHQUAL : STB_DXT_NORMAL;
+      const uint32_t blocks_x   = (width + 3u) / 4u;
+      const uint32_t block_size = getBlockSize(format);
+
+      uint8_t block[64u];
+      for (uint32_t row = 0u; row < row_count; ++row)
+      {
+        for (uint32_t block_x = 0u; block_x < blocks_x; ++block_x)
+        {
+          gatherBlock((const uint8_t*)src, width, height, block_x, first_row + row, block);
+          encodeBlock(format, block, (uint8_t*)dst + (row * blocks_x + block_x) * block_size, mode);
+        }
+      }
+      return true;
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Decodes a block compressed mip to RGBA8, to measure how much was lost.
+    bool decodeMip(TextureFormat format, const char* data, uint32_t width, uint32_t height, Vector<uint8_t>& rgba)
+    {
+      rgba.resize(width * height * 4u);
+
+#if VIOLET_DIRECTX_TEX
+      const uint32_t blocks_x = (width + 3u) / 4u;
+      const uint32_t blocks_y = (height + 3u) / 4u;
+
+      DirectX::Image image;
+      image.width      = width;
+      image.height     = height;
+      image.format     = toDXGIFormat(format);
+      image.rowPitch   = blocks_x * getBlockSize(format);
+      image.slicePitch = image.rowPitch * blocks_y;
+      image.pixels     = (uint8_t*)data;
+
+      DirectX::ScratchImage decompressed;
+      if (FAILED(DirectX::Decompress(image, DXGI_FORMAT_R8G8B8A8_UNORM, decompressed)))
+        return false;
+
+      const DirectX::Image* result = decompressed.GetImage(0u, 0u, 0u);
+      for (uint32_t y = 0u; y < height; ++y)
+        memcpy(rgba.data() + y * width * 4u, result->pixels + y * result->rowPitch, width * 4u);
+      return true;
+#else
+      if (format != TextureFormat::kBC1 && format != TextureFormat::kBC3 && format != TextureFormat::kBC4 && format != TextureFormat::kBC5)
+        return false;
+
+      const uint32_t blocks_x   = (width + 3u) / 4u;
+      const uint32_t block_size = getBlockSize(format);
+      uint8_t block[64u];
+      for (uint32_t y = 0u; y < height; y += 4u)
+      {
+        for (uint32_t x = 0u; x < width; x += 4u)
+        {
+          const uint8_t* src = (const uint8_t*)data + ((y / 4u) * blocks_x + x / 4u) * block_size;
+          for (uint32_t i = 0u; i < 16u; ++i)
+          {
+            block[i * 4u + 0u] = block[i * 4u + 1u] = block[i * 4u + 2u] = 0u;
+            block[i * 4u + 3u] = 255u;
+          }
+
+          switch (format)
+          {
+          case TextureFormat::kBC1: decodeColorBlock(src, block, false); break;
+          case TextureFormat::kBC3: decodeColorBlock(src + 8u, block, true); decodeChannelBlock(src, block + 3u, 4u); break;
+          case TextureFormat::kBC4: decodeChannelBlock(src, block, 4u); break;
+          case TextureFormat::kBC5: decodeChannelBlock(src, block, 4u); decodeChannelBlock(src + 8u, block + 1u, 4u); break;
+          default: break;
+          }
+
+          for (uint32_t by = 0u; by < 4u && y + by < height; ++by)
+            for (uint32_t bx = 0u; bx < 4u && x + bx < width; ++bx)
+              memcpy(rgba.data() + ((y + by) * width + x + bx) * 4u, block + (by * 4u + bx) * 4u, 4u);
+        }
+      }
+      return true;
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Only over the channels the format keeps.
+    float computePSNR(TextureFormat format, const uint8_t* original, const uint8_t* decoded, uint32_t pixel_count)
+    {
+      uint32_t channels = 4u;
+      if (format == TextureFormat::kBC1)
+        channels = 3u;
+      else if (format == TextureFormat::kBC5)
+        channels = 2u;
+      else if (format == TextureFormat::kBC4)
+        channels = 1u;
+
+      double error = 0.0;
+      for (uint32_t i = 0u; i < pixel_count; ++i)
+      {
+        for (uint32_t c = 0u; c < channels; ++c)
+        {
+          const double difference = (double)original[i * 4u + c] - (double)decoded[i * 4u + c];
+          error += difference * difference;
+        }
+      }
+
+      const double mse = error / ((double)pixel_count * channels);
+      if (mse <= 0.0)
+        return 100.0f;
+      return (float)(10.0 * std::log10(255.0 * 255.0 / mse));
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  VioletTextureUsage VioletTextureEncoder::GetUsage(const String& file, bool hdr)
+  {
+    if (hdr)
+      return VioletTextureUsage::kHDR;
+
+    String name = file.substr(0u, file.find_last_of('.'));
+    for (char& c : name)
+      c = (char)tolower((unsigned char)c);
+
+    auto endsWith = [&name](const char* suffix) {
+      const eastl_size_t length = (eastl_size_t)strlen(suffix);
+      return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+    };
+
+    if (endsWith("_nrm") || endsWith("_normal") || endsWith("_norm") || endsWith("_n"))
+      return VioletTextureUsage::kNormal;
+    // The packed map and the channels it is packed from.
+    if (endsWith("_dmra") || endsWith("_ao") || endsWith("_dis") || endsWith("_met") || endsWith("_rgh"))
+      return VioletTextureUsage::kMask;
+    // Impostor normals with the depth in alpha, BC5 would drop the depth.
+    if (endsWith("_nd"))
+      return VioletTextureUsage::kMask;
+    return VioletTextureUsage::kColor;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  TextureFormat VioletTextureEncoder::ChooseFormat(VioletTextureUsage usage, VioletTextureQuality quality, bool contains_alpha, uint32_t width, uint32_t height)
+  {
+    // BC6H has no alpha, half floats still halve the size.
+    if (usage == VioletTextureUsage::kHDR)
+      return (CanEncode(TextureFormat::kBC6) && !contains_alpha && width % 4u == 0u && height % 4u == 0u) ? TextureFormat::kBC6 : TextureFormat::kR16G16B16A16;
+
+    // The renderers need the first mip of a block compressed texture to be a whole number of blocks.
+    if (width % 4u != 0u || height % 4u != 0u)
+      return TextureFormat::kR8G8B8A8;
+
+    switch (usage)
+    {
+    case VioletTextureUsage::kNormal:
+      return TextureFormat::kBC5;
+    case VioletTextureUsage::kSingleChannel:
+      return TextureFormat::kBC4;
+    case VioletTextureUsage::kMask:
+      // BC1 and BC3 share the color endpoints between channels, which does not work for unrelated masks.
+      return CanEncode(TextureFormat::kBC7) ? TextureFormat::kBC7 : TextureFormat::kR8G8B8A8;
+    default:
+      if (contains_alpha)
+        return (CanEncode(TextureFormat::kBC7) && quality != VioletTextureQuality::kFast) ? TextureFormat::kBC7 : TextureFormat::kBC3;
+      return (CanEncode(TextureFormat::kBC7) && quality == VioletTextureQuality::kHigh) ? TextureFormat::kBC7 : TextureFormat::kBC1;
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletTextureEncoder::CanEncode(TextureFormat format)
+  {
+    switch (format)
+    {
+    case TextureFormat::kBC6:
+    case TextureFormat::kBC7:
+#if VIOLET_DIRECTX_TEX
+      return true;
+#else
+      return false;
+#endif
+    case TextureFormat::kBC2:
+      return false;
+    default:
+      return true;
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint32_t VioletTextureEncoder::GetMipCount(uint32_t width, uint32_t height)
+  {
+    return (uint32_t)floorf(std::log2f(std::fminf((float)width, (float)height)) + 1.0f);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletTextureEncoder::GenerateMips(VioletTexture& texture, VioletTextureUsage usage)
+  {
+    const uint32_t pixel_size = getPixelSize(texture.format);
+    texture.data.resize((size_t)VioletTextureManager::GetMipChainSize(texture, 0u));
+
+    uint32_t width  = texture.width;
+    uint32_t height = texture.height;
+    uint64_t offset = 0u;
+    for (uint32_t mip = 1u; mip < texture.mip_count; ++mip)
+    {
+      const uint32_t new_width  = std::max(1u, width / 2u);
+      const uint32_t new_height = std::max(1u, height / 2u);
+      const uint64_t new_offset = offset + (uint64_t)width * height * pixel_size;
+      const unsigned char* src  = (const unsigned char*)texture.data.data() + offset;
+      unsigned char* dst        = (unsigned char*)texture.data.data() + new_offset;
+
+      if (pixel_size == 16u)
+        stbir_resize_float((const float*)src, width, height, 0, (float*)dst, new_width, new_height, 0, 4);
+      else if (usage == VioletTextureUsage::kNormal)
+        downsampleNormals(src, width, height, dst, new_width, new_height);
+      else if (usage == VioletTextureUsage::kColor)
+        // Averages in linear space and weighs the colors by their alpha, so mips do not darken or bleed.
+        stbir_resize_uint8_srgb(src, width, height, 0, dst, new_width, new_height, 0, 4, 3, 0);
+      else
+        stbir_resize_uint8(src, width, height, 0, dst, new_width, new_height, 0, 4);
+
+      width  = new_width;
+      height = new_height;
+      offset = new_offset;
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletTextureEncoder::Encode(VioletTexture& texture, TextureFormat format, VioletTextureUsage usage, VioletTextureQuality quality, Stats& stats)
+  {
+    const uint32_t pixel_size = getPixelSize(texture.format);
+    stats.bytes_before = texture.data.size();
+    stats.bytes_after  = texture.data.size();
+    stats.pixels       = 0u;
+    for (uint32_t mip = 0u; mip < texture.mip_count; ++mip)
+      stats.pixels += (uint64_t)std::max(1u, (uint32_t)texture.width >> mip) * std::max(1u, (uint32_t)texture.height >> mip);
+
+    if (format == texture.format)
+      return true;
+
+    if (!CanEncode(format))
+    {
+      foundation::Error("TextureEncoder: " + texture.file + " can not be encoded as " + FormatToString(format) + " by this build\n");
+      return false;
+    }
+
+    VioletTexture encoded = texture;
+    encoded.format = format;
+    encoded.data   = Vector<char>((size_t)VioletTextureManager::GetMipChainSize(encoded, 0u));
+
+    // Half floats are not a block format, a plain conversion is enough.
+    if (format == TextureFormat::kR16G16B16A16)
+    {
+      LMB_ASSERT(pixel_size == 16u, "TextureEncoder: Half floats are only made from float textures");
+      const float* src = (const float*)texture.data.data();
+      uint32_t* dst    = (uint32_t*)encoded.data.data();
+      for (size_t i = 0u; i < encoded.data.size() / 8u; ++i)
+      {
+        dst[i * 2u + 0u] = glm::packHalf2x16(glm::vec2(src[i * 4u + 0u], src[i * 4u + 1u]));
+        dst[i * 2u + 1u] = glm::packHalf2x16(glm::vec2(src[i * 4u + 2u], src[i * 4u + 3u]));
+      }
+
+      texture.format     = format;
+      texture.data       = eastl::move(encoded.data);
+      stats.bytes_after  = texture.data.size();
+      return true;
+    }
+
+    // Every job encodes a strip of block rows, small mips are a single job.
+    VioletBuildGraph graph;
+    uint64_t src_offset = 0u;
+    uint64_t dst_offset = 0u;
+    for (uint32_t mip = 0u; mip < texture.mip_count; ++mip)
+    {
+      const uint32_t width     = std::max(1u, (uint32_t)texture.width >> mip);
+      const uint32_t height    = std::max(1u, (uint32_t)texture.height >> mip);
+      const uint32_t blocks_y  = (height + 3u) / 4u;
+      const uint32_t row_size  = (width + 3u) / 4u * getBlockSize(format);
+      const char* src          = texture.data.data() + src_offset;
+      char* dst                = encoded.data.data() + dst_offset;
+
+      for (uint32_t row = 0u; row < blocks_y; row += kBlockRowsPerJob)
+      {
+        const uint32_t row_count = std::min(kBlockRowsPerJob, blocks_y - row);
+        graph.AddJob(texture.file, [=]() {
+          return encodeRows(format, usage, quality, src, width, height, pixel_size, row, row_count, dst + row * row_size);
+        });
+      }
+
+      src_offset += VioletTextureManager::GetMipSize(texture, mip);
+      dst_offset += VioletTextureManager::GetMipSize(encoded, mip);
+    }
+    graph.Run();
+
+    for (uint32_t i = 0u; i < graph.GetJobCount(); ++i)
+    {
+      if (!graph.GetJob(i).succeeded)
+      {
+        foundation::Error("TextureEncoder: Failed to encode " + texture.file + " as " + FormatToString(format) + "\n");
+        return false;
+      }
+    }
+    stats.encode_time = graph.GetWallTime();
+
+    Vector<uint8_t> decoded;
+    if (pixel_size == 4u && decodeMip(format, encoded.data.data(), texture.width, texture.height, decoded))
+      stats.psnr = computePSNR(format, (const uint8_t*)texture.data.data(), decoded.data(), (uint32_t)texture.width * texture.height);
+
+    texture.format    = format;
+    texture.data      = eastl::move(encoded.data);
+    stats.bytes_after = texture.data.size();
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  String VioletTextureEncoder::FormatToString(TextureFormat format)
+  {
+    switch (format)
+    {
+    case TextureFormat::kR8G8B8A8:      return "RGBA8";
+    case TextureFormat::kR16G16B16A16:  return "RGBA16F";
+    case TextureFormat::kR32G32B32A32:  return "RGBA32F";
+    case TextureFormat::kBC1:           return "BC1";
+    case TextureFormat::kBC2:           return "BC2";
+    case TextureFormat::kBC3:           return "BC3";
+    case TextureFormat::kBC4:           return "BC4";
+    case TextureFormat::kBC5:           return "BC5";
+    case TextureFormat::kBC6:           return "BC6H";
+    case TextureFormat::kBC7:           return "BC7";
+    default:                            return "Unknown";
+    }
+  }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <assets/texture_manager.h>
+
+namespace lambda
+{
+  enum class VioletTextureUsage : uint8_t
+  {
+    kAuto,          // Picked from the file name, see VioletTextureEncoder::GetUsage.
+    kColor,
+    kNormal,        // Tangent space, only x and y are kept, the shaders rebuild z.
+    kMask,          // Linear data like the packed _dmra maps, every channel stands on its own.
+    kSingleChannel, // Only the red channel is used.
+    kHDR,
+  };
+
+  enum class VioletTextureQuality : uint8_t
+  {
+    kFast,
+    kNormal,
+    kHigh,
+  };
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Builds the mip chain of a texture and block compresses it on the CPU.
+  // Builds with DirectXTex (VIOLET_DIRECTX_TEX) encode every BC format with
+  // it. Otherwise stb_dxt encodes BC1, BC3, BC4 and BC5, and textures that
+  // would use BC6H or BC7 fall back to a format the build can produce.
+  class VioletTextureEncoder
+  {
+  public:
+    // Block rows of a mip that are encoded by a single job.
+    static constexpr uint32_t kBlockRowsPerJob = 8u;
+
+    struct Stats
+    {
+      uint64_t bytes_before = 0u;
+      uint64_t bytes_after  = 0u;
+      float    psnr         = 0.0f; // Of the first mip in dB, zero when it could not be measured.
+      double   encode_time  = 0.0;  // Milliseconds.
+      uint64_t pixels       = 0u;   // Of all mips.
+    };
+
+    static VioletTextureUsage GetUsage(const String& file, bool hdr);
+    static TextureFormat ChooseFormat(VioletTextureUsage usage, VioletTextureQuality quality, bool contains_alpha, uint32_t width, uint32_t height);
+    static bool CanEncode(TextureFormat format);
+    static uint32_t GetMipCount(uint32_t width, uint32_t height);
+
+    // The texture holds the first mip as RGBA8 or RGBA32F, the rest of the
+    // chain is added. Color is filtered in linear space, normals are
+    // renormalized and everything else is filtered as is.
+    static void GenerateMips(VioletTexture& texture, VioletTextureUsage usage);
+    // Compresses every mip of the chain to format, on a thread per core.
+    static bool Encode(VioletTexture& texture, TextureFormat format, VioletTextureUsage usage, VioletTextureQuality quality, Stats& stats);
+
+    static String FormatToString(TextureFormat format);
+  };
+}
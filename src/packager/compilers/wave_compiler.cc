@@ -10,6 +10,8 @@ namespace lambda
   VioletWaveCompiler::VioletWaveCompiler()
 		: VioletWaveManager()
   {
+    // PCM barely compresses, the fast compressor gets about the same ratio.
+    SetCompression(VioletCompression::kLZ4);
   }
   
   /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
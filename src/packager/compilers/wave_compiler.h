@@ -11,6 +11,8 @@ namespace lambda
   class VioletWaveCompiler : public VioletWaveManager
   {
   public:
+    static constexpr uint32_t kVersion = 1u;
+
     VioletWaveCompiler();
 	bool Compile(WaveCompileInfo wave_info);
   };
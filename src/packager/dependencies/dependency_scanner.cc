@@ -0,0 +1,166 @@
+#include "dependency_scanner.h"
+#include <assets/texture_manager.h>
+#include <assets/mesh_manager.h>
+#include <assets/shader_manager.h>
+#include <assets/wave_manager.h>
+#include <compilers/shader_compiler.h>
+#include <utils/file_system.h>
+
+namespace lambda
+{
+  namespace
+  {
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    VioletAssetType typeOfReference(const String& reference)
+    {
+      // Shader references can name a permutation, "file.fx|PERMUTATION".
+      return VioletDependencyGraph::TypeFromExtension(FileSystem::GetExtension(reference.substr(0u, reference.find('|'))));
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  VioletDependencyScanner::VioletDependencyScanner(
+    VioletTextureManager& texture_manager,
+    VioletMeshManager& mesh_manager,
+    VioletShaderManager& shader_manager,
+    VioletWaveManager& wave_manager)
+    : texture_manager_(texture_manager)
+    , mesh_manager_(mesh_manager)
+    , shader_manager_(shader_manager)
+    , wave_manager_(wave_manager)
+  {
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletDependencyScanner::Scan(VioletDependencyGraph& graph, const String& file)
+  {
+    const VioletAssetType type = VioletDependencyGraph::TypeFromExtension(FileSystem::GetExtension(file));
+    graph.RemoveFile(file);
+
+    switch (type)
+    {
+    case VioletAssetType::kTexture:
+    {
+      const uint64_t hash = texture_manager_.GetHash(file);
+      graph.AddNode(hash, type, file, GetSize(type, hash), {});
+      return true;
+    }
+    case VioletAssetType::kWave:
+    {
+      const uint64_t hash = wave_manager_.GetHash(file);
+      graph.AddNode(hash, type, file, GetSize(type, hash), {});
+      return true;
+    }
+    case VioletAssetType::kMesh:
+    {
+      const uint64_t hash = mesh_manager_.GetHash(file);
+      if (!mesh_manager_.HasHeader(hash))
+        return false;
+
+      const VioletMesh mesh = mesh_manager_.GetMesh(hash);
+      Vector<uint64_t> dependencies;
+      for (const Vector<String>* textures : { &mesh.data.tex_alb, &mesh.data.tex_nrm, &mesh.data.tex_dmra, &mesh.data.tex_emi })
+        for (const String& texture : *textures)
+          dependencies.push_back(texture_manager_.GetHash(texture));
+
+      graph.AddNode(hash, type, file, GetSize(type, hash), eastl::move(dependencies));
+      return true;
+    }
+    case VioletAssetType::kShader:
+    {
+      // Every permutation the shader compiler generates is an asset.
+      for (const String& permutation : VioletShaderCompiler::GetPermutations(FileSystem::FileToString(file)))
+      {
+        const uint64_t hash = shader_manager_.GetHash(file + "|" + permutation);
+        graph.AddNode(hash, type, file, GetSize(type, hash), {});
+      }
+      return true;
+    }
+    case VioletAssetType::kScript:
+    {
+      Vector<uint64_t> dependencies;
+      for (const String& reference : FindScriptReferences(file, FileSystem::FileToString(file)))
+        dependencies.push_back(hash(reference));
+
+      graph.AddNode(hash(file), type, file, 0u, eastl::move(dependencies));
+      return true;
+    }
+    default:
+      return false;
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<String> VioletDependencyScanner::FindScriptReferences(const String& file, const String& source)
+  {
+    Vector<String> references;
+    const String extension = FileSystem::GetExtension(file);
+
+    eastl_size_t line_begin = 0u;
+    while (line_begin < source.size())
+    {
+      eastl_size_t line_end = source.find('\n', line_begin);
+      if (line_end == String::npos)
+        line_end = source.size();
+
+      String line = source.substr(line_begin, line_end - line_begin);
+      line_begin = line_end + 1u;
+
+      const eastl_size_t first = line.find_first_not_of(" \t");
+      if (first == String::npos || line.compare(first, 2u, "//") == 0)
+        continue;
+
+      const bool is_import  = extension == "wren" && line.compare(first, 6u, "import") == 0;
+      const bool is_include = extension == "as" && line.compare(first, 8u, "#include") == 0;
+
+      // Assets are always referenced by a string literal holding their path.
+      eastl_size_t begin = line.find('"');
+      while (begin != String::npos)
+      {
+        const eastl_size_t end = line.find('"', begin + 1u);
+        if (end == String::npos)
+          break;
+
+        String reference = line.substr(begin + 1u, end - begin - 1u);
+        begin = line.find('"', end + 1u);
+
+        if (is_import)
+          reference += ".wren";
+        else if (is_include)
+          reference = FileSystem::RemoveName(file) + reference;
+
+        const VioletAssetType type = typeOfReference(reference);
+        if (type == VioletAssetType::kUnknown)
+          continue;
+
+        // The engine loads the default permutation when none is given.
+        if (type == VioletAssetType::kShader && reference.find('|') == String::npos)
+          reference += "|DEFAULT";
+
+        references.push_back(reference);
+      }
+    }
+
+    return references;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint64_t VioletDependencyScanner::GetSize(VioletAssetType type, uint64_t hash) const
+  {
+    const VioletBaseAssetManager* manager = nullptr;
+    switch (type)
+    {
+    case VioletAssetType::kTexture: manager = &texture_manager_; break;
+    case VioletAssetType::kMesh:    manager = &mesh_manager_;    break;
+    case VioletAssetType::kShader:  manager = &shader_manager_;  break;
+    case VioletAssetType::kWave:    manager = &wave_manager_;    break;
+    default:                        return 0u;
+    }
+
+    if (!manager->HasHeader(hash))
+      return 0u;
+
+    const Vector<char> data = manager->ReadData(hash);
+    return VioletBaseAssetManager::GetDecompressedSize(data.data(), data.size());
+  }
+}
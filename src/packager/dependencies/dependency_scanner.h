@@ -0,0 +1,40 @@
+#pragma once
+#include <assets/dependency_graph.h>
+
+namespace lambda
+{
+  class VioletTextureManager;
+  class VioletMeshManager;
+  class VioletShaderManager;
+  class VioletWaveManager;
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Keeps the dependency graph in sync with the source files. Assets have to
+  // be compiled before they are scanned, the sizes and the textures of meshes
+  // are taken from the generated files.
+  class VioletDependencyScanner
+  {
+  public:
+    VioletDependencyScanner(
+      VioletTextureManager& texture_manager,
+      VioletMeshManager& mesh_manager,
+      VioletShaderManager& shader_manager,
+      VioletWaveManager& wave_manager
+    );
+
+    // Returns false if the file does not produce any assets.
+    bool Scan(VioletDependencyGraph& graph, const String& file);
+
+    // Every asset reference found in the script, scripts it imports included.
+    static Vector<String> FindScriptReferences(const String& file, const String& source);
+
+  private:
+    uint64_t GetSize(VioletAssetType type, uint64_t hash) const;
+
+  private:
+    VioletTextureManager& texture_manager_;
+    VioletMeshManager&    mesh_manager_;
+    VioletShaderManager&  shader_manager_;
+    VioletWaveManager&    wave_manager_;
+  };
+}
@@ -0,0 +1,227 @@
+#include "build_database.h"
+#include <cache/build_cache.h>
+#include <assets/binary_header.h>
+#include <utils/file_system.h>
+#include <utils/console.h>
+
+namespace lambda
+{
+  namespace
+  {
+    struct DatabaseBlock
+    {
+      uint32_t record_count;
+      uint32_t padding;
+    };
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletBuildDatabase::Load(const String& file)
+  {
+    records_.clear();
+    dirty_ = false;
+    if (!FileSystem::DoesFileExist(file))
+      return false;
+
+    const Vector<char> data = FileSystem::FileToVector(file);
+    VioletHeaderReader reader(data.data(), data.size(), kVersion);
+    DatabaseBlock block;
+    if (!reader.ReadBlock(block))
+    {
+      foundation::Error("BuildDatabase: " + file + " is not valid, every file will be checked again\n");
+      return false;
+    }
+
+    for (uint32_t i = 0u; i < block.record_count && reader.IsValid(); ++i)
+    {
+      Record record;
+      record.path         = reader.ReadString();
+      record.time_stamp   = reader.Read<uint64_t>();
+      record.size         = reader.Read<uint64_t>();
+      record.content_hash = reader.Read<uint64_t>();
+
+      const uint32_t output_count = reader.Read<uint32_t>();
+      for (uint32_t j = 0u; j < output_count && reader.IsValid(); ++j)
+        record.outputs.push_back(reader.ReadString());
+
+      const uint32_t dependency_count = reader.Read<uint32_t>();
+      if (!reader.IsValid() || dependency_count > data.size() / sizeof(uint64_t))
+        break;
+      record.dependencies.resize(dependency_count);
+      reader.Read((char*)record.dependencies.data(), dependency_count * sizeof(uint64_t));
+
+      if (reader.IsValid())
+        records_[GetPathHash(record.path)] = eastl::move(record);
+    }
+
+    if (!reader.IsValid())
+    {
+      foundation::Error("BuildDatabase: " + file + " is truncated, every file will be checked again\n");
+      records_.clear();
+      return false;
+    }
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletBuildDatabase::Save(const String& file)
+  {
+    DatabaseBlock block;
+    block.record_count = (uint32_t)records_.size();
+    block.padding      = 0u;
+
+    VioletHeaderWriter writer(kVersion, block);
+    for (const auto& it : records_)
+    {
+      const Record& record = it.second;
+      writer.WriteString(record.path);
+      writer.Write(record.time_stamp);
+      writer.Write(record.size);
+      writer.Write(record.content_hash);
+      writer.Write((uint32_t)record.outputs.size());
+      for (const String& output : record.outputs)
+        writer.WriteString(output);
+      writer.Write((uint32_t)record.dependencies.size());
+      writer.Write((const char*)record.dependencies.data(), record.dependencies.size() * sizeof(uint64_t));
+    }
+
+    const String temp = file + ".tmp";
+    FileSystem::WriteFile(temp, writer.GetData());
+    if (!FileSystem::RenameFile(temp, file))
+    {
+      foundation::Error("BuildDatabase: Could not replace " + file + "\n");
+      return false;
+    }
+
+    dirty_ = false;
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletBuildDatabase::IsDirty() const
+  {
+    return dirty_;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletBuildDatabase::HasFile(const String& file) const
+  {
+    return records_.find(GetPathHash(file)) != records_.end();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  bool VioletBuildDatabase::HasChanged(const String& file, bool check_outputs)
+  {
+    auto it = records_.find(GetPathHash(file));
+    if (it == records_.end())
+      return true;
+
+    Record& record = it->second;
+    if (check_outputs)
+      for (const String& output : record.outputs)
+        if (!FileSystem::DoesFileExist(output))
+          return true;
+
+    const uint64_t time_stamp = FileSystem::GetTimeStamp(file);
+    const uint64_t size       = FileSystem::GetFileSize(file);
+    if (time_stamp == record.time_stamp && size == record.size)
+      return false;
+
+    if (size != record.size || GetContentHash(file) != record.content_hash)
+      return true;
+
+    record.time_stamp = time_stamp;
+    dirty_ = true;
+    return false;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildDatabase::Update(const String& file, const Vector<String>& outputs, const Vector<String>& dependencies)
+  {
+    Record& record = records_[GetPathHash(file)];
+    record.path         = file;
+    record.time_stamp   = FileSystem::GetTimeStamp(file);
+    record.size         = FileSystem::GetFileSize(file);
+    record.content_hash = GetContentHash(file);
+    record.outputs      = outputs;
+    record.seen         = true;
+
+    record.dependencies.clear();
+    for (const String& dependency : dependencies)
+      record.dependencies.push_back(GetPathHash(dependency));
+
+    dirty_ = true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildDatabase::Remove(const String& file)
+  {
+    if (records_.erase(GetPathHash(file)) > 0u)
+      dirty_ = true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<String> VioletBuildDatabase::GetDependents(const String& file) const
+  {
+    const uint64_t hash = GetPathHash(file);
+    Vector<String> dependents;
+    for (const auto& it : records_)
+    {
+      const Vector<uint64_t>& dependencies = it.second.dependencies;
+      if (eastl::find(dependencies.begin(), dependencies.end(), hash) != dependencies.end())
+        dependents.push_back(it.second.path);
+    }
+    return dependents;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<String> VioletBuildDatabase::GetFiles() const
+  {
+    Vector<String> files;
+    files.reserve(records_.size());
+    for (const auto& it : records_)
+      files.push_back(it.second.path);
+    return files;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildDatabase::BeginScan()
+  {
+    for (auto& it : records_)
+      it.second.seen = false;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildDatabase::MarkSeen(const String& file)
+  {
+    auto it = records_.find(GetPathHash(file));
+    if (it != records_.end())
+      it->second.seen = true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector<String> VioletBuildDatabase::GetUnseen() const
+  {
+    Vector<String> files;
+    for (const auto& it : records_)
+      if (!it.second.seen)
+        files.push_back(it.second.path);
+    return files;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint64_t VioletBuildDatabase::GetPathHash(const String& file)
+  {
+    return VioletBuildCache::HashData(file.data(), file.size());
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint64_t VioletBuildDatabase::GetContentHash(const String& file)
+  {
+    if (!FileSystem::DoesFileExist(file))
+      return 0u;
+
+    const Vector<char> data = FileSystem::FileToVector(file);
+    return VioletBuildCache::HashData(data.data(), data.size());
+  }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <containers/containers.h>
+
+namespace lambda
+{
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // What the builder knows about every source file, keyed by a hash of its
+  // path. Files are compared by time stamp and size first, the content is
+  // only hashed when one of them differs, so touching a file does not make
+  // it change. Records also hold the generated files of the source and the
+  // files it reads, which finds missing outputs and the sources that have
+  // to be built again when an include changes.
+  class VioletBuildDatabase
+  {
+  public:
+    static constexpr uint8_t kVersion = 1u;
+
+    struct Record
+    {
+      String           path;
+      uint64_t         time_stamp   = 0u;
+      uint64_t         size         = 0u;
+      uint64_t         content_hash = 0u;
+      Vector<String>   outputs;      // Generated files.
+      Vector<uint64_t> dependencies; // Path hashes of the other files it is built from.
+      bool             seen = false; // Only used during a scan, not stored.
+    };
+
+    bool Load(const String& file);
+    // Writes a temporary file and renames it, a crash never leaves a half written database behind.
+    bool Save(const String& file);
+    bool IsDirty() const;
+
+    bool HasFile(const String& file) const;
+    // Unknown files have changed. Files that were only touched get their new
+    // time stamp stored and did not change.
+    bool HasChanged(const String& file, bool check_outputs = false);
+    // Call once the file has been built, stores its current state.
+    void Update(const String& file, const Vector<String>& outputs, const Vector<String>& dependencies);
+    void Remove(const String& file);
+    // Every file that lists the file as one of its dependencies.
+    Vector<String> GetDependents(const String& file) const;
+    Vector<String> GetFiles() const;
+
+    // Files that are not marked as seen between BeginScan and GetUnseen no longer exist.
+    void BeginScan();
+    void MarkSeen(const String& file);
+    Vector<String> GetUnseen() const;
+
+    static uint64_t GetPathHash(const String& file);
+    static uint64_t GetContentHash(const String& file);
+
+  private:
+    UnorderedMap<uint64_t, Record> records_;
+    bool dirty_ = false;
+  };
+}
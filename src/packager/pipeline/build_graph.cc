@@ -0,0 +1,135 @@
+#include "build_graph.h"
+#include <utils/timer.h>
+#include <utils/console.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace lambda
+{
+  // Set while the thread runs a job of a graph.
+  static thread_local bool s_in_job = false;
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint32_t VioletBuildGraph::AddJob(const String& name, Function<bool(void)> function)
+  {
+    Job job;
+    job.name     = name;
+    job.function = function;
+    jobs_.push_back(job);
+    return (uint32_t)jobs_.size() - 1u;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildGraph::AddDependency(uint32_t job, uint32_t dependency)
+  {
+    LMB_ASSERT(job < jobs_.size() && dependency < jobs_.size() && job != dependency, "BuildGraph: Invalid dependency %u on %u", job, dependency);
+
+    Vector<uint32_t>& dependents = jobs_[dependency].dependents;
+    if (eastl::find(dependents.begin(), dependents.end(), job) != dependents.end())
+      return;
+
+    dependents.push_back(job);
+    jobs_[job].dependency_count++;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  void VioletBuildGraph::Run(uint32_t thread_count)
+  {
+    utilities::Timer timer;
+
+    if (thread_count == 0u)
+      thread_count = s_in_job ? 1u : eastl::max(1u, (uint32_t)std::thread::hardware_concurrency());
+    thread_count_ = eastl::max(1u, eastl::min(thread_count, (uint32_t)jobs_.size()));
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    Vector<uint32_t> ready;
+    uint32_t remaining = (uint32_t)jobs_.size();
+
+    for (uint32_t i = 0u; i < jobs_.size(); ++i)
+      if (jobs_[i].dependency_count == 0u)
+        ready.push_back(i);
+
+    // Expects the mutex to be locked. Jobs behind a failed job are skipped, and so is everything behind them.
+    Function<void(uint32_t, bool)> finish = [&](uint32_t index, bool succeeded) {
+      remaining--;
+      for (uint32_t dependent : jobs_[index].dependents)
+      {
+        Job& job = jobs_[dependent];
+        job.dependency_failed |= !succeeded;
+        if (--job.dependency_count > 0u)
+          continue;
+
+        if (job.dependency_failed)
+        {
+          job.skipped = true;
+          finish(dependent, false);
+        }
+        else
+          ready.push_back(dependent);
+      }
+    };
+
+    auto worker = [&]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true)
+      {
+        condition.wait(lock, [&]() { return !ready.empty() || remaining == 0u; });
+        if (ready.empty())
+          return;
+
+        // Oldest first, so jobs run in the order they were added when nothing holds them back.
+        const uint32_t index = ready.front();
+        ready.erase(ready.begin());
+        lock.unlock();
+
+        Job& job = jobs_[index];
+        utilities::Timer job_timer;
+        const bool in_job = s_in_job;
+        s_in_job = true;
+        const bool succeeded = job.function();
+        s_in_job = in_job;
+        job.time = job_timer.elapsed().milliseconds();
+
+        lock.lock();
+        job.succeeded = succeeded;
+        finish(index, succeeded);
+        condition.notify_all();
+      }
+    };
+
+    Vector<std::thread> threads;
+    for (uint32_t i = 1u; i < thread_count_; ++i)
+      threads.push_back(std::thread(worker));
+    worker();
+    for (std::thread& thread : threads)
+      thread.join();
+
+    wall_time_ = timer.elapsed().milliseconds();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  const VioletBuildGraph::Job& VioletBuildGraph::GetJob(uint32_t job) const
+  {
+    return jobs_[job];
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint32_t VioletBuildGraph::GetJobCount() const
+  {
+    return (uint32_t)jobs_.size();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  double VioletBuildGraph::GetWallTime() const
+  {
+    return wall_time_;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  uint32_t VioletBuildGraph::GetThreadCount() const
+  {
+    return thread_count_;
+  }
+}
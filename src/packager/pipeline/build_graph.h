@@ -0,0 +1,45 @@
+#pragma once
+#include <containers/containers.h>
+
+namespace lambda
+{
+  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Jobs of a single build and the order they have to run in. Run executes
+  // every job whose dependencies are done on a pool of worker threads, so
+  // jobs that do not depend on each other compile at the same time. Jobs
+  // write their own files only, the asset managers have no shared state.
+  class VioletBuildGraph
+  {
+  public:
+    struct Job
+    {
+      String               name;
+      Function<bool(void)> function;
+      Vector<uint32_t>     dependents;
+      uint32_t             dependency_count = 0u;
+      bool                 dependency_failed = false;
+      bool                 succeeded = false;
+      bool                 skipped = false; // A dependency failed, the job never ran.
+      double               time = 0.0;      // Milliseconds.
+    };
+
+    uint32_t AddJob(const String& name, Function<bool(void)> function);
+    // The job waits until the dependency has succeeded, the graph can not have cycles.
+    void AddDependency(uint32_t job, uint32_t dependency);
+
+    // Blocks until every job is done. Zero uses a thread per core, or only the
+    // calling thread when it runs a job of another graph, which already keeps
+    // every core busy.
+    void Run(uint32_t thread_count = 0u);
+
+    const Job& GetJob(uint32_t job) const;
+    uint32_t GetJobCount() const;
+    double GetWallTime() const;
+    uint32_t GetThreadCount() const;
+
+  private:
+    Vector<Job> jobs_;
+    double wall_time_ = 0.0;
+    uint32_t thread_count_ = 0u;
+  };
+}